@@ -0,0 +1,789 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Headless benchmark for Cycles.
+ *
+ * Generates a set of procedural XML reference scenes, each stressing one part
+ * of the renderer (BVH build, hair, instancing, volumes, subsurface scattering
+ * and image textures), renders them on the CPU device with a fixed seed and
+ * writes the timings of every stage in a machine-readable format, so results
+ * of different versions can be compared on the same hardware. */
+
+#include <stdio.h>
+
+#include "render/buffers.h"
+#include "render/camera.h"
+#include "render/film.h"
+#include "render/integrator.h"
+#include "render/mesh.h"
+#include "render/scene.h"
+#include "render/session.h"
+#include "device/device.h"
+
+#include "util/util_args.h"
+#include "util/util_foreach.h"
+#include "util/util_image.h"
+#include "util/util_logging.h"
+#include "util/util_math.h"
+#include "util/util_path.h"
+#include "util/util_progress.h"
+#include "util/util_string.h"
+#include "util/util_system.h"
+#include "util/util_time.h"
+#include "util/util_version.h"
+
+#include "app/cycles_xml.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Deterministic random numbers, so generated scenes are identical across runs
+ * and platforms. */
+
+class BenchmarkRandom {
+public:
+	explicit BenchmarkRandom(uint seed) : state(seed) {}
+
+	float next()
+	{
+		state = state * 1664525u + 1013904223u;
+		return (float)(state >> 8) * (1.0f / 16777216.0f);
+	}
+
+	float range(float min, float max)
+	{
+		return min + (max - min) * next();
+	}
+
+protected:
+	uint state;
+};
+
+/* Scene generation utilities. */
+
+static string xml_floats(const vector<float>& values)
+{
+	string str;
+	str.reserve(values.size() * 10);
+
+	for(size_t i = 0; i < values.size(); i++) {
+		if(i) str += " ";
+		str += string_printf("%.5g", (double)values[i]);
+	}
+
+	return str;
+}
+
+static string xml_ints(const vector<int>& values)
+{
+	string str;
+	str.reserve(values.size() * 6);
+
+	for(size_t i = 0; i < values.size(); i++) {
+		if(i) str += " ";
+		str += string_printf("%d", values[i]);
+	}
+
+	return str;
+}
+
+static string xml_header(int width, int height, int max_bounce)
+{
+	/* Camera looking down the positive Z axis, slightly from above. */
+	string str = "<cycles>\n";
+	str += "<transform translate=\"0 2.5 -8\" rotate=\"15 1 0 0\">\n";
+	str += string_printf("  <camera width=\"%d\" height=\"%d\" type=\"perspective\" />\n", width, height);
+	str += "</transform>\n";
+	str += string_printf("<integrator seed=\"0\" max_bounce=\"%d\" />\n", max_bounce);
+	str += "<background>\n"
+	       "  <background name=\"bg\" strength=\"0.5\" color=\"0.8 0.85 1.0\" />\n"
+	       "  <connect from=\"bg background\" to=\"output surface\" />\n"
+	       "</background>\n";
+	str += "<shader name=\"diffuse\">\n"
+	       "  <diffuse_bsdf name=\"bsdf\" color=\"0.7 0.7 0.7\" />\n"
+	       "  <connect from=\"bsdf bsdf\" to=\"output surface\" />\n"
+	       "</shader>\n";
+	str += "<shader name=\"lamp\">\n"
+	       "  <emission name=\"emission\" color=\"1 1 1\" strength=\"800\" />\n"
+	       "  <connect from=\"emission emission\" to=\"output surface\" />\n"
+	       "</shader>\n";
+	str += "<state shader=\"lamp\">\n"
+	       "  <light type=\"point\" co=\"4 6 -6\" size=\"1.0\" />\n"
+	       "</state>\n";
+	return str;
+}
+
+static string xml_footer()
+{
+	return "</cycles>\n";
+}
+
+/* Heightfield grid of res x res quads covering [-size, size] in XZ. */
+static string xml_grid(const string& attributes, int res, float size, float height, bool uv)
+{
+	vector<float> P, UV;
+	vector<int> verts, nverts;
+
+	P.reserve((res + 1) * (res + 1) * 3);
+	for(int j = 0; j <= res; j++) {
+		for(int i = 0; i <= res; i++) {
+			float u = (float)i / res, v = (float)j / res;
+			float y = height * (sinf(u * 23.0f) * cosf(v * 17.0f) + 0.5f * sinf((u + v) * 61.0f));
+			P.push_back((u * 2.0f - 1.0f) * size);
+			P.push_back(y);
+			P.push_back((v * 2.0f - 1.0f) * size);
+		}
+	}
+
+	verts.reserve(res * res * 4);
+	nverts.reserve(res * res);
+	for(int j = 0; j < res; j++) {
+		for(int i = 0; i < res; i++) {
+			int v0 = j * (res + 1) + i;
+			verts.push_back(v0);
+			verts.push_back(v0 + 1);
+			verts.push_back(v0 + res + 2);
+			verts.push_back(v0 + res + 1);
+			nverts.push_back(4);
+
+			if(uv) {
+				float u0 = (float)i / res, u1 = (float)(i + 1) / res;
+				float w0 = (float)j / res, w1 = (float)(j + 1) / res;
+				float corners[8] = {u0, w0, u1, w0, u1, w1, u0, w1};
+				UV.insert(UV.end(), corners, corners + 8);
+			}
+		}
+	}
+
+	string str = "<mesh " + attributes;
+	str += " P=\"" + xml_floats(P) + "\"";
+	str += " nverts=\"" + xml_ints(nverts) + "\"";
+	str += " verts=\"" + xml_ints(verts) + "\"";
+	if(uv) {
+		str += " UV=\"" + xml_floats(UV) + "\"";
+	}
+	str += " />\n";
+	return str;
+}
+
+/* Latitude-longitude sphere. */
+static string xml_sphere(const string& attributes, int segments, float radius)
+{
+	int rings = max(segments / 2, 2);
+	vector<float> P;
+	vector<int> verts, nverts;
+
+	for(int j = 0; j <= rings; j++) {
+		float theta = M_PI_F * j / rings;
+		for(int i = 0; i < segments; i++) {
+			float phi = M_2PI_F * i / segments;
+			P.push_back(radius * sinf(theta) * cosf(phi));
+			P.push_back(radius * cosf(theta));
+			P.push_back(radius * sinf(theta) * sinf(phi));
+		}
+	}
+
+	for(int j = 0; j < rings; j++) {
+		for(int i = 0; i < segments; i++) {
+			int i1 = (i + 1) % segments;
+			verts.push_back(j * segments + i);
+			verts.push_back(j * segments + i1);
+			verts.push_back((j + 1) * segments + i1);
+			verts.push_back((j + 1) * segments + i);
+			nverts.push_back(4);
+		}
+	}
+
+	return "<mesh " + attributes +
+	       " P=\"" + xml_floats(P) + "\"" +
+	       " nverts=\"" + xml_ints(nverts) + "\"" +
+	       " verts=\"" + xml_ints(verts) + "\" />\n";
+}
+
+static string xml_box(float size)
+{
+	vector<float> P;
+	for(int i = 0; i < 8; i++) {
+		P.push_back((i & 1)? size: -size);
+		P.push_back((i & 2)? size: -size);
+		P.push_back((i & 4)? size: -size);
+	}
+
+	return "<mesh P=\"" + xml_floats(P) + "\""
+	       " nverts=\"4 4 4 4 4 4\""
+	       " verts=\"0 2 3 1 4 5 7 6 0 1 5 4 2 6 7 3 0 4 6 2 1 3 7 5\" />\n";
+}
+
+/* Reference scenes. Each generator writes its XML file, and any data files it
+ * needs, into the given directory and returns the path of the XML file. */
+
+struct BenchmarkSettings {
+	int width, height;
+	float scale;
+};
+
+static int scaled(const BenchmarkSettings& settings, int count)
+{
+	return max((int)(count * settings.scale), 1);
+}
+
+static string scene_bvh(const string& dir, const BenchmarkSettings& settings)
+{
+	/* Dense heightfield, mostly stresses BVH build with spatial splits. */
+	int res = (int)(700.0f * sqrtf(settings.scale));
+	string content = "<state shader=\"diffuse\" interpolation=\"smooth\">\n";
+	content += xml_grid("", max(res, 8), 6.0f, 0.4f, false);
+	content += "</state>\n";
+
+	string filepath = path_join(dir, "bvh.xml");
+	string text = xml_header(settings.width, settings.height, 2) + content + xml_footer();
+	return path_write_text(filepath, text)? filepath: "";
+}
+
+static string scene_hair(const string& dir, const BenchmarkSettings& settings)
+{
+	BenchmarkRandom rng(1);
+	int num_curves = scaled(settings, 100000);
+	const int num_keys = 6;
+
+	vector<float> P, radius;
+	vector<int> nkeys;
+	P.reserve(num_curves * num_keys * 3);
+
+	for(int i = 0; i < num_curves; i++) {
+		float x = rng.range(-4.0f, 4.0f), z = rng.range(-4.0f, 4.0f);
+		float bend_x = rng.range(-0.3f, 0.3f), bend_z = rng.range(-0.3f, 0.3f);
+		float length = rng.range(0.3f, 0.8f);
+
+		for(int k = 0; k < num_keys; k++) {
+			float t = (float)k / (num_keys - 1);
+			P.push_back(x + bend_x * t * t);
+			P.push_back(length * t);
+			P.push_back(z + bend_z * t * t);
+			radius.push_back(0.004f * (1.0f - 0.8f * t));
+		}
+		nkeys.push_back(num_keys);
+	}
+
+	string content = "<shader name=\"hair\">\n"
+	                 "  <hair_bsdf name=\"bsdf\" color=\"0.6 0.4 0.2\" />\n"
+	                 "  <connect from=\"bsdf bsdf\" to=\"output surface\" />\n"
+	                 "</shader>\n";
+	content += "<state shader=\"diffuse\">\n" + xml_grid("", 1, 4.0f, 0.0f, false) + "</state>\n";
+	content += "<state shader=\"hair\">\n";
+	content += "<hair P=\"" + xml_floats(P) + "\" nkeys=\"" + xml_ints(nkeys) +
+	           "\" radius=\"" + xml_floats(radius) + "\" />\n";
+	content += "</state>\n";
+
+	string filepath = path_join(dir, "hair.xml");
+	string text = xml_header(settings.width, settings.height, 4) + content + xml_footer();
+	return path_write_text(filepath, text)? filepath: "";
+}
+
+static string scene_instancing(const string& dir, const BenchmarkSettings& settings)
+{
+	BenchmarkRandom rng(2);
+	int num_instances = scaled(settings, 20000);
+
+	/* The prototype is placed far outside the view, instances reference it. */
+	string content = "<state shader=\"diffuse\" interpolation=\"smooth\">\n";
+	content += "<transform translate=\"0 -1000 0\">\n" +
+	           xml_sphere("name=\"rock\"", 48, 1.0f) +
+	           "</transform>\n";
+	content += xml_grid("", 1, 8.0f, 0.0f, false);
+
+	for(int i = 0; i < num_instances; i++) {
+		float s = rng.range(0.03f, 0.12f);
+		content += string_printf(
+		        "<transform translate=\"%.4f %.4f %.4f\" rotate=\"%.2f 0 1 0\" scale=\"%.4f %.4f %.4f\">"
+		        "<instance mesh=\"rock\" /></transform>\n",
+		        (double)rng.range(-8.0f, 8.0f), (double)(s * 0.5f), (double)rng.range(-8.0f, 8.0f),
+		        (double)rng.range(0.0f, 360.0f),
+		        (double)s, (double)(s * rng.range(0.5f, 1.5f)), (double)s);
+	}
+	content += "</state>\n";
+
+	string filepath = path_join(dir, "instancing.xml");
+	string text = xml_header(settings.width, settings.height, 2) + content + xml_footer();
+	return path_write_text(filepath, text)? filepath: "";
+}
+
+static string scene_volume(const string& dir, const BenchmarkSettings& settings)
+{
+	string content = "<shader name=\"smoke\">\n"
+	                 "  <scatter_volume name=\"scatter\" color=\"0.8 0.8 0.8\" density=\"1.5\" anisotropy=\"0.3\" />\n"
+	                 "  <connect from=\"scatter volume\" to=\"output volume\" />\n"
+	                 "</shader>\n";
+	content += "<state shader=\"diffuse\">\n" + xml_grid("", 1, 6.0f, 0.0f, false) + "</state>\n";
+	content += "<state shader=\"smoke\">\n"
+	           "<transform translate=\"0 1.5 0\">\n" + xml_box(1.5f) + "</transform>\n"
+	           "</state>\n";
+
+	string filepath = path_join(dir, "volume.xml");
+	string text = xml_header(settings.width, settings.height, 8) + content + xml_footer();
+	return path_write_text(filepath, text)? filepath: "";
+}
+
+static string scene_sss(const string& dir, const BenchmarkSettings& settings)
+{
+	string content = "<shader name=\"skin\">\n"
+	                 "  <subsurface_scattering name=\"sss\" color=\"0.9 0.6 0.5\" scale=\"0.5\" radius=\"1.0 0.4 0.2\" />\n"
+	                 "  <connect from=\"sss bssrdf\" to=\"output surface\" />\n"
+	                 "</shader>\n";
+	content += "<state shader=\"diffuse\">\n" + xml_grid("", 1, 6.0f, 0.0f, false) + "</state>\n";
+	content += "<state shader=\"skin\" interpolation=\"smooth\">\n";
+	for(int i = 0; i < 3; i++) {
+		content += string_printf("<transform translate=\"%d 1 0\">\n", (i - 1) * 2) +
+		           xml_sphere("", 128, 0.9f) +
+		           "</transform>\n";
+	}
+	content += "</state>\n";
+
+	string filepath = path_join(dir, "sss.xml");
+	string text = xml_header(settings.width, settings.height, 4) + content + xml_footer();
+	return path_write_text(filepath, text)? filepath: "";
+}
+
+static bool write_texture(const string& filepath, int size, uint seed)
+{
+	BenchmarkRandom rng(seed);
+	float fx = rng.range(2.0f, 20.0f), fy = rng.range(2.0f, 20.0f);
+	float3 tint = make_float3(rng.next(), rng.next(), rng.next());
+
+	vector<uchar> pixels(size * size * 3);
+	for(int y = 0; y < size; y++) {
+		for(int x = 0; x < size; x++) {
+			float u = (float)x / size, v = (float)y / size;
+			float f = 0.5f + 0.5f * sinf(u * fx * M_2PI_F) * cosf(v * fy * M_2PI_F);
+			uchar *pixel = &pixels[(y * size + x) * 3];
+			pixel[0] = (uchar)(255.0f * f * tint.x);
+			pixel[1] = (uchar)(255.0f * f * tint.y);
+			pixel[2] = (uchar)(255.0f * f * tint.z);
+		}
+	}
+
+	ImageOutput *out = ImageOutput::create(filepath);
+	if(!out) {
+		return false;
+	}
+
+	ImageSpec spec(size, size, 3, TypeDesc::UINT8);
+	bool ok = out->open(filepath, spec) &&
+	          out->write_image(TypeDesc::UINT8, &pixels[0]);
+	out->close();
+	delete out;
+
+	return ok;
+}
+
+static string scene_textures(const string& dir, const BenchmarkSettings& settings)
+{
+	int num_textures = scaled(settings, 64);
+	int grid = (int)ceilf(sqrtf((float)num_textures));
+	const int texture_size = 1024;
+
+	string content;
+	for(int i = 0; i < num_textures; i++) {
+		string filename = string_printf("texture_%03d.png", i);
+		string filepath = path_join(dir, filename);
+
+		/* Textures are reused across runs, they are expensive to write. */
+		if(!path_exists(filepath) && !write_texture(filepath, texture_size, i + 1)) {
+			fprintf(stderr, "Failed to write texture %s\n", filepath.c_str());
+			return "";
+		}
+
+		content += string_printf(
+		        "<shader name=\"tex%d\">\n"
+		        "  <texture_coordinate name=\"coord\" />\n"
+		        "  <image_texture name=\"image\" filename=\"%s\" />\n"
+		        "  <diffuse_bsdf name=\"bsdf\" />\n"
+		        "  <connect from=\"coord uv\" to=\"image vector\" />\n"
+		        "  <connect from=\"image color\" to=\"bsdf color\" />\n"
+		        "  <connect from=\"bsdf bsdf\" to=\"output surface\" />\n"
+		        "</shader>\n",
+		        i, filename.c_str());
+
+		float tile = 8.0f / grid;
+		content += string_printf(
+		        "<state shader=\"tex%d\"><transform translate=\"%.4f 0 %.4f\">\n",
+		        i,
+		        (double)(-4.0f + tile * ((i % grid) + 0.5f)),
+		        (double)(-4.0f + tile * ((i / grid) + 0.5f)));
+		content += xml_grid("", 4, tile * 0.45f, 0.0f, true);
+		content += "</transform></state>\n";
+	}
+
+	string filepath = path_join(dir, "textures.xml");
+	string text = xml_header(settings.width, settings.height, 2) + content + xml_footer();
+	return path_write_text(filepath, text)? filepath: "";
+}
+
+typedef string (*BenchmarkSceneFunc)(const string& dir, const BenchmarkSettings& settings);
+
+struct BenchmarkScene {
+	const char *name;
+	BenchmarkSceneFunc generate;
+	bool use_bvh_spatial_split;
+};
+
+static const BenchmarkScene benchmark_scenes[] = {
+	{"bvh", scene_bvh, true},
+	{"hair", scene_hair, false},
+	{"instancing", scene_instancing, false},
+	{"volume", scene_volume, false},
+	{"sss", scene_sss, false},
+	{"textures", scene_textures, false},
+};
+
+/* Benchmark run. */
+
+struct BenchmarkOptions {
+	BenchmarkSettings settings;
+	string scene_dir;
+	string output_path;
+	string scenes;
+	int samples;
+	int threads;
+	int tile_size;
+	int repeat;
+	bool use_denoising;
+	bool use_denoising_full_frame;
+	bool use_compressed_attributes;
+	bool generate_only;
+};
+
+struct BenchmarkResult {
+	string scene;
+	int run;
+	bool success;
+	double xml_load_time;
+	double scene_update_time;
+	double bvh_build_time;
+	double render_time;
+	double path_trace_time;
+	double denoise_time;
+	double samples_per_second;
+	size_t mem_peak;
+	MeshInstanceStats instance_stats;
+	MeshCompressionStats compression_stats;
+};
+
+static bool benchmark_render(const BenchmarkOptions& options,
+                             const BenchmarkScene& bench_scene,
+                             const string& filepath,
+                             const DeviceInfo& device_info,
+                             BenchmarkResult& result)
+{
+	SessionParams session_params;
+	session_params.device = device_info;
+	session_params.background = true;
+	session_params.progressive = false;
+	session_params.samples = options.samples;
+	session_params.threads = options.threads;
+	session_params.tile_size = make_int2(options.tile_size, options.tile_size);
+	session_params.use_denoising = options.use_denoising;
+	session_params.denoising_full_frame = options.use_denoising_full_frame;
+
+	SceneParams scene_params;
+	scene_params.shadingsystem = SHADINGSYSTEM_SVM;
+	scene_params.use_bvh_spatial_split = bench_scene.use_bvh_spatial_split;
+	scene_params.use_compressed_attributes = options.use_compressed_attributes;
+
+	Session *session = new Session(session_params);
+
+	/* Load scene. */
+	scoped_timer load_timer;
+	Scene *scene = new Scene(scene_params, session->device);
+	xml_read_file(scene, filepath.c_str());
+	scene->camera->compute_auto_viewplane();
+	result.xml_load_time = load_timer.get_time();
+
+	BufferParams buffer_params;
+	buffer_params.width = scene->camera->width;
+	buffer_params.height = scene->camera->height;
+	buffer_params.full_width = scene->camera->width;
+	buffer_params.full_height = scene->camera->height;
+
+	if(options.use_denoising) {
+		buffer_params.denoising_data_pass = true;
+		session->tile_manager.schedule_denoising = true;
+		scene->film->denoising_data_pass = true;
+		scene->film->tag_update(scene);
+	}
+
+	session->scene = scene;
+	session->reset(buffer_params, session_params.samples);
+	session->start();
+	session->wait();
+
+	result.success = !session->progress.get_error() && !session->progress.get_cancel();
+
+	double total_time, render_time;
+	session->progress.get_time(total_time, render_time);
+	session->progress.get_tile_time(result.path_trace_time, result.denoise_time);
+
+	result.render_time = render_time;
+	result.scene_update_time = max(total_time - render_time, 0.0);
+	result.bvh_build_time = scene->mesh_manager->bvh_build_time;
+	result.instance_stats = scene->mesh_manager->instance_stats;
+	result.compression_stats = scene->mesh_manager->compression_stats;
+	result.samples_per_second = (render_time > 0.0)?
+	        (double)buffer_params.width * buffer_params.height * session_params.samples / render_time: 0.0;
+	result.mem_peak = session->device->stats.mem_peak;
+
+	/* Session owns the scene. */
+	delete session;
+
+	return result.success;
+}
+
+static void benchmark_write_results(FILE *file,
+                                    const BenchmarkOptions& options,
+                                    const DeviceInfo& device_info,
+                                    const vector<BenchmarkResult>& results)
+{
+	fprintf(file, "{\n");
+	fprintf(file, "  \"version\": \"%s\",\n", CYCLES_VERSION_STRING);
+	fprintf(file, "  \"device\": \"%s\",\n", device_info.description.c_str());
+	fprintf(file, "  \"cpu\": \"%s\",\n", system_cpu_brand_string().c_str());
+	fprintf(file, "  \"threads\": %d,\n",
+	        (options.threads > 0)? options.threads: system_cpu_thread_count());
+	fprintf(file, "  \"samples\": %d,\n", options.samples);
+	fprintf(file, "  \"resolution\": [%d, %d],\n", options.settings.width, options.settings.height);
+	fprintf(file, "  \"scale\": %g,\n", (double)options.settings.scale);
+	fprintf(file, "  \"denoising\": %s,\n", options.use_denoising? "true": "false");
+	fprintf(file, "  \"denoising_full_frame\": %s,\n", options.use_denoising_full_frame? "true": "false");
+	fprintf(file, "  \"compressed_attributes\": %s,\n", options.use_compressed_attributes? "true": "false");
+	fprintf(file, "  \"results\": [\n");
+
+	for(size_t i = 0; i < results.size(); i++) {
+		const BenchmarkResult& r = results[i];
+		fprintf(file,
+		        "    {\"scene\": \"%s\", \"run\": %d, \"success\": %s, "
+		        "\"xml_load\": %.6f, \"scene_update\": %.6f, \"bvh_build\": %.6f, "
+		        "\"render\": %.6f, \"path_trace_thread_time\": %.6f, \"denoise_thread_time\": %.6f, "
+		        "\"samples_per_second\": %.1f, \"device_mem_peak\": %lu, "
+		        "\"instances\": %lu, \"instance_memory\": %lu, \"instancing_memory_saved\": %lu, "
+		        "\"normals_memory_saved\": %lu, \"uvs_memory_saved\": %lu, "
+		        "\"tangents_memory_saved\": %lu, \"colors_memory_saved\": %lu}%s\n",
+		        r.scene.c_str(), r.run, r.success? "true": "false",
+		        r.xml_load_time, r.scene_update_time, r.bvh_build_time,
+		        r.render_time, r.path_trace_time, r.denoise_time,
+		        r.samples_per_second, (unsigned long)r.mem_peak,
+		        (unsigned long)r.instance_stats.num_instances,
+		        (unsigned long)r.instance_stats.instance_memory,
+		        (unsigned long)r.instance_stats.memory_saved,
+		        (unsigned long)r.compression_stats.normals_saved,
+		        (unsigned long)r.compression_stats.uvs_saved,
+		        (unsigned long)r.compression_stats.tangents_saved,
+		        (unsigned long)r.compression_stats.colors_saved,
+		        (i + 1 < results.size())? ",": "");
+	}
+
+	fprintf(file, "  ]\n");
+	fprintf(file, "}\n");
+}
+
+static void options_parse(int argc, const char **argv, BenchmarkOptions& options)
+{
+	options.settings.width = 960;
+	options.settings.height = 540;
+	options.settings.scale = 1.0f;
+	options.scene_dir = "cycles_benchmark_scenes";
+	options.output_path = "";
+	options.scenes = "";
+	options.samples = 16;
+	options.threads = 0;
+	options.tile_size = 32;
+	options.repeat = 1;
+	options.use_denoising = false;
+	options.use_denoising_full_frame = false;
+	options.use_compressed_attributes = false;
+	options.generate_only = false;
+
+	string scene_names;
+	for(size_t i = 0; i < sizeof(benchmark_scenes) / sizeof(*benchmark_scenes); i++) {
+		if(i) scene_names += ", ";
+		scene_names += benchmark_scenes[i].name;
+	}
+
+	ArgParse ap;
+	bool help = false, debug = false, version = false;
+	int verbosity = 1;
+	string scenes_help = "Comma separated scenes to render, all by default: " + scene_names;
+
+	ap.options ("Usage: cycles_benchmark [options]",
+		"--scene-dir %s", &options.scene_dir, "Directory to write the generated scenes to",
+		"--scenes %s", &options.scenes, scenes_help.c_str(),
+		"--output %s", &options.output_path, "File path to write timings to, stdout by default",
+		"--samples %d", &options.samples, "Number of samples to render",
+		"--threads %d", &options.threads, "CPU Rendering Threads",
+		"--width %d", &options.settings.width, "Image width in pixel",
+		"--height %d", &options.settings.height, "Image height in pixel",
+		"--tile-size %d", &options.tile_size, "Tile size in pixels",
+		"--scale %f", &options.settings.scale, "Scale factor for the scene complexity",
+		"--repeat %d", &options.repeat, "Number of times to render each scene",
+		"--denoising", &options.use_denoising, "Denoise the rendered images",
+		"--denoising-full-frame", &options.use_denoising_full_frame, "Denoise the whole image after all tiles are rendered",
+		"--compressed-attributes", &options.use_compressed_attributes, "Store mesh attributes with reduced precision",
+		"--generate-only", &options.generate_only, "Only generate the scenes, don't render them",
+#ifdef WITH_CYCLES_LOGGING
+		"--debug", &debug, "Enable debug logging",
+		"--verbose %d", &verbosity, "Set verbosity of the logger",
+#endif
+		"--help", &help, "Print help message",
+		"--version", &version, "Print version number",
+		NULL);
+
+	if(ap.parse(argc, argv) < 0) {
+		fprintf(stderr, "%s\n", ap.geterror().c_str());
+		ap.usage();
+		exit(EXIT_FAILURE);
+	}
+
+	if(debug) {
+		util_logging_start();
+		util_logging_verbosity_set(verbosity);
+	}
+
+	if(help) {
+		ap.usage();
+		exit(EXIT_SUCCESS);
+	}
+	else if(version) {
+		printf("%s\n", CYCLES_VERSION_STRING);
+		exit(EXIT_SUCCESS);
+	}
+
+	if(options.samples <= 0 || options.repeat <= 0 || options.tile_size <= 0 ||
+	   options.settings.width <= 0 || options.settings.height <= 0 ||
+	   options.settings.scale <= 0.0f)
+	{
+		fprintf(stderr, "Invalid benchmark settings\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+static bool scene_enabled(const BenchmarkOptions& options, const char *name)
+{
+	if(options.scenes == "") {
+		return true;
+	}
+
+	vector<string> tokens;
+	string_split(tokens, options.scenes, ", ");
+	foreach(const string& token, tokens) {
+		if(token == name) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static int benchmark_main(int argc, const char **argv)
+{
+	BenchmarkOptions options;
+	options_parse(argc, argv, options);
+
+	/* Always benchmark the CPU device, results are not comparable otherwise. */
+	DeviceInfo device_info;
+	bool device_available = false;
+	foreach(DeviceInfo& info, Device::available_devices()) {
+		if(info.type == DEVICE_CPU) {
+			device_info = info;
+			device_available = true;
+			break;
+		}
+	}
+
+	if(!device_available) {
+		fprintf(stderr, "CPU device not available\n");
+		return EXIT_FAILURE;
+	}
+
+	path_create_directories(path_join(options.scene_dir, "scene.xml"));
+
+	vector<BenchmarkResult> results;
+	bool success = true;
+
+	for(size_t i = 0; i < sizeof(benchmark_scenes) / sizeof(*benchmark_scenes); i++) {
+		const BenchmarkScene& bench_scene = benchmark_scenes[i];
+
+		if(!scene_enabled(options, bench_scene.name)) {
+			continue;
+		}
+
+		fprintf(stderr, "Generating scene %s\n", bench_scene.name);
+		string filepath = bench_scene.generate(options.scene_dir, options.settings);
+		if(filepath == "") {
+			fprintf(stderr, "Failed to generate scene %s\n", bench_scene.name);
+			success = false;
+			continue;
+		}
+
+		if(options.generate_only) {
+			continue;
+		}
+
+		for(int run = 0; run < options.repeat; run++) {
+			fprintf(stderr, "Rendering scene %s (%d/%d)\n", bench_scene.name, run + 1, options.repeat);
+
+			BenchmarkResult result;
+			result.scene = bench_scene.name;
+			result.run = run;
+
+			if(!benchmark_render(options, bench_scene, filepath, device_info, result)) {
+				fprintf(stderr, "Failed to render scene %s\n", bench_scene.name);
+				success = false;
+			}
+
+			results.push_back(result);
+		}
+	}
+
+	if(options.generate_only) {
+		return success? EXIT_SUCCESS: EXIT_FAILURE;
+	}
+
+	FILE *file = stdout;
+	if(options.output_path != "") {
+		file = path_fopen(options.output_path, "w");
+		if(!file) {
+			fprintf(stderr, "Failed to open %s for writing\n", options.output_path.c_str());
+			return EXIT_FAILURE;
+		}
+	}
+
+	benchmark_write_results(file, options, device_info, results);
+
+	if(file != stdout) {
+		fclose(file);
+	}
+
+	return success? EXIT_SUCCESS: EXIT_FAILURE;
+}
+
+CCL_NAMESPACE_END
+
+using namespace ccl;
+
+int main(int argc, const char **argv)
+{
+	util_logging_init(argv[0]);
+	path_init();
+
+	return benchmark_main(argc, argv);
+}
@@ -391,6 +391,11 @@ static void xml_read_mesh(const XMLReadState& state, xml_node node)
 	Mesh *mesh = xml_add_mesh(state.scene, state.tfm);
 	mesh->used_shaders.push_back(state.shader);
 
+	/* named meshes can be referenced by instances */
+	string name;
+	if(xml_read_string(&name, node, "name"))
+		mesh->name = ustring(name);
+
 	/* read state */
 	int shader = 0;
 	bool smooth = state.smooth;
@@ -529,6 +534,74 @@ static void xml_read_mesh(const XMLReadState& state, xml_node node)
 	}
 }
 
+/* Instance */
+
+static void xml_read_instance(const XMLReadState& state, xml_node node)
+{
+	string name;
+	if(!xml_read_string(&name, node, "mesh")) {
+		fprintf(stderr, "Instance without mesh.\n");
+		return;
+	}
+
+	ustring mesh_name(name);
+	foreach(Mesh *mesh, state.scene->meshes) {
+		if(mesh->name == mesh_name) {
+			Object *object = new Object();
+			object->mesh = mesh;
+			object->tfm = state.tfm;
+			state.scene->objects.push_back(object);
+			return;
+		}
+	}
+
+	fprintf(stderr, "Unknown mesh \"%s\".\n", name.c_str());
+}
+
+/* Hair */
+
+static void xml_read_hair(const XMLReadState& state, xml_node node)
+{
+	/* add mesh */
+	Mesh *mesh = xml_add_mesh(state.scene, state.tfm);
+	mesh->used_shaders.push_back(state.shader);
+
+	/* read curve keys, one radius per key or a constant radius */
+	vector<float3> P;
+	vector<float> radius;
+	vector<int> nkeys;
+
+	xml_read_float3_array(P, node, "P");
+	xml_read_int_array(nkeys, node, "nkeys");
+
+	if(!xml_read_float_array(radius, node, "radius") || radius.size() != P.size()) {
+		float constant_radius = (radius.size() == 1)? radius[0]: 0.01f;
+		radius.clear();
+		radius.resize(P.size(), constant_radius);
+	}
+
+	size_t num_keys = 0;
+	for(size_t i = 0; i < nkeys.size(); i++)
+		num_keys += nkeys[i];
+
+	if(num_keys != P.size()) {
+		fprintf(stderr, "Hair key count mismatch: %d keys, %d points.\n",
+		        (int)num_keys, (int)P.size());
+		return;
+	}
+
+	mesh->reserve_curves(nkeys.size(), num_keys);
+
+	int key_offset = 0;
+	for(size_t i = 0; i < nkeys.size(); i++) {
+		for(int j = 0; j < nkeys[i]; j++)
+			mesh->add_curve_key(P[key_offset + j], radius[key_offset + j]);
+
+		mesh->add_curve(key_offset, 0);
+		key_offset += nkeys[i];
+	}
+}
+
 /* Light */
 
 static void xml_read_light(XMLReadState& state, xml_node node)
@@ -628,6 +701,12 @@ static void xml_read_scene(XMLReadState& state, xml_node scene_node)
 		else if(string_iequals(node.name(), "mesh")) {
 			xml_read_mesh(state, node);
 		}
+		else if(string_iequals(node.name(), "instance")) {
+			xml_read_instance(state, node);
+		}
+		else if(string_iequals(node.name(), "hair")) {
+			xml_read_hair(state, node);
+		}
 		else if(string_iequals(node.name(), "light")) {
 			xml_read_light(state, node);
 		}
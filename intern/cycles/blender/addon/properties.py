@@ -551,6 +551,11 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 default=0,
                 min=0, max=16,
                 )
+        cls.debug_use_compressed_attributes = BoolProperty(
+                name="Use Compressed Attributes",
+                description="Store normals, UVs, tangents and colors with reduced precision to save memory",
+                default=False,
+                )
         cls.tile_order = EnumProperty(
                 name="Tile Order",
                 description="Tile order for rendering",
@@ -567,6 +572,14 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 default=False,
                 )
 
+        cls.use_denoising_full_frame = BoolProperty(
+                name="Denoise Full Frame",
+                description="Denoise the whole image at once after all tiles are rendered, "
+                            "instead of denoising each tile as soon as its neighbors are done "
+                            "(only used for final CPU renders, needs memory for the full image)",
+                default=False,
+                )
+
         cls.bake_type = EnumProperty(
             name="Bake Type",
             default='COMBINED',
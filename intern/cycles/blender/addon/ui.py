@@ -419,6 +419,7 @@ class CYCLES_RENDER_PT_performance(CyclesButtonsPanel, Panel):
             if rl.cycles.use_denoising:
                 subsub.active = False
         subsub.prop(cscene, "use_progressive_refine")
+        sub.prop(cscene, "use_denoising_full_frame")
 
         col = split.column()
 
@@ -436,6 +437,8 @@ class CYCLES_RENDER_PT_performance(CyclesButtonsPanel, Panel):
         row.active = not cscene.debug_use_spatial_splits
         row.prop(cscene, "debug_bvh_time_steps")
 
+        col.prop(cscene, "debug_use_compressed_attributes")
+
         col = layout.column()
         col.label(text="Viewport Resolution:")
         split = col.split()
@@ -471,8 +471,123 @@ public:
 		return true;
 	}
 
-	bool denoising_non_local_means(device_ptr image_ptr, device_ptr guide_ptr, device_ptr variance_ptr, device_ptr out_ptr,
-	                               DenoisingTask *task)
+	/* Blocks of rows of a denoising filter. They are taken by the thread running the
+	 * filter and by helper tasks in the device's task pool. The filter thread only waits
+	 * for blocks that other threads already started, never for queued helper tasks, so
+	 * it finishes even if all other threads are busy. Helper tasks that start after all
+	 * blocks are taken do nothing, the last user frees the blocks. */
+	class DenoisingBlocks {
+	public:
+		DenoisingBlocks(const function<void(int, int)>& block_func, int h, int block_rows)
+		: block_func(block_func), h(h), block_rows(block_rows), next_y(0), num_running(0), num_users(1)
+		{
+		}
+
+		void work()
+		{
+			thread_scoped_lock lock(mutex);
+			while(next_y < h) {
+				int y0 = next_y;
+				next_y = min(y0 + block_rows, h);
+				num_running++;
+				lock.unlock();
+
+				block_func(y0, min(y0 + block_rows, h));
+
+				lock.lock();
+				num_running--;
+			}
+			if(num_running == 0) {
+				finished_cond.notify_all();
+			}
+		}
+
+		void wait()
+		{
+			thread_scoped_lock lock(mutex);
+			while(next_y < h || num_running != 0) {
+				finished_cond.wait(lock);
+			}
+		}
+
+		void add_user()
+		{
+			thread_scoped_lock lock(mutex);
+			num_users++;
+		}
+
+		static void release(DenoisingBlocks *blocks)
+		{
+			bool is_last;
+			{
+				thread_scoped_lock lock(blocks->mutex);
+				is_last = (--blocks->num_users == 0);
+			}
+			if(is_last) {
+				delete blocks;
+			}
+		}
+
+	protected:
+		function<void(int, int)> block_func;
+		int h, block_rows;
+		int next_y, num_running, num_users;
+		thread_mutex mutex;
+		thread_condition_variable finished_cond;
+	};
+
+	class DenoisingBlocksTask : public Task {
+	public:
+		explicit DenoisingBlocksTask(DenoisingBlocks *blocks)
+		: blocks(blocks)
+		{
+			blocks->add_user();
+			run = function_bind(&DenoisingBlocksTask::work, this, _1);
+		}
+
+		/* Also called for tasks that are removed from the pool without running. */
+		~DenoisingBlocksTask()
+		{
+			DenoisingBlocks::release(blocks);
+		}
+
+	protected:
+		void work(int /*thread_id*/)
+		{
+			blocks->work();
+		}
+
+		DenoisingBlocks *blocks;
+	};
+
+	/* The whole image, such as the full frame denoising tile, is split into blocks of rows
+	 * which are processed by all threads, the other threads have no tiles to work on then.
+	 * Areas with neighbor tiles are processed by one thread, since the other threads are
+	 * busy with their own tiles. */
+	void denoising_run_blocks(DenoisingTask *task, int h, const function<void(int, int)>& block_func)
+	{
+		int block_rows = h;
+		if(task->whole_image) {
+			block_rows = max(32, divide_up(h, 2*TaskScheduler::num_threads()));
+		}
+
+		if(block_rows >= h) {
+			block_func(0, h);
+			return;
+		}
+
+		DenoisingBlocks *blocks = new DenoisingBlocks(block_func, h, block_rows);
+		for(int i = 1; i < divide_up(h, block_rows); i++) {
+			task_pool.push(new DenoisingBlocksTask(blocks));
+		}
+
+		blocks->work();
+		blocks->wait();
+		DenoisingBlocks::release(blocks);
+	}
+
+	void denoising_non_local_means_block(device_ptr image_ptr, device_ptr guide_ptr, device_ptr variance_ptr, device_ptr out_ptr,
+	                                     DenoisingTask *task, int y0, int y1)
 	{
 		int4 rect = task->rect;
 		int   r   = task->nlm_state.r;
@@ -483,21 +598,46 @@ public:
 		int w = align_up(rect.z-rect.x, 4);
 		int h = rect.w-rect.y;
 
-		float *blurDifference = (float*) task->nlm_state.temporary_1_ptr;
-		float *difference     = (float*) task->nlm_state.temporary_2_ptr;
-		float *weightAccum    = (float*) task->nlm_state.temporary_3_ptr;
+		/* The blurs read f rows above and below, so 2*f additional rows around the
+		 * block are processed, but only the rows of the block are written. */
+		int halo_y0 = max(0, y0 - 2*f);
+		int halo_y1 = min(h, y1 + 2*f);
+		int ofs = halo_y0*w;
+
+		float *blurDifference, *difference;
+		array<float> temporary;
+		if(y0 == 0 && y1 == h) {
+			blurDifference = (float*) task->nlm_state.temporary_1_ptr;
+			difference     = (float*) task->nlm_state.temporary_2_ptr;
+		}
+		else {
+			temporary.resize(2*w*(halo_y1 - halo_y0));
+			blurDifference = temporary.data();
+			difference     = temporary.data() + w*(halo_y1 - halo_y0);
+		}
+
+		float *image       = (float*) image_ptr + ofs;
+		float *guide       = (float*) guide_ptr + ofs;
+		float *variance    = (float*) variance_ptr + ofs;
+		float *out         = (float*) out_ptr + ofs;
+		float *weightAccum = (float*) task->nlm_state.temporary_3_ptr + ofs;
 
-		memset(weightAccum, 0, sizeof(float)*w*h);
-		memset((float*) out_ptr, 0, sizeof(float)*w*h);
+		memset(weightAccum + (y0 - halo_y0)*w, 0, sizeof(float)*w*(y1 - y0));
+		memset(out + (y0 - halo_y0)*w, 0, sizeof(float)*w*(y1 - y0));
 
 		for(int i = 0; i < (2*r+1)*(2*r+1); i++) {
 			int dy = i / (2*r+1) - r;
 			int dx = i % (2*r+1) - r;
 
-			int local_rect[4] = {max(0, -dx), max(0, -dy), rect.z-rect.x - max(0, dx), rect.w-rect.y - max(0, dy)};
+			int local_rect[4] = {max(0, -dx), max(0, -dy - halo_y0),
+			                     rect.z-rect.x - max(0, dx), min(h - max(0, dy), halo_y1) - halo_y0};
+			if(local_rect[1] >= local_rect[3]) {
+				continue;
+			}
+
 			filter_nlm_calc_difference_kernel()(dx, dy,
-			                                    (float*) guide_ptr,
-			                                    (float*) variance_ptr,
+			                                    guide,
+			                                    variance,
 			                                    difference,
 			                                    local_rect,
 			                                    w, 0,
@@ -507,24 +647,35 @@ public:
 			filter_nlm_calc_weight_kernel()(blurDifference, difference, local_rect, w, f);
 			filter_nlm_blur_kernel()       (difference, blurDifference, local_rect, w, f);
 
-			filter_nlm_update_output_kernel()(dx, dy,
-			                                  blurDifference,
-			                                  (float*) image_ptr,
-			                                  (float*) out_ptr,
-			                                  weightAccum,
-			                                  local_rect,
-			                                  w, f);
+			int output_rect[4] = {local_rect[0], max(local_rect[1], y0 - halo_y0),
+			                      local_rect[2], min(local_rect[3], y1 - halo_y0)};
+			if(output_rect[1] < output_rect[3]) {
+				filter_nlm_update_output_kernel()(dx, dy,
+				                                  blurDifference,
+				                                  image,
+				                                  out,
+				                                  weightAccum,
+				                                  output_rect,
+				                                  w, f);
+			}
 		}
 
-		int local_rect[4] = {0, 0, rect.z-rect.x, rect.w-rect.y};
-		filter_nlm_normalize_kernel()((float*) out_ptr, weightAccum, local_rect, w);
+		int local_rect[4] = {0, y0 - halo_y0, rect.z-rect.x, y1 - halo_y0};
+		filter_nlm_normalize_kernel()(out, weightAccum, local_rect, w);
+	}
 
+	bool denoising_non_local_means(device_ptr image_ptr, device_ptr guide_ptr, device_ptr variance_ptr, device_ptr out_ptr,
+	                               DenoisingTask *task)
+	{
+		denoising_run_blocks(task, task->rect.w - task->rect.y,
+		                     function_bind(&CPUDevice::denoising_non_local_means_block, this,
+		                                   image_ptr, guide_ptr, variance_ptr, out_ptr, task, _1, _2));
 		return true;
 	}
 
-	bool denoising_construct_transform(DenoisingTask *task)
+	void denoising_construct_transform_block(DenoisingTask *task, int y0, int y1)
 	{
-		for(int y = 0; y < task->filter_area.w; y++) {
+		for(int y = y0; y < y1; y++) {
 			for(int x = 0; x < task->filter_area.z; x++) {
 				filter_construct_transform_kernel()((float*) task->buffer.mem.device_pointer,
 				                                    x + task->filter_area.x,
@@ -538,54 +689,93 @@ public:
 				                                    task->pca_threshold);
 			}
 		}
+	}
+
+	bool denoising_construct_transform(DenoisingTask *task)
+	{
+		denoising_run_blocks(task, task->filter_area.w,
+		                     function_bind(&CPUDevice::denoising_construct_transform_block, this, task, _1, _2));
 		return true;
 	}
 
-	bool denoising_reconstruct(device_ptr color_ptr,
-	                           device_ptr color_variance_ptr,
-	                           device_ptr output_ptr,
-	                           DenoisingTask *task)
+	void denoising_reconstruct_block(device_ptr color_ptr,
+	                                 device_ptr color_variance_ptr,
+	                                 device_ptr output_ptr,
+	                                 DenoisingTask *task, int y0, int y1)
 	{
-		mem_zero(task->storage.XtWX);
-		mem_zero(task->storage.XtWY);
+		const int f = 4;
+		int4 filter_window = task->reconstruction_state.filter_window;
+		int source_w = task->reconstruction_state.source_w;
+		int source_h = task->reconstruction_state.source_h;
+		int stride = task->buffer.stride;
+
+		/* Same as for the NLM filter, process 2*f extra rows for the blurs. */
+		int halo_y0 = max(0, filter_window.y + y0 - 2*f);
+		int halo_y1 = min(source_h, filter_window.y + y1 + 2*f);
+		int ofs = halo_y0*stride;
+
+		float *difference, *blurDifference;
+		array<float> temporary;
+		if(y0 == 0 && y1 == task->filter_area.w) {
+			difference     = (float*) task->reconstruction_state.temporary_1_ptr;
+			blurDifference = (float*) task->reconstruction_state.temporary_2_ptr;
+		}
+		else {
+			temporary.resize(2*stride*(halo_y1 - halo_y0));
+			difference     = temporary.data();
+			blurDifference = temporary.data() + stride*(halo_y1 - halo_y0);
+		}
+
+		/* Filter window of the block, relative to the first processed row. */
+		int4 block_window = make_int4(filter_window.x, filter_window.y + y0 - halo_y0,
+		                              filter_window.z, filter_window.y + y1 - halo_y0);
+		int storage_ofs = y0*task->storage.w;
 
-		float *difference     = (float*) task->reconstruction_state.temporary_1_ptr;
-		float *blurDifference = (float*) task->reconstruction_state.temporary_2_ptr;
+		float  *buffer    = (float*)  task->buffer.mem.device_pointer + ofs;
+		float  *color     = (float*)  color_ptr + ofs;
+		float  *color_var = (float*)  color_variance_ptr + ofs;
+		float  *transform = (float*)  task->storage.transform.device_pointer + storage_ofs*TRANSFORM_SIZE;
+		int    *rank      = (int*)    task->storage.rank.device_pointer + storage_ofs;
+		float  *XtWX      = (float*)  task->storage.XtWX.device_pointer + storage_ofs*XTWX_SIZE;
+		float3 *XtWY      = (float3*) task->storage.XtWY.device_pointer + storage_ofs*XTWY_SIZE;
 
 		int r = task->radius;
 		for(int i = 0; i < (2*r+1)*(2*r+1); i++) {
 			int dy = i / (2*r+1) - r;
 			int dx = i % (2*r+1) - r;
 
-			int local_rect[4] = {max(0, -dx), max(0, -dy),
-			                     task->reconstruction_state.source_w - max(0, dx),
-			                     task->reconstruction_state.source_h - max(0, dy)};
+			int local_rect[4] = {max(0, -dx), max(0, -dy - halo_y0),
+			                     source_w - max(0, dx), min(source_h - max(0, dy), halo_y1) - halo_y0};
+			if(local_rect[1] >= local_rect[3]) {
+				continue;
+			}
+
 			filter_nlm_calc_difference_kernel()(dx, dy,
-			                                    (float*) color_ptr,
-			                                    (float*) color_variance_ptr,
+			                                    color,
+			                                    color_var,
 			                                    difference,
 			                                    local_rect,
-			                                    task->buffer.stride,
+			                                    stride,
 			                                    task->buffer.pass_stride,
 			                                    1.0f,
 			                                    task->nlm_k_2);
-			filter_nlm_blur_kernel()(difference, blurDifference, local_rect, task->buffer.stride, 4);
-			filter_nlm_calc_weight_kernel()(blurDifference, difference, local_rect, task->buffer.stride, 4);
-			filter_nlm_blur_kernel()(difference, blurDifference, local_rect, task->buffer.stride, 4);
+			filter_nlm_blur_kernel()(difference, blurDifference, local_rect, stride, f);
+			filter_nlm_calc_weight_kernel()(blurDifference, difference, local_rect, stride, f);
+			filter_nlm_blur_kernel()(difference, blurDifference, local_rect, stride, f);
 			filter_nlm_construct_gramian_kernel()(dx, dy,
 			                                      blurDifference,
-			                                      (float*)  task->buffer.mem.device_pointer,
-			                                      (float*)  task->storage.transform.device_pointer,
-			                                      (int*)    task->storage.rank.device_pointer,
-			                                      (float*)  task->storage.XtWX.device_pointer,
-			                                      (float3*) task->storage.XtWY.device_pointer,
+			                                      buffer,
+			                                      transform,
+			                                      rank,
+			                                      XtWX,
+			                                      XtWY,
 			                                      local_rect,
-			                                      &task->reconstruction_state.filter_window.x,
-			                                      task->buffer.stride,
-			                                      4,
+			                                      &block_window.x,
+			                                      stride,
+			                                      f,
 			                                      task->buffer.pass_stride);
 		}
-		for(int y = 0; y < task->filter_area.w; y++) {
+		for(int y = y0; y < y1; y++) {
 			for(int x = 0; x < task->filter_area.z; x++) {
 				filter_finalize_kernel()(x,
 				                         y,
@@ -598,6 +788,19 @@ public:
 				                         task->render_buffer.samples);
 			}
 		}
+	}
+
+	bool denoising_reconstruct(device_ptr color_ptr,
+	                           device_ptr color_variance_ptr,
+	                           device_ptr output_ptr,
+	                           DenoisingTask *task)
+	{
+		mem_zero(task->storage.XtWX);
+		mem_zero(task->storage.XtWY);
+
+		denoising_run_blocks(task, task->filter_area.w,
+		                     function_bind(&CPUDevice::denoising_reconstruct_block, this,
+		                                   color_ptr, color_variance_ptr, output_ptr, task, _1, _2));
 		return true;
 	}
 
@@ -686,7 +889,7 @@ public:
 
 	void path_trace(DeviceTask &task, RenderTile &tile, KernelGlobals *kg)
 	{
-		scoped_timer timer(&tile.buffers->render_time);
+		scoped_timer timer(&tile.time);
 
 		float *render_buffer = (float*)tile.buffer;
 		int start_sample = tile.start_sample;
@@ -713,6 +916,8 @@ public:
 
 	void denoise(DeviceTask &task, DenoisingTask& denoising, RenderTile &tile)
 	{
+		scoped_timer timer(&tile.time);
+
 		tile.sample = tile.start_sample + tile.num_samples;
 
 		denoising.functions.construct_transform = function_bind(&CPUDevice::denoising_construct_transform, this, &denoising);
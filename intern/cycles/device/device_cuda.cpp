@@ -1641,7 +1641,7 @@ public:
 
 	void path_trace(DeviceTask& task, RenderTile& rtile, device_vector<WorkTile>& work_tiles)
 	{
-		scoped_timer timer(&rtile.buffers->render_time);
+		scoped_timer timer(&rtile.time);
 
 		if(have_error())
 			return;
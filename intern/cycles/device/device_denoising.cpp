@@ -20,6 +20,10 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Upper limit for the number of pixels that are reconstructed at once, large enough
+ * for regular tiles to be handled in one go. */
+#define MAX_RECONSTRUCTION_PIXELS (512*512)
+
 DenoisingTask::DenoisingTask(Device *device)
 : tiles_mem(device, "denoising tiles_mem", MEM_READ_WRITE),
   storage(device),
@@ -67,10 +71,14 @@ void DenoisingTask::tiles_from_rendertiles(RenderTile *rtiles)
 	tiles = (TilesInfo*) tiles_mem.alloc(sizeof(TilesInfo)/sizeof(int));
 
 	device_ptr buffers[9];
+	whole_image = true;
 	for(int i = 0; i < 9; i++) {
 		buffers[i] = rtiles[i].buffer;
 		tiles->offsets[i] = rtiles[i].offset;
 		tiles->strides[i] = rtiles[i].stride;
+		if(i != 4 && buffers[i]) {
+			whole_image = false;
+		}
 	}
 	tiles->x[0] = rtiles[3].x;
 	tiles->x[1] = rtiles[4].x;
@@ -196,13 +204,16 @@ bool DenoisingTask::run_denoising()
 		}
 	}
 
-	storage.w = filter_area.z;
-	storage.h = filter_area.w;
+	/* The least squares storage takes several hundred bytes per pixel, so large filter
+	 * areas such as the full frame are reconstructed in bands of rows. */
+	int4 full_filter_area = filter_area;
+	int band_h = clamp(MAX_RECONSTRUCTION_PIXELS / full_filter_area.z, 1, full_filter_area.w);
+
+	storage.w = full_filter_area.z;
+	storage.h = band_h;
 	storage.transform.alloc_to_device(storage.w*storage.h*TRANSFORM_SIZE, false);
 	storage.rank.alloc_to_device(storage.w*storage.h, false);
 
-	functions.construct_transform();
-
 	device_only_memory<float> temporary_1(device, "Denoising NLM temporary 1");
 	device_only_memory<float> temporary_2(device, "Denoising NLM temporary 2");
 	temporary_1.alloc_to_device(buffer.pass_stride, false);
@@ -213,21 +224,30 @@ bool DenoisingTask::run_denoising()
 	storage.XtWX.alloc_to_device(storage.w*storage.h*XTWX_SIZE, false);
 	storage.XtWY.alloc_to_device(storage.w*storage.h*XTWY_SIZE, false);
 
-	reconstruction_state.filter_window = rect_from_shape(filter_area.x-rect.x, filter_area.y-rect.y, storage.w, storage.h);
-	int tile_coordinate_offset = filter_area.y*render_buffer.stride + filter_area.x;
-	reconstruction_state.buffer_params = make_int4(render_buffer.offset + tile_coordinate_offset,
-	                                               render_buffer.stride,
-	                                               render_buffer.pass_stride,
-	                                               render_buffer.denoising_clean_offset);
 	reconstruction_state.source_w = rect.z-rect.x;
 	reconstruction_state.source_h = rect.w-rect.y;
 
-	{
+	for(int band_y = 0; band_y < full_filter_area.w; band_y += band_h) {
+		filter_area = make_int4(full_filter_area.x, full_filter_area.y + band_y,
+		                        full_filter_area.z, min(band_h, full_filter_area.w - band_y));
+		storage.h = filter_area.w;
+
+		functions.construct_transform();
+
+		reconstruction_state.filter_window = rect_from_shape(filter_area.x-rect.x, filter_area.y-rect.y, storage.w, storage.h);
+		int tile_coordinate_offset = filter_area.y*render_buffer.stride + filter_area.x;
+		reconstruction_state.buffer_params = make_int4(render_buffer.offset + tile_coordinate_offset,
+		                                               render_buffer.stride,
+		                                               render_buffer.pass_stride,
+		                                               render_buffer.denoising_clean_offset);
+
 		device_sub_ptr color_ptr    (buffer.mem,  8*buffer.pass_stride, 3*buffer.pass_stride);
 		device_sub_ptr color_var_ptr(buffer.mem, 11*buffer.pass_stride, 3*buffer.pass_stride);
 		functions.reconstruct(*color_ptr, *color_var_ptr, render_buffer.ptr);
 	}
 
+	filter_area = full_filter_area;
+
 	return true;
 }
 
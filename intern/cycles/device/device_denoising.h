@@ -46,6 +46,9 @@ public:
 	TilesInfo *tiles;
 	device_vector<int> tiles_mem;
 	void tiles_from_rendertiles(RenderTile *rtiles);
+	/* There are no neighbor tiles, the area covers the whole image. So no other
+	 * tiles are rendered or denoised at the same time. */
+	bool whole_image;
 
 	int4 rect;
 	int4 filter_area;
@@ -59,7 +59,7 @@ public:
 
 	void path_trace(RenderTile& rtile, int sample)
 	{
-		scoped_timer timer(&rtile.buffers->render_time);
+		scoped_timer timer(&rtile.time);
 
 		/* Cast arguments to cl types. */
 		cl_mem d_data = CL_MEM_PTR(const_mem_map["__data"]->device_pointer);
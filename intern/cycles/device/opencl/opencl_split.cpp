@@ -139,7 +139,7 @@ public:
 			while(task->acquire_tile(this, tile)) {
 				if(tile.task == RenderTile::PATH_TRACE) {
 					assert(tile.task == RenderTile::PATH_TRACE);
-					scoped_timer timer(&tile.buffers->render_time);
+					scoped_timer timer(&tile.time);
 
 					split_kernel->path_trace(task,
 					                         tile,
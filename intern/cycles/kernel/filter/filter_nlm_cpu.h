@@ -26,20 +26,29 @@ ccl_device_inline void kernel_filter_nlm_calc_difference(int dx, int dy,
                                                          float a,
                                                          float k_2)
 {
+	/* Loop over the channels outside of the pixels, so that the inner loop vectorizes. */
+	const int numChannels = channel_offset? 3 : 1;
 	for(int y = rect.y; y < rect.w; y++) {
+		float *diff = difference_image + y*stride;
 		for(int x = rect.x; x < rect.z; x++) {
-			float diff = 0.0f;
-			int numChannels = channel_offset? 3 : 1;
-			for(int c = 0; c < numChannels; c++) {
-				float cdiff = weight_image[c*channel_offset + y*stride + x] - weight_image[c*channel_offset + (y+dy)*stride + (x+dx)];
-				float pvar = variance_image[c*channel_offset + y*stride + x];
-				float qvar = variance_image[c*channel_offset + (y+dy)*stride + (x+dx)];
-				diff += (cdiff*cdiff - a*(pvar + min(pvar, qvar))) / (1e-8f + k_2*(pvar+qvar));
+			diff[x] = 0.0f;
+		}
+		for(int c = 0; c < numChannels; c++) {
+			const float *ccl_restrict p_image = weight_image + c*channel_offset + y*stride;
+			const float *ccl_restrict q_image = weight_image + c*channel_offset + (y+dy)*stride + dx;
+			const float *ccl_restrict p_var = variance_image + c*channel_offset + y*stride;
+			const float *ccl_restrict q_var = variance_image + c*channel_offset + (y+dy)*stride + dx;
+			for(int x = rect.x; x < rect.z; x++) {
+				float cdiff = p_image[x] - q_image[x];
+				float pvar = p_var[x];
+				float qvar = q_var[x];
+				diff[x] += (cdiff*cdiff - a*(pvar + min(pvar, qvar))) / (1e-8f + k_2*(pvar+qvar));
 			}
-			if(numChannels > 1) {
-				diff *= 1.0f/numChannels;
+		}
+		if(numChannels > 1) {
+			for(int x = rect.x; x < rect.z; x++) {
+				diff[x] *= 1.0f/numChannels;
 			}
-			difference_image[y*stride + x] = diff;
 		}
 	}
 }
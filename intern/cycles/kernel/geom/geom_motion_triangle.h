@@ -70,10 +70,8 @@ ccl_device_inline void motion_triangle_verts_for_step(KernelGlobals *kg, uint4 t
 ccl_device_inline void motion_triangle_normals_for_step(KernelGlobals *kg, uint4 tri_vindex, int offset, int numverts, int numsteps, int step, float3 normals[3])
 {
 	if(step == numsteps) {
-		/* center step: regular vertex location */
-		normals[0] = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.x));
-		normals[1] = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.y));
-		normals[2] = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.z));
+		/* center step: regular vertex normals */
+		triangle_vertex_normals(kg, tri_vindex, normals);
 	}
 	else {
 		/* center step is not stored in this array */
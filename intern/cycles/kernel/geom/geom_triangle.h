@@ -74,17 +74,32 @@ ccl_device_inline void triangle_vertices(KernelGlobals *kg, int prim, float3 P[3
 	P[2] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+2));
 }
 
+/* Vertex normals, stored either as float4 or octahedral encoded */
+
+ccl_device_inline void triangle_vertex_normals(KernelGlobals *kg, uint4 tri_vindex, float3 N[3])
+{
+	if(kernel_data.bvh.use_compressed_normals) {
+		N[0] = octahedral_to_float3(kernel_tex_fetch(__tri_vnormal_oct, tri_vindex.x));
+		N[1] = octahedral_to_float3(kernel_tex_fetch(__tri_vnormal_oct, tri_vindex.y));
+		N[2] = octahedral_to_float3(kernel_tex_fetch(__tri_vnormal_oct, tri_vindex.z));
+	}
+	else {
+		N[0] = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.x));
+		N[1] = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.y));
+		N[2] = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.z));
+	}
+}
+
 /* Interpolate smooth vertex normal from vertices */
 
 ccl_device_inline float3 triangle_smooth_normal(KernelGlobals *kg, float3 Ng, int prim, float u, float v)
 {
 	/* load triangle vertices */
 	const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
-	float3 n0 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.x));
-	float3 n1 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.y));
-	float3 n2 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.z));
+	float3 n[3];
+	triangle_vertex_normals(kg, tri_vindex, n);
 
-	float3 N = safe_normalize((1.0f - u - v)*n2 + u*n0 + v*n1);
+	float3 N = safe_normalize((1.0f - u - v)*n[2] + u*n[0] + v*n[1]);
 
 	return is_zero(N)? Ng: N;
 }
@@ -171,7 +186,10 @@ ccl_device float3 triangle_attribute_float3(KernelGlobals *kg, const ShaderData
 
 		return sd->u*f0 + sd->v*f1 + (1.0f - sd->u - sd->v)*f2;
 	}
-	else if(desc.element == ATTR_ELEMENT_CORNER || desc.element == ATTR_ELEMENT_CORNER_BYTE) {
+	else if(desc.element == ATTR_ELEMENT_CORNER ||
+	        desc.element == ATTR_ELEMENT_CORNER_BYTE ||
+	        desc.element == ATTR_ELEMENT_CORNER_HALF)
+	{
 		int tri = desc.offset + sd->prim*3;
 		float3 f0, f1, f2;
 
@@ -180,6 +198,11 @@ ccl_device float3 triangle_attribute_float3(KernelGlobals *kg, const ShaderData
 			f1 = float4_to_float3(kernel_tex_fetch(__attributes_float3, tri + 1));
 			f2 = float4_to_float3(kernel_tex_fetch(__attributes_float3, tri + 2));
 		}
+		else if(desc.element == ATTR_ELEMENT_CORNER_HALF) {
+			f0 = half4_bits_to_float3(kernel_tex_fetch(__attributes_half4, tri + 0));
+			f1 = half4_bits_to_float3(kernel_tex_fetch(__attributes_half4, tri + 1));
+			f2 = half4_bits_to_float3(kernel_tex_fetch(__attributes_half4, tri + 2));
+		}
 		else {
 			f0 = color_byte_to_float(kernel_tex_fetch(__attributes_uchar4, tri + 0));
 			f1 = color_byte_to_float(kernel_tex_fetch(__attributes_uchar4, tri + 1));
@@ -769,6 +769,7 @@ typedef enum AttributeElement {
 	ATTR_ELEMENT_VERTEX_MOTION,
 	ATTR_ELEMENT_CORNER,
 	ATTR_ELEMENT_CORNER_BYTE,
+	ATTR_ELEMENT_CORNER_HALF,
 	ATTR_ELEMENT_CURVE,
 	ATTR_ELEMENT_CURVE_KEY,
 	ATTR_ELEMENT_CURVE_KEY_MOTION,
@@ -1396,7 +1397,8 @@ typedef struct KernelBVH {
 	int have_instancing;
 	int bvh_layout;
 	int use_bvh_steps;
-	int pad1, pad2;
+	int use_compressed_normals;
+	int pad1;
 } KernelBVH;
 static_assert_align(KernelBVH, 16);
 
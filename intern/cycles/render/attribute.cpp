@@ -169,6 +169,7 @@ size_t Attribute::element_size(Mesh *mesh, AttributePrimitive prim) const
 			break;
 		case ATTR_ELEMENT_CORNER:
 		case ATTR_ELEMENT_CORNER_BYTE:
+		case ATTR_ELEMENT_CORNER_HALF:
 			if(prim == ATTR_PRIM_TRIANGLE) {
 				size = mesh->num_triangles()*3;
 			}
@@ -108,6 +108,8 @@ RenderTile::RenderTile()
 	buffer = 0;
 
 	buffers = NULL;
+
+	time = 0.0;
 }
 
 /* Render Buffers */
@@ -130,11 +132,13 @@ void RenderBuffers::reset(BufferParams& params_)
 	/* re-allocate buffer */
 	buffer.alloc(params.width*params.height*params.get_passes_size());
 	buffer.zero_to_device();
+	render_time = 0.0;
 }
 
 void RenderBuffers::zero()
 {
 	buffer.zero_to_device();
+	render_time = 0.0;
 }
 
 bool RenderBuffers::copy_from_device()
@@ -75,6 +75,7 @@ public:
 	/* float buffer */
 	device_vector<float> buffer;
 	bool map_neighbor_copied;
+	/* time spent path tracing the buffer, summed over all its tiles */
 	double render_time;
 
 	explicit RenderBuffers(Device *device);
@@ -140,6 +141,10 @@ public:
 
 	RenderBuffers *buffers;
 
+	/* time the device spent on the task, measured by the device thread
+	 * and added to the statistics when the tile is released */
+	double time;
+
 	RenderTile();
 };
 
@@ -18,11 +18,14 @@
 #include "render/image.h"
 #include "render/scene.h"
 
+#include "util/util_algorithm.h"
 #include "util/util_foreach.h"
+#include "util/util_list.h"
 #include "util/util_logging.h"
 #include "util/util_path.h"
 #include "util/util_progress.h"
 #include "util/util_texture.h"
+#include "util/util_time.h"
 
 #ifdef WITH_OSL
 #include <OSL/oslexec.h>
@@ -40,6 +43,58 @@ static bool isfinite(half /*value*/)
 	return false;
 }
 
+/* Images loaded in worker threads, waiting to be copied to the device. */
+class ImageUploadQueue {
+public:
+	explicit ImageUploadQueue(size_t num_loads)
+	: num_pending(num_loads)
+	{
+	}
+
+	/* Called once by every load task, with -1 if there is nothing to upload. */
+	void push(int flat_slot)
+	{
+		thread_scoped_lock lock(mutex);
+		if(flat_slot != -1) {
+			slots.push_back(flat_slot);
+		}
+		num_pending--;
+		cond.notify_one();
+	}
+
+	/* Wait for the next loaded image, returns false once all loads are done. */
+	bool pop(int *flat_slot)
+	{
+		thread_scoped_lock lock(mutex);
+		while(slots.empty() && num_pending > 0) {
+			cond.wait(lock);
+		}
+		if(slots.empty()) {
+			return false;
+		}
+		*flat_slot = slots.front();
+		slots.pop_front();
+		return true;
+	}
+
+protected:
+	thread_mutex mutex;
+	thread_condition_variable cond;
+	list<int> slots;
+	size_t num_pending;
+};
+
+struct ImageLoadOrder {
+	ImageDataType type;
+	int slot;
+	size_t size;
+};
+
+static bool image_load_order_size_greater(const ImageLoadOrder& a, const ImageLoadOrder& b)
+{
+	return a.size > b.size;
+}
+
 ImageManager::ImageManager(const DeviceInfo& info)
 {
 	need_update = true;
@@ -578,6 +633,7 @@ bool ImageManager::file_load_image(Image *img,
 			/* TODO(dingto): Support half for ImBuf. */
 		}
 	}
+	img->timeline.read_end = time_dt();
 	/* Check if we actually have a float4 slot, in case components == 1,
 	 * but device doesn't support single channel textures.
 	 */
@@ -694,21 +750,26 @@ void ImageManager::device_load_image(Device *device,
                                      Scene *scene,
                                      ImageDataType type,
                                      int slot,
-                                     Progress *progress)
+                                     Progress *progress,
+                                     ImageUploadQueue *upload_queue)
 {
-	if(progress->get_cancel())
-		return;
-
 	Image *img = images[type][slot];
 
-	if(osl_texture_system && !img->builtin_data)
+	if(progress->get_cancel() || (osl_texture_system && !img->builtin_data)) {
+		if(upload_queue) {
+			upload_queue->push(-1);
+		}
 		return;
+	}
 
 	string filename = path_filename(images[type][slot]->filename);
 	progress->set_status("Updating Images", "Loading " + filename);
 
 	const int texture_limit = scene->params.texture_limit;
 
+	img->timeline.read_begin = time_dt();
+	img->timeline.read_end = img->timeline.read_begin;
+
 	/* Slot assignment */
 	int flat_slot = type_index_to_flattened_slot(slot, type);
 	img->mem_name = string_printf("__tex_image_%s_%03d", name_from_type(type).c_str(), flat_slot);
@@ -743,9 +804,6 @@ void ImageManager::device_load_image(Device *device,
 		img->mem = tex_img;
 		img->mem->interpolation = img->interpolation;
 		img->mem->extension = img->extension;
-
-		thread_scoped_lock device_lock(device_mutex);
-		tex_img->copy_to_device();
 	}
 	else if(type == IMAGE_DATA_TYPE_FLOAT) {
 		device_vector<float> *tex_img
@@ -766,9 +824,6 @@ void ImageManager::device_load_image(Device *device,
 		img->mem = tex_img;
 		img->mem->interpolation = img->interpolation;
 		img->mem->extension = img->extension;
-
-		thread_scoped_lock device_lock(device_mutex);
-		tex_img->copy_to_device();
 	}
 	else if(type == IMAGE_DATA_TYPE_BYTE4) {
 		device_vector<uchar4> *tex_img
@@ -792,9 +847,6 @@ void ImageManager::device_load_image(Device *device,
 		img->mem = tex_img;
 		img->mem->interpolation = img->interpolation;
 		img->mem->extension = img->extension;
-
-		thread_scoped_lock device_lock(device_mutex);
-		tex_img->copy_to_device();
 	}
 	else if(type == IMAGE_DATA_TYPE_BYTE) {
 		device_vector<uchar> *tex_img
@@ -814,9 +866,6 @@ void ImageManager::device_load_image(Device *device,
 		img->mem = tex_img;
 		img->mem->interpolation = img->interpolation;
 		img->mem->extension = img->extension;
-
-		thread_scoped_lock device_lock(device_mutex);
-		tex_img->copy_to_device();
 	}
 	else if(type == IMAGE_DATA_TYPE_HALF4) {
 		device_vector<half4> *tex_img
@@ -839,9 +888,6 @@ void ImageManager::device_load_image(Device *device,
 		img->mem = tex_img;
 		img->mem->interpolation = img->interpolation;
 		img->mem->extension = img->extension;
-
-		thread_scoped_lock device_lock(device_mutex);
-		tex_img->copy_to_device();
 	}
 	else if(type == IMAGE_DATA_TYPE_HALF) {
 		device_vector<half> *tex_img
@@ -861,12 +907,59 @@ void ImageManager::device_load_image(Device *device,
 		img->mem = tex_img;
 		img->mem->interpolation = img->interpolation;
 		img->mem->extension = img->extension;
+	}
+
+	img->timeline.convert_end = time_dt();
+	img->need_load = false;
+
+	if(upload_queue) {
+		/* Upload is done by the thread running device_update(). */
+		upload_queue->push(flat_slot);
+	}
+	else {
+		device_upload_image(type, img);
+	}
+}
+
+template<typename T>
+static void image_copy_to_device(device_memory *mem)
+{
+	((device_vector<T>*)mem)->copy_to_device();
+}
 
+void ImageManager::device_upload_image(ImageDataType type,
+                                       Image *img)
+{
+	img->timeline.upload_begin = time_dt();
+
+	{
 		thread_scoped_lock device_lock(device_mutex);
-		tex_img->copy_to_device();
+
+		switch(type) {
+			case IMAGE_DATA_TYPE_FLOAT4:
+				image_copy_to_device<float4>(img->mem);
+				break;
+			case IMAGE_DATA_TYPE_BYTE4:
+				image_copy_to_device<uchar4>(img->mem);
+				break;
+			case IMAGE_DATA_TYPE_HALF4:
+				image_copy_to_device<half4>(img->mem);
+				break;
+			case IMAGE_DATA_TYPE_FLOAT:
+				image_copy_to_device<float>(img->mem);
+				break;
+			case IMAGE_DATA_TYPE_BYTE:
+				image_copy_to_device<uchar>(img->mem);
+				break;
+			case IMAGE_DATA_TYPE_HALF:
+				image_copy_to_device<half>(img->mem);
+				break;
+			case IMAGE_DATA_NUM_TYPES:
+				break;
+		}
 	}
 
-	img->need_load = false;
+	img->timeline.upload_end = time_dt();
 }
 
 void ImageManager::device_free_image(Device *, ImageDataType type, int slot)
@@ -900,7 +993,11 @@ void ImageManager::device_update(Device *device,
 		return;
 	}
 
-	TaskPool pool;
+	const double update_start = time_dt();
+
+	/* Gather images to load, largest first so that the longest reads start
+	 * early and small images fill up the remaining threads. */
+	vector<ImageLoadOrder> load_order;
 	for(int type = 0; type < IMAGE_DATA_NUM_TYPES; type++) {
 		for(size_t slot = 0; slot < images[type].size(); slot++) {
 			if(!images[type][slot])
@@ -910,20 +1007,66 @@ void ImageManager::device_update(Device *device,
 				device_free_image(device, (ImageDataType)type, slot);
 			}
 			else if(images[type][slot]->need_load) {
-				if(!osl_texture_system || images[type][slot]->builtin_data)
-					pool.push(function_bind(&ImageManager::device_load_image,
-					                        this,
-					                        device,
-					                        scene,
-					                        (ImageDataType)type,
-					                        slot,
-					                        &progress));
+				if(!osl_texture_system || images[type][slot]->builtin_data) {
+					const ImageMetaData& metadata = images[type][slot]->metadata;
+					ImageLoadOrder order;
+					order.type = (ImageDataType)type;
+					order.slot = slot;
+					order.size = metadata.width * metadata.height * max(metadata.depth, (size_t)1);
+					load_order.push_back(order);
+				}
 			}
 		}
 	}
 
+	sort(load_order.begin(), load_order.end(), image_load_order_size_greater);
+
+	/* Decode and convert images in worker threads, and copy them to the
+	 * device from this thread as soon as each one is ready. This overlaps
+	 * uploads with reading the remaining images, and keeps the device
+	 * mutex out of the decoding threads. */
+	ImageUploadQueue upload_queue(load_order.size());
+	TaskPool pool;
+
+	foreach(const ImageLoadOrder& order, load_order) {
+		images[order.type][order.slot]->timeline.queued = time_dt();
+		pool.push(function_bind(&ImageManager::device_load_image,
+		                        this,
+		                        device,
+		                        scene,
+		                        order.type,
+		                        order.slot,
+		                        &progress,
+		                        &upload_queue));
+	}
+
+	int flat_slot;
+	while(upload_queue.pop(&flat_slot)) {
+		ImageDataType type;
+		int slot = flattened_slot_to_type_index(flat_slot, &type);
+		device_upload_image(type, images[type][slot]);
+	}
+
 	pool.wait_work();
 
+	if(!load_order.empty() && !progress.get_cancel()) {
+		VLOG(1) << "Image load timeline, in seconds since start of update:";
+		foreach(const ImageLoadOrder& order, load_order) {
+			const Image *img = images[order.type][order.slot];
+			const Image::LoadTimeline& t = img->timeline;
+			VLOG(1) << string_printf("  %s: queued %.3f, read %.3f-%.3f, converted %.3f, upload %.3f-%.3f",
+			                         path_filename(img->filename).c_str(),
+			                         t.queued - update_start,
+			                         t.read_begin - update_start,
+			                         t.read_end - update_start,
+			                         t.convert_end - update_start,
+			                         t.upload_begin - update_start,
+			                         t.upload_end - update_start);
+		}
+		VLOG(1) << string_printf("Loaded %d images in %.3f seconds.",
+		                         (int)load_order.size(), time_dt() - update_start);
+	}
+
 	need_update = false;
 }
 
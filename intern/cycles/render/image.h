@@ -28,6 +28,7 @@
 CCL_NAMESPACE_BEGIN
 
 class Device;
+class ImageUploadQueue;
 class Progress;
 class Scene;
 
@@ -125,6 +126,16 @@ public:
 		device_memory *mem;
 
 		int users;
+
+		/* Timestamps of the last load, for logging the load timeline. */
+		struct LoadTimeline {
+			double queued;
+			double read_begin;
+			double read_end;
+			double convert_end;
+			double upload_begin;
+			double upload_end;
+		} timeline;
 	};
 
 private:
@@ -158,7 +169,10 @@ private:
 	                       Scene *scene,
 	                       ImageDataType type,
 	                       int slot,
-	                       Progress *progess);
+	                       Progress *progess,
+	                       ImageUploadQueue *upload_queue = NULL);
+	void device_upload_image(ImageDataType type,
+	                         Image *img);
 	void device_free_image(Device *device,
 	                       ImageDataType type,
 	                       int slot);
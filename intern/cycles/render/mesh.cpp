@@ -34,6 +34,7 @@
 #include "subd/subd_patch_table.h"
 
 #include "util/util_foreach.h"
+#include "util/util_half.h"
 #include "util/util_logging.h"
 #include "util/util_progress.h"
 #include "util/util_set.h"
@@ -923,6 +924,30 @@ void Mesh::pack_normals(float4 *vnormal)
 	}
 }
 
+void Mesh::pack_normals(uint *vnormal_oct)
+{
+	Attribute *attr_vN = attributes.find(ATTR_STD_VERTEX_NORMAL);
+	if(attr_vN == NULL) {
+		/* Happens on objects with just hair. */
+		return;
+	}
+
+	bool do_transform = transform_applied;
+	Transform ntfm = transform_normal;
+
+	float3 *vN = attr_vN->data_float3();
+	size_t verts_size = verts.size();
+
+	for(size_t i = 0; i < verts_size; i++) {
+		float3 vNi = vN[i];
+
+		if(do_transform)
+			vNi = safe_normalize(transform_direction(&ntfm, vNi));
+
+		vnormal_oct[i] = float3_to_octahedral(vNi);
+	}
+}
+
 void Mesh::pack_verts(const vector<uint>& tri_prim_index,
                       uint4 *tri_vindex,
                       uint *tri_patch,
@@ -1160,12 +1185,102 @@ bool Mesh::is_instanced() const
 	return !transform_applied || has_surface_bssrdf;
 }
 
+size_t Mesh::packed_memory_size() const
+{
+	size_t size = 0;
+
+	/* Triangles: indices, shader, patch and vertex positions in prim_tri_verts. */
+	size += num_triangles() * (sizeof(uint4) + sizeof(uint) * 2 + sizeof(float4) * 3);
+	/* Vertex normals and patch coordinates. */
+	size += verts.size() * (sizeof(float4) + sizeof(float2));
+	/* Curves and curve keys. */
+	size += num_curves() * sizeof(float4);
+	size += curve_keys.size() * sizeof(float4);
+
+	foreach(const Attribute& attr, attributes.attributes) {
+		size += attr.buffer.size();
+	}
+	foreach(const Attribute& attr, curve_attributes.attributes) {
+		size += attr.buffer.size();
+	}
+
+	return size;
+}
+
+/* Mesh Instance Statistics */
+
+static size_t packed_bvh_memory_size(const PackedBVH& pack)
+{
+	return pack.nodes.size() * sizeof(int4) +
+	       pack.leaf_nodes.size() * sizeof(int4) +
+	       pack.object_node.size() * sizeof(int) +
+	       pack.prim_tri_index.size() * sizeof(uint) +
+	       pack.prim_tri_verts.size() * sizeof(float4) +
+	       pack.prim_type.size() * sizeof(int) +
+	       pack.prim_visibility.size() * sizeof(uint) +
+	       pack.prim_index.size() * sizeof(int) +
+	       pack.prim_object.size() * sizeof(int) +
+	       pack.prim_time.size() * sizeof(float2);
+}
+
+MeshInstanceStats::MeshInstanceStats()
+: num_meshes(0),
+  num_instances(0),
+  mesh_memory(0),
+  instance_memory(0),
+  memory_saved(0),
+  bvh_memory_freed(0)
+{
+}
+
+string MeshInstanceStats::full_report() const
+{
+	string report = "";
+	report += string_printf("Instanced meshes:   %lu\n", (unsigned long)num_meshes);
+	report += string_printf("Instances:          %lu\n", (unsigned long)num_instances);
+	report += string_printf("Mesh memory:        %s\n", string_human_readable_size(mesh_memory).c_str());
+	report += string_printf("Instance memory:    %s", string_human_readable_size(instance_memory).c_str());
+	if(num_instances) {
+		report += string_printf(" (%lu bytes per instance)",
+		                        (unsigned long)(instance_memory / num_instances));
+	}
+	report += "\n";
+	report += string_printf("Saved by instancing: %s\n", string_human_readable_size(memory_saved).c_str());
+	report += string_printf("Freed mesh BVHs:    %s\n", string_human_readable_size(bvh_memory_freed).c_str());
+	return report;
+}
+
+MeshCompressionStats::MeshCompressionStats()
+: normals_saved(0),
+  uvs_saved(0),
+  tangents_saved(0),
+  colors_saved(0)
+{
+}
+
+size_t MeshCompressionStats::total_saved() const
+{
+	return normals_saved + uvs_saved + tangents_saved + colors_saved;
+}
+
+string MeshCompressionStats::full_report() const
+{
+	string report = "";
+	report += string_printf("Normals saved:      %s\n", string_human_readable_size(normals_saved).c_str());
+	report += string_printf("UVs saved:          %s\n", string_human_readable_size(uvs_saved).c_str());
+	report += string_printf("Tangents saved:     %s\n", string_human_readable_size(tangents_saved).c_str());
+	report += string_printf("Colors saved:       %s\n", string_human_readable_size(colors_saved).c_str());
+	report += string_printf("Total saved:        %s\n", string_human_readable_size(total_saved()).c_str());
+	return report;
+}
+
 /* Mesh Manager */
 
 MeshManager::MeshManager()
 {
 	need_update = true;
 	need_flags_update = true;
+	bvh_build_time = 0.0;
 }
 
 MeshManager::~MeshManager()
@@ -1392,12 +1507,34 @@ void MeshManager::update_svm_attributes(Device *, DeviceScene *dscene, Scene *sc
 	dscene->attributes_map.copy_to_device();
 }
 
+/* Corner UVs, tangents and colors of triangle meshes may be stored as half
+ * floats when compressed attributes are enabled. */
+static bool attribute_use_half_storage(Mesh *mesh,
+                                       Attribute *mattr,
+                                       AttributePrimitive prim,
+                                       bool use_compressed_attributes)
+{
+	if(!use_compressed_attributes ||
+	   prim != ATTR_PRIM_TRIANGLE ||
+	   mesh->subdivision_type != Mesh::SUBDIVISION_NONE ||
+	   mattr->element != ATTR_ELEMENT_CORNER)
+	{
+		return false;
+	}
+
+	return (mattr->std == ATTR_STD_UV ||
+	        mattr->std == ATTR_STD_UV_TANGENT ||
+	        mattr->type == TypeDesc::TypeColor);
+}
+
 static void update_attribute_element_size(Mesh *mesh,
                                           Attribute *mattr,
                                           AttributePrimitive prim,
+                                          bool use_compressed_attributes,
                                           size_t *attr_float_size,
                                           size_t *attr_float3_size,
-                                          size_t *attr_uchar4_size)
+                                          size_t *attr_uchar4_size,
+                                          size_t *attr_half4_size)
 {
 	if(mattr) {
 		size_t size = mattr->element_size(mesh, prim);
@@ -1408,6 +1545,9 @@ static void update_attribute_element_size(Mesh *mesh,
 		else if(mattr->element == ATTR_ELEMENT_CORNER_BYTE) {
 			*attr_uchar4_size += size;
 		}
+		else if(attribute_use_half_storage(mesh, mattr, prim, use_compressed_attributes)) {
+			*attr_half4_size += size;
+		}
 		else if(mattr->type == TypeDesc::TypeFloat) {
 			*attr_float_size += size;
 		}
@@ -1427,10 +1567,14 @@ static void update_attribute_element_offset(Mesh *mesh,
                                             size_t& attr_float3_offset,
                                             device_vector<uchar4>& attr_uchar4,
                                             size_t& attr_uchar4_offset,
+                                            device_vector<uint2>& attr_half4,
+                                            size_t& attr_half4_offset,
                                             Attribute *mattr,
                                             AttributePrimitive prim,
+                                            bool use_compressed_attributes,
                                             TypeDesc& type,
-                                            AttributeDescriptor& desc)
+                                            AttributeDescriptor& desc,
+                                            MeshCompressionStats& stats)
 {
 	if(mattr) {
 		/* store element and type */
@@ -1459,6 +1603,25 @@ static void update_attribute_element_offset(Mesh *mesh,
 			}
 			attr_uchar4_offset += size;
 		}
+		else if(attribute_use_half_storage(mesh, mattr, prim, use_compressed_attributes)) {
+			float4 *data = mattr->data_float4();
+			offset = attr_half4_offset;
+			element = ATTR_ELEMENT_CORNER_HALF;
+
+			assert(attr_half4.size() >= offset + size);
+			for(size_t k = 0; k < size; k++) {
+				attr_half4[offset+k] = float3_to_half4_bits(float4_to_float3(data[k]));
+			}
+			attr_half4_offset += size;
+
+			const size_t saved = size * (sizeof(float4) - sizeof(uint2));
+			if(mattr->std == ATTR_STD_UV)
+				stats.uvs_saved += saved;
+			else if(mattr->std == ATTR_STD_UV_TANGENT)
+				stats.tangents_saved += saved;
+			else
+				stats.colors_saved += saved;
+		}
 		else if(mattr->type == TypeDesc::TypeFloat) {
 			float *data = mattr->data_float();
 			offset = attr_float_offset;
@@ -1506,7 +1669,10 @@ static void update_attribute_element_offset(Mesh *mesh,
 			else
 				offset -= mesh->face_offset;
 		}
-		else if(element == ATTR_ELEMENT_CORNER || element == ATTR_ELEMENT_CORNER_BYTE) {
+		else if(element == ATTR_ELEMENT_CORNER ||
+		        element == ATTR_ELEMENT_CORNER_BYTE ||
+		        element == ATTR_ELEMENT_CORNER_HALF)
+		{
 			if(prim == ATTR_PRIM_TRIANGLE)
 				offset -= 3*mesh->tri_offset;
 			else
@@ -1552,9 +1718,11 @@ void MeshManager::device_update_attributes(Device *device, DeviceScene *dscene,
 	/* Pre-allocate attributes to avoid arrays re-allocation which would
 	 * take 2x of overall attribute memory usage.
 	 */
+	const bool use_compressed_attributes = scene->params.use_compressed_attributes;
 	size_t attr_float_size = 0;
 	size_t attr_float3_size = 0;
 	size_t attr_uchar4_size = 0;
+	size_t attr_half4_size = 0;
 	for(size_t i = 0; i < scene->meshes.size(); i++) {
 		Mesh *mesh = scene->meshes[i];
 		AttributeRequestSet& attributes = mesh_attributes[i];
@@ -1566,31 +1734,43 @@ void MeshManager::device_update_attributes(Device *device, DeviceScene *dscene,
 			update_attribute_element_size(mesh,
 			                              triangle_mattr,
 			                              ATTR_PRIM_TRIANGLE,
+			                              use_compressed_attributes,
 			                              &attr_float_size,
 			                              &attr_float3_size,
-			                              &attr_uchar4_size);
+			                              &attr_uchar4_size,
+			                              &attr_half4_size);
 			update_attribute_element_size(mesh,
 			                              curve_mattr,
 			                              ATTR_PRIM_CURVE,
+			                              use_compressed_attributes,
 			                              &attr_float_size,
 			                              &attr_float3_size,
-			                              &attr_uchar4_size);
+			                              &attr_uchar4_size,
+			                              &attr_half4_size);
 			update_attribute_element_size(mesh,
 			                              subd_mattr,
 			                              ATTR_PRIM_SUBD,
+			                              use_compressed_attributes,
 			                              &attr_float_size,
 			                              &attr_float3_size,
-			                              &attr_uchar4_size);
+			                              &attr_uchar4_size,
+			                              &attr_half4_size);
 		}
 	}
 
 	dscene->attributes_float.alloc(attr_float_size);
 	dscene->attributes_float3.alloc(attr_float3_size);
 	dscene->attributes_uchar4.alloc(attr_uchar4_size);
+	dscene->attributes_half4.alloc(attr_half4_size);
 
 	size_t attr_float_offset = 0;
 	size_t attr_float3_offset = 0;
 	size_t attr_uchar4_offset = 0;
+	size_t attr_half4_offset = 0;
+
+	compression_stats.uvs_saved = 0;
+	compression_stats.tangents_saved = 0;
+	compression_stats.colors_saved = 0;
 
 	/* Fill in attributes. */
 	for(size_t i = 0; i < scene->meshes.size(); i++) {
@@ -1608,28 +1788,37 @@ void MeshManager::device_update_attributes(Device *device, DeviceScene *dscene,
 			                                dscene->attributes_float, attr_float_offset,
 			                                dscene->attributes_float3, attr_float3_offset,
 			                                dscene->attributes_uchar4, attr_uchar4_offset,
+			                                dscene->attributes_half4, attr_half4_offset,
 			                                triangle_mattr,
 			                                ATTR_PRIM_TRIANGLE,
+			                                use_compressed_attributes,
 			                                req.triangle_type,
-			                                req.triangle_desc);
+			                                req.triangle_desc,
+			                                compression_stats);
 
 			update_attribute_element_offset(mesh,
 			                                dscene->attributes_float, attr_float_offset,
 			                                dscene->attributes_float3, attr_float3_offset,
 			                                dscene->attributes_uchar4, attr_uchar4_offset,
+			                                dscene->attributes_half4, attr_half4_offset,
 			                                curve_mattr,
 			                                ATTR_PRIM_CURVE,
+			                                use_compressed_attributes,
 			                                req.curve_type,
-			                                req.curve_desc);
+			                                req.curve_desc,
+			                                compression_stats);
 
 			update_attribute_element_offset(mesh,
 			                                dscene->attributes_float, attr_float_offset,
 			                                dscene->attributes_float3, attr_float3_offset,
 			                                dscene->attributes_uchar4, attr_uchar4_offset,
+			                                dscene->attributes_half4, attr_half4_offset,
 			                                subd_mattr,
 			                                ATTR_PRIM_SUBD,
+			                                use_compressed_attributes,
 			                                req.subd_type,
-			                                req.subd_desc);
+			                                req.subd_desc,
+			                                compression_stats);
 
 			if(progress.get_cancel()) return;
 		}
@@ -1655,6 +1844,9 @@ void MeshManager::device_update_attributes(Device *device, DeviceScene *dscene,
 	if(dscene->attributes_uchar4.size()) {
 		dscene->attributes_uchar4.copy_to_device();
 	}
+	if(dscene->attributes_half4.size()) {
+		dscene->attributes_half4.copy_to_device();
+	}
 
 	if(progress.get_cancel()) return;
 
@@ -1764,12 +1956,27 @@ void MeshManager::device_update_mesh(Device *,
 	}
 
 	/* Fill in all the arrays. */
+	const bool use_compressed_normals = scene->params.use_compressed_attributes;
+	dscene->data.bvh.use_compressed_normals = use_compressed_normals;
+	compression_stats.normals_saved = 0;
+
 	if(tri_size != 0) {
 		/* normals */
 		progress.set_status("Updating Mesh", "Computing normals");
 
 		uint *tri_shader = dscene->tri_shader.alloc(tri_size);
-		float4 *vnormal = dscene->tri_vnormal.alloc(vert_size);
+		float4 *vnormal = NULL;
+		uint *vnormal_oct = NULL;
+		if(use_compressed_normals) {
+			/* Octahedral encoded, 4 bytes per normal instead of 16. */
+			vnormal_oct = dscene->tri_vnormal_oct.alloc(vert_size);
+			dscene->tri_vnormal.free();
+			compression_stats.normals_saved = vert_size * (sizeof(float4) - sizeof(uint));
+		}
+		else {
+			vnormal = dscene->tri_vnormal.alloc(vert_size);
+			dscene->tri_vnormal_oct.free();
+		}
 		uint4 *tri_vindex = dscene->tri_vindex.alloc(tri_size);
 		uint *tri_patch = dscene->tri_patch.alloc(tri_size);
 		float2 *tri_patch_uv = dscene->tri_patch_uv.alloc(vert_size);
@@ -1777,7 +1984,10 @@ void MeshManager::device_update_mesh(Device *,
 		foreach(Mesh *mesh, scene->meshes) {
 			mesh->pack_shaders(scene,
 			                   &tri_shader[mesh->tri_offset]);
-			mesh->pack_normals(&vnormal[mesh->vert_offset]);
+			if(use_compressed_normals)
+				mesh->pack_normals(&vnormal_oct[mesh->vert_offset]);
+			else
+				mesh->pack_normals(&vnormal[mesh->vert_offset]);
 			mesh->pack_verts(tri_prim_index,
 			                 &tri_vindex[mesh->tri_offset],
 			                 &tri_patch[mesh->tri_offset],
@@ -1791,7 +2001,10 @@ void MeshManager::device_update_mesh(Device *,
 		progress.set_status("Updating Mesh", "Copying Mesh to device");
 
 		dscene->tri_shader.copy_to_device();
-		dscene->tri_vnormal.copy_to_device();
+		if(use_compressed_normals)
+			dscene->tri_vnormal_oct.copy_to_device();
+		else
+			dscene->tri_vnormal.copy_to_device();
 		dscene->tri_vindex.copy_to_device();
 		dscene->tri_patch.copy_to_device();
 		dscene->tri_patch_uv.copy_to_device();
@@ -1872,11 +2085,29 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 		return;
 	}
 
+	PackedBVH& pack = bvh->pack;
+
+	update_instance_stats(scene, pack);
+
+	/* Instanced mesh BVHs were merged into the scene BVH. For final renders
+	 * without persistent data they will not be refit or packed again, so
+	 * there is no need to keep a second copy of them in memory. */
+	if(scene->params.bvh_type == SceneParams::BVH_STATIC && !scene->params.persistent_data) {
+		foreach(Mesh *mesh, scene->meshes) {
+			if(mesh->bvh) {
+				instance_stats.bvh_memory_freed += packed_bvh_memory_size(mesh->bvh->pack);
+				delete mesh->bvh;
+				mesh->bvh = NULL;
+			}
+		}
+	}
+
+	VLOG(1) << "Instancing statistics:\n"
+	        << instance_stats.full_report();
+
 	/* copy to device */
 	progress.set_status("Updating Scene BVH", "Copying BVH to device");
 
-	PackedBVH& pack = bvh->pack;
-
 	if(pack.nodes.size()) {
 		dscene->bvh_nodes.steal_data(pack.nodes);
 		dscene->bvh_nodes.copy_to_device();
@@ -1925,6 +2156,54 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 	delete bvh;
 }
 
+void MeshManager::update_instance_stats(Scene *scene, const PackedBVH& pack)
+{
+	instance_stats = MeshInstanceStats();
+
+	map<Mesh*, size_t> mesh_users;
+	foreach(Object *object, scene->objects) {
+		if(object->mesh->is_instanced()) {
+			mesh_users[object->mesh]++;
+		}
+	}
+
+	/* Per instance data: object, flag and BVH root node, and the reference
+	 * to the instance in the primitive arrays of the top level BVH. */
+	const size_t object_size = sizeof(KernelObject) + sizeof(uint) + sizeof(int);
+	const size_t reference_size = sizeof(int) * 4 + sizeof(uint);
+
+	for(map<Mesh*, size_t>::iterator it = mesh_users.begin(); it != mesh_users.end(); ++it) {
+		Mesh *mesh = it->first;
+		size_t num_users = it->second;
+		size_t mesh_size = mesh->packed_memory_size();
+
+		if(mesh->bvh) {
+			mesh_size += packed_bvh_memory_size(mesh->bvh->pack);
+		}
+
+		instance_stats.num_meshes++;
+		instance_stats.num_instances += num_users;
+		instance_stats.mesh_memory += mesh_size;
+		instance_stats.memory_saved += (num_users - 1) * mesh_size;
+	}
+
+	instance_stats.instance_memory = instance_stats.num_instances * (object_size + reference_size);
+
+	/* Share of the top level BVH nodes, which do not belong to any mesh BVH. */
+	size_t num_top_level_nodes = pack.nodes.size();
+	for(map<Mesh*, size_t>::iterator it = mesh_users.begin(); it != mesh_users.end(); ++it) {
+		if(it->first->bvh) {
+			size_t num_mesh_nodes = it->first->bvh->pack.nodes.size();
+			num_top_level_nodes = (num_top_level_nodes > num_mesh_nodes)?
+			        num_top_level_nodes - num_mesh_nodes: 0;
+		}
+	}
+	if(instance_stats.num_instances && scene->objects.size()) {
+		instance_stats.instance_memory += num_top_level_nodes * sizeof(int4) *
+		                                  instance_stats.num_instances / scene->objects.size();
+	}
+}
+
 void MeshManager::device_update_preprocess(Device *device,
                                            Scene *scene,
                                            Progress& progress)
@@ -2068,6 +2347,12 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 				mesh->need_update = true;
 		}
 
+		/* BVH of instanced meshes may have been freed after merging it into
+		 * the scene BVH, it needs to be built again to rebuild the scene BVH. */
+		if(mesh->bvh == NULL && mesh->need_build_bvh()) {
+			mesh->need_update = true;
+		}
+
 		if(mesh->need_update) {
 			/* Update normals. */
 			mesh->add_face_normals();
@@ -2174,6 +2459,7 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 		if(progress.get_cancel()) return;
 	}
 
+	scoped_timer object_bvh_timer;
 	TaskPool pool;
 
 	size_t i = 0;
@@ -2197,6 +2483,7 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	pool.wait_work(&summary);
 	VLOG(2) << "Objects BVH build pool statistics:\n"
 	        << summary.full_report();
+	bvh_build_time = object_bvh_timer.get_time();
 
 	foreach(Shader *shader, scene->shaders) {
 		shader->need_update_mesh = false;
@@ -2213,12 +2500,21 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 
 	if(progress.get_cancel()) return;
 
-	device_update_bvh(device, dscene, scene, progress);
+	{
+		scoped_timer scene_bvh_timer;
+		device_update_bvh(device, dscene, scene, progress);
+		bvh_build_time += scene_bvh_timer.get_time();
+	}
 	if(progress.get_cancel()) return;
 
 	device_update_mesh(device, dscene, scene, false, progress);
 	if(progress.get_cancel()) return;
 
+	if(scene->params.use_compressed_attributes) {
+		VLOG(1) << "Compressed attributes statistics:\n"
+		        << compression_stats.full_report();
+	}
+
 	need_update = false;
 
 	if(true_displacement_used) {
@@ -2246,6 +2542,7 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
 	dscene->prim_time.free();
 	dscene->tri_shader.free();
 	dscene->tri_vnormal.free();
+	dscene->tri_vnormal_oct.free();
 	dscene->tri_vindex.free();
 	dscene->tri_patch.free();
 	dscene->tri_patch_uv.free();
@@ -2256,6 +2553,7 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
 	dscene->attributes_float.free();
 	dscene->attributes_float3.free();
 	dscene->attributes_uchar4.free();
+	dscene->attributes_half4.free();
 
 #ifdef WITH_OSL
 	OSLGlobals *og = (OSLGlobals*)device->osl_memory();
@@ -38,6 +38,7 @@ class Device;
 class DeviceScene;
 class Mesh;
 class Progress;
+struct PackedBVH;
 class Scene;
 class SceneParams;
 class AttributeRequest;
@@ -281,6 +282,7 @@ public:
 
 	void pack_shaders(Scene *scene, uint *shader);
 	void pack_normals(float4 *vnormal);
+	void pack_normals(uint *vnormal_oct);
 	void pack_verts(const vector<uint>& tri_prim_index,
 	                uint4 *tri_vindex,
 	                uint *tri_patch,
@@ -323,9 +325,56 @@ public:
 	/* Check if the mesh should be treated as instanced. */
 	bool is_instanced() const;
 
+	/* Approximate size of the geometry arrays of this mesh once packed for
+	 * the device, excluding the BVH. */
+	size_t packed_memory_size() const;
+
 	void tessellate(DiagSplit *split);
 };
 
+/* Mesh Instance Statistics
+ *
+ * Memory used by instanced meshes, which are stored and built once and
+ * referenced by transform from every object using them. */
+
+class MeshInstanceStats {
+public:
+	MeshInstanceStats();
+
+	string full_report() const;
+
+	/* Number of meshes with their own BVH, and objects referencing them. */
+	size_t num_meshes;
+	size_t num_instances;
+	/* Geometry and BVH memory of instanced meshes, stored once. */
+	size_t mesh_memory;
+	/* Per object memory of instances: object data and top level references. */
+	size_t instance_memory;
+	/* Memory which would be used if every instance had its own copy of the mesh. */
+	size_t memory_saved;
+	/* Host memory of mesh BVHs freed after merging into the scene BVH. */
+	size_t bvh_memory_freed;
+};
+
+/* Mesh Compression Statistics
+ *
+ * Device memory saved by compressed attribute storage, per attribute class. */
+
+class MeshCompressionStats {
+public:
+	MeshCompressionStats();
+
+	size_t total_saved() const;
+	string full_report() const;
+
+	/* Octahedral encoded vertex normals. */
+	size_t normals_saved;
+	/* Half float corner attributes. */
+	size_t uvs_saved;
+	size_t tangents_saved;
+	size_t colors_saved;
+};
+
 /* Mesh Manager */
 
 class MeshManager {
@@ -333,6 +382,15 @@ public:
 	bool need_update;
 	bool need_flags_update;
 
+	/* Time spent building object and scene BVHs in the last device update. */
+	double bvh_build_time;
+
+	/* Memory statistics of instanced meshes from the last device update. */
+	MeshInstanceStats instance_stats;
+
+	/* Memory saved by compressed attributes in the last device update. */
+	MeshCompressionStats compression_stats;
+
 	MeshManager();
 	~MeshManager();
 
@@ -376,6 +434,8 @@ protected:
 	                       Scene *scene,
 	                       Progress& progress);
 
+	void update_instance_stats(Scene *scene, const PackedBVH& pack);
+
 	void device_update_displacement_images(Device *device,
 	                                       Scene *scene,
 	                                       Progress& progress);
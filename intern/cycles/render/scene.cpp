@@ -53,6 +53,7 @@ DeviceScene::DeviceScene(Device *device)
   prim_time(device, "__prim_time", MEM_TEXTURE),
   tri_shader(device, "__tri_shader", MEM_TEXTURE),
   tri_vnormal(device, "__tri_vnormal", MEM_TEXTURE),
+  tri_vnormal_oct(device, "__tri_vnormal_oct", MEM_TEXTURE),
   tri_vindex(device, "__tri_vindex", MEM_TEXTURE),
   tri_patch(device, "__tri_patch", MEM_TEXTURE),
   tri_patch_uv(device, "__tri_patch_uv", MEM_TEXTURE),
@@ -68,6 +69,7 @@ DeviceScene::DeviceScene(Device *device)
   attributes_float(device, "__attributes_float", MEM_TEXTURE),
   attributes_float3(device, "__attributes_float3", MEM_TEXTURE),
   attributes_uchar4(device, "__attributes_uchar4", MEM_TEXTURE),
+  attributes_half4(device, "__attributes_half4", MEM_TEXTURE),
   light_distribution(device, "__light_distribution", MEM_TEXTURE),
   lights(device, "__lights", MEM_TEXTURE),
   light_background_marginal_cdf(device, "__light_background_marginal_cdf", MEM_TEXTURE),
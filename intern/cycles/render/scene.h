@@ -76,6 +76,7 @@ public:
 	/* mesh */
 	device_vector<uint> tri_shader;
 	device_vector<float4> tri_vnormal;
+	device_vector<uint> tri_vnormal_oct;
 	device_vector<uint4> tri_vindex;
 	device_vector<uint> tri_patch;
 	device_vector<float2> tri_patch_uv;
@@ -99,6 +100,7 @@ public:
 	device_vector<float> attributes_float;
 	device_vector<float4> attributes_float3;
 	device_vector<uchar4> attributes_uchar4;
+	device_vector<uint2> attributes_half4;
 
 	/* lights */
 	device_vector<KernelLightDistribution> light_distribution;
@@ -169,6 +171,11 @@ public:
 	bool persistent_data;
 	int texture_limit;
 
+	/* Store vertex normals octahedral encoded and eligible corner attributes
+	 * (UVs, tangents and colors) as half floats, trading a little precision
+	 * for less device memory. */
+	bool use_compressed_attributes;
+
 	SceneParams()
 	{
 		shadingsystem = SHADINGSYSTEM_SVM;
@@ -179,6 +186,7 @@ public:
 		num_bvh_time_steps = 0;
 		persistent_data = false;
 		texture_limit = 0;
+		use_compressed_attributes = false;
 	}
 
 	bool modified(const SceneParams& params)
@@ -189,7 +197,8 @@ public:
 		&& use_bvh_unaligned_nodes == params.use_bvh_unaligned_nodes
 		&& num_bvh_time_steps == params.num_bvh_time_steps
 		&& persistent_data == params.persistent_data
-		&& texture_limit == params.texture_limit); }
+		&& texture_limit == params.texture_limit
+		&& use_compressed_attributes == params.use_compressed_attributes); }
 };
 
 /* Scene */
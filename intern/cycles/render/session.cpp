@@ -375,6 +375,7 @@ bool Session::acquire_tile(Device *tile_device, RenderTile& rtile)
 	rtile.resolution = tile_manager.state.resolution_divider;
 	rtile.tile_index = tile->index;
 	rtile.task = (tile->state == Tile::DENOISE)? RenderTile::DENOISE: RenderTile::PATH_TRACE;
+	rtile.time = 0.0;
 
 	tile_lock.unlock();
 
@@ -440,6 +441,13 @@ void Session::release_tile(RenderTile& rtile)
 
 	progress.add_finished_tile(rtile.task == RenderTile::DENOISE);
 
+	/* the buffers can be shared by the tiles of all device threads, the time
+	 * of each tile is only added while holding the tile lock */
+	progress.add_tile_time(rtile.task == RenderTile::DENOISE, rtile.time);
+	if(rtile.task == RenderTile::PATH_TRACE && rtile.buffers) {
+		rtile.buffers->render_time += rtile.time;
+	}
+
 	bool delete_tile;
 
 	if(tile_manager.finish_tile(rtile.tile_index, delete_tile)) {
@@ -453,7 +461,9 @@ void Session::release_tile(RenderTile& rtile)
 		}
 	}
 	else {
-		if(update_render_tile_cb && params.progressive_refine == false) {
+		/* With full frame denoising the tiles are part of the full frame buffer,
+		 * which is only written once it has been denoised. */
+		if(update_render_tile_cb && params.progressive_refine == false && !tile_manager.denoise_full_frame) {
 			update_render_tile_cb(rtile, false);
 		}
 	}
@@ -467,14 +477,18 @@ void Session::map_neighbor_tiles(RenderTile *tiles, Device *tile_device)
 
 	int center_idx = tiles[4].tile_index;
 	assert(tile_manager.state.tiles[center_idx].state == Tile::DENOISE);
+	/* The full frame tile covers the whole image, so all of its neighbors are outside of it. */
+	int2 neighbor_step = (center_idx == tile_manager.state.full_frame_tile)?
+	                     make_int2(tiles[4].w, tiles[4].h):
+	                     params.tile_size;
 	BufferParams buffer_params = tile_manager.params;
 	int4 image_region = make_int4(buffer_params.full_x, buffer_params.full_y,
 	                              buffer_params.full_x + buffer_params.width, buffer_params.full_y + buffer_params.height);
 
 	for(int dy = -1, i = 0; dy <= 1; dy++) {
 		for(int dx = -1; dx <= 1; dx++, i++) {
-			int px = tiles[4].x + dx*params.tile_size.x;
-			int py = tiles[4].y + dy*params.tile_size.y;
+			int px = tiles[4].x + dx*neighbor_step.x;
+			int py = tiles[4].y + dy*neighbor_step.y;
 			if(px >= image_region.x && py >= image_region.y &&
 			   px <  image_region.z && py <  image_region.w) {
 				int tile_index = center_idx + dy*tile_manager.state.tile_stride + dx;
@@ -752,8 +766,32 @@ bool Session::draw(BufferParams& buffer_params, DeviceDrawParams &draw_params)
 		return draw_cpu(buffer_params, draw_params);
 }
 
+void Session::update_denoising_full_frame(BufferParams& buffer_params)
+{
+	/* Full frame denoising needs all tiles in a single buffer. Background renders
+	 * otherwise allocate buffers per tile, so allocate it here when needed. */
+	bool full_frame = params.background &&
+	                  params.denoising_full_frame &&
+	                  !params.progressive_refine &&
+	                  params.device.type == DEVICE_CPU &&
+	                  tile_manager.schedule_denoising;
+
+	if(full_frame && !buffers) {
+		buffers = new RenderBuffers(device);
+		buffers->reset(buffer_params);
+	}
+	else if(!full_frame && buffers && params.background && !params.write_render_cb) {
+		delete buffers;
+		buffers = NULL;
+	}
+
+	tile_manager.denoise_full_frame = full_frame;
+}
+
 void Session::reset_(BufferParams& buffer_params, int samples)
 {
+	update_denoising_full_frame(buffer_params);
+
 	if(buffers && buffer_params.modified(tile_manager.params)) {
 		gpu_draw_ready = false;
 		buffers->reset(buffer_params);
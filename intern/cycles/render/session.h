@@ -62,6 +62,9 @@ public:
 	float denoising_strength;
 	float denoising_feature_strength;
 	bool denoising_relative_pca;
+	/* Denoise the whole image once all tiles are rendered, instead of tile by tile.
+	 * Only used for background renders on the CPU. */
+	bool denoising_full_frame;
 
 	double cancel_timeout;
 	double reset_timeout;
@@ -93,6 +96,7 @@ public:
 		denoising_strength = 0.0f;
 		denoising_feature_strength = 0.0f;
 		denoising_relative_pca = false;
+		denoising_full_frame = false;
 
 		display_buffer_linear = false;
 
@@ -117,6 +121,7 @@ public:
 		&& pixel_size == params.pixel_size
 		&& threads == params.threads
 		&& display_buffer_linear == params.display_buffer_linear
+		&& denoising_full_frame == params.denoising_full_frame
 		&& cancel_timeout == params.cancel_timeout
 		&& reset_timeout == params.reset_timeout
 		&& text_timeout == params.text_timeout
@@ -181,6 +186,7 @@ protected:
 	void tonemap(int sample);
 	void render();
 	void reset_(BufferParams& params, int samples);
+	void update_denoising_full_frame(BufferParams& params);
 
 	void run_cpu();
 	bool draw_cpu(BufferParams& params, DeviceDrawParams& draw_params);
@@ -102,6 +102,7 @@ TileManager::TileManager(bool progressive_, int num_samples_, int2 tile_size_, i
 	preserve_tile_device = preserve_tile_device_;
 	background = background_;
 	schedule_denoising = false;
+	denoise_full_frame = false;
 
 	range_start_sample = 0;
 	range_num_samples = -1;
@@ -149,6 +150,8 @@ void TileManager::reset(BufferParams& params_, int num_samples_)
 	state.buffer = BufferParams();
 	state.sample = range_start_sample - 1;
 	state.num_tiles = 0;
+	state.full_frame_tile = -1;
+	state.num_rendered_tiles = 0;
 	state.num_samples = 0;
 	state.resolution_divider = get_divider(params.width, params.height, start_resolution);
 	state.render_tiles.clear();
@@ -352,7 +355,9 @@ void TileManager::gen_render_tiles()
 {
 	/* Regenerate just the render tiles for progressive render. */
 	foreach(Tile& tile, state.tiles) {
-		state.render_tiles[tile.device].push_back(tile.index);
+		if(tile.index != state.full_frame_tile) {
+			state.render_tiles[tile.device].push_back(tile.index);
+		}
 	}
 }
 
@@ -363,6 +368,14 @@ void TileManager::set_tiles()
 	int image_h = max(1, params.height/resolution);
 
 	state.num_tiles = gen_tiles(!background);
+	state.num_rendered_tiles = 0;
+	state.full_frame_tile = -1;
+
+	if(schedule_denoising && denoise_full_frame && !progressive) {
+		/* Extra tile that isn't rendered, but denoises the whole image once all other tiles are done. */
+		state.full_frame_tile = state.tiles.size();
+		state.tiles.push_back(Tile(state.full_frame_tile, 0, 0, image_w, image_h, 0, Tile::RENDERED));
+	}
 
 	state.buffer.width = image_w;
 	state.buffer.height = image_h;
@@ -425,6 +438,13 @@ bool TileManager::finish_tile(int index, bool &delete_tile)
 				return true;
 			}
 			state.tiles[index].state = Tile::RENDERED;
+			if(state.full_frame_tile != -1) {
+				if(++state.num_rendered_tiles == state.num_tiles) {
+					state.tiles[state.full_frame_tile].state = Tile::DENOISE;
+					state.denoising_tiles[0].push_back(state.full_frame_tile);
+				}
+				return false;
+			}
 			/* For each neighbor and the tile itself, check whether all of its neighbors have been rendered. If yes, it can be denoised. */
 			for(int neighbor = 0; neighbor < 9; neighbor++) {
 				int nindex = get_neighbor_index(index, neighbor);
@@ -437,6 +457,13 @@ bool TileManager::finish_tile(int index, bool &delete_tile)
 		}
 		case Tile::DENOISE:
 		{
+			if(index == state.full_frame_tile) {
+				/* The tiles don't own any buffers, so nothing has to be freed. */
+				foreach(Tile& tile, state.tiles) {
+					tile.state = Tile::DONE;
+				}
+				return true;
+			}
 			state.tiles[index].state = Tile::DENOISED;
 			/* For each neighbor and the tile itself, check whether all of its neighbors have been denoised. If yes, it can be freed. */
 			for(int neighbor = 0; neighbor < 9; neighbor++) {
@@ -83,6 +83,10 @@ public:
 		 * Each list in each vector is for one logical device. */
 		vector<list<int> > render_tiles;
 		vector<list<int> > denoising_tiles;
+
+		/* Index of the extra tile covering the whole image when denoising the full frame, -1 otherwise. */
+		int full_frame_tile;
+		int num_rendered_tiles;
 	} state;
 
 	int num_samples;
@@ -114,6 +118,10 @@ public:
 
 	/* Schedule tiles for denoising after they've been rendered. */
 	bool schedule_denoising;
+
+	/* Denoise the whole image at once after all tiles have been rendered.
+	 * Requires the tiles to share a single buffer. */
+	bool denoise_full_frame;
 protected:
 
 	void set_tiles();
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "util/util_half.h"
+#include "util/util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+TEST(util_half, half_bits_roundtrip)
+{
+	const float values[] = {0.0f, 1.0f, -1.0f, 0.5f, 0.125f, 0.333f, -2.75f, 1024.0f};
+	for(size_t i = 0; i < sizeof(values) / sizeof(*values); i++) {
+		const float f = values[i];
+		EXPECT_NEAR(half_bits_to_float(float_to_half(f)), f, fabsf(f) * 1e-3f);
+	}
+}
+
+TEST(util_half, half_bits_denormal_to_zero)
+{
+	EXPECT_EQ(half_bits_to_float(float_to_half(1e-6f)), 0.0f);
+	EXPECT_EQ(half_bits_to_float(0x0001), 0.0f);
+}
+
+TEST(util_half, half_bits_inf_nan)
+{
+	EXPECT_EQ(half_bits_to_float(0x7C00), FLT_MAX * 2.0f);
+	EXPECT_EQ(half_bits_to_float(0xFC00), -FLT_MAX * 2.0f);
+	EXPECT_TRUE(isnan_safe(half_bits_to_float(0x7E00)));
+	EXPECT_EQ(half_bits_to_float(float_to_half_bits(FLT_MAX * 2.0f)), FLT_MAX * 2.0f);
+	EXPECT_EQ(half_bits_to_float(float_to_half_bits(-FLT_MAX * 2.0f)), -FLT_MAX * 2.0f);
+	EXPECT_TRUE(isnan_safe(half_bits_to_float(float_to_half_bits(__uint_as_float(0x7FC00000)))));
+}
+
+TEST(util_half, half4_bits_to_float3)
+{
+	const float3 f = half4_bits_to_float3(float3_to_half4_bits(make_float3(0.25f, -0.5f, 4.0f)));
+	EXPECT_EQ(f.x, 0.25f);
+	EXPECT_EQ(f.y, -0.5f);
+	EXPECT_EQ(f.z, 4.0f);
+}
+
+/* Compressed against full precision mesh attributes: float_to_half() truncates to
+ * 10 mantissa bits and flushes values below 2^-14 to zero. */
+static void expect_half_attribute_near(const float3 f)
+{
+	const float3 d = half4_bits_to_float3(float3_to_half4_bits(f));
+	for(int i = 0; i < 3; i++) {
+		const float tolerance = max(fabsf(f[i]) * (1.0f / 1024.0f), 1.0f / 16384.0f);
+		EXPECT_NEAR(d[i], f[i], tolerance);
+	}
+}
+
+TEST(util_half, compressed_attributes)
+{
+	/* UVs, including ones tiling far outside of the 0..1 range */
+	for(int y = 0; y <= 64; y++) {
+		for(int x = 0; x <= 64; x++) {
+			expect_half_attribute_near(make_float3(x / 64.0f, y / 64.0f, 0.0f));
+			expect_half_attribute_near(make_float3(x * 0.37f - 8.0f, y * 0.53f + 100.0f, 0.0f));
+		}
+	}
+	/* tangents */
+	for(int i = 0; i < 256; i++) {
+		const float a = i * (M_2PI_F / 256.0f), b = i * (M_PI_F / 97.0f);
+		expect_half_attribute_near(make_float3(cosf(a) * sinf(b), sinf(a) * sinf(b), cosf(b)));
+	}
+	/* colors, including HDR values */
+	for(int i = 0; i <= 1000; i++) {
+		const float v = i * 0.1f;
+		expect_half_attribute_near(make_float3(v, v * v * 0.001f, 1.0f / (1.0f + v)));
+	}
+}
+
+TEST(util_half, octahedral_roundtrip)
+{
+	const float3 normals[] = {make_float3(0.0f, 0.0f, 1.0f),
+	                          make_float3(0.0f, 0.0f, -1.0f),
+	                          make_float3(1.0f, 0.0f, 0.0f),
+	                          make_float3(0.0f, -1.0f, 0.0f),
+	                          normalize(make_float3(1.0f, 2.0f, 3.0f)),
+	                          normalize(make_float3(-0.3f, 0.7f, -0.2f)),
+	                          normalize(make_float3(-1.0f, -1.0f, -1.0f))};
+	for(size_t i = 0; i < sizeof(normals) / sizeof(*normals); i++) {
+		const float3 n = normals[i];
+		const float3 d = octahedral_to_float3(float3_to_octahedral(n));
+		EXPECT_GT(dot(n, d), 0.99999f);
+	}
+}
+
+CCL_NAMESPACE_END
@@ -133,10 +133,61 @@ ccl_device_inline half float_to_half(float f)
 	return (value_bits | sign_bit);
 }
 
+/* Encode for half_bits_to_float(). Unlike float_to_half(), infinity and NaN are
+ * kept instead of clamped, so compressed attributes match the full precision ones. */
+
+ccl_device_inline uint float_to_half_bits(float f)
+{
+	const uint u = __float_as_uint(f);
+
+	if((u & 0x7f800000) == 0x7f800000) {
+		const uint sign_bit = (u & 0x80000000) >> 16;
+		return sign_bit | ((u & 0x007fffff) ? 0x7e00 : 0x7c00);
+	}
+
+	return (uint)float_to_half(f);
+}
+
+/* Three floats packed in two integers, see half4_bits_to_float3(). */
+
+ccl_device_inline uint2 float3_to_half4_bits(float3 f)
+{
+	return make_uint2(float_to_half_bits(f.x) | (float_to_half_bits(f.y) << 16),
+	                  float_to_half_bits(f.z));
+}
+
 #endif
 
 #endif
 
+/* Decode half float from the low 16 bits of an integer, usable on all devices
+ * for compressed attribute storage. Denormals are flushed to zero, matching
+ * float_to_half(), infinity and NaN stay infinity and NaN. */
+
+ccl_device_inline float half_bits_to_float(uint h)
+{
+	const uint exponent = h & 0x7C00;
+	const uint sign = (h & 0x8000) << 16;
+
+	if(exponent == 0) {
+		return __uint_as_float(sign);
+	}
+	else if(exponent == 0x7C00) {
+		return __uint_as_float(sign | 0x7F800000 | ((h & 0x03FF) << 13));
+	}
+
+	return __uint_as_float(sign | ((exponent + 0x1C000) << 13) | ((h & 0x03FF) << 13));
+}
+
+/* Four half floats packed in two integers, last component is ignored. */
+
+ccl_device_inline float3 half4_bits_to_float3(uint2 h)
+{
+	return make_float3(half_bits_to_float(h.x & 0xFFFF),
+	                   half_bits_to_float(h.x >> 16),
+	                   half_bits_to_float(h.y & 0xFFFF));
+}
+
 CCL_NAMESPACE_END
 
 #endif /* __UTIL_HALF_H__ */
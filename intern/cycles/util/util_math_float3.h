@@ -390,6 +390,45 @@ ccl_device_inline float3 ensure_finite3(float3 v)
 	return v;
 }
 
+/* Octahedral encoding of unit vectors into two 16 bit signed normalized
+ * values packed in a single integer, used for compressed normals. */
+
+ccl_device_inline uint float3_to_octahedral(float3 n)
+{
+	const float len = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+	if(len == 0.0f) {
+		return 0;
+	}
+
+	float u = n.x / len;
+	float v = n.y / len;
+	if(n.z < 0.0f) {
+		const float tu = u;
+		u = (1.0f - fabsf(v)) * ((tu >= 0.0f)? 1.0f: -1.0f);
+		v = (1.0f - fabsf(tu)) * ((v >= 0.0f)? 1.0f: -1.0f);
+	}
+
+	const int iu = (int)floorf(clamp(u, -1.0f, 1.0f)*32767.0f + 0.5f);
+	const int iv = (int)floorf(clamp(v, -1.0f, 1.0f)*32767.0f + 0.5f);
+
+	return ((uint)iu & 0xFFFF) | (((uint)iv & 0xFFFF) << 16);
+}
+
+ccl_device_inline float3 octahedral_to_float3(uint oct)
+{
+	/* Sign extend the 16 bit components. */
+	const float u = max((float)(((int)(oct << 16)) >> 16) * (1.0f/32767.0f), -1.0f);
+	const float v = max((float)(((int)oct) >> 16) * (1.0f/32767.0f), -1.0f);
+
+	float3 n = make_float3(u, v, 1.0f - fabsf(u) - fabsf(v));
+	if(n.z < 0.0f) {
+		n.x = (1.0f - fabsf(v)) * ((u >= 0.0f)? 1.0f: -1.0f);
+		n.y = (1.0f - fabsf(u)) * ((v >= 0.0f)? 1.0f: -1.0f);
+	}
+
+	return normalize(n);
+}
+
 CCL_NAMESPACE_END
 
 #endif /* __UTIL_MATH_FLOAT3_H__ */
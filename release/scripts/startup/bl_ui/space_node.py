@@ -422,10 +422,17 @@ class NODE_PT_quality(bpy.types.Panel):
         col.prop(tree, "render_quality", text="Render")
         col.prop(tree, "edit_quality", text="Edit")
         col.prop(tree, "chunk_size")
+        col.prop(tree, "memory_limit")
 
         col = layout.column()
         col.prop(tree, "use_opencl")
         col.prop(tree, "use_groupnode_buffer")
+        col.prop(tree, "use_row_execution")
+        col.prop(tree, "use_result_cache")
+        sub = col.column()
+        sub.active = tree.use_result_cache
+        sub.prop(tree, "cache_size")
+        col.prop(tree, "use_half_buffers")
         col.prop(tree, "use_two_pass")
         col.prop(tree, "use_viewer_border")
 
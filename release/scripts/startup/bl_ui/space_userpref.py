@@ -560,9 +560,9 @@ class USERPREF_PT_system(Panel):
         col.separator()
 
         col.label(text="Sequencer/Clip Editor:")
-        # currently disabled in the code
-        # col.prop(system, "prefetch_frames")
+        col.prop(system, "prefetch_frames")
         col.prop(system, "memory_cache_limit")
+        col.prop(system, "sequencer_disk_cache_limit")
 
         # 3. Column
         column = split.column()
@@ -1013,6 +1013,7 @@ class USERPREF_PT_file(Panel):
         sub.label(text="Sounds:")
         sub.label(text="Temp:")
         sub.label(text="Render Cache:")
+        sub.label(text="Sequencer Cache:")
         sub.label(text="I18n Branches:")
         sub.label(text="Image Editor:")
         sub.label(text="Animation Player:")
@@ -1025,6 +1026,7 @@ class USERPREF_PT_file(Panel):
         sub.prop(paths, "sound_directory", text="")
         sub.prop(paths, "temporary_directory", text="")
         sub.prop(paths, "render_cache_directory", text="")
+        sub.prop(paths, "sequencer_disk_cache_directory", text="")
         sub.prop(paths, "i18n_branches_directory", text="")
         sub.prop(paths, "image_editor", text="")
         subsplit = sub.split(percentage=0.3)
@@ -102,6 +102,7 @@ typedef struct SeqRenderData {
 	float motion_blur_shutter;
 	bool skip_cache;
 	bool is_proxy_render;
+	bool is_prefetch_render;
 	int view_id;
 
 	/* special case for OpenGL render */
@@ -187,10 +188,21 @@ struct SeqEffectHandle {
  * ********************************************************************** */
 
 struct ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int chanshown);
-struct ImBuf *BKE_sequencer_give_ibuf_threaded(const SeqRenderData *context, float cfra, int chanshown);
 struct ImBuf *BKE_sequencer_give_ibuf_direct(const SeqRenderData *context, float cfra, struct Sequence *seq);
 struct ImBuf *BKE_sequencer_give_ibuf_seqbase(const SeqRenderData *context, float cfra, int chan_shown, struct ListBase *seqbasep);
-void BKE_sequencer_give_ibuf_prefetch_request(const SeqRenderData *context, float cfra, int chan_shown);
+bool BKE_sequencer_has_cached_frame(const SeqRenderData *context, float cfra, int chanshown);
+
+/* **********************************************************************
+ * sequencer.c
+ *
+ * prefetching of frames ahead of the playhead from worker threads
+ * ********************************************************************** */
+
+bool BKE_sequencer_prefetch_check_supported(struct Scene *scene);
+int BKE_sequencer_prefetch_generation_get(void);
+bool BKE_sequencer_prefetch_frame(const SeqRenderData *context, float cfra, int chanshown, int generation,
+                                  size_t *r_size);
+void BKE_sequencer_prefetch_stop(void);
 
 /* **********************************************************************
  * sequencer.c
@@ -251,6 +263,7 @@ bool BKE_sequencer_input_have_to_preprocess(const SeqRenderData *context, struct
 
 void BKE_sequencer_proxy_rebuild_context(struct Main *bmain, struct Scene *scene, struct Sequence *seq, struct GSet *file_list, ListBase *queue);
 void BKE_sequencer_proxy_rebuild(struct SeqIndexBuildContext *context, short *stop, short *do_update, float *progress);
+void BKE_sequencer_proxy_rebuild_queue(ListBase *queue, short *stop, short *do_update, float *progress);
 void BKE_sequencer_proxy_rebuild_finish(struct SeqIndexBuildContext *context, bool stop);
 
 void BKE_sequencer_proxy_set(struct Sequence *seq, bool value);
@@ -287,6 +300,12 @@ void BKE_sequencer_preprocessed_cache_put(const SeqRenderData *context, struct S
 void BKE_sequencer_preprocessed_cache_cleanup(void);
 void BKE_sequencer_preprocessed_cache_cleanup_sequence(struct Sequence *seq);
 
+/* Composited frames stored in the user preferences disk cache directory,
+ * key is the hexadecimal hash of everything the frame depends on */
+bool BKE_sequencer_disk_cache_is_enabled(const SeqRenderData *context);
+struct ImBuf *BKE_sequencer_disk_cache_get(const char *key);
+void BKE_sequencer_disk_cache_put(const char *key, struct ImBuf *ibuf);
+
 /* **********************************************************************
  * seqeffects.c
  *
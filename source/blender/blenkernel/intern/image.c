@@ -533,6 +533,7 @@ bool BKE_image_scale(Image *image, int width, int height)
 	if (ibuf) {
 		IMB_scaleImBuf(ibuf, width, height);
 		ibuf->userflags |= IB_BITMAPDIRTY;
+		IMB_generation_bump(ibuf);
 	}
 
 	BKE_image_release_ibuf(image, ibuf, lock);
@@ -2203,6 +2204,18 @@ void BKE_render_result_stamp_data(RenderResult *rr, const char *key, const char
 	BLI_addtail(&stamp_data->custom_fields, field);
 }
 
+struct StampData *BKE_stamp_data_copy(const struct StampData *stamp_data)
+{
+	if (stamp_data == NULL) {
+		return NULL;
+	}
+
+	StampData *stamp_datan = MEM_dupallocN(stamp_data);
+	BLI_duplicatelist(&stamp_datan->custom_fields, &stamp_data->custom_fields);
+
+	return stamp_datan;
+}
+
 void BKE_stamp_data_free(struct StampData *stamp_data)
 {
 	if (stamp_data == NULL) {
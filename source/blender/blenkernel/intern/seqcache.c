@@ -27,6 +27,10 @@
  */
 
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "zlib.h"
 
 #include "BLI_sys_types.h"  /* for intptr_t */
 
@@ -34,12 +38,24 @@
 
 #include "DNA_sequence_types.h"
 #include "DNA_scene_types.h"
+#include "DNA_userdef_types.h"
 
 #include "IMB_moviecache.h"
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
+#include "IMB_colormanagement.h"
 
+#include "BLI_fileops.h"
+#include "BLI_fileops_types.h"
 #include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "atomic_ops.h"
 
 #include "BKE_sequencer.h"
 #include "BKE_scene.h"
@@ -67,6 +83,7 @@ typedef struct SeqPreprocessCache {
 } SeqPreprocessCache;
 
 static struct MovieCache *moviecache = NULL;
+static ThreadMutex moviecache_create_lock = BLI_MUTEX_INITIALIZER;
 static struct SeqPreprocessCache *preprocess_cache = NULL;
 
 static void preprocessed_cache_destruct(void);
@@ -121,16 +138,21 @@ static bool seqcache_hashcmp(const void *a_, const void *b_)
 	        seq_cmp_render_data(&a->context, &b->context));
 }
 
+static void disk_cache_destruct(void);
+
 void BKE_sequencer_cache_destruct(void)
 {
 	if (moviecache)
 		IMB_moviecache_free(moviecache);
 
 	preprocessed_cache_destruct();
+	disk_cache_destruct();
 }
 
 void BKE_sequencer_cache_cleanup(void)
 {
+	BKE_sequencer_prefetch_stop();
+
 	if (moviecache) {
 		IMB_moviecache_free(moviecache);
 		moviecache = IMB_moviecache_create("seqcache", sizeof(SeqCacheKey), seqcache_hashhash, seqcache_hashcmp);
@@ -149,6 +171,8 @@ static bool seqcache_key_check_seq(ImBuf *UNUSED(ibuf), void *userkey, void *use
 
 void BKE_sequencer_cache_cleanup_sequence(Sequence *seq)
 {
+	BKE_sequencer_prefetch_stop();
+
 	if (moviecache)
 		IMB_moviecache_cleanup(moviecache, seqcache_key_check_seq, seq);
 }
@@ -178,7 +202,12 @@ void BKE_sequencer_cache_put(const SeqRenderData *context, Sequence *seq, float
 	}
 
 	if (!moviecache) {
-		moviecache = IMB_moviecache_create("seqcache", sizeof(SeqCacheKey), seqcache_hashhash, seqcache_hashcmp);
+		/* frames can be put from prefetching threads */
+		BLI_mutex_lock(&moviecache_create_lock);
+		if (!moviecache) {
+			moviecache = IMB_moviecache_create("seqcache", sizeof(SeqCacheKey), seqcache_hashhash, seqcache_hashcmp);
+		}
+		BLI_mutex_unlock(&moviecache_create_lock);
 	}
 
 	key.seq = seq;
@@ -219,7 +248,8 @@ ImBuf *BKE_sequencer_preprocessed_cache_get(const SeqRenderData *context, Sequen
 {
 	SeqPreprocessCacheElem *elem;
 
-	if (!preprocess_cache)
+	/* only used for the frame displayed by the main thread */
+	if (!preprocess_cache || context->is_prefetch_render)
 		return NULL;
 
 	if (preprocess_cache->cfra != cfra)
@@ -246,6 +276,9 @@ void BKE_sequencer_preprocessed_cache_put(const SeqRenderData *context, Sequence
 {
 	SeqPreprocessCacheElem *elem;
 
+	if (context->is_prefetch_render)
+		return;
+
 	if (!preprocess_cache) {
 		preprocess_cache = MEM_callocN(sizeof(SeqPreprocessCache), "sequencer preprocessed cache");
 	}
@@ -285,3 +318,336 @@ void BKE_sequencer_preprocessed_cache_cleanup_sequence(Sequence *seq)
 		}
 	}
 }
+
+/* *************************** disk cache *************************** */
+
+/* Every composited frame is one gzip compressed file in U.sequencer_disk_cache_dir, named
+ * after the hash of the strip stack computed by the caller. Files don't depend on the
+ * session, so they are still valid after reopening the project. Files are written by a
+ * background task pool to keep rendering and playback going, reading happens in the
+ * thread asking for the frame, which is a worker thread when frames are prefetched.
+ * Reading a file touches it, when the directory grows past the size limit the least
+ * recently used files are deleted.
+ */
+
+#define DISK_CACHE_EXT ".seqcache"
+#define DISK_CACHE_VERSION 1
+/* frames which are not written yet, more are not queued so memory use stays bounded */
+#define DISK_CACHE_MAX_PENDING_WRITES 8
+/* gzread() and gzwrite() take unsigned int lengths and return int, frames are read and written in chunks */
+#define DISK_CACHE_CHUNK_SIZE (64 * 1024 * 1024)
+/* headers with larger frames are from damaged files */
+#define DISK_CACHE_MAX_FRAME_SIZE 65536
+
+typedef struct DiskCacheHeader {
+	char magic[4];
+	int version;
+	int x, y;
+	int planes;
+	int is_float;
+	char colorspace[64];
+} DiskCacheHeader;
+
+typedef struct DiskCacheWrite {
+	char key[33];
+	ImBuf *ibuf;
+} DiskCacheWrite;
+
+typedef struct DiskCacheFile {
+	const char *path;
+	int64_t mtime;
+	size_t size;
+} DiskCacheFile;
+
+static ThreadMutex disk_cache_lock = BLI_MUTEX_INITIALIZER;
+static TaskPool *disk_cache_write_pool = NULL;
+static int32_t disk_cache_pending_writes = 0;
+/* size of the files in the directory, -1 when the directory wasn't scanned yet */
+static int64_t disk_cache_size = -1;
+
+bool BKE_sequencer_disk_cache_is_enabled(const SeqRenderData *context)
+{
+	return (U.sequencer_disk_cache_dir[0] != '\0' && U.sequencer_disk_cache_size_limit > 0 &&
+	        !context->skip_cache && !context->is_proxy_render);
+}
+
+static size_t disk_cache_limit(void)
+{
+	return (size_t)U.sequencer_disk_cache_size_limit * 1024 * 1024 * 1024;
+}
+
+static void disk_cache_filepath(const char *key, const char *suffix, char filepath[FILE_MAX])
+{
+	char filename[FILE_MAXFILE];
+
+	BLI_snprintf(filename, sizeof(filename), "%s" DISK_CACHE_EXT "%s", key, suffix);
+	BLI_join_dirfile(filepath, FILE_MAX, U.sequencer_disk_cache_dir, filename);
+}
+
+static int disk_cache_file_cmp(const void *a_, const void *b_)
+{
+	const DiskCacheFile *a = a_, *b = b_;
+
+	if (a->mtime < b->mtime) return -1;
+	if (a->mtime > b->mtime) return 1;
+	return 0;
+}
+
+/* Update the size of the directory, deleting least recently used files while it's over the limit.
+ * Called with disk_cache_lock held. */
+static void disk_cache_scan(size_t limit)
+{
+	struct direntry *filelist;
+	DiskCacheFile *files;
+	unsigned int i, totfile, totfile_cache = 0;
+	int64_t size = 0;
+
+	totfile = BLI_filelist_dir_contents(U.sequencer_disk_cache_dir, &filelist);
+	files = MEM_mallocN(sizeof(DiskCacheFile) * max_ii((int)totfile, 1), "sequencer disk cache files");
+
+	for (i = 0; i < totfile; i++) {
+		if (S_ISREG(filelist[i].type) && BLI_testextensie(filelist[i].relname, DISK_CACHE_EXT)) {
+			files[totfile_cache].path = filelist[i].path;
+			files[totfile_cache].mtime = (int64_t)filelist[i].s.st_mtime;
+			files[totfile_cache].size = (size_t)filelist[i].s.st_size;
+			size += files[totfile_cache].size;
+			totfile_cache++;
+		}
+	}
+
+	if (size > (int64_t)limit) {
+		/* leave some room, so not every write has to scan the directory */
+		const int64_t target = (int64_t)(limit - limit / 10);
+
+		qsort(files, totfile_cache, sizeof(DiskCacheFile), disk_cache_file_cmp);
+
+		for (i = 0; i < totfile_cache && size > target; i++) {
+			if (BLI_delete(files[i].path, false, false) == 0) {
+				size -= files[i].size;
+			}
+		}
+	}
+
+	disk_cache_size = size;
+
+	MEM_freeN(files);
+	BLI_filelist_free(filelist, totfile);
+}
+
+static bool disk_cache_gzwrite(gzFile file, const void *data, size_t len)
+{
+	const char *cdata = data;
+
+	while (len > 0) {
+		const unsigned int chunk = (unsigned int)min_zz(len, DISK_CACHE_CHUNK_SIZE);
+
+		if (gzwrite(file, cdata, chunk) != (int)chunk) {
+			return false;
+		}
+		cdata += chunk;
+		len -= chunk;
+	}
+
+	return true;
+}
+
+static bool disk_cache_gzread(gzFile file, void *data, size_t len)
+{
+	char *cdata = data;
+
+	while (len > 0) {
+		const unsigned int chunk = (unsigned int)min_zz(len, DISK_CACHE_CHUNK_SIZE);
+
+		if (gzread(file, cdata, chunk) != (int)chunk) {
+			return false;
+		}
+		cdata += chunk;
+		len -= chunk;
+	}
+
+	return true;
+}
+
+static size_t disk_cache_data_size(int x, int y, bool is_float)
+{
+	return (is_float ? sizeof(float) * 4 : sizeof(unsigned int)) * (size_t)x * (size_t)y;
+}
+
+static bool disk_cache_write_file(const char *filepath, ImBuf *ibuf)
+{
+	DiskCacheHeader header;
+	const char *colorspace;
+	size_t len;
+	void *data;
+	gzFile file;
+	bool ok;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "BSQC", 4);
+	header.version = DISK_CACHE_VERSION;
+	header.x = ibuf->x;
+	header.y = ibuf->y;
+	header.planes = ibuf->planes;
+
+	if (ibuf->rect_float) {
+		header.is_float = true;
+		colorspace = IMB_colormanagement_get_float_colorspace(ibuf);
+		data = ibuf->rect_float;
+	}
+	else {
+		header.is_float = false;
+		colorspace = IMB_colormanagement_get_rect_colorspace(ibuf);
+		data = ibuf->rect;
+	}
+	len = disk_cache_data_size(ibuf->x, ibuf->y, header.is_float);
+	BLI_strncpy(header.colorspace, colorspace, sizeof(header.colorspace));
+
+	/* compression level 1, decompressing has to be faster than rendering the frame again */
+	file = (gzFile)BLI_gzopen(filepath, "wb1");
+	if (file == NULL) {
+		return false;
+	}
+
+	ok = (gzwrite(file, &header, sizeof(header)) == sizeof(header));
+	ok = ok && disk_cache_gzwrite(file, data, len);
+	ok = (gzclose(file) == Z_OK) && ok;
+
+	return ok;
+}
+
+static void disk_cache_write_task(TaskPool * __restrict UNUSED(pool), void *taskdata, int UNUSED(threadid))
+{
+	DiskCacheWrite *write = taskdata;
+	char filepath[FILE_MAX], filepath_temp[FILE_MAX], suffix[32];
+
+	disk_cache_filepath(write->key, "", filepath);
+
+	if (!BLI_exists(filepath)) {
+		/* written under another name first, readers never see incomplete files */
+		BLI_snprintf(suffix, sizeof(suffix), ".%p.tmp", (void *)write);
+		disk_cache_filepath(write->key, suffix, filepath_temp);
+
+		if (disk_cache_write_file(filepath_temp, write->ibuf) && BLI_rename(filepath_temp, filepath) == 0) {
+			const size_t limit = disk_cache_limit();
+
+			BLI_mutex_lock(&disk_cache_lock);
+			if (disk_cache_size == -1) {
+				disk_cache_scan(limit);
+			}
+			else {
+				disk_cache_size += BLI_file_size(filepath);
+				if (disk_cache_size > (int64_t)limit) {
+					disk_cache_scan(limit);
+				}
+			}
+			BLI_mutex_unlock(&disk_cache_lock);
+		}
+		else {
+			BLI_delete(filepath_temp, false, false);
+		}
+	}
+
+	IMB_freeImBuf(write->ibuf);
+	atomic_sub_and_fetch_int32(&disk_cache_pending_writes, 1);
+}
+
+void BKE_sequencer_disk_cache_put(const char *key, ImBuf *ibuf)
+{
+	DiskCacheWrite *write;
+
+	if (ibuf == NULL || (ibuf->rect == NULL && ibuf->rect_float == NULL) ||
+	    (ibuf->rect_float && ibuf->channels != 4) ||
+	    ibuf->x > DISK_CACHE_MAX_FRAME_SIZE || ibuf->y > DISK_CACHE_MAX_FRAME_SIZE)
+	{
+		return;
+	}
+
+	if (atomic_add_and_fetch_int32(&disk_cache_pending_writes, 1) > DISK_CACHE_MAX_PENDING_WRITES) {
+		/* writing can't keep up, the frame will be written when it's rendered again */
+		atomic_sub_and_fetch_int32(&disk_cache_pending_writes, 1);
+		return;
+	}
+
+	BLI_mutex_lock(&disk_cache_lock);
+	if (disk_cache_write_pool == NULL) {
+		BLI_dir_create_recursive(U.sequencer_disk_cache_dir);
+		disk_cache_write_pool = BLI_task_pool_create_background(BLI_task_scheduler_get(), NULL);
+	}
+	BLI_mutex_unlock(&disk_cache_lock);
+
+	write = MEM_callocN(sizeof(DiskCacheWrite), "sequencer disk cache write");
+	BLI_strncpy(write->key, key, sizeof(write->key));
+	write->ibuf = ibuf;
+	IMB_refImBuf(ibuf);
+
+	BLI_task_pool_push(disk_cache_write_pool, disk_cache_write_task, write, true, TASK_PRIORITY_LOW);
+}
+
+ImBuf *BKE_sequencer_disk_cache_get(const char *key)
+{
+	DiskCacheHeader header;
+	char filepath[FILE_MAX];
+	ImBuf *ibuf = NULL;
+	gzFile file;
+	bool ok;
+
+	disk_cache_filepath(key, "", filepath);
+
+	file = (gzFile)BLI_gzopen(filepath, "rb");
+	if (file == NULL) {
+		return NULL;
+	}
+
+	ok = (gzread(file, &header, sizeof(header)) == sizeof(header)) &&
+	     memcmp(header.magic, "BSQC", 4) == 0 && header.version == DISK_CACHE_VERSION &&
+	     header.x > 0 && header.y > 0 &&
+	     header.x <= DISK_CACHE_MAX_FRAME_SIZE && header.y <= DISK_CACHE_MAX_FRAME_SIZE &&
+	     ELEM(header.is_float, false, true) && header.planes > 0 && header.planes <= 32;
+
+	if (ok) {
+		const size_t len = disk_cache_data_size(header.x, header.y, header.is_float);
+
+		ibuf = IMB_allocImBuf(header.x, header.y, header.planes, header.is_float ? IB_rectfloat : IB_rect);
+		if (ibuf) {
+			void *data = header.is_float ? (void *)ibuf->rect_float : (void *)ibuf->rect;
+			ok = disk_cache_gzread(file, data, len);
+		}
+		else {
+			ok = false;
+		}
+	}
+	gzclose(file);
+
+	if (!ok) {
+		/* written by another version or damaged */
+		if (ibuf) {
+			IMB_freeImBuf(ibuf);
+		}
+		BLI_delete(filepath, false, false);
+		return NULL;
+	}
+
+	header.colorspace[sizeof(header.colorspace) - 1] = '\0';
+	if (header.is_float) {
+		IMB_colormanagement_assign_float_colorspace(ibuf, header.colorspace);
+	}
+	else {
+		IMB_colormanagement_assign_rect_colorspace(ibuf, header.colorspace);
+	}
+
+	/* most recently used */
+	BLI_file_touch(filepath);
+
+	return ibuf;
+}
+
+static void disk_cache_destruct(void)
+{
+	if (disk_cache_write_pool) {
+		/* frames rendered in this session are not lost */
+		BLI_task_pool_work_and_wait(disk_cache_write_pool);
+		BLI_task_pool_free(disk_cache_write_pool);
+		disk_cache_write_pool = NULL;
+	}
+	disk_cache_size = -1;
+}
@@ -40,6 +40,8 @@
 #include "BLI_utildefines.h"
 #include "BLI_rect.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "DNA_scene_types.h"
 #include "DNA_sequence_types.h"
@@ -62,6 +64,8 @@
 
 #include "BLF_api.h"
 
+#include "seqeffects_intern.h"
+
 static void slice_get_byte_buffers(
         const SeqRenderData *context, const ImBuf *ibuf1, const ImBuf *ibuf2,
         const ImBuf *ibuf3, const ImBuf *out, int start_line, unsigned char **rect1,
@@ -165,6 +169,30 @@ static ImBuf *prepare_effect_imbufs(const SeqRenderData *context, ImBuf *ibuf1,
 	return out;
 }
 
+/*********************** Effect kernels *************************/
+
+/* the SSE2 kernels are used whenever the compiler targets SSE2,
+ * the scalar ones are their reference (see seqeffects_intern.h) */
+#ifdef __SSE2__
+#  define seq_alphaover_byte   seq_alphaover_byte_sse2
+#  define seq_alphaover_float  seq_alphaover_float_sse2
+#  define seq_alphaunder_byte  seq_alphaunder_byte_sse2
+#  define seq_alphaunder_float seq_alphaunder_float_sse2
+#  define seq_cross_byte       seq_cross_byte_sse2
+#  define seq_cross_float      seq_cross_float_sse2
+#  define seq_gammacross_byte  seq_gammacross_byte_sse2
+#  define seq_gammacross_float seq_gammacross_float_sse2
+#else
+#  define seq_alphaover_byte   seq_alphaover_byte_scalar
+#  define seq_alphaover_float  seq_alphaover_float_scalar
+#  define seq_alphaunder_byte  seq_alphaunder_byte_scalar
+#  define seq_alphaunder_float seq_alphaunder_float_scalar
+#  define seq_cross_byte       seq_cross_byte_scalar
+#  define seq_cross_float      seq_cross_float_scalar
+#  define seq_gammacross_byte  seq_gammacross_byte_scalar
+#  define seq_gammacross_float seq_gammacross_float_scalar
+#endif
+
 /*********************** Alpha Over *************************/
 
 static void init_alpha_over_or_under(Sequence *seq)
@@ -176,138 +204,6 @@ static void init_alpha_over_or_under(Sequence *seq)
 	seq->seq1 = seq2;
 }
 
-static void do_alphaover_effect_byte(
-        float facf0, float facf1, int x, int y,
-        unsigned char *rect1, unsigned char *rect2, unsigned char *out)
-{
-	float fac2, mfac, fac, fac4;
-	int xo;
-	unsigned char *cp1, *cp2, *rt;
-	float tempc[4], rt1[4], rt2[4];
-
-	xo = x;
-	cp1 = rect1;
-	cp2 = rect2;
-	rt = out;
-
-	fac2 = facf0;
-	fac4 = facf1;
-
-	while (y--) {
-		x = xo;
-		while (x--) {
-			/* rt = rt1 over rt2  (alpha from rt1) */
-
-			straight_uchar_to_premul_float(rt1, cp1);
-			straight_uchar_to_premul_float(rt2, cp2);
-
-			fac = fac2;
-			mfac = 1.0f - fac2 * rt1[3];
-
-			if      (fac  <= 0.0f) *((unsigned int *) rt) = *((unsigned int *) cp2);
-			else if (mfac <= 0.0f) *((unsigned int *) rt) = *((unsigned int *) cp1);
-			else {
-				tempc[0] = fac * rt1[0] + mfac * rt2[0];
-				tempc[1] = fac * rt1[1] + mfac * rt2[1];
-				tempc[2] = fac * rt1[2] + mfac * rt2[2];
-				tempc[3] = fac * rt1[3] + mfac * rt2[3];
-
-				premul_float_to_straight_uchar(rt, tempc);
-			}
-			cp1 += 4; cp2 += 4; rt += 4;
-		}
-
-		if (y == 0) break;
-		y--;
-
-		x = xo;
-		while (x--) {
-			straight_uchar_to_premul_float(rt1, cp1);
-			straight_uchar_to_premul_float(rt2, cp2);
-
-			fac = fac4;
-			mfac = 1.0f - (fac4 * rt1[3]);
-
-			if      (fac  <= 0.0f) *((unsigned int *) rt) = *((unsigned int *) cp2);
-			else if (mfac <= 0.0f) *((unsigned int *) rt) = *((unsigned int *) cp1);
-			else {
-				tempc[0] = fac * rt1[0] + mfac * rt2[0];
-				tempc[1] = fac * rt1[1] + mfac * rt2[1];
-				tempc[2] = fac * rt1[2] + mfac * rt2[2];
-				tempc[3] = fac * rt1[3] + mfac * rt2[3];
-
-				premul_float_to_straight_uchar(rt, tempc);
-			}
-			cp1 += 4; cp2 += 4; rt += 4;
-		}
-	}
-}
-
-static void do_alphaover_effect_float(
-        float facf0, float facf1, int x, int y,
-        float *rect1, float *rect2, float *out)
-{
-	float fac2, mfac, fac, fac4;
-	int xo;
-	float *rt1, *rt2, *rt;
-
-	xo = x;
-	rt1 = rect1;
-	rt2 = rect2;
-	rt = out;
-
-	fac2 = facf0;
-	fac4 = facf1;
-
-	while (y--) {
-		x = xo;
-		while (x--) {
-			/* rt = rt1 over rt2  (alpha from rt1) */
-
-			fac = fac2;
-			mfac = 1.0f - (fac2 * rt1[3]);
-
-			if (fac <= 0.0f) {
-				memcpy(rt, rt2, 4 * sizeof(float));
-			}
-			else if (mfac <= 0) {
-				memcpy(rt, rt1, 4 * sizeof(float));
-			}
-			else {
-				rt[0] = fac * rt1[0] + mfac * rt2[0];
-				rt[1] = fac * rt1[1] + mfac * rt2[1];
-				rt[2] = fac * rt1[2] + mfac * rt2[2];
-				rt[3] = fac * rt1[3] + mfac * rt2[3];
-			}
-			rt1 += 4; rt2 += 4; rt += 4;
-		}
-
-		if (y == 0)
-			break;
-		y--;
-
-		x = xo;
-		while (x--) {
-			fac = fac4;
-			mfac = 1.0f - (fac4 * rt1[3]);
-
-			if (fac <= 0.0f) {
-				memcpy(rt, rt2, 4 * sizeof(float));
-			}
-			else if (mfac <= 0.0f) {
-				memcpy(rt, rt1, 4 * sizeof(float));
-			}
-			else {
-				rt[0] = fac * rt1[0] + mfac * rt2[0];
-				rt[1] = fac * rt1[1] + mfac * rt2[1];
-				rt[2] = fac * rt1[2] + mfac * rt2[2];
-				rt[3] = fac * rt1[3] + mfac * rt2[3];
-			}
-			rt1 += 4; rt2 += 4; rt += 4;
-		}
-	}
-}
-
 static void do_alphaover_effect(
         const SeqRenderData *context, Sequence *UNUSED(seq), float UNUSED(cfra), float facf0,
         float facf1, ImBuf *ibuf1, ImBuf *ibuf2, ImBuf *UNUSED(ibuf3),
@@ -318,169 +214,19 @@ static void do_alphaover_effect(
 
 		slice_get_float_buffers(context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-		do_alphaover_effect_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
+		seq_alphaover_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
 	}
 	else {
 		unsigned char *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
 
 		slice_get_byte_buffers(context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-		do_alphaover_effect_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
+		seq_alphaover_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
 	}
 }
 
 /*********************** Alpha Under *************************/
 
-static void do_alphaunder_effect_byte(
-        float facf0, float facf1, int x, int y,
-        unsigned char *rect1, unsigned char *rect2, unsigned char *out)
-{
-	float fac2, fac, fac4;
-	int xo;
-	unsigned char *cp1, *cp2, *rt;
-	float tempc[4], rt1[4], rt2[4];
-
-	xo = x;
-	cp1 = rect1;
-	cp2 = rect2;
-	rt = out;
-
-	fac2 = facf0;
-	fac4 = facf1;
-
-	while (y--) {
-		x = xo;
-		while (x--) {
-			/* rt = rt1 under rt2  (alpha from rt2) */
-			straight_uchar_to_premul_float(rt1, cp1);
-			straight_uchar_to_premul_float(rt2, cp2);
-
-			/* this complex optimization is because the
-			 * 'skybuf' can be crossed in
-			 */
-			if      (rt2[3] <= 0.0f && fac2 >= 1.0f) *((unsigned int *) rt) = *((unsigned int *) cp1);
-			else if (rt2[3] >= 1.0f)                 *((unsigned int *) rt) = *((unsigned int *) cp2);
-			else {
-				fac = (fac2 * (1.0f - rt2[3]));
-
-				if (fac <= 0) *((unsigned int *) rt) = *((unsigned int *) cp2);
-				else {
-					tempc[0] = (fac * rt1[0] + rt2[0]);
-					tempc[1] = (fac * rt1[1] + rt2[1]);
-					tempc[2] = (fac * rt1[2] + rt2[2]);
-					tempc[3] = (fac * rt1[3] + rt2[3]);
-					
-					premul_float_to_straight_uchar(rt, tempc);
-				}
-			}
-			cp1 += 4; cp2 += 4; rt += 4;
-		}
-
-		if (y == 0)
-			break;
-		y--;
-
-		x = xo;
-		while (x--) {
-			straight_uchar_to_premul_float(rt1, cp1);
-			straight_uchar_to_premul_float(rt2, cp2);
-			
-			if      (rt2[3] <= 0.0f && fac4 >= 1.0f) *((unsigned int *) rt) = *((unsigned int *) cp1);
-			else if (rt2[3] >= 1.0f)                 *((unsigned int *) rt) = *((unsigned int *) cp2);
-			else {				
-				fac = (fac4 * (1.0f - rt2[3]));
-
-				if (fac <= 0) *((unsigned int *)rt) = *((unsigned int *)cp2);
-				else {
-					tempc[0] = (fac * rt1[0] + rt2[0]);
-					tempc[1] = (fac * rt1[1] + rt2[1]);
-					tempc[2] = (fac * rt1[2] + rt2[2]);
-					tempc[3] = (fac * rt1[3] + rt2[3]);
-					
-					premul_float_to_straight_uchar(rt, tempc);
-				}
-			}
-			cp1 += 4; cp2 += 4; rt += 4;
-		}
-	}
-}
-
-static void do_alphaunder_effect_float(
-        float facf0, float facf1, int x, int y,
-        float *rect1, float *rect2, float *out)
-{
-	float fac2, fac, fac4;
-	int xo;
-	float *rt1, *rt2, *rt;
-
-	xo = x;
-	rt1 = rect1;
-	rt2 = rect2;
-	rt = out;
-
-	fac2 = facf0;
-	fac4 = facf1;
-
-	while (y--) {
-		x = xo;
-		while (x--) {
-			/* rt = rt1 under rt2  (alpha from rt2) */
-
-			/* this complex optimization is because the
-			 * 'skybuf' can be crossed in
-			 */
-			if (rt2[3] <= 0 && fac2 >= 1.0f) {
-				memcpy(rt, rt1, 4 * sizeof(float));
-			}
-			else if (rt2[3] >= 1.0f) {
-				memcpy(rt, rt2, 4 * sizeof(float));
-			}
-			else {
-				fac = fac2 * (1.0f - rt2[3]);
-
-				if (fac == 0) {
-					memcpy(rt, rt2, 4 * sizeof(float));
-				}
-				else {
-					rt[0] = fac * rt1[0] + rt2[0];
-					rt[1] = fac * rt1[1] + rt2[1];
-					rt[2] = fac * rt1[2] + rt2[2];
-					rt[3] = fac * rt1[3] + rt2[3];
-				}
-			}
-			rt1 += 4; rt2 += 4; rt += 4;
-		}
-
-		if (y == 0)
-			break;
-		y--;
-
-		x = xo;
-		while (x--) {
-			if (rt2[3] <= 0 && fac4 >= 1.0f) {
-				memcpy(rt, rt1, 4 * sizeof(float));
-			}
-			else if (rt2[3] >= 1.0f) {
-				memcpy(rt, rt2, 4 * sizeof(float));
-			}
-			else {
-				fac = fac4 * (1.0f - rt2[3]);
-
-				if (fac == 0) {
-					memcpy(rt, rt2, 4 * sizeof(float));
-				}
-				else {
-					rt[0] = fac * rt1[0] + rt2[0];
-					rt[1] = fac * rt1[1] + rt2[1];
-					rt[2] = fac * rt1[2] + rt2[2];
-					rt[3] = fac * rt1[3] + rt2[3];
-				}
-			}
-			rt1 += 4; rt2 += 4; rt += 4;
-		}
-	}
-}
-
 static void do_alphaunder_effect(
         const SeqRenderData *context, Sequence *UNUSED(seq), float UNUSED(cfra),
         float facf0, float facf1, ImBuf *ibuf1, ImBuf *ibuf2, ImBuf *UNUSED(ibuf3),
@@ -491,109 +237,19 @@ static void do_alphaunder_effect(
 
 		slice_get_float_buffers(context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-		do_alphaunder_effect_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
+		seq_alphaunder_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
 	}
 	else {
 		unsigned char *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
 
 		slice_get_byte_buffers(context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-		do_alphaunder_effect_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
+		seq_alphaunder_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
 	}
 }
 
 /*********************** Cross *************************/
 
-static void do_cross_effect_byte(
-        float facf0, float facf1, int x, int y,
-        unsigned char *rect1, unsigned char *rect2, unsigned char *out)
-{
-	int fac1, fac2, fac3, fac4;
-	int xo;
-	unsigned char *rt1, *rt2, *rt;
-
-	xo = x;
-	rt1 = rect1;
-	rt2 = rect2;
-	rt = out;
-
-	fac2 = (int) (256.0f * facf0);
-	fac1 = 256 - fac2;
-	fac4 = (int) (256.0f * facf1);
-	fac3 = 256 - fac4;
-
-	while (y--) {
-		x = xo;
-		while (x--) {
-			rt[0] = (fac1 * rt1[0] + fac2 * rt2[0]) >> 8;
-			rt[1] = (fac1 * rt1[1] + fac2 * rt2[1]) >> 8;
-			rt[2] = (fac1 * rt1[2] + fac2 * rt2[2]) >> 8;
-			rt[3] = (fac1 * rt1[3] + fac2 * rt2[3]) >> 8;
-
-			rt1 += 4; rt2 += 4; rt += 4;
-		}
-
-		if (y == 0)
-			break;
-		y--;
-
-		x = xo;
-		while (x--) {
-			rt[0] = (fac3 * rt1[0] + fac4 * rt2[0]) >> 8;
-			rt[1] = (fac3 * rt1[1] + fac4 * rt2[1]) >> 8;
-			rt[2] = (fac3 * rt1[2] + fac4 * rt2[2]) >> 8;
-			rt[3] = (fac3 * rt1[3] + fac4 * rt2[3]) >> 8;
-
-			rt1 += 4; rt2 += 4; rt += 4;
-		}
-
-	}
-}
-
-static void do_cross_effect_float(float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
-{
-	float fac1, fac2, fac3, fac4;
-	int xo;
-	float *rt1, *rt2, *rt;
-
-	xo = x;
-	rt1 = rect1;
-	rt2 = rect2;
-	rt = out;
-
-	fac2 = facf0;
-	fac1 = 1.0f - fac2;
-	fac4 = facf1;
-	fac3 = 1.0f - fac4;
-
-	while (y--) {
-		x = xo;
-		while (x--) {
-			rt[0] = fac1 * rt1[0] + fac2 * rt2[0];
-			rt[1] = fac1 * rt1[1] + fac2 * rt2[1];
-			rt[2] = fac1 * rt1[2] + fac2 * rt2[2];
-			rt[3] = fac1 * rt1[3] + fac2 * rt2[3];
-
-			rt1 += 4; rt2 += 4; rt += 4;
-		}
-
-		if (y == 0)
-			break;
-		y--;
-
-		x = xo;
-		while (x--) {
-			rt[0] = fac3 * rt1[0] + fac4 * rt2[0];
-			rt[1] = fac3 * rt1[1] + fac4 * rt2[1];
-			rt[2] = fac3 * rt1[2] + fac4 * rt2[2];
-			rt[3] = fac3 * rt1[3] + fac4 * rt2[3];
-
-			rt1 += 4; rt2 += 4; rt += 4;
-		}
-
-	}
-}
-
 static void do_cross_effect(
         const SeqRenderData *context, Sequence *UNUSED(seq), float UNUSED(cfra),
         float facf0, float facf1, ImBuf *ibuf1, ImBuf *ibuf2, ImBuf *UNUSED(ibuf3),
@@ -604,145 +260,19 @@ static void do_cross_effect(
 
 		slice_get_float_buffers(context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-		do_cross_effect_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
+		seq_cross_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
 	}
 	else {
 		unsigned char *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
 
 		slice_get_byte_buffers(context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-		do_cross_effect_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
+		seq_cross_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
 	}
 }
 
 /*********************** Gamma Cross *************************/
 
-/* copied code from initrender.c */
-static unsigned short gamtab[65536];
-static unsigned short igamtab1[256];
-static bool gamma_tabs_init = false;
-
-#define RE_GAMMA_TABLE_SIZE 400
-
-static float gamma_range_table[RE_GAMMA_TABLE_SIZE + 1];
-static float gamfactor_table[RE_GAMMA_TABLE_SIZE];
-static float inv_gamma_range_table[RE_GAMMA_TABLE_SIZE + 1];
-static float inv_gamfactor_table[RE_GAMMA_TABLE_SIZE];
-static float color_domain_table[RE_GAMMA_TABLE_SIZE + 1]; 
-static float color_step;
-static float inv_color_step;
-static float valid_gamma;
-static float valid_inv_gamma;
-
-static void makeGammaTables(float gamma)
-{
-	/* we need two tables: one forward, one backward */
-	int i;
-
-	valid_gamma       = gamma;
-	valid_inv_gamma   = 1.0f / gamma;
-	color_step        = 1.0f / RE_GAMMA_TABLE_SIZE;
-	inv_color_step    = (float) RE_GAMMA_TABLE_SIZE; 
-
-	/* We could squeeze out the two range tables to gain some memory */
-	for (i = 0; i < RE_GAMMA_TABLE_SIZE; i++) {
-		color_domain_table[i]    = i * color_step;
-		gamma_range_table[i]     = pow(color_domain_table[i], valid_gamma);
-		inv_gamma_range_table[i] = pow(color_domain_table[i], valid_inv_gamma);
-	}
-
-	/* The end of the table should match 1.0 carefully. In order to avoid
-	 * rounding errors, we just set this explicitly. The last segment may
-	 * have a different length than the other segments, but our
-	 * interpolation is insensitive to that
-	 */
-	color_domain_table[RE_GAMMA_TABLE_SIZE]    = 1.0;
-	gamma_range_table[RE_GAMMA_TABLE_SIZE]     = 1.0;
-	inv_gamma_range_table[RE_GAMMA_TABLE_SIZE] = 1.0;
-
-	/* To speed up calculations, we make these calc factor tables. They are
-	 * multiplication factors used in scaling the interpolation
-	 */
-	for (i = 0; i < RE_GAMMA_TABLE_SIZE; i++) {
-		gamfactor_table[i] = inv_color_step * (gamma_range_table[i + 1] - gamma_range_table[i]);
-		inv_gamfactor_table[i] = inv_color_step * (inv_gamma_range_table[i + 1] - inv_gamma_range_table[i]);
-	}
-
-}
-
-static float gammaCorrect(float c)
-{
-	int i;
-	float res;
-	
-	i = floorf(c * inv_color_step);
-	/* Clip to range [0, 1]: outside, just do the complete calculation.
-	 * We may have some performance problems here. Stretching up the LUT
-	 * may help solve that, by exchanging LUT size for the interpolation.
-	 * Negative colors are explicitly handled.
-	 */
-	if      (UNLIKELY(i < 0))          res = -powf(-c, valid_gamma);
-	else if (i >= RE_GAMMA_TABLE_SIZE) res =  powf(c,  valid_gamma);
-	else                               res =  gamma_range_table[i] +
-	                                          ((c - color_domain_table[i]) * gamfactor_table[i]);
-	
-	return res;
-}
-
-/* ------------------------------------------------------------------------- */
-
-static float invGammaCorrect(float c)
-{
-	int i;
-	float res = 0.0;
-
-	i = floorf(c * inv_color_step);
-	/* Negative colors are explicitly handled */
-	if      (UNLIKELY(i < 0))          res = -powf(-c, valid_inv_gamma);
-	else if (i >= RE_GAMMA_TABLE_SIZE) res =  powf(c,  valid_inv_gamma);
-	else                               res = inv_gamma_range_table[i] +
-	                                         ((c - color_domain_table[i]) * inv_gamfactor_table[i]);
-
-	return res;
-}
-
-static void gamtabs(float gamma)
-{
-	float val, igamma = 1.0f / gamma;
-	int a;
-	
-	/* gamtab: in short, out short */
-	for (a = 0; a < 65536; a++) {
-		val = a;
-		val /= 65535.0f;
-		
-		if (gamma == 2.0f)
-			val = sqrtf(val);
-		else if (gamma != 1.0f)
-			val = powf(val, igamma);
-		
-		gamtab[a] = (65535.99f * val);
-	}
-	/* inverse gamtab1 : in byte, out short */
-	for (a = 1; a <= 256; a++) {
-		if      (gamma == 2.0f) igamtab1[a - 1] = a   * a - 1;
-		else if (gamma == 1.0f) igamtab1[a - 1] = 256 * a - 1;
-		else {
-			val = a / 256.0f;
-			igamtab1[a - 1] = (65535.0 * pow(val, gamma)) - 1;
-		}
-	}
-}
-
-static void build_gammatabs(void)
-{
-	if (gamma_tabs_init == false) {
-		gamtabs(2.0f);
-		makeGammaTables(2.0f);
-		gamma_tabs_init = true;
-	}
-}
-
 static void init_gammacross(Sequence *UNUSED(seq))
 {
 }
@@ -755,102 +285,6 @@ static void free_gammacross(Sequence *UNUSED(seq))
 {
 }
 
-static void do_gammacross_effect_byte(
-        float facf0, float UNUSED(facf1),  int x, int y, unsigned char *rect1,
-        unsigned char *rect2, unsigned char *out)
-{
-	float fac1, fac2;
-	int xo;
-	unsigned char *cp1, *cp2, *rt;
-	float rt1[4], rt2[4], tempc[4];
-
-	xo = x;
-	cp1 = rect1;
-	cp2 = rect2;
-	rt = out;
-
-	fac2 = facf0;
-	fac1 = 1.0f - fac2;
-
-	while (y--) {
-		x = xo;
-		while (x--) {
-			straight_uchar_to_premul_float(rt1, cp1);
-			straight_uchar_to_premul_float(rt2, cp2);
-
-			tempc[0] = gammaCorrect(fac1 * invGammaCorrect(rt1[0]) + fac2 * invGammaCorrect(rt2[0]));
-			tempc[1] = gammaCorrect(fac1 * invGammaCorrect(rt1[1]) + fac2 * invGammaCorrect(rt2[1]));
-			tempc[2] = gammaCorrect(fac1 * invGammaCorrect(rt1[2]) + fac2 * invGammaCorrect(rt2[2]));
-			tempc[3] = gammaCorrect(fac1 * invGammaCorrect(rt1[3]) + fac2 * invGammaCorrect(rt2[3]));
-
-			premul_float_to_straight_uchar(rt, tempc);
-			cp1 += 4; cp2 += 4; rt += 4;
-		}
-
-		if (y == 0)
-			break;
-		y--;
-
-		x = xo;
-		while (x--) {
-			straight_uchar_to_premul_float(rt1, cp1);
-			straight_uchar_to_premul_float(rt2, cp2);
-
-			tempc[0] = gammaCorrect(fac1 * invGammaCorrect(rt1[0]) + fac2 * invGammaCorrect(rt2[0]));
-			tempc[1] = gammaCorrect(fac1 * invGammaCorrect(rt1[1]) + fac2 * invGammaCorrect(rt2[1]));
-			tempc[2] = gammaCorrect(fac1 * invGammaCorrect(rt1[2]) + fac2 * invGammaCorrect(rt2[2]));
-			tempc[3] = gammaCorrect(fac1 * invGammaCorrect(rt1[3]) + fac2 * invGammaCorrect(rt2[3]));
-
-			premul_float_to_straight_uchar(rt, tempc);
-			cp1 += 4; cp2 += 4; rt += 4;
-		}
-	}
-}
-
-static void do_gammacross_effect_float(
-        float facf0, float UNUSED(facf1), int x, int y, float *rect1,
-        float *rect2, float *out)
-{
-	float fac1, fac2;
-	int xo;
-	float *rt1, *rt2, *rt;
-
-	xo = x;
-	rt1 = rect1;
-	rt2 = rect2;
-	rt = out;
-
-	fac2 = facf0;
-	fac1 = 1.0f - fac2;
-
-	while (y--) {
-		x = xo * 4;
-		while (x--) {
-			*rt = gammaCorrect(fac1 * invGammaCorrect(*rt1) + fac2 * invGammaCorrect(*rt2));
-			rt1++; rt2++; rt++;
-		}
-
-		if (y == 0)
-			break;
-		y--;
-
-		x = xo * 4;
-		while (x--) {
-			*rt = gammaCorrect(fac1 * invGammaCorrect(*rt1) + fac2 * invGammaCorrect(*rt2));
-
-			rt1++; rt2++; rt++;
-		}
-	}
-}
-
-static struct ImBuf *gammacross_init_execution(const SeqRenderData *context, ImBuf *ibuf1, ImBuf *ibuf2, ImBuf *ibuf3)
-{
-	ImBuf *out = prepare_effect_imbufs(context, ibuf1, ibuf2, ibuf3);
-	build_gammatabs();
-
-	return out;
-}
-
 static void do_gammacross_effect(
         const SeqRenderData *context, Sequence *UNUSED(seq), float UNUSED(cfra),
         float facf0, float facf1, ImBuf *ibuf1, ImBuf *ibuf2, ImBuf *UNUSED(ibuf3),
@@ -861,14 +295,14 @@ static void do_gammacross_effect(
 
 		slice_get_float_buffers(context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-		do_gammacross_effect_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
+		seq_gammacross_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
 	}
 	else {
 		unsigned char *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
 
 		slice_get_byte_buffers(context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-		do_gammacross_effect_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
+		seq_gammacross_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
 	}
 }
 
@@ -1887,12 +1321,12 @@ static void copy_wipe_effect(Sequence *dst, Sequence *src)
 }
 
 static void do_wipe_effect_byte(
-        Sequence *seq, float facf0, float UNUSED(facf1), int x, int y,
+        Sequence *seq, float facf0, float UNUSED(facf1), int x, int y, int start_line, int total_lines,
         unsigned char *rect1, unsigned char *rect2, unsigned char *out)
 {
 	WipeZone wipezone;
 	WipeVars *wipe = (WipeVars *)seq->effectdata;
-	int xo, yo;
+	int xo;
 	unsigned char *cp1, *cp2, *rt;
 
 	precalc_wipe_zone(&wipezone, wipe, x, y);
@@ -1902,8 +1336,7 @@ static void do_wipe_effect_byte(
 	rt = out;
 
 	xo = x;
-	yo = y;
-	for (y = 0; y < yo; y++) {
+	for (y = start_line; y < start_line + total_lines; y++) {
 		for (x = 0; x < xo; x++) {
 			float check = check_zone(&wipezone, x, y, seq, facf0);
 			if (check) {
@@ -1954,12 +1387,12 @@ static void do_wipe_effect_byte(
 }
 
 static void do_wipe_effect_float(
-        Sequence *seq, float facf0, float UNUSED(facf1), int x, int y,
+        Sequence *seq, float facf0, float UNUSED(facf1), int x, int y, int start_line, int total_lines,
         float *rect1, float *rect2, float *out)
 {
 	WipeZone wipezone;
 	WipeVars *wipe = (WipeVars *)seq->effectdata;
-	int xo, yo;
+	int xo;
 	float *rt1, *rt2, *rt;
 
 	precalc_wipe_zone(&wipezone, wipe, x, y);
@@ -1969,8 +1402,7 @@ static void do_wipe_effect_float(
 	rt = out;
 
 	xo = x;
-	yo = y;
-	for (y = 0; y < yo; y++) {
+	for (y = start_line; y < start_line + total_lines; y++) {
 		for (x = 0; x < xo; x++) {
 			float check = check_zone(&wipezone, x, y, seq, facf0);
 			if (check) {
@@ -2013,24 +1445,29 @@ static void do_wipe_effect_float(
 	}
 }
 
-static ImBuf *do_wipe_effect(
+static void do_wipe_effect(
         const SeqRenderData *context, Sequence *seq, float UNUSED(cfra), float facf0, float facf1,
-        ImBuf *ibuf1, ImBuf *ibuf2, ImBuf *ibuf3)
+        ImBuf *ibuf1, ImBuf *ibuf2, ImBuf *UNUSED(ibuf3),
+        int start_line, int total_lines, ImBuf *out)
 {
-	ImBuf *out = prepare_effect_imbufs(context, ibuf1, ibuf2, ibuf3);
-
 	if (out->rect_float) {
+		float *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
+
+		slice_get_float_buffers(context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
+
 		do_wipe_effect_float(
-		        seq, facf0, facf1, context->rectx, context->recty, ibuf1->rect_float,
-		        ibuf2->rect_float, out->rect_float);
+		        seq, facf0, facf1, context->rectx, context->recty, start_line, total_lines,
+		        rect1, rect2, rect_out);
 	}
 	else {
+		unsigned char *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
+
+		slice_get_byte_buffers(context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
+
 		do_wipe_effect_byte(
-		        seq, facf0, facf1, context->rectx, context->recty, (unsigned char *) ibuf1->rect,
-		        (unsigned char *) ibuf2->rect, (unsigned char *) out->rect);
+		        seq, facf0, facf1, context->rectx, context->recty, start_line, total_lines,
+		        rect1, rect2, rect_out);
 	}
-
-	return out;
 }
 
 /*********************** Transform *************************/
@@ -2076,7 +1513,7 @@ static void copy_transform_effect(Sequence *dst, Sequence *src)
 }
 
 static void transform_image(
-        int x, int y, ImBuf *ibuf1, ImBuf *out,  float scale_x, float scale_y,
+        int x, int y, int start_line, int total_lines, ImBuf *ibuf1, ImBuf *out, float scale_x, float scale_y,
         float translate_x, float translate_y, float rotate, int interpolation)
 {
 	int xo, yo, xi, yi;
@@ -2090,7 +1527,7 @@ static void transform_image(
 	s = sinf(rotate);
 	c = cosf(rotate);
 
-	for (yi = 0; yi < yo; yi++) {
+	for (yi = start_line; yi < start_line + total_lines; yi++) {
 		for (xi = 0; xi < xo; xi++) {
 			/* translate point */
 			xt = xi - translate_x;
@@ -2124,7 +1561,9 @@ static void transform_image(
 	}
 }
 
-static void do_transform(Scene *scene, Sequence *seq, float UNUSED(facf0), int x, int y,  ImBuf *ibuf1, ImBuf *out)
+static void do_transform(
+        Scene *scene, Sequence *seq, float UNUSED(facf0), int x, int y, int start_line, int total_lines,
+        ImBuf *ibuf1, ImBuf *out)
 {
 	TransformVars *transform = (TransformVars *) seq->effectdata;
 	float scale_x, scale_y, translate_x, translate_y, rotate_radians;
@@ -2153,22 +1592,136 @@ static void do_transform(Scene *scene, Sequence *seq, float UNUSED(facf0), int x
 	/* Rotate */
 	rotate_radians = DEG2RADF(transform->rotIni);
 
-	transform_image(x, y, ibuf1, out, scale_x, scale_y, translate_x, translate_y, rotate_radians, transform->interpolation);
+	transform_image(x, y, start_line, total_lines, ibuf1, out, scale_x, scale_y, translate_x, translate_y,
+	                rotate_radians, transform->interpolation);
 }
 
 
-static ImBuf *do_transform_effect(
+static void do_transform_effect(
         const SeqRenderData *context, Sequence *seq, float UNUSED(cfra), float facf0,
-        float UNUSED(facf1), ImBuf *ibuf1, ImBuf *ibuf2, ImBuf *ibuf3)
+        float UNUSED(facf1), ImBuf *ibuf1, ImBuf *UNUSED(ibuf2), ImBuf *UNUSED(ibuf3),
+        int start_line, int total_lines, ImBuf *out)
 {
-	ImBuf *out = prepare_effect_imbufs(context, ibuf1, ibuf2, ibuf3);
+	do_transform(context->scene, seq, facf0, context->rectx, context->recty, start_line, total_lines, ibuf1, out);
+}
 
-	do_transform(context->scene, seq, facf0, context->rectx, context->recty, ibuf1, out);
+/*********************** Glow *************************/
 
-	return out;
+typedef struct GlowThreadData {
+	float *in, *out;
+	int width, height;
+
+	/* isolate highlights */
+	float threshold, boost, clamp;
+
+	/* blur */
+	float *filter;
+	int halfWidth;
+} GlowThreadData;
+
+/* Blur one row of data->in into data->out */
+static void glow_blur_row_cb(void *__restrict userdata, const int y, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	GlowThreadData *data = userdata;
+	float *map = data->in, *temp = data->out, *filter = data->filter;
+	const int width = data->width, halfWidth = data->halfWidth;
+	float curColor[4], curColor2[4];
+	int x, i, fx, index;
+
+	/* Do the left & right strips */
+	for (x = 0; x < halfWidth; x++) {
+		fx = 0;
+		zero_v4(curColor);
+		zero_v4(curColor2);
+
+		for (i = x - halfWidth; i < x + halfWidth; i++) {
+			if ((i >= 0) && (i < width)) {
+				index = (i + y * width) * 4;
+				madd_v4_v4fl(curColor, map + index, filter[fx]);
+
+				index = (width - 1 - i + y * width) * 4;
+				madd_v4_v4fl(curColor2, map + index, filter[fx]);
+			}
+			fx++;
+		}
+		index = (x + y * width) * 4;
+		copy_v4_v4(temp + index, curColor);
+
+		index = (width - 1 - x + y * width) * 4;
+		copy_v4_v4(temp + index, curColor2);
+	}
+
+	/* Do the main body */
+	for (x = halfWidth; x < width - halfWidth; x++) {
+		fx = 0;
+		zero_v4(curColor);
+		for (i = x - halfWidth; i < x + halfWidth; i++) {
+			index = (i + y * width) * 4;
+			madd_v4_v4fl(curColor, map + index, filter[fx]);
+			fx++;
+		}
+		index = (x + y * width) * 4;
+		copy_v4_v4(temp + index, curColor);
+	}
 }
 
-/*********************** Glow *************************/
+/* Blur one column of data->in into data->out */
+static void glow_blur_column_cb(void *__restrict userdata, const int x, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	GlowThreadData *data = userdata;
+	float *map = data->in, *temp = data->out, *filter = data->filter;
+	const int width = data->width, height = data->height, halfWidth = data->halfWidth;
+	float curColor[4], curColor2[4];
+	int y, i, fy, index;
+
+	/* Do the top & bottom strips */
+	for (y = 0; y < halfWidth; y++) {
+		fy = 0;
+		zero_v4(curColor);
+		zero_v4(curColor2);
+		for (i = y - halfWidth; i < y + halfWidth; i++) {
+			if ((i >= 0) && (i < height)) {
+				/* Bottom */
+				index = (x + i * width) * 4;
+				madd_v4_v4fl(curColor, map + index, filter[fy]);
+
+				/* Top */
+				index = (x + (height - 1 - i) * width) * 4;
+				madd_v4_v4fl(curColor2, map + index, filter[fy]);
+			}
+			fy++;
+		}
+		index = (x + y * width) * 4;
+		copy_v4_v4(temp + index, curColor);
+
+		index = (x + (height - 1 - y) * width) * 4;
+		copy_v4_v4(temp + index, curColor2);
+	}
+
+	/* Do the main body */
+	for (y = halfWidth; y < height - halfWidth; y++) {
+		fy = 0;
+		zero_v4(curColor);
+		for (i = y - halfWidth; i < y + halfWidth; i++) {
+			index = (x + i * width) * 4;
+			madd_v4_v4fl(curColor, map + index, filter[fy]);
+			fy++;
+		}
+		index = (x + y * width) * 4;
+		copy_v4_v4(temp + index, curColor);
+	}
+}
+
+static void glow_parallel_range(int stop, GlowThreadData *data, TaskParallelRangeFunc func)
+{
+	ParallelRangeSettings settings;
+
+	BLI_parallel_range_settings_defaults(&settings);
+	/* small images are not worth the threading overhead */
+	settings.use_threading = (data->width * data->height > 64 * 64);
+	settings.min_iter_per_thread = 8;
+	BLI_task_parallel_range(0, stop, data, func, &settings);
+}
 
 static void RVBlurBitmap2_float(float *map, int width, int height, float blur, int quality)
 /*	MUUUCCH better than the previous blur. */
@@ -2180,11 +1733,11 @@ static void RVBlurBitmap2_float(float *map, int width, int height, float blur, i
 /*	a small bitmap.  Avoid avoid avoid. */
 /*=============================== */
 {
-	float *temp = NULL, *swap;
+	GlowThreadData data;
+	float *temp = NULL;
 	float *filter = NULL;
-	int x, y, i, fx, fy;
-	int index, ix, halfWidth;
-	float fval, k, curColor[4], curColor2[4], weight = 0;
+	int ix, halfWidth;
+	float fval, k, weight = 0;
 
 	/* If we're not really blurring, bail out */
 	if (blur <= 0)
@@ -2225,107 +1778,75 @@ static void RVBlurBitmap2_float(float *map, int width, int height, float blur, i
 	for (ix = 0; ix < halfWidth * 2; ix++)
 		filter[ix] /= fval;
 
-	/* Blur the rows */
-	for (y = 0; y < height; y++) {
-		/* Do the left & right strips */
-		for (x = 0; x < halfWidth; x++) {
-			fx = 0;
-			zero_v4(curColor);
-			zero_v4(curColor2);
-
-			for (i = x - halfWidth; i < x + halfWidth; i++) {
-				if ((i >= 0) && (i < width)) {
-					index = (i + y * width) * 4;
-					madd_v4_v4fl(curColor, map + index, filter[fx]);
-
-					index = (width - 1 - i + y * width) * 4;
-					madd_v4_v4fl(curColor2, map + index, filter[fx]);
-				}
-				fx++;
-			}
-			index = (x + y * width) * 4;
-			copy_v4_v4(temp + index, curColor);
+	data.width = width;
+	data.height = height;
+	data.filter = filter;
+	data.halfWidth = halfWidth;
 
-			index = (width - 1 - x + y * width) * 4;
-			copy_v4_v4(temp + index, curColor2);
-		}
+	/* Blur the rows, every row is independent so they are done in parallel */
+	data.in = map;
+	data.out = temp;
+	glow_parallel_range(height, &data, glow_blur_row_cb);
 
-		/* Do the main body */
-		for (x = halfWidth; x < width - halfWidth; x++) {
-			fx = 0;
-			zero_v4(curColor);
-			for (i = x - halfWidth; i < x + halfWidth; i++) {
-				index = (i + y * width) * 4;
-				madd_v4_v4fl(curColor, map + index, filter[fx]);
-				fx++;
-			}
-			index = (x + y * width) * 4;
-			copy_v4_v4(temp + index, curColor);
-		}
-	}
+	/* Blur the columns back into the map */
+	data.in = temp;
+	data.out = map;
+	glow_parallel_range(width, &data, glow_blur_column_cb);
 
-	/* Swap buffers */
-	swap = temp; temp = map; map = swap;
-
-	/* Blur the columns */
-	for (x = 0; x < width; x++) {
-		/* Do the top & bottom strips */
-		for (y = 0; y < halfWidth; y++) {
-			fy = 0;
-			zero_v4(curColor);
-			zero_v4(curColor2);
-			for (i = y - halfWidth; i < y + halfWidth; i++) {
-				if ((i >= 0) && (i < height)) {
-					/* Bottom */
-					index = (x + i * width) * 4;
-					madd_v4_v4fl(curColor, map + index, filter[fy]);
-
-					/* Top */
-					index = (x + (height - 1 - i) * width) * 4;
-					madd_v4_v4fl(curColor2, map + index, filter[fy]);
-				}
-				fy++;
-			}
-			index = (x + y * width) * 4;
-			copy_v4_v4(temp + index, curColor);
+	/* Tidy up	 */
+	MEM_freeN(filter);
+	MEM_freeN(temp);
+}
 
-			index = (x + (height - 1 - y) * width) * 4;
-			copy_v4_v4(temp + index, curColor2);
-		}
-	
-		/* Do the main body */
-		for (y = halfWidth; y < height - halfWidth; y++) {
-			fy = 0;
-			zero_v4(curColor);
-			for (i = y - halfWidth; i < y + halfWidth; i++) {
-				index = (x + i * width) * 4;
-				madd_v4_v4fl(curColor, map + index, filter[fy]);
-				fy++;
-			}
-			index = (x + y * width) * 4;
-			copy_v4_v4(temp + index, curColor);
-		}
+static void glow_add_row_cb(void *__restrict userdata, const int y, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	GlowThreadData *data = userdata;
+	const float *a = data->in + y * data->width * 4;
+	float *c = data->out + y * data->width * 4;
+	int x;
+
+	for (x = 0; x < data->width; x++, a += 4, c += 4) {
+		c[GlowR] = min_ff(1.0f, a[GlowR] + c[GlowR]);
+		c[GlowG] = min_ff(1.0f, a[GlowG] + c[GlowG]);
+		c[GlowB] = min_ff(1.0f, a[GlowB] + c[GlowB]);
+		c[GlowA] = min_ff(1.0f, a[GlowA] + c[GlowA]);
 	}
+}
 
-	/* Swap buffers */
-	swap = temp; temp = map; /* map = swap; */ /* UNUSED */
+/* Adds a to b in place */
+static void RVAddBitmaps_float(float *a, float *b, int width, int height)
+{
+	GlowThreadData data;
 
-	/* Tidy up	 */
-	MEM_freeN(filter);
-	MEM_freeN(temp);
+	data.in = a;
+	data.out = b;
+	data.width = width;
+	data.height = height;
+
+	glow_parallel_range(height, &data, glow_add_row_cb);
 }
 
-static void RVAddBitmaps_float(float *a, float *b, float *c, int width, int height)
+static void glow_isolate_highlights_row_cb(
+        void *__restrict userdata, const int y, const ParallelRangeTLS *__restrict UNUSED(tls))
 {
-	int x, y, index;
+	GlowThreadData *data = userdata;
+	const float *in = data->in + y * data->width * 4;
+	float *out = data->out + y * data->width * 4;
+	const float threshold = data->threshold, boost = data->boost, clamp = data->clamp;
+	float intensity;
+	int x;
 
-	for (y = 0; y < height; y++) {
-		for (x = 0; x < width; x++) {
-			index = (x + y * width) * 4;
-			c[index + GlowR] = min_ff(1.0f, a[index + GlowR] + b[index + GlowR]);
-			c[index + GlowG] = min_ff(1.0f, a[index + GlowG] + b[index + GlowG]);
-			c[index + GlowB] = min_ff(1.0f, a[index + GlowB] + b[index + GlowB]);
-			c[index + GlowA] = min_ff(1.0f, a[index + GlowA] + b[index + GlowA]);
+	for (x = 0; x < data->width; x++, in += 4, out += 4) {
+		/* Isolate the intensity */
+		intensity = (in[GlowR] + in[GlowG] + in[GlowB] - threshold);
+		if (intensity > 0) {
+			out[GlowR] = min_ff(clamp, (in[GlowR] * boost * intensity));
+			out[GlowG] = min_ff(clamp, (in[GlowG] * boost * intensity));
+			out[GlowB] = min_ff(clamp, (in[GlowB] * boost * intensity));
+			out[GlowA] = min_ff(clamp, (in[GlowA] * boost * intensity));
+		}
+		else {
+			zero_v4(out);
 		}
 	}
 }
@@ -2334,29 +1855,17 @@ static void RVIsolateHighlights_float(
         float *in, float *out, int width, int height,
         float threshold, float boost, float clamp)
 {
-	int x, y, index;
-	float intensity;
+	GlowThreadData data;
 
-	for (y = 0; y < height; y++) {
-		for (x = 0; x < width; x++) {
-			index = (x + y * width) * 4;
-
-			/* Isolate the intensity */
-			intensity = (in[index + GlowR] + in[index + GlowG] + in[index + GlowB] - threshold);
-			if (intensity > 0) {
-				out[index + GlowR] = min_ff(clamp, (in[index + GlowR] * boost * intensity));
-				out[index + GlowG] = min_ff(clamp, (in[index + GlowG] * boost * intensity));
-				out[index + GlowB] = min_ff(clamp, (in[index + GlowB] * boost * intensity));
-				out[index + GlowA] = min_ff(clamp, (in[index + GlowA] * boost * intensity));
-			}
-			else {
-				out[index + GlowR] = 0;
-				out[index + GlowG] = 0;
-				out[index + GlowB] = 0;
-				out[index + GlowA] = 0;
-			}
-		}
-	}
+	data.in = in;
+	data.out = out;
+	data.width = width;
+	data.height = height;
+	data.threshold = threshold;
+	data.boost = boost;
+	data.clamp = clamp;
+
+	glow_parallel_range(height, &data, glow_isolate_highlights_row_cb);
 }
 
 static void init_glow_effect(Sequence *seq)
@@ -2411,7 +1920,7 @@ static void do_glow_effect_byte(
 	RVIsolateHighlights_float(inbuf, outbuf, x, y, glow->fMini * 3.0f, glow->fBoost * facf0, glow->fClamp);
 	RVBlurBitmap2_float(outbuf, x, y, glow->dDist * (render_size / 100.0f), glow->dQuality);
 	if (!glow->bNoComp)
-		RVAddBitmaps_float(inbuf, outbuf, outbuf, x, y);
+		RVAddBitmaps_float(inbuf, outbuf, x, y);
 
 	IMB_buffer_float_unpremultiply(outbuf, x, y);
 	IMB_buffer_byte_from_float(out, outbuf, 4, 0.0f, IB_PROFILE_SRGB, IB_PROFILE_SRGB, false, x, y, x, x);
@@ -2431,7 +1940,7 @@ static void do_glow_effect_float(
 	RVIsolateHighlights_float(inbuf, outbuf, x, y, glow->fMini * 3.0f, glow->fBoost * facf0, glow->fClamp);
 	RVBlurBitmap2_float(outbuf, x, y, glow->dDist * (render_size / 100.0f), glow->dQuality);
 	if (!glow->bNoComp)
-		RVAddBitmaps_float(inbuf, outbuf, outbuf, x, y);
+		RVAddBitmaps_float(inbuf, outbuf, x, y);
 }
 
 static ImBuf *do_glow_effect(
@@ -2895,12 +2404,12 @@ static ImBuf *do_speed_effect(
 	ImBuf *out = prepare_effect_imbufs(context, ibuf1, ibuf2, ibuf3);
 
 	if (out->rect_float) {
-		do_cross_effect_float(
+		seq_cross_float(
 		        facf0, facf1, context->rectx, context->recty,
 		        ibuf1->rect_float, ibuf2->rect_float, out->rect_float);
 	}
 	else {
-		do_cross_effect_byte(
+		seq_cross_byte(
 		        facf0, facf1, context->rectx, context->recty,
 		        (unsigned char *) ibuf1->rect, (unsigned char *) ibuf2->rect, (unsigned char *) out->rect);
 	}
@@ -2922,7 +2431,7 @@ static void do_overdrop_effect(
 		slice_get_float_buffers(context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
 		do_drop_effect_float(facf0, facf1, x, y, rect1, rect2, rect_out);
-		do_alphaover_effect_float(facf0, facf1, x, y, rect1, rect2, rect_out);
+		seq_alphaover_float(facf0, facf1, x, y, rect1, rect2, rect_out);
 	}
 	else {
 		unsigned char *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
@@ -2930,7 +2439,7 @@ static void do_overdrop_effect(
 		slice_get_byte_buffers(context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
 		do_drop_effect_byte(facf0, facf1, x, y, rect1, rect2, rect_out);
-		do_alphaover_effect_byte(facf0, facf1, x, y, rect1, rect2, rect_out);
+		seq_alphaover_byte(facf0, facf1, x, y, rect1, rect2, rect_out);
 	}
 }
 
@@ -3490,6 +2999,9 @@ static ImBuf *do_text_effect(
 		proxy_size_comp = context->preview_render_size / 100.0f;
 	}
 
+	/* the render font is shared, frames can be rendered from prefetching threads */
+	BLI_thread_lock(LOCK_SEQUENCER);
+
 	/* set before return */
 	BLF_size(mono, proxy_size_comp * data->text_size, 72);
 
@@ -3556,6 +3068,8 @@ static ImBuf *do_text_effect(
 
 	BLF_disable(mono, BLF_WORD_WRAP);
 
+	BLI_thread_unlock(LOCK_SEQUENCER);
+
 	return out;
 }
 
@@ -3676,7 +3190,6 @@ static struct SeqEffectHandle get_sequence_effect_impl(int seq_type)
 			rval.free = free_gammacross;
 			rval.early_out = early_out_fade;
 			rval.get_default_fac = get_default_fac_fade;
-			rval.init_execution = gammacross_init_execution;
 			rval.execute_slice = do_gammacross_effect;
 			break;
 		case SEQ_TYPE_ADD:
@@ -3745,7 +3258,8 @@ static struct SeqEffectHandle get_sequence_effect_impl(int seq_type)
 			rval.copy = copy_wipe_effect;
 			rval.early_out = early_out_fade;
 			rval.get_default_fac = get_default_fac_fade;
-			rval.execute = do_wipe_effect;
+			rval.multithreaded = true;
+			rval.execute_slice = do_wipe_effect;
 			break;
 		case SEQ_TYPE_GLOW:
 			rval.init = init_glow_effect;
@@ -3759,7 +3273,8 @@ static struct SeqEffectHandle get_sequence_effect_impl(int seq_type)
 			rval.num_inputs = num_inputs_transform;
 			rval.free = free_transform_effect;
 			rval.copy = copy_transform_effect;
-			rval.execute = do_transform_effect;
+			rval.multithreaded = true;
+			rval.execute_slice = do_transform_effect;
 			break;
 		case SEQ_TYPE_SPEED:
 			rval.init = init_speed_effect;
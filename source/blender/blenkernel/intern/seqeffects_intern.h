@@ -0,0 +1,96 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenkernel/intern/seqeffects_intern.h
+ *  \ingroup bke
+ *
+ * Pixel kernels of the sequencer effects that have an SSE2 version.
+ *
+ * The scalar kernels are always built, they are the reference the SSE2 ones are tested against
+ * (tests/gtests/blenkernel/seqeffects_test.cc). seqeffects.c picks one of them at compile time.
+ *
+ * All kernels take \a x * \a y RGBA pixels, odd lines use \a facf1 as factor (field rendering).
+ */
+
+#ifndef __SEQEFFECTS_INTERN_H__
+#define __SEQEFFECTS_INTERN_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void seq_alphaover_byte_scalar(
+        float facf0, float facf1, int x, int y,
+        const unsigned char *rect1, const unsigned char *rect2, unsigned char *out);
+void seq_alphaover_float_scalar(
+        float facf0, float facf1, int x, int y,
+        const float *rect1, const float *rect2, float *out);
+void seq_alphaunder_byte_scalar(
+        float facf0, float facf1, int x, int y,
+        const unsigned char *rect1, const unsigned char *rect2, unsigned char *out);
+void seq_alphaunder_float_scalar(
+        float facf0, float facf1, int x, int y,
+        const float *rect1, const float *rect2, float *out);
+void seq_cross_byte_scalar(
+        float facf0, float facf1, int x, int y,
+        const unsigned char *rect1, const unsigned char *rect2, unsigned char *out);
+void seq_cross_float_scalar(
+        float facf0, float facf1, int x, int y,
+        const float *rect1, const float *rect2, float *out);
+/* gamma cross uses \a facf0 for all lines */
+void seq_gammacross_byte_scalar(
+        float facf0, float facf1, int x, int y,
+        const unsigned char *rect1, const unsigned char *rect2, unsigned char *out);
+void seq_gammacross_float_scalar(
+        float facf0, float facf1, int x, int y,
+        const float *rect1, const float *rect2, float *out);
+
+#ifdef __SSE2__
+void seq_alphaover_byte_sse2(
+        float facf0, float facf1, int x, int y,
+        const unsigned char *rect1, const unsigned char *rect2, unsigned char *out);
+void seq_alphaover_float_sse2(
+        float facf0, float facf1, int x, int y,
+        const float *rect1, const float *rect2, float *out);
+void seq_alphaunder_byte_sse2(
+        float facf0, float facf1, int x, int y,
+        const unsigned char *rect1, const unsigned char *rect2, unsigned char *out);
+void seq_alphaunder_float_sse2(
+        float facf0, float facf1, int x, int y,
+        const float *rect1, const float *rect2, float *out);
+void seq_cross_byte_sse2(
+        float facf0, float facf1, int x, int y,
+        const unsigned char *rect1, const unsigned char *rect2, unsigned char *out);
+void seq_cross_float_sse2(
+        float facf0, float facf1, int x, int y,
+        const float *rect1, const float *rect2, float *out);
+void seq_gammacross_byte_sse2(
+        float facf0, float facf1, int x, int y,
+        const unsigned char *rect1, const unsigned char *rect2, unsigned char *out);
+void seq_gammacross_float_sse2(
+        float facf0, float facf1, int x, int y,
+        const float *rect1, const float *rect2, float *out);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __SEQEFFECTS_INTERN_H__ */
@@ -0,0 +1,612 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2001-2002 by NaN Holding BV.
+ * All rights reserved.
+ *
+ * Contributor(s):
+ * - Blender Foundation, 2003-2009
+ * - Peter Schlaile <peter [at] schlaile [dot] de> 2005/2006
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenkernel/intern/seqeffects_kernels.c
+ *  \ingroup bke
+ *
+ * Scalar and SSE2 pixel kernels of the alpha over, alpha under, cross and gamma cross effects.
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "BLI_math.h"
+#include "BLI_utildefines.h"
+
+#include "seqeffects_intern.h"  /* own include */
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+/* The cross is done with a gamma of 2.0, which only needs a square root and a square.
+ * Negative colors keep their sign. */
+
+static float gammaCorrect(float c)
+{
+	return c * fabsf(c);
+}
+
+static float invGammaCorrect(float c)
+{
+	return (c < 0.0f) ? -sqrtf(-c) : sqrtf(c);
+}
+
+/*********************** Scalar kernels *************************/
+
+void seq_alphaover_byte_scalar(
+        float facf0, float facf1, int x, int y,
+        const unsigned char *rect1, const unsigned char *rect2, unsigned char *out)
+{
+	const unsigned char *cp1 = rect1, *cp2 = rect2;
+	unsigned char *rt = out;
+	int i, j;
+
+	for (j = 0; j < y; j++) {
+		/* odd lines use the factor of the second field */
+		const float fac = (j & 1) ? facf1 : facf0;
+
+		if (fac <= 0.0f) {
+			memcpy(rt, cp2, 4 * sizeof(unsigned char) * x);
+			cp1 += 4 * x; cp2 += 4 * x; rt += 4 * x;
+			continue;
+		}
+
+		for (i = 0; i < x; i++) {
+			/* rt = rt1 over rt2  (alpha from rt1) */
+			const float mfac = 1.0f - fac * (cp1[3] * (1.0f / 255.0f));
+
+			if (mfac <= 0.0f) {
+				*((unsigned int *) rt) = *((const unsigned int *) cp1);
+			}
+			else {
+				float tempc[4], rt1[4], rt2[4];
+
+				straight_uchar_to_premul_float(rt1, cp1);
+				straight_uchar_to_premul_float(rt2, cp2);
+
+				tempc[0] = fac * rt1[0] + mfac * rt2[0];
+				tempc[1] = fac * rt1[1] + mfac * rt2[1];
+				tempc[2] = fac * rt1[2] + mfac * rt2[2];
+				tempc[3] = fac * rt1[3] + mfac * rt2[3];
+
+				premul_float_to_straight_uchar(rt, tempc);
+			}
+			cp1 += 4; cp2 += 4; rt += 4;
+		}
+	}
+}
+
+void seq_alphaover_float_scalar(
+        float facf0, float facf1, int x, int y,
+        const float *rect1, const float *rect2, float *out)
+{
+	const float *rt1 = rect1, *rt2 = rect2;
+	float *rt = out;
+	int i, j;
+
+	for (j = 0; j < y; j++) {
+		/* odd lines use the factor of the second field */
+		const float fac = (j & 1) ? facf1 : facf0;
+
+		if (fac <= 0.0f) {
+			memcpy(rt, rt2, 4 * sizeof(float) * x);
+			rt1 += 4 * x; rt2 += 4 * x; rt += 4 * x;
+			continue;
+		}
+
+		for (i = 0; i < x; i++) {
+			/* rt = rt1 over rt2  (alpha from rt1) */
+			const float mfac = 1.0f - (fac * rt1[3]);
+
+			if (mfac <= 0.0f) {
+				memcpy(rt, rt1, 4 * sizeof(float));
+			}
+			else {
+				rt[0] = fac * rt1[0] + mfac * rt2[0];
+				rt[1] = fac * rt1[1] + mfac * rt2[1];
+				rt[2] = fac * rt1[2] + mfac * rt2[2];
+				rt[3] = fac * rt1[3] + mfac * rt2[3];
+			}
+			rt1 += 4; rt2 += 4; rt += 4;
+		}
+	}
+}
+
+void seq_alphaunder_byte_scalar(
+        float facf0, float facf1, int x, int y,
+        const unsigned char *rect1, const unsigned char *rect2, unsigned char *out)
+{
+	const unsigned char *cp1 = rect1, *cp2 = rect2;
+	unsigned char *rt = out;
+	int i, j;
+
+	for (j = 0; j < y; j++) {
+		/* odd lines use the factor of the second field */
+		const float fac_line = (j & 1) ? facf1 : facf0;
+
+		for (i = 0; i < x; i++) {
+			/* rt = rt1 under rt2  (alpha from rt2) */
+			const float alpha2 = cp2[3] * (1.0f / 255.0f);
+
+			/* this complex optimization is because the
+			 * 'skybuf' can be crossed in
+			 */
+			if      (alpha2 <= 0.0f && fac_line >= 1.0f) *((unsigned int *) rt) = *((const unsigned int *) cp1);
+			else if (alpha2 >= 1.0f)                     *((unsigned int *) rt) = *((const unsigned int *) cp2);
+			else {
+				const float fac = (fac_line * (1.0f - alpha2));
+
+				if (fac <= 0) {
+					*((unsigned int *) rt) = *((const unsigned int *) cp2);
+				}
+				else {
+					float tempc[4], rt1[4], rt2[4];
+
+					straight_uchar_to_premul_float(rt1, cp1);
+					straight_uchar_to_premul_float(rt2, cp2);
+
+					tempc[0] = (fac * rt1[0] + rt2[0]);
+					tempc[1] = (fac * rt1[1] + rt2[1]);
+					tempc[2] = (fac * rt1[2] + rt2[2]);
+					tempc[3] = (fac * rt1[3] + rt2[3]);
+
+					premul_float_to_straight_uchar(rt, tempc);
+				}
+			}
+			cp1 += 4; cp2 += 4; rt += 4;
+		}
+	}
+}
+
+void seq_alphaunder_float_scalar(
+        float facf0, float facf1, int x, int y,
+        const float *rect1, const float *rect2, float *out)
+{
+	const float *rt1 = rect1, *rt2 = rect2;
+	float *rt = out;
+	int i, j;
+
+	for (j = 0; j < y; j++) {
+		/* odd lines use the factor of the second field */
+		const float fac_line = (j & 1) ? facf1 : facf0;
+
+		for (i = 0; i < x; i++) {
+			/* rt = rt1 under rt2  (alpha from rt2) */
+
+			/* this complex optimization is because the
+			 * 'skybuf' can be crossed in
+			 */
+			if (rt2[3] <= 0 && fac_line >= 1.0f) {
+				memcpy(rt, rt1, 4 * sizeof(float));
+			}
+			else if (rt2[3] >= 1.0f) {
+				memcpy(rt, rt2, 4 * sizeof(float));
+			}
+			else {
+				const float fac = fac_line * (1.0f - rt2[3]);
+
+				if (fac == 0) {
+					memcpy(rt, rt2, 4 * sizeof(float));
+				}
+				else {
+					rt[0] = fac * rt1[0] + rt2[0];
+					rt[1] = fac * rt1[1] + rt2[1];
+					rt[2] = fac * rt1[2] + rt2[2];
+					rt[3] = fac * rt1[3] + rt2[3];
+				}
+			}
+			rt1 += 4; rt2 += 4; rt += 4;
+		}
+	}
+}
+
+void seq_cross_byte_scalar(
+        float facf0, float facf1, int x, int y,
+        const unsigned char *rect1, const unsigned char *rect2, unsigned char *out)
+{
+	const unsigned char *rt1 = rect1, *rt2 = rect2;
+	unsigned char *rt = out;
+	int i, j;
+
+	for (j = 0; j < y; j++) {
+		/* odd lines use the factor of the second field */
+		const int fac2 = (int) (256.0f * ((j & 1) ? facf1 : facf0));
+		const int fac1 = 256 - fac2;
+
+		for (i = 0; i < x; i++) {
+			rt[0] = (fac1 * rt1[0] + fac2 * rt2[0]) >> 8;
+			rt[1] = (fac1 * rt1[1] + fac2 * rt2[1]) >> 8;
+			rt[2] = (fac1 * rt1[2] + fac2 * rt2[2]) >> 8;
+			rt[3] = (fac1 * rt1[3] + fac2 * rt2[3]) >> 8;
+
+			rt1 += 4; rt2 += 4; rt += 4;
+		}
+	}
+}
+
+void seq_cross_float_scalar(
+        float facf0, float facf1, int x, int y,
+        const float *rect1, const float *rect2, float *out)
+{
+	const float *rt1 = rect1, *rt2 = rect2;
+	float *rt = out;
+	int i, j;
+
+	for (j = 0; j < y; j++) {
+		/* odd lines use the factor of the second field */
+		const float fac2 = (j & 1) ? facf1 : facf0;
+		const float fac1 = 1.0f - fac2;
+
+		for (i = 0; i < x; i++) {
+			rt[0] = fac1 * rt1[0] + fac2 * rt2[0];
+			rt[1] = fac1 * rt1[1] + fac2 * rt2[1];
+			rt[2] = fac1 * rt1[2] + fac2 * rt2[2];
+			rt[3] = fac1 * rt1[3] + fac2 * rt2[3];
+
+			rt1 += 4; rt2 += 4; rt += 4;
+		}
+	}
+}
+
+void seq_gammacross_byte_scalar(
+        float facf0, float UNUSED(facf1), int x, int y,
+        const unsigned char *rect1, const unsigned char *rect2, unsigned char *out)
+{
+	const float fac2 = facf0;
+	const float fac1 = 1.0f - fac2;
+	const unsigned char *cp1 = rect1, *cp2 = rect2;
+	unsigned char *rt = out;
+	int i;
+
+	for (i = x * y; i > 0; i--) {
+		float rt1[4], rt2[4], tempc[4];
+
+		straight_uchar_to_premul_float(rt1, cp1);
+		straight_uchar_to_premul_float(rt2, cp2);
+
+		tempc[0] = gammaCorrect(fac1 * invGammaCorrect(rt1[0]) + fac2 * invGammaCorrect(rt2[0]));
+		tempc[1] = gammaCorrect(fac1 * invGammaCorrect(rt1[1]) + fac2 * invGammaCorrect(rt2[1]));
+		tempc[2] = gammaCorrect(fac1 * invGammaCorrect(rt1[2]) + fac2 * invGammaCorrect(rt2[2]));
+		tempc[3] = gammaCorrect(fac1 * invGammaCorrect(rt1[3]) + fac2 * invGammaCorrect(rt2[3]));
+
+		premul_float_to_straight_uchar(rt, tempc);
+
+		cp1 += 4; cp2 += 4; rt += 4;
+	}
+}
+
+void seq_gammacross_float_scalar(
+        float facf0, float UNUSED(facf1), int x, int y,
+        const float *rect1, const float *rect2, float *out)
+{
+	const float fac2 = facf0;
+	const float fac1 = 1.0f - fac2;
+	const float *rt1 = rect1, *rt2 = rect2;
+	float *rt = out;
+	int i;
+
+	for (i = x * y * 4; i > 0; i--) {
+		*rt = gammaCorrect(fac1 * invGammaCorrect(*rt1) + fac2 * invGammaCorrect(*rt2));
+		rt1++; rt2++; rt++;
+	}
+}
+
+/*********************** SSE2 kernels *************************/
+
+#ifdef __SSE2__
+
+/* same as straight_uchar_to_premul_float(), for one pixel */
+BLI_INLINE __m128 straight_uchar_to_premul_float_sse2(const unsigned char color[4])
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i c = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(*((const int *)color)), zero), zero);
+	const float alpha = color[3] * (1.0f / 255.0f);
+	const float fac = alpha * (1.0f / 255.0f);
+
+	return _mm_mul_ps(_mm_cvtepi32_ps(c), _mm_set_ps(1.0f / 255.0f, fac, fac, fac));
+}
+
+/* same as premul_float_to_straight_uchar(), for one pixel */
+BLI_INLINE void premul_float_to_straight_uchar_sse2(unsigned char *result, __m128 color)
+{
+	const float alpha = _mm_cvtss_f32(_mm_shuffle_ps(color, color, _MM_SHUFFLE(3, 3, 3, 3)));
+	__m128i c;
+
+	if (alpha != 0.0f && alpha != 1.0f) {
+		const float alpha_inv = 1.0f / alpha;
+		color = _mm_mul_ps(color, _mm_set_ps(1.0f, alpha_inv, alpha_inv, alpha_inv));
+	}
+
+	/* unit_float_to_uchar_clamp() */
+	color = _mm_add_ps(_mm_mul_ps(color, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f));
+	color = _mm_min_ps(_mm_max_ps(color, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+	c = _mm_cvttps_epi32(color);
+	c = _mm_packus_epi16(_mm_packs_epi32(c, c), c);
+	*((int *)result) = _mm_cvtsi128_si32(c);
+}
+
+BLI_INLINE __m128 gammacross_sse2(__m128 fac1, __m128 fac2, __m128 c1, __m128 c2)
+{
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	__m128 result;
+
+	/* invGammaCorrect() */
+	c1 = _mm_or_ps(_mm_sqrt_ps(_mm_andnot_ps(sign, c1)), _mm_and_ps(sign, c1));
+	c2 = _mm_or_ps(_mm_sqrt_ps(_mm_andnot_ps(sign, c2)), _mm_and_ps(sign, c2));
+
+	result = _mm_add_ps(_mm_mul_ps(fac1, c1), _mm_mul_ps(fac2, c2));
+
+	/* gammaCorrect() */
+	return _mm_mul_ps(result, _mm_andnot_ps(sign, result));
+}
+
+void seq_alphaover_byte_sse2(
+        float facf0, float facf1, int x, int y,
+        const unsigned char *rect1, const unsigned char *rect2, unsigned char *out)
+{
+	const unsigned char *cp1 = rect1, *cp2 = rect2;
+	unsigned char *rt = out;
+	int i, j;
+
+	for (j = 0; j < y; j++) {
+		/* odd lines use the factor of the second field */
+		const float fac = (j & 1) ? facf1 : facf0;
+
+		if (fac <= 0.0f) {
+			memcpy(rt, cp2, 4 * sizeof(unsigned char) * x);
+			cp1 += 4 * x; cp2 += 4 * x; rt += 4 * x;
+			continue;
+		}
+
+		for (i = 0; i < x; i++) {
+			/* rt = rt1 over rt2  (alpha from rt1) */
+			const float mfac = 1.0f - fac * (cp1[3] * (1.0f / 255.0f));
+
+			if (mfac <= 0.0f) {
+				*((unsigned int *) rt) = *((const unsigned int *) cp1);
+			}
+			else {
+				const __m128 rt1 = straight_uchar_to_premul_float_sse2(cp1);
+				const __m128 rt2 = straight_uchar_to_premul_float_sse2(cp2);
+
+				premul_float_to_straight_uchar_sse2(
+				        rt, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(fac), rt1), _mm_mul_ps(_mm_set1_ps(mfac), rt2)));
+			}
+			cp1 += 4; cp2 += 4; rt += 4;
+		}
+	}
+}
+
+void seq_alphaover_float_sse2(
+        float facf0, float facf1, int x, int y,
+        const float *rect1, const float *rect2, float *out)
+{
+	const float *rt1 = rect1, *rt2 = rect2;
+	float *rt = out;
+	int i, j;
+
+	for (j = 0; j < y; j++) {
+		/* odd lines use the factor of the second field */
+		const float fac = (j & 1) ? facf1 : facf0;
+
+		if (fac <= 0.0f) {
+			memcpy(rt, rt2, 4 * sizeof(float) * x);
+			rt1 += 4 * x; rt2 += 4 * x; rt += 4 * x;
+			continue;
+		}
+
+		for (i = 0; i < x; i++) {
+			/* rt = rt1 over rt2  (alpha from rt1) */
+			const float mfac = 1.0f - (fac * rt1[3]);
+
+			if (mfac <= 0.0f) {
+				memcpy(rt, rt1, 4 * sizeof(float));
+			}
+			else {
+				_mm_storeu_ps(rt, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(fac), _mm_loadu_ps(rt1)),
+				                             _mm_mul_ps(_mm_set1_ps(mfac), _mm_loadu_ps(rt2))));
+			}
+			rt1 += 4; rt2 += 4; rt += 4;
+		}
+	}
+}
+
+void seq_alphaunder_byte_sse2(
+        float facf0, float facf1, int x, int y,
+        const unsigned char *rect1, const unsigned char *rect2, unsigned char *out)
+{
+	const unsigned char *cp1 = rect1, *cp2 = rect2;
+	unsigned char *rt = out;
+	int i, j;
+
+	for (j = 0; j < y; j++) {
+		/* odd lines use the factor of the second field */
+		const float fac_line = (j & 1) ? facf1 : facf0;
+
+		for (i = 0; i < x; i++) {
+			/* rt = rt1 under rt2  (alpha from rt2) */
+			const float alpha2 = cp2[3] * (1.0f / 255.0f);
+
+			if      (alpha2 <= 0.0f && fac_line >= 1.0f) *((unsigned int *) rt) = *((const unsigned int *) cp1);
+			else if (alpha2 >= 1.0f)                     *((unsigned int *) rt) = *((const unsigned int *) cp2);
+			else {
+				const float fac = (fac_line * (1.0f - alpha2));
+
+				if (fac <= 0) {
+					*((unsigned int *) rt) = *((const unsigned int *) cp2);
+				}
+				else {
+					const __m128 rt1 = straight_uchar_to_premul_float_sse2(cp1);
+					const __m128 rt2 = straight_uchar_to_premul_float_sse2(cp2);
+
+					premul_float_to_straight_uchar_sse2(rt, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(fac), rt1), rt2));
+				}
+			}
+			cp1 += 4; cp2 += 4; rt += 4;
+		}
+	}
+}
+
+void seq_alphaunder_float_sse2(
+        float facf0, float facf1, int x, int y,
+        const float *rect1, const float *rect2, float *out)
+{
+	const float *rt1 = rect1, *rt2 = rect2;
+	float *rt = out;
+	int i, j;
+
+	for (j = 0; j < y; j++) {
+		/* odd lines use the factor of the second field */
+		const float fac_line = (j & 1) ? facf1 : facf0;
+
+		for (i = 0; i < x; i++) {
+			/* rt = rt1 under rt2  (alpha from rt2) */
+			if (rt2[3] <= 0 && fac_line >= 1.0f) {
+				memcpy(rt, rt1, 4 * sizeof(float));
+			}
+			else if (rt2[3] >= 1.0f) {
+				memcpy(rt, rt2, 4 * sizeof(float));
+			}
+			else {
+				const float fac = fac_line * (1.0f - rt2[3]);
+
+				if (fac == 0) {
+					memcpy(rt, rt2, 4 * sizeof(float));
+				}
+				else {
+					_mm_storeu_ps(rt, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(fac), _mm_loadu_ps(rt1)), _mm_loadu_ps(rt2)));
+				}
+			}
+			rt1 += 4; rt2 += 4; rt += 4;
+		}
+	}
+}
+
+void seq_cross_byte_sse2(
+        float facf0, float facf1, int x, int y,
+        const unsigned char *rect1, const unsigned char *rect2, unsigned char *out)
+{
+	const unsigned char *rt1 = rect1, *rt2 = rect2;
+	unsigned char *rt = out;
+	int i, j;
+
+	for (j = 0; j < y; j++) {
+		/* odd lines use the factor of the second field */
+		const int fac2 = (int) (256.0f * ((j & 1) ? facf1 : facf0));
+		const int fac1 = 256 - fac2;
+
+		i = 0;
+		/* four pixels at a time, the weighted sum fits 16 bits while the factors are in [0, 256] */
+		if (fac2 >= 0 && fac2 <= 256) {
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i f1 = _mm_set1_epi16((short)fac1);
+			const __m128i f2 = _mm_set1_epi16((short)fac2);
+
+			for (; i + 4 <= x; i += 4) {
+				const __m128i a = _mm_loadu_si128((const __m128i *)rt1);
+				const __m128i b = _mm_loadu_si128((const __m128i *)rt2);
+				__m128i lo, hi;
+
+				lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), f1),
+				                   _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), f2));
+				hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), f1),
+				                   _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), f2));
+				_mm_storeu_si128((__m128i *)rt, _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+
+				rt1 += 16; rt2 += 16; rt += 16;
+			}
+		}
+
+		/* remaining pixels, and factors out of range */
+		for (; i < x; i++) {
+			rt[0] = (fac1 * rt1[0] + fac2 * rt2[0]) >> 8;
+			rt[1] = (fac1 * rt1[1] + fac2 * rt2[1]) >> 8;
+			rt[2] = (fac1 * rt1[2] + fac2 * rt2[2]) >> 8;
+			rt[3] = (fac1 * rt1[3] + fac2 * rt2[3]) >> 8;
+
+			rt1 += 4; rt2 += 4; rt += 4;
+		}
+	}
+}
+
+void seq_cross_float_sse2(
+        float facf0, float facf1, int x, int y,
+        const float *rect1, const float *rect2, float *out)
+{
+	const float *rt1 = rect1, *rt2 = rect2;
+	float *rt = out;
+	int i, j;
+
+	for (j = 0; j < y; j++) {
+		/* odd lines use the factor of the second field */
+		const float fac2 = (j & 1) ? facf1 : facf0;
+		const __m128 f1 = _mm_set1_ps(1.0f - fac2);
+		const __m128 f2 = _mm_set1_ps(fac2);
+
+		for (i = 0; i < x; i++) {
+			_mm_storeu_ps(rt, _mm_add_ps(_mm_mul_ps(f1, _mm_loadu_ps(rt1)), _mm_mul_ps(f2, _mm_loadu_ps(rt2))));
+			rt1 += 4; rt2 += 4; rt += 4;
+		}
+	}
+}
+
+void seq_gammacross_byte_sse2(
+        float facf0, float UNUSED(facf1), int x, int y,
+        const unsigned char *rect1, const unsigned char *rect2, unsigned char *out)
+{
+	const __m128 f1 = _mm_set1_ps(1.0f - facf0);
+	const __m128 f2 = _mm_set1_ps(facf0);
+	const unsigned char *cp1 = rect1, *cp2 = rect2;
+	unsigned char *rt = out;
+	int i;
+
+	for (i = x * y; i > 0; i--) {
+		premul_float_to_straight_uchar_sse2(
+		        rt, gammacross_sse2(f1, f2, straight_uchar_to_premul_float_sse2(cp1),
+		                            straight_uchar_to_premul_float_sse2(cp2)));
+		cp1 += 4; cp2 += 4; rt += 4;
+	}
+}
+
+void seq_gammacross_float_sse2(
+        float facf0, float UNUSED(facf1), int x, int y,
+        const float *rect1, const float *rect2, float *out)
+{
+	const __m128 f1 = _mm_set1_ps(1.0f - facf0);
+	const __m128 f2 = _mm_set1_ps(facf0);
+	const float *rt1 = rect1, *rt2 = rect2;
+	float *rt = out;
+	int i;
+
+	for (i = x * y; i > 0; i--) {
+		_mm_storeu_ps(rt, gammacross_sse2(f1, f2, _mm_loadu_ps(rt1), _mm_loadu_ps(rt2)));
+		rt1 += 4; rt2 += 4; rt += 4;
+	}
+}
+
+#endif  /* __SSE2__ */
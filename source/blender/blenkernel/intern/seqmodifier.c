@@ -38,6 +38,7 @@
 #include "BLI_string_utils.h"
 #include "BLI_utildefines.h"
 #include "BLI_math.h"
+#include "BLI_threads.h"
 
 #include "BLT_translation.h"
 
@@ -351,6 +352,9 @@ static void curves_apply(struct SequenceModifierData *smd, ImBuf *ibuf, ImBuf *m
 	float black[3] = {0.0f, 0.0f, 0.0f};
 	float white[3] = {1.0f, 1.0f, 1.0f};
 
+	/* the curve mapping is modified temporarily, frames can be rendered from prefetching threads */
+	BLI_thread_lock(LOCK_SEQUENCER);
+
 	curvemapping_initialize(&cmd->curve_mapping);
 
 	curvemapping_premultiply(&cmd->curve_mapping, 0);
@@ -359,6 +363,8 @@ static void curves_apply(struct SequenceModifierData *smd, ImBuf *ibuf, ImBuf *m
 	modifier_apply_threaded(ibuf, mask, curves_apply_threaded, &cmd->curve_mapping);
 
 	curvemapping_premultiply(&cmd->curve_mapping, 1);
+
+	BLI_thread_unlock(LOCK_SEQUENCER);
 }
 
 static SequenceModifierTypeInfo seqModifier_Curves = {
@@ -464,7 +470,9 @@ static void hue_correct_apply(struct SequenceModifierData *smd, ImBuf *ibuf, ImB
 {
 	HueCorrectModifierData *hcmd = (HueCorrectModifierData *) smd;
 
+	BLI_thread_lock(LOCK_SEQUENCER);
 	curvemapping_initialize(&hcmd->curve_mapping);
+	BLI_thread_unlock(LOCK_SEQUENCER);
 
 	modifier_apply_threaded(ibuf, mask, hue_correct_apply_threaded, &hcmd->curve_mapping);
 }
@@ -890,6 +898,8 @@ SequenceModifierData *BKE_sequence_modifier_new(Sequence *seq, const char *name,
 	SequenceModifierData *smd;
 	const SequenceModifierTypeInfo *smti = BKE_sequence_modifier_type_info_get(type);
 
+	BKE_sequencer_prefetch_stop();
+
 	smd = MEM_callocN(smti->struct_size, "sequence modifier");
 
 	smd->type = type;
@@ -915,6 +925,8 @@ bool BKE_sequence_modifier_remove(Sequence *seq, SequenceModifierData *smd)
 	if (BLI_findindex(&seq->modifiers, smd) == -1)
 		return false;
 
+	BKE_sequencer_prefetch_stop();
+
 	BLI_remlink(&seq->modifiers, smd);
 	BKE_sequence_modifier_free(smd);
 
@@ -925,6 +937,8 @@ void BKE_sequence_modifier_clear(Sequence *seq)
 {
 	SequenceModifierData *smd, *smd_next;
 
+	BKE_sequencer_prefetch_stop();
+
 	for (smd = seq->modifiers.first; smd; smd = smd_next) {
 		smd_next = smd->next;
 		BKE_sequence_modifier_free(smd);
@@ -40,12 +40,16 @@
 #include "DNA_movieclip_types.h"
 #include "DNA_mask_types.h"
 #include "DNA_scene_types.h"
+#include "DNA_action_types.h"
 #include "DNA_anim_types.h"
 #include "DNA_object_types.h"
 #include "DNA_sound_types.h"
+#include "DNA_color_types.h"
 
 #include "BLI_math.h"
+#include "BLI_dynstr.h"
 #include "BLI_fileops.h"
+#include "BLI_hash_md5.h"
 #include "BLI_listbase.h"
 #include "BLI_linklist.h"
 #include "BLI_path_util.h"
@@ -54,6 +58,10 @@
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
+#include "PIL_time.h"
+
+#include "atomic_ops.h"
+
 #ifdef WIN32
 #  include "BLI_winstuff.h"
 #else
@@ -79,8 +87,6 @@
 
 #include "RE_pipeline.h"
 
-#include <pthread.h>
-
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
 #include "IMB_colormanagement.h"
@@ -202,6 +208,10 @@ static void seq_free_strip(Strip *strip)
 /* only give option to skip cache locally (static func) */
 static void BKE_sequence_free_ex(Scene *scene, Sequence *seq, const bool do_cache, const bool do_id_user)
 {
+	if (scene) {
+		BKE_sequencer_prefetch_stop();
+	}
+
 	if (seq->strip)
 		seq_free_strip(seq->strip);
 
@@ -603,6 +613,7 @@ void BKE_sequencer_new_render_data(
 	r_context->motion_blur_shutter = 0;
 	r_context->skip_cache = false;
 	r_context->is_proxy_render = false;
+	r_context->is_prefetch_render = false;
 	r_context->view_id = 0;
 	r_context->gpu_offscreen = NULL;
 	r_context->gpu_samples = (scene->r.mode & R_OSA) ? scene->r.osa : 0;
@@ -856,6 +867,8 @@ void BKE_sequence_reload_new_file(Scene *scene, Sequence *seq, const bool lock_r
 	int prev_startdisp = 0, prev_enddisp = 0;
 	/* note: don't rename the strip, will break animation curves */
 
+	BKE_sequencer_prefetch_stop();
+
 	if (ELEM(seq->type,
 	          SEQ_TYPE_MOVIE, SEQ_TYPE_IMAGE, SEQ_TYPE_SOUND_RAM,
 	          SEQ_TYPE_SCENE, SEQ_TYPE_META, SEQ_TYPE_MOVIECLIP, SEQ_TYPE_MASK) == 0)
@@ -1779,23 +1792,28 @@ static ImBuf *seq_proxy_fetch(const SeqRenderData *context, Sequence *seq, int c
 
 	if (proxy->storage & SEQ_STORAGE_PROXY_CUSTOM_FILE) {
 		int frameno = (int)give_stripelem_index(seq, cfra) + seq->anim_startofs;
-		if (proxy->anim == NULL) {
-			if (seq_proxy_get_fname(ed, seq, cfra, render_size, name, context->view_id) == 0) {
-				return NULL;
-			}
+		ImBuf *ibuf = NULL;
+
+		BLI_thread_lock(LOCK_SEQUENCER);
 
-			proxy->anim = openanim(name, IB_rect, 0, seq->strip->colorspace_settings.name);
-		}
 		if (proxy->anim == NULL) {
-			return NULL;
+			if (seq_proxy_get_fname(ed, seq, cfra, render_size, name, context->view_id)) {
+				proxy->anim = openanim(name, IB_rect, 0, seq->strip->colorspace_settings.name);
+			}
 		}
 
-		seq_open_anim_file(context->scene, seq, true);
-		sanim = seq->anims.first;
+		if (proxy->anim) {
+			seq_open_anim_file(context->scene, seq, true);
+			sanim = seq->anims.first;
 
-		frameno = IMB_anim_index_get_frame_index(sanim ? sanim->anim : NULL, seq->strip->proxy->tc, frameno);
+			frameno = IMB_anim_index_get_frame_index(sanim ? sanim->anim : NULL, seq->strip->proxy->tc, frameno);
 
-		return IMB_anim_absolute(proxy->anim, frameno, IMB_TC_NONE, IMB_PROXY_NONE);
+			ibuf = IMB_anim_absolute(proxy->anim, frameno, IMB_TC_NONE, IMB_PROXY_NONE);
+		}
+
+		BLI_thread_unlock(LOCK_SEQUENCER);
+
+		return ibuf;
 	}
 
 	if (seq_proxy_get_fname(ed, seq, cfra, render_size, name, context->view_id) == 0) {
@@ -2065,6 +2083,124 @@ void BKE_sequencer_proxy_rebuild(SeqIndexBuildContext *context, short *stop, sho
 	}
 }
 
+/* Movie strips are decoded and encoded on threads of their own, so a few of them are
+ * built at once with the cores split between them. The other strips render through
+ * the sequencer and are built one after another afterwards. */
+
+/* cores given to every movie built at the same time */
+#define SEQ_PROXY_THREADS_PER_MOVIE 4
+
+typedef struct SeqProxyRebuildQueue {
+	SeqIndexBuildContext **contexts;
+	float *progress;
+	int num_contexts;
+
+	ThreadMutex mutex;
+	int next;
+	int32_t num_threads_done;
+
+	short *stop;
+} SeqProxyRebuildQueue;
+
+static void *seq_proxy_rebuild_thread(void *queue_v)
+{
+	SeqProxyRebuildQueue *queue = queue_v;
+
+	for (;;) {
+		short do_update;
+		int index;
+
+		BLI_mutex_lock(&queue->mutex);
+		index = queue->next++;
+		BLI_mutex_unlock(&queue->mutex);
+
+		if (index >= queue->num_contexts || *queue->stop) {
+			break;
+		}
+
+		BKE_sequencer_proxy_rebuild(queue->contexts[index], queue->stop, &do_update, &queue->progress[index]);
+		queue->progress[index] = 1.0f;
+	}
+
+	atomic_add_and_fetch_int32(&queue->num_threads_done, 1);
+
+	return NULL;
+}
+
+/**
+ * Build all contexts of a queue made by #BKE_sequencer_proxy_rebuild_context.
+ */
+void BKE_sequencer_proxy_rebuild_queue(ListBase *queue, short *stop, short *do_update, float *progress)
+{
+	const int num_contexts = BLI_listbase_count(queue);
+	SeqProxyRebuildQueue movies = {NULL};
+	LinkData *link;
+
+	if (num_contexts == 0) {
+		return;
+	}
+
+	movies.contexts = MEM_mallocN(sizeof(*movies.contexts) * num_contexts, "proxy rebuild movies");
+	movies.progress = MEM_callocN(sizeof(*movies.progress) * num_contexts, "proxy rebuild progress");
+	movies.stop = stop;
+	BLI_mutex_init(&movies.mutex);
+
+	for (link = queue->first; link; link = link->next) {
+		SeqIndexBuildContext *context = link->data;
+
+		if (context->seq->type == SEQ_TYPE_MOVIE && context->index_context) {
+			movies.contexts[movies.num_contexts++] = context;
+		}
+	}
+
+	if (movies.num_contexts) {
+		const int num_system_threads = BLI_system_thread_count();
+		const int num_threads = CLAMPIS(num_system_threads / SEQ_PROXY_THREADS_PER_MOVIE, 1, movies.num_contexts);
+		ListBase threads;
+		int i;
+
+		for (i = 0; i < movies.num_contexts; i++) {
+			IMB_anim_index_rebuild_set_threads(movies.contexts[i]->index_context,
+			                                   max_ii(num_system_threads / num_threads, 1));
+		}
+
+		BLI_threadpool_init(&threads, seq_proxy_rebuild_thread, num_threads);
+		for (i = 0; i < num_threads; i++) {
+			BLI_threadpool_insert(&threads, &movies);
+		}
+
+		while (atomic_add_and_fetch_int32(&movies.num_threads_done, 0) < num_threads) {
+			float total = 0.0f;
+
+			for (i = 0; i < movies.num_contexts; i++) {
+				total += movies.progress[i];
+			}
+
+			*progress = total / num_contexts;
+			*do_update = true;
+
+			PIL_sleep_ms(100);
+		}
+
+		BLI_threadpool_end(&threads);
+	}
+
+	/* these report the progress of each strip, like the job did before */
+	for (link = queue->first; link && !*stop; link = link->next) {
+		SeqIndexBuildContext *context = link->data;
+
+		if (context->seq->type == SEQ_TYPE_MOVIE && context->index_context) {
+			continue;
+		}
+
+		BKE_sequencer_proxy_rebuild(context, stop, do_update, progress);
+	}
+
+	BLI_mutex_end(&movies.mutex);
+	MEM_freeN(movies.contexts);
+	MEM_freeN(movies.progress);
+}
+
 void BKE_sequencer_proxy_rebuild_finish(SeqIndexBuildContext *context, bool stop)
 {
 	if (context->index_context) {
@@ -2830,6 +2966,41 @@ static ImBuf *seq_render_effect_strip_impl(
 	return out;
 }
 
+/* Preview sizes of 50% and 25% read the matching mipmap level of tiled OpenEXR files,
+ * the image is scaled back up in input_preprocess like proxies are. */
+static ImBuf *seq_load_image_preview_size(const SeqRenderData *context, Sequence *seq,
+                                          const char *name, int flag, StripElem *s_elem)
+{
+	ImPartialRead partial = {0};
+	double f = seq_rendersize_to_scale_factor(context->preview_render_size);
+	ImBuf *ibuf;
+
+	if (context->is_proxy_render || !ELEM(f, 0.5, 0.25)) {
+		return NULL;
+	}
+
+	partial.level = (f == 0.5) ? 1 : 2;
+	ibuf = IMB_loadiffname_partial(name, flag, seq->strip->colorspace_settings.name, &partial);
+
+	if (ibuf && partial.level_read != 0 && partial.level_read != partial.level) {
+		/* file has fewer levels, the scale wouldn't match the preview size */
+		IMB_freeImBuf(ibuf);
+		ibuf = NULL;
+	}
+
+	if (ibuf) {
+		if (G.debug & G_DEBUG_IO) {
+			printf("%s: %s level %d, read %zu bytes, skipped %zu bytes\n", __func__, name,
+			       partial.level_read, partial.bytes_read, partial.bytes_skipped);
+		}
+
+		s_elem->orig_width  = partial.width;
+		s_elem->orig_height = partial.height;
+	}
+
+	return ibuf;
+}
+
 static ImBuf *seq_render_image_strip(const SeqRenderData *context, Sequence *seq, float nr, float cfra)
 {
 	ImBuf *ibuf = NULL;
@@ -2926,16 +3097,20 @@ static ImBuf *seq_render_image_strip(const SeqRenderData *context, Sequence *seq
 	}
 	else {
 monoview_image:
-		if ((ibuf = IMB_loadiffname(name, flag, seq->strip->colorspace_settings.name))) {
+		ibuf = seq_load_image_preview_size(context, seq, name, flag, s_elem);
+
+		if (ibuf == NULL && (ibuf = IMB_loadiffname(name, flag, seq->strip->colorspace_settings.name))) {
+			s_elem->orig_width  = ibuf->x;
+			s_elem->orig_height = ibuf->y;
+		}
+
+		if (ibuf) {
 			/* we don't need both (speed reasons)! */
 			if (ibuf->rect_float && ibuf->rect)
 				imb_freerectImBuf(ibuf);
 
 			/* all sequencer color is done in SRGB space, linear gives odd crossfades */
 			BKE_sequencer_imbuf_to_sequencer_space(context->scene, ibuf, false);
-
-			s_elem->orig_width  = ibuf->x;
-			s_elem->orig_height = ibuf->y;
 		}
 	}
 
@@ -3517,7 +3692,9 @@ static ImBuf *do_render_strip_uncached(
 			float f_cfra;
 			SpeedControlVars *s = (SpeedControlVars *)seq->effectdata;
 
+			BLI_thread_lock(LOCK_SEQUENCER);
 			BKE_sequence_effect_speed_rebuild_map(context->scene, seq, false);
+			BLI_thread_unlock(LOCK_SEQUENCER);
 
 			/* weeek! */
 			f_cfra = seq->start + s->frameMap[(int)nr];
@@ -3552,14 +3729,19 @@ static ImBuf *do_render_strip_uncached(
 
 		case SEQ_TYPE_MOVIE:
 		{
+			/* movies are decoded sequentially from an anim handle owned by the strip */
+			BLI_thread_lock(LOCK_SEQUENCER);
 			ibuf = seq_render_movie_strip(context, seq, nr, cfra);
+			BLI_thread_unlock(LOCK_SEQUENCER);
 			copy_to_ibuf_still(context, seq, nr, ibuf);
 			break;
 		}
 
 		case SEQ_TYPE_MOVIECLIP:
 		{
+			BLI_thread_lock(LOCK_SEQUENCER);
 			ibuf = seq_render_movieclip_strip(context, seq, nr);
+			BLI_thread_unlock(LOCK_SEQUENCER);
 
 			if (ibuf) {
 				/* duplicate frame so movie cache wouldn't be confused by sequencer's stuff */
@@ -3579,7 +3761,9 @@ static ImBuf *do_render_strip_uncached(
 		case SEQ_TYPE_MASK:
 		{
 			/* ibuf is always new */
+			BLI_thread_lock(LOCK_SEQUENCER);
 			ibuf = seq_render_mask_strip(context, seq, nr);
+			BLI_thread_unlock(LOCK_SEQUENCER);
 
 			copy_to_ibuf_still(context, seq, nr, ibuf);
 			break;
@@ -3626,6 +3810,11 @@ static ImBuf *seq_render_strip(
 					if (ELEM(seq->type, SEQ_TYPE_MOVIE, SEQ_TYPE_MOVIECLIP)) {
 						is_proxy_image = (context->preview_render_size != 100);
 					}
+					else if (seq->type == SEQ_TYPE_IMAGE && !is_proxy_image) {
+						/* reduced mipmap level read by seq_load_image_preview_size */
+						StripElem *s_elem = BKE_sequencer_give_stripelem(seq, cfra);
+						is_proxy_image = (s_elem && ibuf->x < s_elem->orig_width);
+					}
 					BKE_sequencer_preprocessed_cache_put(context, seq, cfra, SEQ_STRIPELEM_IBUF, ibuf);
 				}
 			}
@@ -3865,6 +4054,241 @@ static ImBuf *seq_render_strip_stack(
 	return out;
 }
 
+/* *********************** disk cache keys ******************* */
+
+/* The disk cache outlives the session, so the key of a frame is a hash of the settings of
+ * every strip which could contribute to it and of the files they read, instead of pointers.
+ * Strips depending on data outside of the sequencer are not cached on disk.
+ */
+
+static void seq_disk_cache_hash_data(DynStr *ds, const void *data, size_t len)
+{
+	char md5[16], hex[33];
+
+	BLI_hash_md5_buffer(data, len, md5);
+	BLI_dynstr_append(ds, BLI_hash_md5_to_hexdigest(md5, hex));
+}
+
+static void seq_disk_cache_hash_filepath(DynStr *ds, const char *path)
+{
+	char filepath[FILE_MAX];
+	BLI_stat_t st;
+
+	BLI_strncpy(filepath, path, sizeof(filepath));
+	BLI_path_abs(filepath, BKE_main_blendfile_path_from_global());
+
+	/* edited files get new keys */
+	if (BLI_stat(filepath, &st) == 0) {
+		BLI_dynstr_appendf(ds, "file %s %lld %lld\n", filepath, (long long)st.st_mtime, (long long)st.st_size);
+	}
+	else {
+		BLI_dynstr_appendf(ds, "file %s missing\n", filepath);
+	}
+}
+
+static void seq_disk_cache_hash_file(DynStr *ds, const char *dir, const char *filename)
+{
+	char filepath[FILE_MAX];
+
+	BLI_join_dirfile(filepath, sizeof(filepath), dir, filename);
+	seq_disk_cache_hash_filepath(ds, filepath);
+}
+
+/* the proxy settings and file, proxies are used instead of the source files when they are built */
+static void seq_disk_cache_hash_proxy(DynStr *ds, const SeqRenderData *context, Sequence *seq, float cfra)
+{
+	StripProxy *proxy = seq->strip->proxy;
+	Editing *ed = context->scene->ed;
+	char name[PROXY_MAXFILE];
+	int render_size = context->preview_render_size;
+
+	BLI_dynstr_appendf(ds, "proxy %d %d %d %d %d %s %s %d %s\n", proxy->tc, proxy->quality,
+	                   proxy->build_size_flags, proxy->build_tc_flags, proxy->storage, proxy->dir, proxy->file,
+	                   ed->proxy_storage, ed->proxy_dir);
+
+	/* same as seq_proxy_fetch() */
+	if (render_size == 99) {
+		render_size = 100;
+	}
+
+	if (seq->type == SEQ_TYPE_IMAGE && BKE_sequencer_give_stripelem(seq, cfra) == NULL) {
+		return;
+	}
+
+	if (seq_proxy_get_fname(ed, seq, (int)cfra, render_size, name, context->view_id)) {
+		seq_disk_cache_hash_filepath(ds, name);
+	}
+}
+
+static void seq_disk_cache_hash_curve_mapping(DynStr *ds, const CurveMapping *cumap)
+{
+	int i;
+
+	BLI_dynstr_appendf(ds, "curves %d %g %g %g %g %g %g\n", cumap->flag,
+	                   cumap->black[0], cumap->black[1], cumap->black[2],
+	                   cumap->white[0], cumap->white[1], cumap->white[2]);
+
+	for (i = 0; i < CM_TOT; i++) {
+		const CurveMap *cuma = &cumap->cm[i];
+
+		BLI_dynstr_appendf(ds, "curve %d %d %g %g %g %g\n", cuma->totpoint, cuma->flag,
+		                   cuma->ext_in[0], cuma->ext_in[1], cuma->ext_out[0], cuma->ext_out[1]);
+		if (cuma->curve) {
+			seq_disk_cache_hash_data(ds, cuma->curve, sizeof(CurveMapPoint) * cuma->totpoint);
+		}
+	}
+}
+
+/* flags which only affect drawing and editing of strips, changing them keeps the cached frames */
+#define SEQ_DISK_CACHE_FLAG_IGNORE \
+	(SEQ_ALLSEL | SEQ_OVERLAP | SEQ_LOCK | SEQ_FLAG_DELETE | SEQ_AUDIO_VOLUME_ANIMATED | \
+	 SEQ_AUDIO_PITCH_ANIMATED | SEQ_AUDIO_PAN_ANIMATED | SEQ_AUDIO_DRAW_WAVEFORM)
+
+static bool seq_disk_cache_hash_seqbase(DynStr *ds, const SeqRenderData *context, ListBase *seqbase, float cfra);
+
+/* returns false when the strip can't be cached on disk */
+static bool seq_disk_cache_hash_sequence(DynStr *ds, const SeqRenderData *context, Sequence *seq, float cfra)
+{
+	SequenceModifierData *smd;
+	Strip *strip = seq->strip;
+
+	if (ELEM(seq->type, SEQ_TYPE_SCENE, SEQ_TYPE_MOVIECLIP, SEQ_TYPE_MASK, SEQ_TYPE_SPEED)) {
+		/* scenes, clips and masks are edited outside of the sequencer,
+		 * the frame map of speed effects depends on the animation of other frames */
+		return false;
+	}
+	if (seq->type == SEQ_TYPE_SOUND_RAM) {
+		return true;
+	}
+
+	BLI_dynstr_appendf(ds, "seq %s %d %d %d %d %d %d %d %d %d %d %d %d %d %d %g %g %g %g %g %g %d %d\n",
+	                   seq->name, seq->type, seq->flag & ~SEQ_DISK_CACHE_FLAG_IGNORE, seq->machine, seq->start, seq->len,
+	                   seq->startofs, seq->endofs, seq->startstill, seq->endstill,
+	                   seq->anim_startofs, seq->anim_endofs, seq->streamindex, seq->multicam_source,
+	                   seq->blend_mode, seq->blend_opacity, seq->sat, seq->mul, seq->strobe,
+	                   seq->effect_fader, seq->speed_fader, seq->alpha_mode, seq->views_format);
+
+	if (seq->stereo3d_format) {
+		seq_disk_cache_hash_data(ds, seq->stereo3d_format, sizeof(Stereo3dFormat));
+	}
+	if (seq->effectdata) {
+		seq_disk_cache_hash_data(ds, seq->effectdata, MEM_allocN_len(seq->effectdata));
+	}
+	if (seq->seq1) BLI_dynstr_appendf(ds, "input1 %s\n", seq->seq1->name);
+	if (seq->seq2) BLI_dynstr_appendf(ds, "input2 %s\n", seq->seq2->name);
+	if (seq->seq3) BLI_dynstr_appendf(ds, "input3 %s\n", seq->seq3->name);
+
+	if (strip) {
+		BLI_dynstr_appendf(ds, "strip %s\n", strip->colorspace_settings.name);
+		if (strip->crop) {
+			seq_disk_cache_hash_data(ds, strip->crop, sizeof(StripCrop));
+		}
+		if (strip->transform) {
+			seq_disk_cache_hash_data(ds, strip->transform, sizeof(StripTransform));
+		}
+
+		if (seq->type == SEQ_TYPE_IMAGE) {
+			StripElem *se = BKE_sequencer_give_stripelem(seq, cfra);
+			if (se) {
+				seq_disk_cache_hash_file(ds, strip->dir, se->name);
+			}
+		}
+		else if (seq->type == SEQ_TYPE_MOVIE && strip->stripdata) {
+			seq_disk_cache_hash_file(ds, strip->dir, strip->stripdata->name);
+		}
+
+		if ((seq->flag & SEQ_USE_PROXY) && strip->proxy) {
+			seq_disk_cache_hash_proxy(ds, context, seq, cfra);
+		}
+	}
+
+	for (smd = seq->modifiers.first; smd; smd = smd->next) {
+		const SequenceModifierTypeInfo *smti = BKE_sequence_modifier_type_info_get(smd->type);
+
+		if (smd->mask_id || smti == NULL) {
+			return false;
+		}
+
+		BLI_dynstr_appendf(ds, "modifier %s %d %d %d %d\n", smd->name, smd->type, smd->flag,
+		                   smd->mask_input_type, smd->mask_time);
+
+		if (smd->mask_sequence) {
+			if (!seq_disk_cache_hash_sequence(ds, context, smd->mask_sequence, cfra)) {
+				return false;
+			}
+		}
+
+		if (smd->type == seqModifierType_Curves) {
+			seq_disk_cache_hash_curve_mapping(ds, &((CurvesModifierData *)smd)->curve_mapping);
+		}
+		else if (smd->type == seqModifierType_HueCorrect) {
+			seq_disk_cache_hash_curve_mapping(ds, &((HueCorrectModifierData *)smd)->curve_mapping);
+		}
+		else if (smti->struct_size > sizeof(SequenceModifierData)) {
+			/* the other modifiers only store values */
+			seq_disk_cache_hash_data(ds, smd + 1, smti->struct_size - sizeof(SequenceModifierData));
+		}
+	}
+
+	if (seq->type == SEQ_TYPE_META) {
+		/* same frame as do_render_strip_seqbase() */
+		BLI_dynstr_append(ds, "meta\n");
+		if (!seq_disk_cache_hash_seqbase(ds, context, &seq->seqbase, give_stripelem_index(seq, cfra) + seq->start)) {
+			return false;
+		}
+		BLI_dynstr_append(ds, "meta end\n");
+	}
+
+	return true;
+}
+
+static bool seq_disk_cache_hash_seqbase(DynStr *ds, const SeqRenderData *context, ListBase *seqbase, float cfra)
+{
+	Sequence *seq;
+
+	/* effect inputs and adjustment layers can use strips which aren't shown,
+	 * all strips at the frame are included */
+	for (seq = seqbase->first; seq; seq = seq->next) {
+		if (seq->startdisp <= cfra && seq->enddisp > cfra) {
+			if (!seq_disk_cache_hash_sequence(ds, context, seq, cfra)) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/* r_key is the hexadecimal hash identifying the frame, returns false when the frame can't be cached on disk */
+static bool seq_disk_cache_key(
+        const SeqRenderData *context, ListBase *seqbasep, float cfra, int chanshown, char r_key[33])
+{
+	Scene *scene = context->scene;
+	DynStr *ds = BLI_dynstr_new();
+	bool ok;
+
+	BLI_dynstr_appendf(ds, "frame %g %d %d %d %d %d %d %g %d %d %d %d %g %d %s\n",
+	                   cfra, chanshown, context->rectx, context->recty, context->preview_render_size,
+	                   context->view_id, context->motion_blur_samples, context->motion_blur_shutter,
+	                   scene->r.xsch, scene->r.ysch, scene->r.seq_flag, scene->r.frs_sec, scene->r.frs_sec_base,
+	                   scene->r.views_format, scene->sequencer_colorspace_settings.name);
+
+	ok = seq_disk_cache_hash_seqbase(ds, context, seqbasep, cfra);
+
+	if (ok) {
+		char *str = BLI_dynstr_get_cstring(ds);
+		char md5[16];
+
+		BLI_hash_md5_buffer(str, strlen(str), md5);
+		BLI_hash_md5_to_hexdigest(md5, r_key);
+		MEM_freeN(str);
+	}
+
+	BLI_dynstr_free(ds);
+
+	return ok;
+}
+
 /*
  * returned ImBuf is refed!
  * you have to free after usage!
@@ -3874,6 +4298,10 @@ ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int cha
 {
 	Editing *ed = BKE_sequencer_editing_get(context->scene, false);
 	ListBase *seqbasep;
+	Sequence *seq_arr[MAXSEQ + 1];
+	char disk_cache_key[33];
+	int num_shown;
+	ImBuf *out;
 	
 	if (ed == NULL) return NULL;
 
@@ -3889,7 +4317,35 @@ ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int cha
 	SeqRenderState state;
 	sequencer_state_init(&state);
 
-	return seq_render_strip_stack(context, &state, seqbasep, cfra, chanshown);
+	if (!BKE_sequencer_disk_cache_is_enabled(context)) {
+		return seq_render_strip_stack(context, &state, seqbasep, cfra, chanshown);
+	}
+
+	/* the memory cache comes first, it has the result for the top most strip */
+	num_shown = get_shown_sequences(seqbasep, cfra, chanshown, (Sequence **)&seq_arr);
+	if (num_shown == 0) {
+		return NULL;
+	}
+
+	out = BKE_sequencer_cache_get(context, seq_arr[num_shown - 1], cfra, SEQ_STRIPELEM_IBUF_COMP);
+	if (out) {
+		return out;
+	}
+
+	if (!seq_disk_cache_key(context, seqbasep, cfra, chanshown, disk_cache_key)) {
+		return seq_render_strip_stack(context, &state, seqbasep, cfra, chanshown);
+	}
+
+	out = BKE_sequencer_disk_cache_get(disk_cache_key);
+	if (out) {
+		BKE_sequencer_cache_put(context, seq_arr[num_shown - 1], cfra, SEQ_STRIPELEM_IBUF_COMP, out);
+		return out;
+	}
+
+	out = seq_render_strip_stack(context, &state, seqbasep, cfra, chanshown);
+	BKE_sequencer_disk_cache_put(disk_cache_key, out);
+
+	return out;
 }
 
 ImBuf *BKE_sequencer_give_ibuf_seqbase(const SeqRenderData *context, float cfra, int chanshown, ListBase *seqbasep)
@@ -3909,156 +4365,175 @@ ImBuf *BKE_sequencer_give_ibuf_direct(const SeqRenderData *context, float cfra,
 	return seq_render_strip(context, &state, seq, cfra);
 }
 
-/* *********************** threading api ******************* */
+bool BKE_sequencer_has_cached_frame(const SeqRenderData *context, float cfra, int chanshown)
+{
+	Editing *ed = BKE_sequencer_editing_get(context->scene, false);
+	Sequence *seq_arr[MAXSEQ + 1];
+	ListBase *seqbasep;
+	ImBuf *ibuf;
+	int count;
 
-static ListBase running_threads;
-static ListBase prefetch_wait;
-static ListBase prefetch_done;
+	if (ed == NULL) return false;
 
-static pthread_mutex_t queue_lock          = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t wakeup_lock         = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t wakeup_cond          = PTHREAD_COND_INITIALIZER;
+	if ((chanshown < 0) && !BLI_listbase_is_empty(&ed->metastack)) {
+		int metacount = BLI_listbase_count(&ed->metastack);
+		metacount = max_ii(metacount + chanshown, 0);
+		seqbasep = ((MetaStack *)BLI_findlink(&ed->metastack, metacount))->oldbasep;
+	}
+	else {
+		seqbasep = ed->seqbasep;
+	}
 
-//static pthread_mutex_t prefetch_ready_lock = PTHREAD_MUTEX_INITIALIZER;
-//static pthread_cond_t  prefetch_ready_cond = PTHREAD_COND_INITIALIZER;
+	count = get_shown_sequences(seqbasep, cfra, chanshown, (Sequence **)&seq_arr);
 
-static pthread_mutex_t frame_done_lock     = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t frame_done_cond      = PTHREAD_COND_INITIALIZER;
+	if (count == 0) {
+		/* nothing to render */
+		return true;
+	}
 
-static volatile bool seq_thread_shutdown = true; 
-static volatile int seq_last_given_monoton_cfra = 0;
-static int monoton_cfra = 0;
+	/* the result of the strip stack is always cached for the top most strip */
+	ibuf = BKE_sequencer_cache_get(context, seq_arr[count - 1], cfra, SEQ_STRIPELEM_IBUF_COMP);
 
-typedef struct PrefetchThread {
-	struct PrefetchThread *next, *prev;
-	
-	Scene *scene;
-	struct PrefetchQueueElem *current;
-	pthread_t pthread;
-	int running;
-	
-} PrefetchThread;
+	if (ibuf) {
+		IMB_freeImBuf(ibuf);
+		return true;
+	}
 
-typedef struct PrefetchQueueElem {
-	struct PrefetchQueueElem *next, *prev;
-	
-	int rectx;
-	int recty;
-	float cfra;
-	int chanshown;
-	int preview_render_size;
+	return false;
+}
 
-	int monoton_cfra;
+/* *********************** prefetching api ******************* */
 
-	ImBuf *ibuf;
-} PrefetchQueueElem;
+/* Frames are prefetched by rendering them into the cache from worker threads, while the
+ * main thread keeps drawing and editing. Rendering of a frame happens with the prefetch
+ * lock held for reading, changes to the sequences stop prefetching before they write,
+ * free or invalidate anything: the generation is increased so no new frames are started
+ * and the lock is taken for writing to wait for the frames being rendered.
+ *
+ * Besides the functions here which add, free or reload strips, prefetching is stopped
+ * before operators which push undo run and before interface buttons and Python write RNA
+ * properties.
+ *
+ * Parts of the strip rendering which are not reentrant (movie decoding, proxies, masks,
+ * text and curve evaluation) are protected by LOCK_SEQUENCER.
+ */
+
+static ThreadRWMutex seq_prefetch_lock = BLI_RWLOCK_INITIALIZER;
+static int32_t seq_prefetch_generation = 0;
 
-void BKE_sequencer_give_ibuf_prefetch_request(const SeqRenderData *context, float cfra, int chanshown)
+static bool seq_prefetch_check_animation(AnimData *adt)
 {
-	PrefetchQueueElem *e;
-	if (seq_thread_shutdown) {
-		return;
+	FCurve *fcu;
+
+	if (adt == NULL) {
+		return false;
 	}
 
-	e = MEM_callocN(sizeof(PrefetchQueueElem), "prefetch_queue_elem");
-	e->rectx = context->rectx;
-	e->recty = context->recty;
-	e->cfra = cfra;
-	e->chanshown = chanshown;
-	e->preview_render_size = context->preview_render_size;
-	e->monoton_cfra = monoton_cfra++;
+	/* NLA evaluation is not checked, be conservative */
+	if (adt->nla_tracks.first) {
+		return true;
+	}
 
-	pthread_mutex_lock(&queue_lock);
-	BLI_addtail(&prefetch_wait, e);
-	pthread_mutex_unlock(&queue_lock);
-	
-	pthread_mutex_lock(&wakeup_lock);
-	pthread_cond_signal(&wakeup_cond);
-	pthread_mutex_unlock(&wakeup_lock);
+	if (adt->action) {
+		for (fcu = adt->action->curves.first; fcu; fcu = fcu->next) {
+			if (fcu->rna_path && STRPREFIX(fcu->rna_path, "sequence_editor.")) {
+				return true;
+			}
+		}
+	}
+
+	for (fcu = adt->drivers.first; fcu; fcu = fcu->next) {
+		if (fcu->rna_path && STRPREFIX(fcu->rna_path, "sequence_editor.")) {
+			return true;
+		}
+	}
+
+	return false;
 }
 
-ImBuf *BKE_sequencer_give_ibuf_threaded(const SeqRenderData *context, float cfra, int chanshown)
+/* Only frames which can be rendered without changing the scene can be prefetched:
+ * animation of strips is only evaluated for the current frame and scene strips
+ * evaluate and render a whole scene.
+ */
+bool BKE_sequencer_prefetch_check_supported(Scene *scene)
 {
-	PrefetchQueueElem *e = NULL;
-	bool found_something = false;
+	Editing *ed = BKE_sequencer_editing_get(scene, false);
+	Sequence *seq;
+	bool supported = true;
 
-	if (seq_thread_shutdown) {
-		return BKE_sequencer_give_ibuf(context, cfra, chanshown);
+	if (ed == NULL) {
+		return false;
 	}
 
-	while (!e) {
-		bool success = false;
-		pthread_mutex_lock(&queue_lock);
+	if (seq_prefetch_check_animation(scene->adt)) {
+		return false;
+	}
 
-		for (e = prefetch_done.first; e; e = e->next) {
-			if (cfra == e->cfra &&
-			    chanshown == e->chanshown &&
-			    context->rectx == e->rectx &&
-			    context->recty == e->recty &&
-			    context->preview_render_size == e->preview_render_size)
-			{
-				success = true;
-				found_something = true;
-				break;
-			}
+	SEQ_BEGIN (ed, seq)
+	{
+		if (seq->type == SEQ_TYPE_SCENE && (seq->flag & SEQ_SCENE_STRIPS) == 0) {
+			supported = false;
 		}
+	}
+	SEQ_END
 
-		if (!e) {
-			for (e = prefetch_wait.first; e; e = e->next) {
-				if (cfra == e->cfra &&
-				    chanshown == e->chanshown &&
-				    context->rectx == e->rectx &&
-				    context->recty == e->recty &&
-				    context->preview_render_size == e->preview_render_size)
-				{
-					found_something = true;
-					break;
-				}
-			}
-		}
+	return supported;
+}
 
-		if (!e) {
-			PrefetchThread *tslot;
+int BKE_sequencer_prefetch_generation_get(void)
+{
+	return atomic_add_and_fetch_int32(&seq_prefetch_generation, 0);
+}
 
-			for (tslot = running_threads.first;
-			     tslot;
-			     tslot = tslot->next)
-			{
-				if (tslot->current &&
-				    cfra == tslot->current->cfra &&
-				    chanshown == tslot->current->chanshown &&
-				    context->rectx == tslot->current->rectx &&
-				    context->recty == tslot->current->recty &&
-				    context->preview_render_size == tslot->current->preview_render_size)
-				{
-					found_something = true;
-					break;
-				}
-			}
-		}
+/* Render the frame into the cache, r_size is the memory used by the frame when it had
+ * to be rendered. Returns false when the sequences were changed after generation was
+ * taken, prefetching has to stop then.
+ */
+bool BKE_sequencer_prefetch_frame(const SeqRenderData *context, float cfra, int chanshown, int generation,
+                                  size_t *r_size)
+{
+	SeqRenderData localcontext = *context;
+	ImBuf *ibuf;
 
-		/* e->ibuf is unrefed by render thread on next round. */
+	*r_size = 0;
 
-		if (e) {
-			seq_last_given_monoton_cfra = e->monoton_cfra;
-		}
+	BLI_rw_mutex_lock(&seq_prefetch_lock, THREAD_LOCK_READ);
 
-		pthread_mutex_unlock(&queue_lock);
+	if (generation != BKE_sequencer_prefetch_generation_get()) {
+		BLI_rw_mutex_unlock(&seq_prefetch_lock);
+		return false;
+	}
 
-		if (!success) {
-			e = NULL;
+	localcontext.is_prefetch_render = true;
 
-			if (!found_something) {
-				fprintf(stderr, "SEQ-THREAD: Requested frame not in queue ???\n");
-				break;
+	if (!BKE_sequencer_has_cached_frame(&localcontext, cfra, chanshown)) {
+		ibuf = BKE_sequencer_give_ibuf(&localcontext, cfra, chanshown);
+
+		if (ibuf) {
+			if (ibuf->rect) {
+				*r_size += sizeof(unsigned int) * ibuf->x * ibuf->y;
+			}
+			if (ibuf->rect_float) {
+				*r_size += sizeof(float) * ibuf->channels * ibuf->x * ibuf->y;
 			}
-			pthread_mutex_lock(&frame_done_lock);
-			pthread_cond_wait(&frame_done_cond, &frame_done_lock);
-			pthread_mutex_unlock(&frame_done_lock);
+			IMB_freeImBuf(ibuf);
 		}
 	}
-	
-	return e ? e->ibuf : NULL;
+
+	BLI_rw_mutex_unlock(&seq_prefetch_lock);
+
+	return true;
+}
+
+/* must be called from the main thread before sequences are changed or freed */
+void BKE_sequencer_prefetch_stop(void)
+{
+	/* no new frames are started */
+	atomic_add_and_fetch_int32(&seq_prefetch_generation, 1);
+
+	/* wait for frames being rendered */
+	BLI_rw_mutex_lock(&seq_prefetch_lock, THREAD_LOCK_WRITE);
+	BLI_rw_mutex_unlock(&seq_prefetch_lock);
 }
 
 /* check whether sequence cur depends on seq */
@@ -4110,6 +4585,8 @@ static void sequence_invalidate_cache(Scene *scene, Sequence *seq, bool invalida
 {
 	Editing *ed = scene->ed;
 
+	BKE_sequencer_prefetch_stop();
+
 	/* invalidate cache for current sequence */
 	if (invalidate_self) {
 		/* Animation structure holds some buffers inside,
@@ -4805,6 +5282,8 @@ int BKE_sequence_swap(Sequence *seq_a, Sequence *seq_b, const char **error_str)
 {
 	char name[sizeof(seq_a->name)];
 
+	BKE_sequencer_prefetch_stop();
+
 	if (seq_a->len != seq_b->len) {
 		*error_str = N_("Strips must be the same length");
 		return 0;
@@ -5102,6 +5581,8 @@ Sequence *BKE_sequence_alloc(ListBase *lb, int cfra, int machine)
 {
 	Sequence *seq;
 
+	BKE_sequencer_prefetch_stop();
+
 	seq = MEM_callocN(sizeof(Sequence), "addseq");
 	BLI_addtail(lb, seq);
 
@@ -0,0 +1,56 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2017 by Blender Foundation
+ * All rights reserved.
+ *
+ * The Original Code is: all of this file.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ * */
+
+#ifndef __BLI_MATH_HALF_H__
+#define __BLI_MATH_HALF_H__
+
+/** \file BLI_math_half.h
+ *  \ingroup bli
+ *
+ * Conversion between 32 bit floats and IEEE 754 half floats, used to store
+ * data in half the memory where the precision is enough.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "BLI_sys_types.h"
+
+/********************************** Half Floats *********************************/
+
+unsigned short float_to_half(float f);
+float half_to_float(unsigned short h);
+
+/* round to nearest even, out of range values become infinite,
+ * uses F16C instructions when the compiler targets them */
+void BLI_float_to_half_array(unsigned short *dst, const float *src, size_t len);
+void BLI_half_to_float_array(float *dst, const unsigned short *src, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLI_MATH_HALF_H__ */
@@ -90,6 +90,7 @@ int     BLI_system_num_threads_override_get(void);
 #define LOCK_COLORMANAGE 8
 #define LOCK_FFTW       9
 #define LOCK_VIEW3D     10
+#define LOCK_SEQUENCER  11
 
 void    BLI_thread_lock(int type);
 void    BLI_thread_unlock(int type);
@@ -0,0 +1,134 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2017 by Blender Foundation
+ * All rights reserved.
+ *
+ * The Original Code is: all of this file.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ * */
+
+/** \file blender/blenlib/intern/math_half.c
+ *  \ingroup bli
+ */
+
+#include "BLI_math_half.h"
+#include "BLI_utildefines.h"
+
+#ifdef __F16C__
+#  include <immintrin.h>
+#endif
+
+#include "BLI_strict_flags.h"
+
+/********************************** Half Floats *********************************/
+
+typedef union FloatBits {
+	float f;
+	uint32_t u;
+} FloatBits;
+
+unsigned short float_to_half(float f)
+{
+	FloatBits bits;
+	bits.f = f;
+
+	const uint32_t sign = (bits.u >> 16) & 0x8000;
+	const uint32_t u = bits.u & 0x7fffffff;
+	uint32_t h, rem, halfway;
+
+	if (u >= 0x7f800000) {
+		/* infinity stays infinity, NaN stays a quiet NaN */
+		return (unsigned short)(sign | 0x7c00 | ((u > 0x7f800000) ? 0x200 : 0));
+	}
+	if (u >= 0x477ff000) {
+		/* 65520 and larger round to infinity */
+		return (unsigned short)(sign | 0x7c00);
+	}
+	if (u < 0x38800000) {
+		/* denormal half, smaller than 2^-25 rounds to zero */
+		if (u < 0x33000000) {
+			return (unsigned short)sign;
+		}
+		const uint32_t mantissa = (u & 0x7fffff) | 0x800000;
+		const uint32_t shift = 126 - (u >> 23);
+		h = mantissa >> shift;
+		rem = mantissa & ((1u << shift) - 1);
+		halfway = 1u << (shift - 1);
+	}
+	else {
+		/* rebias the exponent from 127 to 15, a rounding carry moves into the exponent */
+		h = (u - 0x38000000) >> 13;
+		rem = u & 0x1fff;
+		halfway = 0x1000;
+	}
+
+	if (rem > halfway || (rem == halfway && (h & 1))) {
+		h++;
+	}
+	return (unsigned short)(sign | h);
+}
+
+float half_to_float(unsigned short h)
+{
+	const uint32_t sign = ((uint32_t)h & 0x8000) << 16;
+	const uint32_t exponent = ((uint32_t)h >> 10) & 0x1f;
+	const uint32_t mantissa = (uint32_t)h & 0x3ff;
+	FloatBits bits;
+
+	if (exponent == 0) {
+		/* zero and denormals, exact in float */
+		const float f = (float)mantissa * 5.9604644775390625e-08f;  /* 2^-24 */
+		return sign ? -f : f;
+	}
+	else if (exponent == 31) {
+		bits.u = sign | 0x7f800000 | (mantissa << 13);
+	}
+	else {
+		bits.u = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+	return bits.f;
+}
+
+void BLI_float_to_half_array(unsigned short *dst, const float *src, size_t len)
+{
+	size_t i = 0;
+#ifdef __F16C__
+	for (; i + 4 <= len; i += 4) {
+		const __m128i h = _mm_cvtps_ph(_mm_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+		_mm_storel_epi64((__m128i *)(dst + i), h);
+	}
+#endif
+	for (; i < len; i++) {
+		dst[i] = float_to_half(src[i]);
+	}
+}
+
+void BLI_half_to_float_array(float *dst, const unsigned short *src, size_t len)
+{
+	size_t i = 0;
+#ifdef __F16C__
+	for (; i + 4 <= len; i += 4) {
+		const __m128i h = _mm_loadl_epi64((const __m128i *)(src + i));
+		_mm_storeu_ps(dst + i, _mm_cvtph_ps(h));
+	}
+#endif
+	for (; i < len; i++) {
+		dst[i] = half_to_float(src[i]);
+	}
+}
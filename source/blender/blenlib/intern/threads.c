@@ -125,6 +125,7 @@ static pthread_mutex_t _movieclip_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t _colormanage_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t _fftw_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t _view3d_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t _sequencer_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_t mainid;
 static unsigned int thread_levels = 0;  /* threads can be invoked inside threads */
 static int num_threads_override = 0;
@@ -412,6 +413,8 @@ static ThreadMutex *global_mutex_from_type(const int type)
 			return &_fftw_lock;
 		case LOCK_VIEW3D:
 			return &_view3d_lock;
+		case LOCK_SEQUENCER:
+			return &_sequencer_lock;
 		default:
 			BLI_assert(0);
 			return NULL;
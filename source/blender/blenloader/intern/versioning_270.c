@@ -1826,6 +1826,17 @@ void blo_do_versions_270(FileData *fd, Library *UNUSED(lib), Main *bmain)
 			}
 		}
 	}
+
+	{
+		/* Versioning code until next subversion bump goes here. */
+		if (!DNA_struct_elem_find(fd->filesdna, "bNodeTree", "int", "cache_size")) {
+			for (Scene *scene = bmain->scene.first; scene; scene = scene->id.next) {
+				if (scene->nodetree) {
+					scene->nodetree->cache_size = 512;
+				}
+			}
+		}
+	}
 }
 
 void do_versions_after_linking_270(Main *bmain)
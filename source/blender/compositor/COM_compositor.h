@@ -145,7 +145,11 @@ extern "C" {
  * ExecutionGroup A) is asked to calculate the area ExecutionGroup B is missing.
  * [@ref ExecutionGroup.scheduleAreaWhenPossible]
  * ExecutionGroup B checks what chunks the area spans, and tries to schedule these chunks.
- * If all input data is available these chunks are scheduled [@ref ExecutionGroup.scheduleChunk]
+ * If all input data is available these chunks are added to the WorkScheduler, otherwise they
+ * count the input chunks they still wait for.
+ * Every chunk that is waited for keeps a list of the chunks waiting for it. When a chunk is finished
+ * [@ref ExecutionGroup.finalizeChunkExecution] the counters of these chunks are decreased, and chunks
+ * that don't wait for anything anymore are added to the WorkScheduler directly from the device thread.
  *
  * <pre>
  *
@@ -169,7 +173,7 @@ extern "C" {
  *            .                                .  .                                         .  O-------/
  *            .                                .  .                                         .  O
  *            .                                .  .                                         .  O
- *            .                                .  .                                         .  O-------\ ExecutionGroup.scheduleChunk
+ *            .                                .  .                                         .  O-------\ WorkScheduler.schedule
  *            .                                .  .                                         .  .       |
  *            .                                .  .                                         .  .  O----/
  *            .                                .  .                                         .  O<=O
@@ -182,7 +186,8 @@ extern "C" {
  *            .                                O                                            |
  * </pre>
  *
- * This happens until all chunks of (ExecutionGroup B) are finished executing or the user break's the process.
+ * All chunks of all output ExecutionGroups of the same priority are scheduled this way at once, after which
+ * [@ref WorkScheduler.finish] waits until all of them are finished executing or the user break's the process.
  *
  * NodeOperation like the ScaleOperation can influence the area of interest by reimplementing the
  * [@ref NodeOperation.determineAreaOfInterest] method
@@ -206,12 +211,12 @@ extern "C" {
  *
  * </pre>
  *
- * @see ExecutionGroup.execute Execute a complete ExecutionGroup. Halts until finished or breaked by user
- * @see ExecutionGroup.scheduleChunkWhenPossible Tries to schedule a single chunk,
- * checks if all input data is available. Can trigger dependent chunks to be calculated
- * @see ExecutionGroup.scheduleAreaWhenPossible Tries to schedule an area. This can be multiple chunks
+ * @see ExecutionGroup.execute Schedule all chunks of a complete ExecutionGroup.
+ * @see ExecutionGroup.scheduleChunkWhenPossible Schedules a single chunk,
+ * counts the input chunks it waits for. Can trigger dependent chunks to be calculated
+ * @see ExecutionGroup.scheduleAreaWhenPossible Schedules an area. This can be multiple chunks
  * (is called from [@ref ExecutionGroup.scheduleChunkWhenPossible])
- * @see ExecutionGroup.scheduleChunk Schedule a chunk on the WorkScheduler
+ * @see ExecutionGroup.finalizeChunkExecution Adds the chunks waiting for a finished chunk to the WorkScheduler
  * @see NodeOperation.determineDependingAreaOfInterest Influence the area of interest of a chunk.
  * @see WriteBufferOperation Operation to write to a MemoryProxy/MemoryBuffer
  * @see ReadBufferOperation Operation to read from a MemoryProxy/MemoryBuffer
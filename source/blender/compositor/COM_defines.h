@@ -111,4 +111,11 @@ typedef enum OrderOfChunks {
 
 #define COM_BLUR_BOKEH_PIXELS 512
 
+/**
+ * @brief maximum number of pixels calculated at once when executing rows
+ * Row buffers are allocated on the stack, 4 floats per pixel.
+ * @see SocketReader.executeRow
+ */
+#define COM_ROW_SPAN 64
+
 #endif  /* __COM_DEFINES_H__ */
@@ -200,6 +200,27 @@ public:
 	void setFastCalculation(bool fastCalculation) {this->m_fastCalculation = fastCalculation;}
 	bool isFastCalculation() const { return this->m_fastCalculation; }
 	bool isGroupnodeBufferEnabled() const { return (this->getbNodeTree()->flag & NTREE_COM_GROUPNODE_BUFFER) != 0; }
+	bool isRowExecutionEnabled() const { return (this->getbNodeTree()->flag & NTREE_COM_ROW_EXECUTION) != 0; }
+
+	/**
+	 * @brief results are only cached while editing, every render has new input
+	 */
+	bool isResultCacheEnabled() const { return !this->m_rendering && (this->getbNodeTree()->flag & NTREE_COM_RESULT_CACHE) != 0; }
+
+	/**
+	 * @brief memory limit of the result cache in bytes
+	 */
+	size_t getResultCacheLimit() const { return (size_t)this->getbNodeTree()->cache_size * 1024 * 1024; }
+
+	/**
+	 * @brief memory budget of the buffers in bytes, 0 when there is no limit
+	 */
+	size_t getMemoryLimit() const { return (size_t)this->getbNodeTree()->memory_limit * 1024 * 1024; }
+
+	/**
+	 * @brief store color buffers with half float precision while they are not used
+	 */
+	bool isHalfBuffersEnabled() const { return (this->getbNodeTree()->flag & NTREE_COM_HALF_BUFFERS) != 0; }
 };
 
 
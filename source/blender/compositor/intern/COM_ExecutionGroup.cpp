@@ -36,20 +36,38 @@
 #include "COM_ViewerOperation.h"
 #include "COM_ChunkOrder.h"
 #include "COM_Debug.h"
+#include "COM_ResultCache.h"
+#include "COM_MemoryBudget.h"
 
 #include "MEM_guardedalloc.h"
 #include "BLI_math.h"
 #include "BLI_string.h"
+#include "BLI_threads.h"
 #include "BLT_translation.h"
 #include "PIL_time.h"
 #include "WM_api.h"
 #include "WM_types.h"
 
+/* Protects the chunk states and dependencies of all execution groups. Chunks are scheduled
+ * from the main thread and finalized from the device threads. Never hold this lock while
+ * adding work to the WorkScheduler, it executes work directly when threading is disabled. */
+static ThreadMutex g_chunk_mutex = BLI_MUTEX_INITIALIZER;
+
+static void schedule_ready_chunks(const vector<ChunkReference> &ready)
+{
+	for (unsigned int index = 0; index < ready.size(); index++) {
+		ready[index].group->acquireChunkBuffers();
+		WorkScheduler::schedule(ready[index].group, ready[index].chunkNumber);
+	}
+}
+
 ExecutionGroup::ExecutionGroup()
 {
 	this->m_isOutput = false;
 	this->m_complex = false;
 	this->m_chunkExecutionStates = NULL;
+	this->m_chunkDependencies = NULL;
+	this->m_chunkDependents = NULL;
 	this->m_bTree = NULL;
 	this->m_height = 0;
 	this->m_width = 0;
@@ -63,6 +81,9 @@ ExecutionGroup::ExecutionGroup()
 	this->m_chunksFinished = 0;
 	BLI_rcti_init(&this->m_viewerBorder, 0, 0, 0, 0);
 	this->m_executionStartTime = 0;
+	this->m_resultCacheKey = 0;
+	this->m_resultCacheChecked = false;
+	this->m_resultFromCache = false;
 }
 
 CompositorPriority ExecutionGroup::getRenderPriotrity()
@@ -122,6 +143,8 @@ void ExecutionGroup::initExecution()
 		for (index = 0; index < this->m_numberOfChunks; index++) {
 			this->m_chunkExecutionStates[index] = COM_ES_NOT_SCHEDULED;
 		}
+		this->m_chunkDependencies = (unsigned int *)MEM_callocN(sizeof(unsigned int) * this->m_numberOfChunks, __func__);
+		this->m_chunkDependents = new vector<ChunkReference>[this->m_numberOfChunks];
 	}
 
 
@@ -138,6 +161,10 @@ void ExecutionGroup::initExecution()
 	maxNumber++;
 	this->m_cachedMaxReadBufferOffset = maxNumber;
 
+	this->m_chunksFinished = 0;
+	this->m_resultCacheChecked = false;
+	this->m_resultFromCache = false;
+
 }
 
 void ExecutionGroup::deinitExecution()
@@ -146,6 +173,14 @@ void ExecutionGroup::deinitExecution()
 		MEM_freeN(this->m_chunkExecutionStates);
 		this->m_chunkExecutionStates = NULL;
 	}
+	if (this->m_chunkDependencies != NULL) {
+		MEM_freeN(this->m_chunkDependencies);
+		this->m_chunkDependencies = NULL;
+	}
+	if (this->m_chunkDependents != NULL) {
+		delete[] this->m_chunkDependents;
+		this->m_chunkDependents = NULL;
+	}
 	this->m_numberOfChunks = 0;
 	this->m_numberOfXChunks = 0;
 	this->m_numberOfYChunks = 0;
@@ -304,48 +339,23 @@ void ExecutionGroup::execute(ExecutionSystem *graph)
 	DebugInfo::execution_group_started(this);
 	DebugInfo::graphviz(graph);
 
-	bool breaked = false;
-	bool finished = false;
-	unsigned int startIndex = 0;
-	const int maxNumberEvaluated = BLI_system_thread_count() * 2;
-
-	while (!finished && !breaked) {
-		bool startEvaluated = false;
-		finished = true;
-		int numberEvaluated = 0;
-
-		for (index = startIndex; index < this->m_numberOfChunks && numberEvaluated < maxNumberEvaluated; index++) {
-			chunkNumber = chunkOrder[index];
-			int yChunk = chunkNumber / this->m_numberOfXChunks;
-			int xChunk = chunkNumber - (yChunk * this->m_numberOfXChunks);
-			const ChunkExecutionState state = this->m_chunkExecutionStates[chunkNumber];
-			if (state == COM_ES_NOT_SCHEDULED) {
-				scheduleChunkWhenPossible(graph, xChunk, yChunk);
-				finished = false;
-				startEvaluated = true;
-				numberEvaluated++;
-
-				if (bTree->update_draw)
-					bTree->update_draw(bTree->udh);
-			}
-			else if (state == COM_ES_SCHEDULED) {
-				finished = false;
-				startEvaluated = true;
-				numberEvaluated++;
-			}
-			else if (state == COM_ES_EXECUTED && !startEvaluated) {
-				startIndex = index + 1;
-			}
-		}
-
-		WorkScheduler::finish();
-
-		if (bTree->test_break && bTree->test_break(bTree->tbh)) {
-			breaked = true;
-		}
+	/* reading the cache can do file I/O, so it is not done while holding the chunk lock */
+	readResultCaches();
+
+	/* Schedule all chunks in order at once. Chunks that can be calculated are added to the
+	 * WorkScheduler, the others are added by the device threads as soon as the last chunk
+	 * they depend on is finished. */
+	vector<ChunkReference> ready;
+	BLI_mutex_lock(&g_chunk_mutex);
+	for (index = 0; index < this->m_numberOfChunks; index++) {
+		chunkNumber = chunkOrder[index];
+		int yChunk = chunkNumber / this->m_numberOfXChunks;
+		int xChunk = chunkNumber - (yChunk * this->m_numberOfXChunks);
+		scheduleChunkWhenPossible(graph, xChunk, yChunk, NULL, ready);
 	}
-	DebugInfo::execution_group_finished(this);
-	DebugInfo::graphviz(graph);
+	BLI_mutex_unlock(&g_chunk_mutex);
+
+	schedule_ready_chunks(ready);
 
 	MEM_freeN(chunkOrder);
 }
@@ -380,10 +390,36 @@ MemoryBuffer *ExecutionGroup::constructConsolidatedMemoryBuffer(MemoryProxy *mem
 
 void ExecutionGroup::finalizeChunkExecution(int chunkNumber, MemoryBuffer **memoryBuffers)
 {
+	vector<ChunkReference> ready;
+
+	releaseChunkBuffers();
+
+	BLI_mutex_lock(&g_chunk_mutex);
 	if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_SCHEDULED)
 		this->m_chunkExecutionStates[chunkNumber] = COM_ES_EXECUTED;
+
+	vector<ChunkReference> &dependents = this->m_chunkDependents[chunkNumber];
+	for (unsigned int index = 0; index < dependents.size(); index++) {
+		ExecutionGroup *group = dependents[index].group;
+		if (--group->m_chunkDependencies[dependents[index].chunkNumber] == 0) {
+			ready.push_back(dependents[index]);
+		}
+	}
+	dependents.clear();
+	BLI_mutex_unlock(&g_chunk_mutex);
+
+	/* after a break the waiting chunks are never added, so WorkScheduler::finish returns
+	 * as soon as the chunks being calculated are done */
+	if (!this->getOutputOperation()->isBreaked()) {
+		schedule_ready_chunks(ready);
+	}
 	
-	atomic_add_and_fetch_u(&this->m_chunksFinished, 1);
+	if (atomic_add_and_fetch_u(&this->m_chunksFinished, 1) == this->m_numberOfChunks) {
+		releaseInputBuffers();
+		if (this->getOutputOperation()->isWriteBufferOperation()) {
+			MemoryBudget::written(((WriteBufferOperation *)this->getOutputOperation())->getMemoryProxy());
+		}
+	}
 	if (memoryBuffers) {
 		for (unsigned int index = 0; index < this->m_cachedMaxReadBufferOffset; index++) {
 			MemoryBuffer *buffer = memoryBuffers[index];
@@ -407,6 +443,9 @@ void ExecutionGroup::finalizeChunkExecution(int chunkNumber, MemoryBuffer **memo
 		             this->m_chunksFinished,
 		             this->m_numberOfChunks);
 		this->m_bTree->stats_draw(this->m_bTree->sdh, buf);
+
+		if (this->m_bTree->update_draw)
+			this->m_bTree->update_draw(this->m_bTree->udh);
 	}
 }
 
@@ -448,10 +487,11 @@ MemoryBuffer *ExecutionGroup::allocateOutputBuffer(int /*chunkNumber*/,
 }
 
 
-bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area)
+unsigned int ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area,
+                                                      const ChunkReference *dependent, vector<ChunkReference> &ready)
 {
 	if (this->m_singleThreaded) {
-		return scheduleChunkWhenPossible(graph, 0, 0);
+		return scheduleChunkWhenPossible(graph, 0, 0, dependent, ready) ? 0 : 1;
 	}
 	// find all chunks inside the rect
 	// determine minxchunk, minychunk, maxxchunk, maxychunk where x and y are chunknumbers
@@ -470,11 +510,11 @@ bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area
 	maxxchunk = min_ii(maxxchunk, (int)m_numberOfXChunks);
 	maxychunk = min_ii(maxychunk, (int)m_numberOfYChunks);
 
-	bool result = true;
+	unsigned int result = 0;
 	for (indexx = minxchunk; indexx < maxxchunk; indexx++) {
 		for (indexy = minychunk; indexy < maxychunk; indexy++) {
-			if (!scheduleChunkWhenPossible(graph, indexx, indexy)) {
-				result = false;
+			if (!scheduleChunkWhenPossible(graph, indexx, indexy, dependent, ready)) {
+				result++;
 			}
 		}
 	}
@@ -482,17 +522,8 @@ bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area
 	return result;
 }
 
-bool ExecutionGroup::scheduleChunk(unsigned int chunkNumber)
-{
-	if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_NOT_SCHEDULED) {
-		this->m_chunkExecutionStates[chunkNumber] = COM_ES_SCHEDULED;
-		WorkScheduler::schedule(this, chunkNumber);
-		return true;
-	}
-	return false;
-}
-
-bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk)
+bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk,
+                                               const ChunkReference *dependent, vector<ChunkReference> &ready)
 {
 	if (xChunk < 0 || xChunk >= (int)this->m_numberOfXChunks) {
 		return true;
@@ -506,20 +537,27 @@ bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChun
 		return true;
 	}
 
+	if (dependent) {
+		this->m_chunkDependents[chunkNumber].push_back(*dependent);
+	}
+
 	// chunk is scheduled, but not executed
 	if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_SCHEDULED) {
 		return false;
 	}
 
-	// chunk is nor executed nor scheduled.
+	// chunk is nor executed nor scheduled, schedule the chunks it reads from.
+	this->m_chunkExecutionStates[chunkNumber] = COM_ES_SCHEDULED;
+
 	vector<MemoryProxy *> memoryProxies;
 	this->determineDependingMemoryProxies(&memoryProxies);
 
 	rcti rect;
 	determineChunkRect(&rect, xChunk, yChunk);
 	unsigned int index;
-	bool canBeExecuted = true;
+	unsigned int dependencies = 0;
 	rcti area;
+	const ChunkReference chunk(this, chunkNumber);
 
 	for (index = 0; index < this->m_cachedReadOperations.size(); index++) {
 		ReadBufferOperation *readOperation = (ReadBufferOperation *)this->m_cachedReadOperations[index];
@@ -529,17 +567,18 @@ bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChun
 		ExecutionGroup *group = memoryProxy->getExecutor();
 
 		if (group != NULL) {
-			if (!group->scheduleAreaWhenPossible(graph, &area)) {
-				canBeExecuted = false;
-			}
+			dependencies += group->scheduleAreaWhenPossible(graph, &area, &chunk, ready);
 		}
 		else {
 			throw "ERROR";
 		}
 	}
 
-	if (canBeExecuted) {
-		scheduleChunk(chunkNumber);
+	if (dependencies == 0) {
+		ready.push_back(chunk);
+	}
+	else {
+		this->m_chunkDependencies[chunkNumber] = dependencies;
 	}
 
 	return false;
@@ -559,6 +598,110 @@ void ExecutionGroup::determineDependingMemoryProxies(vector<MemoryProxy *> *memo
 	}
 }
 
+void ExecutionGroup::determineDistinctMemoryProxies(vector<MemoryProxy *> *memoryProxies)
+{
+	unsigned int index;
+	for (index = 0; index < this->m_cachedReadOperations.size(); index++) {
+		ReadBufferOperation *readOperation = (ReadBufferOperation *) this->m_cachedReadOperations[index];
+		MemoryProxy *memoryProxy = readOperation->getMemoryProxy();
+		if (std::find(memoryProxies->begin(), memoryProxies->end(), memoryProxy) == memoryProxies->end()) {
+			memoryProxies->push_back(memoryProxy);
+		}
+	}
+}
+
+void ExecutionGroup::readResultCaches()
+{
+	if (this->m_resultCacheChecked) {
+		return;
+	}
+	this->m_resultCacheChecked = true;
+
+	if (this->m_resultCacheKey != 0 && readResultCache()) {
+		/* the groups this group reads from are not scheduled for it */
+		return;
+	}
+
+	vector<MemoryProxy *> memoryProxies;
+	this->determineDistinctMemoryProxies(&memoryProxies);
+	for (unsigned int index = 0; index < memoryProxies.size(); index++) {
+		memoryProxies[index]->getExecutor()->readResultCaches();
+	}
+}
+
+bool ExecutionGroup::readResultCache()
+{
+	NodeOperation *operation = this->getOutputOperation();
+	BLI_assert(operation->isWriteBufferOperation());
+	MemoryProxy *proxy = ((WriteBufferOperation *)operation)->getMemoryProxy();
+
+	MemoryBudget::acquire(proxy);
+	const bool found = ResultCache::read(this->m_resultCacheKey, proxy->getBuffer());
+	MemoryBudget::release(proxy);
+
+	if (found) {
+		for (unsigned int index = 0; index < this->m_numberOfChunks; index++) {
+			this->m_chunkExecutionStates[index] = COM_ES_EXECUTED;
+		}
+		this->m_chunksFinished = this->m_numberOfChunks;
+		this->m_resultFromCache = true;
+		/* the inputs are not read, they can be freed as if this group was calculated */
+		releaseInputBuffers();
+		MemoryBudget::written(proxy);
+	}
+	return found;
+}
+
+void ExecutionGroup::releaseInputBuffers()
+{
+	vector<MemoryProxy *> memoryProxies;
+	this->determineDistinctMemoryProxies(&memoryProxies);
+	for (unsigned int index = 0; index < memoryProxies.size(); index++) {
+		MemoryBudget::releaseReader(memoryProxies[index]);
+	}
+}
+
+void ExecutionGroup::acquireChunkBuffers()
+{
+	vector<MemoryProxy *> memoryProxies;
+	this->determineDistinctMemoryProxies(&memoryProxies);
+	for (unsigned int index = 0; index < memoryProxies.size(); index++) {
+		MemoryBudget::acquire(memoryProxies[index]);
+	}
+
+	NodeOperation *operation = this->getOutputOperation();
+	if (operation->isWriteBufferOperation()) {
+		MemoryBudget::acquire(((WriteBufferOperation *)operation)->getMemoryProxy());
+	}
+}
+
+void ExecutionGroup::releaseChunkBuffers()
+{
+	vector<MemoryProxy *> memoryProxies;
+	this->determineDistinctMemoryProxies(&memoryProxies);
+	for (unsigned int index = 0; index < memoryProxies.size(); index++) {
+		MemoryBudget::release(memoryProxies[index]);
+	}
+
+	NodeOperation *operation = this->getOutputOperation();
+	if (operation->isWriteBufferOperation()) {
+		MemoryBudget::release(((WriteBufferOperation *)operation)->getMemoryProxy());
+	}
+}
+
+bool ExecutionGroup::isExecuted() const
+{
+	if (this->m_chunkExecutionStates == NULL) {
+		return false;
+	}
+	for (unsigned int index = 0; index < this->m_numberOfChunks; index++) {
+		if (this->m_chunkExecutionStates[index] != COM_ES_EXECUTED) {
+			return false;
+		}
+	}
+	return true;
+}
+
 bool ExecutionGroup::isOpenCL()
 {
 	return this->m_openCL;
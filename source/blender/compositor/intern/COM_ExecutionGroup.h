@@ -34,6 +34,7 @@
 using std::vector;
 
 class ExecutionSystem;
+class ExecutionGroup;
 class MemoryProxy;
 class ReadBufferOperation;
 class Device;
@@ -57,6 +58,17 @@ typedef enum ChunkExecutionState {
 	COM_ES_EXECUTED = 2
 } ChunkExecutionState;
 
+/**
+ * @brief reference to a chunk of an ExecutionGroup
+ * @ingroup Execution
+ */
+struct ChunkReference {
+	ExecutionGroup *group;
+	unsigned int chunkNumber;
+
+	ChunkReference(ExecutionGroup *group_, unsigned int chunkNumber_) : group(group_), chunkNumber(chunkNumber_) {}
+};
+
 /**
  * @brief Class ExecutionGroup is a group of Operations that are executed as one.
  * This grouping is used to combine Operations that can be executed as one whole when multi-processing.
@@ -151,10 +163,21 @@ private:
 	/**
 	 * @brief the chunkExecutionStates holds per chunk the execution state. this state can be
 	 *   - COM_ES_NOT_SCHEDULED: not scheduled
-	 *   - COM_ES_SCHEDULED: scheduled
+	 *   - COM_ES_SCHEDULED: scheduled, waiting for its inputs or in the WorkScheduler
 	 *   - COM_ES_EXECUTED: executed
 	 */
 	ChunkExecutionState *m_chunkExecutionStates;
+
+	/**
+	 * @brief per chunk the number of input chunks that are not executed yet.
+	 * A scheduled chunk is added to the WorkScheduler when this drops to zero.
+	 */
+	unsigned int *m_chunkDependencies;
+
+	/**
+	 * @brief per chunk the scheduled chunks of other groups that wait for its result
+	 */
+	vector<ChunkReference> *m_chunkDependents;
 	
 	/**
 	 * @brief indicator when this ExecutionGroup has valid Operations in its vector for Execution
@@ -178,6 +201,21 @@ private:
 	 */
 	double m_executionStartTime;
 
+	/**
+	 * @brief key of the result of this group in the ResultCache, 0 when it is not cached
+	 */
+	uint64_t m_resultCacheKey;
+
+	/**
+	 * @brief the ResultCache has been checked for the result of this group and the groups it reads from
+	 */
+	bool m_resultCacheChecked;
+
+	/**
+	 * @brief the result of this group was copied from the ResultCache
+	 */
+	bool m_resultFromCache;
+
 	// methods
 	/**
 	 * @brief check whether parameter operation can be added to the execution group
@@ -208,34 +246,53 @@ private:
 	void determineNumberOfChunks();
 	
 	/**
-	 * @brief try to schedule a specific chunk.
-	 * @note scheduling succeeds when all input requirements are met and the chunks hasn't been scheduled yet.
+	 * @brief schedule a specific chunk and the chunks of other groups it depends on.
+	 * @note A chunk without unfinished input chunks is added to the ready list, otherwise it is
+	 * added to the WorkScheduler by finalizeChunkExecution of its last unfinished input chunk.
+	 * @note must be called with the chunk lock held
 	 * @param graph
 	 * @param xChunk
 	 * @param yChunk
+	 * @param dependent chunk that waits for this chunk, or NULL
+	 * @param ready chunks that can be added to the WorkScheduler once the chunk lock is released
 	 * @return [true:false]
-	 * true: package(s) are scheduled
-	 * false: scheduling is deferred (depending workpackages are scheduled)
+	 * true: the chunk is executed
+	 * false: the chunk is scheduled, the dependent will be notified when it is executed
 	 */
-	bool scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk);
+	bool scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk,
+	                               const ChunkReference *dependent, vector<ChunkReference> &ready);
 
 	/**
-	 * @brief try to schedule a specific area.
-	 * @note Check if a certain area is available, when not available this are will be checked.
+	 * @brief schedule all chunks of a specific area.
 	 * @note This method is called from other ExecutionGroup's.
 	 * @param graph
 	 * @param rect
-	 * @return [true:false]
-	 * true: package(s) are scheduled
-	 * false: scheduling is deferred (depending workpackages are scheduled)
+	 * @param dependent chunk that waits for the area
+	 * @param ready chunks that can be added to the WorkScheduler once the chunk lock is released
+	 * @return number of chunks in the area that are not executed yet
 	 */
-	bool scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *rect);
+	unsigned int scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *rect,
+	                                      const ChunkReference *dependent, vector<ChunkReference> &ready);
 
 	/**
-	 * @brief add a chunk to the WorkScheduler.
-	 * @param chunknumber
+	 * @brief copy the result from the ResultCache into the write buffer
+	 * When found all chunks are marked as executed, so groups this group depends on
+	 * will not be scheduled for it.
+	 * @return the result was found in the cache
 	 */
-	bool scheduleChunk(unsigned int chunkNumber);
+	bool readResultCache();
+
+	/**
+	 * @brief read the cached results of this group and the groups it reads from, before scheduling
+	 * Groups are only checked once per execution, groups only read by a cached group are skipped.
+	 */
+	void readResultCaches();
+
+	/**
+	 * @brief this group is finished, release it as reader of its input buffers
+	 * @see MemoryBudget
+	 */
+	void releaseInputBuffers();
 	
 	/**
 	 * @brief determine the area of interest of a certain input area
@@ -362,7 +419,8 @@ public:
 	
 	/**
 	 * @brief schedule an ExecutionGroup
-	 * @note this method will return when all chunks have been calculated, or the execution has breaked (by user)
+	 * @note this method returns as soon as all chunks are scheduled, use WorkScheduler::finish
+	 * to wait until they have been calculated or the execution has breaked (by user).
 	 *
 	 * first the order of the chunks will be determined. This is determined by finding the ViewerOperation and get the relevant information from it.
 	 *   - ChunkOrdering
@@ -383,6 +441,23 @@ public:
 	 * @param memoryProxies result
 	 */
 	void determineDependingMemoryProxies(vector<MemoryProxy *> *memoryProxies);
+
+	/**
+	 * @brief like determineDependingMemoryProxies, but every MemoryProxy is added once
+	 * @param memoryProxies result
+	 */
+	void determineDistinctMemoryProxies(vector<MemoryProxy *> *memoryProxies);
+
+	/**
+	 * @brief pin the input and output buffers of this group in the MemoryBudget
+	 * @note called for every chunk added to the WorkScheduler
+	 */
+	void acquireChunkBuffers();
+
+	/**
+	 * @brief unpin the buffers pinned by acquireChunkBuffers
+	 */
+	void releaseChunkBuffers();
 	
 	/**
 	 * @brief Determine the rect (minx, maxx, miny, maxy) of a chunk.
@@ -413,6 +488,19 @@ public:
 
 	void setRenderBorder(float xmin, float xmax, float ymin, float ymax);
 
+	/**
+	 * @brief set the key of the result of this group in the ResultCache
+	 * @note only for groups writing to a buffer
+	 */
+	void setResultCacheKey(uint64_t key) { this->m_resultCacheKey = key; }
+	uint64_t getResultCacheKey() const { return this->m_resultCacheKey; }
+	bool isResultFromCache() const { return this->m_resultFromCache; }
+
+	/**
+	 * @brief are all chunks of this group executed
+	 */
+	bool isExecuted() const;
+
 	/* allow the DebugInfo class to look at internals */
 	friend class DebugInfo;
 
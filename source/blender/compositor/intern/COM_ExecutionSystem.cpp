@@ -22,9 +22,13 @@
 
 #include "COM_ExecutionSystem.h"
 
+#include <stdio.h>
+#include <typeinfo>
+
 #include "PIL_time.h"
 #include "BLI_utildefines.h"
 extern "C" {
+#include "BKE_global.h"
 #include "BKE_node.h"
 }
 
@@ -36,6 +40,9 @@ extern "C" {
 #include "COM_ExecutionGroup.h"
 #include "COM_WorkScheduler.h"
 #include "COM_ReadBufferOperation.h"
+#include "COM_WriteBufferOperation.h"
+#include "COM_ResultCache.h"
+#include "COM_MemoryBudget.h"
 #include "COM_Debug.h"
 
 #ifdef WITH_CXX_GUARDEDALLOC
@@ -144,6 +151,10 @@ void ExecutionSystem::execute()
 	}
 	unsigned int index;
 
+	for (index = 0; index < this->m_operations.size(); index++) {
+		this->m_operations[index]->setRowExecution(this->m_context.isRowExecutionEnabled());
+	}
+
 	// First allocale all write buffer
 	for (index = 0; index < this->m_operations.size(); index++) {
 		NodeOperation *operation = this->m_operations[index];
@@ -174,6 +185,16 @@ void ExecutionSystem::execute()
 		executionGroup->initExecution();
 	}
 
+	initMemoryBudget();
+
+	if (this->m_context.isResultCacheEnabled()) {
+		initResultCache();
+	}
+	else if (!this->m_context.isRendering()) {
+		/* caching was disabled, don't keep the memory */
+		ResultCache::clear();
+	}
+
 	WorkScheduler::start(this->m_context);
 
 	executeGroups(COM_PRIORITY_HIGH);
@@ -185,6 +206,16 @@ void ExecutionSystem::execute()
 	WorkScheduler::finish();
 	WorkScheduler::stop();
 
+	if (this->m_context.isResultCacheEnabled()) {
+		writeResultCache();
+	}
+
+	if (G.debug & G_DEBUG) {
+		printExecutionTimes();
+		printMemoryUsage();
+	}
+	MemoryBudget::end();
+
 	editingtree->stats_draw(editingtree->sdh, IFACE_("Compositing | De-initializing execution"));
 	for (index = 0; index < this->m_operations.size(); index++) {
 		NodeOperation *operation = this->m_operations[index];
@@ -196,16 +227,215 @@ void ExecutionSystem::execute()
 	}
 }
 
+uint64_t ExecutionSystem::determineContextHash() const
+{
+	const RenderData *rd = this->m_context.getRenderData();
+	ResultHash hash;
+	hash.add((uint64_t)(intptr_t)this->m_context.getScene());
+	hash.add((uint64_t)this->m_context.getFramenumber());
+	hash.add((uint64_t)this->m_context.getQuality());
+	hash.add((uint64_t)this->m_context.isFastCalculation());
+	hash.add((uint64_t)this->m_context.getHasActiveOpenCLDevices());
+	if (this->m_context.getViewName()) {
+		hash.add(this->m_context.getViewName());
+	}
+	if (rd) {
+		hash.add((uint64_t)rd->size);
+		hash.add((uint64_t)rd->xsch);
+		hash.add((uint64_t)rd->ysch);
+		hash.add(&rd->xasp, sizeof(rd->xasp));
+		hash.add(&rd->yasp, sizeof(rd->yasp));
+		hash.add((uint64_t)(rd->mode & (R_BORDER | R_CROP)));
+		hash.add(&rd->border, sizeof(rd->border));
+		hash.add((uint64_t)(rd->scemode & R_FULL_SAMPLE));
+	}
+	return hash.get();
+}
+
+uint64_t ExecutionSystem::determineResultHash(NodeOperation *operation, ResultHashes &hashes)
+{
+	ResultHashes::iterator found = hashes.find(operation);
+	if (found != hashes.end()) {
+		return found->second;
+	}
+
+	uint64_t result = 0;
+	if (operation->isReadBufferOperation()) {
+		MemoryProxy *proxy = ((ReadBufferOperation *)operation)->getMemoryProxy();
+		result = determineResultHash(proxy->getWriteBufferOperation(), hashes);
+	}
+	else if (!operation->isVolatile()) {
+		ResultHash hash;
+		hash.add(typeid(*operation).name());
+		hash.add(operation->getSettingsHash());
+		hash.add((uint64_t)operation->getWidth());
+		hash.add((uint64_t)operation->getHeight());
+
+		result = 1;
+		for (unsigned int index = 0; index < operation->getNumberOfInputSockets(); index++) {
+			NodeOperationInput *input = operation->getInputSocket(index);
+			NodeOperationOutput *link = input->getLink();
+			hash.add((uint64_t)input->getResizeMode());
+			if (link == NULL) {
+				continue;
+			}
+
+			NodeOperation &linked = link->getOperation();
+			for (unsigned int output = 0; output < linked.getNumberOfOutputSockets(); output++) {
+				if (linked.getOutputSocket(output) == link) {
+					hash.add((uint64_t)output);
+				}
+			}
+
+			uint64_t input_hash = determineResultHash(&linked, hashes);
+			if (input_hash == 0) {
+				result = 0;
+				break;
+			}
+			hash.add(input_hash);
+		}
+
+		if (result != 0) {
+			/* 0 is reserved for results that can't be cached */
+			result = hash.get() ? hash.get() : 1;
+		}
+	}
+
+	hashes[operation] = result;
+	return result;
+}
+
+void ExecutionSystem::initResultCache()
+{
+	const uint64_t context_hash = determineContextHash();
+	ResultHashes hashes;
+
+	for (unsigned int index = 0; index < this->m_groups.size(); index++) {
+		ExecutionGroup *group = this->m_groups[index];
+		NodeOperation *operation = group->getOutputOperation();
+		if (!operation->isWriteBufferOperation()) {
+			continue;
+		}
+
+		uint64_t operation_hash = determineResultHash(operation, hashes);
+		if (operation_hash != 0) {
+			ResultHash hash;
+			hash.add(context_hash);
+			hash.add(operation_hash);
+			group->setResultCacheKey(hash.get() ? hash.get() : 1);
+		}
+		else {
+			group->setResultCacheKey(0);
+		}
+	}
+}
+
+void ExecutionSystem::writeResultCache()
+{
+	const size_t limit = this->m_context.getResultCacheLimit();
+	unsigned int num_read = 0, num_written = 0;
+
+	for (unsigned int index = 0; index < this->m_groups.size(); index++) {
+		ExecutionGroup *group = this->m_groups[index];
+		if (group->getResultCacheKey() == 0) {
+			continue;
+		}
+		if (group->isResultFromCache()) {
+			num_read++;
+		}
+		else if (group->isExecuted()) {
+			WriteBufferOperation *operation = (WriteBufferOperation *)group->getOutputOperation();
+			MemoryProxy *proxy = operation->getMemoryProxy();
+			/* buffers freed early by the MemoryBudget are already written */
+			if (proxy->getBuffer()->hasData() || proxy->isPacked() || proxy->isSpilled()) {
+				MemoryBudget::acquire(proxy);
+				ResultCache::write(group->getResultCacheKey(), proxy->getBuffer(), limit,
+				                   this->m_context.isHalfBuffersEnabled() && proxy->isHalfStorage());
+				MemoryBudget::release(proxy);
+			}
+			num_written++;
+		}
+	}
+
+	if (G.debug & G_DEBUG) {
+		unsigned int hits, misses, num_results;
+		size_t memory;
+		ResultCache::getStatistics(&hits, &misses, &num_results, &memory);
+		printf("Compositor result cache: %u read, %u written, "
+		       "%u hits, %u misses, %u results using %.2f MB\n",
+		       num_read, num_written, hits, misses, num_results,
+		       (double)memory / (1024.0 * 1024.0));
+	}
+}
+
+void ExecutionSystem::initMemoryBudget()
+{
+	MemoryBudget::begin(this->m_context);
+
+	unsigned int index;
+	for (index = 0; index < this->m_operations.size(); index++) {
+		NodeOperation *operation = this->m_operations[index];
+		if (operation->isWriteBufferOperation()) {
+			MemoryBudget::addBuffer(((WriteBufferOperation *)operation)->getMemoryProxy());
+		}
+	}
+	for (index = 0; index < this->m_groups.size(); index++) {
+		vector<MemoryProxy *> memoryProxies;
+		this->m_groups[index]->determineDistinctMemoryProxies(&memoryProxies);
+		for (unsigned int proxy_index = 0; proxy_index < memoryProxies.size(); proxy_index++) {
+			MemoryBudget::addReader(memoryProxies[proxy_index]);
+		}
+	}
+}
+
+void ExecutionSystem::printMemoryUsage() const
+{
+	size_t peak_memory, spilled_memory;
+	unsigned int num_freed, num_packed, num_spilled;
+	MemoryBudget::getStatistics(&peak_memory, &num_freed, &num_packed, &num_spilled, &spilled_memory);
+	printf("Compositor buffers: peak %.2f MB, %u freed early, %u packed, %u spilled using %.2f MB\n",
+	       (double)peak_memory / (1024.0 * 1024.0), num_freed, num_packed, num_spilled,
+	       (double)spilled_memory / (1024.0 * 1024.0));
+}
+
+void ExecutionSystem::printExecutionTimes() const
+{
+	printf("Compositor operation times (summed over threads):\n");
+	for (unsigned int index = 0; index < this->m_operations.size(); index++) {
+		NodeOperation *operation = this->m_operations[index];
+		if (!operation->isWriteBufferOperation()) {
+			continue;
+		}
+
+		WriteBufferOperation *writeOperation = (WriteBufferOperation *)operation;
+		NodeOperation *input = writeOperation->getInput();
+		const double time = writeOperation->getExecutionTime();
+		if (input == NULL || time == 0.0) {
+			continue;
+		}
+		printf("  %-40s %5ux%-5u %10.3f ms\n", typeid(*input).name(),
+		       writeOperation->getWidth(), writeOperation->getHeight(), time * 1000.0);
+	}
+}
+
 void ExecutionSystem::executeGroups(CompositorPriority priority)
 {
 	unsigned int index;
 	vector<ExecutionGroup *> executionGroups;
 	this->findOutputExecutionGroup(&executionGroups, priority);
 
+	/* all output groups of a priority are scheduled before waiting,
+	 * so independent groups are calculated at the same time */
 	for (index = 0; index < executionGroups.size(); index++) {
 		ExecutionGroup *group = executionGroups[index];
 		group->execute(this);
 	}
+	WorkScheduler::finish();
+
+	for (index = 0; index < executionGroups.size(); index++) {
+		DebugInfo::execution_group_finished(executionGroups[index]);
+		DebugInfo::graphviz(this);
+	}
 }
 
 void ExecutionSystem::findOutputExecutionGroup(vector<ExecutionGroup *> *result, CompositorPriority priority) const
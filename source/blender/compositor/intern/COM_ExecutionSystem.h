@@ -32,6 +32,8 @@ class ExecutionGroup;
 #include "COM_ExecutionGroup.h"
 #include "COM_NodeOperation.h"
 
+#include <map>
+
 /**
  * @page execution Execution model
  * In order to get to an efficient model for execution, several steps are being done. these steps are explained below.
@@ -142,6 +144,46 @@ private: //methods
 	 */
 	void findOutputExecutionGroup(vector<ExecutionGroup *> *result) const;
 
+	typedef std::map<NodeOperation *, uint64_t> ResultHashes;
+
+	/**
+	 * @brief hash identifying the result of an operation, based on its settings, resolution
+	 * and the hashes of the operations it reads from.
+	 * @return 0 when the result depends on a volatile operation and can't be cached
+	 * @see ResultCache
+	 */
+	uint64_t determineResultHash(NodeOperation *operation, ResultHashes &hashes);
+
+	/**
+	 * @brief hash of the context settings that operations can depend on
+	 */
+	uint64_t determineContextHash() const;
+
+	/**
+	 * @brief set the ResultCache keys of the groups writing to a buffer
+	 */
+	void initResultCache();
+
+	/**
+	 * @brief store the results of the groups that were calculated in this execution
+	 */
+	void writeResultCache();
+
+	/**
+	 * @brief register the buffers and the groups reading them in the MemoryBudget
+	 */
+	void initMemoryBudget();
+
+	/**
+	 * @brief print the peak memory of the buffers and how many were freed early or spilled
+	 */
+	void printMemoryUsage() const;
+
+	/**
+	 * @brief print the time spent in the operations writing to a buffer, for benchmarking
+	 */
+	void printExecutionTimes() const;
+
 public:
 	/**
 	 * @brief Create a new ExecutionSystem and initialize it with the
@@ -0,0 +1,333 @@
+/*
+ * Copyright 2017, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <vector>
+
+#include "COM_MemoryBudget.h"
+#include "COM_CompositorContext.h"
+#include "COM_ExecutionGroup.h"
+#include "COM_MemoryProxy.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_ResultCache.h"
+
+extern "C" {
+#  include "BLI_path_util.h"
+#  include "BLI_string.h"
+#  include "BLI_threads.h"
+#  include "BKE_appdir.h"
+}
+
+static ThreadMutex g_mutex = BLI_MUTEX_INITIALIZER;
+static ThreadCondition g_idle_cond;
+static std::vector<MemoryProxy *> g_buffers;
+static size_t g_limit = 0;
+static size_t g_result_cache_limit = 0;
+static bool g_half = false;
+static size_t g_memory = 0;
+static size_t g_peak_memory = 0;
+static unsigned int g_use_counter = 0;
+static unsigned int g_num_freed = 0;
+static unsigned int g_num_packed = 0;
+static unsigned int g_num_spilled = 0;
+static size_t g_spilled_memory = 0;
+
+/* memory counted for the buffer, float data or packed half float data */
+static size_t memory_size(MemoryProxy *proxy)
+{
+	if (proxy->getBuffer()->hasData()) {
+		return proxy->getBuffer()->getDataSize();
+	}
+	return proxy->isPacked() ? proxy->getPackedSize() : 0;
+}
+
+static bool use_half(MemoryProxy *proxy)
+{
+	return g_half && proxy->isHalfStorage();
+}
+
+void MemoryBudget::waitUntilIdle(MemoryProxy *proxy)
+{
+	while (proxy->m_busy) {
+		BLI_condition_wait(&g_idle_cond, &g_mutex);
+	}
+}
+
+void MemoryBudget::selectSpillBuffers(size_t size, std::vector<MemoryProxy *> &r_pack,
+                                      std::vector<MemoryProxy *> &r_spill, std::vector<size_t> &r_spill_sizes)
+{
+	while (g_memory + size > g_limit) {
+		MemoryProxy *oldest = NULL;
+		for (unsigned int index = 0; index < g_buffers.size(); index++) {
+			MemoryProxy *proxy = g_buffers[index];
+			if (proxy->m_numPins == 0 && !proxy->m_busy &&
+			    (proxy->getBuffer()->hasData() || proxy->isPacked()) &&
+			    (oldest == NULL || proxy->m_lastUsed < oldest->m_lastUsed))
+			{
+				oldest = proxy;
+			}
+		}
+		if (oldest == NULL) {
+			/* everything in memory is in use, exceed the budget */
+			return;
+		}
+
+		oldest->m_busy = true;
+		if (use_half(oldest) && oldest->getBuffer()->hasData()) {
+			/* packing is much cheaper than writing a file, the packed data is spilled when
+			 * the buffer is the oldest again */
+			g_memory -= oldest->getBuffer()->getDataSize() - oldest->getPackedSize();
+			r_pack.push_back(oldest);
+		}
+		else {
+			const size_t spill_size = memory_size(oldest);
+			g_memory -= spill_size;
+			r_spill.push_back(oldest);
+			r_spill_sizes.push_back(spill_size);
+		}
+	}
+}
+
+void MemoryBudget::freeBuffer(MemoryProxy *proxy)
+{
+	proxy->m_readersFinished = false;
+	waitUntilIdle(proxy);
+
+	MemoryBuffer *buffer = proxy->getBuffer();
+	const size_t size = memory_size(proxy);
+	if (size == 0 && !proxy->isSpilled()) {
+		/* never calculated */
+		return;
+	}
+
+	/* the result would otherwise be written to the cache after the execution */
+	ExecutionGroup *executor = proxy->getExecutor();
+	const bool write_result_cache = (g_result_cache_limit != 0 && executor->getResultCacheKey() != 0 &&
+	                                 !executor->isResultFromCache() && executor->isExecuted());
+
+	proxy->m_busy = true;
+	BLI_mutex_unlock(&g_mutex);
+
+	if (write_result_cache) {
+		if (proxy->isSpilled()) {
+			proxy->restore();
+		}
+		else if (proxy->isPacked()) {
+			proxy->unpack();
+		}
+		ResultCache::write(executor->getResultCacheKey(), buffer, g_result_cache_limit, use_half(proxy));
+	}
+	proxy->freeData();
+
+	BLI_mutex_lock(&g_mutex);
+	g_memory -= size;
+	g_num_freed++;
+	proxy->m_busy = false;
+	BLI_condition_notify_all(&g_idle_cond);
+}
+
+void MemoryBudget::begin(const CompositorContext &context)
+{
+	BLI_mutex_lock(&g_mutex);
+	BLI_condition_init(&g_idle_cond);
+	g_buffers.clear();
+	g_limit = context.getMemoryLimit();
+	g_result_cache_limit = context.isResultCacheEnabled() ? context.getResultCacheLimit() : 0;
+	g_half = context.isHalfBuffersEnabled();
+	g_memory = 0;
+	g_peak_memory = 0;
+	g_use_counter = 0;
+	g_num_freed = 0;
+	g_num_packed = 0;
+	g_num_spilled = 0;
+	g_spilled_memory = 0;
+	BLI_mutex_unlock(&g_mutex);
+}
+
+void MemoryBudget::addBuffer(MemoryProxy *proxy)
+{
+	BLI_mutex_lock(&g_mutex);
+	proxy->m_numReaders = 0;
+	proxy->m_numPins = 0;
+	proxy->m_lastUsed = 0;
+	proxy->m_busy = false;
+	proxy->m_readersFinished = false;
+	g_buffers.push_back(proxy);
+	BLI_mutex_unlock(&g_mutex);
+}
+
+void MemoryBudget::addReader(MemoryProxy *proxy)
+{
+	BLI_mutex_lock(&g_mutex);
+	proxy->m_numReaders++;
+	BLI_mutex_unlock(&g_mutex);
+}
+
+void MemoryBudget::acquire(MemoryProxy *proxy)
+{
+	MemoryBuffer *buffer = proxy->getBuffer();
+	std::vector<MemoryProxy *> pack, spill;
+	std::vector<size_t> spill_sizes;
+
+	BLI_mutex_lock(&g_mutex);
+	proxy->m_numPins++;
+	proxy->m_lastUsed = ++g_use_counter;
+	waitUntilIdle(proxy);
+
+	if (buffer->hasData()) {
+		BLI_mutex_unlock(&g_mutex);
+		return;
+	}
+
+	const size_t size = buffer->getDataSize();
+	const size_t packed_size = proxy->isPacked() ? proxy->getPackedSize() : 0;
+	if (g_limit != 0) {
+		selectSpillBuffers(size - packed_size, pack, spill, spill_sizes);
+	}
+	g_memory += size;
+	if (g_memory > g_peak_memory) {
+		g_peak_memory = g_memory;
+	}
+
+	/* the files are written and read without holding the lock, the buffers involved are
+	 * marked busy so other threads wait for them, and only for them */
+	proxy->m_busy = true;
+	BLI_mutex_unlock(&g_mutex);
+
+	std::vector<bool> packed(pack.size());
+	for (unsigned int index = 0; index < pack.size(); index++) {
+		packed[index] = pack[index]->pack();
+	}
+
+	std::vector<bool> spilled(spill.size());
+	for (unsigned int index = 0; index < spill.size(); index++) {
+		char name[64], filepath[FILE_MAX];
+		BLI_snprintf(name, sizeof(name), "compositor_%p.buf.gz", (void *)spill[index]);
+		BLI_join_dirfile(filepath, sizeof(filepath), BKE_tempdir_session(), name);
+		spilled[index] = spill[index]->spill(filepath, use_half(spill[index]));
+	}
+
+	if (proxy->isPacked()) {
+		proxy->unpack();
+	}
+	else if (proxy->isSpilled()) {
+		proxy->restore();
+	}
+	else {
+		buffer->allocateData();
+	}
+
+	BLI_mutex_lock(&g_mutex);
+	for (unsigned int index = 0; index < pack.size(); index++) {
+		if (packed[index]) {
+			g_num_packed++;
+		}
+		else {
+			g_memory += pack[index]->getBuffer()->getDataSize() - pack[index]->getPackedSize();
+		}
+		pack[index]->m_busy = false;
+	}
+	for (unsigned int index = 0; index < spill.size(); index++) {
+		if (spilled[index]) {
+			const size_t data_size = spill[index]->getBuffer()->getDataSize();
+			g_num_spilled++;
+			g_spilled_memory += spill[index]->m_spillHalf ? data_size / 2 : data_size;
+		}
+		else {
+			g_memory += spill_sizes[index];
+		}
+		spill[index]->m_busy = false;
+	}
+	/* the packed data was freed when unpacking */
+	g_memory -= packed_size;
+	proxy->m_busy = false;
+	BLI_condition_notify_all(&g_idle_cond);
+	BLI_mutex_unlock(&g_mutex);
+}
+
+void MemoryBudget::written(MemoryProxy *proxy)
+{
+	BLI_mutex_lock(&g_mutex);
+	/* chunks reading the buffer are already scheduled when it is pinned, they would unpack it right away */
+	if (!use_half(proxy) || proxy->m_numPins != 0 || proxy->m_numReaders == 0 || proxy->m_busy ||
+	    !proxy->getBuffer()->hasData())
+	{
+		BLI_mutex_unlock(&g_mutex);
+		return;
+	}
+
+	proxy->m_busy = true;
+	BLI_mutex_unlock(&g_mutex);
+
+	const bool packed = proxy->pack();
+
+	BLI_mutex_lock(&g_mutex);
+	if (packed) {
+		g_memory -= proxy->getBuffer()->getDataSize() - proxy->getPackedSize();
+		g_num_packed++;
+	}
+	proxy->m_busy = false;
+	BLI_condition_notify_all(&g_idle_cond);
+	BLI_mutex_unlock(&g_mutex);
+}
+
+void MemoryBudget::release(MemoryProxy *proxy)
+{
+	BLI_mutex_lock(&g_mutex);
+	BLI_assert(proxy->m_numPins > 0);
+	proxy->m_numPins--;
+	if (proxy->m_numPins == 0 && proxy->m_readersFinished) {
+		/* the last reader finished while the buffer was pinned */
+		freeBuffer(proxy);
+	}
+	BLI_mutex_unlock(&g_mutex);
+}
+
+void MemoryBudget::releaseReader(MemoryProxy *proxy)
+{
+	BLI_mutex_lock(&g_mutex);
+	BLI_assert(proxy->m_numReaders > 0);
+	proxy->m_numReaders--;
+	if (proxy->m_numReaders == 0) {
+		proxy->m_readersFinished = true;
+		if (proxy->m_numPins == 0) {
+			freeBuffer(proxy);
+		}
+	}
+	BLI_mutex_unlock(&g_mutex);
+}
+
+void MemoryBudget::end()
+{
+	BLI_mutex_lock(&g_mutex);
+	g_buffers.clear();
+	g_memory = 0;
+	BLI_condition_end(&g_idle_cond);
+	BLI_mutex_unlock(&g_mutex);
+}
+
+void MemoryBudget::getStatistics(size_t *r_peak_memory, unsigned int *r_num_freed, unsigned int *r_num_packed,
+                                 unsigned int *r_num_spilled, size_t *r_spilled_memory)
+{
+	BLI_mutex_lock(&g_mutex);
+	*r_peak_memory = g_peak_memory;
+	*r_num_freed = g_num_freed;
+	*r_num_packed = g_num_packed;
+	*r_num_spilled = g_num_spilled;
+	*r_spilled_memory = g_spilled_memory;
+	BLI_mutex_unlock(&g_mutex);
+}
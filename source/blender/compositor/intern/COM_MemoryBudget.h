@@ -0,0 +1,125 @@
+/*
+ * Copyright 2017, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _COM_MemoryBudget_h_
+#define _COM_MemoryBudget_h_
+
+#include <string.h>
+#include <vector>
+
+class CompositorContext;
+class MemoryProxy;
+
+/**
+ * @brief keeps the memory used by the write buffers of an execution within a budget
+ *
+ * The data of a MemoryProxy is allocated when the first chunk writing or reading it is
+ * scheduled, and freed as soon as the last execution group reading it is finished.
+ * Scheduled chunks pin the buffers they use. When the memory in use exceeds the limit of
+ * the node tree, the least recently used unpinned buffers are written compressed to the
+ * temporary directory and read back when a chunk needs them again.
+ *
+ * When the node tree uses half float buffers, color buffers are stored with half float
+ * precision outside of the chunks using them: a finished buffer nobody reads yet is packed
+ * to half floats in memory, over budget the least recently used color buffers are packed
+ * before anything is spilled, and spill files and ResultCache entries of color buffers
+ * contain half floats. Value and vector buffers keep the full precision.
+ *
+ * Buffers are acquired and released from the main thread and the device threads,
+ * all state is protected by a mutex. Spilling, reading back and writing to the ResultCache
+ * are done without holding it, the buffers are marked busy meanwhile and threads which
+ * need a busy buffer wait for it.
+ * @ingroup Memory
+ */
+class MemoryBudget {
+private:
+	/**
+	 * @brief wait until no other thread reads or writes the data of the buffer, the mutex must be held
+	 */
+	static void waitUntilIdle(MemoryProxy *proxy);
+
+	/**
+	 * @brief select least recently used unpinned buffers to pack or spill until the given amount of memory is available
+	 *
+	 * The selected buffers are marked busy, spilled buffers no longer count as memory in use
+	 * and packed buffers count with their packed size.
+	 */
+	static void selectSpillBuffers(size_t size, std::vector<MemoryProxy *> &r_pack,
+	                               std::vector<MemoryProxy *> &r_spill, std::vector<size_t> &r_spill_sizes);
+
+	/**
+	 * @brief free the data of a buffer without readers and pins, storing it in the ResultCache if needed
+	 *
+	 * The mutex must be held, it is released while writing to the cache.
+	 */
+	static void freeBuffer(MemoryProxy *proxy);
+
+public:
+	/**
+	 * @brief start an execution, resets the statistics
+	 */
+	static void begin(const CompositorContext &context);
+
+	/**
+	 * @brief register a buffer of the execution
+	 */
+	static void addBuffer(MemoryProxy *proxy);
+
+	/**
+	 * @brief register an execution group reading the buffer
+	 */
+	static void addReader(MemoryProxy *proxy);
+
+	/**
+	 * @brief make the data of the buffer available and pin it until release is called
+	 */
+	static void acquire(MemoryProxy *proxy);
+
+	/**
+	 * @brief all chunks of the buffer are calculated, pack it when no chunk reading it is scheduled yet
+	 */
+	static void written(MemoryProxy *proxy);
+
+	/**
+	 * @brief unpin a buffer pinned by acquire
+	 *
+	 * When the last reader finished while the buffer was pinned it is freed now.
+	 */
+	static void release(MemoryProxy *proxy);
+
+	/**
+	 * @brief an execution group reading the buffer is finished
+	 *
+	 * When it was the last reader the result is stored in the ResultCache if needed and
+	 * the data is freed.
+	 */
+	static void releaseReader(MemoryProxy *proxy);
+
+	/**
+	 * @brief end the execution, the remaining buffers are freed by their WriteBufferOperation
+	 */
+	static void end();
+
+	/**
+	 * @brief statistics of the last execution
+	 */
+	static void getStatistics(size_t *r_peak_memory, unsigned int *r_num_freed, unsigned int *r_num_packed,
+	                          unsigned int *r_num_spilled, size_t *r_spilled_memory);
+};
+
+#endif
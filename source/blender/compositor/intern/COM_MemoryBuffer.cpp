@@ -54,7 +54,7 @@ int MemoryBuffer::getHeight() const
 	return this->m_height;
 }
 
-MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, rcti *rect)
+MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, rcti *rect, bool allocate)
 {
 	BLI_rcti_init(&this->m_rect, rect->xmin, rect->xmax, rect->ymin, rect->ymax);
 	this->m_width = BLI_rcti_size_x(&this->m_rect);
@@ -62,7 +62,10 @@ MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, r
 	this->m_memoryProxy = memoryProxy;
 	this->m_chunkNumber = chunkNumber;
 	this->m_num_channels = determine_num_channels(memoryProxy->getDataType());
-	this->m_buffer = (float *)MEM_mallocN_aligned(sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
+	this->m_buffer = NULL;
+	if (allocate) {
+		allocateData();
+	}
 	this->m_state = COM_MB_ALLOCATED;
 	this->m_datatype = memoryProxy->getDataType();
 }
@@ -143,6 +146,18 @@ float MemoryBuffer::getMaximumValue(rcti *rect)
 }
 
 MemoryBuffer::~MemoryBuffer()
+{
+	freeData();
+}
+
+void MemoryBuffer::allocateData()
+{
+	if (this->m_buffer == NULL) {
+		this->m_buffer = (float *)MEM_mallocN_aligned(sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
+	}
+}
+
+void MemoryBuffer::freeData()
 {
 	if (this->m_buffer) {
 		MEM_freeN(this->m_buffer);
@@ -104,8 +104,9 @@ private:
 public:
 	/**
 	 * @brief construct new MemoryBuffer for a chunk
+	 * @param allocate when false the data is allocated later by allocateData
 	 */
-	MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, rcti *rect);
+	MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, rcti *rect, bool allocate = true);
 	
 	/**
 	 * @brief construct new temporarily MemoryBuffer for an area
@@ -134,6 +135,26 @@ public:
 	 * @note buffer should already be available in memory
 	 */
 	float *getBuffer() { return this->m_buffer; }
+
+	/**
+	 * @brief is the data of this MemoryBuffer allocated
+	 */
+	bool hasData() const { return this->m_buffer != NULL; }
+
+	/**
+	 * @brief size of the data of this MemoryBuffer in bytes
+	 */
+	size_t getDataSize() const { return (size_t)this->m_width * this->m_height * this->m_num_channels * sizeof(float); }
+
+	/**
+	 * @brief allocate the data when it is not allocated yet, the contents are undefined
+	 */
+	void allocateData();
+
+	/**
+	 * @brief free the data, the MemoryBuffer keeps its size and can be allocated again
+	 */
+	void freeData();
 	
 	/**
 	 * @brief after execution the state will be set to available by calling this method
@@ -250,6 +271,36 @@ public:
 		memcpy(result, buffer, sizeof(float) * this->m_num_channels);
 	}
 	
+	/**
+	 * @brief read a span of pixels of a row, same as read() for every pixel
+	 * @param result array of length * 4 floats, 4 floats per pixel regardless of the number of channels
+	 */
+	inline void readRow(float *result, int x, int y, int length)
+	{
+		const int num_channels = this->m_num_channels;
+		if (y < m_rect.ymin || y >= m_rect.ymax) {
+			for (int i = 0; i < length; i++) {
+				memset(&result[i * 4], 0, num_channels * sizeof(float));
+			}
+			return;
+		}
+
+		const float *buffer = &this->m_buffer[(this->m_width * y + x) * num_channels];
+		const int xmin = max_ii(x, m_rect.xmin), xmax = min_ii(x + length, m_rect.xmax);
+		if (num_channels == 4 && xmin == x && xmax == x + length) {
+			memcpy(result, buffer, sizeof(float) * 4 * length);
+			return;
+		}
+		for (int i = 0; i < length; i++) {
+			if (x + i < xmin || x + i >= xmax) {
+				memset(&result[i * 4], 0, num_channels * sizeof(float));
+			}
+			else {
+				memcpy(&result[i * 4], &buffer[i * num_channels], num_channels * sizeof(float));
+			}
+		}
+	}
+
 	void writePixel(int x, int y, const float color[4]);
 	void addPixel(int x, int y, const float color[4]);
 	inline void readBilinear(float *result, float x, float y,
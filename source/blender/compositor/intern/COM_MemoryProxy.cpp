@@ -22,12 +22,34 @@
 
 #include "COM_MemoryProxy.h"
 
+#include <zlib.h>
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#  include "BLI_fileops.h"
+#  include "BLI_math_half.h"
+#  include "BLI_string.h"
+}
+
+/* number of floats written at once, gzwrite and gzread take an unsigned int size
+ * and half floats are converted a block at a time */
+#define SPILL_BLOCK_LENGTH (1024 * 1024)
 
 MemoryProxy::MemoryProxy(DataType datatype)
 {
 	this->m_writeBufferOperation = NULL;
 	this->m_executor = NULL;
+	this->m_buffer = NULL;
 	this->m_datatype = datatype;
+	this->m_numReaders = 0;
+	this->m_numPins = 0;
+	this->m_lastUsed = 0;
+	this->m_busy = false;
+	this->m_readersFinished = false;
+	this->m_spillFilepath = NULL;
+	this->m_spillHalf = false;
+	this->m_packedData = NULL;
 }
 
 void MemoryProxy::allocate(unsigned int width, unsigned int height)
@@ -38,14 +60,172 @@ void MemoryProxy::allocate(unsigned int width, unsigned int height)
 	result.ymin = 0;
 	result.ymax = height;
 
-	this->m_buffer = new MemoryBuffer(this, 1, &result);
+	this->m_buffer = new MemoryBuffer(this, 1, &result, false);
 }
 
 void MemoryProxy::free()
 {
+	freeData();
 	if (this->m_buffer) {
 		delete this->m_buffer;
 		this->m_buffer = NULL;
 	}
 }
 
+void MemoryProxy::freeData()
+{
+	if (this->m_buffer) {
+		this->m_buffer->freeData();
+	}
+	if (this->m_packedData) {
+		MEM_freeN(this->m_packedData);
+		this->m_packedData = NULL;
+	}
+	if (this->m_spillFilepath) {
+		BLI_delete(this->m_spillFilepath, false, false);
+		MEM_freeN(this->m_spillFilepath);
+		this->m_spillFilepath = NULL;
+	}
+}
+
+bool MemoryProxy::spill(const char *filepath, bool half)
+{
+	const bool packed = this->isPacked();
+	if (this->m_buffer == NULL || !(this->m_buffer->hasData() || packed) || this->m_spillFilepath) {
+		return false;
+	}
+	if (packed) {
+		half = true;
+	}
+
+	/* compression level 1, buffers are written and read back during a single execution */
+	gzFile file = (gzFile)BLI_gzopen(filepath, "wb1");
+	if (file == NULL) {
+		return false;
+	}
+
+	unsigned short *block = (half && !packed) ? (unsigned short *)MEM_mallocN(sizeof(unsigned short) * SPILL_BLOCK_LENGTH, __func__) : NULL;
+	const float *data = this->m_buffer->getBuffer();
+	const unsigned short *packed_data = this->m_packedData;
+	size_t remaining = this->m_buffer->getDataSize() / sizeof(float);
+	bool ok = true;
+	while (ok && remaining > 0) {
+		const size_t length = remaining < SPILL_BLOCK_LENGTH ? remaining : SPILL_BLOCK_LENGTH;
+		if (packed) {
+			ok = (gzwrite(file, packed_data, (unsigned int)(length * sizeof(unsigned short))) ==
+			      (int)(length * sizeof(unsigned short)));
+			packed_data += length;
+		}
+		else if (half) {
+			BLI_float_to_half_array(block, data, length);
+			ok = (gzwrite(file, block, (unsigned int)(length * sizeof(unsigned short))) ==
+			      (int)(length * sizeof(unsigned short)));
+			data += length;
+		}
+		else {
+			ok = (gzwrite(file, data, (unsigned int)(length * sizeof(float))) == (int)(length * sizeof(float)));
+			data += length;
+		}
+		remaining -= length;
+	}
+	ok = (gzclose(file) == Z_OK) && ok;
+	if (block) {
+		MEM_freeN(block);
+	}
+
+	if (!ok) {
+		BLI_delete(filepath, false, false);
+		return false;
+	}
+
+	this->m_spillFilepath = BLI_strdup(filepath);
+	this->m_spillHalf = half;
+	this->m_buffer->freeData();
+	if (packed) {
+		MEM_freeN(this->m_packedData);
+		this->m_packedData = NULL;
+	}
+	return true;
+}
+
+bool MemoryProxy::pack()
+{
+	if (this->m_buffer == NULL || !this->m_buffer->hasData() || this->m_packedData) {
+		return false;
+	}
+
+	const size_t length = this->m_buffer->getDataSize() / sizeof(float);
+	this->m_packedData = (unsigned short *)MEM_mallocN(sizeof(unsigned short) * length, "MemoryProxy packed");
+	if (this->m_packedData == NULL) {
+		return false;
+	}
+
+	BLI_float_to_half_array(this->m_packedData, this->m_buffer->getBuffer(), length);
+	this->m_buffer->freeData();
+	return true;
+}
+
+size_t MemoryProxy::getPackedSize() const
+{
+	return this->m_buffer->getDataSize() / sizeof(float) * sizeof(unsigned short);
+}
+
+void MemoryProxy::unpack()
+{
+	if (this->m_packedData == NULL) {
+		return;
+	}
+
+	this->m_buffer->allocateData();
+	BLI_half_to_float_array(this->m_buffer->getBuffer(), this->m_packedData,
+	                        this->m_buffer->getDataSize() / sizeof(float));
+
+	MEM_freeN(this->m_packedData);
+	this->m_packedData = NULL;
+}
+
+bool MemoryProxy::restore()
+{
+	if (this->m_spillFilepath == NULL) {
+		return false;
+	}
+
+	this->m_buffer->allocateData();
+
+	bool ok = false;
+	gzFile file = (gzFile)BLI_gzopen(this->m_spillFilepath, "rb");
+	if (file) {
+		const bool half = this->m_spillHalf;
+		unsigned short *block = half ? (unsigned short *)MEM_mallocN(sizeof(unsigned short) * SPILL_BLOCK_LENGTH, __func__) : NULL;
+		float *data = this->m_buffer->getBuffer();
+		size_t remaining = this->m_buffer->getDataSize() / sizeof(float);
+		ok = true;
+		while (ok && remaining > 0) {
+			const size_t length = remaining < SPILL_BLOCK_LENGTH ? remaining : SPILL_BLOCK_LENGTH;
+			if (half) {
+				ok = (gzread(file, block, (unsigned int)(length * sizeof(unsigned short))) ==
+				      (int)(length * sizeof(unsigned short)));
+				BLI_half_to_float_array(data, block, length);
+			}
+			else {
+				ok = (gzread(file, data, (unsigned int)(length * sizeof(float))) == (int)(length * sizeof(float)));
+			}
+			data += length;
+			remaining -= length;
+		}
+		gzclose(file);
+		if (block) {
+			MEM_freeN(block);
+		}
+	}
+
+	if (!ok) {
+		/* the result is lost, better black than undefined memory */
+		this->m_buffer->clear();
+	}
+
+	BLI_delete(this->m_spillFilepath, false, false);
+	MEM_freeN(this->m_spillFilepath);
+	this->m_spillFilepath = NULL;
+	return ok;
+}
@@ -68,6 +68,49 @@ private:
 	 */
 	DataType m_datatype;
 
+	/**
+	 * @brief number of execution groups reading this buffer that are not finished yet
+	 * @see MemoryBudget
+	 */
+	unsigned int m_numReaders;
+
+	/**
+	 * @brief number of scheduled chunks reading or writing this buffer, it can not be spilled while pinned
+	 */
+	unsigned int m_numPins;
+
+	/**
+	 * @brief value of the MemoryBudget use counter when the buffer was last pinned
+	 */
+	unsigned int m_lastUsed;
+
+	/**
+	 * @brief a thread is spilling, reading back or freeing the data without holding the MemoryBudget lock
+	 */
+	bool m_busy;
+
+	/**
+	 * @brief all readers finished, the data is freed once the buffer is not pinned anymore
+	 */
+	bool m_readersFinished;
+
+	/**
+	 * @brief file the data is stored in while it is spilled, NULL when the data is in memory
+	 */
+	char *m_spillFilepath;
+
+	/**
+	 * @brief the spill file contains half floats
+	 */
+	bool m_spillHalf;
+
+	/**
+	 * @brief half float copy of the data while it is packed, NULL when it is not
+	 */
+	unsigned short *m_packedData;
+
+	friend class MemoryBudget;
+
 public:
 	MemoryProxy(DataType type);
 	
@@ -95,15 +138,67 @@ public:
 	WriteBufferOperation *getWriteBufferOperation() { return this->m_writeBufferOperation; }
 
 	/**
-	 * @brief allocate memory of size width x height
+	 * @brief create the buffer of size width x height
+	 * @note the data is allocated by the MemoryBudget when the first chunk using it is scheduled
 	 */
 	void allocate(unsigned int width, unsigned int height);
 
 	/**
-	 * @brief free the allocated memory
+	 * @brief free the allocated memory and the spill file
 	 */
 	void free();
 
+	/**
+	 * @brief free the data and the spill file, the buffer itself is kept for its readers
+	 */
+	void freeData();
+
+	/**
+	 * @brief write the data compressed to a file and free it
+	 * @param half store the data with half float precision, packed data is always stored as half floats
+	 * @return false when the file could not be written, the data is kept in memory then
+	 */
+	bool spill(const char *filepath, bool half);
+
+	/**
+	 * @brief convert the data to half floats in memory and free the float data
+	 * @return false when the half float data could not be allocated, the float data is kept then
+	 */
+	bool pack();
+
+	/**
+	 * @brief allocate the float data again and convert the packed data back
+	 */
+	void unpack();
+
+	/**
+	 * @brief is the data stored as half floats in memory
+	 */
+	bool isPacked() const { return this->m_packedData != NULL; }
+
+	/**
+	 * @brief size of the packed data in bytes
+	 */
+	size_t getPackedSize() const;
+
+	/**
+	 * @brief can the data be stored with half float precision when the node tree uses half float buffers
+	 *
+	 * Colors are, values and vectors often are depths, coordinates or motion vectors which
+	 * need the full precision.
+	 */
+	bool isHalfStorage() const { return this->m_datatype == COM_DT_COLOR; }
+
+	/**
+	 * @brief allocate the data again and read it back from the spill file
+	 */
+	bool restore();
+
+	/**
+	 * @brief is the data stored in a file
+	 */
+	bool isSpilled() const { return this->m_spillFilepath != NULL; }
+
 	/**
 	 * @brief get the allocated memory
 	 */
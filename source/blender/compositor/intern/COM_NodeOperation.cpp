@@ -41,6 +41,9 @@ NodeOperation::NodeOperation()
 	this->m_isResolutionSet = false;
 	this->m_openCL = false;
 	this->m_btree = NULL;
+	this->m_rowExecution = false;
+	this->m_settingsHash = 0;
+	this->m_volatile = false;
 }
 
 NodeOperation::~NodeOperation()
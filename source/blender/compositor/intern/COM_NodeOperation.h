@@ -30,6 +30,7 @@
 extern "C" {
 #include "BLI_math_color.h"
 #include "BLI_math_vector.h"
+#include "BLI_sys_types.h"
 #include "BLI_threads.h"
 }
 
@@ -125,6 +126,24 @@ private:
 	 * @brief set to truth when resolution for this operation is set
 	 */
 	bool m_isResolutionSet;
+
+	/**
+	 * @brief read non-complex inputs a row at a time instead of per pixel
+	 * @see SocketReader.executeRow
+	 */
+	bool m_rowExecution;
+
+	/**
+	 * @brief hash of the node settings and constants this operation was created with
+	 * @see NodeOperationBuilder.addOperation
+	 */
+	uint64_t m_settingsHash;
+
+	/**
+	 * @brief the result depends on data that can change without changing the settings hash
+	 * (masks, movie clips, painted images, ...), it and results using it are never cached.
+	 */
+	bool m_volatile;
 	
 public:
 	virtual ~NodeOperation();
@@ -166,6 +185,12 @@ public:
 	virtual int isSingleThreaded() { return false; }
 
 	void setbNodeTree(const bNodeTree *tree) { this->m_btree = tree; }
+	void setRowExecution(bool rowExecution) { this->m_rowExecution = rowExecution; }
+	bool isRowExecution() const { return this->m_rowExecution; }
+	void setSettingsHash(uint64_t hash) { this->m_settingsHash = hash; }
+	uint64_t getSettingsHash() const { return this->m_settingsHash; }
+	void setVolatile(bool isVolatile) { this->m_volatile = isVolatile; }
+	bool isVolatile() const { return this->m_volatile; }
 	virtual void initExecution();
 	
 	/**
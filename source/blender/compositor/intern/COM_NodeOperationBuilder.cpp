@@ -21,8 +21,22 @@
 
 extern "C" {
 #include "BLI_utildefines.h"
+
+#include "DNA_image_types.h"
+
+#include "BKE_global.h"
+#include "BKE_image.h"
+#include "BKE_node.h"
+
+#include "IMB_imbuf_types.h"
+
+#include "RE_pipeline.h"
+
+#include "RNA_access.h"
 }
 
+#include "MEM_guardedalloc.h"
+
 #include "COM_NodeConverter.h"
 #include "COM_Converter.h"
 #include "COM_Debug.h"
@@ -39,12 +53,15 @@ extern "C" {
 #include "COM_ReadBufferOperation.h"
 #include "COM_WriteBufferOperation.h"
 #include "COM_ViewerOperation.h"
+#include "COM_ResultCache.h"
 
 #include "COM_NodeOperationBuilder.h" /* own include */
 
 NodeOperationBuilder::NodeOperationBuilder(const CompositorContext *context, bNodeTree *b_nodetree) :
     m_context(context),
     m_current_node(NULL),
+    m_current_node_hash(0),
+    m_current_node_volatile(false),
     m_active_viewer(NULL)
 {
 	m_graph.from_bNodeTree(*context, b_nodetree);
@@ -54,6 +71,202 @@ NodeOperationBuilder::~NodeOperationBuilder()
 {
 }
 
+/**
+ * Hash the values of the RNA properties of a struct, instead of its memory which also has
+ * pointers and padding. Properties also found in \a skip_type are ignored, IDs are hashed
+ * by name and other structs are followed up to a few levels deep.
+ */
+static void rna_struct_hash(ResultHash &hash, PointerRNA *ptr, StructRNA *skip_type, int depth)
+{
+	RNA_STRUCT_BEGIN (ptr, prop)
+	{
+		const char *identifier = RNA_property_identifier(prop);
+		if (STREQ(identifier, "rna_type") ||
+		    (skip_type && RNA_struct_type_find_property(skip_type, identifier)))
+		{
+			continue;
+		}
+
+		const int len = RNA_property_array_length(ptr, prop);
+		switch (RNA_property_type(prop)) {
+			case PROP_BOOLEAN:
+			case PROP_INT:
+			{
+				std::vector<int> values((len > 0) ? len : 1);
+				if (len == 0) {
+					values[0] = (RNA_property_type(prop) == PROP_BOOLEAN) ?
+					            RNA_property_boolean_get(ptr, prop) : RNA_property_int_get(ptr, prop);
+				}
+				else if (RNA_property_type(prop) == PROP_BOOLEAN) {
+					RNA_property_boolean_get_array(ptr, prop, &values[0]);
+				}
+				else {
+					RNA_property_int_get_array(ptr, prop, &values[0]);
+				}
+				hash.add(&values[0], sizeof(int) * values.size());
+				break;
+			}
+			case PROP_FLOAT:
+			{
+				std::vector<float> values((len > 0) ? len : 1);
+				if (len == 0) {
+					values[0] = RNA_property_float_get(ptr, prop);
+				}
+				else {
+					RNA_property_float_get_array(ptr, prop, &values[0]);
+				}
+				hash.add(&values[0], sizeof(float) * values.size());
+				break;
+			}
+			case PROP_ENUM:
+				hash.add((uint64_t)RNA_property_enum_get(ptr, prop));
+				break;
+			case PROP_STRING:
+			{
+				char fixedbuf[256];
+				int str_len;
+				char *str = RNA_property_string_get_alloc(ptr, prop, fixedbuf, sizeof(fixedbuf), &str_len);
+				hash.add(str, str_len);
+				if (str != fixedbuf) {
+					MEM_freeN(str);
+				}
+				break;
+			}
+			case PROP_POINTER:
+			{
+				PointerRNA value = RNA_property_pointer_get(ptr, prop);
+				if (value.data == NULL) {
+					hash.add((uint64_t)0);
+				}
+				else if (RNA_struct_is_ID(value.type)) {
+					hash.add(((ID *)value.data)->name);
+				}
+				else if (depth < 3) {
+					rna_struct_hash(hash, &value, NULL, depth + 1);
+				}
+				break;
+			}
+			case PROP_COLLECTION:
+			{
+				if (depth < 3) {
+					RNA_PROP_BEGIN (ptr, itemptr, prop)
+					{
+						rna_struct_hash(hash, &itemptr, NULL, depth + 1);
+					}
+					RNA_PROP_END;
+				}
+				hash.add((uint64_t)RNA_property_collection_length(ptr, prop));
+				break;
+			}
+		}
+	}
+	RNA_STRUCT_END;
+}
+
+/* The render result only changes when rendering again, which sets new render times. */
+static bool render_result_hash(ResultHash &hash, const Scene *scene)
+{
+	if (G.is_rendering) {
+		/* result of the render in progress still changes */
+		return false;
+	}
+
+	Render *re = RE_GetSceneRender(scene);
+	if (re) {
+		RenderStats *stats = RE_GetStats(re);
+		hash.add(&stats->starttime, sizeof(stats->starttime));
+		hash.add(&stats->lastframetime, sizeof(stats->lastframetime));
+	}
+	return true;
+}
+
+/* Images are identified by their loaded buffer, reloading creates a new buffer,
+ * painting and saving bump its generation. */
+static bool image_hash(ResultHash &hash, const CompositorContext &context, Image *image, const ImageUser *image_user)
+{
+	if (!ELEM(image->type, IMA_TYPE_IMAGE, IMA_TYPE_UV_TEST) || BKE_image_is_multiview(image)) {
+		return false;
+	}
+
+	ImageUser iuser = *image_user;
+	BKE_image_user_frame_calc(&iuser, context.getFramenumber(), 0);
+
+	bool is_volatile = false;
+	ImBuf *ibuf = BKE_image_acquire_ibuf(image, &iuser, NULL);
+	if (ibuf) {
+		/* not every operation modifying the pixels of an unsaved buffer bumps the generation */
+		is_volatile = (ibuf->userflags & IB_BITMAPDIRTY) != 0;
+		hash.add(ibuf->uid);
+		hash.add(ibuf->generation);
+	}
+	BKE_image_release_ibuf(image, ibuf, NULL);
+
+	return !is_volatile;
+}
+
+/**
+ * Hash of the settings of a node, used to identify results in the ResultCache.
+ * Returns false when the node reads data that can change without changing the hash.
+ */
+static bool node_settings_hash(const CompositorContext &context, Node *node, uint64_t *r_hash)
+{
+	ResultHash hash;
+	bNode *bnode = node->getbNode();
+
+	*r_hash = 0;
+	if (bnode == NULL) {
+		return true;
+	}
+
+	hash.add(bnode->type);
+	hash.add(&bnode->custom1, sizeof(bnode->custom1));
+	hash.add(&bnode->custom2, sizeof(bnode->custom2));
+	hash.add(&bnode->custom3, sizeof(bnode->custom3));
+	hash.add(&bnode->custom4, sizeof(bnode->custom4));
+	if (bnode->id) {
+		hash.add(bnode->id->name);
+	}
+
+	/* settings of the node type, mostly in its storage */
+	PointerRNA ptr;
+	RNA_pointer_create((ID *)node->getbNodeTree(), &RNA_Node, bnode, &ptr);
+	rna_struct_hash(hash, &ptr, &RNA_Node, 0);
+
+	for (bNodeSocket *sock = (bNodeSocket *)bnode->inputs.first; sock; sock = sock->next) {
+		if (sock->default_value) {
+			hash.add(sock->default_value, MEM_allocN_len(sock->default_value));
+		}
+	}
+	/* value and color input nodes store their value in the output */
+	for (bNodeSocket *sock = (bNodeSocket *)bnode->outputs.first; sock; sock = sock->next) {
+		if (sock->default_value) {
+			hash.add(sock->default_value, MEM_allocN_len(sock->default_value));
+		}
+	}
+
+	bool is_volatile = false;
+	if (bnode->type == CMP_NODE_R_LAYERS) {
+		Scene *scene = bnode->id ? (Scene *)bnode->id : context.getScene();
+		is_volatile = !render_result_hash(hash, scene);
+	}
+	else if (bnode->type == CMP_NODE_IMAGE) {
+		if (bnode->id) {
+			is_volatile = !image_hash(hash, context, (Image *)bnode->id, (ImageUser *)bnode->storage);
+		}
+	}
+	else if (bnode->type == CMP_NODE_DEFOCUS) {
+		/* reads the scene camera */
+		is_volatile = true;
+	}
+	else if (bnode->id) {
+		/* masks, movie clips, textures, ... */
+		is_volatile = true;
+	}
+
+	*r_hash = hash.get();
+	return !is_volatile;
+}
+
 void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 {
 	/* interface handle for nodes */
@@ -63,6 +276,9 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 		Node *node = (Node *)m_graph.nodes()[index];
 		
 		m_current_node = node;
+		if (m_context->isResultCacheEnabled()) {
+			m_current_node_volatile = !node_settings_hash(*m_context, node, &m_current_node_hash);
+		}
 		
 		DebugInfo::node_to_operations(node);
 		node->convertToOperations(converter, *m_context);
@@ -131,6 +347,11 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 void NodeOperationBuilder::addOperation(NodeOperation *operation)
 {
 	m_operations.push_back(operation);
+
+	if (m_current_node) {
+		operation->setSettingsHash(m_current_node_hash);
+		operation->setVolatile(m_current_node_volatile);
+	}
 }
 
 void NodeOperationBuilder::mapInputSocket(NodeInput *node_socket, NodeOperationInput *operation_socket)
@@ -313,6 +534,13 @@ void NodeOperationBuilder::add_operation_input_constants()
 	}
 }
 
+static uint64_t constant_value_hash(const void *value, size_t size)
+{
+	ResultHash hash;
+	hash.add(value, size);
+	return hash.get();
+}
+
 void NodeOperationBuilder::add_input_constant_value(NodeOperationInput *input, NodeInput *node_input)
 {
 	switch (input->getDataType()) {
@@ -325,6 +553,7 @@ void NodeOperationBuilder::add_input_constant_value(NodeOperationInput *input, N
 			
 			SetValueOperation *op = new SetValueOperation();
 			op->setValue(value);
+			op->setSettingsHash(constant_value_hash(&value, sizeof(value)));
 			addOperation(op);
 			addLink(op->getOutputSocket(), input);
 			break;
@@ -338,6 +567,7 @@ void NodeOperationBuilder::add_input_constant_value(NodeOperationInput *input, N
 			
 			SetColorOperation *op = new SetColorOperation();
 			op->setChannels(value);
+			op->setSettingsHash(constant_value_hash(&value, sizeof(value)));
 			addOperation(op);
 			addLink(op->getOutputSocket(), input);
 			break;
@@ -351,6 +581,7 @@ void NodeOperationBuilder::add_input_constant_value(NodeOperationInput *input, N
 			
 			SetVectorOperation *op = new SetVectorOperation();
 			op->setVector(value);
+			op->setSettingsHash(constant_value_hash(&value, sizeof(value)));
 			addOperation(op);
 			addLink(op->getOutputSocket(), input);
 			break;
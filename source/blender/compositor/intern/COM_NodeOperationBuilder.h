@@ -26,6 +26,10 @@
 #include <set>
 #include <vector>
 
+extern "C" {
+#include "BLI_sys_types.h"
+}
+
 #include "COM_NodeGraph.h"
 
 using std::vector;
@@ -87,6 +91,10 @@ private:
 	OutputSocketMap m_output_map;
 	
 	Node *m_current_node;
+	/** Settings hash of the current node, given to the operations it adds */
+	uint64_t m_current_node_hash;
+	/** The current node reads data that can change without changing its settings */
+	bool m_current_node_volatile;
 	
 	/** Operation that will be writing to the viewer image
 	 *  Only one operation can occupy this place at a time,
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2017, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <map>
+
+#include "COM_ResultCache.h"
+#include "COM_MemoryBuffer.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#  include "BLI_math_half.h"
+#  include "BLI_threads.h"
+}
+
+/* readers copy the data without holding the lock, an entry removed meanwhile
+ * leaves its data to the last reader to free */
+typedef struct ResultCacheData {
+	/* float or half float data */
+	void *buffer;
+	bool half;
+	size_t size;
+	unsigned int num_readers;
+	bool removed;
+} ResultCacheData;
+
+typedef struct ResultCacheEntry {
+	ResultCacheData *data;
+	int width, height;
+	unsigned int num_channels;
+	/* value of the use counter when the result was last written or read */
+	unsigned int last_used;
+} ResultCacheEntry;
+
+typedef std::map<uint64_t, ResultCacheEntry> ResultCacheEntries;
+
+static ThreadMutex g_mutex = BLI_MUTEX_INITIALIZER;
+static ResultCacheEntries g_entries;
+static size_t g_memory = 0;
+static unsigned int g_use_counter = 0;
+static unsigned int g_hits = 0;
+static unsigned int g_misses = 0;
+
+static size_t buffer_length(MemoryBuffer *buffer)
+{
+	return (size_t)buffer->getWidth() * buffer->getHeight() * buffer->get_num_channels();
+}
+
+static void free_data(ResultCacheData *data)
+{
+	MEM_freeN(data->buffer);
+	MEM_freeN(data);
+}
+
+static void remove_entry(ResultCacheEntries::iterator it)
+{
+	ResultCacheData *data = it->second.data;
+	g_memory -= data->size;
+	if (data->num_readers == 0) {
+		free_data(data);
+	}
+	else {
+		data->removed = true;
+	}
+	g_entries.erase(it);
+}
+
+/* remove least recently used results until the given amount of memory is available */
+static void free_memory(size_t size, size_t limit)
+{
+	while (!g_entries.empty() && g_memory + size > limit) {
+		ResultCacheEntries::iterator oldest = g_entries.begin();
+		for (ResultCacheEntries::iterator it = g_entries.begin(); it != g_entries.end(); ++it) {
+			if (it->second.last_used < oldest->second.last_used) {
+				oldest = it;
+			}
+		}
+		remove_entry(oldest);
+	}
+}
+
+bool ResultCache::read(uint64_t key, MemoryBuffer *buffer)
+{
+	BLI_mutex_lock(&g_mutex);
+	ResultCacheEntries::iterator it = g_entries.find(key);
+	if (it == g_entries.end()) {
+		g_misses++;
+		BLI_mutex_unlock(&g_mutex);
+		return false;
+	}
+
+	ResultCacheEntry &entry = it->second;
+	if (entry.width != buffer->getWidth() ||
+	    entry.height != buffer->getHeight() ||
+	    entry.num_channels != buffer->get_num_channels())
+	{
+		/* the hash includes the resolution, this only happens on hash collisions */
+		remove_entry(it);
+		g_misses++;
+		BLI_mutex_unlock(&g_mutex);
+		return false;
+	}
+
+	ResultCacheData *data = entry.data;
+	data->num_readers++;
+	entry.last_used = ++g_use_counter;
+	g_hits++;
+	BLI_mutex_unlock(&g_mutex);
+
+	/* copied without the lock, like in write, other threads only wait for the lookup */
+	if (data->half) {
+		BLI_half_to_float_array(buffer->getBuffer(), (unsigned short *)data->buffer, buffer_length(buffer));
+	}
+	else {
+		memcpy(buffer->getBuffer(), data->buffer, data->size);
+	}
+
+	BLI_mutex_lock(&g_mutex);
+	data->num_readers--;
+	if (data->num_readers == 0 && data->removed) {
+		free_data(data);
+	}
+	BLI_mutex_unlock(&g_mutex);
+	return true;
+}
+
+void ResultCache::write(uint64_t key, MemoryBuffer *buffer, size_t limit, bool half)
+{
+	const size_t size = buffer_length(buffer) * (half ? sizeof(unsigned short) : sizeof(float));
+
+	ResultCacheData *data = NULL;
+	if (size <= limit) {
+		/* copied before locking, the conversion of a large buffer takes a while */
+		void *data_buffer = MEM_mallocN(size, "ResultCacheEntry");
+		if (data_buffer == NULL) {
+			return;
+		}
+		if (half) {
+			BLI_float_to_half_array((unsigned short *)data_buffer, buffer->getBuffer(), buffer_length(buffer));
+		}
+		else {
+			memcpy(data_buffer, buffer->getBuffer(), size);
+		}
+		data = (ResultCacheData *)MEM_callocN(sizeof(ResultCacheData), "ResultCacheData");
+		data->buffer = data_buffer;
+		data->half = half;
+		data->size = size;
+	}
+
+	BLI_mutex_lock(&g_mutex);
+	ResultCacheEntries::iterator it = g_entries.find(key);
+	if (it != g_entries.end()) {
+		remove_entry(it);
+	}
+
+	if (data == NULL) {
+		BLI_mutex_unlock(&g_mutex);
+		return;
+	}
+
+	free_memory(size, limit);
+
+	ResultCacheEntry &entry = g_entries[key];
+	entry.data = data;
+	entry.width = buffer->getWidth();
+	entry.height = buffer->getHeight();
+	entry.num_channels = buffer->get_num_channels();
+	entry.last_used = ++g_use_counter;
+	g_memory += size;
+	BLI_mutex_unlock(&g_mutex);
+}
+
+void ResultCache::clear()
+{
+	BLI_mutex_lock(&g_mutex);
+	while (!g_entries.empty()) {
+		remove_entry(g_entries.begin());
+	}
+	BLI_mutex_unlock(&g_mutex);
+}
+
+void ResultCache::getStatistics(unsigned int *r_hits, unsigned int *r_misses,
+                                unsigned int *r_num_results, size_t *r_memory)
+{
+	BLI_mutex_lock(&g_mutex);
+	*r_hits = g_hits;
+	*r_misses = g_misses;
+	*r_num_results = (unsigned int)g_entries.size();
+	*r_memory = g_memory;
+	BLI_mutex_unlock(&g_mutex);
+}
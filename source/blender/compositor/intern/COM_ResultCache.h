@@ -0,0 +1,94 @@
+/*
+ * Copyright 2017, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _COM_ResultCache_h_
+#define _COM_ResultCache_h_
+
+#include <string.h>
+
+extern "C" {
+#  include "BLI_sys_types.h"
+}
+
+class MemoryBuffer;
+
+/**
+ * @brief 64 bit FNV-1a hash, identifies the result of an operation
+ * @ingroup Memory
+ */
+class ResultHash {
+private:
+	uint64_t m_hash;
+
+public:
+	ResultHash() : m_hash(14695981039346656037ULL) {}
+
+	void add(const void *data, size_t size) {
+		const unsigned char *bytes = (const unsigned char *)data;
+		for (size_t i = 0; i < size; i++) {
+			this->m_hash ^= bytes[i];
+			this->m_hash *= 1099511628211ULL;
+		}
+	}
+	void add(uint64_t value) { add(&value, sizeof(value)); }
+	void add(const char *str) { add(str, strlen(str)); }
+
+	uint64_t get() const { return this->m_hash; }
+};
+
+/**
+ * @brief cache of write buffer results between executions
+ *
+ * Results are keyed on the hash of the operation subtree that calculated them
+ * (see ExecutionSystem.determineResultHash), so an execution group whose
+ * subtree did not change since an earlier execution copies the cached buffer
+ * instead of calculating it again. Least recently used results are removed
+ * when the cache exceeds its memory limit.
+ *
+ * Results are written from the device threads when the MemoryBudget frees a
+ * buffer early, so access to the cache is protected by a mutex.
+ * @ingroup Memory
+ */
+class ResultCache {
+public:
+	/**
+	 * @brief copy a cached result into the buffer
+	 * @return true when the result was found, false when it needs to be calculated
+	 */
+	static bool read(uint64_t key, MemoryBuffer *buffer);
+
+	/**
+	 * @brief store a copy of a calculated result
+	 * @param limit memory limit of the cache in bytes
+	 * @param half store the result with half float precision
+	 */
+	static void write(uint64_t key, MemoryBuffer *buffer, size_t limit, bool half);
+
+	/**
+	 * @brief free all cached results
+	 */
+	static void clear();
+
+	/**
+	 * @brief statistics since the cache was created
+	 */
+	static void getStatistics(unsigned int *r_hits, unsigned int *r_misses,
+	                          unsigned int *r_num_results, size_t *r_memory);
+};
+
+#endif
@@ -95,13 +95,52 @@ protected:
 	                                  float /*x*/, float /*y*/,
 	                                  float /*dx*/[2], float /*dy*/[2]) {}
 
+	/**
+	 * @brief calculate a span of pixels of a row, nearest sampled
+	 * @note this method is called for non-complex operations when row execution is enabled.
+	 * Operations that can calculate many pixels at once without virtual calls per pixel
+	 * override this; the default falls back to executePixelSampled for every pixel.
+	 * @param output array of length * 4 floats, 4 floats per pixel regardless of the datatype
+	 * @param x the x-coordinate of the first pixel in image space
+	 * @param y the y-coordinate of the row in image space
+	 * @param length number of pixels, at most COM_ROW_SPAN
+	 */
+	virtual void executeRow(float *output, int x, int y, int length) {
+		for (int i = 0; i < length; i++) {
+			executePixelSampled(&output[i * 4], x + i, y, COM_PS_NEAREST);
+		}
+	}
+
+	/**
+	 * @brief calculate a span of pixels of a row
+	 * @note this method is called for complex operations when row execution is enabled.
+	 * Operations with a kernel that can be shared between neighboring pixels override this;
+	 * the default falls back to executePixel for every pixel.
+	 * @param output array of length * 4 floats, 4 floats per pixel regardless of the datatype
+	 * @param x the x-coordinate of the first pixel in image space
+	 * @param y the y-coordinate of the row in image space
+	 * @param length number of pixels, at most COM_ROW_SPAN
+	 * @param chunkData chunk specific data a during execution time.
+	 */
+	virtual void executeTileRow(float *output, int x, int y, int length, void *chunkData) {
+		for (int i = 0; i < length; i++) {
+			executePixel(&output[i * 4], x + i, y, chunkData);
+		}
+	}
+
 public:
 	inline void readSampled(float result[4], float x, float y, PixelSampler sampler) {
 		executePixelSampled(result, x, y, sampler);
 	}
+	inline void readRow(float *result, int x, int y, int length) {
+		executeRow(result, x, y, length);
+	}
 	inline void read(float result[4], int x, int y, void *chunkData) {
 		executePixel(result, x, y, chunkData);
 	}
+	inline void readTileRow(float *result, int x, int y, int length, void *chunkData) {
+		executeTileRow(result, x, y, length, chunkData);
+	}
 	inline void readFiltered(float result[4], float x, float y, float dx[2], float dy[2]) {
 		executePixelFiltered(result, x, y, dx, dy);
 	}
@@ -73,9 +73,25 @@ static bool g_openclActive = false;
 static bool g_openclInitialized = false;
 #endif
 #endif
+
+/// @brief number of scheduled work packages that are not finished yet
+static int g_num_scheduled = 0;
+static ThreadMutex g_scheduled_mutex = BLI_MUTEX_INITIALIZER;
+/// @brief signaled when the last scheduled work package is finished
+static ThreadCondition g_scheduled_cond;
 #endif
 
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+static void work_finished()
+{
+	BLI_mutex_lock(&g_scheduled_mutex);
+	g_num_scheduled--;
+	if (g_num_scheduled == 0) {
+		BLI_condition_notify_all(&g_scheduled_cond);
+	}
+	BLI_mutex_unlock(&g_scheduled_mutex);
+}
+
 void *WorkScheduler::thread_execute_cpu(void *data)
 {
 	CPUDevice *device = (CPUDevice *)data;
@@ -84,6 +100,7 @@ void *WorkScheduler::thread_execute_cpu(void *data)
 	while ((work = (WorkPackage *)BLI_thread_queue_pop(g_cpuqueue))) {
 		device->execute(work);
 		delete work;
+		work_finished();
 	}
 	
 	return NULL;
@@ -97,6 +114,7 @@ void *WorkScheduler::thread_execute_gpu(void *data)
 	while ((work = (WorkPackage *)BLI_thread_queue_pop(g_gpuqueue))) {
 		device->execute(work);
 		delete work;
+		work_finished();
 	}
 	
 	return NULL;
@@ -113,6 +131,9 @@ void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber)
 	device.execute(package);
 	delete package;
 #elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+	BLI_mutex_lock(&g_scheduled_mutex);
+	g_num_scheduled++;
+	BLI_mutex_unlock(&g_scheduled_mutex);
 #ifdef COM_OPENCL_ENABLED
 	if (group->isOpenCL() && g_openclActive) {
 		BLI_thread_queue_push(g_gpuqueue, package);
@@ -130,6 +151,8 @@ void WorkScheduler::start(CompositorContext &context)
 {
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
 	unsigned int index;
+	g_num_scheduled = 0;
+	BLI_condition_init(&g_scheduled_cond);
 	g_cpuqueue = BLI_thread_queue_init();
 	BLI_threadpool_init(&g_cputhreads, thread_execute_cpu, g_cpudevices.size());
 	for (index = 0; index < g_cpudevices.size(); index++) {
@@ -155,17 +178,13 @@ void WorkScheduler::start(CompositorContext &context)
 void WorkScheduler::finish()
 {
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-#ifdef COM_OPENCL_ENABLED
-	if (g_openclActive) {
-		BLI_thread_queue_wait_finish(g_gpuqueue);
-		BLI_thread_queue_wait_finish(g_cpuqueue);
-	}
-	else {
-		BLI_thread_queue_wait_finish(g_cpuqueue);
+	/* finished work packages can schedule new ones, so waiting for the queues to be empty
+	 * is not enough: wait until no work package is queued or being executed */
+	BLI_mutex_lock(&g_scheduled_mutex);
+	while (g_num_scheduled > 0) {
+		BLI_condition_wait(&g_scheduled_cond, &g_scheduled_mutex);
 	}
-#else
-	BLI_thread_queue_wait_finish(cpuqueue);
-#endif
+	BLI_mutex_unlock(&g_scheduled_mutex);
 #endif
 }
 void WorkScheduler::stop()
@@ -175,6 +194,7 @@ void WorkScheduler::stop()
 	BLI_threadpool_end(&g_cputhreads);
 	BLI_thread_queue_free(g_cpuqueue);
 	g_cpuqueue = NULL;
+	BLI_condition_end(&g_scheduled_cond);
 #ifdef COM_OPENCL_ENABLED
 	if (g_openclActive) {
 		BLI_thread_queue_nowait(g_gpuqueue);
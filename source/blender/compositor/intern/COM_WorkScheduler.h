@@ -60,6 +60,7 @@ public:
 	 * An execution group schedules a chunk in the WorkScheduler
 	 * when ExecutionGroup.isOpenCL is set the work will be handled by a OpenCLDevice
 	 * otherwise the work is scheduled for an CPUDevice
+	 * @note can be called from the device threads
 	 * @see ExecutionGroup.execute
 	 * @param group the execution group
 	 * @param chunkNumber the number of the chunk in the group to be executed
@@ -102,6 +103,7 @@ public:
 
 	/**
 	 * @brief wait for all work to be completed.
+	 * This includes work that is scheduled by finished work, while waiting.
 	 */
 	static void finish();
 
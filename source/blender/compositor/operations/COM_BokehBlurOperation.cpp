@@ -23,6 +23,7 @@
 #include "COM_BokehBlurOperation.h"
 #include "BLI_math.h"
 #include "COM_OpenCLDevice.h"
+#include "MEM_guardedalloc.h"
 
 extern "C" {
 #  include "RE_pipeline.h"
@@ -45,6 +46,8 @@ BokehBlurOperation::BokehBlurOperation() : NodeOperation()
 	this->m_inputBoundingBoxReader = NULL;
 
 	this->m_extend_bounds = false;
+	this->m_bokehKernel = NULL;
+	this->m_bokehKernelRadius = 0;
 }
 
 void *BokehBlurOperation::initializeTileData(rcti * /*rect*/)
@@ -53,6 +56,9 @@ void *BokehBlurOperation::initializeTileData(rcti * /*rect*/)
 	if (!this->m_sizeavailable) {
 		updateSize();
 	}
+	if (this->m_bokehKernel == NULL) {
+		updateBokehKernel();
+	}
 	void *buffer = getInputOperation(0)->initializeTileData(NULL);
 	unlockMutex();
 	return buffer;
@@ -76,6 +82,34 @@ void BokehBlurOperation::initExecution()
 	QualityStepHelper::initExecution(COM_QH_INCREASE);
 }
 
+/* kernels larger than this (in pixels) sample the bokeh image for every pixel */
+#define BOKEH_KERNEL_MAX_SIZE (2048 * 2048)
+
+void BokehBlurOperation::updateBokehKernel()
+{
+	const float max_dim = max(this->getWidth(), this->getHeight());
+	const int pixelSize = this->m_size * max_dim / 100.0f;
+	const int size = 2 * pixelSize;
+
+	if (size <= 0 || size * size > BOKEH_KERNEL_MAX_SIZE) {
+		return;
+	}
+
+	float *kernel = (float *)MEM_mallocN_aligned(sizeof(float) * 4 * size * size, 16, "bokeh kernel");
+	const float m = this->m_bokehDimension / pixelSize;
+	for (int dy = -pixelSize; dy < pixelSize; dy++) {
+		float *kernel_row = &kernel[(dy + pixelSize) * size * 4];
+		for (int dx = -pixelSize; dx < pixelSize; dx++) {
+			float u = this->m_bokehMidX - dx * m;
+			float v = this->m_bokehMidY - dy * m;
+			this->m_inputBokehProgram->readSampled(&kernel_row[(dx + pixelSize) * 4], u, v, COM_PS_NEAREST);
+		}
+	}
+
+	this->m_bokehKernelRadius = pixelSize;
+	this->m_bokehKernel = kernel;
+}
+
 void BokehBlurOperation::executePixel(float output[4], int x, int y, void *data)
 {
 	float color_accum[4];
@@ -115,6 +149,40 @@ void BokehBlurOperation::executePixel(float output[4], int x, int y, void *data)
 		int offsetadd = getOffsetAdd() * COM_NUM_CHANNELS_COLOR;
 
 		float m = this->m_bokehDimension / pixelSize;
+		if (this->m_bokehKernel && this->m_bokehKernelRadius == pixelSize) {
+			const int kernel_size = 2 * pixelSize;
+#ifdef __SSE2__
+			__m128 color_accum_r = _mm_loadu_ps(color_accum);
+			__m128 multiplier_accum_r = _mm_loadu_ps(multiplier_accum);
+#endif
+			for (int ny = miny; ny < maxy; ny += step) {
+				int bufferindex = ((minx - bufferstartx) * COM_NUM_CHANNELS_COLOR) + ((ny - bufferstarty) * COM_NUM_CHANNELS_COLOR * bufferwidth);
+				const float *kernel = &this->m_bokehKernel[((ny - y + pixelSize) * kernel_size + (minx - x + pixelSize)) * 4];
+				const int kerneladd = step * 4;
+				for (int nx = minx; nx < maxx; nx += step) {
+#ifdef __SSE2__
+					const __m128 bokeh_r = _mm_load_ps(kernel);
+					color_accum_r = _mm_add_ps(color_accum_r, _mm_mul_ps(bokeh_r, _mm_load_ps(&buffer[bufferindex])));
+					multiplier_accum_r = _mm_add_ps(multiplier_accum_r, bokeh_r);
+#else
+					madd_v4_v4v4(color_accum, kernel, &buffer[bufferindex]);
+					add_v4_v4(multiplier_accum, kernel);
+#endif
+					bufferindex += offsetadd;
+					kernel += kerneladd;
+				}
+			}
+#ifdef __SSE2__
+			_mm_storeu_ps(output, _mm_mul_ps(color_accum_r, _mm_div_ps(_mm_set1_ps(1.0f), multiplier_accum_r)));
+#else
+			output[0] = color_accum[0] * (1.0f / multiplier_accum[0]);
+			output[1] = color_accum[1] * (1.0f / multiplier_accum[1]);
+			output[2] = color_accum[2] * (1.0f / multiplier_accum[2]);
+			output[3] = color_accum[3] * (1.0f / multiplier_accum[3]);
+#endif
+			return;
+		}
+
 		for (int ny = miny; ny < maxy; ny += step) {
 			int bufferindex = ((minx - bufferstartx) * COM_NUM_CHANNELS_COLOR) + ((ny - bufferstarty) * COM_NUM_CHANNELS_COLOR * bufferwidth);
 			for (int nx = minx; nx < maxx; nx += step) {
@@ -139,6 +207,10 @@ void BokehBlurOperation::executePixel(float output[4], int x, int y, void *data)
 void BokehBlurOperation::deinitExecution()
 {
 	deinitMutex();
+	if (this->m_bokehKernel) {
+		MEM_freeN(this->m_bokehKernel);
+		this->m_bokehKernel = NULL;
+	}
 	this->m_inputProgram = NULL;
 	this->m_inputBokehProgram = NULL;
 	this->m_inputBoundingBoxReader = NULL;
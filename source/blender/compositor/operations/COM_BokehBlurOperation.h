@@ -38,6 +38,14 @@ private:
 	float m_bokehMidY;
 	float m_bokehDimension;
 	bool m_extend_bounds;
+
+	/**
+	 * @brief bokeh samples for every offset of the kernel, RGBA per offset
+	 * The bokeh image is sampled at the same positions for every pixel, so it's sampled once.
+	 */
+	float *m_bokehKernel;
+	int m_bokehKernelRadius;
+	void updateBokehKernel();
 public:
 	BokehBlurOperation();
 
@@ -188,6 +188,37 @@ void CompositorOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
 	}
 #endif
 
+	if (this->isRowExecution()) {
+		float color_row[COM_ROW_SPAN * COM_NUM_CHANNELS_COLOR];
+		float alpha_row[COM_ROW_SPAN * COM_NUM_CHANNELS_COLOR];
+		float depth_row[COM_ROW_SPAN * COM_NUM_CHANNELS_COLOR];
+
+		for (y = y1; y < y2 && (!breaked); y++) {
+			for (x = x1; x < x2; x += COM_ROW_SPAN) {
+				const int length = min(COM_ROW_SPAN, x2 - x);
+				const int pixel = y * this->getWidth() + x;
+
+				this->m_imageInput->readRow(color_row, x + dx, y + dy, length);
+				if (this->m_useAlphaInput) {
+					this->m_alphaInput->readRow(alpha_row, x + dx, y + dy, length);
+					for (int i = 0; i < length; i++) {
+						color_row[i * 4 + 3] = alpha_row[i * 4];
+					}
+				}
+				memcpy(&buffer[pixel * COM_NUM_CHANNELS_COLOR], color_row, sizeof(float) * length * COM_NUM_CHANNELS_COLOR);
+
+				this->m_depthInput->readRow(depth_row, x + dx, y + dy, length);
+				for (int i = 0; i < length; i++) {
+					zbuffer[pixel + i] = depth_row[i * 4];
+				}
+			}
+			if (isBreaked()) {
+				breaked = true;
+			}
+		}
+		return;
+	}
+
 	for (y = y1; y < y2 && (!breaked); y++) {
 		for (x = x1; x < x2 && (!breaked); x++) {
 			int input_x = x + dx, input_y = y + dy;
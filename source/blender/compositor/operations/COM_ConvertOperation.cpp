@@ -58,6 +58,17 @@ void ConvertValueToColorOperation::executePixelSampled(float output[4], float x,
 	output[3] = 1.0f;
 }
 
+void ConvertValueToColorOperation::executeRow(float *output, int x, int y, int length)
+{
+	float value[COM_ROW_SPAN * 4];
+	this->m_inputOperation->readRow(value, x, y, length);
+	for (int i = 0; i < length; i++) {
+		float *out = &output[i * 4];
+		out[0] = out[1] = out[2] = value[i * 4];
+		out[3] = 1.0f;
+	}
+}
+
 
 /* ******** Color to Value ******** */
 
@@ -74,6 +85,16 @@ void ConvertColorToValueOperation::executePixelSampled(float output[4], float x,
 	output[0] = (inputColor[0] + inputColor[1] + inputColor[2]) / 3.0f;
 }
 
+void ConvertColorToValueOperation::executeRow(float *output, int x, int y, int length)
+{
+	float inputColor[COM_ROW_SPAN * 4];
+	this->m_inputOperation->readRow(inputColor, x, y, length);
+	for (int i = 0; i < length; i++) {
+		const float *in = &inputColor[i * 4];
+		output[i * 4] = (in[0] + in[1] + in[2]) / 3.0f;
+	}
+}
+
 
 /* ******** Color to BW ******** */
 
@@ -90,6 +111,15 @@ void ConvertColorToBWOperation::executePixelSampled(float output[4], float x, fl
 	output[0] = IMB_colormanagement_get_luminance(inputColor);
 }
 
+void ConvertColorToBWOperation::executeRow(float *output, int x, int y, int length)
+{
+	float inputColor[COM_ROW_SPAN * 4];
+	this->m_inputOperation->readRow(inputColor, x, y, length);
+	for (int i = 0; i < length; i++) {
+		output[i * 4] = IMB_colormanagement_get_luminance(&inputColor[i * 4]);
+	}
+}
+
 
 /* ******** Color to Vector ******** */
 
@@ -114,6 +144,15 @@ ConvertValueToVectorOperation::ConvertValueToVectorOperation() : ConvertBaseOper
 	this->addOutputSocket(COM_DT_VECTOR);
 }
 
+void ConvertColorToVectorOperation::executeRow(float *output, int x, int y, int length)
+{
+	float color[COM_ROW_SPAN * 4];
+	this->m_inputOperation->readRow(color, x, y, length);
+	for (int i = 0; i < length; i++) {
+		copy_v3_v3(&output[i * 4], &color[i * 4]);
+	}
+}
+
 void ConvertValueToVectorOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float value;
@@ -121,6 +160,16 @@ void ConvertValueToVectorOperation::executePixelSampled(float output[4], float x
 	output[0] = output[1] = output[2] = value;
 }
 
+void ConvertValueToVectorOperation::executeRow(float *output, int x, int y, int length)
+{
+	float value[COM_ROW_SPAN * 4];
+	this->m_inputOperation->readRow(value, x, y, length);
+	for (int i = 0; i < length; i++) {
+		float *out = &output[i * 4];
+		out[0] = out[1] = out[2] = value[i * 4];
+	}
+}
+
 
 /* ******** Vector to Color ******** */
 
@@ -136,6 +185,14 @@ void ConvertVectorToColorOperation::executePixelSampled(float output[4], float x
 	output[3] = 1.0f;
 }
 
+void ConvertVectorToColorOperation::executeRow(float *output, int x, int y, int length)
+{
+	this->m_inputOperation->readRow(output, x, y, length);
+	for (int i = 0; i < length; i++) {
+		output[i * 4 + 3] = 1.0f;
+	}
+}
+
 
 /* ******** Vector to Value ******** */
 
@@ -152,6 +209,16 @@ void ConvertVectorToValueOperation::executePixelSampled(float output[4], float x
 	output[0] = (input[0] + input[1] + input[2]) / 3.0f;
 }
 
+void ConvertVectorToValueOperation::executeRow(float *output, int x, int y, int length)
+{
+	float input[COM_ROW_SPAN * 4];
+	this->m_inputOperation->readRow(input, x, y, length);
+	for (int i = 0; i < length; i++) {
+		const float *in = &input[i * 4];
+		output[i * 4] = (in[0] + in[1] + in[2]) / 3.0f;
+	}
+}
+
 
 /* ******** RGB to YCC ******** */
 
@@ -327,6 +394,23 @@ void ConvertPremulToStraightOperation::executePixelSampled(float output[4], floa
 	output[3] = alpha;
 }
 
+void ConvertPremulToStraightOperation::executeRow(float *output, int x, int y, int length)
+{
+	/* reading into the output is safe, every pixel only depends on itself */
+	this->m_inputOperation->readRow(output, x, y, length);
+	for (int i = 0; i < length; i++) {
+		float *out = &output[i * 4];
+		const float alpha = out[3];
+
+		if (fabsf(alpha) < 1e-5f) {
+			zero_v3(out);
+		}
+		else {
+			mul_v3_fl(out, 1.0f / alpha);
+		}
+	}
+}
+
 
 /* ******** Straight to Premul ******** */
 
@@ -350,6 +434,15 @@ void ConvertStraightToPremulOperation::executePixelSampled(float output[4], floa
 	output[3] = alpha;
 }
 
+void ConvertStraightToPremulOperation::executeRow(float *output, int x, int y, int length)
+{
+	this->m_inputOperation->readRow(output, x, y, length);
+	for (int i = 0; i < length; i++) {
+		float *out = &output[i * 4];
+		mul_v3_fl(out, out[3]);
+	}
+}
+
 
 /* ******** Separate Channels ******** */
 
@@ -377,6 +470,15 @@ void SeparateChannelOperation::executePixelSampled(float output[4], float x, flo
 	output[0] = input[this->m_channel];
 }
 
+void SeparateChannelOperation::executeRow(float *output, int x, int y, int length)
+{
+	float input[COM_ROW_SPAN * 4];
+	this->m_inputOperation->readRow(input, x, y, length);
+	for (int i = 0; i < length; i++) {
+		output[i * 4] = input[i * 4 + this->m_channel];
+	}
+}
+
 
 /* ******** Combine Channels ******** */
 
@@ -431,3 +533,21 @@ void CombineChannelsOperation::executePixelSampled(float output[4], float x, flo
 		output[3] = input[0];
 	}
 }
+
+void CombineChannelsOperation::executeRow(float *output, int x, int y, int length)
+{
+	float input[COM_ROW_SPAN * 4];
+	SocketReader *inputs[4] = {this->m_inputChannel1Operation,
+	                           this->m_inputChannel2Operation,
+	                           this->m_inputChannel3Operation,
+	                           this->m_inputChannel4Operation};
+
+	for (int channel = 0; channel < 4; channel++) {
+		if (inputs[channel]) {
+			inputs[channel]->readRow(input, x, y, length);
+			for (int i = 0; i < length; i++) {
+				output[i * 4 + channel] = input[i * 4];
+			}
+		}
+	}
+}
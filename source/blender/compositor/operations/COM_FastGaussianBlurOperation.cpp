@@ -26,6 +26,10 @@
 #include "MEM_guardedalloc.h"
 #include "BLI_utildefines.h"
 
+extern "C" {
+#  include "BLI_task.h"
+}
+
 FastGaussianBlurOperation::FastGaussianBlurOperation() : BlurBaseOperation(COM_DT_COLOR)
 {
 	this->m_iirgaus = NULL;
@@ -111,23 +115,121 @@ void *FastGaussianBlurOperation::initializeTileData(rcti *rect)
 	return this->m_iirgaus;
 }
 
+/* coefficients of the recursive filter, shared by all rows or columns */
+typedef struct IIRGaussData {
+	float *buffer;
+	unsigned int width, height;
+	unsigned int num_channels, chan;
+	double cf[4], tsM[9];
+} IIRGaussData;
+
+/* rows or columns are filtered in blocks, one block per task */
+#define IIR_GAUSS_BLOCK_SIZE 16
+
+/* filter L samples of X into Y, W is the intermediate result of the causal pass */
+static void iir_gauss_yvv(const IIRGaussData *data, const double *X, double *W, double *Y, const unsigned int L)
+{
+	const double *cf = data->cf;
+	const double *tsM = data->tsM;
+	double tsu[3], tsv[3];
+	unsigned int i;
+
+	W[0] = cf[0] * X[0] + cf[1] * X[0] + cf[2] * X[0] + cf[3] * X[0];
+	W[1] = cf[0] * X[1] + cf[1] * W[0] + cf[2] * X[0] + cf[3] * X[0];
+	W[2] = cf[0] * X[2] + cf[1] * W[1] + cf[2] * W[0] + cf[3] * X[0];
+	for (i = 3; i < L; i++) {
+		W[i] = cf[0] * X[i] + cf[1] * W[i - 1] + cf[2] * W[i - 2] + cf[3] * W[i - 3];
+	}
+	tsu[0] = W[L - 1] - X[L - 1];
+	tsu[1] = W[L - 2] - X[L - 1];
+	tsu[2] = W[L - 3] - X[L - 1];
+	tsv[0] = tsM[0] * tsu[0] + tsM[1] * tsu[1] + tsM[2] * tsu[2] + X[L - 1];
+	tsv[1] = tsM[3] * tsu[0] + tsM[4] * tsu[1] + tsM[5] * tsu[2] + X[L - 1];
+	tsv[2] = tsM[6] * tsu[0] + tsM[7] * tsu[1] + tsM[8] * tsu[2] + X[L - 1];
+	Y[L - 1] = cf[0] * W[L - 1] + cf[1] * tsv[0] + cf[2] * tsv[1] + cf[3] * tsv[2];
+	Y[L - 2] = cf[0] * W[L - 2] + cf[1] * Y[L - 1] + cf[2] * tsv[0] + cf[3] * tsv[1];
+	Y[L - 3] = cf[0] * W[L - 3] + cf[1] * Y[L - 2] + cf[2] * Y[L - 1] + cf[3] * tsv[0];
+	/* 'i != UINT_MAX' is really 'i >= 0', but necessary for unsigned int wrapping */
+	for (i = L - 4; i != UINT_MAX; i--) {
+		Y[i] = cf[0] * W[i] + cf[1] * Y[i + 1] + cf[2] * Y[i + 2] + cf[3] * Y[i + 3];
+	}
+}
+
+static void iir_gauss_rows(void *__restrict userdata, const int block, const ParallelRangeTLS *__restrict /*tls*/)
+{
+	const IIRGaussData *data = (const IIRGaussData *)userdata;
+	const unsigned int width = data->width;
+	const unsigned int num_channels = data->num_channels;
+	const unsigned int ymin = block * IIR_GAUSS_BLOCK_SIZE;
+	const unsigned int ymax = min(ymin + IIR_GAUSS_BLOCK_SIZE, data->height);
+	double *X = (double *)MEM_mallocN(3 * width * sizeof(double), "IIR_gauss rows");
+	double *W = X + width;
+	double *Y = W + width;
+
+	for (unsigned int y = ymin; y < ymax; y++) {
+		float *row = &data->buffer[y * width * num_channels + data->chan];
+		for (unsigned int x = 0; x < width; x++) {
+			X[x] = row[x * num_channels];
+		}
+		iir_gauss_yvv(data, X, W, Y, width);
+		for (unsigned int x = 0; x < width; x++) {
+			row[x * num_channels] = Y[x];
+		}
+	}
+
+	MEM_freeN(X);
+}
+
+static void iir_gauss_columns(void *__restrict userdata, const int block, const ParallelRangeTLS *__restrict /*tls*/)
+{
+	const IIRGaussData *data = (const IIRGaussData *)userdata;
+	const unsigned int width = data->width;
+	const unsigned int height = data->height;
+	const unsigned int num_channels = data->num_channels;
+	const unsigned int xmin = block * IIR_GAUSS_BLOCK_SIZE;
+	const unsigned int num_columns = min(xmin + IIR_GAUSS_BLOCK_SIZE, width) - xmin;
+	/* the columns of the block are stored transposed, so reading and writing the image goes
+	 * row by row instead of walking down every column separately */
+	double *X = (double *)MEM_mallocN((num_columns + 2) * height * sizeof(double), "IIR_gauss columns");
+	double *W = X + num_columns * height;
+	double *Y = W + height;
+	unsigned int x, y;
+
+	for (y = 0; y < height; y++) {
+		const float *row = &data->buffer[(y * width + xmin) * num_channels + data->chan];
+		for (x = 0; x < num_columns; x++) {
+			X[x * height + y] = row[x * num_channels];
+		}
+	}
+	for (x = 0; x < num_columns; x++) {
+		double *column = &X[x * height];
+		iir_gauss_yvv(data, column, W, Y, height);
+		memcpy(column, Y, height * sizeof(double));
+	}
+	for (y = 0; y < height; y++) {
+		float *row = &data->buffer[(y * width + xmin) * num_channels + data->chan];
+		for (x = 0; x < num_columns; x++) {
+			row[x * num_channels] = X[x * height + y];
+		}
+	}
+
+	MEM_freeN(X);
+}
+
 void FastGaussianBlurOperation::IIR_gauss(MemoryBuffer *src, float sigma, unsigned int chan, unsigned int xy)
 {
-	double q, q2, sc, cf[4], tsM[9], tsu[3], tsv[3];
-	double *X, *Y, *W;
+	double q, q2, sc;
+	IIRGaussData data;
+	double *cf = data.cf, *tsM = data.tsM;
 	const unsigned int src_width = src->getWidth();
 	const unsigned int src_height = src->getHeight();
-	unsigned int x, y, sz;
-	unsigned int i;
-	float *buffer = src->getBuffer();
-	const unsigned int num_channels = src->get_num_channels();
 	
 	// <0.5 not valid, though can have a possibly useful sort of sharpening effect
 	if (sigma < 0.5f) return;
 	
 	if ((xy < 1) || (xy > 3)) xy = 3;
 	
-	// XXX The YVV macro defined below explicitly expects sources of at least 3x3 pixels,
+	// XXX iir_gauss_yvv explicitly expects sources of at least 3x3 pixels,
 	//     so just skiping blur along faulty direction if src's def is below that limit!
 	if (src_width < 3) xy &= ~1;
 	if (src_height < 3) xy &= ~2;
@@ -166,76 +268,26 @@ void FastGaussianBlurOperation::IIR_gauss(MemoryBuffer *src, float sigma, unsign
 	tsM[6] = sc * (cf[3] * cf[1] + cf[2] + cf[1] * cf[1] - cf[2] * cf[2]);
 	tsM[7] = sc * (cf[1] * cf[2] + cf[3] * cf[2] * cf[2] - cf[1] * cf[3] * cf[3] - cf[3] * cf[3] * cf[3] - cf[3] * cf[2] + cf[3]);
 	tsM[8] = sc * (cf[3] * (cf[1] + cf[3] * cf[2]));
-	
-#define YVV(L)                                                                          \
-{                                                                                       \
-	W[0] = cf[0] * X[0] + cf[1] * X[0] + cf[2] * X[0] + cf[3] * X[0];                   \
-	W[1] = cf[0] * X[1] + cf[1] * W[0] + cf[2] * X[0] + cf[3] * X[0];                   \
-	W[2] = cf[0] * X[2] + cf[1] * W[1] + cf[2] * W[0] + cf[3] * X[0];                   \
-	for (i = 3; i < L; i++) {                                                           \
-		W[i] = cf[0] * X[i] + cf[1] * W[i - 1] + cf[2] * W[i - 2] + cf[3] * W[i - 3];   \
-	}                                                                                   \
-	tsu[0] = W[L - 1] - X[L - 1];                                                       \
-	tsu[1] = W[L - 2] - X[L - 1];                                                       \
-	tsu[2] = W[L - 3] - X[L - 1];                                                       \
-	tsv[0] = tsM[0] * tsu[0] + tsM[1] * tsu[1] + tsM[2] * tsu[2] + X[L - 1];            \
-	tsv[1] = tsM[3] * tsu[0] + tsM[4] * tsu[1] + tsM[5] * tsu[2] + X[L - 1];            \
-	tsv[2] = tsM[6] * tsu[0] + tsM[7] * tsu[1] + tsM[8] * tsu[2] + X[L - 1];            \
-	Y[L - 1] = cf[0] * W[L - 1] + cf[1] * tsv[0] + cf[2] * tsv[1] + cf[3] * tsv[2];     \
-	Y[L - 2] = cf[0] * W[L - 2] + cf[1] * Y[L - 1] + cf[2] * tsv[0] + cf[3] * tsv[1];   \
-	Y[L - 3] = cf[0] * W[L - 3] + cf[1] * Y[L - 2] + cf[2] * Y[L - 1] + cf[3] * tsv[0]; \
-	/* 'i != UINT_MAX' is really 'i >= 0', but necessary for unsigned int wrapping */   \
-	for (i = L - 4; i != UINT_MAX; i--) {                                               \
-		Y[i] = cf[0] * W[i] + cf[1] * Y[i + 1] + cf[2] * Y[i + 2] + cf[3] * Y[i + 3];   \
-	}                                                                                   \
-} (void)0
-	
-	// intermediate buffers
-	sz = max(src_width, src_height);
-	X = (double *)MEM_callocN(sz * sizeof(double), "IIR_gauss X buf");
-	Y = (double *)MEM_callocN(sz * sizeof(double), "IIR_gauss Y buf");
-	W = (double *)MEM_callocN(sz * sizeof(double), "IIR_gauss W buf");
+
+	data.buffer = src->getBuffer();
+	data.width = src_width;
+	data.height = src_height;
+	data.num_channels = src->get_num_channels();
+	data.chan = chan;
+
+	// rows and columns are independent, filter blocks of them in parallel
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (src_width * src_height > 64 * 64);
+
 	if (xy & 1) {   // H
-		int offset;
-		for (y = 0; y < src_height; ++y) {
-			const int yx = y * src_width;
-			offset = yx * num_channels + chan;
-			for (x = 0; x < src_width; ++x) {
-				X[x] = buffer[offset];
-				offset += num_channels;
-			}
-			YVV(src_width);
-			offset = yx * num_channels + chan;
-			for (x = 0; x < src_width; ++x) {
-				buffer[offset] = Y[x];
-				offset += num_channels;
-			}
-		}
+		const int num_blocks = (src_height + IIR_GAUSS_BLOCK_SIZE - 1) / IIR_GAUSS_BLOCK_SIZE;
+		BLI_task_parallel_range(0, num_blocks, &data, iir_gauss_rows, &settings);
 	}
 	if (xy & 2) {   // V
-		int offset;
-		const int add = src_width * num_channels;
-
-		for (x = 0; x < src_width; ++x) {
-			offset = x * num_channels + chan;
-			for (y = 0; y < src_height; ++y) {
-				X[y] = buffer[offset];
-				offset += add;
-			}
-			YVV(src_height);
-			offset = x * num_channels + chan;
-			for (y = 0; y < src_height; ++y) {
-				buffer[offset] = Y[y];
-				offset += add;
-			}
-		}
+		const int num_blocks = (src_width + IIR_GAUSS_BLOCK_SIZE - 1) / IIR_GAUSS_BLOCK_SIZE;
+		BLI_task_parallel_range(0, num_blocks, &data, iir_gauss_columns, &settings);
 	}
-	
-	MEM_freeN(X);
-	MEM_freeN(W);
-	MEM_freeN(Y);
-#undef YVV
-	
 }
 
 
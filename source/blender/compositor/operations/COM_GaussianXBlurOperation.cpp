@@ -123,6 +123,69 @@ void GaussianXBlurOperation::executePixel(float output[4], int x, int y, void *d
 	mul_v4_v4fl(output, color_accum, 1.0f / multiplier_accum);
 }
 
+void GaussianXBlurOperation::executeTileRow(float *output, int x, int y, int length, void *data)
+{
+	int i = 0;
+#ifdef __SSE2__
+	MemoryBuffer *inputBuffer = (MemoryBuffer *)data;
+	rcti &rect = *inputBuffer->getRect();
+
+	if (getStep() == 1 && y >= rect.ymin && y < rect.ymax) {
+		const int filtersize = this->m_filtersize;
+		const int taps = 2 * filtersize + 1;
+		const float *row = inputBuffer->getBuffer() + ((y - rect.ymin) * inputBuffer->getWidth() - rect.xmin) * 4;
+		/* pixels in this range have the whole kernel inside the input */
+		const int xmin = rect.xmin + filtersize;
+		const int xmax = rect.xmax - filtersize;
+
+		float multiplier_accum = 0.0f;
+		for (int index = 0; index < taps; index++) {
+			multiplier_accum += this->m_gausstab[index];
+		}
+		const __m128 normalize = _mm_set1_ps(1.0f / multiplier_accum);
+
+		while (i < length) {
+			const int px = x + i;
+			if (i + 4 > length || px < xmin || px + 4 > xmax) {
+				executePixel(&output[i * 4], px, y, data);
+				i++;
+				continue;
+			}
+
+			/* four neighboring pixels at once, every input pixel is loaded once
+			 * and used for all the pixels it contributes to */
+			const float *in = &row[(px - filtersize) * 4];
+			__m128 accum_0 = _mm_setzero_ps();
+			__m128 accum_1 = _mm_setzero_ps();
+			__m128 accum_2 = _mm_setzero_ps();
+			__m128 accum_3 = _mm_setzero_ps();
+			__m128 in_0 = _mm_load_ps(&in[0]);
+			__m128 in_1 = _mm_load_ps(&in[4]);
+			__m128 in_2 = _mm_load_ps(&in[8]);
+			for (int index = 0; index < taps; index++) {
+				const __m128 weight = this->m_gausstab_sse[index];
+				const __m128 in_3 = _mm_load_ps(&in[(index + 3) * 4]);
+				accum_0 = _mm_add_ps(accum_0, _mm_mul_ps(in_0, weight));
+				accum_1 = _mm_add_ps(accum_1, _mm_mul_ps(in_1, weight));
+				accum_2 = _mm_add_ps(accum_2, _mm_mul_ps(in_2, weight));
+				accum_3 = _mm_add_ps(accum_3, _mm_mul_ps(in_3, weight));
+				in_0 = in_1;
+				in_1 = in_2;
+				in_2 = in_3;
+			}
+			_mm_storeu_ps(&output[i * 4], _mm_mul_ps(accum_0, normalize));
+			_mm_storeu_ps(&output[i * 4 + 4], _mm_mul_ps(accum_1, normalize));
+			_mm_storeu_ps(&output[i * 4 + 8], _mm_mul_ps(accum_2, normalize));
+			_mm_storeu_ps(&output[i * 4 + 12], _mm_mul_ps(accum_3, normalize));
+			i += 4;
+		}
+	}
+#endif
+	for (; i < length; i++) {
+		executePixel(&output[i * 4], x + i, y, data);
+	}
+}
+
 void GaussianXBlurOperation::executeOpenCL(OpenCLDevice *device,
                                            MemoryBuffer *outputMemoryBuffer, cl_mem clOutputBuffer,
                                            MemoryBuffer **inputMemoryBuffers, list<cl_mem> *clMemToCleanUp,
@@ -125,6 +125,50 @@ void GaussianYBlurOperation::executePixel(float output[4], int x, int y, void *d
 	mul_v4_v4fl(output, color_accum, 1.0f / multiplier_accum);
 }
 
+void GaussianYBlurOperation::executeTileRow(float *output, int x, int y, int length, void *data)
+{
+#ifdef __SSE2__
+	MemoryBuffer *inputBuffer = (MemoryBuffer *)data;
+	rcti &rect = *inputBuffer->getRect();
+	const int filtersize = this->m_filtersize;
+
+	/* When the whole kernel is inside the input the span is calculated one tap at a time,
+	 * every tap adds a contiguous part of an input row to all pixels of the span. This reads
+	 * the input row by row instead of walking down a column for every pixel. */
+	if (getStep() == 1 &&
+	    y - filtersize >= rect.ymin && y + filtersize < rect.ymax &&
+	    x >= rect.xmin && x + length <= rect.xmax)
+	{
+		__m128 accum[COM_ROW_SPAN];
+		const int offsetadd = inputBuffer->getWidth() * 4;
+		const float *in = inputBuffer->getBuffer() +
+		                  (y - filtersize - rect.ymin) * offsetadd + (x - rect.xmin) * 4;
+		float multiplier_accum = 0.0f;
+
+		for (int i = 0; i < length; i++) {
+			accum[i] = _mm_setzero_ps();
+		}
+		for (int index = 0; index < 2 * filtersize + 1; index++) {
+			const __m128 weight = this->m_gausstab_sse[index];
+			for (int i = 0; i < length; i++) {
+				accum[i] = _mm_add_ps(accum[i], _mm_mul_ps(_mm_load_ps(&in[i * 4]), weight));
+			}
+			multiplier_accum += this->m_gausstab[index];
+			in += offsetadd;
+		}
+
+		const __m128 normalize = _mm_set1_ps(1.0f / multiplier_accum);
+		for (int i = 0; i < length; i++) {
+			_mm_storeu_ps(&output[i * 4], _mm_mul_ps(accum[i], normalize));
+		}
+		return;
+	}
+#endif
+	for (int i = 0; i < length; i++) {
+		executePixel(&output[i * 4], x + i, y, data);
+	}
+}
+
 void GaussianYBlurOperation::executeOpenCL(OpenCLDevice *device,
                                            MemoryBuffer *outputMemoryBuffer, cl_mem clOutputBuffer,
                                            MemoryBuffer **inputMemoryBuffers, list<cl_mem> *clMemToCleanUp,
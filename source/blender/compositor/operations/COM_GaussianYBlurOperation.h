@@ -41,6 +41,11 @@ public:
 	 */
 	void executePixel(float output[4], int x, int y, void *data);
 
+	/**
+	 * @brief calculate a span of pixels, sharing the kernel between neighboring pixels
+	 */
+	void executeTileRow(float *output, int x, int y, int length, void *data);
+
 	void executeOpenCL(OpenCLDevice *device,
 	                   MemoryBuffer *outputMemoryBuffer, cl_mem clOutputBuffer,
 	                   MemoryBuffer **inputMemoryBuffers, list<cl_mem> *clMemToCleanUp,
@@ -23,6 +23,11 @@
 #include "COM_GlareFogGlowOperation.h"
 #include "MEM_guardedalloc.h"
 
+extern "C" {
+#  include "BLI_task.h"
+#  include "BLI_threads.h"
+}
+
 /*
  *  2D Fast Hartley Transform, used for convolution
  */
@@ -243,34 +248,115 @@ static void fht_convolve(fREAL *d1, fREAL *d2, unsigned int M, unsigned int N)
 }
 //------------------------------------------------------------------------------
 
+/* shared state of the threaded block convolution */
+typedef struct ConvolveData {
+	fREAL *data1;                 /* FHT of the kernel, one w2 * h2 block per channel */
+	float *kernelBuffer, *imageBuffer, *dstBuffer;
+	unsigned int kernelWidth, kernelHeight;
+	unsigned int imageWidth, imageHeight;
+	unsigned int w2, h2, log2_w, log2_h;
+	int hw, hh, xbsz, ybsz, nxb;
+	ThreadMutex mutex[3];         /* overlapping blocks add to the same pixels, one lock per channel */
+} ConvolveData;
+
+/* in2, channel ch -> data1, forward FHT */
+static void convolve_kernel_channel(void *__restrict userdata, const int ch, const ParallelRangeTLS *__restrict /*tls*/)
+{
+	ConvolveData *cd = (ConvolveData *)userdata;
+	fREAL *data1ch = &cd->data1[ch * cd->w2 * cd->h2];
+	fREAL *fp;
+	fRGB *colp;
+
+	for (unsigned int y = 0; y < cd->kernelHeight; y++) {
+		fp = &data1ch[y * cd->w2];
+		colp = (fRGB *)&cd->kernelBuffer[y * cd->kernelWidth * COM_NUM_CHANNELS_COLOR];
+		for (unsigned int x = 0; x < cd->kernelWidth; x++)
+			fp[x] = colp[x][ch];
+	}
+
+	// zero pad data start is different for each == height+1
+	FHT2D(data1ch, cd->log2_w, cd->log2_h, cd->kernelHeight + 1, 0);
+}
+
+/* convolve one channel of one image block with the kernel and add it to the result */
+static void convolve_block_channel(void *__restrict userdata, const int task, const ParallelRangeTLS *__restrict /*tls*/)
+{
+	ConvolveData *cd = (ConvolveData *)userdata;
+	const int ch = task % 3;
+	const int xbl = (task / 3) % cd->nxb;
+	const int ybl = (task / 3) / cd->nxb;
+	const int imageWidth = cd->imageWidth;
+	const int imageHeight = cd->imageHeight;
+	fREAL *data1ch = &cd->data1[ch * cd->w2 * cd->h2];
+	fREAL *data2, *fp;
+	fRGB *colp;
+	int x, y;
+
+	// in1, channel ch -> data2
+	data2 = (fREAL *)MEM_callocN(cd->w2 * cd->h2 * sizeof(fREAL), "convolve_fast FHT data2");
+	for (y = 0; y < cd->ybsz; y++) {
+		int yy = ybl * cd->ybsz + y;
+		if (yy >= imageHeight) continue;
+		fp = &data2[y * cd->w2];
+		colp = (fRGB *)&cd->imageBuffer[yy * imageWidth * COM_NUM_CHANNELS_COLOR];
+		for (x = 0; x < cd->xbsz; x++) {
+			int xx = xbl * cd->xbsz + x;
+			if (xx >= imageWidth) continue;
+			fp[x] = colp[xx][ch];
+		}
+	}
+
+	// forward FHT
+	FHT2D(data2, cd->log2_w, cd->log2_h, cd->kernelHeight + 1, 0);
+
+	// FHT2D transposed data, row/col now swapped
+	// convolve & inverse FHT
+	fht_convolve(data2, data1ch, cd->log2_h, cd->log2_w);
+	FHT2D(data2, cd->log2_h, cd->log2_w, 0, 1);
+	// data again transposed, so in order again
+
+	// overlap-add result
+	BLI_mutex_lock(&cd->mutex[ch]);
+	for (y = 0; y < (int)cd->h2; y++) {
+		const int yy = ybl * cd->ybsz + y - cd->hh;
+		if ((yy < 0) || (yy >= imageHeight)) continue;
+		fp = &data2[y * cd->w2];
+		colp = (fRGB *)&cd->dstBuffer[yy * imageWidth * COM_NUM_CHANNELS_COLOR];
+		for (x = 0; x < (int)cd->w2; x++) {
+			const int xx = xbl * cd->xbsz + x - cd->hw;
+			if ((xx < 0) || (xx >= imageWidth)) continue;
+			colp[xx][ch] += fp[x];
+		}
+	}
+	BLI_mutex_unlock(&cd->mutex[ch]);
+
+	MEM_freeN(data2);
+}
+
 static void convolve(float *dst, MemoryBuffer *in1, MemoryBuffer *in2)
 {
-	fREAL *data1, *data2, *fp;
-	unsigned int w2, h2, hw, hh, log2_w, log2_h;
+	ConvolveData cd;
 	fRGB wt, *colp;
-	int x, y, ch;
-	int xbl, ybl, nxb, nyb, xbsz, ybsz;
-	bool in2done = false;
+	unsigned int x, y;
+	int nyb, ch;
 	const unsigned int kernelWidth = in2->getWidth();
 	const unsigned int kernelHeight = in2->getHeight();
 	const unsigned int imageWidth = in1->getWidth();
 	const unsigned int imageHeight = in1->getHeight();
 	float *kernelBuffer = in2->getBuffer();
-	float *imageBuffer = in1->getBuffer();
 
 	MemoryBuffer *rdst = new MemoryBuffer(COM_DT_COLOR, in1->getRect());
 	memset(rdst->getBuffer(), 0, rdst->getWidth() * rdst->getHeight() * COM_NUM_CHANNELS_COLOR * sizeof(float));
 
 	// convolution result width & height
-	w2 = 2 * kernelWidth - 1;
-	h2 = 2 * kernelHeight - 1;
+	cd.w2 = 2 * kernelWidth - 1;
+	cd.h2 = 2 * kernelHeight - 1;
 	// FFT pow2 required size & log2
-	w2 = nextPow2(w2, &log2_w);
-	h2 = nextPow2(h2, &log2_h);
+	cd.w2 = nextPow2(cd.w2, &cd.log2_w);
+	cd.h2 = nextPow2(cd.h2, &cd.log2_h);
 
 	// alloc space
-	data1 = (fREAL *)MEM_callocN(3 * w2 * h2 * sizeof(fREAL), "convolve_fast FHT data1");
-	data2 = (fREAL *)MEM_callocN(w2 * h2 * sizeof(fREAL), "convolve_fast FHT data2");
+	cd.data1 = (fREAL *)MEM_callocN(3 * cd.w2 * cd.h2 * sizeof(fREAL), "convolve_fast FHT data1");
 
 	// normalize convolutor
 	wt[0] = wt[1] = wt[2] = 0.0f;
@@ -288,81 +374,41 @@ static void convolve(float *dst, MemoryBuffer *in1, MemoryBuffer *in2)
 			mul_v3_v3(colp[x], wt);
 	}
 
-	// copy image data, unpacking interleaved RGBA into separate channels
-	// only need to calc data1 once
+	cd.kernelBuffer = kernelBuffer;
+	cd.imageBuffer = in1->getBuffer();
+	cd.dstBuffer = rdst->getBuffer();
+	cd.kernelWidth = kernelWidth;
+	cd.kernelHeight = kernelHeight;
+	cd.imageWidth = imageWidth;
+	cd.imageHeight = imageHeight;
 
 	// block add-overlap
-	hw = kernelWidth >> 1;
-	hh = kernelHeight >> 1;
-	xbsz = (w2 + 1) - kernelWidth;
-	ybsz = (h2 + 1) - kernelHeight;
-	nxb = imageWidth / xbsz;
-	if (imageWidth % xbsz) nxb++;
-	nyb = imageHeight / ybsz;
-	if (imageHeight % ybsz) nyb++;
-	for (ybl = 0; ybl < nyb; ybl++) {
-		for (xbl = 0; xbl < nxb; xbl++) {
-
-			// each channel one by one
-			for (ch = 0; ch < 3; ch++) {
-				fREAL *data1ch = &data1[ch * w2 * h2];
-
-				// only need to calc fht data from in2 once, can re-use for every block
-				if (!in2done) {
-					// in2, channel ch -> data1
-					for (y = 0; y < kernelHeight; y++) {
-						fp = &data1ch[y * w2];
-						colp = (fRGB *)&kernelBuffer[y * kernelWidth * COM_NUM_CHANNELS_COLOR];
-						for (x = 0; x < kernelWidth; x++)
-							fp[x] = colp[x][ch];
-					}
-				}
-
-				// in1, channel ch -> data2
-				memset(data2, 0, w2 * h2 * sizeof(fREAL));
-				for (y = 0; y < ybsz; y++) {
-					int yy = ybl * ybsz + y;
-					if (yy >= imageHeight) continue;
-					fp = &data2[y * w2];
-					colp = (fRGB *)&imageBuffer[yy * imageWidth * COM_NUM_CHANNELS_COLOR];
-					for (x = 0; x < xbsz; x++) {
-						int xx = xbl * xbsz + x;
-						if (xx >= imageWidth) continue;
-						fp[x] = colp[xx][ch];
-					}
-				}
+	cd.hw = kernelWidth >> 1;
+	cd.hh = kernelHeight >> 1;
+	cd.xbsz = (cd.w2 + 1) - kernelWidth;
+	cd.ybsz = (cd.h2 + 1) - kernelHeight;
+	cd.nxb = imageWidth / cd.xbsz;
+	if (imageWidth % cd.xbsz) cd.nxb++;
+	nyb = imageHeight / cd.ybsz;
+	if (imageHeight % cd.ybsz) nyb++;
+
+	for (ch = 0; ch < 3; ch++) {
+		BLI_mutex_init(&cd.mutex[ch]);
+	}
 
-				// forward FHT
-				// zero pad data start is different for each == height+1
-				if (!in2done) FHT2D(data1ch, log2_w, log2_h, kernelHeight + 1, 0);
-				FHT2D(data2, log2_w, log2_h, kernelHeight + 1, 0);
-
-				// FHT2D transposed data, row/col now swapped
-				// convolve & inverse FHT
-				fht_convolve(data2, data1ch, log2_h, log2_w);
-				FHT2D(data2, log2_h, log2_w, 0, 1);
-				// data again transposed, so in order again
-
-				// overlap-add result
-				for (y = 0; y < (int)h2; y++) {
-					const int yy = ybl * ybsz + y - hh;
-					if ((yy < 0) || (yy >= imageHeight)) continue;
-					fp = &data2[y * w2];
-					colp = (fRGB *)&rdst->getBuffer()[yy * imageWidth * COM_NUM_CHANNELS_COLOR];
-					for (x = 0; x < (int)w2; x++) {
-						const int xx = xbl * xbsz + x - hw;
-						if ((xx < 0) || (xx >= imageWidth)) continue;
-						colp[xx][ch] += fp[x];
-					}
-				}
+	// the kernel FHT is calculated once per channel and re-used for every block,
+	// then all blocks and channels are transformed in parallel
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+	BLI_task_parallel_range(0, 3, &cd, convolve_kernel_channel, &settings);
+	BLI_task_parallel_range(0, cd.nxb * nyb * 3, &cd, convolve_block_channel, &settings);
 
-			}
-			in2done = true;
-		}
+	for (ch = 0; ch < 3; ch++) {
+		BLI_mutex_end(&cd.mutex[ch]);
 	}
 
-	MEM_freeN(data2);
-	MEM_freeN(data1);
+	MEM_freeN(cd.data1);
 	memcpy(dst, rdst->getBuffer(), sizeof(float) * imageWidth * imageHeight * COM_NUM_CHANNELS_COLOR);
 	delete(rdst);
 }
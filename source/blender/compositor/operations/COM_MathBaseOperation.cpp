@@ -72,6 +72,15 @@ void MathBaseOperation::clampIfNeeded(float *color)
 	}
 }
 
+void MathBaseOperation::clampRowIfNeeded(float *output, int length)
+{
+	if (this->m_useClamp) {
+		for (int i = 0; i < length; i++) {
+			CLAMP(output[i * 4], 0.0f, 1.0f);
+		}
+	}
+}
+
 void MathAddOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -85,6 +94,21 @@ void MathAddOperation::executePixelSampled(float output[4], float x, float y, Pi
 	clampIfNeeded(output);
 }
 
+void MathAddOperation::executeRow(float *output, int x, int y, int length)
+{
+	float in1[COM_ROW_SPAN * 4];
+	float in2[COM_ROW_SPAN * 4];
+
+	this->m_inputValue1Operation->readRow(in1, x, y, length);
+	this->m_inputValue2Operation->readRow(in2, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		output[i * 4] = in1[i * 4] + in2[i * 4];
+	}
+
+	clampRowIfNeeded(output, length);
+}
+
 void MathSubtractOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -98,6 +122,21 @@ void MathSubtractOperation::executePixelSampled(float output[4], float x, float
 	clampIfNeeded(output);
 }
 
+void MathSubtractOperation::executeRow(float *output, int x, int y, int length)
+{
+	float in1[COM_ROW_SPAN * 4];
+	float in2[COM_ROW_SPAN * 4];
+
+	this->m_inputValue1Operation->readRow(in1, x, y, length);
+	this->m_inputValue2Operation->readRow(in2, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		output[i * 4] = in1[i * 4] - in2[i * 4];
+	}
+
+	clampRowIfNeeded(output, length);
+}
+
 void MathMultiplyOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -111,6 +150,21 @@ void MathMultiplyOperation::executePixelSampled(float output[4], float x, float
 	clampIfNeeded(output);
 }
 
+void MathMultiplyOperation::executeRow(float *output, int x, int y, int length)
+{
+	float in1[COM_ROW_SPAN * 4];
+	float in2[COM_ROW_SPAN * 4];
+
+	this->m_inputValue1Operation->readRow(in1, x, y, length);
+	this->m_inputValue2Operation->readRow(in2, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		output[i * 4] = in1[i * 4] * in2[i * 4];
+	}
+
+	clampRowIfNeeded(output, length);
+}
+
 void MathDivideOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -127,6 +181,24 @@ void MathDivideOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+void MathDivideOperation::executeRow(float *output, int x, int y, int length)
+{
+	float in1[COM_ROW_SPAN * 4];
+	float in2[COM_ROW_SPAN * 4];
+
+	this->m_inputValue1Operation->readRow(in1, x, y, length);
+	this->m_inputValue2Operation->readRow(in2, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		if (in2[i * 4] == 0) /* We don't want to divide by zero. */
+			output[i * 4] = 0.0;
+		else
+			output[i * 4] = in1[i * 4] / in2[i * 4];
+	}
+
+	clampRowIfNeeded(output, length);
+}
+
 void MathSineOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -265,6 +337,21 @@ void MathMinimumOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MathMinimumOperation::executeRow(float *output, int x, int y, int length)
+{
+	float in1[COM_ROW_SPAN * 4];
+	float in2[COM_ROW_SPAN * 4];
+
+	this->m_inputValue1Operation->readRow(in1, x, y, length);
+	this->m_inputValue2Operation->readRow(in2, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		output[i * 4] = min(in1[i * 4], in2[i * 4]);
+	}
+
+	clampRowIfNeeded(output, length);
+}
+
 void MathMaximumOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -278,6 +365,21 @@ void MathMaximumOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MathMaximumOperation::executeRow(float *output, int x, int y, int length)
+{
+	float in1[COM_ROW_SPAN * 4];
+	float in2[COM_ROW_SPAN * 4];
+
+	this->m_inputValue1Operation->readRow(in1, x, y, length);
+	this->m_inputValue2Operation->readRow(in2, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		output[i * 4] = max(in1[i * 4], in2[i * 4]);
+	}
+
+	clampRowIfNeeded(output, length);
+}
+
 void MathRoundOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -304,6 +406,21 @@ void MathLessThanOperation::executePixelSampled(float output[4], float x, float
 	clampIfNeeded(output);
 }
 
+void MathLessThanOperation::executeRow(float *output, int x, int y, int length)
+{
+	float in1[COM_ROW_SPAN * 4];
+	float in2[COM_ROW_SPAN * 4];
+
+	this->m_inputValue1Operation->readRow(in1, x, y, length);
+	this->m_inputValue2Operation->readRow(in2, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		output[i * 4] = in1[i * 4] < in2[i * 4] ? 1.0f : 0.0f;
+	}
+
+	clampRowIfNeeded(output, length);
+}
+
 void MathGreaterThanOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -317,6 +434,21 @@ void MathGreaterThanOperation::executePixelSampled(float output[4], float x, flo
 	clampIfNeeded(output);
 }
 
+void MathGreaterThanOperation::executeRow(float *output, int x, int y, int length)
+{
+	float in1[COM_ROW_SPAN * 4];
+	float in2[COM_ROW_SPAN * 4];
+
+	this->m_inputValue1Operation->readRow(in1, x, y, length);
+	this->m_inputValue2Operation->readRow(in2, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		output[i * 4] = in1[i * 4] > in2[i * 4] ? 1.0f : 0.0f;
+	}
+
+	clampRowIfNeeded(output, length);
+}
+
 void MathModuloOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
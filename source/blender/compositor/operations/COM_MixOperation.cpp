@@ -69,6 +69,19 @@ void MixBaseOperation::executePixelSampled(float output[4], float x, float y, Pi
 	output[3] = inputColor1[3];
 }
 
+void MixBaseOperation::readInputRows(float *value, float *color1, float *color2, int x, int y, int length)
+{
+	this->m_inputValueOperation->readRow(value, x, y, length);
+	this->m_inputColor1Operation->readRow(color1, x, y, length);
+	this->m_inputColor2Operation->readRow(color2, x, y, length);
+
+	if (this->useValueAlphaMultiply()) {
+		for (int i = 0; i < length; i++) {
+			value[i * 4] *= color2[i * 4 + 3];
+		}
+	}
+}
+
 void MixBaseOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
 {
 	NodeOperationInput *socket;
@@ -129,6 +142,29 @@ void MixAddOperation::executePixelSampled(float output[4], float x, float y, Pix
 	clampIfNeeded(output);
 }
 
+void MixAddOperation::executeRow(float *output, int x, int y, int length)
+{
+	float inputColor1[COM_ROW_SPAN * 4];
+	float inputColor2[COM_ROW_SPAN * 4];
+	float inputValue[COM_ROW_SPAN * 4];
+
+	readInputRows(inputValue, inputColor1, inputColor2, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		const float *in1 = &inputColor1[i * 4];
+		const float *in2 = &inputColor2[i * 4];
+		const float value = inputValue[i * 4];
+		float *out = &output[i * 4];
+
+		out[0] = in1[0] + value * in2[0];
+		out[1] = in1[1] + value * in2[1];
+		out[2] = in1[2] + value * in2[2];
+		out[3] = in1[3];
+	}
+
+	clampRowIfNeeded(output, length);
+}
+
 /* ******** Mix Blend Operation ******** */
 
 MixBlendOperation::MixBlendOperation() : MixBaseOperation()
@@ -160,6 +196,30 @@ void MixBlendOperation::executePixelSampled(float output[4], float x, float y, P
 	clampIfNeeded(output);
 }
 
+void MixBlendOperation::executeRow(float *output, int x, int y, int length)
+{
+	float inputColor1[COM_ROW_SPAN * 4];
+	float inputColor2[COM_ROW_SPAN * 4];
+	float inputValue[COM_ROW_SPAN * 4];
+
+	readInputRows(inputValue, inputColor1, inputColor2, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		const float *in1 = &inputColor1[i * 4];
+		const float *in2 = &inputColor2[i * 4];
+		const float value = inputValue[i * 4];
+		float *out = &output[i * 4];
+
+		const float valuem = 1.0f - value;
+		out[0] = valuem * (in1[0]) + value * (in2[0]);
+		out[1] = valuem * (in1[1]) + value * (in2[1]);
+		out[2] = valuem * (in1[2]) + value * (in2[2]);
+		out[3] = in1[3];
+	}
+
+	clampRowIfNeeded(output, length);
+}
+
 /* ******** Mix Burn Operation ******** */
 
 MixBurnOperation::MixBurnOperation() : MixBaseOperation()
@@ -623,6 +683,30 @@ void MixMultiplyOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MixMultiplyOperation::executeRow(float *output, int x, int y, int length)
+{
+	float inputColor1[COM_ROW_SPAN * 4];
+	float inputColor2[COM_ROW_SPAN * 4];
+	float inputValue[COM_ROW_SPAN * 4];
+
+	readInputRows(inputValue, inputColor1, inputColor2, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		const float *in1 = &inputColor1[i * 4];
+		const float *in2 = &inputColor2[i * 4];
+		const float value = inputValue[i * 4];
+		float *out = &output[i * 4];
+
+		const float valuem = 1.0f - value;
+		out[0] = in1[0] * (valuem + value * in2[0]);
+		out[1] = in1[1] * (valuem + value * in2[1]);
+		out[2] = in1[2] * (valuem + value * in2[2]);
+		out[3] = in1[3];
+	}
+
+	clampRowIfNeeded(output, length);
+}
+
 /* ******** Mix Ovelray Operation ******** */
 
 MixOverlayOperation::MixOverlayOperation() : MixBaseOperation()
@@ -740,6 +824,30 @@ void MixScreenOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+void MixScreenOperation::executeRow(float *output, int x, int y, int length)
+{
+	float inputColor1[COM_ROW_SPAN * 4];
+	float inputColor2[COM_ROW_SPAN * 4];
+	float inputValue[COM_ROW_SPAN * 4];
+
+	readInputRows(inputValue, inputColor1, inputColor2, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		const float *in1 = &inputColor1[i * 4];
+		const float *in2 = &inputColor2[i * 4];
+		const float value = inputValue[i * 4];
+		float *out = &output[i * 4];
+
+		const float valuem = 1.0f - value;
+		out[0] = 1.0f - (valuem + value * (1.0f - in2[0])) * (1.0f - in1[0]);
+		out[1] = 1.0f - (valuem + value * (1.0f - in2[1])) * (1.0f - in1[1]);
+		out[2] = 1.0f - (valuem + value * (1.0f - in2[2])) * (1.0f - in1[2]);
+		out[3] = in1[3];
+	}
+
+	clampRowIfNeeded(output, length);
+}
+
 /* ******** Mix Soft Light Operation ******** */
 
 MixSoftLightOperation::MixSoftLightOperation() : MixBaseOperation()
@@ -806,6 +914,29 @@ void MixSubtractOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MixSubtractOperation::executeRow(float *output, int x, int y, int length)
+{
+	float inputColor1[COM_ROW_SPAN * 4];
+	float inputColor2[COM_ROW_SPAN * 4];
+	float inputValue[COM_ROW_SPAN * 4];
+
+	readInputRows(inputValue, inputColor1, inputColor2, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		const float *in1 = &inputColor1[i * 4];
+		const float *in2 = &inputColor2[i * 4];
+		const float value = inputValue[i * 4];
+		float *out = &output[i * 4];
+
+		out[0] = in1[0] - value * (in2[0]);
+		out[1] = in1[1] - value * (in2[1]);
+		out[2] = in1[2] - value * (in2[2]);
+		out[3] = in1[3];
+	}
+
+	clampRowIfNeeded(output, length);
+}
+
 /* ******** Mix Value Operation ******** */
 
 MixValueOperation::MixValueOperation() : MixBaseOperation()
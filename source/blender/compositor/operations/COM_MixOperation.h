@@ -50,6 +50,21 @@ protected:
 			CLAMP(color[3], 0.0f, 1.0f);
 		}
 	}
+
+	inline void clampRowIfNeeded(float *output, int length)
+	{
+		if (m_useClamp) {
+			for (int i = 0; i < length * 4; i++) {
+				CLAMP(output[i], 0.0f, 1.0f);
+			}
+		}
+	}
+
+	/**
+	 * read a span of the value and both color inputs, the value is
+	 * already multiplied by the alpha of the second color when needed.
+	 */
+	void readInputRows(float *value, float *color1, float *color2, int x, int y, int length);
 	
 public:
 	/**
@@ -84,12 +99,14 @@ class MixAddOperation : public MixBaseOperation {
 public:
 	MixAddOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRow(float *output, int x, int y, int length);
 };
 
 class MixBlendOperation : public MixBaseOperation {
 public:
 	MixBlendOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRow(float *output, int x, int y, int length);
 };
 
 class MixBurnOperation : public MixBaseOperation {
@@ -156,6 +173,7 @@ class MixMultiplyOperation : public MixBaseOperation {
 public:
 	MixMultiplyOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRow(float *output, int x, int y, int length);
 };
 
 class MixOverlayOperation : public MixBaseOperation {
@@ -174,6 +192,7 @@ class MixScreenOperation : public MixBaseOperation {
 public:
 	MixScreenOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRow(float *output, int x, int y, int length);
 };
 
 class MixSoftLightOperation : public MixBaseOperation {
@@ -186,6 +205,7 @@ class MixSubtractOperation : public MixBaseOperation {
 public:
 	MixSubtractOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRow(float *output, int x, int y, int length);
 };
 
 class MixValueOperation : public MixBaseOperation {
@@ -74,6 +74,22 @@ void ReadBufferOperation::executePixelSampled(float output[4], float x, float y,
 	}
 }
 
+void ReadBufferOperation::executeRow(float *output, int x, int y, int length)
+{
+	if (m_single_value) {
+		/* write buffer has a single value stored at (0,0) */
+		float value[4];
+		m_buffer->read(value, 0, 0);
+		const int num_channels = m_buffer->get_num_channels();
+		for (int i = 0; i < length; i++) {
+			memcpy(&output[i * 4], value, sizeof(float) * num_channels);
+		}
+	}
+	else {
+		m_buffer->readRow(output, x, y, length);
+	}
+}
+
 void ReadBufferOperation::executePixelExtend(float output[4], float x, float y, PixelSampler sampler,
                                              MemoryBufferExtend extend_x, MemoryBufferExtend extend_y)
 {
@@ -171,6 +171,33 @@ void RenderLayersProg::executePixelSampled(float output[4], float x, float y, Pi
 	}
 }
 
+void RenderLayersProg::doRowInterpolation(float *output, int x, int y, int length)
+{
+	const int width = this->getWidth(), height = this->getHeight();
+	const int elemsize = this->m_elementsize;
+
+	for (int i = 0; i < length; i++) {
+		const int ix = x + i;
+		float *out = &output[i * 4];
+		if (this->m_inputBuffer == NULL || ix < 0 || y < 0 || ix >= width || y >= height) {
+			for (int c = 0; c < elemsize; c++) {
+				out[c] = 0.0f;
+			}
+		}
+		else {
+			const float *in = &this->m_inputBuffer[(y * width + ix) * elemsize];
+			for (int c = 0; c < elemsize; c++) {
+				out[c] = in[c];
+			}
+		}
+	}
+}
+
+void RenderLayersProg::executeRow(float *output, int x, int y, int length)
+{
+	doRowInterpolation(output, x, y, length);
+}
+
 void RenderLayersProg::deinitExecution()
 {
 	this->m_inputBuffer = NULL;
@@ -217,6 +244,14 @@ void RenderLayersAOOperation::executePixelSampled(float output[4], float x, floa
 	output[3] = 1.0f;
 }
 
+void RenderLayersAOOperation::executeRow(float *output, int x, int y, int length)
+{
+	doRowInterpolation(output, x, y, length);
+	for (int i = 0; i < length; i++) {
+		output[i * 4 + 3] = 1.0f;
+	}
+}
+
 /* ******** Render Layers Alpha Operation ******** */
 void RenderLayersAlphaProg::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
@@ -232,6 +267,22 @@ void RenderLayersAlphaProg::executePixelSampled(float output[4], float x, float
 	}
 }
 
+void RenderLayersAlphaProg::executeRow(float *output, int x, int y, int length)
+{
+	if (this->getInputBuffer() == NULL) {
+		for (int i = 0; i < length; i++) {
+			output[i * 4] = 0.0f;
+		}
+	}
+	else {
+		float temp[COM_ROW_SPAN * 4];
+		doRowInterpolation(temp, x, y, length);
+		for (int i = 0; i < length; i++) {
+			output[i * 4] = temp[i * 4 + 3];
+		}
+	}
+}
+
 /* ******** Render Layers Depth Operation ******** */
 void RenderLayersDepthProg::executePixelSampled(float output[4], float x, float y, PixelSampler /*sampler*/)
 {
@@ -247,3 +298,19 @@ void RenderLayersDepthProg::executePixelSampled(float output[4], float x, float
 		output[0] = inputBuffer[offset];
 	}
 }
+
+void RenderLayersDepthProg::executeRow(float *output, int x, int y, int length)
+{
+	const int width = this->getWidth(), height = this->getHeight();
+	float *inputBuffer = this->getInputBuffer();
+
+	for (int i = 0; i < length; i++) {
+		const int ix = x + i;
+		if (inputBuffer == NULL || ix < 0 || y < 0 || ix >= width || y >= height) {
+			output[i * 4] = 10e10f;
+		}
+		else {
+			output[i * 4] = inputBuffer[y * width + ix];
+		}
+	}
+}
@@ -83,6 +83,11 @@ protected:
 	inline float *getInputBuffer() { return this->m_inputBuffer; }
 
 	void doInterpolation(float output[4], float x, float y, PixelSampler sampler);
+	/**
+	 * nearest sampled span of a row, pixels outside the render result or
+	 * missing render passes are zero.
+	 */
+	void doRowInterpolation(float *output, int x, int y, int length);
 public:
 	/**
 	 * Constructor
@@ -103,6 +108,7 @@ public:
 	void initExecution();
 	void deinitExecution();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRow(float *output, int x, int y, int length);
 };
 
 class RenderLayersAOOperation : public RenderLayersProg {
@@ -110,6 +116,7 @@ public:
 	RenderLayersAOOperation(const char *passName, DataType type, int elementsize)
 	 : RenderLayersProg(passName, type, elementsize) {}
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRow(float *output, int x, int y, int length);
 };
 
 class RenderLayersAlphaProg : public RenderLayersProg {
@@ -117,6 +124,7 @@ public:
 	RenderLayersAlphaProg(const char *passName, DataType type, int elementsize)
 	 : RenderLayersProg(passName, type, elementsize) {}
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRow(float *output, int x, int y, int length);
 };
 
 class RenderLayersDepthProg : public RenderLayersProg {
@@ -124,6 +132,7 @@ public:
 	RenderLayersDepthProg(const char *passName, DataType type, int elementsize)
 	 : RenderLayersProg(passName, type, elementsize) {}
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRow(float *output, int x, int y, int length);
 };
 
 #endif
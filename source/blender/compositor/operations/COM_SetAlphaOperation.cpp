@@ -48,6 +48,18 @@ void SetAlphaOperation::executePixelSampled(float output[4], float x, float y, P
 	output[3] = alphaInput[0];
 }
 
+void SetAlphaOperation::executeRow(float *output, int x, int y, int length)
+{
+	float alphaInput[COM_ROW_SPAN * 4];
+
+	this->m_inputColor->readRow(output, x, y, length);
+	this->m_inputAlpha->readRow(alphaInput, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		output[i * 4 + 3] = alphaInput[i * 4];
+	}
+}
+
 void SetAlphaOperation::deinitExecution()
 {
 	this->m_inputColor = NULL;
@@ -34,6 +34,13 @@ void SetColorOperation::executePixelSampled(float output[4],
 	copy_v4_v4(output, this->m_color);
 }
 
+void SetColorOperation::executeRow(float *output, int /*x*/, int /*y*/, int length)
+{
+	for (int i = 0; i < length; i++) {
+		copy_v4_v4(&output[i * 4], this->m_color);
+	}
+}
+
 void SetColorOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
 {
 	resolution[0] = preferredResolution[0];
@@ -101,6 +101,36 @@ void ViewerOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
 	int y;
 	bool breaked = false;
 
+	if (this->isRowExecution()) {
+		float alpha_row[COM_ROW_SPAN * 4], depth_row[COM_ROW_SPAN * 4];
+
+		for (y = y1; y < y2 && (!breaked); y++) {
+			for (x = x1; x < x2; x += COM_ROW_SPAN) {
+				const int length = min(COM_ROW_SPAN, x2 - x);
+				offset = y * this->getWidth() + x;
+				offset4 = offset * 4;
+
+				/* the output buffer has 4 floats per pixel too, so read directly into it */
+				this->m_imageInput->readRow(&buffer[offset4], x, y, length);
+				if (this->m_useAlphaInput) {
+					this->m_alphaInput->readRow(alpha_row, x, y, length);
+					for (int i = 0; i < length; i++) {
+						buffer[offset4 + i * 4 + 3] = alpha_row[i * 4];
+					}
+				}
+				this->m_depthInput->readRow(depth_row, x, y, length);
+				for (int i = 0; i < length; i++) {
+					depthbuffer[offset + i] = depth_row[i * 4];
+				}
+			}
+			if (isBreaked()) {
+				breaked = true;
+			}
+		}
+		updateImage(rect);
+		return;
+	}
+
 	for (y = y1; y < y2 && (!breaked); y++) {
 		for (x = x1; x < x2; x++) {
 			this->m_imageInput->readSampled(&(buffer[offset4]), x, y, COM_PS_NEAREST);
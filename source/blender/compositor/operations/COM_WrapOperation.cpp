@@ -74,6 +74,12 @@ void WrapOperation::executePixelSampled(float output[4], float x, float y, Pixel
 	executePixelExtend(output, nx, ny, sampler, extend_x, extend_y);
 }
 
+void WrapOperation::executeRow(float *output, int x, int y, int length)
+{
+	/* wrapping is done per pixel, don't use the row read of the buffer */
+	SocketReader::executeRow(output, x, y, length);
+}
+
 bool WrapOperation::determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output)
 {
 	rcti newInput;
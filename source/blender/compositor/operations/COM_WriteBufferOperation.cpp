@@ -25,12 +25,17 @@
 #include <stdio.h>
 #include "COM_OpenCLDevice.h"
 
+#include "PIL_time.h"
+
+#include "atomic_ops.h"
+
 WriteBufferOperation::WriteBufferOperation(DataType datatype) : NodeOperation()
 {
 	this->addInputSocket(datatype);
 	this->m_memoryProxy = new MemoryProxy(datatype);
 	this->m_memoryProxy->setWriteBufferOperation(this);
 	this->m_memoryProxy->setExecutor(NULL);
+	this->m_executionTime = 0;
 }
 WriteBufferOperation::~WriteBufferOperation()
 {
@@ -49,6 +54,7 @@ void WriteBufferOperation::initExecution()
 {
 	this->m_input = this->getInputOperation(0);
 	this->m_memoryProxy->allocate(this->m_width, this->m_height);
+	this->m_executionTime = 0;
 }
 
 void WriteBufferOperation::deinitExecution()
@@ -59,10 +65,44 @@ void WriteBufferOperation::deinitExecution()
 
 void WriteBufferOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
 {
+	const double start_time = PIL_check_seconds_timer();
 	MemoryBuffer *memoryBuffer = this->m_memoryProxy->getBuffer();
 	float *buffer = memoryBuffer->getBuffer();
 	const int num_channels = memoryBuffer->get_num_channels();
-	if (this->m_input->isComplex()) {
+	if (this->m_input->isComplex() && this->isRowExecution()) {
+		float row[COM_ROW_SPAN * COM_NUM_CHANNELS_COLOR];
+		void *data = this->m_input->initializeTileData(rect);
+		int x1 = rect->xmin;
+		int y1 = rect->ymin;
+		int x2 = rect->xmax;
+		int y2 = rect->ymax;
+		int x;
+		int y;
+		bool breaked = false;
+		for (y = y1; y < y2 && (!breaked); y++) {
+			for (x = x1; x < x2; x += COM_ROW_SPAN) {
+				const int length = min(COM_ROW_SPAN, x2 - x);
+				float *out = &buffer[(y * memoryBuffer->getWidth() + x) * num_channels];
+				this->m_input->readTileRow(row, x, y, length, data);
+				if (num_channels == COM_NUM_CHANNELS_COLOR) {
+					memcpy(out, row, sizeof(float) * length * COM_NUM_CHANNELS_COLOR);
+				}
+				else {
+					for (int i = 0; i < length; i++) {
+						memcpy(&out[i * num_channels], &row[i * COM_NUM_CHANNELS_COLOR], sizeof(float) * num_channels);
+					}
+				}
+			}
+			if (isBreaked()) {
+				breaked = true;
+			}
+		}
+		if (data) {
+			this->m_input->deinitializeTileData(rect, data);
+			data = NULL;
+		}
+	}
+	else if (this->m_input->isComplex()) {
 		void *data = this->m_input->initializeTileData(rect);
 		int x1 = rect->xmin;
 		int y1 = rect->ymin;
@@ -87,6 +127,35 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/
 			data = NULL;
 		}
 	}
+	else if (this->isRowExecution()) {
+		float row[COM_ROW_SPAN * COM_NUM_CHANNELS_COLOR];
+		int x1 = rect->xmin;
+		int y1 = rect->ymin;
+		int x2 = rect->xmax;
+		int y2 = rect->ymax;
+
+		int x;
+		int y;
+		bool breaked = false;
+		for (y = y1; y < y2 && (!breaked); y++) {
+			for (x = x1; x < x2; x += COM_ROW_SPAN) {
+				const int length = min(COM_ROW_SPAN, x2 - x);
+				float *out = &buffer[(y * memoryBuffer->getWidth() + x) * num_channels];
+				this->m_input->readRow(row, x, y, length);
+				if (num_channels == COM_NUM_CHANNELS_COLOR) {
+					memcpy(out, row, sizeof(float) * length * COM_NUM_CHANNELS_COLOR);
+				}
+				else {
+					for (int i = 0; i < length; i++) {
+						memcpy(&out[i * num_channels], &row[i * COM_NUM_CHANNELS_COLOR], sizeof(float) * num_channels);
+					}
+				}
+			}
+			if (isBreaked()) {
+				breaked = true;
+			}
+		}
+	}
 	else {
 		int x1 = rect->xmin;
 		int y1 = rect->ymin;
@@ -108,6 +177,9 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/
 		}
 	}
 	memoryBuffer->setCreatedState();
+
+	const uint64_t time = (uint64_t)((PIL_check_seconds_timer() - start_time) * 1000000.0);
+	atomic_add_and_fetch_uint64(&this->m_executionTime, time);
 }
 
 void WriteBufferOperation::executeOpenCLRegion(OpenCLDevice *device, rcti * /*rect*/, unsigned int /*chunkNumber*/,
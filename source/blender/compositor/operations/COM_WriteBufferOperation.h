@@ -34,6 +34,10 @@ class WriteBufferOperation : public NodeOperation {
 	MemoryProxy *m_memoryProxy;
 	bool m_single_value; /* single value stored in buffer */
 	NodeOperation *m_input;
+	/**
+	 * @brief time spent calculating the regions of this buffer, summed over all threads (microseconds)
+	 */
+	uint64_t m_executionTime;
 public:
 	WriteBufferOperation(DataType datatype);
 	~WriteBufferOperation();
@@ -52,5 +56,10 @@ public:
 		return m_input;
 	}
 
+	/**
+	 * @brief time spent calculating this buffer on the CPU in seconds, summed over all threads
+	 */
+	double getExecutionTime() const { return this->m_executionTime / 1000000.0; }
+
 };
 #endif
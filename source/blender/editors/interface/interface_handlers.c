@@ -69,6 +69,7 @@
 #include "BKE_idprop.h"
 #include "BKE_report.h"
 #include "BKE_screen.h"
+#include "BKE_sequencer.h"
 #include "BKE_tracking.h"
 #include "BKE_unit.h"
 #include "BKE_paint.h"
@@ -2091,6 +2092,11 @@ static void ui_apply_but(bContext *C, uiBlock *block, uiBut *but, uiHandleButton
 #endif
 	}
 
+	/* the sequencer prefetches frames from the scene data in worker threads */
+	if (but->rnapoin.id.data && GS(((ID *)but->rnapoin.id.data)->name) == ID_SCE) {
+		BKE_sequencer_prefetch_stop();
+	}
+
 	/* ensures we are writing actual values */
 	editstr = but->editstr;
 	editval = but->editval;
@@ -4004,6 +4004,9 @@ void uiTemplateColormanagedViewSettings(uiLayout *layout, bContext *UNUSED(C), P
 	uiItemR(col, &view_transform_ptr, "use_curve_mapping", 0, NULL, ICON_NONE);
 	if (view_settings->flag & COLORMANAGE_VIEW_USE_CURVES)
 		uiTemplateCurveMapping(col, &view_transform_ptr, "curve_mapping", 'c', true, false, false);
+
+	col = uiLayoutColumn(layout, false);
+	uiItemR(col, &view_transform_ptr, "use_exact_transform", 0, NULL, ICON_NONE);
 }
 
 /********************************* Component Menu *************************************/
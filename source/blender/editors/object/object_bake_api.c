@@ -246,6 +246,7 @@ static bool write_internal_bake_pixels(
 		RE_bake_margin(ibuf, mask_buffer, margin);
 
 	ibuf->userflags |= IB_DISPLAY_BUFFER_INVALID | IB_BITMAPDIRTY;
+	IMB_generation_bump(ibuf);
 
 	if (ibuf->rect_float)
 		ibuf->userflags |= IB_RECT_INVALID;
@@ -131,6 +131,8 @@ void ED_imapaint_dirty_region(Image *ima, ImBuf *ibuf, int x, int y, int w, int
 	if (w == 0 || h == 0)
 		return;
 
+	IMB_dirty_rect_tag(ibuf, x, y, x + w, y + h);
+
 	if (!imapaintpartial.enabled) {
 		imapaintpartial.x1 = x;
 		imapaintpartial.y1 = y;
@@ -154,6 +156,7 @@ void ED_imapaint_dirty_region(Image *ima, ImBuf *ibuf, int x, int y, int w, int
 			image_undo_push_tile(undo_tiles, ima, ibuf, &tmpibuf, tx, ty, NULL, NULL, false, find_old);
 
 	ibuf->userflags |= IB_BITMAPDIRTY;
+	IMB_generation_bump(ibuf);
 
 	if (tmpibuf)
 		IMB_freeImBuf(tmpibuf);
@@ -65,7 +65,6 @@
 #include "UI_view2d.h"
 
 
-#include "GPU_draw.h"
 
 #include "paint_intern.h"
 
@@ -1362,8 +1361,7 @@ void paint_2d_redraw(const bContext *C, void *ps, bool final)
 	}
 
 	if (final) {
-		if (s->image && !(s->sima && s->sima->lock))
-			GPU_free_image(s->image);
+		/* the painted region is tagged dirty and uploaded when the texture is drawn next */
 
 		/* compositor listener deals with updating */
 		WM_event_add_notifier(C, NC_IMAGE | NA_EDITED, s->image);
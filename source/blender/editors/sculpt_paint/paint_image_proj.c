@@ -1514,6 +1514,7 @@ static int project_paint_undo_subtiles(const TileInfo *tinf, int tx, int ty)
 		}
 
 		pjIma->ibuf->userflags |= IB_BITMAPDIRTY;
+		IMB_generation_bump(pjIma->ibuf);
 		/* tile ready, publish */
 		if (tinf->lock)
 			BLI_spin_lock(tinf->lock);
@@ -246,6 +246,19 @@ void image_undo_remove_masks(void)
 	}
 }
 
+/* only the restored pixels are uploaded to the texture when it is drawn next */
+static void image_undo_tag_gpu(Image *ima, ImBuf *ibuf, UndoImageTile *tile)
+{
+	if (BKE_image_is_animated(ima)) {
+		/* the texture may be of another frame */
+		GPU_free_image(ima);
+	}
+	else {
+		IMB_dirty_rect_tag(ibuf, tile->x * IMAPAINT_TILE_SIZE, tile->y * IMAPAINT_TILE_SIZE,
+		                   (tile->x + 1) * IMAPAINT_TILE_SIZE, (tile->y + 1) * IMAPAINT_TILE_SIZE);
+	}
+}
+
 static void image_undo_restore_runtime(ListBase *lb)
 {
 	ImBuf *ibuf, *tmpibuf;
@@ -260,7 +273,7 @@ static void image_undo_restore_runtime(ListBase *lb)
 
 		undo_copy_tile(tile, tmpibuf, ibuf, RESTORE);
 
-		GPU_free_image(ima); /* force OpenGL reload (maybe partial update will operate better?) */
+		image_undo_tag_gpu(ima, ibuf, tile);
 		if (ibuf->rect_float) {
 			ibuf->userflags |= IB_RECT_INVALID; /* force recreate of char rect */
 		}
@@ -319,7 +332,7 @@ static void image_undo_restore_list(ListBase *lb, struct UndoIDPtrMap *id_map)
 
 		undo_copy_tile(tile, tmpibuf, ibuf, RESTORE_COPY);
 
-		GPU_free_image(ima); /* force OpenGL reload */
+		image_undo_tag_gpu(ima, ibuf, tile);
 		if (ibuf->rect_float) {
 			ibuf->userflags |= IB_RECT_INVALID; /* force recreate of char rect */
 		}
@@ -250,8 +250,7 @@ typedef struct FileListEntryCache {
 	GHash *uuids;
 
 	/* Previews handling. */
-	TaskPool *previews_pool;
-	ThreadQueue *previews_done;
+	ThumbBatch *previews_batch;
 } FileListEntryCache;
 
 /* FileListCache.flags */
@@ -260,13 +259,6 @@ enum {
 	FLC_PREVIEWS_ACTIVE      = 1 << 1,
 };
 
-typedef struct FileListEntryPreview {
-	char path[FILE_MAX];
-	unsigned int flags;
-	int index;
-	ImBuf *img;
-} FileListEntryPreview;
-
 typedef struct FileListFilter {
 	unsigned int filter;
 	unsigned int filter_id;
@@ -1086,107 +1078,64 @@ static void filelist_intern_free(FileListIntern *filelist_intern)
 	MEM_SAFE_FREE(filelist_intern->filtered);
 }
 
-static void filelist_cache_preview_runf(TaskPool *__restrict pool, void *taskdata, int UNUSED(threadid))
+static ThumbSource filelist_cache_preview_source(const unsigned int typeflag)
 {
-	FileListEntryCache *cache = BLI_task_pool_userdata(pool);
-	FileListEntryPreview *preview = taskdata;
-
-	ThumbSource source = 0;
-
-//	printf("%s: Start (%d)...\n", __func__, threadid);
-
-//	printf("%s: %d - %s - %p\n", __func__, preview->index, preview->path, preview->img);
-	BLI_assert(preview->flags & (FILE_TYPE_IMAGE | FILE_TYPE_MOVIE | FILE_TYPE_FTFONT |
-	                             FILE_TYPE_BLENDER | FILE_TYPE_BLENDER_BACKUP | FILE_TYPE_BLENDERLIB));
-
-	if (preview->flags & FILE_TYPE_IMAGE) {
-		source = THB_SOURCE_IMAGE;
+	if (typeflag & FILE_TYPE_IMAGE) {
+		return THB_SOURCE_IMAGE;
 	}
-	else if (preview->flags & (FILE_TYPE_BLENDER | FILE_TYPE_BLENDER_BACKUP | FILE_TYPE_BLENDERLIB)) {
-		source = THB_SOURCE_BLEND;
+	else if (typeflag & (FILE_TYPE_BLENDER | FILE_TYPE_BLENDER_BACKUP | FILE_TYPE_BLENDERLIB)) {
+		return THB_SOURCE_BLEND;
 	}
-	else if (preview->flags & FILE_TYPE_MOVIE) {
-		source = THB_SOURCE_MOVIE;
+	else if (typeflag & FILE_TYPE_MOVIE) {
+		return THB_SOURCE_MOVIE;
 	}
-	else if (preview->flags & FILE_TYPE_FTFONT) {
-		source = THB_SOURCE_FONT;
+	else if (typeflag & FILE_TYPE_FTFONT) {
+		return THB_SOURCE_FONT;
 	}
 
-	IMB_thumb_path_lock(preview->path);
-	preview->img = IMB_thumb_manage(preview->path, THB_LARGE, source);
-	IMB_thumb_path_unlock(preview->path);
-
-	/* Used to tell free func to not free anything.
-	 * Note that we do not care about cas result here,
-	 * we only want value attribution itself to be atomic (and memory barier).*/
-	atomic_cas_uint32(&preview->flags, preview->flags, 0);
-	BLI_thread_queue_push(cache->previews_done, preview);
-
-//	printf("%s: End (%d)...\n", __func__, threadid);
-}
-
-static void filelist_cache_preview_freef(TaskPool * __restrict UNUSED(pool), void *taskdata, int UNUSED(threadid))
-{
-	FileListEntryPreview *preview = taskdata;
-
-	/* If preview->flag is empty, it means that preview has already been generated and added to done queue,
-	 * we do not own it anymore. */
-	if (preview->flags) {
-		if (preview->img) {
-			IMB_freeImBuf(preview->img);
-		}
-		MEM_freeN(preview);
-	}
+	BLI_assert(0);
+	return THB_SOURCE_IMAGE;
 }
 
 static void filelist_cache_preview_ensure_running(FileListEntryCache *cache)
 {
-	if (!cache->previews_pool) {
-		TaskScheduler *scheduler = BLI_task_scheduler_get();
+	if (!cache->previews_batch) {
+		cache->previews_batch = IMB_thumb_batch_create(THB_LARGE, 0);
 
-		cache->previews_pool = BLI_task_pool_create_background(scheduler, cache);
-		cache->previews_done = BLI_thread_queue_init();
-
-		IMB_thumb_locks_acquire();
+		if (G.debug & G_DEBUG_IO) {
+			IMB_thumb_stats_reset();
+		}
 	}
 }
 
 static void filelist_cache_previews_clear(FileListEntryCache *cache)
 {
-	FileListEntryPreview *preview;
-
-	if (cache->previews_pool) {
-		BLI_task_pool_cancel(cache->previews_pool);
-
-		while ((preview = BLI_thread_queue_pop_timeout(cache->previews_done, 0))) {
-//			printf("%s: DONE %d - %s - %p\n", __func__, preview->index, preview->path, preview->img);
-			if (preview->img) {
-				IMB_freeImBuf(preview->img);
-			}
-			MEM_freeN(preview);
-		}
+	if (cache->previews_batch) {
+		/* Previews being generated are still delivered, update ignores the ones not cached anymore. */
+		IMB_thumb_batch_cancel(cache->previews_batch);
 	}
 }
 
 static void filelist_cache_previews_free(FileListEntryCache *cache)
 {
-	if (cache->previews_pool) {
-		BLI_thread_queue_nowait(cache->previews_done);
-
-		filelist_cache_previews_clear(cache);
+	if (cache->previews_batch) {
+		IMB_thumb_batch_free(cache->previews_batch);
+		cache->previews_batch = NULL;
 
-		BLI_thread_queue_free(cache->previews_done);
-		BLI_task_pool_free(cache->previews_pool);
-		cache->previews_pool = NULL;
-		cache->previews_done = NULL;
+		if (G.debug & G_DEBUG_IO) {
+			ThumbStats stats;
 
-		IMB_thumb_locks_release();
+			IMB_thumb_stats_get(&stats);
+			printf("%s: thumbnails: %u hits, %u generated, %u failed, %.3fs generating\n", __func__,
+			       stats.hits, stats.misses, stats.failures, stats.generate_time);
+		}
 	}
 
 	cache->flags &= ~FLC_PREVIEWS_ACTIVE;
 }
 
-static void filelist_cache_previews_push(FileList *filelist, FileDirEntry *entry, const int index)
+/* distance is the number of items to the (assumed visible) center, nearest ones are generated first */
+static void filelist_cache_previews_push(FileList *filelist, FileDirEntry *entry, const int index, const int distance)
 {
 	FileListEntryCache *cache = &filelist->filelist_cache;
 
@@ -1197,16 +1146,13 @@ static void filelist_cache_previews_push(FileList *filelist, FileDirEntry *entry
 	    (entry->typeflag & (FILE_TYPE_IMAGE | FILE_TYPE_MOVIE | FILE_TYPE_FTFONT |
 	                        FILE_TYPE_BLENDER | FILE_TYPE_BLENDER_BACKUP | FILE_TYPE_BLENDERLIB)))
 	{
-		FileListEntryPreview *preview = MEM_mallocN(sizeof(*preview), __func__);
-		BLI_join_dirfile(preview->path, sizeof(preview->path), filelist->filelist.root, entry->relpath);
-		preview->index = index;
-		preview->flags = entry->typeflag;
-		preview->img = NULL;
-//		printf("%s: %d - %s - %p\n", __func__, preview->index, preview->path, preview->img);
+		char path[FILE_MAX];
+
+		BLI_join_dirfile(path, sizeof(path), filelist->filelist.root, entry->relpath);
 
 		filelist_cache_preview_ensure_running(cache);
-		BLI_task_pool_push_ex(cache->previews_pool, filelist_cache_preview_runf, preview,
-		                      true, filelist_cache_preview_freef, TASK_PRIORITY_LOW);
+		IMB_thumb_batch_push(cache->previews_batch, path, filelist_cache_preview_source(entry->typeflag),
+		                     (float)distance, SET_INT_IN_POINTER(index));
 	}
 }
 
@@ -1539,8 +1485,8 @@ static FileDirEntry *filelist_file_ex(struct FileList *filelist, const int index
 	cache->misc_cursor = (cache->misc_cursor + 1) % cache_size;
 
 #if 0  /* Actually no, only block cached entries should have preview imho. */
-	if (cache->previews_pool) {
-		filelist_cache_previews_push(filelist, ret, index);
+	if (cache->previews_batch) {
+		filelist_cache_previews_push(filelist, ret, index, 0);
 	}
 #endif
 
@@ -1843,11 +1789,11 @@ bool filelist_file_cache_block(struct FileList *filelist, const int index)
 		for (i = 0; ((index + i) < end_index) || ((index - i) >= start_index); i++) {
 			if ((index - i) >= start_index) {
 				const int idx = (cache->block_cursor + (index - start_index) - i) % cache_size;
-				filelist_cache_previews_push(filelist, cache->block_entries[idx], index - i);
+				filelist_cache_previews_push(filelist, cache->block_entries[idx], index - i, i);
 			}
 			if ((index + i) < end_index) {
 				const int idx = (cache->block_cursor + (index - start_index) + i) % cache_size;
-				filelist_cache_previews_push(filelist, cache->block_entries[idx], index + i);
+				filelist_cache_previews_push(filelist, cache->block_entries[idx], index + i, i);
 			}
 		}
 	}
@@ -1870,7 +1816,7 @@ void filelist_cache_previews_set(FileList *filelist, const bool use_previews)
 	else if (use_previews && (filelist->flags & FL_IS_READY)) {
 		cache->flags |= FLC_PREVIEWS_ACTIVE;
 
-		BLI_assert((cache->previews_pool == NULL) && (cache->previews_done == NULL));
+		BLI_assert(cache->previews_batch == NULL);
 
 //		printf("%s: Init Previews...\n", __func__);
 
@@ -1886,37 +1832,30 @@ void filelist_cache_previews_set(FileList *filelist, const bool use_previews)
 bool filelist_cache_previews_update(FileList *filelist)
 {
 	FileListEntryCache *cache = &filelist->filelist_cache;
-	TaskPool *pool = cache->previews_pool;
+	ThumbBatch *batch = cache->previews_batch;
+	ImBuf *img;
+	void *index_p;
 	bool changed = false;
 
-	if (!pool) {
+	if (!batch) {
 		return changed;
 	}
 
 //	printf("%s: Update Previews...\n", __func__);
 
-	while (!BLI_thread_queue_is_empty(cache->previews_done)) {
-		FileListEntryPreview *preview = BLI_thread_queue_pop(cache->previews_done);
-		FileDirEntry *entry;
-
-		/* Paranoid (should never happen currently since we consume this queue from a single thread), but... */
-		if (!preview) {
-			continue;
-		}
+	while (IMB_thumb_batch_pop(batch, &img, &index_p)) {
 		/* entry might have been removed from cache in the mean time, we do not want to cache it again here. */
-		entry = filelist_file_ex(filelist, preview->index, false);
-
-//		printf("%s: %d - %s - %p\n", __func__, preview->index, preview->path, preview->img);
+		FileDirEntry *entry = filelist_file_ex(filelist, GET_INT_FROM_POINTER(index_p), false);
 
-		if (preview->img) {
+		if (img) {
 			/* Due to asynchronous process, a preview for a given image may be generated several times, i.e.
 			 * entry->image may already be set at this point. */
 			if (entry && !entry->image) {
-				entry->image = preview->img;
+				entry->image = img;
 				changed = true;
 			}
 			else {
-				IMB_freeImBuf(preview->img);
+				IMB_freeImBuf(img);
 			}
 		}
 		else if (entry) {
@@ -1924,8 +1863,6 @@ bool filelist_cache_previews_update(FileList *filelist)
 			 * Note that, since entries only live in cache, preview will be retried quite often anyway. */
 			entry->flags |= FILE_ENTRY_INVALID_PREVIEW;
 		}
-
-		MEM_freeN(preview);
 	}
 
 	return changed;
@@ -1935,7 +1872,7 @@ bool filelist_cache_previews_running(FileList *filelist)
 {
 	FileListEntryCache *cache = &filelist->filelist_cache;
 
-	return (cache->previews_pool != NULL);
+	return (cache->previews_batch != NULL);
 }
 
 /* would recognize .blend as well */
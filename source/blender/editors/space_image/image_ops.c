@@ -1745,6 +1745,7 @@ static void save_image_post(
 			}
 
 			ibuf->userflags &= ~IB_BITMAPDIRTY;
+			IMB_generation_bump(ibuf);
 
 			/* change type? */
 			if (ima->type == IMA_TYPE_R_RESULT) {
@@ -2307,6 +2308,7 @@ static int image_save_sequence_exec(bContext *C, wmOperator *op)
 
 			BKE_reportf(op->reports, RPT_INFO, "Saved %s", ibuf->name);
 			ibuf->userflags &= ~IB_BITMAPDIRTY;
+			IMB_generation_bump(ibuf);
 		}
 
 		IMB_moviecacheIter_step(iter);
@@ -2660,6 +2662,7 @@ static int image_invert_exec(bContext *C, wmOperator *op)
 	}
 
 	ibuf->userflags |= IB_BITMAPDIRTY | IB_DISPLAY_BUFFER_INVALID;
+	IMB_generation_bump(ibuf);
 
 	if (ibuf->mipmap[0])
 		ibuf->userflags |= IB_MIPMAP_INVALID;
@@ -53,6 +53,10 @@
 #include "BKE_sound.h"
 #include "BKE_scene.h"
 
+#include "BLF_api.h"
+
+#include "BLT_translation.h"
+
 #include "IMB_colormanagement.h"
 #include "IMB_imbuf.h"
 
@@ -909,14 +913,13 @@ void ED_sequencer_special_preview_clear(void)
 	sequencer_special_update_set(NULL);
 }
 
-ImBuf *sequencer_ibuf_get(struct Main *bmain, Scene *scene, SpaceSeq *sseq, int cfra, int frame_ofs, const char *viewname)
+/* render data used for the preview of the space, returns false when nothing is to be rendered */
+bool sequencer_render_data_get(struct Main *bmain, Scene *scene, SpaceSeq *sseq, const char *viewname,
+                               SeqRenderData *r_context)
 {
-	SeqRenderData context = {0};
-	ImBuf *ibuf;
 	int rectx, recty;
 	float render_size;
 	float proxy_size = 100.0;
-	short is_break = G.is_break;
 
 	render_size = sseq->render_size;
 	if (render_size == 0) {
@@ -927,7 +930,7 @@ ImBuf *sequencer_ibuf_get(struct Main *bmain, Scene *scene, SpaceSeq *sseq, int
 	}
 
 	if (render_size < 0) {
-		return NULL;
+		return false;
 	}
 
 	rectx = (render_size * (float)scene->r.xsch) / 100.0f + 0.5f;
@@ -936,8 +939,22 @@ ImBuf *sequencer_ibuf_get(struct Main *bmain, Scene *scene, SpaceSeq *sseq, int
 	BKE_sequencer_new_render_data(
 	        bmain->eval_ctx, bmain, scene,
 	        rectx, recty, proxy_size,
-	        &context);
-	context.view_id = BKE_scene_multiview_view_id_get(&scene->r, viewname);
+	        r_context);
+	r_context->view_id = BKE_scene_multiview_view_id_get(&scene->r, viewname);
+
+	return true;
+}
+
+ImBuf *sequencer_ibuf_get(struct Main *bmain, Scene *scene, SpaceSeq *sseq, int cfra, int frame_ofs, const char *viewname)
+{
+	SeqRenderData context = {0};
+	ImBuf *ibuf;
+	short is_break = G.is_break;
+
+	if (!sequencer_render_data_get(bmain, scene, sseq, viewname, &context)) {
+		return NULL;
+	}
+
 	if (scene->r.seq_flag & R_SEQ_CAMERA_DOF) {
 		if (sseq->compositor == NULL) {
 			sseq->compositor = GPU_fx_compositor_create();
@@ -952,10 +969,8 @@ ImBuf *sequencer_ibuf_get(struct Main *bmain, Scene *scene, SpaceSeq *sseq, int
 
 	if (special_seq_update)
 		ibuf = BKE_sequencer_give_ibuf_direct(&context, cfra + frame_ofs, special_seq_update);
-	else if (!U.prefetchframes) // XXX || (G.f & G_PLAYANIM) == 0) {
-		ibuf = BKE_sequencer_give_ibuf(&context, cfra + frame_ofs, sseq->chanshown);
 	else
-		ibuf = BKE_sequencer_give_ibuf_threaded(&context, cfra + frame_ofs, sseq->chanshown);
+		ibuf = BKE_sequencer_give_ibuf(&context, cfra + frame_ofs, sseq->chanshown);
 
 	/* restore state so real rendering would be canceled (if needed) */
 	G.is_break = is_break;
@@ -1452,6 +1467,33 @@ void draw_image_seq(const bContext *C, Scene *scene, ARegion *ar, SpaceSeq *sseq
 	}
 }
 
+/* bytes which reduced preview sizes did not have to read from image files, drawn below the fps */
+void sequencer_draw_partial_read_stats(const rcti *rect)
+{
+	ImPartialReadStats stats;
+	char str_read[15], str_skipped[15];
+	char printable[128];
+
+	IMB_partial_read_stats_get(&stats);
+
+	if (stats.reads == 0) {
+		return;
+	}
+
+	BLI_str_format_byte_unit(str_read, stats.bytes_read, false);
+	BLI_str_format_byte_unit(str_skipped, stats.bytes_skipped, false);
+	BLI_snprintf(printable, sizeof(printable), IFACE_("Partial image reads: %s read, %s skipped"),
+	             str_read, str_skipped);
+
+	UI_ThemeColor(TH_TEXT_HI);
+
+#ifdef WITH_INTERNATIONAL
+	BLF_draw_default(rect->xmin + U.widget_unit, rect->ymax - 2 * U.widget_unit, 0.0f, printable, sizeof(printable));
+#else
+	BLF_draw_default_ascii(rect->xmin + U.widget_unit, rect->ymax - 2 * U.widget_unit, 0.0f, printable, sizeof(printable));
+#endif
+}
+
 #if 0
 void drawprefetchseqspace(Scene *scene, ARegion *UNUSED(ar), SpaceSeq *sseq)
 {
@@ -39,12 +39,14 @@
 struct Sequence;
 struct bContext;
 struct rctf;
+struct rcti;
 struct SpaceSeq;
 struct ScrArea;
 struct ARegion;
 struct ARegionType;
 struct Scene;
 struct Main;
+struct SeqRenderData;
 struct wmOperator;
 struct StripElem;
 
@@ -55,6 +57,7 @@ struct ARegion *sequencer_has_buttons_region(struct ScrArea *sa);
 /* sequencer_draw.c */
 void draw_timeline_seq(const struct bContext *C, struct ARegion *ar);
 void draw_image_seq(const struct bContext *C, struct Scene *scene, struct  ARegion *ar, struct SpaceSeq *sseq, int cfra, int offset, bool draw_overlay, bool draw_backdrop);
+void sequencer_draw_partial_read_stats(const struct rcti *rect);
 void color3ubv_from_seq(struct Scene *curscene, struct Sequence *seq, unsigned char col[3]);
 void draw_shadedstrip(struct Sequence *seq, unsigned char col[3], float x1, float y1, float x2, float y2);
 void draw_sequence_extensions(struct Scene *scene, struct ARegion *ar, struct Sequence *seq);
@@ -64,6 +67,8 @@ void sequencer_special_update_set(Sequence *seq);
 /* UNUSED */
 // void seq_reset_imageofs(struct SpaceSeq *sseq);
 
+bool sequencer_render_data_get(struct Main *bmain, struct Scene *scene, struct SpaceSeq *sseq, const char *viewname,
+                               struct SeqRenderData *r_context);
 struct ImBuf *sequencer_ibuf_get(struct Main *bmain, struct Scene *scene, struct SpaceSeq *sseq, int cfra, int frame_ofs, const char *viewname);
 
 /* sequencer_edit.c */
@@ -208,6 +213,9 @@ void SEQUENCER_OT_sample(struct wmOperatorType *ot);
 /* sequencer_preview.c */
 void sequencer_preview_add_sound(const struct bContext *C, struct Sequence *seq);
 
+/* sequencer_prefetch.c */
+void sequencer_start_prefetch_job(const struct bContext *C);
+
 /* sequencer_add */
 int sequencer_image_seq_get_minmax_frame(struct wmOperator *op, int sfra, int *r_minframe, int *r_numdigits);
 void sequencer_image_seq_reserve_frames(struct wmOperator *op, struct StripElem *se, int len, int minframe, int numdigits);
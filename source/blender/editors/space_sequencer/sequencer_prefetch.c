@@ -0,0 +1,263 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2017 Blender Foundation.
+ * All rights reserved.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/editors/space_sequencer/sequencer_prefetch.c
+ *  \ingroup spseq
+ *
+ * Rendering of the frames ahead of the playhead into the sequencer cache during playback.
+ */
+
+#include <stdio.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_scene_types.h"
+#include "DNA_sequence_types.h"
+#include "DNA_space_types.h"
+#include "DNA_userdef_types.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+
+#include "PIL_time.h"
+
+#include "BKE_context.h"
+#include "BKE_global.h"
+#include "BKE_main.h"
+#include "BKE_sequencer.h"
+
+#include "WM_api.h"
+#include "WM_types.h"
+
+#include "sequencer_intern.h"
+
+typedef struct PrefetchJob {
+	SeqRenderData context;
+	int start_frame, end_frame;
+	int chanshown;
+
+	/* frames are only rendered as long as the sequences don't change */
+	int generation;
+
+	/* memory which may be used by prefetched frames */
+	size_t memory_limit;
+
+	/* statistics */
+	int frames_rendered;
+	double time;
+} PrefetchJob;
+
+typedef struct PrefetchQueue {
+	PrefetchJob *pj;
+	int current_frame;
+	int frames_processed;
+	int frames_rendered;
+	size_t memory_used;
+
+	SpinLock spin;
+
+	short *stop;
+	short *do_update;
+	float *progress;
+} PrefetchQueue;
+
+/* get the next frame to render, false when prefetching is to stop */
+static bool prefetch_queue_next_frame(PrefetchQueue *queue, int *r_frame)
+{
+	bool result = false;
+
+	BLI_spin_lock(&queue->spin);
+	if (!*queue->stop && !G.is_break &&
+	    queue->current_frame <= queue->pj->end_frame &&
+	    queue->memory_used < queue->pj->memory_limit)
+	{
+		*r_frame = queue->current_frame++;
+		result = true;
+	}
+	BLI_spin_unlock(&queue->spin);
+
+	return result;
+}
+
+static void prefetch_task_func(TaskPool * __restrict pool, void *UNUSED(taskdata), int UNUSED(threadid))
+{
+	PrefetchQueue *queue = (PrefetchQueue *)BLI_task_pool_userdata(pool);
+	PrefetchJob *pj = queue->pj;
+	int frame;
+
+	while (prefetch_queue_next_frame(queue, &frame)) {
+		size_t size;
+
+		if (!BKE_sequencer_prefetch_frame(&pj->context, frame, pj->chanshown, pj->generation, &size)) {
+			/* sequences were changed, prefetching starts over from the next redraw */
+			*queue->stop = 1;
+			break;
+		}
+
+		BLI_spin_lock(&queue->spin);
+		queue->frames_processed++;
+		if (size) {
+			queue->frames_rendered++;
+			queue->memory_used += size;
+		}
+		*queue->do_update = 1;
+		*queue->progress = (float)queue->frames_processed / (pj->end_frame - pj->start_frame + 1);
+		BLI_spin_unlock(&queue->spin);
+	}
+}
+
+static void prefetch_startjob(void *pjv, short *stop, short *do_update, float *progress)
+{
+	PrefetchJob *pj = pjv;
+	PrefetchQueue queue;
+	TaskScheduler *task_scheduler = BLI_task_scheduler_get();
+	TaskPool *task_pool;
+	int i, tot_thread = BLI_task_scheduler_num_threads(task_scheduler);
+	double start_time = PIL_check_seconds_timer();
+
+	BLI_spin_init(&queue.spin);
+
+	queue.pj = pj;
+	queue.current_frame = pj->start_frame;
+	queue.frames_processed = 0;
+	queue.frames_rendered = 0;
+	queue.memory_used = 0;
+
+	queue.stop = stop;
+	queue.do_update = do_update;
+	queue.progress = progress;
+
+	/* every thread renders whole frames */
+	task_pool = BLI_task_pool_create(task_scheduler, &queue);
+	for (i = 0; i < tot_thread; i++) {
+		BLI_task_pool_push(task_pool,
+		                   prefetch_task_func,
+		                   NULL,
+		                   false,
+		                   TASK_PRIORITY_LOW);
+	}
+	BLI_task_pool_work_and_wait(task_pool);
+	BLI_task_pool_free(task_pool);
+
+	BLI_spin_end(&queue.spin);
+
+	pj->frames_rendered = queue.frames_rendered;
+	pj->time = PIL_check_seconds_timer() - start_time;
+}
+
+static void prefetch_endjob(void *pjv)
+{
+	PrefetchJob *pj = pjv;
+
+	if ((G.debug & G_DEBUG) && pj->frames_rendered && pj->time > 0.0) {
+		/* the rate at which frames are delivered is the playback rate which can be sustained */
+		printf("Sequencer prefetch: %d frames rendered in %.2f sec, %.2f fps sustained\n",
+		       pj->frames_rendered, pj->time, pj->frames_rendered / pj->time);
+	}
+}
+
+static void prefetch_freejob(void *pjv)
+{
+	PrefetchJob *pj = pjv;
+
+	MEM_freeN(pj);
+}
+
+/* returns true if early out is possible */
+static bool prefetch_check_early_out(const bContext *C, const SeqRenderData *context, int start_frame, int end_frame)
+{
+	SpaceSeq *sseq = CTX_wm_space_seq(C);
+
+	if (start_frame > end_frame) {
+		return true;
+	}
+
+	/* only check the first and last frame, skipping the job is cheaper than rendering */
+	return BKE_sequencer_has_cached_frame(context, start_frame, sseq->chanshown) &&
+	       BKE_sequencer_has_cached_frame(context, end_frame, sseq->chanshown);
+}
+
+/* start rendering the frames after the current one into the cache, to be called during playback */
+void sequencer_start_prefetch_job(const bContext *C)
+{
+	wmWindowManager *wm = CTX_wm_manager(C);
+	Main *bmain = CTX_data_main(C);
+	Scene *scene = CTX_data_scene(C);
+	SpaceSeq *sseq = CTX_wm_space_seq(C);
+	const char *names[2] = {STEREO_LEFT_NAME, STEREO_RIGHT_NAME};
+	SeqRenderData context = {0};
+	wmJob *wm_job;
+	PrefetchJob *pj;
+	int start_frame, end_frame;
+
+	if (U.prefetchframes == 0 || G.is_rendering || sseq == NULL) {
+		return;
+	}
+
+	if (WM_jobs_test(wm, scene, WM_JOB_TYPE_SEQ_PREFETCH)) {
+		return;
+	}
+
+	if (!BKE_sequencer_prefetch_check_supported(scene)) {
+		return;
+	}
+
+	if (!sequencer_render_data_get(bmain, scene, sseq, names[(int)sseq->multiview_eye], &context)) {
+		return;
+	}
+
+	start_frame = CFRA + 1;
+	end_frame = min_ii(CFRA + U.prefetchframes, PEFRA);
+
+	if (prefetch_check_early_out(C, &context, start_frame, end_frame)) {
+		return;
+	}
+
+	wm_job = WM_jobs_get(wm, CTX_wm_window(C), scene, "Prefetching",
+	                     WM_JOB_PROGRESS, WM_JOB_TYPE_SEQ_PREFETCH);
+
+	/* create new job */
+	pj = MEM_callocN(sizeof(PrefetchJob), "sequencer prefetch job");
+	pj->context = context;
+	pj->start_frame = start_frame;
+	pj->end_frame = end_frame;
+	pj->chanshown = sseq->chanshown;
+	pj->generation = BKE_sequencer_prefetch_generation_get();
+
+	/* leave half of the cache to the frames being played and intermediate results */
+	if (U.memcachelimit) {
+		pj->memory_limit = (size_t)U.memcachelimit * 1024 * 1024 / 2;
+	}
+	else {
+		pj->memory_limit = SIZE_MAX;
+	}
+
+	WM_jobs_customdata_set(wm_job, pj, prefetch_freejob);
+	WM_jobs_timer(wm_job, 0.2, 0, 0);
+	WM_jobs_callbacks(wm_job, prefetch_startjob, NULL, NULL, prefetch_endjob);
+
+	/* and finally start the job */
+	WM_jobs_start(wm, wm_job);
+}
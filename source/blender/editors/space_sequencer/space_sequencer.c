@@ -597,10 +597,16 @@ static void sequencer_preview_region_draw(const bContext *C, ARegion *ar)
 			draw_image_seq(C, scene, ar, sseq, scene->r.cfra, over_cfra - scene->r.cfra, true, false);
 	}
 
-	if ((U.uiflag & USER_SHOW_FPS) && ED_screen_animation_no_scrub(wm)) {
-		rcti rect;
-		ED_region_visible_rect(ar, &rect);
-		ED_scene_draw_fps(scene, &rect);
+	if (ED_screen_animation_no_scrub(wm)) {
+		/* render the frames to be played next */
+		sequencer_start_prefetch_job(C);
+
+		if (U.uiflag & USER_SHOW_FPS) {
+			rcti rect;
+			ED_region_visible_rect(ar, &rect);
+			ED_scene_draw_fps(scene, &rect);
+			sequencer_draw_partial_read_stats(&rect);
+		}
 	}
 }
 
@@ -32,6 +32,8 @@
 #ifndef __GPU_DRAW_H__
 #define __GPU_DRAW_H__
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -148,6 +150,19 @@ void GPU_free_images(void);
 void GPU_free_images_anim(void);
 void GPU_free_images_old(void);
 
+/* Amount of image data sent to OpenGL, whole textures are uploaded when they
+ * are created, partial uploads update the pixels changed by painting */
+typedef struct GPUTextureUploadStats {
+	size_t full_bytes;
+	size_t partial_bytes;
+	/* mipmap levels computed on the CPU, part of the numbers above */
+	size_t mipmap_bytes;
+	unsigned int full_num, partial_num;
+} GPUTextureUploadStats;
+
+void GPU_texture_upload_stats_get(GPUTextureUploadStats *r_stats);
+void GPU_texture_upload_stats_reset(void);
+
 /* smoke drawing functions */
 void GPU_free_smoke(struct SmokeModifierData *smd);
 void GPU_create_smoke(struct SmokeModifierData *smd, int highres);
@@ -41,9 +41,11 @@
 #include "GPU_glew.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
 #include "BLI_hash.h"
 #include "BLI_linklist.h"
 #include "BLI_math.h"
+#include "BLI_rect.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
@@ -84,6 +86,8 @@
 #include "GPU_shader.h"
 #include "GPU_texture.h"
 
+#include "gpu_private.h"
+
 #include "PIL_time.h"
 
 #ifdef WITH_SMOKE
@@ -270,6 +274,13 @@ static struct GPUTextureState {
 	float anisotropic;
 	int gpu_mipmap;
 	MTexPoly *lasttface;
+
+	/* for partial texture uploads */
+	GLuint pixel_buffer;
+	bool pixel_buffer_mapped;
+	/* Image -> rcti, regions painted while mipmaps were off, to update when they are on again */
+	GHash *mipmap_dirty;
+	GPUTextureUploadStats stats;
 } GTS = {0, 0, 0, 0, 0, 0, 0, 0, NULL, NULL, 1, 0, 0, -1, 1.0f, 0, NULL};
 
 /* Mipmap settings */
@@ -565,6 +576,392 @@ static void gpu_verify_high_bit_srgb_buffer(float *srgb_frect,
 	}
 }
 
+/* Partial texture updates
+ *
+ * Painting tags the changed pixels of an ImBuf (IMB_dirty_rect_tag), only those are
+ * uploaded instead of making the whole texture again. The pixels are written straight
+ * into a pixel buffer object when supported, so the driver copies them to the GPU
+ * asynchronously instead of the upload blocking until it is done. */
+
+/* the first mipmap level not larger than this is read back from OpenGL to compute
+ * the levels below it, for updating the mipmaps of a region on the CPU */
+#define GPU_MIPMAP_READBACK_SIZE 256
+
+static size_t gpu_texture_pixels_size(int w, int h, GLenum type)
+{
+	return (size_t)w * h * ((type == GL_FLOAT) ? sizeof(float[4]) : sizeof(unsigned char[4]));
+}
+
+static void gpu_texture_stats_full(int w, int h, GLenum type, bool is_mipmap)
+{
+	const size_t size = gpu_texture_pixels_size(w, h, type);
+
+	GTS.stats.full_bytes += size;
+	if (is_mipmap)
+		GTS.stats.mipmap_bytes += size;
+}
+
+void GPU_texture_upload_stats_get(GPUTextureUploadStats *r_stats)
+{
+	*r_stats = GTS.stats;
+}
+
+void GPU_texture_upload_stats_reset(void)
+{
+	memset(&GTS.stats, 0, sizeof(GTS.stats));
+}
+
+static bool gpu_use_pixel_buffer(void)
+{
+	return GLEW_VERSION_2_1 || GLEW_ARB_pixel_buffer_object;
+}
+
+/* get memory for 'size' bytes of pixels, which are uploaded by gpu_texture_upload_end */
+static void *gpu_texture_upload_begin(size_t size)
+{
+	BLI_assert(!GTS.pixel_buffer_mapped);
+
+	if (gpu_use_pixel_buffer()) {
+		void *pixels;
+
+		if (GTS.pixel_buffer == 0)
+			glGenBuffers(1, &GTS.pixel_buffer);
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, GTS.pixel_buffer);
+		/* new storage, the driver may still be reading the pixels of the previous upload */
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+		pixels = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+
+		if (pixels) {
+			GTS.pixel_buffer_mapped = true;
+			return pixels;
+		}
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	return MEM_mallocN(size, "gpu_texture_upload");
+}
+
+/* upload RGBA pixels to a region of a level of the bound texture */
+static void gpu_texture_upload_end(
+        void *pixels, GLenum target, int level, int x, int y, int w, int h, GLenum type, bool is_mipmap)
+{
+	const size_t size = gpu_texture_pixels_size(w, h, type);
+
+	if (GTS.pixel_buffer_mapped) {
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glTexSubImage2D(target, level, x, y, w, h, GL_RGBA, type, NULL);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		GTS.pixel_buffer_mapped = false;
+	}
+	else {
+		glTexSubImage2D(target, level, x, y, w, h, GL_RGBA, type, pixels);
+		MEM_freeN(pixels);
+	}
+
+	GTS.stats.partial_bytes += size;
+	GTS.stats.partial_num++;
+	if (is_mipmap)
+		GTS.stats.mipmap_bytes += size;
+}
+
+/* upload a region of a buffer with rows of 'stride' pixels, 'pixels' points to its first pixel */
+static void gpu_texture_upload_rect(
+        const void *pixels, int stride, GLenum target, int level, int x, int y, int w, int h, GLenum type,
+        bool is_mipmap)
+{
+	const size_t pixel_size = gpu_texture_pixels_size(1, 1, type);
+	const size_t row_size = pixel_size * w;
+	char *buffer = gpu_texture_upload_begin(row_size * h);
+
+	for (int i = 0; i < h; i++)
+		memcpy(buffer + row_size * i, (const char *)pixels + pixel_size * stride * i, row_size);
+
+	gpu_texture_upload_end(buffer, target, level, x, y, w, h, type, is_mipmap);
+}
+
+static bool gpu_is_scaled_image(ImBuf *ibuf)
+{
+	return ((!GPU_full_non_power_of_two_support() && !is_power_of_2_resolution(ibuf->x, ibuf->y)) ||
+	        is_over_resolution_limit(GL_TEXTURE_2D, ibuf->x, ibuf->y));
+}
+
+/* check if image has been downscaled and do scaled partial update */
+static bool gpu_check_scaled_image(ImBuf *ibuf, float *frect, int x, int y, int w, int h)
+{
+	if (gpu_is_scaled_image(ibuf)) {
+		int x_limit = smaller_power_of_2_limit(ibuf->x);
+		int y_limit = smaller_power_of_2_limit(ibuf->y);
+
+		float xratio = x_limit / (float)ibuf->x;
+		float yratio = y_limit / (float)ibuf->y;
+
+		/* find new width, height and x,y gpu texture coordinates */
+
+		/* take ceiling because we will be losing 1 pixel due to rounding errors in x,y... */
+		int rectw = (int)ceil(xratio * w);
+		int recth = (int)ceil(yratio * h);
+
+		x *= xratio;
+		y *= yratio;
+
+		/* ...but take back if we are over the limit! */
+		if (rectw + x > x_limit) rectw--;
+		if (recth + y > y_limit) recth--;
+
+		/* float rectangles are already continuous in memory so we can use IMB_scaleImBuf */
+		if (frect) {
+			ImBuf *ibuf_scale = IMB_allocFromBuffer(NULL, frect, w, h);
+			IMB_scaleImBuf(ibuf_scale, rectw, recth);
+
+			gpu_texture_upload_rect(ibuf_scale->rect_float, rectw, GL_TEXTURE_2D, 0, x, y, rectw, recth,
+			                        GL_FLOAT, false);
+
+			IMB_freeImBuf(ibuf_scale);
+		}
+		/* byte images are not continuous in memory so do manual interpolation */
+		else {
+			unsigned char *scalerect = gpu_texture_upload_begin(rectw * recth * sizeof(*scalerect) * 4);
+			unsigned int *p = (unsigned int *)scalerect;
+			int i, j;
+			float inv_xratio = 1.0f / xratio;
+			float inv_yratio = 1.0f / yratio;
+			for (i = 0; i < rectw; i++) {
+				float u = (x + i) * inv_xratio;
+				for (j = 0; j < recth; j++) {
+					float v = (y + j) * inv_yratio;
+					bilinear_interpolation_color_wrap(ibuf, (unsigned char *)(p + i + j * (rectw)), NULL, u, v);
+				}
+			}
+
+			gpu_texture_upload_end(scalerect, GL_TEXTURE_2D, 0, x, y, rectw, recth, GL_UNSIGNED_BYTE, false);
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+/* upload a changed region of a regular image */
+static void gpu_texture_update_region(Image *ima, ImBuf *ibuf, const rcti *rect)
+{
+	const int x = rect->xmin, y = rect->ymin;
+	const int w = BLI_rcti_size_x(rect), h = BLI_rcti_size_y(rect);
+
+	/* if color correction is needed, we must update the part that needs updating. */
+	if (ibuf->rect_float) {
+		const bool is_data = (ima->tpageflag & IMA_GLBIND_IS_DATA) != 0;
+
+		if (gpu_is_scaled_image(ibuf)) {
+			float *buffer = MEM_mallocN(w * h * sizeof(float) * 4, "temp_texpaint_float_buf");
+			IMB_partial_rect_from_float(ibuf, buffer, x, y, w, h, is_data);
+			gpu_check_scaled_image(ibuf, buffer, x, y, w, h);
+			MEM_freeN(buffer);
+		}
+		else {
+			float *buffer = gpu_texture_upload_begin(gpu_texture_pixels_size(w, h, GL_FLOAT));
+			IMB_partial_rect_from_float(ibuf, buffer, x, y, w, h, is_data);
+			gpu_texture_upload_end(buffer, GL_TEXTURE_2D, 0, x, y, w, h, GL_FLOAT, false);
+		}
+	}
+	else if (!gpu_check_scaled_image(ibuf, NULL, x, y, w, h)) {
+		gpu_texture_upload_rect(ibuf->rect + (size_t)y * ibuf->x + x, ibuf->x,
+		                        GL_TEXTURE_2D, 0, x, y, w, h, GL_UNSIGNED_BYTE, false);
+	}
+}
+
+/* read the pixels of a region of an image, the way they are uploaded to its texture */
+static void gpu_texture_read_region(Image *ima, ImBuf *ibuf, ImBuf *ibuf_region, int x, int y)
+{
+	const bool is_data = (ima->tpageflag & IMA_GLBIND_IS_DATA) != 0;
+	const int w = ibuf_region->x, h = ibuf_region->y;
+
+	if (ibuf_region->rect_float) {
+		IMB_partial_rect_from_float(ibuf, ibuf_region->rect_float, x, y, w, h, is_data);
+	}
+	else {
+		for (int i = 0; i < h; i++) {
+			memcpy(ibuf_region->rect + (size_t)i * w, ibuf->rect + (size_t)(y + i) * ibuf->x + x,
+			       sizeof(*ibuf->rect) * w);
+		}
+	}
+}
+
+/* Update the mipmaps of the bound texture for a changed region, like IMB_makemipmap
+ * does for the whole image in GPU_create_gl_tex. Only the levels above
+ * GPU_MIPMAP_READBACK_SIZE are computed from the region, the smaller ones from
+ * the first of those read back from OpenGL. */
+static bool gpu_texture_update_mipmap_region(Image *ima, ImBuf *ibuf, const rcti *rect)
+{
+	const bool use_float = (ibuf->rect_float != NULL);
+	const GLenum type = use_float ? GL_FLOAT : GL_UNSIGNED_BYTE;
+	const int imb_flag = use_float ? IB_rectfloat : IB_rect;
+	ImBuf *ibuf_low;
+	int levels = 0;
+
+	if (gpu_is_scaled_image(ibuf))
+		return false;
+
+	while (max_ii(ibuf->x >> levels, ibuf->y >> levels) > GPU_MIPMAP_READBACK_SIZE)
+		levels++;
+
+	if (levels > 0) {
+		/* the 3x3 filter of each level spreads the changes, a pixel of the last level depends on
+		 * the pixels up to 2^levels away. aligning the region to it keeps the pixel pairs which
+		 * are averaged the same as for the whole image */
+		const int align = 1 << levels;
+		rcti region;
+
+		region.xmin = (max_ii(rect->xmin - align, 0) / align) * align;
+		region.ymin = (max_ii(rect->ymin - align, 0) / align) * align;
+		region.xmax = min_ii(((rect->xmax + 2 * align - 1) / align) * align, ibuf->x);
+		region.ymax = min_ii(((rect->ymax + 2 * align - 1) / align) * align, ibuf->y);
+
+		ImBuf *ibuf_region = IMB_allocImBuf(BLI_rcti_size_x(&region), BLI_rcti_size_y(&region), 32, imb_flag);
+		gpu_texture_read_region(ima, ibuf, ibuf_region, region.xmin, region.ymin);
+		IMB_makemipmap(ibuf_region, true);
+
+		for (int level = 1; level <= levels && level < ibuf_region->miptot; level++) {
+			ImBuf *mip = ibuf_region->mipmap[level - 1];
+			const int xofs = region.xmin >> level, yofs = region.ymin >> level;
+			const int xmin = rect->xmin >> level, ymin = rect->ymin >> level;
+			const int xmax = min_ii(((rect->xmax - 1) >> level) + 1, xofs + mip->x);
+			const int ymax = min_ii(((rect->ymax - 1) >> level) + 1, yofs + mip->y);
+			const size_t offset = (size_t)(ymin - yofs) * mip->x + (xmin - xofs);
+
+			if (xmax <= xmin || ymax <= ymin)
+				continue;
+
+			gpu_texture_upload_rect(use_float ? (void *)(mip->rect_float + offset * 4) : (void *)(mip->rect + offset),
+			                        mip->x, GL_TEXTURE_2D, level, xmin, ymin, xmax - xmin, ymax - ymin, type, true);
+		}
+
+		IMB_freeImBuf(ibuf_region);
+
+		ibuf_low = IMB_allocImBuf(max_ii(ibuf->x >> levels, 1), max_ii(ibuf->y >> levels, 1), 32, imb_flag);
+		glGetTexImage(GL_TEXTURE_2D, levels, GL_RGBA, type,
+		              use_float ? (void *)ibuf_low->rect_float : (void *)ibuf_low->rect);
+	}
+	else {
+		/* small enough to do all of it */
+		ibuf_low = IMB_allocImBuf(ibuf->x, ibuf->y, 32, imb_flag);
+		gpu_texture_read_region(ima, ibuf, ibuf_low, 0, 0);
+	}
+
+	IMB_makemipmap(ibuf_low, true);
+
+	for (int level = 1; level < ibuf_low->miptot; level++) {
+		ImBuf *mip = ibuf_low->mipmap[level - 1];
+
+		gpu_texture_upload_rect(use_float ? (void *)mip->rect_float : (void *)mip->rect, mip->x,
+		                        GL_TEXTURE_2D, levels + level, 0, 0, mip->x, mip->y, type, true);
+	}
+
+	IMB_freeImBuf(ibuf_low);
+
+	return true;
+}
+
+static void gpu_texture_mipmap_dirty_tag(Image *ima, const rcti *rect)
+{
+	rcti **rect_p;
+
+	if (GTS.mipmap_dirty == NULL)
+		GTS.mipmap_dirty = BLI_ghash_ptr_new(__func__);
+
+	if (BLI_ghash_ensure_p(GTS.mipmap_dirty, ima, (void ***)&rect_p)) {
+		BLI_rcti_union(*rect_p, rect);
+	}
+	else {
+		*rect_p = MEM_mallocN(sizeof(rcti), __func__);
+		**rect_p = *rect;
+	}
+}
+
+/* update the mipmaps of the regions painted while mipmaps were off */
+static bool gpu_texture_update_mipmap_dirty(Image *ima)
+{
+	rcti *rect = GTS.mipmap_dirty ? BLI_ghash_lookup(GTS.mipmap_dirty, ima) : NULL;
+	bool ok = false;
+
+	if (rect && !ima->repbind && ima->bindcode[TEXTARGET_TEXTURE_2D] &&
+	    !ima->bindcode[TEXTARGET_TEXTURE_CUBE_MAP] && !BKE_image_is_animated(ima))
+	{
+		ImBuf *ibuf = BKE_image_acquire_ibuf(ima, NULL, NULL);
+
+		if (ibuf) {
+			glBindTexture(GL_TEXTURE_2D, ima->bindcode[TEXTARGET_TEXTURE_2D]);
+
+			if (GTS.gpu_mipmap) {
+				gpu_generate_mipmap(GL_TEXTURE_2D);
+				ok = true;
+			}
+			else {
+				ok = gpu_texture_update_mipmap_region(ima, ibuf, rect);
+			}
+		}
+
+		BKE_image_release_ibuf(ima, ibuf, NULL);
+	}
+
+	if (GTS.mipmap_dirty)
+		BLI_ghash_remove(GTS.mipmap_dirty, ima, NULL, MEM_freeN);
+
+	if (ok)
+		ima->tpageflag |= IMA_MIPMAP_COMPLETE;
+
+	return ok;
+}
+
+static bool gpu_texture_is_dirty(ImBuf *ibuf)
+{
+	return !BLI_rcti_is_empty(&ibuf->dirty_rect);
+}
+
+/* Update the 2D texture of an image with the pixels changed since it was made,
+ * returns false when it has to be made again instead. */
+static bool gpu_texture_update_dirty(Image *ima, ImBuf *ibuf)
+{
+	const bool use_cpu_mipmap = GPU_get_mipmap() && !GTS.gpu_mipmap && (ima->tpageflag & IMA_MIPMAP_COMPLETE);
+	rcti rect;
+	bool changed = IMB_dirty_rect_get(ibuf, &rect);
+
+	if (ima->repbind || ima->bindcode[TEXTARGET_TEXTURE_2D] == 0 ||
+	    (use_cpu_mipmap && gpu_is_scaled_image(ibuf)))
+	{
+		return false;
+	}
+
+	if (!changed)
+		return true;
+
+	glBindTexture(GL_TEXTURE_2D, ima->bindcode[TEXTARGET_TEXTURE_2D]);
+
+	gpu_texture_update_region(ima, ibuf, &rect);
+
+	IMB_dirty_rect_clear(ibuf);
+
+	if (!GPU_get_mipmap()) {
+		/* mipmaps are off while texture painting, remember what to update when it ends */
+		if ((ima->tpageflag & IMA_MIPMAP_COMPLETE) ||
+		    (GTS.mipmap_dirty && BLI_ghash_haskey(GTS.mipmap_dirty, ima)))
+		{
+			gpu_texture_mipmap_dirty_tag(ima, &rect);
+		}
+		ima->tpageflag &= ~IMA_MIPMAP_COMPLETE;
+	}
+	else if (GTS.gpu_mipmap) {
+		gpu_generate_mipmap(GL_TEXTURE_2D);
+	}
+	else if (use_cpu_mipmap) {
+		return gpu_texture_update_mipmap_region(ima, ibuf, &rect);
+	}
+
+	return true;
+}
+
 int GPU_verify_image(
         Image *ima, ImageUser *iuser,
         int textarget, int tftile, bool compare, bool mipmap, bool is_data)
@@ -627,6 +1024,14 @@ int GPU_verify_image(
 	if (ibuf == NULL)
 		return 0;
 
+	/* update the pixels changed since the texture was made */
+	if (textarget == GL_TEXTURE_2D && !GTS.tilemode && !(ima->tpageflag & IMA_TPAGE_REFRESH) &&
+	    ima->bindcode[TEXTARGET_TEXTURE_2D] && gpu_texture_is_dirty(ibuf))
+	{
+		if (!gpu_texture_update_dirty(ima, ibuf))
+			GPU_free_image(ima);
+	}
+
 	if (ibuf->rect_float) {
 		if (U.use_16bit_textures) {
 			/* use high precision textures. This is relatively harmless because OpenGL gives us
@@ -776,6 +1181,10 @@ int GPU_verify_image(
 	if (srgb_frect)
 		MEM_freeN(srgb_frect);
 
+	/* the new texture has all changes */
+	if (*bind && textarget == GL_TEXTURE_2D && !GTS.tilemode)
+		IMB_dirty_rect_clear(ibuf);
+
 	BKE_image_release_ibuf(ima, ibuf, NULL);
 
 	return *bind;
@@ -896,6 +1305,8 @@ void GPU_create_gl_tex(
 		else
 			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, rectw, recth, 0, GL_RGBA, GL_UNSIGNED_BYTE, rect);
 
+		gpu_texture_stats_full(rectw, recth, use_high_bit_depth ? GL_FLOAT : GL_UNSIGNED_BYTE, false);
+
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, gpu_get_mipmap_filter(1));
 
 		if (GPU_get_mipmap() && mipmap) {
@@ -925,6 +1336,8 @@ void GPU_create_gl_tex(
 					else {
 						glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, mip->x, mip->y, 0, GL_RGBA, GL_UNSIGNED_BYTE, mip->rect);
 					}
+
+					gpu_texture_stats_full(mip->x, mip->y, use_high_bit_depth ? GL_FLOAT : GL_UNSIGNED_BYTE, true);
 				}
 			}
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, gpu_get_mipmap_filter(0));
@@ -943,10 +1356,13 @@ void GPU_create_gl_tex(
 			GLenum informat = use_high_bit_depth ? (GLEW_ARB_texture_float ? GL_RGBA16F_ARB : GL_RGBA16) : GL_RGBA8;
 			GLenum type = use_high_bit_depth ? GL_FLOAT : GL_UNSIGNED_BYTE;
 
-			if (cube_map)
+			if (cube_map) {
 				for (int i = 0; i < 6; i++)
 					glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, informat, w, h, 0, GL_RGBA, type, cube_map[i]);
 
+				gpu_texture_stats_full(w, h * 6, type, false);
+			}
+
 			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, gpu_get_mipmap_filter(1));
 
 			if (GPU_get_mipmap() && mipmap) {
@@ -977,6 +1393,8 @@ void GPU_create_gl_tex(
 								glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + j, i,
 									informat, mipw, miph, 0, GL_RGBA, type, mip_cube_map[j]);
 							}
+
+							gpu_texture_stats_full(mipw, miph * 6, type, true);
 						}
 						gpu_del_cube_map(mip_cube_map);
 					}
@@ -1003,6 +1421,8 @@ void GPU_create_gl_tex(
 	if (GLEW_EXT_texture_filter_anisotropic)
 		glTexParameterf(textarget, GL_TEXTURE_MAX_ANISOTROPY_EXT, GPU_get_anisotropic());
 
+	GTS.stats.full_num++;
+
 	if (ibuf)
 		IMB_freeImBuf(ibuf);
 }
@@ -1162,6 +1582,10 @@ void GPU_paint_set_mipmap(bool mipmap)
 	if (mipmap) {
 		for (Image *ima = G.main->image.first; ima; ima = ima->id.next) {
 			if (BKE_image_has_bindcode(ima)) {
+				/* painted images only need the mipmaps of the painted regions */
+				if (!(ima->tpageflag & IMA_MIPMAP_COMPLETE))
+					gpu_texture_update_mipmap_dirty(ima);
+
 				if (ima->tpageflag & IMA_MIPMAP_COMPLETE) {
 					if (ima->bindcode[TEXTARGET_TEXTURE_2D]) {
 						glBindTexture(GL_TEXTURE_2D, ima->bindcode[TEXTARGET_TEXTURE_2D]);
@@ -1203,152 +1627,21 @@ void GPU_paint_set_mipmap(bool mipmap)
 }
 
 
-/* check if image has been downscaled and do scaled partial update */
-static bool gpu_check_scaled_image(ImBuf *ibuf, Image *ima, float *frect, int x, int y, int w, int h)
-{
-	if ((!GPU_full_non_power_of_two_support() && !is_power_of_2_resolution(ibuf->x, ibuf->y)) ||
-	    is_over_resolution_limit(GL_TEXTURE_2D, ibuf->x, ibuf->y))
-	{
-		int x_limit = smaller_power_of_2_limit(ibuf->x);
-		int y_limit = smaller_power_of_2_limit(ibuf->y);
-
-		float xratio = x_limit / (float)ibuf->x;
-		float yratio = y_limit / (float)ibuf->y;
-
-		/* find new width, height and x,y gpu texture coordinates */
-
-		/* take ceiling because we will be losing 1 pixel due to rounding errors in x,y... */
-		int rectw = (int)ceil(xratio * w);
-		int recth = (int)ceil(yratio * h);
-
-		x *= xratio;
-		y *= yratio;
-
-		/* ...but take back if we are over the limit! */
-		if (rectw + x > x_limit) rectw--;
-		if (recth + y > y_limit) recth--;
-
-		/* float rectangles are already continuous in memory so we can use IMB_scaleImBuf */
-		if (frect) {
-			ImBuf *ibuf_scale = IMB_allocFromBuffer(NULL, frect, w, h);
-			IMB_scaleImBuf(ibuf_scale, rectw, recth);
-
-			glBindTexture(GL_TEXTURE_2D, ima->bindcode[TEXTARGET_TEXTURE_2D]);
-			glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, rectw, recth, GL_RGBA,
-			                GL_FLOAT, ibuf_scale->rect_float);
-
-			IMB_freeImBuf(ibuf_scale);
-		}
-		/* byte images are not continuous in memory so do manual interpolation */
-		else {
-			unsigned char *scalerect = MEM_mallocN(rectw * recth * sizeof(*scalerect) * 4, "scalerect");
-			unsigned int *p = (unsigned int *)scalerect;
-			int i, j;
-			float inv_xratio = 1.0f / xratio;
-			float inv_yratio = 1.0f / yratio;
-			for (i = 0; i < rectw; i++) {
-				float u = (x + i) * inv_xratio;
-				for (j = 0; j < recth; j++) {
-					float v = (y + j) * inv_yratio;
-					bilinear_interpolation_color_wrap(ibuf, (unsigned char *)(p + i + j * (rectw)), NULL, u, v);
-				}
-			}
-			glBindTexture(GL_TEXTURE_2D, ima->bindcode[TEXTARGET_TEXTURE_2D]);
-			glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, rectw, recth, GL_RGBA,
-			                GL_UNSIGNED_BYTE, scalerect);
-
-			MEM_freeN(scalerect);
-		}
-
-		if (GPU_get_mipmap()) {
-			gpu_generate_mipmap(GL_TEXTURE_2D);
-		}
-		else {
-			ima->tpageflag &= ~IMA_MIPMAP_COMPLETE;
-		}
-
-		return true;
-	}
-
-	return false;
-}
-
 void GPU_paint_update_image(Image *ima, ImageUser *iuser, int x, int y, int w, int h)
 {
 	ImBuf *ibuf = BKE_image_acquire_ibuf(ima, iuser, NULL);
 
-	if (ima->repbind ||
-	    (!GTS.gpu_mipmap && GPU_get_mipmap()) ||
-	    (ima->bindcode[TEXTARGET_TEXTURE_2D] == 0) ||
-	    (ibuf == NULL) ||
-	    (w == 0) || (h == 0))
-	{
-		/* these cases require full reload still */
+	if (ibuf == NULL || w == 0 || h == 0) {
 		GPU_free_image(ima);
 	}
 	else {
 		/* for the special case, we can do a partial update
 		 * which is much quicker for painting */
-		GLint row_length, skip_pixels, skip_rows;
-
-		/* if color correction is needed, we must update the part that needs updating. */
-		if (ibuf->rect_float) {
-			float *buffer = MEM_mallocN(w * h * sizeof(float) * 4, "temp_texpaint_float_buf");
-			bool is_data = (ima->tpageflag & IMA_GLBIND_IS_DATA) != 0;
-			IMB_partial_rect_from_float(ibuf, buffer, x, y, w, h, is_data);
-
-			if (gpu_check_scaled_image(ibuf, ima, buffer, x, y, w, h)) {
-				MEM_freeN(buffer);
-				BKE_image_release_ibuf(ima, ibuf, NULL);
-				return;
-			}
-
-			glBindTexture(GL_TEXTURE_2D, ima->bindcode[TEXTARGET_TEXTURE_2D]);
-			glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RGBA, GL_FLOAT, buffer);
-
-			MEM_freeN(buffer);
+		IMB_dirty_rect_tag(ibuf, x, y, x + w, y + h);
 
-			/* we have already accounted for the case where GTS.gpu_mipmap is false
-			 * so we will be using GPU mipmap generation here */
-			if (GPU_get_mipmap()) {
-				gpu_generate_mipmap(GL_TEXTURE_2D);
-			}
-			else {
-				ima->tpageflag &= ~IMA_MIPMAP_COMPLETE;
-			}
-
-			BKE_image_release_ibuf(ima, ibuf, NULL);
-			return;
-		}
-
-		if (gpu_check_scaled_image(ibuf, ima, NULL, x, y, w, h)) {
-			BKE_image_release_ibuf(ima, ibuf, NULL);
-			return;
-		}
-
-		glBindTexture(GL_TEXTURE_2D, ima->bindcode[TEXTARGET_TEXTURE_2D]);
-
-		glGetIntegerv(GL_UNPACK_ROW_LENGTH, &row_length);
-		glGetIntegerv(GL_UNPACK_SKIP_PIXELS, &skip_pixels);
-		glGetIntegerv(GL_UNPACK_SKIP_ROWS, &skip_rows);
-
-		glPixelStorei(GL_UNPACK_ROW_LENGTH, ibuf->x);
-		glPixelStorei(GL_UNPACK_SKIP_PIXELS, x);
-		glPixelStorei(GL_UNPACK_SKIP_ROWS, y);
-
-		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RGBA,
-			GL_UNSIGNED_BYTE, ibuf->rect);
-
-		glPixelStorei(GL_UNPACK_ROW_LENGTH, row_length);
-		glPixelStorei(GL_UNPACK_SKIP_PIXELS, skip_pixels);
-		glPixelStorei(GL_UNPACK_SKIP_ROWS, skip_rows);
-
-		/* see comment above as to why we are using gpu mipmap generation here */
-		if (GPU_get_mipmap()) {
-			gpu_generate_mipmap(GL_TEXTURE_2D);
-		}
-		else {
-			ima->tpageflag &= ~IMA_MIPMAP_COMPLETE;
+		if (!gpu_texture_update_dirty(ima, ibuf)) {
+			/* these cases require full reload still */
+			GPU_free_image(ima);
 		}
 	}
 
@@ -1533,6 +1826,9 @@ void GPU_free_image(Image *ima)
 		ima->repbind = NULL;
 	}
 
+	if (GTS.mipmap_dirty)
+		BLI_ghash_remove(GTS.mipmap_dirty, ima, NULL, MEM_freeN);
+
 	ima->tpageflag &= ~(IMA_MIPMAP_COMPLETE | IMA_GLBIND_IS_DATA);
 }
 
@@ -1589,6 +1885,27 @@ void GPU_free_images_old(void)
 	}
 }
 
+/* free the buffers of partial texture uploads */
+void gpu_draw_exit(void)
+{
+	if (G.debug & G_DEBUG_GPU) {
+		printf("Texture uploads: %u full (%.1f MB), %u partial (%.1f MB), mipmaps %.1f MB\n",
+		       GTS.stats.full_num, GTS.stats.full_bytes / (1024.0 * 1024.0),
+		       GTS.stats.partial_num, GTS.stats.partial_bytes / (1024.0 * 1024.0),
+		       GTS.stats.mipmap_bytes / (1024.0 * 1024.0));
+	}
+
+	if (GTS.pixel_buffer) {
+		glDeleteBuffers(1, &GTS.pixel_buffer);
+		GTS.pixel_buffer = 0;
+	}
+
+	if (GTS.mipmap_dirty) {
+		BLI_ghash_free(GTS.mipmap_dirty, NULL, MEM_freeN);
+		GTS.mipmap_dirty = NULL;
+	}
+}
+
 
 /* OpenGL Materials */
 
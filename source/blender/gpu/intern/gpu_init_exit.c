@@ -65,6 +65,8 @@ void GPU_init(void)
 
 void GPU_exit(void)
 {
+	gpu_draw_exit();
+
 	if (G.debug & G_DEBUG_GPU)
 		gpu_debug_exit();
 	gpu_codegen_exit();
@@ -29,6 +29,9 @@
 void gpu_extensions_init(void);
 void gpu_extensions_exit(void);
 
+/* gpu_draw.c */
+void gpu_draw_exit(void);
+
 /* gpu_debug.c */
 void gpu_debug_init(void);
 void gpu_debug_exit(void);
@@ -198,6 +198,9 @@ void IMB_colormanagement_processor_apply(struct ColormanageProcessor *cm_process
 void IMB_colormanagement_processor_apply_byte(struct ColormanageProcessor *cm_processor,
                                               unsigned char *buffer, int width, int height, int channels);
 void IMB_colormanagement_processor_free(struct ColormanageProcessor *cm_processor);
+void IMB_colormanagement_processor_use_display_lut(struct ColormanageProcessor *cm_processor,
+                                                   const struct ColorManagedViewSettings *view_settings,
+                                                   const struct ColorManagedDisplaySettings *display_settings);
 
 /* ** OpenGL drawing routines using GLSL for color space transform ** */
 
@@ -85,8 +85,11 @@ struct ImBuf;
 struct anim;
 
 struct ColorManagedDisplay;
+struct ImPartialRead;
+struct ImPartialReadStats;
 
 struct GSet;
+struct rcti;
 /**
  *
  * \attention defined in DNA_scene_types.h
@@ -119,6 +122,24 @@ struct ImBuf *IMB_testiffname(const char *filepath, int flags);
  */
 struct ImBuf *IMB_loadiffname(const char *filepath, int flags, char colorspace[IM_MAX_SPACE]);
 
+/**
+ * Load a region of a mipmap level or a single pass of an image, only the pixel data needed
+ * is read from the file. OpenEXR files support all of #ImPartialRead, JPEG files are decoded
+ * directly at the reduced size of level_min_size. NULL is returned for other files.
+ *
+ * \attention Defined in readimage.c
+ */
+struct ImBuf *IMB_loadiffname_partial(const char *filepath, int flags, char colorspace[IM_MAX_SPACE],
+                                      struct ImPartialRead *partial);
+
+/**
+ * Bytes read and skipped by #IMB_loadiffname_partial, updated from any thread.
+ *
+ * \attention Defined in readimage.c
+ */
+void IMB_partial_read_stats_get(struct ImPartialReadStats *r_stats);
+void IMB_partial_read_stats_reset(void);
+
 /**
  *
  * \attention Defined in allocimbuf.c
@@ -161,6 +182,7 @@ struct ImBuf *IMB_allocFromBuffer(const unsigned int *rect, const float *rectf,
 
 void IMB_refImBuf(struct ImBuf *ibuf);
 struct ImBuf *IMB_makeSingleUser(struct ImBuf *ibuf);
+void IMB_generation_bump(struct ImBuf *ibuf);
 
 /**
  *
@@ -277,6 +299,9 @@ struct IndexBuildContext *IMB_anim_index_rebuild_context(struct anim *anim, IMB_
                                                          IMB_Proxy_Size proxy_sizes_in_use, int quality,
                                                          const bool overwite, struct GSet *file_list);
 
+/* limit the threads used for decoding, so several builders can run at once (0 uses all) */
+void IMB_anim_index_rebuild_set_threads(struct IndexBuildContext *context, int num_threads);
+
 /* will rebuild all used indices and proxies at once */
 void IMB_anim_index_rebuild(struct IndexBuildContext *context,
                             short *stop, short *do_update, float *progress);
@@ -364,6 +389,16 @@ void IMB_tile_cache_params(int totthread, int maxmem);
 unsigned int *IMB_gettile(struct ImBuf *ibuf, int tx, int ty, int thread);
 void IMB_tiles_to_rect(struct ImBuf *ibuf);
 
+/**
+ * Region of the pixels changed since the GPU texture of the image was updated.
+ *
+ * \attention Defined in rectop.c
+ */
+
+void IMB_dirty_rect_tag(struct ImBuf *ibuf, int xmin, int ymin, int xmax, int ymax);
+bool IMB_dirty_rect_get(const struct ImBuf *ibuf, struct rcti *r_rect);
+void IMB_dirty_rect_clear(struct ImBuf *ibuf);
+
 /**
  *
  * \attention Defined in filter.c
@@ -394,6 +429,19 @@ bool IMB_scalefastImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy
  */
 void IMB_scaleImBuf_threaded(struct ImBuf *ibuf, unsigned int newx, unsigned int newy);
 
+typedef enum eIMBScaleFilter {
+	IMB_SCALE_FILTER_BOX      = 0, /* area average, what IMB_scaleImBuf uses for downscaling */
+	IMB_SCALE_FILTER_BILINEAR = 1, /* triangle, widened when downscaling */
+	IMB_SCALE_FILTER_LANCZOS  = 2, /* 3 lobes, sharpest but rings on hard edges */
+} eIMBScaleFilter;
+
+/**
+ * Separable resampling of the byte and float buffers, split over threads by rows.
+ *
+ * \attention Defined in scaling.c
+ */
+bool IMB_scaleImBuf_filter(struct ImBuf *ibuf, unsigned int newx, unsigned int newy, eIMBScaleFilter filter);
+
 /**
  *
  * \attention Defined in writeimage.c
@@ -446,12 +494,18 @@ void IMB_saturation(struct ImBuf *ibuf, float sat);
 void IMB_buffer_byte_from_float(unsigned char *rect_to, const float *rect_from,
 	int channels_from, float dither, int profile_to, int profile_from, bool predivide,
 	int width, int height, int stride_to, int stride_from);
+void IMB_buffer_byte_from_float_threaded(unsigned char *rect_to, const float *rect_from,
+	int channels_from, float dither, int profile_to, int profile_from, bool predivide,
+	int width, int height, int stride_to, int stride_from);
 void IMB_buffer_byte_from_float_mask(unsigned char *rect_to, const float *rect_from,
 	int channels_from, float dither, bool predivide,
 	int width, int height, int stride_to, int stride_from, char *mask);
 void IMB_buffer_float_from_byte(float *rect_to, const unsigned char *rect_from,
 	int profile_to, int profile_from, bool predivide,
 	int width, int height, int stride_to, int stride_from);
+void IMB_buffer_float_from_byte_threaded(float *rect_to, const unsigned char *rect_from,
+	int profile_to, int profile_from, bool predivide,
+	int width, int height, int stride_to, int stride_from);
 void IMB_buffer_float_from_float(float *rect_to, const float *rect_from,
 	int channels_from, int profile_to, int profile_from, bool predivide,
 	int width, int height, int stride_to, int stride_from);
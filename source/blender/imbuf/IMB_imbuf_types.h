@@ -204,6 +204,8 @@ typedef struct ImBuf {
 	/* memory cache limiter */
 	struct MEM_CacheLimiterHandle_s *c_handle; /* handle for cache limiter */
 	int refcounter; /* reference counter for multiple users */
+	unsigned int uid; /* unique number of this buffer, lets caches tell reloaded buffers apart */
+	unsigned int generation; /* bumped when the pixels change or are saved, see IMB_generation_bump */
 
 	/* some parameters to pass along for packing images */
 	unsigned char *encodedbuffer;     /* Compressed image only used with png currently */
@@ -218,6 +220,9 @@ typedef struct ImBuf {
 	int colormanage_flag;
 	rcti invalid_rect;
 
+	/* changed pixels which are not in the GPU texture yet */
+	rcti dirty_rect;
+
 	/* information for compressed textures */
 	struct DDSData dds_data;
 } ImBuf;
@@ -313,4 +318,37 @@ enum {
 
 /** \} */
 
+/**
+ * \name Imbuf Partial Reading
+ * \brief Used with #IMB_loadiffname_partial
+ *
+ * \{ */
+
+typedef struct ImPartialRead {
+	/* region to read in pixels of the level, with the origin at the bottom left and exclusive
+	 * maximum. The whole level is read when the region is empty */
+	int xmin, ymin, xmax, ymax;
+	/* mipmap or ripmap level of tiled files, clamped to the levels in the file. Other files are
+	 * subsampled by 2^level when level_min_size is used */
+	int level;
+	/* when non-zero, read the smallest level which is at least this large instead of level */
+	int level_min_size;
+	/* "Layer.Pass" of a multilayer file to read, the RGBA channels are read when NULL */
+	const char *passname;
+
+	/* set by the reading: the size of the full resolution image and the level which was read */
+	int width, height;
+	int level_read;
+	/* uncompressed size of the pixel data in the file which was read and which was skipped */
+	size_t bytes_read, bytes_skipped;
+} ImPartialRead;
+
+/* Totals of all partial reads since startup or the last reset */
+typedef struct ImPartialReadStats {
+	unsigned int reads;
+	size_t bytes_read, bytes_skipped;
+} ImPartialReadStats;
+
+/** \} */
+
 #endif  /* __IMB_IMBUF_TYPES_H__ */
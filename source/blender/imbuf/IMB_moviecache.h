@@ -48,7 +48,6 @@ typedef void  *(*MovieCacheGetPriorityDataFP) (void *userkey);
 typedef int    (*MovieCacheGetItemPriorityFP) (void *last_userkey, void *priority_data);
 typedef void   (*MovieCachePriorityDeleterFP) (void *priority_data);
 
-void IMB_moviecache_init(void);
 void IMB_moviecache_destruct(void);
 
 struct MovieCache *IMB_moviecache_create(const char *name, int keysize, GHashHashFP hashfp, GHashCmpFP cmpfp);
@@ -86,6 +86,7 @@ void IMB_thumb_makedirs(void);
 /* special function for loading a thumbnail embedded into a blend file */
 ImBuf *IMB_thumb_load_blend(const char *blen_path, const char *blen_group, const char *blen_id);
 void   IMB_thumb_overlay_blend(unsigned int *thumb, int width, int height, float aspect);
+void   IMB_thumb_blend_cache_clear(void);
 
 /* special function for previewing fonts */
 ImBuf *IMB_thumb_load_font(const char *filename, unsigned int x, unsigned int y);
@@ -97,6 +98,30 @@ void IMB_thumb_locks_release(void);
 void IMB_thumb_path_lock(const char *path);
 void IMB_thumb_path_unlock(const char *path);
 
+/* Statistics of IMB_thumb_manage since startup or the last reset */
+typedef struct ThumbStats {
+	/* valid thumbnails and failure thumbnails found in the thumbnail directory */
+	unsigned int hits;
+	/* thumbnails generated, and files for which generating failed */
+	unsigned int misses, failures;
+	/* seconds spent generating, summed over all threads */
+	double generate_time;
+} ThumbStats;
+
+void IMB_thumb_stats_get(ThumbStats *r_stats);
+void IMB_thumb_stats_reset(void);
+
+/* Batch of thumbnails managed by worker threads, requests with the lowest priority value are
+ * handled first (e.g. the distance to the visible items). Defined in thumbs_batch.c */
+typedef struct ThumbBatch ThumbBatch;
+
+ThumbBatch *IMB_thumb_batch_create(ThumbSize size, int num_threads);
+void IMB_thumb_batch_push(ThumbBatch *batch, const char *path, ThumbSource source, float priority, void *userdata);
+bool IMB_thumb_batch_pop(ThumbBatch *batch, ImBuf **r_img, void **r_userdata);
+void IMB_thumb_batch_cancel(ThumbBatch *batch);
+void IMB_thumb_batch_wait(ThumbBatch *batch);
+void IMB_thumb_batch_free(ThumbBatch *batch);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -94,6 +94,15 @@
 struct _AviMovie;
 struct anim_index;
 struct IDProperty;
+struct MovieCache;
+
+#ifdef WITH_FFMPEG
+/* slot of the ring buffer of decoded movie frames, the frame itself is in frame_cache_ibufs */
+struct anim_frame_cache_entry {
+	int64_t pts;        /* AV_NOPTS_VALUE = unused */
+	int64_t end_pts;    /* pts of the frame decoded after this one, -1 = unknown */
+};
+#endif
 
 struct anim {
 	int ib_flags;
@@ -147,6 +156,14 @@ struct anim {
 	int64_t last_pts;
 	int64_t next_pts;
 	AVPacket next_packet;
+	int decoder_position; /* position the decoder state belongs to, curposition
+	                       * can also point at a frame taken from frame_cache */
+
+	struct anim_frame_cache_entry *frame_cache;
+	struct MovieCache *frame_cache_ibufs; /* frames by pts, within the memory cache limit */
+	int frame_cache_len;     /* number of slots */
+	int frame_cache_next;    /* slot to overwrite next */
+	int frame_cache_pending; /* slot still waiting for its end_pts, -1 if none */
 #endif
 
 	char index_dir[768];
@@ -31,6 +31,7 @@
 /* Generic File Type */
 
 struct ImBuf;
+struct ImPartialRead;
 
 #define IM_FTYPE_FLOAT	1
 
@@ -89,6 +90,8 @@ int imb_savejp2(struct ImBuf *ibuf, const char *name, int flags);
 int imb_is_a_jpeg(const unsigned char *mem);
 int imb_savejpeg(struct ImBuf *ibuf, const char *name, int flags);
 struct ImBuf *imb_load_jpeg(const unsigned char *buffer, size_t size, int flags, char colorspace[IM_MAX_SPACE]);
+struct ImBuf *imb_load_jpeg_partial(const unsigned char *buffer, size_t size, int flags, struct ImPartialRead *partial,
+                                    char colorspace[IM_MAX_SPACE]);
 
 /* bmp */
 int imb_is_a_bmp(const unsigned char *buf);
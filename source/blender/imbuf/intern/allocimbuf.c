@@ -51,6 +51,7 @@
 #include "BLI_threads.h"
 
 static SpinLock refcounter_spin;
+static unsigned int imbuf_uid_counter = 0;
 
 void imb_refcounter_lock_init(void)
 {
@@ -237,6 +238,15 @@ void IMB_refImBuf(ImBuf *ibuf)
 	BLI_spin_unlock(&refcounter_spin);
 }
 
+/* The pixels of the buffer were changed in place or written to a file, together with the
+ * uid this lets caches tell the current contents apart from those seen before. */
+void IMB_generation_bump(ImBuf *ibuf)
+{
+	BLI_spin_lock(&refcounter_spin);
+	ibuf->generation++;
+	BLI_spin_unlock(&refcounter_spin);
+}
+
 ImBuf *IMB_makeSingleUser(ImBuf *ibuf)
 {
 	ImBuf *rval;
@@ -467,6 +477,10 @@ bool IMB_initImBuf(struct ImBuf *ibuf,
 {
 	memset(ibuf, 0, sizeof(ImBuf));
 
+	BLI_spin_lock(&refcounter_spin);
+	ibuf->uid = ++imbuf_uid_counter;
+	BLI_spin_unlock(&refcounter_spin);
+
 	ibuf->x = x;
 	ibuf->y = y;
 	ibuf->planes = planes;
@@ -565,6 +579,7 @@ ImBuf *IMB_dupImBuf(const ImBuf *ibuf1)
 	tbuf.mall               = ibuf2->mall;
 	tbuf.c_handle           = NULL;
 	tbuf.refcounter         = 0;
+	tbuf.uid                = ibuf2->uid;
 
 	/* for now don't duplicate metadata */
 	tbuf.metadata = NULL;
@@ -81,6 +81,7 @@
 #include "IMB_anim.h"
 #include "IMB_indexer.h"
 #include "IMB_metadata.h"
+#include "IMB_moviecache.h"
 
 #ifdef WITH_FFMPEG
 #  include "BKE_global.h"  /* ENDIAN_ORDER */
@@ -454,6 +455,11 @@ static ImBuf *avi_fetchibuf(struct anim *anim, int position)
 
 #ifdef WITH_FFMPEG
 
+/* Number of decoded frames kept per anim, so scrubbing backwards or playing in
+ * reverse doesn't re-decode a whole GOP per frame. Their memory is limited by
+ * the movie cache, together with all other cached frames. */
+#define FFMPEG_FRAME_CACHE_MAX_FRAMES 64
+
 BLI_INLINE bool need_aligned_ffmpeg_buffer(struct anim *anim)
 {
 	return (anim->x & 31) != 0;
@@ -571,11 +577,16 @@ static int startffmpeg(struct anim *anim)
 	anim->framesize = anim->x * anim->y * 4;
 
 	anim->curposition = -1;
+	anim->decoder_position = -1;
 	anim->last_frame = 0;
 	anim->last_pts = -1;
 	anim->next_pts = -1;
 	anim->next_packet.stream_index = -1;
 
+	anim->frame_cache_len = FFMPEG_FRAME_CACHE_MAX_FRAMES;
+	anim->frame_cache_next = 0;
+	anim->frame_cache_pending = -1;
+
 	anim->pFrame = av_frame_alloc();
 	anim->pFrameComplete = false;
 	anim->pFrameDeinterlaced = av_frame_alloc();
@@ -678,13 +689,12 @@ static int startffmpeg(struct anim *anim)
 /* postprocess the image in anim->pFrame and do color conversion
  * and deinterlacing stuff.
  *
- * Output is anim->last_frame
+ * Output is ibuf
  */
 
-static void ffmpeg_postprocess(struct anim *anim)
+static void ffmpeg_postprocess(struct anim *anim, ImBuf *ibuf)
 {
 	AVFrame *input = anim->pFrame;
-	ImBuf *ibuf = anim->last_frame;
 	int filter_y = 0;
 
 	if (!anim->pFrameComplete) {
@@ -808,6 +818,134 @@ static void ffmpeg_postprocess(struct anim *anim)
 	}
 }
 
+/* Ring buffer of decoded frames.
+ *
+ * Copies of every frame handed out by ffmpeg_fetchibuf() and the frames decoded
+ * while walking a GOP towards the requested one are kept here, keyed by pts.
+ * The interval a frame covers ends at the pts of the frame decoded right
+ * after it, which is only known once that one is decoded (see
+ * ffmpeg_frame_cache_link()). The frames themselves are stored in a movie
+ * cache, which can evict them when the memory cache limit is reached. */
+
+static unsigned int ffmpeg_frame_cache_hash(const void *key_v)
+{
+	const int64_t *key = key_v;
+	return BLI_ghashutil_uinthash((unsigned int)(*key ^ (*key >> 32)));
+}
+
+static bool ffmpeg_frame_cache_cmp(const void *a_v, const void *b_v)
+{
+	const int64_t *a = a_v;
+	const int64_t *b = b_v;
+	return *a != *b;
+}
+
+static bool ffmpeg_frame_cache_remove_cb(ImBuf *UNUSED(ibuf), void *userkey, void *userdata)
+{
+	return *(int64_t *)userkey == *(int64_t *)userdata;
+}
+
+/* returns a copy of the cached frame, the caller may modify it */
+static ImBuf *ffmpeg_frame_cache_lookup(struct anim *anim, int64_t pts)
+{
+	int i;
+
+	if (anim->frame_cache == NULL) {
+		return NULL;
+	}
+
+	for (i = 0; i < anim->frame_cache_len; i++) {
+		struct anim_frame_cache_entry *entry = &anim->frame_cache[i];
+
+		if (entry->pts == AV_NOPTS_VALUE) {
+			continue;
+		}
+		if (entry->pts == pts ||
+		    (entry->pts < pts && pts < entry->end_pts))
+		{
+			ImBuf *ibuf = IMB_moviecache_get(anim->frame_cache_ibufs, &entry->pts);
+			ImBuf *ibuf_copy = NULL;
+
+			if (ibuf) {
+				ibuf_copy = IMB_dupImBuf(ibuf);
+				IMB_freeImBuf(ibuf);
+			}
+			return ibuf_copy;
+		}
+	}
+
+	return NULL;
+}
+
+static void ffmpeg_frame_cache_insert(struct anim *anim, ImBuf *ibuf, int64_t pts)
+{
+	struct anim_frame_cache_entry *entry = NULL;
+	int i;
+
+	if (anim->frame_cache_len == 0 || pts == AV_NOPTS_VALUE) {
+		return;
+	}
+
+	if (anim->frame_cache == NULL) {
+		anim->frame_cache = MEM_mallocN(sizeof(*anim->frame_cache) * anim->frame_cache_len,
+		                                "anim frame cache");
+		for (i = 0; i < anim->frame_cache_len; i++) {
+			anim->frame_cache[i].pts = AV_NOPTS_VALUE;
+		}
+		anim->frame_cache_ibufs = IMB_moviecache_create("anim frame cache", sizeof(int64_t),
+		                                                ffmpeg_frame_cache_hash, ffmpeg_frame_cache_cmp);
+	}
+
+	/* the same GOP can be walked again, replace instead of duplicating */
+	for (i = 0; i < anim->frame_cache_len; i++) {
+		if (anim->frame_cache[i].pts == pts) {
+			entry = &anim->frame_cache[i];
+			break;
+		}
+	}
+
+	if (entry == NULL) {
+		i = anim->frame_cache_next;
+		entry = &anim->frame_cache[i];
+		anim->frame_cache_next = (i + 1) % anim->frame_cache_len;
+
+		if (entry->pts != AV_NOPTS_VALUE) {
+			IMB_moviecache_cleanup(anim->frame_cache_ibufs, ffmpeg_frame_cache_remove_cb, &entry->pts);
+		}
+	}
+
+	IMB_moviecache_put(anim->frame_cache_ibufs, &pts, ibuf);
+
+	entry->pts = pts;
+	entry->end_pts = -1;
+
+	anim->frame_cache_pending = i;
+}
+
+/* the frame just decoded ends the interval of the previously cached one */
+static void ffmpeg_frame_cache_link(struct anim *anim)
+{
+	if (anim->frame_cache_pending != -1) {
+		anim->frame_cache[anim->frame_cache_pending].end_pts = anim->next_pts;
+		anim->frame_cache_pending = -1;
+	}
+}
+
+static void ffmpeg_frame_cache_free(struct anim *anim)
+{
+	if (anim->frame_cache == NULL) {
+		return;
+	}
+
+	IMB_moviecache_free(anim->frame_cache_ibufs);
+	anim->frame_cache_ibufs = NULL;
+
+	MEM_freeN(anim->frame_cache);
+	anim->frame_cache = NULL;
+	anim->frame_cache_next = 0;
+	anim->frame_cache_pending = -1;
+}
+
 /* decode one video frame also considering the packet read into next_packet */
 
 static int ffmpeg_decode_video_frame(struct anim *anim)
@@ -916,6 +1054,9 @@ static void ffmpeg_decode_video_frame_scan(
 {
 	/* there seem to exist *very* silly GOP lengths out in the wild... */
 	int count = 1000;
+	AVStream *v_st = anim->pFormatCtx->streams[anim->videoStream];
+	double frame_pts_step = 1.0 / (av_q2d(av_get_r_frame_rate_compat(anim->pFormatCtx, v_st)) *
+	                               av_q2d(v_st->time_base));
 
 	av_log(anim->pFormatCtx,
 	       AV_LOG_DEBUG, 
@@ -930,6 +1071,22 @@ static void ffmpeg_decode_video_frame_scan(
 		if (!ffmpeg_decode_video_frame(anim)) {
 			break;
 		}
+		ffmpeg_frame_cache_link(anim);
+
+		/* Keep the frames right before the one searched for, those are
+		 * the ones asked for next when scrubbing backwards. Converting
+		 * the start of a long GOP would only push them out again. */
+		if (anim->pFrameComplete &&
+		    anim->next_pts < pts_to_search &&
+		    (pts_to_search - anim->next_pts) < frame_pts_step * anim->frame_cache_len)
+		{
+			ImBuf *ibuf = IMB_allocImBuf(anim->x, anim->y, 32, IB_rect);
+			ibuf->rect_colorspace = colormanage_colorspace_get_named(anim->colorspace);
+
+			ffmpeg_postprocess(anim, ibuf);
+			ffmpeg_frame_cache_insert(anim, ibuf, anim->next_pts);
+			IMB_freeImBuf(ibuf);
+		}
 		count--;
 	}
 	if (count == 0) {
@@ -989,6 +1146,28 @@ static int ffmpeg_seek_by_byte(AVFormatContext *pFormatCtx)
 	return false;
 }
 
+/* Any timecode index built for the movie knows where the keyframes are,
+ * use it to seek even when frames are addressed without timecode. */
+static struct anim_index *ffmpeg_keyframe_index(struct anim *anim)
+{
+	static const IMB_Timecode_Type tc_types[] = {
+		IMB_TC_RECORD_RUN,
+		IMB_TC_FREE_RUN,
+		IMB_TC_INTERPOLATED_REC_DATE_FREE_RUN,
+		IMB_TC_RECORD_RUN_NO_GAPS,
+	};
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(tc_types); i++) {
+		struct anim_index *idx = IMB_anim_open_index(anim, tc_types[i]);
+		if (idx) {
+			return idx;
+		}
+	}
+
+	return NULL;
+}
+
 static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
                                IMB_Timecode_Type tc)
 {
@@ -997,7 +1176,9 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 	double pts_time_base;
 	long long st_time; 
 	struct anim_index *tc_index = 0;
+	struct anim_index *seek_index = 0;
 	AVStream *v_st;
+	ImBuf *cached_frame;
 	int new_frame_index = 0; /* To quiet gcc barking... */
 	int old_frame_index = 0; /* To quiet gcc barking... */
 
@@ -1020,9 +1201,10 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 		new_frame_index = IMB_indexer_get_frame_index(
 		        tc_index, position);
 		old_frame_index = IMB_indexer_get_frame_index(
-		        tc_index, anim->curposition);
+		        tc_index, anim->decoder_position);
 		pts_to_search = IMB_indexer_get_pts(
 		        tc_index, new_frame_index);
+		seek_index = tc_index;
 	}
 	else {
 		pts_to_search = (long long) 
@@ -1032,6 +1214,14 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 		if (st_time != AV_NOPTS_VALUE) {
 			pts_to_search += st_time / pts_time_base / AV_TIME_BASE;
 		}
+
+		seek_index = ffmpeg_keyframe_index(anim);
+		if (seek_index) {
+			new_frame_index = IMB_indexer_get_frame_index_for_pts(
+			        seek_index, pts_to_search);
+			old_frame_index = IMB_indexer_get_frame_index_for_pts(
+			        seek_index, anim->last_pts);
+		}
 	}
 
 	av_log(anim->pFormatCtx, AV_LOG_DEBUG, 
@@ -1048,21 +1238,34 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 		       (long long int)anim->next_pts);
 		IMB_refImBuf(anim->last_frame);
 		anim->curposition = position;
+		anim->decoder_position = position;
 		return anim->last_frame;
 	}
-	 
-	if (position > anim->curposition + 1 &&
+
+	/* When the decoder is right in front of the frame, decoding it is as cheap
+	 * as a cache hit and keeps forward playback from running into seeks. */
+	if (position != anim->decoder_position + 1) {
+		cached_frame = ffmpeg_frame_cache_lookup(anim, pts_to_search);
+		if (cached_frame) {
+			av_log(anim->pFormatCtx, AV_LOG_DEBUG,
+			       "FETCH: frame cache hit for PTS=%lld\n",
+			       (long long int)pts_to_search);
+			return cached_frame;
+		}
+	}
+
+	if (position > anim->decoder_position + 1 &&
 	    anim->preseek &&
-	    !tc_index &&
-	    position - (anim->curposition + 1) < anim->preseek)
+	    !seek_index &&
+	    position - (anim->decoder_position + 1) < anim->preseek)
 	{
 		av_log(anim->pFormatCtx, AV_LOG_DEBUG, 
 		       "FETCH: within preseek interval (no index)\n");
 
 		ffmpeg_decode_video_frame_scan(anim, pts_to_search);
 	}
-	else if (tc_index &&
-	         IMB_indexer_can_scan(tc_index, old_frame_index,
+	else if (seek_index &&
+	         IMB_indexer_can_scan(seek_index, old_frame_index,
 	                              new_frame_index))
 	{
 		av_log(anim->pFormatCtx, AV_LOG_DEBUG, 
@@ -1071,17 +1274,17 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 
 		ffmpeg_decode_video_frame_scan(anim, pts_to_search);
 	}
-	else if (position != anim->curposition + 1) {
+	else if (position != anim->decoder_position + 1) {
 		long long pos;
 		int ret;
 
-		if (tc_index) {
+		if (seek_index) {
 			unsigned long long dts;
 
 			pos = IMB_indexer_get_seek_pos(
-			    tc_index, new_frame_index);
+			    seek_index, new_frame_index);
 			dts = IMB_indexer_get_seek_pos_dts(
-			    tc_index, new_frame_index);
+			    seek_index, new_frame_index);
 
 			av_log(anim->pFormatCtx, AV_LOG_DEBUG, 
 			       "TC INDEX seek pos = %lld\n", pos);
@@ -1137,6 +1340,7 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 		}
 
 		avcodec_flush_buffers(anim->pCodecCtx);
+		anim->frame_cache_pending = -1;
 
 		anim->next_pts = -1;
 
@@ -1151,7 +1355,7 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 			ffmpeg_decode_video_frame_scan(anim, pts_to_search);
 		}
 	}
-	else if (position == 0 && anim->curposition == -1) {
+	else if (position == 0 && anim->decoder_position == -1) {
 		/* first frame without seeking special case... */
 		ffmpeg_decode_video_frame(anim);
 	}
@@ -1164,13 +1368,22 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 	anim->last_frame = IMB_allocImBuf(anim->x, anim->y, 32, IB_rect);
 	anim->last_frame->rect_colorspace = colormanage_colorspace_get_named(anim->colorspace);
 
-	ffmpeg_postprocess(anim);
+	ffmpeg_postprocess(anim, anim->last_frame);
 
 	anim->last_pts = anim->next_pts;
-	
-	ffmpeg_decode_video_frame(anim);
+	if (anim->pFrameComplete) {
+		/* last_frame is handed out, the cache gets its own copy */
+		ImBuf *ibuf = IMB_dupImBuf(anim->last_frame);
+		ffmpeg_frame_cache_insert(anim, ibuf, anim->last_pts);
+		IMB_freeImBuf(ibuf);
+	}
+
+	if (ffmpeg_decode_video_frame(anim)) {
+		ffmpeg_frame_cache_link(anim);
+	}
 	
 	anim->curposition = position;
+	anim->decoder_position = position;
 	
 	IMB_refImBuf(anim->last_frame);
 
@@ -1208,6 +1421,7 @@ static void free_anim_ffmpeg(struct anim *anim)
 
 		sws_freeContext(anim->img_convert_ctx);
 		IMB_freeImBuf(anim->last_frame);
+		ffmpeg_frame_cache_free(anim);
 		if (anim->next_packet.stream_index != -1) {
 			av_free_packet(&anim->next_packet);
 		}
@@ -71,6 +71,10 @@
 
 #include <ocio_capi.h>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 /*********************** Global declarations *************************/
 
 #define DISPLAY_BUFFER_CHANNELS 4
@@ -109,6 +113,9 @@ typedef struct ColormanageProcessor {
 	OCIO_ConstProcessorRcPtr *processor;
 	CurveMapping *curve_mapping;
 	bool is_data_result;
+
+	/* baked OCIO processor, used instead of the processor when set */
+	struct ColormanageDisplayLUT *display_lut;
 } ColormanageProcessor;
 
 static struct global_glsl_state {
@@ -447,6 +454,354 @@ static void colormanage_cache_handle_release(void *cache_handle)
 	IMB_freeImBuf(cache_ibuf);
 }
 
+/*********************** Display transform LUT *************************/
+
+/* Display transforms of the buffers drawn on screen are baked into a 3D LUT, which is
+ * much faster to apply than the OCIO processor. Scene linear values are mapped to the
+ * LUT with a log2 shaper covering 8 stops below to 6 stops above white, negative values
+ * and values above that range are clamped. This is only used when the result is stored
+ * in a byte buffer, where the difference with the exact transform is below the
+ * quantization (see colormanagement_test.cc).
+ */
+
+#define DISPLAY_LUT_SIZE 64
+/* offset added before taking the log2, so zero maps to the first lattice point */
+#define DISPLAY_LUT_SHAPER_OFFSET (1.0f / 256.0f)
+/* log2(1.0 + DISPLAY_LUT_SHAPER_OFFSET), white falls exactly on a lattice point since 8 stops
+ * are 36 lattice steps. Otherwise transforms clipping at white are interpolated across the
+ * clip, which gives errors of almost half a byte step just below white. */
+#define DISPLAY_LUT_SHAPER_WHITE 0.00562454919f
+#define DISPLAY_LUT_SHAPER_MIN (DISPLAY_LUT_SHAPER_WHITE - 8.0f)
+#define DISPLAY_LUT_SHAPER_MAX (DISPLAY_LUT_SHAPER_WHITE + 6.0f)
+#define DISPLAY_LUT_SHAPER_SCALE ((DISPLAY_LUT_SIZE - 1) / (DISPLAY_LUT_SHAPER_MAX - DISPLAY_LUT_SHAPER_MIN))
+
+/* number of LUTs kept around for different view settings */
+#define DISPLAY_LUT_CACHE_SIZE 4
+
+typedef struct ColormanageDisplayLUT {
+	/* settings of the baked processor for comparison */
+	char look[MAX_COLORSPACE_NAME];
+	char view[MAX_COLORSPACE_NAME];
+	char display[MAX_COLORSPACE_NAME];
+	float exposure, gamma;
+
+	/* processors using the LUT, it's only freed when unused */
+	int users;
+	bool is_cached;
+	unsigned int last_used;
+
+	/* RGB of the lattice points, padded to 4 floats, red varies fastest */
+	float *table;
+} ColormanageDisplayLUT;
+
+static struct global_display_lut_state {
+	ColormanageDisplayLUT *luts[DISPLAY_LUT_CACHE_SIZE];
+	unsigned int use_counter;
+} global_display_lut_state;
+
+static pthread_mutex_t display_lut_lock = BLI_MUTEX_INITIALIZER;
+
+static float display_lut_shaper_inverse(int index)
+{
+	return exp2f((float)index / DISPLAY_LUT_SHAPER_SCALE + DISPLAY_LUT_SHAPER_MIN) - DISPLAY_LUT_SHAPER_OFFSET;
+}
+
+typedef struct DisplayLUTBakeData {
+	OCIO_ConstProcessorRcPtr *processor;
+	float *table;
+} DisplayLUTBakeData;
+
+/* every scanline is a row of lattice points of constant green and blue, so the
+ * bake is split into as many tasks as an image of DISPLAY_LUT_SIZE^2 scanlines */
+static void display_lut_bake_thread_do(void *data_v, int start_scanline, int num_scanlines)
+{
+	DisplayLUTBakeData *data = (DisplayLUTBakeData *)data_v;
+	const size_t row_size = (size_t)DISPLAY_LUT_SIZE * 4;
+	float *table = data->table + start_scanline * row_size;
+	OCIO_PackedImageDesc *img;
+	int r, row;
+
+	for (row = start_scanline; row < start_scanline + num_scanlines; row++) {
+		const float green = display_lut_shaper_inverse(row % DISPLAY_LUT_SIZE);
+		const float blue = display_lut_shaper_inverse(row / DISPLAY_LUT_SIZE);
+
+		for (r = 0; r < DISPLAY_LUT_SIZE; r++, table += 4) {
+			table[0] = display_lut_shaper_inverse(r);
+			table[1] = green;
+			table[2] = blue;
+			table[3] = 1.0f;
+		}
+	}
+
+	img = OCIO_createOCIO_PackedImageDesc(
+	        data->table + start_scanline * row_size,
+	        DISPLAY_LUT_SIZE, num_scanlines, 4, sizeof(float),
+	        4 * sizeof(float), row_size * sizeof(float));
+	OCIO_processorApply(data->processor, img);
+	OCIO_PackedImageDescRelease(img);
+}
+
+static ColormanageDisplayLUT *display_lut_bake(OCIO_ConstProcessorRcPtr *processor,
+                                               const ColorManagedViewSettings *view_settings,
+                                               const ColorManagedDisplaySettings *display_settings)
+{
+	ColormanageDisplayLUT *lut = MEM_callocN(sizeof(ColormanageDisplayLUT), "colormanagement display LUT");
+	DisplayLUTBakeData data;
+
+	BLI_strncpy(lut->look, view_settings->look, MAX_COLORSPACE_NAME);
+	BLI_strncpy(lut->view, view_settings->view_transform, MAX_COLORSPACE_NAME);
+	BLI_strncpy(lut->display, display_settings->display_device, MAX_COLORSPACE_NAME);
+	lut->exposure = view_settings->exposure;
+	lut->gamma = view_settings->gamma;
+
+	lut->table = MEM_mallocN(sizeof(float) * 4 * DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE,
+	                          "colormanagement display LUT table");
+
+	data.processor = processor;
+	data.table = lut->table;
+	IMB_processor_apply_threaded_scanlines(DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE, display_lut_bake_thread_do, &data);
+
+	return lut;
+}
+
+static void display_lut_free(ColormanageDisplayLUT *lut)
+{
+	MEM_freeN(lut->table);
+	MEM_freeN(lut);
+}
+
+static bool display_lut_matches(const ColormanageDisplayLUT *lut,
+                                const ColorManagedViewSettings *view_settings,
+                                const ColorManagedDisplaySettings *display_settings)
+{
+	return lut->exposure == view_settings->exposure &&
+	       lut->gamma == view_settings->gamma &&
+	       STREQ(lut->look, view_settings->look) &&
+	       STREQ(lut->view, view_settings->view_transform) &&
+	       STREQ(lut->display, display_settings->display_device);
+}
+
+/* get the LUT of the processor from the cache or bake it, must be released after use */
+static ColormanageDisplayLUT *display_lut_acquire(OCIO_ConstProcessorRcPtr *processor,
+                                                  const ColorManagedViewSettings *view_settings,
+                                                  const ColorManagedDisplaySettings *display_settings)
+{
+	struct global_display_lut_state *state = &global_display_lut_state;
+	ColormanageDisplayLUT *lut = NULL;
+	int i, slot = -1;
+
+	BLI_mutex_lock(&display_lut_lock);
+
+	for (i = 0; i < DISPLAY_LUT_CACHE_SIZE; i++) {
+		if (state->luts[i] && display_lut_matches(state->luts[i], view_settings, display_settings)) {
+			lut = state->luts[i];
+			break;
+		}
+	}
+
+	if (lut == NULL) {
+		/* baking holds the lock, so a LUT isn't baked twice when several buffers are drawn at once */
+		lut = display_lut_bake(processor, view_settings, display_settings);
+
+		/* replace the least recently used LUT which isn't in use */
+		for (i = 0; i < DISPLAY_LUT_CACHE_SIZE; i++) {
+			if (state->luts[i] == NULL) {
+				slot = i;
+				break;
+			}
+			if (state->luts[i]->users == 0 &&
+			    (slot == -1 || state->luts[i]->last_used < state->luts[slot]->last_used))
+			{
+				slot = i;
+			}
+		}
+
+		if (slot != -1) {
+			if (state->luts[slot]) {
+				display_lut_free(state->luts[slot]);
+			}
+			state->luts[slot] = lut;
+			lut->is_cached = true;
+		}
+	}
+
+	lut->users++;
+	lut->last_used = ++state->use_counter;
+
+	BLI_mutex_unlock(&display_lut_lock);
+
+	return lut;
+}
+
+static void display_lut_release(ColormanageDisplayLUT *lut)
+{
+	BLI_mutex_lock(&display_lut_lock);
+	lut->users--;
+	if (lut->users == 0 && !lut->is_cached) {
+		display_lut_free(lut);
+	}
+	BLI_mutex_unlock(&display_lut_lock);
+}
+
+static void display_lut_free_all(void)
+{
+	int i;
+
+	for (i = 0; i < DISPLAY_LUT_CACHE_SIZE; i++) {
+		if (global_display_lut_state.luts[i]) {
+			BLI_assert(global_display_lut_state.luts[i]->users == 0);
+			display_lut_free(global_display_lut_state.luts[i]);
+			global_display_lut_state.luts[i] = NULL;
+		}
+	}
+}
+
+#ifdef __SSE2__
+/* log2 of positive normalized values, the polynomial approximation of the mantissa's log2
+ * has an error below 3e-5, well below the spacing of the lattice points */
+static __m128 display_lut_log2_sse2(__m128 v)
+{
+	const __m128i bits = _mm_castps_si128(v);
+	const __m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+	const __m128 mantissa = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)),
+	                                                      _mm_set1_epi32(0x3f800000)));
+	__m128 p;
+
+	p = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.0458788306f), mantissa), _mm_set1_ps(-0.377923356f));
+	p = _mm_add_ps(_mm_mul_ps(p, mantissa), _mm_set1_ps(1.27390803f));
+	p = _mm_add_ps(_mm_mul_ps(p, mantissa), _mm_set1_ps(-2.30624014f));
+	p = _mm_add_ps(_mm_mul_ps(p, mantissa), _mm_set1_ps(2.80620212f));
+
+	return _mm_add_ps(exponent, _mm_mul_ps(p, _mm_sub_ps(mantissa, _mm_set1_ps(1.0f))));
+}
+
+BLI_INLINE __m128 display_lut_lerp_sse2(__m128 a, __m128 b, __m128 t)
+{
+	return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+}
+
+/* trilinear interpolation of the RGB of a pixel, all channels at once */
+static void display_lut_apply_rgb(const float *table, float rgb[3])
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 max_coord = _mm_set1_ps((float)(DISPLAY_LUT_SIZE - 1));
+	const __m128i max_index = _mm_set1_epi32(DISPLAY_LUT_SIZE - 2);
+	__m128 v = _mm_set_ps(0.0f, rgb[2], rgb[1], rgb[0]);
+	__m128 coord, frac, c00, c01, c10, c11, c0, c1, result;
+	__m128i index, lt;
+	int offset[4];
+	float f[4], out[4];
+	const float *p;
+
+	v = _mm_add_ps(_mm_max_ps(v, zero), _mm_set1_ps(DISPLAY_LUT_SHAPER_OFFSET));
+	coord = _mm_mul_ps(_mm_sub_ps(display_lut_log2_sse2(v), _mm_set1_ps(DISPLAY_LUT_SHAPER_MIN)),
+	                   _mm_set1_ps(DISPLAY_LUT_SHAPER_SCALE));
+	coord = _mm_min_ps(_mm_max_ps(coord, zero), max_coord);
+
+	/* the last cell is used for the last lattice point */
+	index = _mm_cvttps_epi32(coord);
+	lt = _mm_cmplt_epi32(index, max_index);
+	index = _mm_or_si128(_mm_and_si128(lt, index), _mm_andnot_si128(lt, max_index));
+	frac = _mm_sub_ps(coord, _mm_cvtepi32_ps(index));
+
+	_mm_storeu_si128((__m128i *)offset, index);
+	_mm_storeu_ps(f, frac);
+
+	p = table + 4 * (((size_t)offset[2] * DISPLAY_LUT_SIZE + offset[1]) * DISPLAY_LUT_SIZE + offset[0]);
+
+#define LUT_STEP_R 4
+#define LUT_STEP_G (4 * DISPLAY_LUT_SIZE)
+#define LUT_STEP_B (4 * DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE)
+	frac = _mm_set1_ps(f[0]);
+	c00 = display_lut_lerp_sse2(_mm_loadu_ps(p), _mm_loadu_ps(p + LUT_STEP_R), frac);
+	c01 = display_lut_lerp_sse2(_mm_loadu_ps(p + LUT_STEP_B), _mm_loadu_ps(p + LUT_STEP_B + LUT_STEP_R), frac);
+	c10 = display_lut_lerp_sse2(_mm_loadu_ps(p + LUT_STEP_G), _mm_loadu_ps(p + LUT_STEP_G + LUT_STEP_R), frac);
+	c11 = display_lut_lerp_sse2(_mm_loadu_ps(p + LUT_STEP_G + LUT_STEP_B),
+	                            _mm_loadu_ps(p + LUT_STEP_G + LUT_STEP_B + LUT_STEP_R), frac);
+#undef LUT_STEP_R
+#undef LUT_STEP_G
+#undef LUT_STEP_B
+
+	frac = _mm_set1_ps(f[1]);
+	c0 = display_lut_lerp_sse2(c00, c10, frac);
+	c1 = display_lut_lerp_sse2(c01, c11, frac);
+	result = display_lut_lerp_sse2(c0, c1, _mm_set1_ps(f[2]));
+
+	_mm_storeu_ps(out, result);
+	copy_v3_v3(rgb, out);
+}
+#else
+static void display_lut_apply_rgb(const float *table, float rgb[3])
+{
+	int offset[3], i;
+	float f[3], c00, c01, c10, c11;
+	const float *p;
+
+	for (i = 0; i < 3; i++) {
+		const float v = max_ff(rgb[i], 0.0f) + DISPLAY_LUT_SHAPER_OFFSET;
+		float coord = (log2f(v) - DISPLAY_LUT_SHAPER_MIN) * DISPLAY_LUT_SHAPER_SCALE;
+
+		CLAMP(coord, 0.0f, (float)(DISPLAY_LUT_SIZE - 1));
+		offset[i] = min_ii((int)coord, DISPLAY_LUT_SIZE - 2);
+		f[i] = coord - (float)offset[i];
+	}
+
+	p = table + 4 * (((size_t)offset[2] * DISPLAY_LUT_SIZE + offset[1]) * DISPLAY_LUT_SIZE + offset[0]);
+
+	for (i = 0; i < 3; i++) {
+		const float *q = p + i;
+		const int step_g = 4 * DISPLAY_LUT_SIZE, step_b = 4 * DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE;
+
+		c00 = interpf(q[4], q[0], f[0]);
+		c01 = interpf(q[step_b + 4], q[step_b], f[0]);
+		c10 = interpf(q[step_g + 4], q[step_g], f[0]);
+		c11 = interpf(q[step_g + step_b + 4], q[step_g + step_b], f[0]);
+
+		rgb[i] = interpf(interpf(c11, c01, f[1]), interpf(c10, c00, f[1]), f[2]);
+	}
+}
+#endif
+
+static void display_lut_apply(const ColormanageDisplayLUT *lut, float *buffer, int width, int height,
+                              int channels, bool predivide)
+{
+	const size_t num_pixels = (size_t)width * height;
+	float *pixel = buffer;
+	size_t i;
+
+	BLI_assert(channels >= 3);
+
+	for (i = 0; i < num_pixels; i++, pixel += channels) {
+		/* same as OCIO_processorApply_predivide */
+		if (predivide && channels == 4 && pixel[3] != 1.0f && pixel[3] != 0.0f) {
+			const float alpha = pixel[3];
+
+			mul_v3_fl(pixel, 1.0f / alpha);
+			display_lut_apply_rgb(lut->table, pixel);
+			mul_v3_fl(pixel, alpha);
+		}
+		else {
+			display_lut_apply_rgb(lut->table, pixel);
+		}
+	}
+}
+
+/* use a baked LUT for the OCIO processor of a display processor, unless exact output is asked for.
+ * Only for results stored in byte buffers, the view and display settings must be the ones the
+ * processor was created for */
+void IMB_colormanagement_processor_use_display_lut(ColormanageProcessor *cm_processor,
+                                                   const ColorManagedViewSettings *view_settings,
+                                                   const ColorManagedDisplaySettings *display_settings)
+{
+	if (cm_processor->processor == NULL || view_settings == NULL ||
+	    (view_settings->flag & COLORMANAGE_VIEW_EXACT_TRANSFORM))
+	{
+		return;
+	}
+
+	cm_processor->display_lut = display_lut_acquire(cm_processor->processor, view_settings, display_settings);
+}
+
 /*********************** Initialization / De-initialization *************************/
 
 static void colormanage_role_color_space_name_get(OCIO_ConstConfigRcPtr *config, char *colorspace_name, const char *role, const char *backup_role)
@@ -699,6 +1054,8 @@ void colormanagement_exit(void)
 	if (global_glsl_state.transform_ocio_glsl_state)
 		OCIO_freeOGLState(global_glsl_state.transform_ocio_glsl_state);
 
+	display_lut_free_all();
+
 	colormanage_free_config();
 }
 
@@ -1551,9 +1908,15 @@ static void colormanage_display_buffer_process_ex(ImBuf *ibuf, float *display_bu
 		skip_transform = is_ibuf_rect_in_display_space(ibuf, view_settings, display_settings);
 	}
 
-	if (skip_transform == false)
+	if (skip_transform == false) {
 		cm_processor = IMB_colormanagement_display_processor_new(view_settings, display_settings);
 
+		/* buffers only drawn on screen can use the LUT */
+		if (display_buffer == NULL) {
+			IMB_colormanagement_processor_use_display_lut(cm_processor, view_settings, display_settings);
+		}
+	}
+
 	display_buffer_apply_threaded(ibuf, ibuf->rect_float, (unsigned char *) ibuf->rect,
 	                              display_buffer, display_buffer_byte, cm_processor);
 
@@ -2105,6 +2468,7 @@ void IMB_colormanagement_buffer_make_display_space(float *buffer, unsigned char
 	memcpy(display_buffer_float, buffer, float_buffer_size);
 
 	cm_processor = IMB_colormanagement_display_processor_new(view_settings, display_settings);
+	IMB_colormanagement_processor_use_display_lut(cm_processor, view_settings, display_settings);
 
 	processor_transform_apply_threaded(NULL, display_buffer_float, width, height, channels,
 	                                   cm_processor, true, false);
@@ -3238,7 +3602,10 @@ void IMB_colormanagement_processor_apply(ColormanageProcessor *cm_processor, flo
 		}
 	}
 
-	if (cm_processor->processor && channels >= 3) {
+	if (cm_processor->display_lut && channels >= 3) {
+		display_lut_apply(cm_processor->display_lut, buffer, width, height, channels, predivide);
+	}
+	else if (cm_processor->processor && channels >= 3) {
 		OCIO_PackedImageDesc *img;
 
 		/* apply OCIO processor */
@@ -3281,6 +3648,8 @@ void IMB_colormanagement_processor_free(ColormanageProcessor *cm_processor)
 		curvemapping_free(cm_processor->curve_mapping);
 	if (cm_processor->processor)
 		OCIO_processorRelease(cm_processor->processor);
+	if (cm_processor->display_lut)
+		display_lut_release(cm_processor->display_lut);
 
 	MEM_freeN(cm_processor);
 }
@@ -45,6 +45,10 @@
 
 #include "MEM_guardedalloc.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 /**************************** Interlace/Deinterlace **************************/
 
 void IMB_de_interlace(ImBuf *ibuf)
@@ -122,6 +126,166 @@ static void clear_dither_context(DitherContext *di)
 	MEM_freeN(di);
 }
 
+/* The noise of dither_random_value(), with a polynomial instead of sinf() so it can
+ * be computed for four pixels at once. The SSE2 version gives exactly the same values.
+ * s and t are never negative, so the sine argument is in [0, 91.2]. */
+MINLINE float dither_noise(float s, float t)
+{
+	const float x = s * 12.9898f + t * 78.233f;
+	const float k = (float)(int)(x * (float)(0.5 / M_PI) + 0.5f);
+	float r, r2, value;
+
+	/* reduce to [-pi, pi], 2 * pi is split so k * 6.28125f is exact */
+	r = x - k * 6.28125f;
+	r = r - k * 1.9353071795864769e-3f;
+	r2 = r * r;
+	value = r * (1.0f + r2 * (-1.6666667e-1f + r2 * (8.3333333e-3f + r2 * (-1.9841270e-4f + r2 * 2.7557319e-6f))));
+
+	value *= 43758.5453f;
+	return value - floorf(value);
+}
+
+#ifdef __SSE2__
+MALWAYS_INLINE __m128 dither_noise_sse(const __m128 s, const __m128 t)
+{
+	const __m128 x = _mm_add_ps(_mm_mul_ps(s, _mm_set1_ps(12.9898f)), _mm_mul_ps(t, _mm_set1_ps(78.233f)));
+	const __m128 k = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps((float)(0.5 / M_PI))),
+	                                                             _mm_set1_ps(0.5f))));
+	__m128 r, r2, value, value_floor;
+
+	r = _mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(6.28125f)));
+	r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(1.9353071795864769e-3f)));
+	r2 = _mm_mul_ps(r, r);
+	value = _mm_add_ps(_mm_set1_ps(-1.9841270e-4f), _mm_mul_ps(r2, _mm_set1_ps(2.7557319e-6f)));
+	value = _mm_add_ps(_mm_set1_ps(8.3333333e-3f), _mm_mul_ps(r2, value));
+	value = _mm_add_ps(_mm_set1_ps(-1.6666667e-1f), _mm_mul_ps(r2, value));
+	value = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r2, value));
+	value = _mm_mul_ps(r, value);
+
+	value = _mm_mul_ps(value, _mm_set1_ps(43758.5453f));
+	/* floorf(), the value is small enough for an int */
+	value_floor = _mm_cvtepi32_ps(_mm_cvttps_epi32(value));
+	value_floor = _mm_sub_ps(value_floor, _mm_and_ps(_mm_cmpgt_ps(value_floor, value), _mm_set1_ps(1.0f)));
+	return _mm_sub_ps(value, value_floor);
+}
+#endif  /* __SSE2__ */
+
+/*************************** SIMD Pixel Conversion ***************************/
+
+/* Conversion of 4-channel pixels with SSE2, giving exactly the same results as
+ * the per pixel functions used for the remaining pixels of a row. */
+
+#ifdef __SSE2__
+
+#define SSE_MASK_ALPHA _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0))
+
+/* color channels from rgb, alpha from rgba */
+MALWAYS_INLINE __m128 sse_keep_alpha(const __m128 rgb, const __m128 rgba)
+{
+	return _bli_math_blend_sse(SSE_MASK_ALPHA, rgba, rgb);
+}
+
+MALWAYS_INLINE __m128 sse_alpha(const __m128 rgba)
+{
+	return _mm_shuffle_ps(rgba, rgba, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+/* premul_to_straight_v4_v4() */
+MALWAYS_INLINE __m128 premul_to_straight_sse(const __m128 premul)
+{
+	const __m128 alpha = sse_alpha(premul);
+	const __m128 keep = _mm_or_ps(_mm_cmpeq_ps(alpha, _mm_setzero_ps()), _mm_cmpeq_ps(alpha, _mm_set1_ps(1.0f)));
+	const __m128 straight = _mm_mul_ps(premul, _mm_div_ps(_mm_set1_ps(1.0f), alpha));
+	return _bli_math_blend_sse(_mm_or_ps(keep, SSE_MASK_ALPHA), premul, straight);
+}
+
+/* straight_to_premul_v4_v4() */
+MALWAYS_INLINE __m128 straight_to_premul_sse(const __m128 straight)
+{
+	return sse_keep_alpha(_mm_mul_ps(straight, sse_alpha(straight)), straight);
+}
+
+/* alpha and its inverse as used by the predivide color space conversions */
+MALWAYS_INLINE void predivide_alpha_sse(const __m128 rgba, __m128 *r_alpha, __m128 *r_alpha_inv)
+{
+	const __m128 alpha = sse_alpha(rgba);
+	const __m128 keep = _mm_or_ps(_mm_cmpeq_ps(alpha, _mm_setzero_ps()), _mm_cmpeq_ps(alpha, _mm_set1_ps(1.0f)));
+
+	*r_alpha = _bli_math_blend_sse(keep, _mm_set1_ps(1.0f), alpha);
+	*r_alpha_inv = _mm_div_ps(_mm_set1_ps(1.0f), *r_alpha);
+}
+
+/* srgb_to_linearrgb_v4() and srgb_to_linearrgb_predivide_v4() */
+MALWAYS_INLINE __m128 srgb_to_linearrgb_sse(const __m128 srgb, const bool predivide)
+{
+	__m128 linear;
+
+	if (predivide) {
+		__m128 alpha, alpha_inv;
+		predivide_alpha_sse(srgb, &alpha, &alpha_inv);
+		linear = _mm_mul_ps(srgb_to_linearrgb_v4_simd(_mm_mul_ps(srgb, alpha_inv)), alpha);
+	}
+	else {
+		linear = srgb_to_linearrgb_v4_simd(srgb);
+	}
+
+	return sse_keep_alpha(linear, srgb);
+}
+
+/* linearrgb_to_srgb_v4() and linearrgb_to_srgb_predivide_v4() */
+MALWAYS_INLINE __m128 linearrgb_to_srgb_sse(const __m128 linear, const bool predivide)
+{
+	__m128 srgb;
+
+	if (predivide) {
+		__m128 alpha, alpha_inv;
+		predivide_alpha_sse(linear, &alpha, &alpha_inv);
+		srgb = _mm_mul_ps(linearrgb_to_srgb_v4_simd(_mm_mul_ps(linear, alpha_inv)), alpha);
+	}
+	else {
+		srgb = linearrgb_to_srgb_v4_simd(linear);
+	}
+
+	return sse_keep_alpha(srgb, linear);
+}
+
+/* unit_float_to_uchar_clamp() for four values, as 32 bit integers */
+MALWAYS_INLINE __m128i unit_float_to_uchar_clamp_sse(const __m128 value)
+{
+	const __m128i zero = _mm_castps_si128(_mm_cmple_ps(value, _mm_setzero_ps()));
+	const __m128i full = _mm_castps_si128(_mm_cmpgt_ps(value, _mm_set1_ps(1.0f - 0.5f / 255.0f)));
+	__m128i result = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+
+	result = _mm_or_si128(_mm_andnot_si128(full, result), _mm_and_si128(full, _mm_set1_epi32(255)));
+	return _mm_andnot_si128(zero, result);
+}
+
+/* rgba_float_to_uchar() for four pixels */
+MALWAYS_INLINE void rgba_float_to_uchar_sse(uchar to[16], const __m128 px[4])
+{
+	const __m128i px01 = _mm_packs_epi32(unit_float_to_uchar_clamp_sse(px[0]), unit_float_to_uchar_clamp_sse(px[1]));
+	const __m128i px23 = _mm_packs_epi32(unit_float_to_uchar_clamp_sse(px[2]), unit_float_to_uchar_clamp_sse(px[3]));
+
+	_mm_storeu_si128((__m128i *)to, _mm_packus_epi16(px01, px23));
+}
+
+/* rgba_uchar_to_float() for four pixels */
+MALWAYS_INLINE void rgba_uchar_to_float_sse(__m128 px[4], const uchar from[16])
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+	const __m128i bytes = _mm_loadu_si128((const __m128i *)from);
+	const __m128i px01 = _mm_unpacklo_epi8(bytes, zero);
+	const __m128i px23 = _mm_unpackhi_epi8(bytes, zero);
+
+	px[0] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(px01, zero)), scale);
+	px[1] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(px01, zero)), scale);
+	px[2] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(px23, zero)), scale);
+	px[3] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(px23, zero)), scale);
+}
+
+#endif  /* __SSE2__ */
+
 
 /************************* Generic Buffer Conversion *************************/
 
@@ -141,7 +305,7 @@ MINLINE unsigned char ftochar(float value)
 MINLINE void ushort_to_byte_dither_v4(uchar b[4], const unsigned short us[4], DitherContext *di, float s, float t)
 {
 #define USHORTTOFLOAT(val) ((float)val / 65535.0f)
-	float dither_value = dither_random_value(s, t) * 0.005f * di->dither;
+	float dither_value = dither_noise(s, t) * 0.005f * di->dither;
 
 	b[0] = ftochar(dither_value + USHORTTOFLOAT(us[0]));
 	b[1] = ftochar(dither_value + USHORTTOFLOAT(us[1]));
@@ -153,7 +317,7 @@ MINLINE void ushort_to_byte_dither_v4(uchar b[4], const unsigned short us[4], Di
 
 MINLINE void float_to_byte_dither_v4(uchar b[4], const float f[4], DitherContext *di, float s, float t)
 {
-	float dither_value = dither_random_value(s, t) * 0.005f * di->dither;
+	float dither_value = dither_noise(s, t) * 0.005f * di->dither;
 
 	b[0] = ftochar(dither_value + f[0]);
 	b[1] = ftochar(dither_value + f[1]);
@@ -161,25 +325,79 @@ MINLINE void float_to_byte_dither_v4(uchar b[4], const float f[4], DitherContext
 	b[3] = unit_float_to_uchar_clamp(f[3]);
 }
 
-/* float to byte pixels, output 4-channel RGBA */
-void IMB_buffer_byte_from_float(uchar *rect_to, const float *rect_from,
-                                int channels_from, float dither, int profile_to, int profile_from, bool predivide,
-                                int width, int height, int stride_to, int stride_from)
+/* 4-channel float to byte pixels of a row, optionally converting from sRGB to linear */
+static void float_to_byte_row(uchar *to, const float *from, int width, bool to_linear, bool predivide,
+                              DitherContext *di, float inv_width, float t)
+{
+	float tmp[4];
+	int x = 0;
+
+#ifdef __SSE2__
+	for (; x + 4 <= width; x += 4, from += 16, to += 16) {
+		__m128 px[4];
+		int i;
+
+		for (i = 0; i < 4; i++) {
+			px[i] = _mm_loadu_ps(from + i * 4);
+
+			if (to_linear)
+				px[i] = srgb_to_linearrgb_sse(px[i], predivide);
+			else if (predivide)
+				px[i] = premul_to_straight_sse(px[i]);
+		}
+
+		if (di) {
+			const __m128 s = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(x), _mm_set_epi32(3, 2, 1, 0))),
+			                            _mm_set1_ps(inv_width));
+			const __m128 noise = dither_noise_sse(s, _mm_set1_ps(t));
+			const __m128 dv = _mm_mul_ps(_mm_mul_ps(noise, _mm_set1_ps(0.005f)), _mm_set1_ps(di->dither));
+
+			/* alpha is not dithered */
+			px[0] = _mm_add_ps(px[0], _mm_andnot_ps(SSE_MASK_ALPHA, _mm_shuffle_ps(dv, dv, _MM_SHUFFLE(0, 0, 0, 0))));
+			px[1] = _mm_add_ps(px[1], _mm_andnot_ps(SSE_MASK_ALPHA, _mm_shuffle_ps(dv, dv, _MM_SHUFFLE(1, 1, 1, 1))));
+			px[2] = _mm_add_ps(px[2], _mm_andnot_ps(SSE_MASK_ALPHA, _mm_shuffle_ps(dv, dv, _MM_SHUFFLE(2, 2, 2, 2))));
+			px[3] = _mm_add_ps(px[3], _mm_andnot_ps(SSE_MASK_ALPHA, _mm_shuffle_ps(dv, dv, _MM_SHUFFLE(3, 3, 3, 3))));
+		}
+
+		rgba_float_to_uchar_sse(to, px);
+	}
+#endif
+
+	for (; x < width; x++, from += 4, to += 4) {
+		const float *px = from;
+
+		if (to_linear) {
+			if (predivide)
+				srgb_to_linearrgb_predivide_v4(tmp, from);
+			else
+				srgb_to_linearrgb_v4(tmp, from);
+			px = tmp;
+		}
+		else if (predivide) {
+			premul_to_straight_v4_v4(tmp, from);
+			px = tmp;
+		}
+
+		if (di)
+			float_to_byte_dither_v4(to, px, di, (float) x * inv_width, t);
+		else
+			rgba_float_to_uchar(to, px);
+	}
+}
+
+/* rows start_y to start_y + num_rows of IMB_buffer_byte_from_float(), height is the height
+ * of the whole buffer so the dither noise does not depend on how the rows are split */
+static void buffer_byte_from_float_rows(uchar *rect_to, const float *rect_from,
+                                        int channels_from, DitherContext *di, int profile_to, int profile_from,
+                                        bool predivide, int width, int height, int stride_to, int stride_from,
+                                        int start_y, int num_rows)
 {
 	float tmp[4];
 	int x, y;
-	DitherContext *di = NULL;
 	float inv_width = 1.0f / width;
 	float inv_height = 1.0f / height;
 
-	/* we need valid profiles */
-	BLI_assert(profile_to != IB_PROFILE_NONE);
-	BLI_assert(profile_from != IB_PROFILE_NONE);
-
-	if (dither)
-		di = create_dither_context(dither);
-
-	for (y = 0; y < height; y++) {
+	for (y = start_y; y < start_y + num_rows; y++) {
 		float t = y * inv_height;
 
 		if (channels_from == 1) {
@@ -224,44 +442,23 @@ void IMB_buffer_byte_from_float(uchar *rect_to, const float *rect_from,
 			const float *from = rect_from + ((size_t)stride_from) * y * 4;
 			uchar *to = rect_to + ((size_t)stride_to) * y * 4;
 
-			if (profile_to == profile_from) {
-				float straight[4];
-
-				/* no color space conversion */
-				if (dither && predivide) {
-					for (x = 0; x < width; x++, from += 4, to += 4) {
-						premul_to_straight_v4_v4(straight, from);
-						float_to_byte_dither_v4(to, straight, di, (float) x * inv_width, t);
-					}
-				}
-				else if (dither) {
-					for (x = 0; x < width; x++, from += 4, to += 4)
-						float_to_byte_dither_v4(to, from, di, (float) x * inv_width, t);
-				}
-				else if (predivide) {
-					for (x = 0; x < width; x++, from += 4, to += 4) {
-						premul_to_straight_v4_v4(straight, from);
-						rgba_float_to_uchar(to, straight);
-					}
-				}
-				else {
-					for (x = 0; x < width; x++, from += 4, to += 4)
-						rgba_float_to_uchar(to, from);
-				}
+			if (profile_to == profile_from || profile_to == IB_PROFILE_LINEAR_RGB) {
+				/* no color space conversion, or convert from sRGB to linear */
+				float_to_byte_row(to, from, width, profile_to != profile_from, predivide, di, inv_width, t);
 			}
 			else if (profile_to == IB_PROFILE_SRGB) {
 				/* convert from linear to sRGB */
 				unsigned short us[4];
 				float straight[4];
 
-				if (dither && predivide) {
+				if (di && predivide) {
 					for (x = 0; x < width; x++, from += 4, to += 4) {
 						premul_to_straight_v4_v4(straight, from);
 						linearrgb_to_srgb_ushort4(us, from);
 						ushort_to_byte_dither_v4(to, us, di, (float) x * inv_width, t);
 					}
 				}
-				else if (dither) {
+				else if (di) {
 					for (x = 0; x < width; x++, from += 4, to += 4) {
 						linearrgb_to_srgb_ushort4(us, from);
 						ushort_to_byte_dither_v4(to, us, di, (float) x * inv_width, t);
@@ -281,40 +478,115 @@ void IMB_buffer_byte_from_float(uchar *rect_to, const float *rect_from,
 					}
 				}
 			}
-			else if (profile_to == IB_PROFILE_LINEAR_RGB) {
-				/* convert from sRGB to linear */
-				if (dither && predivide) {
-					for (x = 0; x < width; x++, from += 4, to += 4) {
-						srgb_to_linearrgb_predivide_v4(tmp, from);
-						float_to_byte_dither_v4(to, tmp, di, (float) x * inv_width, t);
-					}
-				}
-				else if (dither) {
-					for (x = 0; x < width; x++, from += 4, to += 4) {
-						srgb_to_linearrgb_v4(tmp, from);
-						float_to_byte_dither_v4(to, tmp, di, (float) x * inv_width, t);
-					}
-				}
-				else if (predivide) {
-					for (x = 0; x < width; x++, from += 4, to += 4) {
-						srgb_to_linearrgb_predivide_v4(tmp, from);
-						rgba_float_to_uchar(to, tmp);
-					}
-				}
-				else {
-					for (x = 0; x < width; x++, from += 4, to += 4) {
-						srgb_to_linearrgb_v4(tmp, from);
-						rgba_float_to_uchar(to, tmp);
-					}
-				}
-			}
 		}
 	}
+}
+
+/* float to byte pixels, output 4-channel RGBA */
+void IMB_buffer_byte_from_float(uchar *rect_to, const float *rect_from,
+                                int channels_from, float dither, int profile_to, int profile_from, bool predivide,
+                                int width, int height, int stride_to, int stride_from)
+{
+	DitherContext *di = NULL;
+
+	/* we need valid profiles */
+	BLI_assert(profile_to != IB_PROFILE_NONE);
+	BLI_assert(profile_from != IB_PROFILE_NONE);
+
+	if (dither)
+		di = create_dither_context(dither);
+
+	buffer_byte_from_float_rows(rect_to, rect_from, channels_from, di, profile_to, profile_from, predivide,
+	                            width, height, stride_to, stride_from, 0, height);
 
 	if (dither)
 		clear_dither_context(di);
 }
 
+typedef struct ByteFromFloatThreadData {
+	uchar *rect_to;
+	const float *rect_from;
+	int channels_from;
+	DitherContext *di;
+	int profile_to;
+	int profile_from;
+	bool predivide;
+	int width;
+	int height;
+	int stride_to;
+	int stride_from;
+} ByteFromFloatThreadData;
+
+static void imb_buffer_byte_from_float_thread_do(void *data_v,
+                                                 int start_scanline,
+                                                 int num_scanlines)
+{
+	ByteFromFloatThreadData *data = (ByteFromFloatThreadData *)data_v;
+	buffer_byte_from_float_rows(data->rect_to,
+	                            data->rect_from,
+	                            data->channels_from,
+	                            data->di,
+	                            data->profile_to,
+	                            data->profile_from,
+	                            data->predivide,
+	                            data->width,
+	                            data->height,
+	                            data->stride_to,
+	                            data->stride_from,
+	                            start_scanline,
+	                            num_scanlines);
+}
+
+void IMB_buffer_byte_from_float_threaded(uchar *rect_to,
+                                         const float *rect_from,
+                                         int channels_from,
+                                         float dither,
+                                         int profile_to,
+                                         int profile_from,
+                                         bool predivide,
+                                         int width,
+                                         int height,
+                                         int stride_to,
+                                         int stride_from)
+{
+	if (((size_t)width) * height < 64 * 64) {
+		IMB_buffer_byte_from_float(rect_to,
+		                           rect_from,
+		                           channels_from,
+		                           dither,
+		                           profile_to,
+		                           profile_from,
+		                           predivide,
+		                           width,
+		                           height,
+		                           stride_to,
+		                           stride_from);
+	}
+	else {
+		ByteFromFloatThreadData data;
+
+		/* we need valid profiles */
+		BLI_assert(profile_to != IB_PROFILE_NONE);
+		BLI_assert(profile_from != IB_PROFILE_NONE);
+
+		data.rect_to = rect_to;
+		data.rect_from = rect_from;
+		data.channels_from = channels_from;
+		data.di = (dither) ? create_dither_context(dither) : NULL;
+		data.profile_to = profile_to;
+		data.profile_from = profile_from;
+		data.predivide = predivide;
+		data.width = width;
+		data.height = height;
+		data.stride_to = stride_to;
+		data.stride_from = stride_from;
+		IMB_processor_apply_threaded_scanlines(
+		    height, imb_buffer_byte_from_float_thread_do, &data);
+
+		if (data.di)
+			clear_dither_context(data.di);
+	}
+}
 
 /* float to byte pixels, output 4-channel RGBA */
 void IMB_buffer_byte_from_float_mask(uchar *rect_to, const float *rect_from,
@@ -393,12 +665,47 @@ void IMB_buffer_byte_from_float_mask(uchar *rect_to, const float *rect_from,
 		clear_dither_context(di);
 }
 
+/* 4-channel byte to float pixels of a row, optionally converting from linear to sRGB */
+static void byte_to_float_row(float *to, const uchar *from, int width, bool to_srgb, bool predivide)
+{
+	float tmp[4];
+	int x = 0;
+
+#ifdef __SSE2__
+	for (; x + 4 <= width; x += 4, from += 16, to += 16) {
+		__m128 px[4];
+		int i;
+
+		rgba_uchar_to_float_sse(px, from);
+
+		for (i = 0; i < 4; i++) {
+			if (to_srgb)
+				px[i] = linearrgb_to_srgb_sse(px[i], predivide);
+
+			_mm_storeu_ps(to + i * 4, px[i]);
+		}
+	}
+#endif
+
+	for (; x < width; x++, from += 4, to += 4) {
+		if (to_srgb) {
+			rgba_uchar_to_float(tmp, from);
+			if (predivide)
+				linearrgb_to_srgb_predivide_v4(to, tmp);
+			else
+				linearrgb_to_srgb_v4(to, tmp);
+		}
+		else {
+			rgba_uchar_to_float(to, from);
+		}
+	}
+}
+
 /* byte to float pixels, input and output 4-channel RGBA  */
 void IMB_buffer_float_from_byte(float *rect_to, const uchar *rect_from,
                                 int profile_to, int profile_from, bool predivide,
                                 int width, int height, int stride_to, int stride_from)
 {
-	float tmp[4];
 	int x, y;
 
 	/* we need valid profiles */
@@ -407,13 +714,12 @@ void IMB_buffer_float_from_byte(float *rect_to, const uchar *rect_from,
 
 	/* RGBA input */
 	for (y = 0; y < height; y++) {
-		const uchar *from = rect_from + stride_from * y * 4;
+		const uchar *from = rect_from + ((size_t)stride_from) * y * 4;
 		float *to = rect_to + ((size_t)stride_to) * y * 4;
 
-		if (profile_to == profile_from) {
-			/* no color space conversion */
-			for (x = 0; x < width; x++, from += 4, to += 4)
-				rgba_uchar_to_float(to, from);
+		if (profile_to == profile_from || profile_to == IB_PROFILE_SRGB) {
+			/* no color space conversion, or convert linear to sRGB */
+			byte_to_float_row(to, from, width, profile_to != profile_from, predivide);
 		}
 		else if (profile_to == IB_PROFILE_LINEAR_RGB) {
 			/* convert sRGB to linear */
@@ -428,21 +734,71 @@ void IMB_buffer_float_from_byte(float *rect_to, const uchar *rect_from,
 				}
 			}
 		}
-		else if (profile_to == IB_PROFILE_SRGB) {
-			/* convert linear to sRGB */
-			if (predivide) {
-				for (x = 0; x < width; x++, from += 4, to += 4) {
-					rgba_uchar_to_float(tmp, from);
-					linearrgb_to_srgb_predivide_v4(to, tmp);
-				}
-			}
-			else {
-				for (x = 0; x < width; x++, from += 4, to += 4) {
-					rgba_uchar_to_float(tmp, from);
-					linearrgb_to_srgb_v4(to, tmp);
-				}
-			}
-		}
+	}
+}
+
+typedef struct FloatFromByteThreadData {
+	float *rect_to;
+	const uchar *rect_from;
+	int profile_to;
+	int profile_from;
+	bool predivide;
+	int width;
+	int stride_to;
+	int stride_from;
+} FloatFromByteThreadData;
+
+static void imb_buffer_float_from_byte_thread_do(void *data_v,
+                                                 int start_scanline,
+                                                 int num_scanlines)
+{
+	FloatFromByteThreadData *data = (FloatFromByteThreadData *)data_v;
+	size_t offset_from = ((size_t)start_scanline) * data->stride_from * 4;
+	size_t offset_to = ((size_t)start_scanline) * data->stride_to * 4;
+	IMB_buffer_float_from_byte(data->rect_to + offset_to,
+	                           data->rect_from + offset_from,
+	                           data->profile_to,
+	                           data->profile_from,
+	                           data->predivide,
+	                           data->width,
+	                           num_scanlines,
+	                           data->stride_to,
+	                           data->stride_from);
+}
+
+void IMB_buffer_float_from_byte_threaded(float *rect_to,
+                                         const uchar *rect_from,
+                                         int profile_to,
+                                         int profile_from,
+                                         bool predivide,
+                                         int width,
+                                         int height,
+                                         int stride_to,
+                                         int stride_from)
+{
+	if (((size_t)width) * height < 64 * 64) {
+		IMB_buffer_float_from_byte(rect_to,
+		                           rect_from,
+		                           profile_to,
+		                           profile_from,
+		                           predivide,
+		                           width,
+		                           height,
+		                           stride_to,
+		                           stride_from);
+	}
+	else {
+		FloatFromByteThreadData data;
+		data.rect_to = rect_to;
+		data.rect_from = rect_from;
+		data.profile_to = profile_to;
+		data.profile_from = profile_from;
+		data.predivide = predivide;
+		data.width = width;
+		data.stride_to = stride_to;
+		data.stride_from = stride_from;
+		IMB_processor_apply_threaded_scanlines(
+		    height, imb_buffer_float_from_byte_thread_do, &data);
 	}
 }
 
@@ -708,7 +1064,8 @@ void IMB_buffer_byte_from_byte(uchar *rect_to, const uchar *rect_from,
 
 void IMB_rect_from_float(ImBuf *ibuf)
 {
-	float *buffer;
+	const float *buffer;
+	float *buffer_transform = NULL;
 	const char *from_colorspace;
 
 	/* verify we have a float buffer */
@@ -726,19 +1083,23 @@ void IMB_rect_from_float(ImBuf *ibuf)
 	else
 		from_colorspace = ibuf->float_colorspace->name;
 
-	buffer = MEM_dupallocN(ibuf->rect_float);
-
-	/* first make float buffer in byte space */
-	IMB_colormanagement_transform(buffer, ibuf->x, ibuf->y, ibuf->channels, from_colorspace, ibuf->rect_colorspace->name, true);
-
-	/* convert from float's premul alpha to byte's straight alpha */
-	IMB_unpremultiply_rect_float(buffer, ibuf->channels, ibuf->x, ibuf->y);
+	/* first make float buffer in byte space, a copy is only needed when the color spaces differ */
+	if (STREQ(from_colorspace, ibuf->rect_colorspace->name)) {
+		buffer = ibuf->rect_float;
+	}
+	else {
+		buffer_transform = MEM_dupallocN(ibuf->rect_float);
+		IMB_colormanagement_transform_threaded(buffer_transform, ibuf->x, ibuf->y, ibuf->channels,
+		                                       from_colorspace, ibuf->rect_colorspace->name, true);
+		buffer = buffer_transform;
+	}
 
-	/* convert float to byte */
-	IMB_buffer_byte_from_float((unsigned char *) ibuf->rect, buffer, ibuf->channels, ibuf->dither, IB_PROFILE_SRGB, IB_PROFILE_SRGB,
-	                           false, ibuf->x, ibuf->y, ibuf->x, ibuf->x);
+	/* convert float to byte, predivide converts from float's premul alpha to byte's straight alpha */
+	IMB_buffer_byte_from_float_threaded((unsigned char *) ibuf->rect, buffer, ibuf->channels, ibuf->dither,
+	                                    IB_PROFILE_SRGB, IB_PROFILE_SRGB, true, ibuf->x, ibuf->y, ibuf->x, ibuf->x);
 
-	MEM_freeN(buffer);
+	if (buffer_transform)
+		MEM_freeN(buffer_transform);
 
 	/* ensure user flag is reset */
 	ibuf->userflags &= ~IB_RECT_INVALID;
@@ -841,6 +1202,34 @@ void IMB_partial_rect_from_float(ImBuf *ibuf, float *buffer, int x, int y, int w
 	ibuf->userflags &= ~IB_RECT_INVALID;
 }
 
+typedef struct PremultiplyThreadData {
+	float *buffer;
+	int width;
+} PremultiplyThreadData;
+
+static void buffer_float_premultiply_thread_do(void *data_v,
+                                               int start_scanline,
+                                               int num_scanlines)
+{
+	PremultiplyThreadData *data = (PremultiplyThreadData *)data_v;
+	IMB_buffer_float_premultiply(data->buffer + ((size_t)start_scanline) * data->width * 4,
+	                             data->width, num_scanlines);
+}
+
+static void buffer_float_premultiply_threaded(float *buffer, int width, int height)
+{
+	if (((size_t)width) * height < 64 * 64) {
+		IMB_buffer_float_premultiply(buffer, width, height);
+	}
+	else {
+		PremultiplyThreadData data;
+		data.buffer = buffer;
+		data.width = width;
+		IMB_processor_apply_threaded_scanlines(
+		        height, buffer_float_premultiply_thread_do, &data);
+	}
+}
+
 void IMB_float_from_rect(ImBuf *ibuf)
 {
 	float *rect_float;
@@ -868,15 +1257,16 @@ void IMB_float_from_rect(ImBuf *ibuf)
 	}
 
 	/* first, create float buffer in non-linear space */
-	IMB_buffer_float_from_byte(rect_float, (unsigned char *) ibuf->rect, IB_PROFILE_SRGB, IB_PROFILE_SRGB,
-	                           false, ibuf->x, ibuf->y, ibuf->x, ibuf->x);
+	IMB_buffer_float_from_byte_threaded(rect_float, (unsigned char *) ibuf->rect, IB_PROFILE_SRGB, IB_PROFILE_SRGB,
+	                                    false, ibuf->x, ibuf->y, ibuf->x, ibuf->x);
 
 	/* then make float be in linear space */
 	IMB_colormanagement_colorspace_to_scene_linear(rect_float, ibuf->x, ibuf->y, ibuf->channels,
 	                                               ibuf->rect_colorspace, false);
 
 	/* byte buffer is straight alpha, float should always be premul */
-	IMB_premultiply_rect_float(rect_float, ibuf->channels, ibuf->x, ibuf->y);
+	if (ibuf->channels == 4)
+		buffer_float_premultiply_threaded(rect_float, ibuf->x, ibuf->y);
 
 	if (ibuf->rect_float == NULL) {
 		ibuf->rect_float = rect_float;
@@ -917,6 +1307,14 @@ void IMB_buffer_float_unpremultiply(float *buf, int width, int height)
 {
 	size_t total = ((size_t)width) * height;
 	float *fp = buf;
+#ifdef __SSE2__
+	for (; total >= 4; total -= 4, fp += 16) {
+		_mm_storeu_ps(fp, premul_to_straight_sse(_mm_loadu_ps(fp)));
+		_mm_storeu_ps(fp + 4, premul_to_straight_sse(_mm_loadu_ps(fp + 4)));
+		_mm_storeu_ps(fp + 8, premul_to_straight_sse(_mm_loadu_ps(fp + 8)));
+		_mm_storeu_ps(fp + 12, premul_to_straight_sse(_mm_loadu_ps(fp + 12)));
+	}
+#endif
 	while (total--) {
 		premul_to_straight_v4(fp);
 		fp += 4;
@@ -927,6 +1325,14 @@ void IMB_buffer_float_premultiply(float *buf, int width, int height)
 {
 	size_t total = ((size_t)width) * height;
 	float *fp = buf;
+#ifdef __SSE2__
+	for (; total >= 4; total -= 4, fp += 16) {
+		_mm_storeu_ps(fp, straight_to_premul_sse(_mm_loadu_ps(fp)));
+		_mm_storeu_ps(fp + 4, straight_to_premul_sse(_mm_loadu_ps(fp + 4)));
+		_mm_storeu_ps(fp + 8, straight_to_premul_sse(_mm_loadu_ps(fp + 8)));
+		_mm_storeu_ps(fp + 12, straight_to_premul_sse(_mm_loadu_ps(fp + 12)));
+	}
+#endif
 	while (total--) {
 		straight_to_premul_v4(fp);
 		fp += 4;
@@ -613,21 +613,9 @@ void IMB_premultiply_rect(unsigned int *rect, char planes, int w, int h)
 
 void IMB_premultiply_rect_float(float *rect_float, int channels, int w, int h)
 {
-	float val, *cp;
-	int x, y;
-
 	if (channels == 4) {
-		cp = rect_float;
-		for (y = 0; y < h; y++) {
-			for (x = 0; x < w; x++, cp += 4) {
-				val = cp[3];
-				cp[0] = cp[0] * val;
-				cp[1] = cp[1] * val;
-				cp[2] = cp[2] * val;
-			}
-		}
+		IMB_buffer_float_premultiply(rect_float, w, h);
 	}
-
 }
 
 void IMB_premultiply_alpha(ImBuf *ibuf)
@@ -671,21 +659,9 @@ void IMB_unpremultiply_rect(unsigned int *rect, char planes, int w, int h)
 
 void IMB_unpremultiply_rect_float(float *rect_float, int channels, int w, int h)
 {
-	float val, *fp;
-	int x, y;
-
 	if (channels == 4) {
-		fp = rect_float;
-		for (y = 0; y < h; y++) {
-			for (x = 0; x < w; x++, fp += 4) {
-				val = fp[3] != 0.0f ? 1.0f / fp[3] : 1.0f;
-				fp[0] = fp[0] * val;
-				fp[1] = fp[1] * val;
-				fp[2] = fp[2] * val;
-			}
-		}
+		IMB_buffer_float_unpremultiply(rect_float, w, h);
 	}
-
 }
 
 void IMB_unpremultiply_alpha(ImBuf *ibuf)
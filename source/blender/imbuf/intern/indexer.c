@@ -30,12 +30,18 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "BLI_utildefines.h"
 #include "BLI_endian_switch.h"
+#include "BLI_math_base.h"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
 #include "BLI_fileops.h"
 #include "BLI_ghash.h"
+#include "BLI_threads.h"
+
+#include "PIL_time.h"
 
 #include "IMB_indexer.h"
 #include "IMB_anim.h"
@@ -282,6 +288,40 @@ int IMB_indexer_get_frame_index(struct anim_index *idx, int frameno)
 	}
 }
 
+int IMB_indexer_get_frame_index_for_pts(struct anim_index *idx,
+                                        long long pts)
+{
+	int len = idx->num_entries;
+	int half;
+	int middle;
+	int first = 0;
+
+	if (pts < 0) {
+		return 0;
+	}
+
+	/* bsearch (upper bound) the first entry past pts, the frame showing
+	 * pts is the one right before it */
+
+	while (len > 0) {
+		half = len >> 1;
+		middle = first;
+
+		middle += half;
+
+		if (idx->entries[middle].pts <= (unsigned long long)pts) {
+			first = middle;
+			first++;
+			len = len - half - 1;
+		}
+		else {
+			len = half;
+		}
+	}
+
+	return (first > 0) ? first - 1 : 0;
+}
+
 unsigned long long IMB_indexer_get_pts(struct anim_index *idx,
                                        int frame_index)
 {
@@ -439,6 +479,7 @@ static void get_tc_filename(struct anim *anim, IMB_Timecode_Type tc,
 
 typedef struct IndexBuildContext {
 	int anim_type;
+	int num_threads;
 } IndexBuildContext;
 
 
@@ -455,6 +496,7 @@ struct proxy_output_ctx {
 	AVCodec *codec;
 	struct SwsContext *sws_ctx;
 	AVFrame *frame;
+	ThreadQueue *queue;
 	int cfra;
 	int proxy_size;
 	int orig_height;
@@ -694,8 +736,70 @@ static void free_proxy_output_ffmpeg(struct proxy_output_ctx *ctx,
 	MEM_freeN(ctx);
 }
 
+/* Decoded frames are copied once and shared by the proxy outputs, which each
+ * scale and encode on their own thread. */
+typedef struct ProxyFrame {
+	AVFrame *frame;
+	unsigned int users;
+} ProxyFrame;
+
+/* frames waiting for one proxy output, bounds the memory used when decoding is
+ * faster than encoding */
+#define PROXY_QUEUE_MAX_FRAMES 8
+
+/* keyframes remembered for the timecode index, more than the frames a threaded
+ * decoder can have in flight */
+#define INDEX_KEYFRAME_HISTORY 64
+
+typedef struct IndexKeyframe {
+	unsigned long long pos;
+	unsigned long long dts;
+	unsigned long long pts;
+} IndexKeyframe;
+
+static ProxyFrame *proxy_frame_copy(AVFrame *frame, int width, int height, enum AVPixelFormat pix_fmt)
+{
+	ProxyFrame *proxy_frame = MEM_callocN(sizeof(ProxyFrame), "proxy frame");
+
+	proxy_frame->frame = av_frame_alloc();
+	avpicture_fill((AVPicture *) proxy_frame->frame,
+	               MEM_mallocN(avpicture_get_size(pix_fmt, width, height), "proxy frame data"),
+	               pix_fmt, width, height);
+	av_picture_copy((AVPicture *) proxy_frame->frame, (const AVPicture *) frame, pix_fmt, width, height);
+
+	proxy_frame->frame->width = width;
+	proxy_frame->frame->height = height;
+	proxy_frame->frame->format = pix_fmt;
+
+	return proxy_frame;
+}
+
+static void proxy_frame_release(ProxyFrame *proxy_frame)
+{
+	if (atomic_sub_and_fetch_u(&proxy_frame->users, 1) == 0) {
+		MEM_freeN(proxy_frame->frame->data[0]);
+		av_frame_free(&proxy_frame->frame);
+		MEM_freeN(proxy_frame);
+	}
+}
+
+static void *proxy_output_thread(void *ctx_v)
+{
+	struct proxy_output_ctx *ctx = ctx_v;
+	ProxyFrame *proxy_frame;
+
+	/* returns NULL once the queue is empty and set to nowait */
+	while ((proxy_frame = BLI_thread_queue_pop(ctx->queue))) {
+		add_to_proxy_output_ffmpeg(ctx, proxy_frame->frame);
+		proxy_frame_release(proxy_frame);
+	}
+
+	return NULL;
+}
+
 typedef struct FFmpegIndexBuilderContext {
 	int anim_type;
+	int num_threads;
 
 	AVFormatContext *iFormatCtx;
 	AVCodecContext *iCodecCtx;
@@ -712,11 +816,9 @@ typedef struct FFmpegIndexBuilderContext {
 	IMB_Timecode_Type tcs_in_use;
 	IMB_Proxy_Size proxy_sizes_in_use;
 
-	unsigned long long seek_pos;
-	unsigned long long last_seek_pos;
-	unsigned long long seek_pos_dts;
-	unsigned long long seek_pos_pts;
-	unsigned long long last_seek_pos_dts;
+	IndexKeyframe keyframes[INDEX_KEYFRAME_HISTORY];
+	int num_keyframes;
+
 	unsigned long long start_pts;
 	double frame_rate;
 	double pts_time_base;
@@ -784,11 +886,7 @@ static IndexBuildContext *index_ffmpeg_create_context(struct anim *anim, IMB_Tim
 
 	context->iCodecCtx->workaround_bugs = 1;
 
-	if (avcodec_open2(context->iCodecCtx, context->iCodec, NULL) < 0) {
-		avformat_close_input(&context->iFormatCtx);
-		MEM_freeN(context);
-		return NULL;
-	}
+	/* the decoder is opened in index_rebuild_ffmpeg, once the number of threads is known */
 
 	for (i = 0; i < num_proxy_sizes; i++) {
 		if (proxy_sizes_in_use & proxy_sizes[i]) {
@@ -848,12 +946,35 @@ static void index_rebuild_ffmpeg_proc_decoded_frame(
         AVFrame *in_frame)
 {
 	int i;
-	unsigned long long s_pos = context->seek_pos;
-	unsigned long long s_dts = context->seek_pos_dts;
+	unsigned long long s_pos = 0;
+	unsigned long long s_dts = 0;
 	unsigned long long pts = av_get_pts_from_frame(context->iFormatCtx, in_frame);
+	ProxyFrame *proxy_frame = NULL;
 
 	for (i = 0; i < context->num_proxy_sizes; i++) {
-		add_to_proxy_output_ffmpeg(context->proxy_ctx[i], in_frame);
+		struct proxy_output_ctx *ctx = context->proxy_ctx[i];
+
+		if (ctx == NULL) {
+			continue;
+		}
+
+		if (proxy_frame == NULL) {
+			proxy_frame = proxy_frame_copy(in_frame, context->iCodecCtx->width, context->iCodecCtx->height,
+			                               context->iCodecCtx->pix_fmt);
+			/* held until all outputs got the frame */
+			proxy_frame->users = 1;
+		}
+
+		while (BLI_thread_queue_len(ctx->queue) >= PROXY_QUEUE_MAX_FRAMES) {
+			PIL_sleep_ms(1);
+		}
+
+		atomic_add_and_fetch_u(&proxy_frame->users, 1);
+		BLI_thread_queue_push(ctx->queue, proxy_frame);
+	}
+
+	if (proxy_frame) {
+		proxy_frame_release(proxy_frame);
 	}
 
 	if (!context->start_pts_set) {
@@ -870,11 +991,20 @@ static void index_rebuild_ffmpeg_proc_decoded_frame(
 	 * information is in place, when we seek
 	 * to the I-Frame presented *after* the P-Frame,
 	 * but located before the P-Frame within
-	 * the stream */
+	 * the stream.
+	 *
+	 * A threaded decoder outputs frames a few packets late, so look for the
+	 * last I-Frame presented before this frame in the recent history. */
+
+	for (i = context->num_keyframes - 1; i >= max_ii(context->num_keyframes - INDEX_KEYFRAME_HISTORY, 0); i--) {
+		const IndexKeyframe *keyframe = &context->keyframes[i % INDEX_KEYFRAME_HISTORY];
 
-	if (pts < context->seek_pos_pts) {
-		s_pos = context->last_seek_pos;
-		s_dts = context->last_seek_pos_dts;
+		s_pos = keyframe->pos;
+		s_dts = keyframe->dts;
+
+		if (keyframe->pts <= pts) {
+			break;
+		}
 	}
 
 	for (i = 0; i < context->num_indexers; i++) {
@@ -902,9 +1032,40 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
 	AVFrame *in_frame = 0;
 	AVPacket next_packet;
 	uint64_t stream_size;
+	ListBase threads;
+	const double start_time = PIL_check_seconds_timer();
+	int num_threads = (context->num_threads > 0) ? context->num_threads : BLI_system_thread_count();
+	int num_outputs = 0;
+	int i;
 
 	memset(&next_packet, 0, sizeof(AVPacket));
 
+	/* frame threading gives the most speedup, slices help codecs without it */
+	context->iCodecCtx->thread_count = num_threads;
+	context->iCodecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
+	if (avcodec_open2(context->iCodecCtx, context->iCodec, NULL) < 0) {
+		fprintf(stderr, "Couldn't open decoder for '%s', proxy not built!\n", context->iFormatCtx->filename);
+		return 0;
+	}
+
+	for (i = 0; i < context->num_proxy_sizes; i++) {
+		if (context->proxy_ctx[i]) {
+			num_outputs++;
+		}
+	}
+
+	if (num_outputs) {
+		BLI_threadpool_init(&threads, proxy_output_thread, num_outputs);
+
+		for (i = 0; i < context->num_proxy_sizes; i++) {
+			if (context->proxy_ctx[i]) {
+				context->proxy_ctx[i]->queue = BLI_thread_queue_init();
+				BLI_threadpool_insert(&threads, context->proxy_ctx[i]);
+			}
+		}
+	}
+
 	in_frame = av_frame_alloc();
 
 	stream_size = avio_size(context->iFormatCtx->pb);
@@ -929,11 +1090,11 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
 
 		if (next_packet.stream_index == context->videoStream) {
 			if (next_packet.flags & AV_PKT_FLAG_KEY) {
-				context->last_seek_pos = context->seek_pos;
-				context->last_seek_pos_dts = context->seek_pos_dts;
-				context->seek_pos = next_packet.pos;
-				context->seek_pos_dts = next_packet.dts;
-				context->seek_pos_pts = next_packet.pts;
+				IndexKeyframe *keyframe = &context->keyframes[context->num_keyframes++ % INDEX_KEYFRAME_HISTORY];
+
+				keyframe->pos = next_packet.pos;
+				keyframe->dts = next_packet.dts;
+				keyframe->pts = next_packet.pts;
 			}
 
 			avcodec_decode_video2(
@@ -975,6 +1136,32 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
 
 	av_free(in_frame);
 
+	/* wait for the outputs to encode the queued frames */
+	if (num_outputs) {
+		for (i = 0; i < context->num_proxy_sizes; i++) {
+			if (context->proxy_ctx[i]) {
+				BLI_thread_queue_nowait(context->proxy_ctx[i]->queue);
+			}
+		}
+
+		BLI_threadpool_end(&threads);
+
+		for (i = 0; i < context->num_proxy_sizes; i++) {
+			if (context->proxy_ctx[i]) {
+				BLI_thread_queue_free(context->proxy_ctx[i]->queue);
+				context->proxy_ctx[i]->queue = NULL;
+			}
+		}
+	}
+
+	if (!*stop) {
+		const double time = PIL_check_seconds_timer() - start_time;
+
+		fprintf(stderr, "Proxy: %d frames of '%s' in %.2f seconds (%.1f fps, %d decoding threads)\n",
+		        context->frameno_gapless, context->iFormatCtx->filename, time,
+		        (time > 0.0) ? context->frameno_gapless / time : 0.0, num_threads);
+	}
+
 	return 1;
 }
 
@@ -987,6 +1174,7 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
 #ifdef WITH_AVI
 typedef struct FallbackIndexBuilderContext {
 	int anim_type;
+	int num_threads;
 
 	struct anim *anim;
 	AviMovie *proxy_ctx[IMB_PROXY_MAX_SLOT];
@@ -1223,6 +1411,11 @@ IndexBuildContext *IMB_anim_index_rebuild_context(struct anim *anim, IMB_Timecod
 	UNUSED_VARS(tcs_in_use, proxy_sizes_in_use, quality);
 }
 
+void IMB_anim_index_rebuild_set_threads(struct IndexBuildContext *context, int num_threads)
+{
+	context->num_threads = num_threads;
+}
+
 void IMB_anim_index_rebuild(struct IndexBuildContext *context,
                             short *stop, short *do_update, float *progress)
 {
@@ -62,7 +62,7 @@ static void skip_input_data(j_decompress_ptr cinfo, long num_bytes);
 static void term_source(j_decompress_ptr cinfo);
 static void memory_source(j_decompress_ptr cinfo, const unsigned char *buffer, size_t size);
 static boolean handle_app1(j_decompress_ptr cinfo);
-static ImBuf *ibJpegImageFromCinfo(struct jpeg_decompress_struct *cinfo, int flags);
+static ImBuf *ibJpegImageFromCinfo(struct jpeg_decompress_struct *cinfo, int flags, ImPartialRead *partial);
 
 static const uchar jpeg_default_quality = 75;
 static uchar ibuf_quality;
@@ -271,7 +271,20 @@ static boolean handle_app1(j_decompress_ptr cinfo)
 }
 
 
-static ImBuf *ibJpegImageFromCinfo(struct jpeg_decompress_struct *cinfo, int flags)
+/* the largest of the 1/2, 1/4 and 1/8 downscaling of the IDCT which keeps the image at least min_size */
+static int jpeg_scale_denom(int width, int height, int min_size)
+{
+	const int size = MAX2(width, height);
+	int denom = 1;
+
+	while (denom < 8 && size / (denom * 2) >= min_size) {
+		denom *= 2;
+	}
+
+	return denom;
+}
+
+static ImBuf *ibJpegImageFromCinfo(struct jpeg_decompress_struct *cinfo, int flags, ImPartialRead *partial)
 {
 	JSAMPARRAY row_pointer;
 	JSAMPLE *buffer = NULL;
@@ -295,8 +308,27 @@ static ImBuf *ibJpegImageFromCinfo(struct jpeg_decompress_struct *cinfo, int fla
 
 		if (cinfo->jpeg_color_space == JCS_YCCK) cinfo->out_color_space = JCS_CMYK;
 
+		if (partial) {
+			partial->width = x;
+			partial->height = y;
+			partial->level_read = 0;
+
+			/* decode at reduced size directly, skipping most of the IDCT work */
+			if (partial->level_min_size) {
+				cinfo->scale_num = 1;
+				cinfo->scale_denom = jpeg_scale_denom(x, y, partial->level_min_size);
+
+				while ((1u << partial->level_read) < cinfo->scale_denom) {
+					partial->level_read++;
+				}
+			}
+		}
+
 		jpeg_start_decompress(cinfo);
 
+		x = cinfo->output_width;
+		y = cinfo->output_height;
+
 		if (flags & IB_test) {
 			jpeg_abort_decompress(cinfo);
 			ibuf = IMB_allocImBuf(x, y, 8 * depth, 0);
@@ -455,11 +487,47 @@ ImBuf *imb_load_jpeg(const unsigned char *buffer, size_t size, int flags, char c
 	jpeg_create_decompress(cinfo);
 	memory_source(cinfo, buffer, size);
 
-	ibuf = ibJpegImageFromCinfo(cinfo, flags);
+	ibuf = ibJpegImageFromCinfo(cinfo, flags, NULL);
 	
 	return(ibuf);
 }
 
+/* only the whole image is read, at the smallest IDCT scale of at least level_min_size */
+ImBuf *imb_load_jpeg_partial(const unsigned char *buffer, size_t size, int flags, ImPartialRead *partial,
+                             char colorspace[IM_MAX_SPACE])
+{
+	struct jpeg_decompress_struct _cinfo, *cinfo = &_cinfo;
+	struct my_error_mgr jerr;
+	ImBuf *ibuf;
+
+	if (!imb_is_a_jpeg(buffer)) return NULL;
+
+	/* regions and passes are not supported */
+	if ((partial->xmax > partial->xmin && partial->ymax > partial->ymin) || partial->passname) return NULL;
+
+	colorspace_set_default_role(colorspace, IM_MAX_SPACE, COLOR_ROLE_DEFAULT_BYTE);
+
+	cinfo->err = jpeg_std_error(&jerr.pub);
+	jerr.pub.error_exit = jpeg_error;
+
+	if (setjmp(jerr.setjmp_buffer)) {
+		jpeg_destroy_decompress(cinfo);
+		return NULL;
+	}
+
+	jpeg_create_decompress(cinfo);
+	memory_source(cinfo, buffer, size);
+
+	ibuf = ibJpegImageFromCinfo(cinfo, flags, partial);
+
+	if (ibuf) {
+		partial->bytes_read = size;
+		partial->bytes_skipped = 0;
+	}
+
+	return(ibuf);
+}
+
 
 static void write_jpeg(struct jpeg_compress_struct *cinfo, struct ImBuf *ibuf)
 {
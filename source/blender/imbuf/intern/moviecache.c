@@ -37,6 +37,8 @@
 #include "MEM_guardedalloc.h"
 #include "MEM_CacheLimiterC-Api.h"
 
+#include "atomic_ops.h"
+
 #include "BLI_string.h"
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
@@ -58,13 +60,35 @@
 #  define PRINT(format, ...)
 #endif
 
-static MEM_CacheLimiterC *limitor = NULL;
-static pthread_mutex_t limitor_lock = BLI_MUTEX_INITIALIZER;
+/* Every cache is a hash table split into shards, each protected by a read/write lock,
+ * so lookups only wait for insertions and removals in the same shard.
+ *
+ * All caches share one memory limit. Their items are kept in a CLOCK ring: a lookup
+ * only sets the referenced flag of the item, and when the limit is exceeded the clock
+ * hand clears the flags it passes and evicts the first unreferenced item. Inserting and
+ * removing items is serialized by the limiter lock, which is always taken before the
+ * lock of a shard. */
+
+#define MOVIECACHE_SHARD_BITS 4
+#define MOVIECACHE_SHARDS (1 << MOVIECACHE_SHARD_BITS)
+
+/* for caches with a priority callback the unreferenced item with the lowest priority
+ * out of this many is evicted */
+#define MOVIECACHE_CLOCK_SAMPLES 8
+
+typedef struct MovieCacheShard {
+	GHash *hash;
+	ThreadRWMutex lock;
+
+	struct BLI_mempool *keys_pool;
+	struct BLI_mempool *items_pool;
+	struct BLI_mempool *userkeys_pool;
+} MovieCacheShard;
 
 typedef struct MovieCache {
 	char name[64];
 
-	GHash *hash;
+	MovieCacheShard shards[MOVIECACHE_SHARDS];
 	GHashHashFP hashfp;
 	GHashCmpFP cmpfp;
 	MovieCacheGetKeyDataFP getdatafp;
@@ -73,16 +97,12 @@ typedef struct MovieCache {
 	MovieCacheGetItemPriorityFP getitempriorityfp;
 	MovieCachePriorityDeleterFP prioritydeleterfp;
 
-	struct BLI_mempool *keys_pool;
-	struct BLI_mempool *items_pool;
-	struct BLI_mempool *userkeys_pool;
-
 	int keysize;
 
 	void *last_userkey;
 
 	int totseg, *points, proxy, render_flags;  /* for visual statistics optimization */
-	int pad;
+	int iterators;  /* items are not evicted while iterating, protected by the limiter lock */
 } MovieCache;
 
 typedef struct MovieCacheKey {
@@ -92,11 +112,28 @@ typedef struct MovieCacheKey {
 
 typedef struct MovieCacheItem {
 	MovieCache *cache_owner;
+	MovieCacheShard *shard;
+	MovieCacheKey *key;
 	ImBuf *ibuf;
-	MEM_CacheLimiterHandleC *c_handle;
 	void *priority_data;
+	size_t size;
+	unsigned int clock_index;
+	uint8_t referenced;
 } MovieCacheItem;
 
+typedef struct MovieCacheIter {
+	MovieCache *cache;
+	int shard;
+	GHashIterator gh_iter;
+} MovieCacheIter;
+
+static ThreadMutex limiter_lock = BLI_MUTEX_INITIALIZER;
+static MovieCacheItem **clock_items = NULL;
+static unsigned int clock_len = 0;
+static unsigned int clock_size = 0;
+static unsigned int clock_hand = 0;
+static size_t memory_in_use = 0;
+
 static unsigned int moviecache_hashhash(const void *keyv)
 {
 	const MovieCacheKey *key = keyv;
@@ -112,56 +149,12 @@ static bool moviecache_hashcmp(const void *av, const void *bv)
 	return a->cache_owner->cmpfp(a->userkey, b->userkey);
 }
 
-static void moviecache_keyfree(void *val)
+static MovieCacheShard *moviecache_shard(MovieCache *cache, const void *userkey)
 {
-	MovieCacheKey *key = val;
-
-	BLI_mempool_free(key->cache_owner->userkeys_pool, key->userkey);
+	/* the high bits of a multiplicative hash, user hashes often differ in the low bits only */
+	const unsigned int hash = cache->hashfp(userkey) * 2654435761u;
 
-	BLI_mempool_free(key->cache_owner->keys_pool, key);
-}
-
-static void moviecache_valfree(void *val)
-{
-	MovieCacheItem *item = (MovieCacheItem *)val;
-	MovieCache *cache = item->cache_owner;
-
-	PRINT("%s: cache '%s' free item %p buffer %p\n", __func__, cache->name, item, item->ibuf);
-
-	if (item->ibuf) {
-		MEM_CacheLimiter_unmanage(item->c_handle);
-		IMB_freeImBuf(item->ibuf);
-	}
-
-	if (item->priority_data && cache->prioritydeleterfp) {
-		cache->prioritydeleterfp(item->priority_data);
-	}
-
-	BLI_mempool_free(item->cache_owner->items_pool, item);
-}
-
-static void check_unused_keys(MovieCache *cache)
-{
-	GHashIterator gh_iter;
-
-	BLI_ghashIterator_init(&gh_iter, cache->hash);
-
-	while (!BLI_ghashIterator_done(&gh_iter)) {
-		const MovieCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
-		const MovieCacheItem *item = BLI_ghashIterator_getValue(&gh_iter);
-		bool remove;
-
-		BLI_ghashIterator_step(&gh_iter);
-
-		remove = !item->ibuf;
-
-		if (remove) {
-			PRINT("%s: cache '%s' remove item %p without buffer\n", __func__, cache->name, item);
-		}
-
-		if (remove)
-			BLI_ghash_remove(cache->hash, key, moviecache_keyfree, moviecache_valfree);
-	}
+	return &cache->shards[hash >> (32 - MOVIECACHE_SHARD_BITS)];
 }
 
 static int compare_int(const void *av, const void *bv)
@@ -171,28 +164,6 @@ static int compare_int(const void *av, const void *bv)
 	return *a - *b;
 }
 
-static void IMB_moviecache_destructor(void *p)
-{
-	MovieCacheItem *item = (MovieCacheItem *)p;
-
-	if (item && item->ibuf) {
-		MovieCache *cache = item->cache_owner;
-
-		PRINT("%s: cache '%s' destroy item %p buffer %p\n", __func__, cache->name, item, item->ibuf);
-
-		IMB_freeImBuf(item->ibuf);
-
-		item->ibuf = NULL;
-		item->c_handle = NULL;
-
-		/* force cached segments to be updated */
-		if (cache->points) {
-			MEM_freeN(cache->points);
-			cache->points = NULL;
-		}
-	}
-}
-
 /* approximate size of ImBuf in memory */
 static size_t IMB_get_size_in_memory(ImBuf *ibuf)
 {
@@ -235,39 +206,71 @@ static size_t IMB_get_size_in_memory(ImBuf *ibuf)
 	return size;
 }
 
-static size_t get_item_size(void *p)
+static void clock_insert(MovieCacheItem *item)
 {
-	size_t size = sizeof(MovieCacheItem);
-	MovieCacheItem *item = (MovieCacheItem *) p;
+	if (clock_len == clock_size) {
+		clock_size = clock_size ? clock_size * 2 : 256;
+		clock_items = MEM_reallocN(clock_items, sizeof(*clock_items) * clock_size);
+	}
 
-	if (item->ibuf)
-		size += IMB_get_size_in_memory(item->ibuf);
+	item->clock_index = clock_len;
+	clock_items[clock_len++] = item;
+	memory_in_use += item->size;
+}
 
-	return size;
+static void clock_remove(MovieCacheItem *item)
+{
+	const unsigned int index = item->clock_index;
+
+	clock_items[index] = clock_items[--clock_len];
+	clock_items[index]->clock_index = index;
+	memory_in_use -= item->size;
 }
 
-static int get_item_priority(void *item_v, int default_priority)
+/* free an item which is not in the hash of its shard anymore,
+ * the limiter lock and the shard lock must be held */
+static void moviecache_item_free(MovieCacheItem *item)
 {
-	MovieCacheItem *item = (MovieCacheItem *) item_v;
 	MovieCache *cache = item->cache_owner;
-	int priority;
+	MovieCacheShard *shard = item->shard;
+	MovieCacheKey *key = item->key;
 
-	if (!cache->getitempriorityfp) {
-		PRINT("%s: cache '%s' item %p use default priority %d\n", __func__, cache-> name, item, default_priority);
+	PRINT("%s: cache '%s' free item %p buffer %p\n", __func__, cache->name, item, item->ibuf);
+
+	clock_remove(item);
+
+	if (item->ibuf) {
+		IMB_freeImBuf(item->ibuf);
+	}
 
-		return default_priority;
+	if (item->priority_data && cache->prioritydeleterfp) {
+		cache->prioritydeleterfp(item->priority_data);
 	}
 
-	priority = cache->getitempriorityfp(cache->last_userkey, item->priority_data);
+	BLI_mempool_free(shard->userkeys_pool, key->userkey);
+	BLI_mempool_free(shard->keys_pool, key);
+	BLI_mempool_free(shard->items_pool, item);
 
-	PRINT("%s: cache '%s' item %p priority %d\n", __func__, cache-> name, item, priority);
+	/* force cached segments to be updated */
+	if (cache->points) {
+		MEM_freeN(cache->points);
+		cache->points = NULL;
+	}
+}
 
-	return priority;
+static void moviecache_item_free_cb(void *val)
+{
+	moviecache_item_free((MovieCacheItem *)val);
 }
 
-static bool get_item_destroyable(void *item_v)
+static void moviecache_item_remove(MovieCacheItem *item)
+{
+	BLI_ghash_remove(item->shard->hash, item->key, NULL, NULL);
+	moviecache_item_free(item);
+}
+
+static bool moviecache_item_destroyable(MovieCacheItem *item)
 {
-	MovieCacheItem *item = (MovieCacheItem *) item_v;
 	/* IB_BITMAPDIRTY means image was modified from inside blender and
 	 * changes are not saved to disk.
 	 *
@@ -281,23 +284,106 @@ static bool get_item_destroyable(void *item_v)
 	return true;
 }
 
-void IMB_moviecache_init(void)
+static int moviecache_item_priority(MovieCacheItem *item)
 {
-	limitor = new_MEM_CacheLimiter(IMB_moviecache_destructor, get_item_size);
+	MovieCache *cache = item->cache_owner;
+	int priority = cache->getitempriorityfp(cache->last_userkey, item->priority_data);
+
+	PRINT("%s: cache '%s' item %p priority %d\n", __func__, cache->name, item, priority);
 
-	MEM_CacheLimiter_ItemPriority_Func_set(limitor, get_item_priority);
-	MEM_CacheLimiter_ItemDestroyable_Func_set(limitor, get_item_destroyable);
+	return priority;
+}
+
+/* find the item to evict next, the limiter lock must be held */
+static MovieCacheItem *clock_find_victim(MovieCacheItem *keep)
+{
+	MovieCacheItem *samples[MOVIECACHE_CLOCK_SAMPLES];
+	MovieCacheItem *victim;
+	int num_samples = 0, best_priority, a;
+	unsigned int step;
+
+	/* two rounds, the first may only clear referenced flags */
+	for (step = 0; step < 2 * clock_len && num_samples < MOVIECACHE_CLOCK_SAMPLES; step++) {
+		MovieCacheItem *item;
+
+		if (clock_hand >= clock_len) {
+			clock_hand = 0;
+		}
+		item = clock_items[clock_hand++];
+
+		if (item == keep || item->cache_owner->iterators || !moviecache_item_destroyable(item)) {
+			continue;
+		}
+		/* priorities are only compared between items of the same cache */
+		if (num_samples && item->cache_owner != samples[0]->cache_owner) {
+			continue;
+		}
+		if (atomic_fetch_and_and_uint8(&item->referenced, 0)) {
+			continue;
+		}
+		if (!item->cache_owner->getitempriorityfp) {
+			return item;
+		}
+		samples[num_samples++] = item;
+	}
+
+	if (num_samples == 0) {
+		return NULL;
+	}
+
+	victim = samples[0];
+	best_priority = moviecache_item_priority(victim);
+	for (a = 1; a < num_samples; a++) {
+		int priority = moviecache_item_priority(samples[a]);
+		if (priority < best_priority) {
+			best_priority = priority;
+			victim = samples[a];
+		}
+	}
+	return victim;
+}
+
+/* evict items until the memory limit is respected, the limiter lock must be held */
+static void moviecache_enforce_limit(MovieCacheItem *keep)
+{
+	const size_t max = MEM_CacheLimiter_get_maximum();
+
+	if (MEM_CacheLimiter_is_disabled() || max == 0) {
+		return;
+	}
+
+	while (memory_in_use > max) {
+		MovieCacheItem *item = clock_find_victim(keep);
+		MovieCacheShard *shard;
+
+		if (!item) {
+			break;
+		}
+
+		PRINT("%s: cache '%s' evict item %p buffer %p\n", __func__, item->cache_owner->name, item, item->ibuf);
+
+		shard = item->shard;
+		BLI_rw_mutex_lock(&shard->lock, THREAD_LOCK_WRITE);
+		moviecache_item_remove(item);
+		BLI_rw_mutex_unlock(&shard->lock);
+	}
 }
 
 void IMB_moviecache_destruct(void)
 {
-	if (limitor)
-		delete_MEM_CacheLimiter(limitor);
+	BLI_mutex_lock(&limiter_lock);
+	/* caches which are still alive keep using the clock */
+	if (clock_len == 0) {
+		MEM_SAFE_FREE(clock_items);
+		clock_size = clock_hand = 0;
+	}
+	BLI_mutex_unlock(&limiter_lock);
 }
 
 MovieCache *IMB_moviecache_create(const char *name, int keysize, GHashHashFP hashfp, GHashCmpFP cmpfp)
 {
 	MovieCache *cache;
+	int a;
 
 	PRINT("%s: cache '%s' create\n", __func__, name);
 
@@ -305,10 +391,15 @@ MovieCache *IMB_moviecache_create(const char *name, int keysize, GHashHashFP has
 
 	BLI_strncpy(cache->name, name, sizeof(cache->name));
 
-	cache->keys_pool = BLI_mempool_create(sizeof(MovieCacheKey), 0, 64, BLI_MEMPOOL_NOP);
-	cache->items_pool = BLI_mempool_create(sizeof(MovieCacheItem), 0, 64, BLI_MEMPOOL_NOP);
-	cache->userkeys_pool = BLI_mempool_create(keysize, 0, 64, BLI_MEMPOOL_NOP);
-	cache->hash = BLI_ghash_new(moviecache_hashhash, moviecache_hashcmp, "MovieClip ImBuf cache hash");
+	for (a = 0; a < MOVIECACHE_SHARDS; a++) {
+		MovieCacheShard *shard = &cache->shards[a];
+
+		shard->keys_pool = BLI_mempool_create(sizeof(MovieCacheKey), 0, 64, BLI_MEMPOOL_NOP);
+		shard->items_pool = BLI_mempool_create(sizeof(MovieCacheItem), 0, 64, BLI_MEMPOOL_NOP);
+		shard->userkeys_pool = BLI_mempool_create(keysize, 0, 64, BLI_MEMPOOL_NOP);
+		shard->hash = BLI_ghash_new(moviecache_hashhash, moviecache_hashcmp, "MovieClip ImBuf cache hash");
+		BLI_rw_mutex_init(&shard->lock);
+	}
 
 	cache->keysize = keysize;
 	cache->hashfp = hashfp;
@@ -334,132 +425,148 @@ void IMB_moviecache_set_priority_callback(struct MovieCache *cache, MovieCacheGe
 	cache->prioritydeleterfp = prioritydeleterfp;
 }
 
-static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, bool need_lock)
+/* the limiter lock must be held */
+static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, size_t size)
 {
+	MovieCacheShard *shard = moviecache_shard(cache, userkey);
 	MovieCacheKey *key;
-	MovieCacheItem *item;
+	MovieCacheItem *item, *old_item;
+	void *priority_data = NULL;
 
-	if (!limitor)
-		IMB_moviecache_init();
+	if (cache->getprioritydatafp) {
+		priority_data = cache->getprioritydatafp(userkey);
+	}
 
 	IMB_refImBuf(ibuf);
 
-	key = BLI_mempool_alloc(cache->keys_pool);
+	BLI_rw_mutex_lock(&shard->lock, THREAD_LOCK_WRITE);
+
+	key = BLI_mempool_alloc(shard->keys_pool);
 	key->cache_owner = cache;
-	key->userkey = BLI_mempool_alloc(cache->userkeys_pool);
+	key->userkey = BLI_mempool_alloc(shard->userkeys_pool);
 	memcpy(key->userkey, userkey, cache->keysize);
 
-	item = BLI_mempool_alloc(cache->items_pool);
+	item = BLI_mempool_alloc(shard->items_pool);
 
-	PRINT("%s: cache '%s' put %p, item %p\n", __func__, cache-> name, ibuf, item);
+	PRINT("%s: cache '%s' put %p, item %p\n", __func__, cache->name, ibuf, item);
 
 	item->ibuf = ibuf;
 	item->cache_owner = cache;
-	item->c_handle = NULL;
-	item->priority_data = NULL;
-
-	if (cache->getprioritydatafp) {
-		item->priority_data = cache->getprioritydatafp(userkey);
+	item->shard = shard;
+	item->key = key;
+	item->priority_data = priority_data;
+	item->size = size;
+	/* new items get a second chance like items which were looked up */
+	item->referenced = 1;
+
+	old_item = BLI_ghash_lookup(shard->hash, key);
+	if (old_item) {
+		moviecache_item_remove(old_item);
 	}
-
-	BLI_ghash_reinsert(cache->hash, key, item, moviecache_keyfree, moviecache_valfree);
+	BLI_ghash_insert(shard->hash, key, item);
+	clock_insert(item);
 
 	if (cache->last_userkey) {
 		memcpy(cache->last_userkey, userkey, cache->keysize);
 	}
 
-	if (need_lock)
-		BLI_mutex_lock(&limitor_lock);
-
-	item->c_handle = MEM_CacheLimiter_insert(limitor, item);
-
-	MEM_CacheLimiter_ref(item->c_handle);
-	MEM_CacheLimiter_enforce_limits(limitor);
-	MEM_CacheLimiter_unref(item->c_handle);
-
-	if (need_lock)
-		BLI_mutex_unlock(&limitor_lock);
-
-	/* cache limiter can't remove unused keys which points to destoryed values */
-	check_unused_keys(cache);
-
 	if (cache->points) {
 		MEM_freeN(cache->points);
 		cache->points = NULL;
 	}
+
+	BLI_rw_mutex_unlock(&shard->lock);
+
+	moviecache_enforce_limit(item);
 }
 
 void IMB_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf)
 {
-	do_moviecache_put(cache, userkey, ibuf, true);
+	const size_t size = sizeof(MovieCacheItem) + IMB_get_size_in_memory(ibuf);
+
+	BLI_mutex_lock(&limiter_lock);
+	do_moviecache_put(cache, userkey, ibuf, size);
+	BLI_mutex_unlock(&limiter_lock);
 }
 
 bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibuf)
 {
-	size_t mem_in_use, mem_limit, elem_size;
+	size_t mem_limit, elem_size;
 	bool result = false;
 
-	elem_size = IMB_get_size_in_memory(ibuf);
+	elem_size = sizeof(MovieCacheItem) + IMB_get_size_in_memory(ibuf);
 	mem_limit = MEM_CacheLimiter_get_maximum();
 
-	BLI_mutex_lock(&limitor_lock);
-	mem_in_use = MEM_CacheLimiter_get_memory_in_use(limitor);
+	BLI_mutex_lock(&limiter_lock);
 
-	if (mem_in_use + elem_size <= mem_limit) {
-		do_moviecache_put(cache, userkey, ibuf, false);
+	if (memory_in_use + elem_size <= mem_limit) {
+		do_moviecache_put(cache, userkey, ibuf, elem_size);
 		result = true;
 	}
 
-	BLI_mutex_unlock(&limitor_lock);
+	BLI_mutex_unlock(&limiter_lock);
 
 	return result;
 }
 
 ImBuf *IMB_moviecache_get(MovieCache *cache, void *userkey)
 {
+	MovieCacheShard *shard = moviecache_shard(cache, userkey);
 	MovieCacheKey key;
 	MovieCacheItem *item;
+	ImBuf *ibuf = NULL;
 
 	key.cache_owner = cache;
 	key.userkey = userkey;
-	item = (MovieCacheItem *)BLI_ghash_lookup(cache->hash, &key);
 
-	if (item) {
-		if (item->ibuf) {
-			BLI_mutex_lock(&limitor_lock);
-			MEM_CacheLimiter_touch(item->c_handle);
-			BLI_mutex_unlock(&limitor_lock);
+	BLI_rw_mutex_lock(&shard->lock, THREAD_LOCK_READ);
+	item = (MovieCacheItem *)BLI_ghash_lookup(shard->hash, &key);
 
-			IMB_refImBuf(item->ibuf);
+	if (item && item->ibuf) {
+		atomic_fetch_and_or_uint8(&item->referenced, 1);
 
-			return item->ibuf;
-		}
+		ibuf = item->ibuf;
+		IMB_refImBuf(ibuf);
 	}
+	BLI_rw_mutex_unlock(&shard->lock);
 
-	return NULL;
+	return ibuf;
 }
 
 bool IMB_moviecache_has_frame(MovieCache *cache, void *userkey)
 {
+	MovieCacheShard *shard = moviecache_shard(cache, userkey);
 	MovieCacheKey key;
 	MovieCacheItem *item;
 
 	key.cache_owner = cache;
 	key.userkey = userkey;
-	item = (MovieCacheItem *)BLI_ghash_lookup(cache->hash, &key);
+
+	BLI_rw_mutex_lock(&shard->lock, THREAD_LOCK_READ);
+	item = (MovieCacheItem *)BLI_ghash_lookup(shard->hash, &key);
+	BLI_rw_mutex_unlock(&shard->lock);
 
 	return item != NULL;
 }
 
 void IMB_moviecache_free(MovieCache *cache)
 {
+	int a;
+
 	PRINT("%s: cache '%s' free\n", __func__, cache->name);
 
-	BLI_ghash_free(cache->hash, moviecache_keyfree, moviecache_valfree);
+	BLI_mutex_lock(&limiter_lock);
+	for (a = 0; a < MOVIECACHE_SHARDS; a++) {
+		MovieCacheShard *shard = &cache->shards[a];
 
-	BLI_mempool_destroy(cache->keys_pool);
-	BLI_mempool_destroy(cache->items_pool);
-	BLI_mempool_destroy(cache->userkeys_pool);
+		BLI_ghash_free(shard->hash, NULL, moviecache_item_free_cb);
+
+		BLI_mempool_destroy(shard->keys_pool);
+		BLI_mempool_destroy(shard->items_pool);
+		BLI_mempool_destroy(shard->userkeys_pool);
+		BLI_rw_mutex_end(&shard->lock);
+	}
+	BLI_mutex_unlock(&limiter_lock);
 
 	if (cache->points)
 		MEM_freeN(cache->points);
@@ -472,24 +579,31 @@ void IMB_moviecache_free(MovieCache *cache)
 
 void IMB_moviecache_cleanup(MovieCache *cache, bool (cleanup_check_cb) (ImBuf *ibuf, void *userkey, void *userdata), void *userdata)
 {
-	GHashIterator gh_iter;
+	int a;
 
-	check_unused_keys(cache);
+	BLI_mutex_lock(&limiter_lock);
+	for (a = 0; a < MOVIECACHE_SHARDS; a++) {
+		MovieCacheShard *shard = &cache->shards[a];
+		GHashIterator gh_iter;
 
-	BLI_ghashIterator_init(&gh_iter, cache->hash);
+		BLI_rw_mutex_lock(&shard->lock, THREAD_LOCK_WRITE);
+		BLI_ghashIterator_init(&gh_iter, shard->hash);
 
-	while (!BLI_ghashIterator_done(&gh_iter)) {
-		MovieCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
-		MovieCacheItem *item = BLI_ghashIterator_getValue(&gh_iter);
+		while (!BLI_ghashIterator_done(&gh_iter)) {
+			MovieCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
+			MovieCacheItem *item = BLI_ghashIterator_getValue(&gh_iter);
 
-		BLI_ghashIterator_step(&gh_iter);
+			BLI_ghashIterator_step(&gh_iter);
 
-		if (cleanup_check_cb(item->ibuf, key->userkey, userdata)) {
-			PRINT("%s: cache '%s' remove item %p\n", __func__, cache->name, item);
+			if (cleanup_check_cb(item->ibuf, key->userkey, userdata)) {
+				PRINT("%s: cache '%s' remove item %p\n", __func__, cache->name, item);
 
-			BLI_ghash_remove(cache->hash, key, moviecache_keyfree, moviecache_valfree);
+				moviecache_item_remove(item);
+			}
 		}
+		BLI_rw_mutex_unlock(&shard->lock);
 	}
+	BLI_mutex_unlock(&limiter_lock);
 }
 
 /* get segments of cached frames. useful for debugging cache policies */
@@ -501,6 +615,9 @@ void IMB_moviecache_get_cache_segments(MovieCache *cache, int proxy, int render_
 	if (!cache->getdatafp)
 		return;
 
+	/* no items are added or removed while the segments are built */
+	BLI_mutex_lock(&limiter_lock);
+
 	if (cache->proxy != proxy || cache->render_flags != render_flags) {
 		if (cache->points)
 			MEM_freeN(cache->points);
@@ -513,22 +630,29 @@ void IMB_moviecache_get_cache_segments(MovieCache *cache, int proxy, int render_
 		*points_r = cache->points;
 	}
 	else {
-		int totframe = BLI_ghash_len(cache->hash);
-		int *frames = MEM_callocN(totframe * sizeof(int), "movieclip cache frames");
-		int a, totseg = 0;
+		int totframe = 0;
+		int *frames;
+		int a, totseg = 0, shard;
 		GHashIterator gh_iter;
 
+		for (shard = 0; shard < MOVIECACHE_SHARDS; shard++) {
+			totframe += BLI_ghash_len(cache->shards[shard].hash);
+		}
+		frames = MEM_callocN(totframe * sizeof(int), "movieclip cache frames");
+
 		a = 0;
-		GHASH_ITER(gh_iter, cache->hash) {
-			MovieCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
-			MovieCacheItem *item = BLI_ghashIterator_getValue(&gh_iter);
-			int framenr, curproxy, curflags;
+		for (shard = 0; shard < MOVIECACHE_SHARDS; shard++) {
+			GHASH_ITER(gh_iter, cache->shards[shard].hash) {
+				MovieCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
+				MovieCacheItem *item = BLI_ghashIterator_getValue(&gh_iter);
+				int framenr, curproxy, curflags;
 
-			if (item->ibuf) {
-				cache->getdatafp(key->userkey, &framenr, &curproxy, &curflags);
+				if (item->ibuf) {
+					cache->getdatafp(key->userkey, &framenr, &curproxy, &curflags);
 
-				if (curproxy == proxy && curflags == render_flags)
-					frames[a++] = framenr;
+					if (curproxy == proxy && curflags == render_flags)
+						frames[a++] = framenr;
+				}
 			}
 		}
 
@@ -573,41 +697,70 @@ void IMB_moviecache_get_cache_segments(MovieCache *cache, int proxy, int render_
 
 		MEM_freeN(frames);
 	}
+
+	BLI_mutex_unlock(&limiter_lock);
 }
 
+/* The iterator does not lock the cache, the caller must not add or remove items of it while
+ * iterating. Items of the cache are not evicted by puts into other caches meanwhile, that is
+ * deferred until the last iterator is freed. */
 struct MovieCacheIter *IMB_moviecacheIter_new(MovieCache *cache)
 {
-	GHashIterator *iter;
+	MovieCacheIter *iter = MEM_mallocN(sizeof(MovieCacheIter), "MovieCacheIter");
+
+	BLI_mutex_lock(&limiter_lock);
+	cache->iterators++;
+	BLI_mutex_unlock(&limiter_lock);
+
+	iter->cache = cache;
+	iter->shard = 0;
+	BLI_ghashIterator_init(&iter->gh_iter, cache->shards[0].hash);
 
-	check_unused_keys(cache);
-	iter = BLI_ghashIterator_new(cache->hash);
+	/* skip empty shards */
+	while (BLI_ghashIterator_done(&iter->gh_iter) && iter->shard < MOVIECACHE_SHARDS - 1) {
+		iter->shard++;
+		BLI_ghashIterator_init(&iter->gh_iter, cache->shards[iter->shard].hash);
+	}
 
-	return (struct MovieCacheIter *) iter;
+	return iter;
 }
 
 void IMB_moviecacheIter_free(struct MovieCacheIter *iter)
 {
-	BLI_ghashIterator_free((GHashIterator *) iter);
+	BLI_mutex_lock(&limiter_lock);
+	iter->cache->iterators--;
+	/* evict what was skipped while iterating */
+	if (iter->cache->iterators == 0) {
+		moviecache_enforce_limit(NULL);
+	}
+	BLI_mutex_unlock(&limiter_lock);
+
+	MEM_freeN(iter);
 }
 
 bool IMB_moviecacheIter_done(struct MovieCacheIter *iter)
 {
-	return BLI_ghashIterator_done((GHashIterator *) iter);
+	return BLI_ghashIterator_done(&iter->gh_iter);
 }
 
 void IMB_moviecacheIter_step(struct MovieCacheIter *iter)
 {
-	BLI_ghashIterator_step((GHashIterator *) iter);
+	BLI_ghashIterator_step(&iter->gh_iter);
+
+	while (BLI_ghashIterator_done(&iter->gh_iter) && iter->shard < MOVIECACHE_SHARDS - 1) {
+		iter->shard++;
+		BLI_ghashIterator_init(&iter->gh_iter, iter->cache->shards[iter->shard].hash);
+	}
 }
 
 ImBuf *IMB_moviecacheIter_getImBuf(struct MovieCacheIter *iter)
 {
-	MovieCacheItem *item = BLI_ghashIterator_getValue((GHashIterator *) iter);
+	MovieCacheItem *item = BLI_ghashIterator_getValue(&iter->gh_iter);
 	return item->ibuf;
 }
 
 void *IMB_moviecacheIter_getUserKey(struct MovieCacheIter *iter)
 {
-	MovieCacheKey *key = BLI_ghashIterator_getKey((GHashIterator *) iter);
+	MovieCacheKey *key = BLI_ghashIterator_getKey(&iter->gh_iter);
 	return key->userkey;
 }
@@ -39,6 +39,7 @@
 #include <errno.h>
 #include <algorithm>
 #include <iostream>
+#include <vector>
 
 #include <half.h>
 #include <Iex.h>
@@ -62,6 +63,7 @@
 #include <ImfOutputPart.h>
 #include <ImfMultiPartOutputFile.h>
 #include <ImfTiledOutputPart.h>
+#include <ImfTiledInputPart.h>
 #include <ImfPartType.h>
 #include <ImfPartHelper.h>
 
@@ -86,6 +88,7 @@ _CRTIMP void __cdecl _invalid_parameter_noinfo(void)
 #include "MEM_guardedalloc.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_math_base.h"
 #include "BLI_math_color.h"
 #include "BLI_threads.h"
 
@@ -1739,6 +1742,405 @@ bool IMB_exr_has_multilayer(void *handle)
 	return imb_exr_is_multi(*data->ifile);
 }
 
+static void exr_read_metadata(const Header& header, ImBuf *ibuf)
+{
+	Header::ConstIterator iter;
+
+	IMB_metadata_ensure(&ibuf->metadata);
+	for (iter = header.begin(); iter != header.end(); iter++) {
+		const StringAttribute *attrib = header.findTypedAttribute <StringAttribute> (iter.name());
+
+		/* not all attributes are string attributes so we might get some NULLs here */
+		if (attrib) {
+			IMB_metadata_set_field(ibuf->metadata, iter.name(), attrib->value().c_str());
+			ibuf->flags |= IB_metadata;
+		}
+	}
+}
+
+/* ********************** Partial reading ********************** */
+
+/* uncompressed size of a pixel with all channels of a part */
+static size_t exr_pixel_size(const Header& header)
+{
+	const ChannelList& channels = header.channels();
+	size_t size = 0;
+
+	for (ChannelList::ConstIterator i = channels.begin(); i != channels.end(); ++i) {
+		size += (i.channel().type == HALF) ? sizeof(half) : sizeof(float);
+	}
+
+	return size;
+}
+
+static size_t exr_box_area(const Box2i& box)
+{
+	return (size_t)(box.max.x - box.min.x + 1) * (size_t)(box.max.y - box.min.y + 1);
+}
+
+/* channels of a pass of a multilayer file, sorted like imb_exr_begin_read_mem does */
+static int exr_pass_channels(const Header& header, const char *passname, std::string names[4])
+{
+	const ChannelList& channels = header.channels();
+	const size_t len = strlen(passname);
+	const char *order = NULL;
+	int totchan = 0;
+
+	for (ChannelList::ConstIterator i = channels.begin(); i != channels.end() && totchan < 4; ++i) {
+		const char *name = i.name();
+
+		/* "Layer.Pass.X", channels of other views have the view name before the identifier */
+		if (STREQLEN(name, passname, len) && name[len] == '.' && name[len + 1] != '\0' && name[len + 2] == '\0') {
+			names[totchan++] = name;
+		}
+	}
+
+	for (int a = 0; a < totchan; a++) {
+		const char chan_id = names[a][len + 1];
+
+		if (chan_id == 'B') {
+			order = "RGBA";
+		}
+		else if (chan_id == 'Y' && order == NULL) {
+			order = "XYZW";
+		}
+		else if (chan_id == 'V' && order == NULL) {
+			order = "UVA";
+		}
+	}
+
+	if (order) {
+		/* channels which are not in the order are kept last */
+		for (int a = 1; a < totchan; a++) {
+			for (int b = a; b > 0; b--) {
+				const char *pos_a = strchr(order, names[b - 1][len + 1]);
+				const char *pos_b = strchr(order, names[b][len + 1]);
+
+				if (pos_b && (pos_a == NULL || pos_b < pos_a)) {
+					std::swap(names[b - 1], names[b]);
+				}
+			}
+		}
+	}
+
+	return totchan;
+}
+
+/* the pixel (min_x, min_y) of the file is stored at first, the other pixels at the given strides */
+static void exr_partial_framebuffer(FrameBuffer& frameBuffer, const std::string names[4], int totchan,
+                                    float *first, int min_x, int min_y, ptrdiff_t xstride, ptrdiff_t ystride)
+{
+	/* inverse correct first pixel for the data window coordinates */
+	char *base = (char *)first - min_x * xstride - min_y * ystride;
+
+	for (int a = 0; a < totchan; a++) {
+		/* 1.0 is fill value for the alpha of RGB files */
+		frameBuffer.insert(names[a], Slice(Imf::FLOAT, base + a * sizeof(float), xstride, ystride, 1, 1,
+		                                   (a == 3) ? 1.0f : 0.0f));
+	}
+}
+
+/* read the pixels of read_box which contains region, into the float buffer of the ImBuf the size of region */
+static void exr_read_partial_pixels(InputPart *in, TiledInputPart *tiled_in, int tile_x[2], int tile_y[2], int lx, int ly,
+                                    const Box2i& read_box, const Box2i& region,
+                                    const std::string names[4], int totchan, ImBuf *ibuf)
+{
+	const int channels = ibuf->channels;
+	const int width = region.max.x - region.min.x + 1;
+	const int height = region.max.y - region.min.y + 1;
+	FrameBuffer frameBuffer;
+
+	if (read_box == region) {
+		/* read directly, the last scanline is the top of the image */
+		exr_partial_framebuffer(frameBuffer, names, totchan,
+		                        ibuf->rect_float + (size_t)channels * (height - 1) * width,
+		                        region.min.x, region.min.y,
+		                        sizeof(float) * channels, -(ptrdiff_t)(sizeof(float) * channels * width));
+
+		if (tiled_in) {
+			tiled_in->setFrameBuffer(frameBuffer);
+			tiled_in->readTiles(tile_x[0], tile_x[1], tile_y[0], tile_y[1], lx, ly);
+		}
+		else {
+			in->setFrameBuffer(frameBuffer);
+			in->readPixels(region.min.y, region.max.y);
+		}
+	}
+	else {
+		/* whole scanlines or tiles are written, read into a buffer and copy the region */
+		const int read_width = read_box.max.x - read_box.min.x + 1;
+		std::vector<float> buffer(exr_box_area(read_box) * channels);
+
+		exr_partial_framebuffer(frameBuffer, names, totchan, &buffer[0],
+		                        read_box.min.x, read_box.min.y,
+		                        sizeof(float) * channels, sizeof(float) * channels * read_width);
+
+		if (tiled_in) {
+			tiled_in->setFrameBuffer(frameBuffer);
+			tiled_in->readTiles(tile_x[0], tile_x[1], tile_y[0], tile_y[1], lx, ly);
+		}
+		else {
+			in->setFrameBuffer(frameBuffer);
+			in->readPixels(read_box.min.y, read_box.max.y);
+		}
+
+		for (int y = 0; y < height; y++) {
+			const float *src = &buffer[((size_t)(region.max.y - y - read_box.min.y) * read_width +
+			                            (region.min.x - read_box.min.x)) * channels];
+			float *dst = ibuf->rect_float + (size_t)channels * y * width;
+
+			memcpy(dst, src, sizeof(float) * channels * width);
+		}
+	}
+}
+
+/* Scanline files have no levels, for a reduced size every step-th pixel of every step-th
+ * scanline is read instead. All scanlines go through a single row buffer. */
+static void exr_read_subsampled_pixels(InputPart *in, const Box2i& dw, int step,
+                                       const std::string names[4], int totchan, ImBuf *ibuf)
+{
+	const int channels = ibuf->channels;
+	std::vector<float> row((size_t)(dw.max.x - dw.min.x + 1) * channels);
+	FrameBuffer frameBuffer;
+
+	exr_partial_framebuffer(frameBuffer, names, totchan, &row[0], dw.min.x, dw.min.y,
+	                        sizeof(float) * channels, 0);
+	in->setFrameBuffer(frameBuffer);
+
+	for (int y = 0; y < ibuf->y; y++) {
+		float *dst = ibuf->rect_float + (size_t)channels * y * ibuf->x;
+
+		/* the last scanline is the bottom of the image */
+		in->readPixels(dw.max.y - y * step);
+
+		for (int x = 0; x < ibuf->x; x++) {
+			memcpy(dst + (size_t)channels * x, &row[(size_t)channels * x * step], sizeof(float) * channels);
+		}
+	}
+}
+
+static ImBuf *exr_read_partial(MultiPartInputFile& file, int flags, ImPartialRead *partial)
+{
+	std::string names[4];
+	int part = 0, totchan = 0;
+	size_t full_size = 0;
+
+	if (partial->passname) {
+		for (part = 0; part < file.parts(); part++) {
+			totchan = exr_pass_channels(file.header(part), partial->passname, names);
+			if (totchan) {
+				break;
+			}
+		}
+
+		/* loading the whole file would read all passes */
+		for (int a = 0; a < file.parts(); a++) {
+			full_size += exr_pixel_size(file.header(a)) * exr_box_area(file.header(a).dataWindow());
+		}
+	}
+	else if (!imb_exr_is_multi(file) || (flags & IB_thumbnail)) {
+		/* luma and chroma files are only read completely */
+		if (exr_has_rgb(file) || imb_exr_is_multi(file)) {
+			names[0] = exr_rgba_channelname(file, "R");
+			names[1] = exr_rgba_channelname(file, "G");
+			names[2] = exr_rgba_channelname(file, "B");
+			names[3] = exr_rgba_channelname(file, "A");
+			totchan = 4;
+		}
+
+		full_size = exr_pixel_size(file.header(0)) * exr_box_area(file.header(0).dataWindow());
+	}
+
+	if (totchan == 0) {
+		return NULL;
+	}
+
+	const Header& header = file.header(part);
+	const Box2i& dw = header.dataWindow();
+	TiledInputPart *tiled_in = NULL;
+	InputPart *in = NULL;
+	ImBuf *ibuf = NULL;
+
+	partial->width = dw.max.x - dw.min.x + 1;
+	partial->height = dw.max.y - dw.min.y + 1;
+
+	try {
+		Box2i level_dw = dw, region, read_box;
+		int lx = 0, ly = 0, tile_x[2] = {0, 0}, tile_y[2] = {0, 0};
+		int subsample_level = 0;
+
+		if (header.hasTileDescription()) {
+			int num_x_levels = 1, num_y_levels = 1;
+			int level = max_ii(partial->level, 0);
+
+			tiled_in = new TiledInputPart(file, part);
+
+			if (tiled_in->levelMode() == MIPMAP_LEVELS) {
+				num_x_levels = num_y_levels = tiled_in->numLevels();
+			}
+			else if (tiled_in->levelMode() == RIPMAP_LEVELS) {
+				num_x_levels = tiled_in->numXLevels();
+				num_y_levels = tiled_in->numYLevels();
+			}
+
+			if (partial->level_min_size) {
+				/* the smallest level of which the largest side is still large enough */
+				for (level = 0; level + 1 < max_ii(num_x_levels, num_y_levels); level++) {
+					const Box2i next_dw = tiled_in->dataWindowForLevel(min_ii(level + 1, num_x_levels - 1),
+					                                                   min_ii(level + 1, num_y_levels - 1));
+					const int next_size = max_ii(next_dw.max.x - next_dw.min.x, next_dw.max.y - next_dw.min.y) + 1;
+
+					if (next_size < partial->level_min_size) {
+						break;
+					}
+				}
+			}
+
+			lx = min_ii(level, num_x_levels - 1);
+			ly = min_ii(level, num_y_levels - 1);
+			level_dw = tiled_in->dataWindowForLevel(lx, ly);
+		}
+		else {
+			in = new InputPart(file, part);
+
+			/* subsample whole images to the size the level would have */
+			if (partial->level_min_size && !(partial->xmax > partial->xmin && partial->ymax > partial->ymin)) {
+				const int size = max_ii(partial->width, partial->height);
+
+				while ((size >> (subsample_level + 1)) >= partial->level_min_size) {
+					subsample_level++;
+				}
+
+				level_dw.max.x = level_dw.min.x + max_ii(partial->width >> subsample_level, 1) - 1;
+				level_dw.max.y = level_dw.min.y + max_ii(partial->height >> subsample_level, 1) - 1;
+			}
+		}
+
+		partial->level_read = max_ii(max_ii(lx, ly), subsample_level);
+
+		/* clamp the region to the level */
+		const int level_width = level_dw.max.x - level_dw.min.x + 1;
+		const int level_height = level_dw.max.y - level_dw.min.y + 1;
+		int xmin = 0, ymin = 0, xmax = level_width - 1, ymax = level_height - 1;
+
+		if (partial->xmax > partial->xmin && partial->ymax > partial->ymin) {
+			xmin = max_ii(partial->xmin, 0);
+			ymin = max_ii(partial->ymin, 0);
+			xmax = min_ii(partial->xmax, level_width) - 1;
+			ymax = min_ii(partial->ymax, level_height) - 1;
+		}
+
+		if (xmin <= xmax && ymin <= ymax) {
+			/* region in file coordinates, where y goes down */
+			region.min.x = level_dw.min.x + xmin;
+			region.max.x = level_dw.min.x + xmax;
+			region.min.y = level_dw.max.y - ymax;
+			region.max.y = level_dw.max.y - ymin;
+
+			if (tiled_in) {
+				tile_x[0] = (region.min.x - level_dw.min.x) / tiled_in->tileXSize();
+				tile_x[1] = (region.max.x - level_dw.min.x) / tiled_in->tileXSize();
+				tile_y[0] = (region.min.y - level_dw.min.y) / tiled_in->tileYSize();
+				tile_y[1] = (region.max.y - level_dw.min.y) / tiled_in->tileYSize();
+
+				read_box.min = tiled_in->dataWindowForTile(tile_x[0], tile_y[0], lx, ly).min;
+				read_box.max = tiled_in->dataWindowForTile(tile_x[1], tile_y[1], lx, ly).max;
+			}
+			else {
+				/* scanlines are always read completely */
+				read_box.min = V2i(dw.min.x, region.min.y);
+				read_box.max = V2i(dw.max.x, region.max.y);
+			}
+
+			const int channels = (totchan == 2) ? 3 : totchan;
+			const bool is_alpha = (channels == 4) && (partial->passname || exr_has_alpha(file));
+
+			ibuf = IMB_allocImBuf(xmax - xmin + 1, ymax - ymin + 1, is_alpha ? 32 : 24, 0);
+
+			if (hasXDensity(file.header(0))) {
+				ibuf->ppm[0] = xDensity(file.header(0)) * 39.3700787f;
+				ibuf->ppm[1] = ibuf->ppm[0] * (double)file.header(0).pixelAspectRatio();
+			}
+
+			ibuf->ftype = IMB_FTYPE_OPENEXR;
+
+			if (flags & IB_metadata) {
+				exr_read_metadata(file.header(0), ibuf);
+			}
+
+			imb_addrectfloatImBuf(ibuf);
+			ibuf->channels = channels;
+			if (totchan != channels) {
+				memset(ibuf->rect_float, 0, sizeof(float) * channels * ibuf->x * ibuf->y);
+			}
+
+			if (subsample_level) {
+				exr_read_subsampled_pixels(in, dw, 1 << subsample_level, names, totchan, ibuf);
+
+				/* whole scanlines are read */
+				read_box.min = V2i(dw.min.x, 0);
+				read_box.max = V2i(dw.max.x, ibuf->y - 1);
+			}
+			else {
+				exr_read_partial_pixels(in, tiled_in, tile_x, tile_y, lx, ly, read_box, region, names, totchan, ibuf);
+			}
+
+			partial->bytes_read = exr_pixel_size(header) * exr_box_area(read_box);
+			partial->bytes_skipped = (full_size > partial->bytes_read) ? full_size - partial->bytes_read : 0;
+
+			if (flags & IB_alphamode_detect)
+				ibuf->flags |= IB_alphamode_premul;
+		}
+	}
+	catch (const std::exception& exc) {
+		std::cerr << "OpenEXR-partial read: ERROR: " << exc.what() << std::endl;
+		if (ibuf) {
+			IMB_freeImBuf(ibuf);
+			ibuf = NULL;
+		}
+	}
+
+	delete tiled_in;
+	delete in;
+
+	return ibuf;
+}
+
+struct ImBuf *imb_load_openexr_partial(const char *filepath, int flags, ImPartialRead *partial,
+                                       char colorspace[IM_MAX_SPACE])
+{
+	IFileStream *file_stream = NULL;
+	MultiPartInputFile *file = NULL;
+	ImBuf *ibuf = NULL;
+
+	try
+	{
+		char magic[4];
+
+		file_stream = new IFileStream(filepath);
+
+		if (file_stream->read(magic, sizeof(magic)) && imb_is_a_openexr((const unsigned char *)magic)) {
+			colorspace_set_default_role(colorspace, IM_MAX_SPACE, COLOR_ROLE_DEFAULT_FLOAT);
+
+			file_stream->seekg(0);
+			file = new MultiPartInputFile(*file_stream);
+
+			ibuf = exr_read_partial(*file, flags, partial);
+		}
+	}
+	catch (const std::exception& exc)
+	{
+		std::cerr << exc.what() << std::endl;
+		if (ibuf) IMB_freeImBuf(ibuf);
+		ibuf = NULL;
+	}
+
+	delete file;
+	delete file_stream;
+
+	return ibuf;
+}
+
 struct ImBuf *imb_load_openexr(const unsigned char *mem, size_t size, int flags, char colorspace[IM_MAX_SPACE])
 {
 	struct ImBuf *ibuf = NULL;
@@ -1787,19 +2189,7 @@ struct ImBuf *imb_load_openexr(const unsigned char *mem, size_t size, int flags,
 			if (!(flags & IB_test)) {
 
 				if (flags & IB_metadata) {
-					const Header & header = file->header(0);
-					Header::ConstIterator iter;
-
-					IMB_metadata_ensure(&ibuf->metadata);
-					for (iter = header.begin(); iter != header.end(); iter++) {
-						const StringAttribute *attrib = file->header(0).findTypedAttribute <StringAttribute> (iter.name());
-
-						/* not all attributes are string attributes so we might get some NULLs here */
-						if (attrib) {
-							IMB_metadata_set_field(ibuf->metadata, iter.name(), attrib->value().c_str());
-							ibuf->flags |= IB_metadata;
-						}
-					}
+					exr_read_metadata(file->header(0), ibuf);
 				}
 
 				if (is_multi && ((flags & IB_thumbnail) == 0)) { /* only enters with IB_multilayer flag set */
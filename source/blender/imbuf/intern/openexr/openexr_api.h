@@ -47,6 +47,8 @@ int		imb_save_openexr			(struct ImBuf *ibuf, const char *name, int flags);
 
 struct ImBuf *imb_load_openexr		(const unsigned char *mem, size_t size, int flags, char *colorspace);
 
+struct ImBuf *imb_load_openexr_partial(const char *filepath, int flags, struct ImPartialRead *partial, char *colorspace);
+
 #ifdef __cplusplus
 }
 #endif
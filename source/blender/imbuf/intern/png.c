@@ -32,10 +32,13 @@
  */
 
 #include "png.h"
+#include "zlib.h"
 
 #include "BLI_utildefines.h"
 #include "BLI_fileops.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_global.h"
 #include "BKE_idprop.h"
@@ -127,6 +130,262 @@ BLI_INLINE unsigned short ftoshort(float val)
 	return unit_float_to_ushort_clamp(val);
 }
 
+/* -------------------------------------------------------------------- */
+/* Threaded deflate
+ *
+ * libpng filters and deflates the whole image on a single thread. For large
+ * images the rows are split in blocks that are filtered and deflated on all
+ * threads instead, then concatenated into one zlib stream: all blocks except
+ * the last one end with a sync flush so they stop on a byte boundary, and
+ * the adler32 checksums of the blocks are combined (same scheme as pigz).
+ * Blocks don't share a dictionary, which costs a little compression at
+ * every block boundary. */
+
+#define PNG_DEFLATE_BLOCK_SIZE (512 * 1024)  /* filtered bytes per block */
+#define PNG_IDAT_CHUNK_SIZE (1024 * 1024)
+
+typedef struct PNGDeflateBlock {
+	unsigned char *data;
+	size_t size;
+	size_t raw_size;
+	uLong adler;
+	bool ok;
+} PNGDeflateBlock;
+
+typedef struct PNGDeflateData {
+	png_bytepp row_pointers;
+	int height;
+	size_t row_bytes;
+	int pixel_bytes;
+	bool swap_bytes;
+	int level;
+	int rows_per_block;
+	int num_blocks;
+	PNGDeflateBlock *blocks;
+} PNGDeflateData;
+
+BLI_INLINE int png_paeth_predictor(int a, int b, int c)
+{
+	const int p = a + b - c;
+	const int pa = abs(p - a);
+	const int pb = abs(p - b);
+	const int pc = abs(p - c);
+
+	if (pa <= pb && pa <= pc) {
+		return a;
+	}
+	return (pb <= pc) ? b : c;
+}
+
+/* Same heuristic as libpng: pick the filter with the smallest sum of
+ * absolute values of the filtered bytes, seen as signed. */
+static void png_filter_row(unsigned char *dst, const unsigned char *cur, const unsigned char *prev,
+                           size_t row_bytes, int bpp, unsigned char *scratch)
+{
+	unsigned char *filtered[5];
+	unsigned int sum[5] = {0, 0, 0, 0, 0};
+	int best = 0;
+	size_t i;
+	int f;
+
+	for (f = 0; f < 5; f++) {
+		filtered[f] = scratch + f * row_bytes;
+	}
+
+	for (i = 0; i < row_bytes; i++) {
+		const int a = (i >= (size_t)bpp) ? cur[i - bpp] : 0;
+		const int b = prev[i];
+		const int c = (i >= (size_t)bpp) ? prev[i - bpp] : 0;
+		const int x = cur[i];
+
+		filtered[0][i] = (unsigned char)x;
+		filtered[1][i] = (unsigned char)(x - a);
+		filtered[2][i] = (unsigned char)(x - b);
+		filtered[3][i] = (unsigned char)(x - ((a + b) >> 1));
+		filtered[4][i] = (unsigned char)(x - png_paeth_predictor(a, b, c));
+
+		for (f = 0; f < 5; f++) {
+			const int v = filtered[f][i];
+			sum[f] += (v < 128) ? v : 256 - v;
+		}
+	}
+
+	for (f = 1; f < 5; f++) {
+		if (sum[f] < sum[best]) {
+			best = f;
+		}
+	}
+
+	dst[0] = (unsigned char)best;
+	memcpy(dst + 1, filtered[best], row_bytes);
+}
+
+static void png_deflate_load_row(const PNGDeflateData *data, int row, unsigned char *dst)
+{
+	const unsigned char *src = data->row_pointers[row];
+
+	if (data->swap_bytes) {
+		size_t i;
+		for (i = 0; i < data->row_bytes; i += 2) {
+			dst[i] = src[i + 1];
+			dst[i + 1] = src[i];
+		}
+	}
+	else {
+		memcpy(dst, src, data->row_bytes);
+	}
+}
+
+static void png_deflate_block(TaskPool * __restrict pool, void *taskdata, int UNUSED(threadid))
+{
+	const PNGDeflateData *data = BLI_task_pool_userdata(pool);
+	const int block = GET_INT_FROM_POINTER(taskdata);
+	PNGDeflateBlock *out = &data->blocks[block];
+	const int row_start = block * data->rows_per_block;
+	const int row_end = min_ii(row_start + data->rows_per_block, data->height);
+	const bool is_last = (block == data->num_blocks - 1);
+	const size_t stride = data->row_bytes + 1;
+	unsigned char *filtered, *rows, *cur, *prev;
+	z_stream stream = {NULL};
+	size_t bound;
+	int row, ret;
+
+	out->raw_size = stride * (row_end - row_start);
+	filtered = MEM_mallocN(out->raw_size, "png deflate block");
+	rows = MEM_callocN(data->row_bytes * 7, "png deflate rows");
+	prev = rows;
+	cur = rows + data->row_bytes;
+
+	/* filters look at the row above, which belongs to the previous block */
+	if (row_start > 0) {
+		png_deflate_load_row(data, row_start - 1, prev);
+	}
+
+	for (row = row_start; row < row_end; row++) {
+		unsigned char *tmp;
+
+		png_deflate_load_row(data, row, cur);
+		png_filter_row(filtered + stride * (row - row_start), cur, prev,
+		               data->row_bytes, data->pixel_bytes, rows + data->row_bytes * 2);
+
+		tmp = prev;
+		prev = cur;
+		cur = tmp;
+	}
+	MEM_freeN(rows);
+
+	out->adler = adler32(adler32(0L, Z_NULL, 0), filtered, (uInt)out->raw_size);
+
+	/* raw deflate, the zlib header and checksum are written once for all blocks,
+	 * Z_FILTERED is what libpng uses for filtered rows as well */
+	if (deflateInit2(&stream, data->level, Z_DEFLATED, -MAX_WBITS, 8, Z_FILTERED) != Z_OK) {
+		MEM_freeN(filtered);
+		return;
+	}
+
+	/* room for the flush marker on top of what a finished stream needs */
+	bound = deflateBound(&stream, out->raw_size) + 64;
+	out->data = MEM_mallocN(bound, "png deflate output");
+
+	stream.next_in = filtered;
+	stream.avail_in = (uInt)out->raw_size;
+	stream.next_out = out->data;
+	stream.avail_out = (uInt)bound;
+
+	ret = deflate(&stream, is_last ? Z_FINISH : Z_SYNC_FLUSH);
+
+	out->ok = is_last ? (ret == Z_STREAM_END) : (ret == Z_OK && stream.avail_in == 0 && stream.avail_out != 0);
+	out->size = bound - stream.avail_out;
+
+	deflateEnd(&stream);
+	MEM_freeN(filtered);
+}
+
+static void png_write_idat(png_structp png_ptr, const unsigned char *data, size_t size)
+{
+	while (size > 0) {
+		const size_t chunk_size = min_zz(size, PNG_IDAT_CHUNK_SIZE);
+		png_write_chunk(png_ptr, (png_bytep)"IDAT", (png_bytep)data, chunk_size);
+		data += chunk_size;
+		size -= chunk_size;
+	}
+}
+
+/* Write the image data and the end of the file, returns false when nothing
+ * has been written and the regular libpng path has to be used. */
+static bool png_write_image_threaded(png_structp png_ptr, png_bytepp row_pointers,
+                                     int width, int height, int pixel_bytes, bool swap_bytes, int level)
+{
+	PNGDeflateData data;
+	TaskScheduler *task_scheduler;
+	TaskPool *task_pool;
+	unsigned char header[2], trailer[4];
+	unsigned int zlib_header;
+	uLong adler = adler32(0L, Z_NULL, 0);
+	bool ok = true;
+	int i;
+
+	data.row_pointers = row_pointers;
+	data.height = height;
+	data.row_bytes = (size_t)width * pixel_bytes;
+	data.pixel_bytes = pixel_bytes;
+	data.swap_bytes = swap_bytes;
+	data.level = level;
+	data.rows_per_block = max_ii(1, (int)(PNG_DEFLATE_BLOCK_SIZE / (data.row_bytes + 1)));
+	data.num_blocks = (height + data.rows_per_block - 1) / data.rows_per_block;
+
+	if (data.num_blocks < 2 || BLI_system_thread_count() < 2) {
+		return false;
+	}
+
+	data.blocks = MEM_callocN(sizeof(PNGDeflateBlock) * data.num_blocks, "png deflate blocks");
+
+	task_scheduler = BLI_task_scheduler_get();
+	task_pool = BLI_task_pool_create(task_scheduler, &data);
+	for (i = 0; i < data.num_blocks; i++) {
+		BLI_task_pool_push(task_pool, png_deflate_block, SET_INT_IN_POINTER(i), false, TASK_PRIORITY_LOW);
+	}
+	BLI_task_pool_work_and_wait(task_pool);
+	BLI_task_pool_free(task_pool);
+
+	for (i = 0; i < data.num_blocks; i++) {
+		ok &= data.blocks[i].ok;
+	}
+
+	if (ok) {
+		/* zlib header, the level hint matches what zlib itself would write */
+		zlib_header = (Z_DEFLATED + ((MAX_WBITS - 8) << 4)) << 8;
+		zlib_header |= ((level < 2) ? 0 : (level < 6) ? 1 : (level == 6) ? 2 : 3) << 6;
+		zlib_header += 31 - (zlib_header % 31);
+		header[0] = (unsigned char)(zlib_header >> 8);
+		header[1] = (unsigned char)(zlib_header & 0xff);
+		png_write_idat(png_ptr, header, 2);
+
+		for (i = 0; i < data.num_blocks; i++) {
+			png_write_idat(png_ptr, data.blocks[i].data, data.blocks[i].size);
+			adler = adler32_combine(adler, data.blocks[i].adler, (z_off_t)data.blocks[i].raw_size);
+		}
+
+		trailer[0] = (unsigned char)(adler >> 24);
+		trailer[1] = (unsigned char)(adler >> 16);
+		trailer[2] = (unsigned char)(adler >> 8);
+		trailer[3] = (unsigned char)(adler);
+		png_write_idat(png_ptr, trailer, 4);
+
+		/* all text chunks went out with the header, only the end marker is left */
+		png_write_chunk(png_ptr, (png_bytep)"IEND", NULL, 0);
+	}
+
+	for (i = 0; i < data.num_blocks; i++) {
+		if (data.blocks[i].data) {
+			MEM_freeN(data.blocks[i].data);
+		}
+	}
+	MEM_freeN(data.blocks);
+
+	return ok;
+}
+
 int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
 {
 	png_structp png_ptr;
@@ -141,6 +400,7 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
 	FILE *fp = NULL;
 
 	bool is_16bit  = (ibuf->foptions.flag & PNG_16BIT) != 0;
+	bool swap_bytes = false;
 	bool has_float = (ibuf->rect_float != NULL);
 	int channels_in_float = ibuf->channels ? ibuf->channels : 4;
 
@@ -472,11 +732,19 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
 		}
 	}
 
-	/* write out the entire image data in one call */
-	png_write_image(png_ptr, row_pointers);
+#ifdef __LITTLE_ENDIAN__
+	swap_bytes = is_16bit;
+#endif
 
-	/* write the additional chunks to the PNG file (not really needed) */
-	png_write_end(png_ptr, info_ptr);
+	if (!png_write_image_threaded(png_ptr, row_pointers, ibuf->x, ibuf->y,
+	                              bytesperpixel * (is_16bit ? 2 : 1), swap_bytes, compression))
+	{
+		/* write out the entire image data in one call */
+		png_write_image(png_ptr, row_pointers);
+
+		/* write the additional chunks to the PNG file (not really needed) */
+		png_write_end(png_ptr, info_ptr);
+	}
 
 	/* clean up */
 	if (pixels)
@@ -54,6 +54,12 @@
 #include "IMB_colormanagement.h"
 #include "IMB_colormanagement_intern.h"
 
+#include "atomic_ops.h"
+
+#ifdef WITH_OPENEXR
+#  include "openexr/openexr_api.h"
+#endif
+
 static void imb_handle_alpha(ImBuf *ibuf, int flags, char colorspace[IM_MAX_SPACE], char effective_colorspace[IM_MAX_SPACE])
 {
 	int alpha_flags;
@@ -238,6 +244,90 @@ ImBuf *IMB_loadiffname(const char *filepath, int flags, char colorspace[IM_MAX_S
 	return ibuf;
 }
 
+/* formats which decode a reduced size directly from memory */
+static ImBuf *imb_load_partial_from_file(const char *filepath, int flags, ImPartialRead *partial,
+                                         char colorspace[IM_MAX_SPACE])
+{
+	ImBuf *ibuf = NULL;
+	unsigned char *mem;
+	size_t size;
+	int file;
+
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file == -1)
+		return NULL;
+
+	size = BLI_file_descriptor_size(file);
+
+	imb_mmap_lock();
+	mem = mmap(NULL, size, PROT_READ, MAP_SHARED, file, 0);
+	imb_mmap_unlock();
+
+	if (mem != (unsigned char *) -1) {
+		if (size >= 4 && imb_is_a_jpeg(mem))
+			ibuf = imb_load_jpeg_partial(mem, size, flags, partial, colorspace);
+
+		imb_mmap_lock();
+		if (munmap(mem, size))
+			fprintf(stderr, "%s: couldn't unmap file %s\n", __func__, filepath);
+		imb_mmap_unlock();
+	}
+
+	close(file);
+
+	return ibuf;
+}
+
+/* counters of IMB_loadiffname_partial, updated from any thread */
+static struct {
+	uint32_t reads;
+	size_t bytes_read, bytes_skipped;
+} partial_read_stats = {0};
+
+void IMB_partial_read_stats_get(ImPartialReadStats *r_stats)
+{
+	r_stats->reads = atomic_add_and_fetch_uint32(&partial_read_stats.reads, 0);
+	r_stats->bytes_read = atomic_add_and_fetch_z(&partial_read_stats.bytes_read, 0);
+	r_stats->bytes_skipped = atomic_add_and_fetch_z(&partial_read_stats.bytes_skipped, 0);
+}
+
+void IMB_partial_read_stats_reset(void)
+{
+	/* concurrent reads may be counted in either period */
+	atomic_fetch_and_and_uint32(&partial_read_stats.reads, 0);
+	atomic_sub_and_fetch_z(&partial_read_stats.bytes_read, atomic_add_and_fetch_z(&partial_read_stats.bytes_read, 0));
+	atomic_sub_and_fetch_z(&partial_read_stats.bytes_skipped, atomic_add_and_fetch_z(&partial_read_stats.bytes_skipped, 0));
+}
+
+ImBuf *IMB_loadiffname_partial(const char *filepath, int flags, char colorspace[IM_MAX_SPACE], ImPartialRead *partial)
+{
+	ImBuf *ibuf = NULL;
+	char effective_colorspace[IM_MAX_SPACE] = "";
+
+	BLI_assert(!BLI_path_is_rel(filepath));
+
+	if (colorspace)
+		BLI_strncpy(effective_colorspace, colorspace, sizeof(effective_colorspace));
+
+#ifdef WITH_OPENEXR
+	ibuf = imb_load_openexr_partial(filepath, flags, partial, effective_colorspace);
+#endif
+
+	if (ibuf == NULL)
+		ibuf = imb_load_partial_from_file(filepath, flags, partial, effective_colorspace);
+
+	if (ibuf) {
+		imb_handle_alpha(ibuf, flags, colorspace, effective_colorspace);
+		BLI_strncpy(ibuf->name, filepath, sizeof(ibuf->name));
+
+		atomic_add_and_fetch_uint32(&partial_read_stats.reads, 1);
+		atomic_add_and_fetch_z(&partial_read_stats.bytes_read, partial->bytes_read);
+		atomic_add_and_fetch_z(&partial_read_stats.bytes_skipped, partial->bytes_skipped);
+	}
+
+	return ibuf;
+}
+
 ImBuf *IMB_testiffname(const char *filepath, int flags)
 {
 	ImBuf *ibuf;
@@ -38,6 +38,7 @@
 #include "BLI_math_color.h"
 #include "BLI_math_color_blend.h"
 #include "BLI_math_vector.h"
+#include "BLI_rect.h"
 
 #include "IMB_imbuf_types.h"
 #include "IMB_imbuf.h"
@@ -931,3 +932,40 @@ void IMB_rectfill_alpha(ImBuf *ibuf, const float value)
 		for (i = ibuf->x * ibuf->y; i > 0; i--, cbuf += 4) { *cbuf = cvalue; }
 	}
 }
+
+/* dirty region, an empty rectangle means nothing changed */
+
+void IMB_dirty_rect_tag(ImBuf *ibuf, int xmin, int ymin, int xmax, int ymax)
+{
+	rcti rect;
+
+	BLI_rcti_init(&rect, max_ii(xmin, 0), min_ii(xmax, ibuf->x), max_ii(ymin, 0), min_ii(ymax, ibuf->y));
+
+	if (BLI_rcti_is_empty(&rect)) {
+		return;
+	}
+
+	IMB_generation_bump(ibuf);
+
+	if (BLI_rcti_is_empty(&ibuf->dirty_rect)) {
+		ibuf->dirty_rect = rect;
+	}
+	else {
+		BLI_rcti_union(&ibuf->dirty_rect, &rect);
+	}
+}
+
+bool IMB_dirty_rect_get(const ImBuf *ibuf, rcti *r_rect)
+{
+	if (BLI_rcti_is_empty(&ibuf->dirty_rect)) {
+		return false;
+	}
+
+	*r_rect = ibuf->dirty_rect;
+	return true;
+}
+
+void IMB_dirty_rect_clear(ImBuf *ibuf)
+{
+	BLI_rcti_init(&ibuf->dirty_rect, 0, 0, 0, 0);
+}
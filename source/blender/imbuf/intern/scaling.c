@@ -33,6 +33,7 @@
 
 
 #include "BLI_utildefines.h"
+#include "BLI_math_base.h"
 #include "BLI_math_color.h"
 #include "BLI_math_interp.h"
 #include "MEM_guardedalloc.h"
@@ -45,6 +46,13 @@
 
 #include "BLI_sys_types.h" // for intptr_t support
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+/* Smaller images are scaled on the calling thread. */
+#define SCALE_THREADED_MIN_PIXELS (256 * 256)
+
 /************************************************************************/
 /*								SCALING									*/
 /************************************************************************/
@@ -339,33 +347,24 @@ MINLINE void premul_ushort_to_straight_uchar(unsigned char *result, const unsign
 	}
 }
 
-/* result in ibuf2, scaling should be done correctly */
-void imb_onehalf_no_alloc(struct ImBuf *ibuf2, struct ImBuf *ibuf1)
+typedef struct OneHalfData {
+	ImBuf *ibuf1, *ibuf2;
+	bool do_rect, do_float;
+} OneHalfData;
+
+static void onehalf_rows(void *data_v, int start_line, int tot_line)
 {
+	OneHalfData *data = (OneHalfData *)data_v;
+	ImBuf *ibuf1 = data->ibuf1, *ibuf2 = data->ibuf2;
 	int x, y;
-	const short do_rect = (ibuf1->rect != NULL);
-	const short do_float = (ibuf1->rect_float != NULL) && (ibuf2->rect_float != NULL);
-
-	if (do_rect && (ibuf2->rect == NULL)) {
-		imb_addrectImBuf(ibuf2);
-	}
 
-	if (ibuf1->x <= 1) {
-		imb_half_y_no_alloc(ibuf2, ibuf1);
-		return;
-	}
-	if (ibuf1->y <= 1) {
-		imb_half_x_no_alloc(ibuf2, ibuf1);
-		return;
-	}
-	
-	if (do_rect) {
+	if (data->do_rect) {
 		unsigned char *cp1, *cp2, *dest;
 		
-		cp1 = (unsigned char *) ibuf1->rect;
-		dest = (unsigned char *) ibuf2->rect;
+		cp1 = (unsigned char *) ibuf1->rect + (size_t)start_line * 2 * (ibuf1->x << 2);
+		dest = (unsigned char *) ibuf2->rect + (size_t)start_line * (ibuf2->x << 2);
 		
-		for (y = ibuf2->y; y > 0; y--) {
+		for (y = tot_line; y > 0; y--) {
 			cp2 = cp1 + (ibuf1->x << 2);
 			for (x = ibuf2->x; x > 0; x--) {
 				unsigned short p1i[8], p2i[8], desti[4];
@@ -391,18 +390,27 @@ void imb_onehalf_no_alloc(struct ImBuf *ibuf2, struct ImBuf *ibuf1)
 		}
 	}
 	
-	if (do_float) {
+	if (data->do_float) {
 		float *p1f, *p2f, *destf;
+#ifdef __SSE2__
+		const __m128 quarter = _mm_set1_ps(0.25f);
+#endif
 		
-		p1f = ibuf1->rect_float;
-		destf = ibuf2->rect_float;
-		for (y = ibuf2->y; y > 0; y--) {
+		p1f = ibuf1->rect_float + (size_t)start_line * 2 * (ibuf1->x << 2);
+		destf = ibuf2->rect_float + (size_t)start_line * (ibuf2->x << 2);
+		for (y = tot_line; y > 0; y--) {
 			p2f = p1f + (ibuf1->x << 2);
 			for (x = ibuf2->x; x > 0; x--) {
+#ifdef __SSE2__
+				const __m128 sum1 = _mm_add_ps(_mm_loadu_ps(p1f), _mm_loadu_ps(p2f));
+				const __m128 sum2 = _mm_add_ps(_mm_loadu_ps(p1f + 4), _mm_loadu_ps(p2f + 4));
+				_mm_storeu_ps(destf, _mm_mul_ps(quarter, _mm_add_ps(sum1, sum2)));
+#else
 				destf[0] = 0.25f * (p1f[0] + p2f[0] + p1f[4] + p2f[4]);
 				destf[1] = 0.25f * (p1f[1] + p2f[1] + p1f[5] + p2f[5]);
 				destf[2] = 0.25f * (p1f[2] + p2f[2] + p1f[6] + p2f[6]);
 				destf[3] = 0.25f * (p1f[3] + p2f[3] + p1f[7] + p2f[7]);
+#endif
 				p1f += 8;
 				p2f += 8;
 				destf += 4;
@@ -413,6 +421,37 @@ void imb_onehalf_no_alloc(struct ImBuf *ibuf2, struct ImBuf *ibuf1)
 	}
 }
 
+/* result in ibuf2, scaling should be done correctly */
+void imb_onehalf_no_alloc(struct ImBuf *ibuf2, struct ImBuf *ibuf1)
+{
+	OneHalfData data;
+
+	data.ibuf1 = ibuf1;
+	data.ibuf2 = ibuf2;
+	data.do_rect = (ibuf1->rect != NULL);
+	data.do_float = (ibuf1->rect_float != NULL) && (ibuf2->rect_float != NULL);
+
+	if (data.do_rect && (ibuf2->rect == NULL)) {
+		imb_addrectImBuf(ibuf2);
+	}
+
+	if (ibuf1->x <= 1) {
+		imb_half_y_no_alloc(ibuf2, ibuf1);
+		return;
+	}
+	if (ibuf1->y <= 1) {
+		imb_half_x_no_alloc(ibuf2, ibuf1);
+		return;
+	}
+
+	if ((size_t)ibuf2->x * ibuf2->y < SCALE_THREADED_MIN_PIXELS) {
+		onehalf_rows(&data, 0, ibuf2->y);
+	}
+	else {
+		IMB_processor_apply_threaded_scanlines(ibuf2->y, onehalf_rows, &data);
+	}
+}
+
 ImBuf *IMB_onehalf(struct ImBuf *ibuf1)
 {
 	struct ImBuf *ibuf2;
@@ -881,673 +920,503 @@ static bool q_scale_linear_interpolation(
 	return true;
 }
 
-static ImBuf *scaledownx(struct ImBuf *ibuf, int newx)
+static void scalefast_Z_ImBuf(ImBuf *ibuf, int newx, int newy)
 {
-	const int do_rect = (ibuf->rect != NULL);
-	const int do_float = (ibuf->rect_float != NULL);
-	const size_t rect_size = ibuf->x * ibuf->y * 4;
-
-	uchar *rect, *_newrect, *newrect;
-	float *rectf, *_newrectf, *newrectf;
-	float sample, add, val[4], nval[4], valf[4], nvalf[4];
+	int *zbuf, *newzbuf, *_newzbuf = NULL;
+	float *zbuf_float, *newzbuf_float, *_newzbuf_float = NULL;
 	int x, y;
+	int ofsx, ofsy, stepx, stepy;
 
-	rectf = _newrectf = newrectf = NULL;
-	rect = _newrect = newrect = NULL;
-	nval[0] =  nval[1] = nval[2] = nval[3] = 0.0f;
-	nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
-
-	if (!do_rect && !do_float) return (ibuf);
-
-	if (do_rect) {
-		_newrect = MEM_mallocN(newx * ibuf->y * sizeof(uchar) * 4, "scaledownx");
-		if (_newrect == NULL) return(ibuf);
-	}
-	if (do_float) {
-		_newrectf = MEM_mallocN(newx * ibuf->y * sizeof(float) * 4, "scaledownxf");
-		if (_newrectf == NULL) {
-			if (_newrect) MEM_freeN(_newrect);
-			return(ibuf);
+	if (ibuf->zbuf) {
+		_newzbuf = MEM_mallocN(newx * newy * sizeof(int), __func__);
+		if (_newzbuf == NULL) {
+			IMB_freezbufImBuf(ibuf);
 		}
 	}
 
-	add = (ibuf->x - 0.01) / newx;
-
-	if (do_rect) {
-		rect = (uchar *) ibuf->rect;
-		newrect = _newrect;
+	if (ibuf->zbuf_float) {
+		_newzbuf_float = MEM_mallocN((size_t)newx * newy * sizeof(float), __func__);
+		if (_newzbuf_float == NULL) {
+			IMB_freezbuffloatImBuf(ibuf);
+		}
 	}
-	if (do_float) {
-		rectf = ibuf->rect_float;
-		newrectf = _newrectf;
+
+	if (!_newzbuf && !_newzbuf_float) {
+		return;
 	}
-		
-	for (y = ibuf->y; y > 0; y--) {
-		sample = 0.0f;
-		val[0] =  val[1] = val[2] = val[3] = 0.0f;
-		valf[0] = valf[1] = valf[2] = valf[3] = 0.0f;
 
-		for (x = newx; x > 0; x--) {
-			if (do_rect) {
-				nval[0] = -val[0] * sample;
-				nval[1] = -val[1] * sample;
-				nval[2] = -val[2] * sample;
-				nval[3] = -val[3] * sample;
-			}
-			if (do_float) {
-				nvalf[0] = -valf[0] * sample;
-				nvalf[1] = -valf[1] * sample;
-				nvalf[2] = -valf[2] * sample;
-				nvalf[3] = -valf[3] * sample;
-			}
-			
-			sample += add;
+	stepx = (65536.0 * (ibuf->x - 1.0) / (newx - 1.0)) + 0.5;
+	stepy = (65536.0 * (ibuf->y - 1.0) / (newy - 1.0)) + 0.5;
+	ofsy = 32768;
 
-			while (sample >= 1.0f) {
-				sample -= 1.0f;
-				
-				if (do_rect) {
-					nval[0] += rect[0];
-					nval[1] += rect[1];
-					nval[2] += rect[2];
-					nval[3] += rect[3];
-					rect += 4;
-				}
-				if (do_float) {
-					nvalf[0] += rectf[0];
-					nvalf[1] += rectf[1];
-					nvalf[2] += rectf[2];
-					nvalf[3] += rectf[3];
-					rectf += 4;
-				}
-			}
-			
-			if (do_rect) {
-				val[0] = rect[0]; val[1] = rect[1]; val[2] = rect[2]; val[3] = rect[3];
-				rect += 4;
-				
-				newrect[0] = ((nval[0] + sample * val[0]) / add + 0.5f);
-				newrect[1] = ((nval[1] + sample * val[1]) / add + 0.5f);
-				newrect[2] = ((nval[2] + sample * val[2]) / add + 0.5f);
-				newrect[3] = ((nval[3] + sample * val[3]) / add + 0.5f);
-				
-				newrect += 4;
+	newzbuf = _newzbuf;
+	newzbuf_float = _newzbuf_float;
+
+	for (y = newy; y > 0; y--, ofsy += stepy) {
+		if (newzbuf) {
+			zbuf = ibuf->zbuf;
+			zbuf += (ofsy >> 16) * ibuf->x;
+			ofsx = 32768;
+			for (x = newx; x > 0; x--, ofsx += stepx) {
+				*newzbuf++ = zbuf[ofsx >> 16];
 			}
-			if (do_float) {
-				
-				valf[0] = rectf[0]; valf[1] = rectf[1]; valf[2] = rectf[2]; valf[3] = rectf[3];
-				rectf += 4;
-				
-				newrectf[0] = ((nvalf[0] + sample * valf[0]) / add);
-				newrectf[1] = ((nvalf[1] + sample * valf[1]) / add);
-				newrectf[2] = ((nvalf[2] + sample * valf[2]) / add);
-				newrectf[3] = ((nvalf[3] + sample * valf[3]) / add);
-				
-				newrectf += 4;
+		}
+
+		if (newzbuf_float) {
+			zbuf_float = ibuf->zbuf_float;
+			zbuf_float += (ofsy >> 16) * ibuf->x;
+			ofsx = 32768;
+			for (x = newx; x > 0; x--, ofsx += stepx) {
+				*newzbuf_float++ = zbuf_float[ofsx >> 16];
 			}
-			
-			sample -= 1.0f;
 		}
 	}
 
-	if (do_rect) {
-		// printf("%ld %ld\n", (uchar *)rect - ((uchar *)ibuf->rect), rect_size);
-		BLI_assert((uchar *)rect - ((uchar *)ibuf->rect) == rect_size); /* see bug [#26502] */
-		imb_freerectImBuf(ibuf);
-		ibuf->mall |= IB_rect;
-		ibuf->rect = (unsigned int *) _newrect;
+	if (_newzbuf) {
+		IMB_freezbufImBuf(ibuf);
+		ibuf->mall |= IB_zbuf;
+		ibuf->zbuf = _newzbuf;
 	}
-	if (do_float) {
-		// printf("%ld %ld\n", rectf - ibuf->rect_float, rect_size);
-		BLI_assert((rectf - ibuf->rect_float) == rect_size); /* see bug [#26502] */
-		imb_freerectfloatImBuf(ibuf);
-		ibuf->mall |= IB_rectfloat;
-		ibuf->rect_float = _newrectf;
+
+	if (_newzbuf_float) {
+		IMB_freezbuffloatImBuf(ibuf);
+		ibuf->mall |= IB_zbuffloat;
+		ibuf->zbuf_float = _newzbuf_float;
 	}
-	(void)rect_size; /* UNUSED in release builds */
-	
-	ibuf->x = newx;
-	return(ibuf);
 }
 
+/* ******** polyphase resampling ******** */
+
+/* Weights of the source pixels contributing to each destination pixel along one axis.
+ * Every destination pixel reads the same number of contiguous taps so the inner loops
+ * don't branch, taps outside of the image are folded into the edge pixels. */
+typedef struct ScaleFilterAxis {
+	int taps;
+	int *start;
+	float *weights;
+} ScaleFilterAxis;
+
+typedef struct ScaleFilterData {
+	int width, height;
+	int newx, newy;
+	int channels;
+
+	const unsigned char *in_byte;
+	const float *in_float;
+
+	/* source rows filtered horizontally, newx * height pixels */
+	float *temp;
 
-static ImBuf *scaledowny(struct ImBuf *ibuf, int newy)
+	unsigned char *out_byte;
+	float *out_float;
+
+	ScaleFilterAxis axis_x, axis_y;
+} ScaleFilterData;
+
+static float scale_filter_radius(eIMBScaleFilter filter)
 {
-	const int do_rect = (ibuf->rect != NULL);
-	const int do_float = (ibuf->rect_float != NULL);
-	const size_t rect_size = ibuf->x * ibuf->y * 4;
-
-	uchar *rect, *_newrect, *newrect;
-	float *rectf, *_newrectf, *newrectf;
-	float sample, add, val[4], nval[4], valf[4], nvalf[4];
-	int x, y, skipx;
-
-	rectf = _newrectf = newrectf = NULL;
-	rect = _newrect = newrect = NULL;
-	nval[0] =  nval[1] = nval[2] = nval[3] = 0.0f;
-	nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
-
-	if (!do_rect && !do_float) return (ibuf);
-
-	if (do_rect) {
-		_newrect = MEM_mallocN(newy * ibuf->x * sizeof(uchar) * 4, "scaledowny");
-		if (_newrect == NULL) return(ibuf);
-	}
-	if (do_float) {
-		_newrectf = MEM_mallocN(newy * ibuf->x * sizeof(float) * 4, "scaledownyf");
-		if (_newrectf == NULL) {
-			if (_newrect) MEM_freeN(_newrect);
-			return(ibuf);
-		}
+	switch (filter) {
+		case IMB_SCALE_FILTER_BILINEAR:
+			return 1.0f;
+		case IMB_SCALE_FILTER_LANCZOS:
+			return 3.0f;
+		default:
+			return 0.5f;
 	}
+}
 
-	add = (ibuf->y - 0.01) / newy;
-	skipx = 4 * ibuf->x;
+/* x is the distance to the destination pixel center, in destination pixels when downscaling */
+static float scale_filter_weight(eIMBScaleFilter filter, float x)
+{
+	x = fabsf(x);
 
-	for (x = skipx - 4; x >= 0; x -= 4) {
-		if (do_rect) {
-			rect = ((uchar *) ibuf->rect) + x;
-			newrect = _newrect + x;
+	if (filter == IMB_SCALE_FILTER_LANCZOS) {
+		if (x < 1e-5f) {
+			return 1.0f;
 		}
-		if (do_float) {
-			rectf = ibuf->rect_float + x;
-			newrectf = _newrectf + x;
+		else if (x < 3.0f) {
+			const float px = (float)M_PI * x;
+			return 3.0f * sinf(px) * sinf(px / 3.0f) / (px * px);
 		}
-		
-		sample = 0.0f;
-		val[0] =  val[1] = val[2] = val[3] = 0.0f;
-		valf[0] = valf[1] = valf[2] = valf[3] = 0.0f;
+		return 0.0f;
+	}
 
-		for (y = newy; y > 0; y--) {
-			if (do_rect) {
-				nval[0] = -val[0] * sample;
-				nval[1] = -val[1] * sample;
-				nval[2] = -val[2] * sample;
-				nval[3] = -val[3] * sample;
+	return (x < 1.0f) ? 1.0f - x : 0.0f;
+}
+
+static void scale_filter_axis_init(ScaleFilterAxis *axis, eIMBScaleFilter filter, int in_size, int out_size)
+{
+	const float scale = (float)in_size / (float)out_size;
+	const float support = max_ff(scale, 1.0f);
+	const float radius = scale_filter_radius(filter) * support;
+	const int span = (int)ceilf(2.0f * radius) + 2;
+	int i;
+
+	axis->taps = min_ii(span, in_size);
+	axis->start = MEM_mallocN(sizeof(int) * out_size, "scale filter start");
+	axis->weights = MEM_callocN(sizeof(float) * out_size * axis->taps, "scale filter weights");
+
+	for (i = 0; i < out_size; i++) {
+		float *weights = axis->weights + (size_t)i * axis->taps;
+		/* in source pixels, where pixel j covers [j, j + 1] */
+		const float center = (i + 0.5f) * scale;
+		const int first = (int)floorf(center - radius);
+		const int start = CLAMPIS(first, 0, in_size - axis->taps);
+		float total = 0.0f;
+		int j;
+
+		for (j = first; j < first + span; j++) {
+			float weight;
+
+			if (filter == IMB_SCALE_FILTER_BOX) {
+				/* area of the source pixel covered by the destination pixel */
+				weight = max_ff(min_ff(j + 1.0f, center + 0.5f * scale) - max_ff(j, center - 0.5f * scale), 0.0f);
 			}
-			if (do_float) {
-				nvalf[0] = -valf[0] * sample;
-				nvalf[1] = -valf[1] * sample;
-				nvalf[2] = -valf[2] * sample;
-				nvalf[3] = -valf[3] * sample;
+			else {
+				weight = scale_filter_weight(filter, (j + 0.5f - center) / support);
 			}
-			
-			sample += add;
 
-			while (sample >= 1.0f) {
-				sample -= 1.0f;
-				
-				if (do_rect) {
-					nval[0] += rect[0];
-					nval[1] += rect[1];
-					nval[2] += rect[2];
-					nval[3] += rect[3];
-					rect += skipx;
-				}
-				if (do_float) {
-					nvalf[0] += rectf[0];
-					nvalf[1] += rectf[1];
-					nvalf[2] += rectf[2];
-					nvalf[3] += rectf[3];
-					rectf += skipx;
-				}
+			if (weight != 0.0f) {
+				weights[CLAMPIS(j, 0, in_size - 1) - start] += weight;
+				total += weight;
 			}
+		}
 
-			if (do_rect) {
-				val[0] = rect[0]; val[1] = rect[1]; val[2] = rect[2]; val[3] = rect[3];
-				rect += skipx;
-				
-				newrect[0] = ((nval[0] + sample * val[0]) / add + 0.5f);
-				newrect[1] = ((nval[1] + sample * val[1]) / add + 0.5f);
-				newrect[2] = ((nval[2] + sample * val[2]) / add + 0.5f);
-				newrect[3] = ((nval[3] + sample * val[3]) / add + 0.5f);
-				
-				newrect += skipx;
-			}
-			if (do_float) {
-				
-				valf[0] = rectf[0]; valf[1] = rectf[1]; valf[2] = rectf[2]; valf[3] = rectf[3];
-				rectf += skipx;
-				
-				newrectf[0] = ((nvalf[0] + sample * valf[0]) / add);
-				newrectf[1] = ((nvalf[1] + sample * valf[1]) / add);
-				newrectf[2] = ((nvalf[2] + sample * valf[2]) / add);
-				newrectf[3] = ((nvalf[3] + sample * valf[3]) / add);
-				
-				newrectf += skipx;
+		if (total != 0.0f) {
+			for (j = 0; j < axis->taps; j++) {
+				weights[j] /= total;
 			}
-			
-			sample -= 1.0f;
 		}
-	}
+		else {
+			weights[CLAMPIS((int)center, 0, in_size - 1) - start] = 1.0f;
+		}
 
-	if (do_rect) {
-		// printf("%ld %ld\n", (uchar *)rect - ((uchar *)ibuf->rect), rect_size);
-		BLI_assert((uchar *)rect - ((uchar *)ibuf->rect) == rect_size); /* see bug [#26502] */
-		imb_freerectImBuf(ibuf);
-		ibuf->mall |= IB_rect;
-		ibuf->rect = (unsigned int *) _newrect;
-	}
-	if (do_float) {
-		// printf("%ld %ld\n", rectf - ibuf->rect_float, rect_size);
-		BLI_assert((rectf - ibuf->rect_float) == rect_size); /* see bug [#26502] */
-		imb_freerectfloatImBuf(ibuf);
-		ibuf->mall |= IB_rectfloat;
-		ibuf->rect_float = (float *) _newrectf;
+		axis->start[i] = start;
 	}
-	(void)rect_size; /* UNUSED in release builds */
-	
-	ibuf->y = newy;
-	return(ibuf);
 }
 
+static void scale_filter_axis_free(ScaleFilterAxis *axis)
+{
+	MEM_freeN(axis->start);
+	MEM_freeN(axis->weights);
+}
 
-static ImBuf *scaleupx(struct ImBuf *ibuf, int newx)
+static void scale_byte_row_to_float(float *out, const unsigned char *in, int width)
 {
-	uchar *rect, *_newrect = NULL, *newrect;
-	float *rectf, *_newrectf = NULL, *newrectf;
-	float sample, add;
-	float val_a, nval_a, diff_a;
-	float val_b, nval_b, diff_b;
-	float val_g, nval_g, diff_g;
-	float val_r, nval_r, diff_r;
-	float val_af, nval_af, diff_af;
-	float val_bf, nval_bf, diff_bf;
-	float val_gf, nval_gf, diff_gf;
-	float val_rf, nval_rf, diff_rf;
-	int x, y;
-	bool do_rect = false, do_float = false;
+	size_t i = 0;
+	const size_t len = (size_t)width * 4;
 
-	val_a = nval_a = diff_a = val_b = nval_b = diff_b = 0;
-	val_g = nval_g = diff_g = val_r = nval_r = diff_r = 0;
-	val_af = nval_af = diff_af = val_bf = nval_bf = diff_bf = 0;
-	val_gf = nval_gf = diff_gf = val_rf = nval_rf = diff_rf = 0;
-	if (ibuf == NULL) return(NULL);
-	if (ibuf->rect == NULL && ibuf->rect_float == NULL) return (ibuf);
+#ifdef __SSE2__
+	const __m128i zero = _mm_setzero_si128();
 
-	if (ibuf->rect) {
-		do_rect = true;
-		_newrect = MEM_mallocN(newx * ibuf->y * sizeof(int), "scaleupx");
-		if (_newrect == NULL) return(ibuf);
+	for (; i + 16 <= len; i += 16) {
+		const __m128i bytes = _mm_loadu_si128((const __m128i *)(in + i));
+		const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+		const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+
+		_mm_storeu_ps(out + i,      _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)));
+		_mm_storeu_ps(out + i + 4,  _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)));
+		_mm_storeu_ps(out + i + 8,  _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)));
+		_mm_storeu_ps(out + i + 12, _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)));
 	}
-	if (ibuf->rect_float) {
-		do_float = true;
-		_newrectf = MEM_mallocN(newx * ibuf->y * sizeof(float) * 4, "scaleupxf");
-		if (_newrectf == NULL) {
-			if (_newrect) MEM_freeN(_newrect);
-			return(ibuf);
-		}
+#endif
+
+	for (; i < len; i++) {
+		out[i] = in[i];
 	}
+}
 
-	add = (ibuf->x - 1.001) / (newx - 1.0);
+static void scale_float_row_to_byte(unsigned char *out, const float *in, size_t len)
+{
+	size_t i = 0;
 
-	rect = (uchar *) ibuf->rect;
-	rectf = (float *) ibuf->rect_float;
-	newrect = _newrect;
-	newrectf = _newrectf;
+#ifdef __SSE2__
+	for (; i + 16 <= len; i += 16) {
+		const __m128i a = _mm_cvtps_epi32(_mm_loadu_ps(in + i));
+		const __m128i b = _mm_cvtps_epi32(_mm_loadu_ps(in + i + 4));
+		const __m128i c = _mm_cvtps_epi32(_mm_loadu_ps(in + i + 8));
+		const __m128i d = _mm_cvtps_epi32(_mm_loadu_ps(in + i + 12));
 
-	for (y = ibuf->y; y > 0; y--) {
+		/* saturating packs clamp to [0, 255] */
+		_mm_storeu_si128((__m128i *)(out + i), _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+	}
+#endif
 
-		sample = 0;
-		
-		if (do_rect) {
-			val_a = rect[0];
-			nval_a = rect[4];
-			diff_a = nval_a - val_a;
-			val_a += 0.5f;
-
-			val_b = rect[1];
-			nval_b = rect[5];
-			diff_b = nval_b - val_b;
-			val_b += 0.5f;
-
-			val_g = rect[2];
-			nval_g = rect[6];
-			diff_g = nval_g - val_g;
-			val_g += 0.5f;
-
-			val_r = rect[3];
-			nval_r = rect[7];
-			diff_r = nval_r - val_r;
-			val_r += 0.5f;
-
-			rect += 8;
-		}
-		if (do_float) {
-			val_af = rectf[0];
-			nval_af = rectf[4];
-			diff_af = nval_af - val_af;
-	
-			val_bf = rectf[1];
-			nval_bf = rectf[5];
-			diff_bf = nval_bf - val_bf;
+	for (; i < len; i++) {
+		const int value = (int)floorf(in[i] + 0.5f);
+		out[i] = (unsigned char)CLAMPIS(value, 0, 255);
+	}
+}
 
-			val_gf = rectf[2];
-			nval_gf = rectf[6];
-			diff_gf = nval_gf - val_gf;
+/* out = in * weight, or out += in * weight when accumulating */
+static void scale_row_madd(float *out, const float *in, float weight, size_t len, bool accumulate)
+{
+	size_t i = 0;
 
-			val_rf = rectf[3];
-			nval_rf = rectf[7];
-			diff_rf = nval_rf - val_rf;
+#ifdef __SSE2__
+	const __m128 w = _mm_set1_ps(weight);
 
-			rectf += 8;
+	if (accumulate) {
+		for (; i + 4 <= len; i += 4) {
+			_mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(w, _mm_loadu_ps(in + i))));
 		}
-		for (x = newx; x > 0; x--) {
-			if (sample >= 1.0f) {
-				sample -= 1.0f;
-
-				if (do_rect) {
-					val_a = nval_a;
-					nval_a = rect[0];
-					diff_a = nval_a - val_a;
-					val_a += 0.5f;
-
-					val_b = nval_b;
-					nval_b = rect[1];
-					diff_b = nval_b - val_b;
-					val_b += 0.5f;
-
-					val_g = nval_g;
-					nval_g = rect[2];
-					diff_g = nval_g - val_g;
-					val_g += 0.5f;
-
-					val_r = nval_r;
-					nval_r = rect[3];
-					diff_r = nval_r - val_r;
-					val_r += 0.5f;
-					rect += 4;
-				}
-				if (do_float) {
-					val_af = nval_af;
-					nval_af = rectf[0];
-					diff_af = nval_af - val_af;
-	
-					val_bf = nval_bf;
-					nval_bf = rectf[1];
-					diff_bf = nval_bf - val_bf;
-
-					val_gf = nval_gf;
-					nval_gf = rectf[2];
-					diff_gf = nval_gf - val_gf;
-
-					val_rf = nval_rf;
-					nval_rf = rectf[3];
-					diff_rf = nval_rf - val_rf;
-					rectf += 4;
-				}
-			}
-			if (do_rect) {
-				newrect[0] = val_a + sample * diff_a;
-				newrect[1] = val_b + sample * diff_b;
-				newrect[2] = val_g + sample * diff_g;
-				newrect[3] = val_r + sample * diff_r;
-				newrect += 4;
-			}
-			if (do_float) {
-				newrectf[0] = val_af + sample * diff_af;
-				newrectf[1] = val_bf + sample * diff_bf;
-				newrectf[2] = val_gf + sample * diff_gf;
-				newrectf[3] = val_rf + sample * diff_rf;
-				newrectf += 4;
-			}
-			sample += add;
+	}
+	else {
+		for (; i + 4 <= len; i += 4) {
+			_mm_storeu_ps(out + i, _mm_mul_ps(w, _mm_loadu_ps(in + i)));
 		}
 	}
+#endif
 
-	if (do_rect) {
-		imb_freerectImBuf(ibuf);
-		ibuf->mall |= IB_rect;
-		ibuf->rect = (unsigned int *) _newrect;
+	if (accumulate) {
+		for (; i < len; i++) {
+			out[i] += in[i] * weight;
+		}
 	}
-	if (do_float) {
-		imb_freerectfloatImBuf(ibuf);
-		ibuf->mall |= IB_rectfloat;
-		ibuf->rect_float = (float *) _newrectf;
+	else {
+		for (; i < len; i++) {
+			out[i] = in[i] * weight;
+		}
 	}
-	
-	ibuf->x = newx;
-	return(ibuf);
 }
 
-static ImBuf *scaleupy(struct ImBuf *ibuf, int newy)
+#ifdef __SSE2__
+MINLINE __m128 scale_load_byte_pixel(const unsigned char *pixel)
 {
-	uchar *rect, *_newrect = NULL, *newrect;
-	float *rectf, *_newrectf = NULL, *newrectf;
-	float sample, add;
-	float val_a, nval_a, diff_a;
-	float val_b, nval_b, diff_b;
-	float val_g, nval_g, diff_g;
-	float val_r, nval_r, diff_r;
-	float val_af, nval_af, diff_af;
-	float val_bf, nval_bf, diff_bf;
-	float val_gf, nval_gf, diff_gf;
-	float val_rf, nval_rf, diff_rf;
-	int x, y, skipx;
-	bool do_rect = false, do_float = false;
-
-	val_a = nval_a = diff_a = val_b = nval_b = diff_b = 0;
-	val_g = nval_g = diff_g = val_r = nval_r = diff_r = 0;
-	val_af = nval_af = diff_af = val_bf = nval_bf = diff_bf = 0;
-	val_gf = nval_gf = diff_gf = val_rf = nval_rf = diff_rf = 0;
-	if (ibuf == NULL) return(NULL);
-	if (ibuf->rect == NULL && ibuf->rect_float == NULL) return (ibuf);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bytes = _mm_cvtsi32_si128(*(const int *)pixel);
 
-	if (ibuf->rect) {
-		do_rect = true;
-		_newrect = MEM_mallocN(ibuf->x * newy * sizeof(int), "scaleupy");
-		if (_newrect == NULL) return(ibuf);
+	return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+}
+
+/* two accumulators to hide the latency of the additions over the taps */
+MINLINE void scale_filter_pixel_byte(float out[4], const unsigned char *pixel, const float *weights, int taps)
+{
+	__m128 accum1 = _mm_setzero_ps(), accum2 = _mm_setzero_ps();
+	int k;
+
+	for (k = 0; k + 2 <= taps; k += 2, pixel += 8) {
+		accum1 = _mm_add_ps(accum1, _mm_mul_ps(_mm_set1_ps(weights[k]), scale_load_byte_pixel(pixel)));
+		accum2 = _mm_add_ps(accum2, _mm_mul_ps(_mm_set1_ps(weights[k + 1]), scale_load_byte_pixel(pixel + 4)));
 	}
-	if (ibuf->rect_float) {
-		do_float = true;
-		_newrectf = MEM_mallocN(ibuf->x * newy * sizeof(float) * 4, "scaleupyf");
-		if (_newrectf == NULL) {
-			if (_newrect) MEM_freeN(_newrect);
-			return(ibuf);
-		}
+	if (k < taps) {
+		accum1 = _mm_add_ps(accum1, _mm_mul_ps(_mm_set1_ps(weights[k]), scale_load_byte_pixel(pixel)));
 	}
 
-	add = (ibuf->y - 1.001) / (newy - 1.0);
-	skipx = 4 * ibuf->x;
-
-	rect = (uchar *) ibuf->rect;
-	rectf = (float *) ibuf->rect_float;
-	newrect = _newrect;
-	newrectf = _newrectf;
+	_mm_storeu_ps(out, _mm_add_ps(accum1, accum2));
+}
 
-	for (x = ibuf->x; x > 0; x--) {
+MINLINE void scale_filter_pixel_float(float out[4], const float *pixel, const float *weights, int taps)
+{
+	__m128 accum1 = _mm_setzero_ps(), accum2 = _mm_setzero_ps();
+	int k;
 
-		sample = 0;
-		if (do_rect) {
-			rect = ((uchar *)ibuf->rect) + 4 * (x - 1);
-			newrect = _newrect + 4 * (x - 1);
-
-			val_a = rect[0];
-			nval_a = rect[skipx];
-			diff_a = nval_a - val_a;
-			val_a += 0.5f;
-
-			val_b = rect[1];
-			nval_b = rect[skipx + 1];
-			diff_b = nval_b - val_b;
-			val_b += 0.5f;
-
-			val_g = rect[2];
-			nval_g = rect[skipx + 2];
-			diff_g = nval_g - val_g;
-			val_g += 0.5f;
-
-			val_r = rect[3];
-			nval_r = rect[skipx + 3];
-			diff_r = nval_r - val_r;
-			val_r += 0.5f;
-
-			rect += 2 * skipx;
-		}
-		if (do_float) {
-			rectf = ibuf->rect_float + 4 * (x - 1);
-			newrectf = _newrectf + 4 * (x - 1);
+	for (k = 0; k + 2 <= taps; k += 2, pixel += 8) {
+		accum1 = _mm_add_ps(accum1, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(pixel)));
+		accum2 = _mm_add_ps(accum2, _mm_mul_ps(_mm_set1_ps(weights[k + 1]), _mm_loadu_ps(pixel + 4)));
+	}
+	if (k < taps) {
+		accum1 = _mm_add_ps(accum1, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(pixel)));
+	}
 
-			val_af = rectf[0];
-			nval_af = rectf[skipx];
-			diff_af = nval_af - val_af;
-	
-			val_bf = rectf[1];
-			nval_bf = rectf[skipx + 1];
-			diff_bf = nval_bf - val_bf;
+	_mm_storeu_ps(out, _mm_add_ps(accum1, accum2));
+}
+#endif
 
-			val_gf = rectf[2];
-			nval_gf = rectf[skipx + 2];
-			diff_gf = nval_gf - val_gf;
+static void scale_filter_rows_x(void *data_v, int start_line, int tot_line)
+{
+	ScaleFilterData *data = (ScaleFilterData *)data_v;
+	const ScaleFilterAxis *axis = &data->axis_x;
+	const int channels = data->channels;
+	const int taps = axis->taps;
+	float *row = NULL;
+	int y;
+
+#ifdef __SSE2__
+	/* when downscaling every source pixel is read about once, convert the bytes as they are
+	 * read instead of converting the whole row first */
+	const bool read_byte = data->in_byte && (size_t)data->newx * taps < (size_t)data->width * 2;
+#else
+	const bool read_byte = false;
+#endif
+
+	if (data->in_byte && !read_byte) {
+		row = MEM_mallocN(sizeof(float) * 4 * data->width, "scale filter row");
+	}
 
-			val_rf = rectf[3];
-			nval_rf = rectf[skipx + 3];
-			diff_rf = nval_rf - val_rf;
+	for (y = start_line; y < start_line + tot_line; y++) {
+		const float *in = NULL;
+		float *out = data->temp + (size_t)y * data->newx * channels;
+		int x, k, c;
 
-			rectf += 2 * skipx;
+		if (read_byte) {
+			/* pass */
 		}
-		
-		for (y = newy; y > 0; y--) {
-			if (sample >= 1.0f) {
-				sample -= 1.0f;
-
-				if (do_rect) {
-					val_a = nval_a;
-					nval_a = rect[0];
-					diff_a = nval_a - val_a;
-					val_a += 0.5f;
-
-					val_b = nval_b;
-					nval_b = rect[1];
-					diff_b = nval_b - val_b;
-					val_b += 0.5f;
-
-					val_g = nval_g;
-					nval_g = rect[2];
-					diff_g = nval_g - val_g;
-					val_g += 0.5f;
-
-					val_r = nval_r;
-					nval_r = rect[3];
-					diff_r = nval_r - val_r;
-					val_r += 0.5f;
-					rect += skipx;
-				}
-				if (do_float) {
-					val_af = nval_af;
-					nval_af = rectf[0];
-					diff_af = nval_af - val_af;
-	
-					val_bf = nval_bf;
-					nval_bf = rectf[1];
-					diff_bf = nval_bf - val_bf;
-
-					val_gf = nval_gf;
-					nval_gf = rectf[2];
-					diff_gf = nval_gf - val_gf;
-
-					val_rf = nval_rf;
-					nval_rf = rectf[3];
-					diff_rf = nval_rf - val_rf;
-					rectf += skipx;
-				}
+		else if (data->in_byte) {
+			scale_byte_row_to_float(row, data->in_byte + (size_t)y * data->width * 4, data->width);
+			in = row;
+		}
+		else {
+			in = data->in_float + (size_t)y * data->width * channels;
+		}
+
+		for (x = 0; x < data->newx; x++, out += channels) {
+			const float *weights = axis->weights + (size_t)x * taps;
+			const float *pixel;
+
+#ifdef __SSE2__
+			if (read_byte) {
+				scale_filter_pixel_byte(out, data->in_byte + ((size_t)y * data->width + axis->start[x]) * 4,
+				                        weights, taps);
+				continue;
 			}
-			if (do_rect) {
-				newrect[0] = val_a + sample * diff_a;
-				newrect[1] = val_b + sample * diff_b;
-				newrect[2] = val_g + sample * diff_g;
-				newrect[3] = val_r + sample * diff_r;
-				newrect += skipx;
+			else if (channels == 4) {
+				scale_filter_pixel_float(out, in + (size_t)axis->start[x] * 4, weights, taps);
+				continue;
 			}
-			if (do_float) {
-				newrectf[0] = val_af + sample * diff_af;
-				newrectf[1] = val_bf + sample * diff_bf;
-				newrectf[2] = val_gf + sample * diff_gf;
-				newrectf[3] = val_rf + sample * diff_rf;
-				newrectf += skipx;
+#endif
+
+			pixel = in + (size_t)axis->start[x] * channels;
+			for (c = 0; c < channels; c++) {
+				out[c] = 0.0f;
+			}
+			for (k = 0; k < taps; k++, pixel += channels) {
+				for (c = 0; c < channels; c++) {
+					out[c] += weights[k] * pixel[c];
+				}
 			}
-			sample += add;
 		}
 	}
 
-	if (do_rect) {
-		imb_freerectImBuf(ibuf);
-		ibuf->mall |= IB_rect;
-		ibuf->rect = (unsigned int *) _newrect;
+	if (row) {
+		MEM_freeN(row);
 	}
-	if (do_float) {
-		imb_freerectfloatImBuf(ibuf);
-		ibuf->mall |= IB_rectfloat;
-		ibuf->rect_float = (float *) _newrectf;
-	}
-	
-	ibuf->y = newy;
-	return(ibuf);
 }
 
-static void scalefast_Z_ImBuf(ImBuf *ibuf, int newx, int newy)
+static void scale_filter_rows_y(void *data_v, int start_line, int tot_line)
 {
-	int *zbuf, *newzbuf, *_newzbuf = NULL;
-	float *zbuf_float, *newzbuf_float, *_newzbuf_float = NULL;
-	int x, y;
-	int ofsx, ofsy, stepx, stepy;
+	ScaleFilterData *data = (ScaleFilterData *)data_v;
+	const ScaleFilterAxis *axis = &data->axis_y;
+	const size_t row_len = (size_t)data->newx * data->channels;
+	float *accum = NULL;
+	int y, k;
+
+	if (data->out_byte) {
+		accum = MEM_mallocN(sizeof(float) * row_len, "scale filter row");
+	}
 
-	if (ibuf->zbuf) {
-		_newzbuf = MEM_mallocN(newx * newy * sizeof(int), __func__);
-		if (_newzbuf == NULL) {
-			IMB_freezbufImBuf(ibuf);
+	for (y = start_line; y < start_line + tot_line; y++) {
+		const float *weights = axis->weights + (size_t)y * axis->taps;
+		const float *in = data->temp + (size_t)axis->start[y] * row_len;
+		float *out = (data->out_byte) ? accum : data->out_float + (size_t)y * row_len;
+
+		scale_row_madd(out, in, weights[0], row_len, false);
+
+		for (k = 1; k < axis->taps; k++) {
+			in += row_len;
+			if (weights[k] != 0.0f) {
+				scale_row_madd(out, in, weights[k], row_len, true);
+			}
 		}
-	}
 
-	if (ibuf->zbuf_float) {
-		_newzbuf_float = MEM_mallocN((size_t)newx * newy * sizeof(float), __func__);
-		if (_newzbuf_float == NULL) {
-			IMB_freezbuffloatImBuf(ibuf);
+		if (data->out_byte) {
+			scale_float_row_to_byte(data->out_byte + (size_t)y * row_len, accum, row_len);
 		}
 	}
 
-	if (!_newzbuf && !_newzbuf_float) {
-		return;
+	if (accum) {
+		MEM_freeN(accum);
 	}
+}
 
-	stepx = (65536.0 * (ibuf->x - 1.0) / (newx - 1.0)) + 0.5;
-	stepy = (65536.0 * (ibuf->y - 1.0) / (newy - 1.0)) + 0.5;
-	ofsy = 32768;
+static void scale_filter_apply(ScaleFilterData *data)
+{
+	if ((size_t)data->width * data->height < SCALE_THREADED_MIN_PIXELS &&
+	    (size_t)data->newx * data->newy < SCALE_THREADED_MIN_PIXELS)
+	{
+		scale_filter_rows_x(data, 0, data->height);
+		scale_filter_rows_y(data, 0, data->newy);
+	}
+	else {
+		IMB_processor_apply_threaded_scanlines(data->height, scale_filter_rows_x, data);
+		IMB_processor_apply_threaded_scanlines(data->newy, scale_filter_rows_y, data);
+	}
+}
 
-	newzbuf = _newzbuf;
-	newzbuf_float = _newzbuf_float;
+/* Byte buffers are filtered with straight alpha, like the scaling functions above. */
+static bool scale_filter_imbuf(ImBuf *ibuf, int newx, int newy,
+                               eIMBScaleFilter filter_x, eIMBScaleFilter filter_y)
+{
+	ScaleFilterData data = {0};
+	unsigned char *newrect = NULL;
+	float *newrectf = NULL;
 
-	for (y = newy; y > 0; y--, ofsy += stepy) {
-		if (newzbuf) {
-			zbuf = ibuf->zbuf;
-			zbuf += (ofsy >> 16) * ibuf->x;
-			ofsx = 32768;
-			for (x = newx; x > 0; x--, ofsx += stepx) {
-				*newzbuf++ = zbuf[ofsx >> 16];
-			}
-		}
+	if (ibuf == NULL) return false;
+	if (ibuf->rect == NULL && ibuf->rect_float == NULL) return false;
+	if (newx <= 0 || newy <= 0) return false;
+	if (newx == ibuf->x && newy == ibuf->y) return false;
 
-		if (newzbuf_float) {
-			zbuf_float = ibuf->zbuf_float;
-			zbuf_float += (ofsy >> 16) * ibuf->x;
-			ofsx = 32768;
-			for (x = newx; x > 0; x--, ofsx += stepx) {
-				*newzbuf_float++ = zbuf_float[ofsx >> 16];
-			}
-		}
+	if (ibuf->rect) {
+		newrect = MEM_mallocN((size_t)newx * newy * 4, "scale filter byte");
+	}
+	if (ibuf->rect_float) {
+		newrectf = MEM_mallocN((size_t)newx * newy * ibuf->channels * sizeof(float), "scale filter float");
 	}
 
-	if (_newzbuf) {
-		IMB_freezbufImBuf(ibuf);
-		ibuf->mall |= IB_zbuf;
-		ibuf->zbuf = _newzbuf;
+	data.width = ibuf->x;
+	data.height = ibuf->y;
+	data.newx = newx;
+	data.newy = newy;
+	data.temp = MEM_mallocN((size_t)newx * ibuf->y * max_ii(ibuf->channels, 4) * sizeof(float), "scale filter temp");
+
+	scale_filter_axis_init(&data.axis_x, filter_x, ibuf->x, newx);
+	scale_filter_axis_init(&data.axis_y, filter_y, ibuf->y, newy);
+
+	if (newrect) {
+		data.channels = 4;
+		data.in_byte = (unsigned char *)ibuf->rect;
+		data.out_byte = newrect;
+		scale_filter_apply(&data);
+		data.in_byte = data.out_byte = NULL;
 	}
 
-	if (_newzbuf_float) {
-		IMB_freezbuffloatImBuf(ibuf);
-		ibuf->mall |= IB_zbuffloat;
-		ibuf->zbuf_float = _newzbuf_float;
+	if (newrectf) {
+		data.channels = ibuf->channels;
+		data.in_float = ibuf->rect_float;
+		data.out_float = newrectf;
+		scale_filter_apply(&data);
+	}
+
+	scale_filter_axis_free(&data.axis_x);
+	scale_filter_axis_free(&data.axis_y);
+	MEM_freeN(data.temp);
+
+	/* the Z-buffer is scaled before ibuf->x and ibuf->y change */
+	scalefast_Z_ImBuf(ibuf, newx, newy);
+
+	if (newrect) {
+		imb_freerectImBuf(ibuf);
+		ibuf->mall |= IB_rect;
+		ibuf->rect = (unsigned int *)newrect;
+	}
+
+	if (newrectf) {
+		imb_freerectfloatImBuf(ibuf);
+		ibuf->mall |= IB_rectfloat;
+		ibuf->rect_float = newrectf;
 	}
+
+	ibuf->x = newx;
+	ibuf->y = newy;
+	return true;
+}
+
+/**
+ * Return true if \a ibuf is modified.
+ */
+bool IMB_scaleImBuf_filter(struct ImBuf *ibuf, unsigned int newx, unsigned int newy, eIMBScaleFilter filter)
+{
+	return scale_filter_imbuf(ibuf, (int)newx, (int)newy, filter, filter);
 }
 
 /**
@@ -1557,105 +1426,116 @@ bool IMB_scaleImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy)
 {
 	if (ibuf == NULL) return false;
 	if (ibuf->rect == NULL && ibuf->rect_float == NULL) return false;
-	
+
+	/* zero keeps the size of that axis */
+	if (newx == 0) newx = ibuf->x;
+	if (newy == 0) newy = ibuf->y;
+
 	if (newx == ibuf->x && newy == ibuf->y) {
 		return false;
 	}
 
-	/* scaleup / scaledown functions below change ibuf->x and ibuf->y
-	 * so we first scale the Z-buffer (if any) */
-	scalefast_Z_ImBuf(ibuf, newx, newy);
-
 	/* try to scale common cases in a fast way */
 	/* disabled, quality loss is unacceptable, see report #18609  (ton) */
 	if (0 && q_scale_linear_interpolation(ibuf, newx, newy)) {
 		return true;
 	}
 
-	if (newx && (newx < ibuf->x)) scaledownx(ibuf, newx);
-	if (newy && (newy < ibuf->y)) scaledowny(ibuf, newy);
-	if (newx && (newx > ibuf->x)) scaleupx(ibuf, newx);
-	if (newy && (newy > ibuf->y)) scaleupy(ibuf, newy);
-	
-	return true;
+	/* area average when making an axis smaller, linear interpolation when making it larger */
+	return scale_filter_imbuf(ibuf, newx, newy,
+	                          (newx < ibuf->x) ? IMB_SCALE_FILTER_BOX : IMB_SCALE_FILTER_BILINEAR,
+	                          (newy < ibuf->y) ? IMB_SCALE_FILTER_BOX : IMB_SCALE_FILTER_BILINEAR);
 }
 
 struct imbufRGBA {
 	float r, g, b, a;
 };
 
+typedef struct ScaleFastData {
+	ImBuf *ibuf;
+	unsigned int *newrect;
+	struct imbufRGBA *newrectf;
+	int newx;
+	size_t stepx, stepy;
+} ScaleFastData;
+
+static void scalefast_rows(void *data_v, int start_line, int tot_line)
+{
+	ScaleFastData *data = (ScaleFastData *)data_v;
+	ImBuf *ibuf = data->ibuf;
+	size_t ofsx, ofsy = 32768 + start_line * data->stepy;
+	int x, y;
+
+	for (y = start_line; y < start_line + tot_line; y++, ofsy += data->stepy) {
+		if (data->newrect) {
+			unsigned int *rect = ibuf->rect + (ofsy >> 16) * ibuf->x;
+			unsigned int *newrect = data->newrect + (size_t)y * data->newx;
+			ofsx = 32768;
+
+			for (x = data->newx; x > 0; x--, ofsx += data->stepx) {
+				*newrect++ = rect[ofsx >> 16];
+			}
+		}
+
+		if (data->newrectf) {
+			struct imbufRGBA *rectf = (struct imbufRGBA *)ibuf->rect_float + (ofsy >> 16) * ibuf->x;
+			struct imbufRGBA *newrectf = data->newrectf + (size_t)y * data->newx;
+			ofsx = 32768;
+
+			for (x = data->newx; x > 0; x--, ofsx += data->stepx) {
+				*newrectf++ = rectf[ofsx >> 16];
+			}
+		}
+	}
+}
+
 /**
  * Return true if \a ibuf is modified.
  */
 bool IMB_scalefastImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy)
 {
-	unsigned int *rect, *_newrect, *newrect;
-	struct imbufRGBA *rectf, *_newrectf, *newrectf;
-	int x, y;
-	bool do_float = false, do_rect = false;
-	size_t ofsx, ofsy, stepx, stepy;
-
-	rect = NULL; _newrect = NULL; newrect = NULL;
-	rectf = NULL; _newrectf = NULL; newrectf = NULL;
+	ScaleFastData data = {NULL};
 
 	if (ibuf == NULL) return false;
-	if (ibuf->rect) do_rect = true;
-	if (ibuf->rect_float) do_float = true;
-	if (do_rect == false && do_float == false) return false;
+	if (ibuf->rect == NULL && ibuf->rect_float == NULL) return false;
 	
 	if (newx == ibuf->x && newy == ibuf->y) return false;
 	
-	if (do_rect) {
-		_newrect = MEM_mallocN(newx * newy * sizeof(int), "scalefastimbuf");
-		if (_newrect == NULL) return false;
-		newrect = _newrect;
+	if (ibuf->rect) {
+		data.newrect = MEM_mallocN(newx * newy * sizeof(int), "scalefastimbuf");
+		if (data.newrect == NULL) return false;
 	}
 	
-	if (do_float) {
-		_newrectf = MEM_mallocN(newx * newy * sizeof(float) * 4, "scalefastimbuf f");
-		if (_newrectf == NULL) {
-			if (_newrect) MEM_freeN(_newrect);
+	if (ibuf->rect_float) {
+		data.newrectf = MEM_mallocN(newx * newy * sizeof(float) * 4, "scalefastimbuf f");
+		if (data.newrectf == NULL) {
+			if (data.newrect) MEM_freeN(data.newrect);
 			return false;
 		}
-		newrectf = _newrectf;
 	}
 
-	stepx = (65536.0 * (ibuf->x - 1.0) / (newx - 1.0)) + 0.5;
-	stepy = (65536.0 * (ibuf->y - 1.0) / (newy - 1.0)) + 0.5;
-	ofsy = 32768;
-
-	for (y = newy; y > 0; y--, ofsy += stepy) {
-		if (do_rect) {
-			rect = ibuf->rect;
-			rect += (ofsy >> 16) * ibuf->x;
-			ofsx = 32768;
+	data.ibuf = ibuf;
+	data.newx = newx;
+	data.stepx = (65536.0 * (ibuf->x - 1.0) / (newx - 1.0)) + 0.5;
+	data.stepy = (65536.0 * (ibuf->y - 1.0) / (newy - 1.0)) + 0.5;
 
-			for (x = newx; x > 0; x--, ofsx += stepx) {
-				*newrect++ = rect[ofsx >> 16];
-			}
-		}
-
-		if (do_float) {
-			rectf = (struct imbufRGBA *)ibuf->rect_float;
-			rectf += (ofsy >> 16) * ibuf->x;
-			ofsx = 32768;
-
-			for (x = newx; x > 0; x--, ofsx += stepx) {
-				*newrectf++ = rectf[ofsx >> 16];
-			}
-		}
+	if ((size_t)newx * newy < SCALE_THREADED_MIN_PIXELS) {
+		scalefast_rows(&data, 0, newy);
+	}
+	else {
+		IMB_processor_apply_threaded_scanlines(newy, scalefast_rows, &data);
 	}
 
-	if (do_rect) {
+	if (data.newrect) {
 		imb_freerectImBuf(ibuf);
 		ibuf->mall |= IB_rect;
-		ibuf->rect = _newrect;
+		ibuf->rect = data.newrect;
 	}
 
-	if (do_float) {
+	if (data.newrectf) {
 		imb_freerectfloatImBuf(ibuf);
 		ibuf->mall |= IB_rectfloat;
-		ibuf->rect_float = (float *)_newrectf;
+		ibuf->rect_float = (float *)data.newrectf;
 	}
 
 	scalefast_Z_ImBuf(ibuf, newx, newy);
@@ -1667,111 +1547,7 @@ bool IMB_scalefastImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy
 
 /* ******** threaded scaling ******** */
 
-typedef struct ScaleTreadInitData {
-	ImBuf *ibuf;
-
-	unsigned int newx;
-	unsigned int newy;
-
-	unsigned char *byte_buffer;
-	float *float_buffer;
-} ScaleTreadInitData;
-
-typedef struct ScaleThreadData {
-	ImBuf *ibuf;
-
-	unsigned int newx;
-	unsigned int newy;
-
-	int start_line;
-	int tot_line;
-
-	unsigned char *byte_buffer;
-	float *float_buffer;
-} ScaleThreadData;
-
-static void scale_thread_init(void *data_v, int start_line, int tot_line, void *init_data_v)
-{
-	ScaleThreadData *data = (ScaleThreadData *) data_v;
-	ScaleTreadInitData *init_data = (ScaleTreadInitData *) init_data_v;
-
-	data->ibuf = init_data->ibuf;
-
-	data->newx = init_data->newx;
-	data->newy = init_data->newy;
-
-	data->start_line = start_line;
-	data->tot_line = tot_line;
-
-	data->byte_buffer = init_data->byte_buffer;
-	data->float_buffer = init_data->float_buffer;
-}
-
-static void *do_scale_thread(void *data_v)
-{
-	ScaleThreadData *data = (ScaleThreadData *) data_v;
-	ImBuf *ibuf = data->ibuf;
-	int i;
-	float factor_x = (float) ibuf->x / data->newx;
-	float factor_y = (float) ibuf->y / data->newy;
-
-	for (i = 0; i < data->tot_line; i++) {
-		int y = data->start_line + i;
-		int x;
-
-		for (x = 0; x < data->newx; x++) {
-			float u = (float) x * factor_x;
-			float v = (float) y * factor_y;
-			int offset = y * data->newx + x;
-
-			if (data->byte_buffer) {
-				unsigned char *pixel = data->byte_buffer + 4 * offset;
-				BLI_bilinear_interpolation_char((unsigned char *) ibuf->rect, pixel, ibuf->x, ibuf->y, 4, u, v);
-			}
-
-			if (data->float_buffer) {
-				float *pixel = data->float_buffer + ibuf->channels * offset;
-				BLI_bilinear_interpolation_fl(ibuf->rect_float, pixel, ibuf->x, ibuf->y, ibuf->channels, u, v);
-			}
-		}
-	}
-
-	return NULL;
-}
-
 void IMB_scaleImBuf_threaded(ImBuf *ibuf, unsigned int newx, unsigned int newy)
 {
-	ScaleTreadInitData init_data = {NULL};
-
-	/* prepare initialization data */
-	init_data.ibuf = ibuf;
-
-	init_data.newx = newx;
-	init_data.newy = newy;
-
-	if (ibuf->rect)
-		init_data.byte_buffer = MEM_mallocN(4 * newx * newy * sizeof(char), "threaded scale byte buffer");
-
-	if (ibuf->rect_float)
-		init_data.float_buffer = MEM_mallocN(ibuf->channels * newx * newy * sizeof(float), "threaded scale float buffer");
-
-	/* actual scaling threads */
-	IMB_processor_apply_threaded(newy, sizeof(ScaleThreadData), &init_data,
-	                             scale_thread_init, do_scale_thread);
-
-	/* alter image buffer */
-	ibuf->x = newx;
-	ibuf->y = newy;
-
-	if (ibuf->rect) {
-		imb_freerectImBuf(ibuf);
-		ibuf->mall |= IB_rect;
-		ibuf->rect = (unsigned int *) init_data.byte_buffer;
-	}
-
-	if (ibuf->rect_float) {
-		imb_freerectfloatImBuf(ibuf);
-		ibuf->mall |= IB_rectfloat;
-		ibuf->rect_float = init_data.float_buffer;
-	}
+	IMB_scaleImBuf_filter(ibuf, newx, newy, IMB_SCALE_FILTER_BILINEAR);
 }
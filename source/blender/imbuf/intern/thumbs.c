@@ -44,6 +44,10 @@
 #include "BLI_threads.h"
 #include BLI_SYSTEM_PID_H
 
+#include "PIL_time.h"
+
+#include "atomic_ops.h"
+
 #include "BLO_readfile.h"
 
 #include "DNA_space_types.h"  /* For FILE_MAX_LIBEXTRA */
@@ -322,6 +326,7 @@ static ImBuf *thumb_create_ex(
 	char cwidth[40] = "0"; /* in case images have no data */
 	char cheight[40] = "0";
 	short tsize = 128;
+	int image_width = 0, image_height = 0;
 	short ex, ey;
 	float scaledx, scaledy;
 	BLI_stat_t info;
@@ -366,8 +371,21 @@ static ImBuf *thumb_create_ex(
 				if (img == NULL) {
 					switch (source) {
 						case THB_SOURCE_IMAGE:
-							img = IMB_loadiffname(file_path, IB_rect | IB_metadata, NULL);
+						{
+							ImPartialRead partial = {0};
+
+							/* only read the smallest mipmap level large enough for the thumbnail */
+							partial.level_min_size = tsize;
+							img = IMB_loadiffname_partial(file_path, IB_rect | IB_metadata | IB_thumbnail, NULL, &partial);
+							if (img) {
+								image_width = partial.width;
+								image_height = partial.height;
+							}
+							else {
+								img = IMB_loadiffname(file_path, IB_rect | IB_metadata, NULL);
+							}
 							break;
+						}
 						case THB_SOURCE_BLEND:
 							img = IMB_thumb_load_blend(file_path, blen_group, blen_id);
 							break;
@@ -383,8 +401,8 @@ static ImBuf *thumb_create_ex(
 					if (BLI_stat(file_path, &info) != -1) {
 						BLI_snprintf(mtime, sizeof(mtime), "%ld", (long int)info.st_mtime);
 					}
-					BLI_snprintf(cwidth, sizeof(cwidth), "%d", img->x);
-					BLI_snprintf(cheight, sizeof(cheight), "%d", img->y);
+					BLI_snprintf(cwidth, sizeof(cwidth), "%d", image_width ? image_width : img->x);
+					BLI_snprintf(cheight, sizeof(cheight), "%d", image_height ? image_height : img->y);
 				}
 			}
 			else if (THB_SOURCE_MOVIE == source) {
@@ -480,6 +498,43 @@ static ImBuf *thumb_create_or_fail(
 	return img;
 }
 
+/* counters of IMB_thumb_manage, updated from any thread */
+static struct {
+	uint32_t hits, misses, failures;
+	/* time spent generating thumbnails, in microseconds */
+	uint64_t generate_usec;
+} thumb_stats = {0};
+
+void IMB_thumb_stats_get(ThumbStats *r_stats)
+{
+	r_stats->hits = atomic_add_and_fetch_uint32(&thumb_stats.hits, 0);
+	r_stats->misses = atomic_add_and_fetch_uint32(&thumb_stats.misses, 0);
+	r_stats->failures = atomic_add_and_fetch_uint32(&thumb_stats.failures, 0);
+	r_stats->generate_time = (double)atomic_add_and_fetch_uint64(&thumb_stats.generate_usec, 0) * 1e-6;
+}
+
+void IMB_thumb_stats_reset(void)
+{
+	atomic_fetch_and_and_uint32(&thumb_stats.hits, 0);
+	atomic_fetch_and_and_uint32(&thumb_stats.misses, 0);
+	atomic_fetch_and_and_uint32(&thumb_stats.failures, 0);
+	/* concurrent generation may be counted in either period */
+	atomic_sub_and_fetch_uint64(&thumb_stats.generate_usec, atomic_add_and_fetch_uint64(&thumb_stats.generate_usec, 0));
+}
+
+static ImBuf *thumb_create_or_fail_stats(
+        const char *file_path, const char *uri, const char *thumb, const bool use_hash, const char *hash,
+        const char *blen_group, const char *blen_id, ThumbSize size, ThumbSource source)
+{
+	const double start = PIL_check_seconds_timer();
+	ImBuf *img = thumb_create_or_fail(file_path, uri, thumb, use_hash, hash, blen_group, blen_id, size, source);
+
+	atomic_add_and_fetch_uint32(img ? &thumb_stats.misses : &thumb_stats.failures, 1);
+	atomic_add_and_fetch_uint64(&thumb_stats.generate_usec, (uint64_t)((PIL_check_seconds_timer() - start) * 1e6));
+
+	return img;
+}
+
 ImBuf *IMB_thumb_create(const char *path, ThumbSize size, ThumbSource source, ImBuf *img)
 {
 	char uri[URI_MAX] = "";
@@ -570,6 +625,7 @@ ImBuf *IMB_thumb_manage(const char *org_path, ThumbSize size, ThumbSource source
 				BLI_delete(thumb_path, false, false);
 			}
 			else {
+				atomic_add_and_fetch_uint32(&thumb_stats.hits, 1);
 				return NULL;
 			}
 		}
@@ -614,15 +670,18 @@ ImBuf *IMB_thumb_manage(const char *org_path, ThumbSize size, ThumbSource source
 					IMB_thumb_delete(path, THB_NORMAL);
 					IMB_thumb_delete(path, THB_LARGE);
 					IMB_thumb_delete(path, THB_FAIL);
-					img = thumb_create_or_fail(
+					img = thumb_create_or_fail_stats(
 					          file_path, uri, thumb_name, use_hash, thumb_hash, blen_group, blen_id, size, source);
 				}
+				else {
+					atomic_add_and_fetch_uint32(&thumb_stats.hits, 1);
+				}
 			}
 			else {
 				char thumb_hash[33];
 				const bool use_hash = thumbhash_from_path(file_path, source, thumb_hash);
 
-				img = thumb_create_or_fail(
+				img = thumb_create_or_fail_stats(
 				          file_path, uri, thumb_name, use_hash, thumb_hash, blen_group, blen_id, size, source);
 			}
 		}
@@ -677,6 +736,9 @@ void IMB_thumb_locks_release(void)
 		BLI_gset_free(thumb_locks.locked_paths, MEM_freeN);
 		thumb_locks.locked_paths = NULL;
 		BLI_condition_end(&thumb_locks.cond);
+
+		/* the previews of .blend files are kept for the duration of a thumbnailing job */
+		IMB_thumb_blend_cache_clear();
 	}
 
 	BLI_thread_unlock(LOCK_IMAGE);
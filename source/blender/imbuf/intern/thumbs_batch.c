@@ -0,0 +1,244 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/imbuf/intern/thumbs_batch.c
+ *  \ingroup imbuf
+ *
+ * Manage the thumbnails of many files at once. Requests are kept in a heap so the most
+ * important ones (the visible items of a file browser) are handled first, even when they
+ * are pushed after the others. Finished thumbnails are collected until the owner pops them.
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_heap.h"
+#include "BLI_listbase.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_threads.h"
+
+#include "IMB_imbuf_types.h"
+#include "IMB_imbuf.h"
+#include "IMB_thumbs.h"
+
+typedef struct ThumbBatchItem {
+	struct ThumbBatchItem *next, *prev;
+	char path[FILE_MAX];
+	ThumbSource source;
+	void *userdata;
+	ImBuf *img;
+} ThumbBatchItem;
+
+struct ThumbBatch {
+	ThumbSize size;
+
+	/* protects everything below */
+	ThreadMutex mutex;
+	/* signaled on new requests and on stopping for the workers,
+	 * and when the last running request finished for IMB_thumb_batch_wait */
+	ThreadCondition cond;
+
+	Heap *pending;
+	ListBase done;
+	int running;
+	bool stop;
+
+	ListBase threads;
+	int num_threads;
+};
+
+static void *thumb_batch_thread(void *batch_v)
+{
+	ThumbBatch *batch = batch_v;
+
+	BLI_mutex_lock(&batch->mutex);
+
+	while (true) {
+		ThumbBatchItem *item;
+
+		while (!batch->stop && BLI_heap_is_empty(batch->pending)) {
+			BLI_condition_wait(&batch->cond, &batch->mutex);
+		}
+
+		if (batch->stop) {
+			break;
+		}
+
+		item = BLI_heap_pop_min(batch->pending);
+		batch->running++;
+
+		BLI_mutex_unlock(&batch->mutex);
+
+		IMB_thumb_path_lock(item->path);
+		item->img = IMB_thumb_manage(item->path, batch->size, item->source);
+		IMB_thumb_path_unlock(item->path);
+
+		BLI_mutex_lock(&batch->mutex);
+
+		BLI_addtail(&batch->done, item);
+		batch->running--;
+
+		if (batch->running == 0 && BLI_heap_is_empty(batch->pending)) {
+			BLI_condition_notify_all(&batch->cond);
+		}
+	}
+
+	BLI_mutex_unlock(&batch->mutex);
+
+	return NULL;
+}
+
+/* num_threads of zero uses all threads of the system */
+ThumbBatch *IMB_thumb_batch_create(ThumbSize size, int num_threads)
+{
+	ThumbBatch *batch = MEM_callocN(sizeof(ThumbBatch), "ThumbBatch");
+
+	batch->size = size;
+	batch->pending = BLI_heap_new();
+	batch->num_threads = (num_threads > 0) ? num_threads : BLI_system_thread_count();
+
+	BLI_mutex_init(&batch->mutex);
+	BLI_condition_init(&batch->cond);
+
+	IMB_thumb_locks_acquire();
+
+	return batch;
+}
+
+static void thumb_batch_threads_ensure(ThumbBatch *batch)
+{
+	int i, tot;
+
+	/* threads are started on the first request, many batches never get one */
+	if (BLI_listbase_is_empty(&batch->threads)) {
+		BLI_threadpool_init(&batch->threads, thumb_batch_thread, batch->num_threads);
+
+		/* the pool may have less threads than asked for */
+		tot = BLI_available_threads(&batch->threads);
+		for (i = 0; i < tot; i++) {
+			BLI_threadpool_insert(&batch->threads, batch);
+		}
+	}
+}
+
+void IMB_thumb_batch_push(ThumbBatch *batch, const char *path, ThumbSource source, float priority, void *userdata)
+{
+	ThumbBatchItem *item = MEM_callocN(sizeof(ThumbBatchItem), "ThumbBatchItem");
+
+	BLI_strncpy(item->path, path, sizeof(item->path));
+	item->source = source;
+	item->userdata = userdata;
+
+	BLI_mutex_lock(&batch->mutex);
+	thumb_batch_threads_ensure(batch);
+	BLI_heap_insert(batch->pending, priority, item);
+	/* not only workers wait on the condition */
+	BLI_condition_notify_all(&batch->cond);
+	BLI_mutex_unlock(&batch->mutex);
+}
+
+/* Get a finished request without waiting, returns false when there is none.
+ * r_img is NULL when no thumbnail could be made, the caller owns it otherwise. */
+bool IMB_thumb_batch_pop(ThumbBatch *batch, ImBuf **r_img, void **r_userdata)
+{
+	ThumbBatchItem *item;
+
+	BLI_mutex_lock(&batch->mutex);
+	item = BLI_pophead(&batch->done);
+	BLI_mutex_unlock(&batch->mutex);
+
+	if (item == NULL) {
+		return false;
+	}
+
+	*r_img = item->img;
+	*r_userdata = item->userdata;
+	MEM_freeN(item);
+
+	return true;
+}
+
+static void thumb_batch_item_free(void *item_v)
+{
+	ThumbBatchItem *item = item_v;
+
+	if (item->img) {
+		IMB_freeImBuf(item->img);
+	}
+	MEM_freeN(item);
+}
+
+/* Remove the requests not started yet and the finished ones which were not popped.
+ * Requests being handled are still added to the finished ones. */
+void IMB_thumb_batch_cancel(ThumbBatch *batch)
+{
+	ThumbBatchItem *item;
+
+	BLI_mutex_lock(&batch->mutex);
+
+	BLI_heap_clear(batch->pending, thumb_batch_item_free);
+	while ((item = BLI_pophead(&batch->done))) {
+		thumb_batch_item_free(item);
+	}
+
+	BLI_condition_notify_all(&batch->cond);
+	BLI_mutex_unlock(&batch->mutex);
+}
+
+/* wait until all requests are finished */
+void IMB_thumb_batch_wait(ThumbBatch *batch)
+{
+	BLI_mutex_lock(&batch->mutex);
+	while (batch->running || !BLI_heap_is_empty(batch->pending)) {
+		BLI_condition_wait(&batch->cond, &batch->mutex);
+	}
+	BLI_mutex_unlock(&batch->mutex);
+}
+
+void IMB_thumb_batch_free(ThumbBatch *batch)
+{
+	ThumbBatchItem *item;
+
+	BLI_mutex_lock(&batch->mutex);
+	BLI_heap_clear(batch->pending, thumb_batch_item_free);
+	batch->stop = true;
+	BLI_condition_notify_all(&batch->cond);
+	BLI_mutex_unlock(&batch->mutex);
+
+	/* running requests are finished first */
+	if (!BLI_listbase_is_empty(&batch->threads)) {
+		BLI_threadpool_end(&batch->threads);
+	}
+
+	while ((item = BLI_pophead(&batch->done))) {
+		thumb_batch_item_free(item);
+	}
+
+	BLI_heap_free(batch->pending, NULL);
+	BLI_condition_end(&batch->cond);
+	BLI_mutex_end(&batch->mutex);
+
+	IMB_thumb_locks_release();
+
+	MEM_freeN(batch);
+}
@@ -32,6 +32,9 @@
 #include "BLI_endian_switch.h"
 #include "BLI_fileops.h"
 #include "BLI_linklist.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_threads.h"
 
 #include "BLO_blend_defs.h"
 #include "BLO_readfile.h"
@@ -49,22 +52,124 @@
 
 #include "MEM_guardedalloc.h"
 
+/* ID names and previews of the last read groups, to read the previews of all IDs of a group
+ * from the .blend file at once instead of reopening the file for each and every ID. */
+#define BLEND_PREVIEW_CACHE_SIZE 4
+
+typedef struct BlendPreviewCacheEntry {
+	char path[FILE_MAX];
+	int idcode;
+	int64_t mtime;
+	LinkNode *names, *previews;
+	int nnames;
+} BlendPreviewCacheEntry;
+
+static struct BlendPreviewCache {
+	BlendPreviewCacheEntry entries[BLEND_PREVIEW_CACHE_SIZE];
+	/* entry to replace next, oldest first */
+	int next;
+} blend_preview_cache;
+
+static ThreadMutex blend_preview_cache_lock = BLI_MUTEX_INITIALIZER;
+
+static void blend_preview_cache_entry_free(BlendPreviewCacheEntry *entry)
+{
+	BLI_linklist_free(entry->previews, BKE_previewimg_freefunc);
+	BLI_linklist_free(entry->names, free);
+	memset(entry, 0, sizeof(*entry));
+}
+
+static BlendPreviewCacheEntry *blend_preview_cache_find(const char *blen_path, int idcode, int64_t mtime)
+{
+	int i;
+
+	for (i = 0; i < BLEND_PREVIEW_CACHE_SIZE; i++) {
+		BlendPreviewCacheEntry *entry = &blend_preview_cache.entries[i];
+
+		if (entry->names && entry->idcode == idcode && entry->mtime == mtime && STREQ(entry->path, blen_path)) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+/* copy the preview of blen_id into a new ImBuf, also returns NULL when the ID has no preview */
+static ImBuf *blend_preview_to_imbuf(LinkNode *names, LinkNode *previews, int nnames, const char *blen_id)
+{
+	LinkNode *ln, *lp;
+	ImBuf *ima = NULL;
+	int i;
+
+	for (i = 0, ln = names, lp = previews; i < nnames; i++, ln = ln->next, lp = lp->next) {
+		const char *blockname = ln->link;
+		PreviewImage *img = lp->link;
+
+		if (STREQ(blockname, blen_id)) {
+			if (img) {
+				unsigned int w = img->w[ICON_SIZE_PREVIEW];
+				unsigned int h = img->h[ICON_SIZE_PREVIEW];
+				unsigned int *rect = img->rect[ICON_SIZE_PREVIEW];
+
+				if (w > 0 && h > 0 && rect) {
+					/* first allocate imbuf for copying preview into it */
+					ima = IMB_allocImBuf(w, h, 32, IB_rect);
+					memcpy(ima->rect, rect, w * h * sizeof(unsigned int));
+				}
+			}
+			break;
+		}
+	}
+
+	return ima;
+}
+
+void IMB_thumb_blend_cache_clear(void)
+{
+	int i;
+
+	BLI_mutex_lock(&blend_preview_cache_lock);
+	for (i = 0; i < BLEND_PREVIEW_CACHE_SIZE; i++) {
+		if (blend_preview_cache.entries[i].names) {
+			blend_preview_cache_entry_free(&blend_preview_cache.entries[i]);
+		}
+	}
+	blend_preview_cache.next = 0;
+	BLI_mutex_unlock(&blend_preview_cache_lock);
+}
+
 ImBuf *IMB_thumb_load_blend(const char *blen_path, const char *blen_group, const char *blen_id)
 {
 	ImBuf *ima = NULL;
 
 	if (blen_group && blen_id) {
-		LinkNode *ln, *names, *lp, *previews = NULL;
-		struct BlendHandle *libfiledata = BLO_blendhandle_from_file(blen_path, NULL);
+		LinkNode *names, *previews = NULL;
+		struct BlendHandle *libfiledata;
+		BlendPreviewCacheEntry *entry;
 		int idcode = BKE_idcode_from_name(blen_group);
-		int i, nprevs, nnames;
+		int nprevs, nnames;
+		BLI_stat_t st;
 
+		if (BLI_stat(blen_path, &st) == -1) {
+			return ima;
+		}
+
+		BLI_mutex_lock(&blend_preview_cache_lock);
+		entry = blend_preview_cache_find(blen_path, idcode, (int64_t)st.st_mtime);
+		if (entry) {
+			ima = blend_preview_to_imbuf(entry->names, entry->previews, entry->nnames, blen_id);
+		}
+		BLI_mutex_unlock(&blend_preview_cache_lock);
+
+		if (entry) {
+			return ima;
+		}
+
+		libfiledata = BLO_blendhandle_from_file(blen_path, NULL);
 		if (libfiledata == NULL) {
 			return ima;
 		}
 
-		/* Note: we should handle all previews for a same group at once, would avoid reopening .blend file
-		 *       for each and every ID. However, this adds some complexity, so keep it for later. */
 		names = BLO_blendhandle_get_datablock_names(libfiledata, idcode, &nnames);
 		previews = BLO_blendhandle_get_previews(libfiledata, idcode, &nprevs);
 
@@ -80,25 +185,27 @@ ImBuf *IMB_thumb_load_blend(const char *blen_path, const char *blen_group, const
 			return ima;
 		}
 
-		for (i = 0, ln = names, lp = previews; i < nnames; i++, ln = ln->next, lp = lp->next) {
-			const char *blockname = ln->link;
-			PreviewImage *img = lp->link;
+		ima = blend_preview_to_imbuf(names, previews, nnames, blen_id);
 
-			if (STREQ(blockname, blen_id)) {
-				if (img) {
-					unsigned int w = img->w[ICON_SIZE_PREVIEW];
-					unsigned int h = img->h[ICON_SIZE_PREVIEW];
-					unsigned int *rect = img->rect[ICON_SIZE_PREVIEW];
-
-					if (w > 0 && h > 0 && rect) {
-						/* first allocate imbuf for copying preview into it */
-						ima = IMB_allocImBuf(w, h, 32, IB_rect);
-						memcpy(ima->rect, rect, w * h * sizeof(unsigned int));
-					}
-				}
-				break;
+		/* keep the group for the other IDs, unless another thread was faster */
+		BLI_mutex_lock(&blend_preview_cache_lock);
+		if (nnames && !blend_preview_cache_find(blen_path, idcode, (int64_t)st.st_mtime)) {
+			entry = &blend_preview_cache.entries[blend_preview_cache.next];
+			if (entry->names) {
+				blend_preview_cache_entry_free(entry);
 			}
+
+			BLI_strncpy(entry->path, blen_path, sizeof(entry->path));
+			entry->idcode = idcode;
+			entry->mtime = (int64_t)st.st_mtime;
+			entry->names = names;
+			entry->previews = previews;
+			entry->nnames = nnames;
+
+			blend_preview_cache.next = (blend_preview_cache.next + 1) % BLEND_PREVIEW_CACHE_SIZE;
+			names = previews = NULL;
 		}
+		BLI_mutex_unlock(&blend_preview_cache_lock);
 
 		BLI_linklist_free(previews, BKE_previewimg_freefunc);
 		BLI_linklist_free(names, free);
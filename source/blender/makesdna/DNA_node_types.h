@@ -354,7 +354,7 @@ typedef struct bNodeTree {
 	int update;						/* update flags */
 	short is_updating;				/* flag to prevent reentrant update calls */
 	short done;						/* generic temporary flag for recursion check (DFS/BFS) */
-	int pad2;
+	int cache_size;					/* memory limit of the compositor result cache in megabytes */
 	
 	int nodetype DNA_DEPRECATED;	/* specific node type this tree is used for */
 
@@ -378,7 +378,7 @@ typedef struct bNodeTree {
 	 * in case multiple different editors are used and make context ambiguous.
 	 */
 	bNodeInstanceKey active_viewer_key;
-	int pad;
+	int memory_limit;				/* memory budget of compositor buffers in megabytes, 0 for no limit */
 	
 	/* execution data */
 	/* XXX It would be preferable to completely move this data out of the underlying node tree,
@@ -417,6 +417,9 @@ typedef struct bNodeTree {
 #define NTREE_COM_GROUPNODE_BUFFER	8	/* use groupnode buffers */
 #define NTREE_VIEWER_BORDER			16	/* use a border for viewer nodes */
 #define NTREE_IS_LOCALIZED			32	/* tree is localized copy, free when deleting node groups */
+#define NTREE_COM_ROW_EXECUTION		64	/* evaluate simple operations a row at a time */
+#define NTREE_COM_RESULT_CACHE		128	/* keep intermediate results between executions */
+#define NTREE_COM_HALF_BUFFERS		256	/* store unused color buffers as half floats */
 
 /* XXX not nice, but needed as a temporary flags
  * for group updates after library linking.
@@ -583,7 +583,9 @@ typedef struct UserDef {
 	struct WalkNavigation walk_navigation;
 
 	short opensubdiv_compute_type;
-	char pad5[6];
+	short pad5;
+	int sequencer_disk_cache_size_limit;  /* in gigabytes, 0 disables the disk cache */
+	char sequencer_disk_cache_dir[768];  /* 768 = FILE_MAXDIR */
 } UserDef;
 
 extern UserDef U; /* from blenkernel blender.c */
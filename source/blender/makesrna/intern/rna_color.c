@@ -1151,6 +1151,13 @@ static void rna_def_colormanage(BlenderRNA *brna)
 	RNA_def_property_ui_text(prop, "Use Curves", "Use RGB curved for pre-display transformation");
 	RNA_def_property_update(prop, NC_WINDOW, "rna_ColorManagement_update");
 
+	prop = RNA_def_property(srna, "use_exact_transform", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "flag", COLORMANAGE_VIEW_EXACT_TRANSFORM);
+	RNA_def_property_ui_text(prop, "Exact Transform",
+	                         "Apply the exact view transform to images drawn on screen, instead of a faster "
+	                         "approximation baked into a lookup table");
+	RNA_def_property_update(prop, NC_WINDOW, "rna_ColorManagement_update");
+
 	/* ** Colorspace **  */
 	srna = RNA_def_struct(brna, "ColorManagedInputColorspaceSettings", NULL);
 	RNA_def_struct_path_func(srna, "rna_ColorManagedInputColorspaceSettings_path");
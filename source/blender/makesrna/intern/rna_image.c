@@ -412,6 +412,7 @@ static void rna_Image_pixels_set(PointerRNA *ptr, const float *values)
 		}
 
 		ibuf->userflags |= IB_BITMAPDIRTY | IB_DISPLAY_BUFFER_INVALID | IB_MIPMAP_INVALID;
+		IMB_generation_bump(ibuf);
 		if (!G.background) {
 			GPU_free_image(ima);
 		}
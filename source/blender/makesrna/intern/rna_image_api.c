@@ -136,6 +136,7 @@ static void rna_Image_save(Image *image, Main *bmain, bContext *C, ReportList *r
 			IMB_colormanagment_colorspace_from_ibuf_ftype(&image->colorspace_settings, ibuf);
 
 			ibuf->userflags &= ~IB_BITMAPDIRTY;
+			IMB_generation_bump(ibuf);
 		}
 		else {
 			BKE_reportf(reports, RPT_ERROR, "Image '%s' could not be saved to '%s'", image->id.name + 2, image->name);
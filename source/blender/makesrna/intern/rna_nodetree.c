@@ -8449,6 +8449,35 @@ static void rna_def_composite_nodetree(BlenderRNA *brna)
 	RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_COM_GROUPNODE_BUFFER);
 	RNA_def_property_ui_text(prop, "Buffer Groups", "Enable buffering of group nodes");
 
+	prop = RNA_def_property(srna, "use_row_execution", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_COM_ROW_EXECUTION);
+	RNA_def_property_ui_text(prop, "Row Execution", "Calculate simple nodes a row of pixels at a time "
+	                                               "instead of pixel by pixel");
+
+	prop = RNA_def_property(srna, "use_result_cache", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_COM_RESULT_CACHE);
+	RNA_def_property_ui_text(prop, "Cache Results", "Keep intermediate results while editing, "
+	                                                "so only nodes affected by a change are calculated again");
+
+	prop = RNA_def_property(srna, "cache_size", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "cache_size");
+	RNA_def_property_range(prop, 0, INT_MAX);
+	RNA_def_property_ui_range(prop, 0, 16384, 64, -1);
+	RNA_def_property_ui_text(prop, "Cache Limit", "Memory limit for cached results (in megabytes)");
+
+	prop = RNA_def_property(srna, "use_half_buffers", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_COM_HALF_BUFFERS);
+	RNA_def_property_ui_text(prop, "Half Float Buffers", "Store color intermediate results with half float "
+	                                                     "precision while they are not used, values and vectors "
+	                                                     "keep full precision");
+
+	prop = RNA_def_property(srna, "memory_limit", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "memory_limit");
+	RNA_def_property_range(prop, 0, INT_MAX);
+	RNA_def_property_ui_range(prop, 0, 65536, 256, -1);
+	RNA_def_property_ui_text(prop, "Memory Limit", "Intermediate buffers exceeding this limit are stored "
+	                                               "compressed in temporary files, 0 means no limit (in megabytes)");
+
 	prop = RNA_def_property(srna, "use_two_pass", PROP_BOOLEAN, PROP_NONE);
 	RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_TWO_PASS);
 	RNA_def_property_ui_text(prop, "Two Pass", "Use two pass execution during editing: first calculate fast nodes, "
@@ -346,6 +346,8 @@ static StripElem *rna_SequenceElements_append(ID *id, Sequence *seq, const char
 	Scene *scene = (Scene *)id;
 	StripElem *se;
 
+	BKE_sequencer_prefetch_stop();
+
 	seq->strip->stripdata = se = MEM_reallocN(seq->strip->stripdata, sizeof(StripElem) * (seq->len + 1));
 	se += seq->len;
 	BLI_strncpy(se->name, filename, sizeof(se->name));
@@ -378,6 +380,8 @@ static void rna_SequenceElements_pop(ID *id, Sequence *seq, ReportList *reports,
 		return;
 	}
 
+	BKE_sequencer_prefetch_stop();
+
 	new_seq = MEM_callocN(sizeof(StripElem) * (seq->len - 1), "SequenceElements_pop");
 	seq->len--;
 
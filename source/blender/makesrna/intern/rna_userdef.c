@@ -4102,6 +4102,13 @@ static void rna_def_userdef_system(BlenderRNA *brna)
 	RNA_def_property_ui_text(prop, "Memory Cache Limit", "Memory cache limit (in megabytes)");
 	RNA_def_property_update(prop, 0, "rna_Userdef_memcache_update");
 
+	prop = RNA_def_property(srna, "sequencer_disk_cache_limit", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "sequencer_disk_cache_size_limit");
+	RNA_def_property_range(prop, 0, INT_MAX);
+	RNA_def_property_ui_range(prop, 0, 1024, 1, -1);
+	RNA_def_property_ui_text(prop, "Disk Cache Limit",
+	                         "Size of the sequencer disk cache (in gigabytes), zero disables the disk cache");
+
 	prop = RNA_def_property(srna, "frame_server_port", PROP_INT, PROP_NONE);
 	RNA_def_property_int_sdna(prop, NULL, "frameserverport");
 	RNA_def_property_range(prop, 0, 32727);
@@ -4588,6 +4595,11 @@ static void rna_def_userdef_filepaths(BlenderRNA *brna)
 	RNA_def_property_string_sdna(prop, NULL, "render_cachedir");
 	RNA_def_property_ui_text(prop, "Render Cache Path", "Where to cache raw render results");
 
+	prop = RNA_def_property(srna, "sequencer_disk_cache_directory", PROP_STRING, PROP_DIRPATH);
+	RNA_def_property_string_sdna(prop, NULL, "sequencer_disk_cache_dir");
+	RNA_def_property_ui_text(prop, "Sequencer Disk Cache Path",
+	                         "Where to store rendered sequencer frames between sessions");
+
 	prop = RNA_def_property(srna, "image_editor", PROP_STRING, PROP_FILEPATH);
 	RNA_def_property_string_sdna(prop, NULL, "image_editor");
 	RNA_def_property_ui_text(prop, "Image Editor", "Path to an image editor");
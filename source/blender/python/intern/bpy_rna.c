@@ -72,6 +72,7 @@
 #include "BKE_global.h" /* evil G.* */
 #include "BKE_report.h"
 #include "BKE_idprop.h"
+#include "BKE_sequencer.h"
 
 /* only for types */
 #include "BKE_node.h"
@@ -1623,6 +1624,16 @@ static PyObject *pyrna_func_to_py(const PointerRNA *ptr, FunctionRNA *func)
 }
 
 
+/* the sequencer prefetches frames from the scene data in worker threads, stop it before writing */
+static void pyrna_write_begin(PointerRNA *ptr)
+{
+	ID *id = ptr->id.data;
+
+	if (id && GS(id->name) == ID_SCE) {
+		BKE_sequencer_prefetch_stop();
+	}
+}
+
 static int pyrna_py_to_prop(
         PointerRNA *ptr, PropertyRNA *prop, void *data, PyObject *value,
         const char *error_prefix)
@@ -1630,6 +1641,9 @@ static int pyrna_py_to_prop(
 	/* XXX hard limits should be checked here */
 	const int type = RNA_property_type(prop);
 
+	if (data == NULL) {
+		pyrna_write_begin(ptr);
+	}
 
 	if (RNA_property_array_check(prop)) {
 		/* done getting the length */
@@ -3042,6 +3056,8 @@ static int pyrna_prop_array_ass_subscript(BPy_PropertyArrayRNA *self, PyObject *
 
 	PYRNA_PROP_CHECK_INT((BPy_PropertyRNA *)self);
 
+	pyrna_write_begin(&self->ptr);
+
 	if (!RNA_property_editable_flag(&self->ptr, self->prop)) {
 		PyErr_Format(PyExc_AttributeError,
 		             "bpy_prop_collection: attribute \"%.200s\" from \"%.200s\" is read-only",
@@ -5094,6 +5110,8 @@ static PyObject *pyrna_prop_collection_foreach_set(BPy_PropertyRNA *self, PyObje
 {
 	PYRNA_PROP_CHECK_OBJ(self);
 
+	pyrna_write_begin(&self->ptr);
+
 	return foreach_getset(self, args, 1);
 }
 
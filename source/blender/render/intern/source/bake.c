@@ -1138,6 +1138,7 @@ int RE_bake_shade_all_selected(Render *re, int type, Object *actob, short *do_up
 				}
 
 				ibuf->userflags |= IB_BITMAPDIRTY;
+				IMB_generation_bump(ibuf);
 				BKE_image_release_ibuf(ima, ibuf, NULL);
 			}
 		}
@@ -1264,6 +1264,7 @@ static void finish_images(MultiresBakeRender *bkr, MultiresBakeResult *result)
 		RE_bake_ibuf_filter(ibuf, userdata->mask_buffer, bkr->bake_filter);
 
 		ibuf->userflags |= IB_BITMAPDIRTY | IB_DISPLAY_BUFFER_INVALID;
+		IMB_generation_bump(ibuf);
 
 		if (ibuf->rect_float)
 			ibuf->userflags |= IB_RECT_INVALID;
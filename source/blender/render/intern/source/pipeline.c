@@ -143,7 +143,9 @@ Render R;
 
 /* ********* alloc and free ******** */
 
-static int do_write_image_or_movie(Render *re, Main *bmain, Scene *scene, bMovieHandle *mh, const int totvideos, const char *name_override);
+struct RenderWriteQueue;
+static int do_write_image_or_movie(Render *re, Main *bmain, Scene *scene, bMovieHandle *mh, const int totvideos,
+                                   const char *name_override, struct RenderWriteQueue *write_queue);
 
 static volatile int g_break = 0;
 static int thread_break(void *UNUSED(arg))
@@ -237,6 +239,240 @@ static int render_imbuf_write_stamp_test(
 	return ok;
 }
 
+/* ------------------------------------------------------------------------- */
+/* Background Image Writing
+ *
+ * Animation renders hand the images of a frame over to writer threads, so the
+ * next frame renders while the previous one gets encoded and written. Each
+ * frame in flight holds a copy of the images, so their number is bounded.
+ * Errors and the render_write handlers of a frame are dealt with on the
+ * render thread once all its files are written. */
+
+#define RE_WRITE_QUEUE_MAX_FRAMES 2
+
+typedef struct RenderWriteFile {
+	struct RenderWriteFile *next, *prev;
+	char name[FILE_MAX];
+	ImageFormatData imf;
+	ImBuf *ibuf;            /* written with BKE_imbuf_write(), else the frame's render result */
+	char view[64];          /* view of the render result to write, all views when empty */
+	bool ok;
+	int err;
+} RenderWriteFile;
+
+typedef struct RenderWriteFrame {
+	struct RenderWriteFrame *next, *prev;
+	ListBase files;
+	RenderResult *rr;       /* copy of the result for EXR files */
+	int cfra;
+	bool done;
+} RenderWriteFrame;
+
+typedef struct RenderWriteQueue {
+	ListBase threads;
+	ThreadQueue *todo;
+	ListBase frames;        /* in render order, only used by the render thread */
+	ThreadMutex mutex;      /* protects RenderWriteFrame.done */
+	ThreadCondition done_cond;
+} RenderWriteQueue;
+
+static void *render_write_thread(void *data)
+{
+	RenderWriteQueue *queue = data;
+	RenderWriteFrame *wframe;
+
+	while ((wframe = BLI_thread_queue_pop(queue->todo))) {
+		RenderWriteFile *wfile;
+
+		for (wfile = wframe->files.first; wfile; wfile = wfile->next) {
+			errno = 0;
+
+			if (wfile->ibuf) {
+				wfile->ok = BKE_imbuf_write(wfile->ibuf, wfile->name, &wfile->imf);
+			}
+			else {
+				wfile->ok = RE_WriteRenderResult(NULL, wframe->rr, wfile->name, &wfile->imf,
+				                                 wfile->view[0] ? wfile->view : NULL, -1);
+			}
+
+			wfile->err = errno;
+		}
+
+		BLI_mutex_lock(&queue->mutex);
+		wframe->done = true;
+		BLI_condition_notify_all(&queue->done_cond);
+		BLI_mutex_unlock(&queue->mutex);
+	}
+
+	return NULL;
+}
+
+static RenderWriteQueue *render_write_queue_create(void)
+{
+	RenderWriteQueue *queue = MEM_callocN(sizeof(RenderWriteQueue), "RenderWriteQueue");
+	int i;
+
+	queue->todo = BLI_thread_queue_init();
+	BLI_mutex_init(&queue->mutex);
+	BLI_condition_init(&queue->done_cond);
+
+	BLI_threadpool_init(&queue->threads, render_write_thread, RE_WRITE_QUEUE_MAX_FRAMES);
+	for (i = 0; i < RE_WRITE_QUEUE_MAX_FRAMES; i++) {
+		BLI_threadpool_insert(&queue->threads, queue);
+	}
+
+	return queue;
+}
+
+static RenderWriteFrame *render_write_frame_new(int cfra)
+{
+	RenderWriteFrame *wframe = MEM_callocN(sizeof(RenderWriteFrame), "RenderWriteFrame");
+	wframe->cfra = cfra;
+	return wframe;
+}
+
+static void render_write_frame_free(RenderWriteFrame *wframe)
+{
+	RenderWriteFile *wfile;
+
+	for (wfile = wframe->files.first; wfile; wfile = wfile->next) {
+		IMB_freeImBuf(wfile->ibuf);
+	}
+	BLI_freelistN(&wframe->files);
+
+	if (wframe->rr) {
+		render_result_free(wframe->rr);
+	}
+
+	MEM_freeN(wframe);
+}
+
+static RenderWriteFile *render_write_frame_add(RenderWriteFrame *wframe, const char *name, const ImageFormatData *imf)
+{
+	RenderWriteFile *wfile = MEM_callocN(sizeof(RenderWriteFile), "RenderWriteFile");
+
+	BLI_strncpy(wfile->name, name, sizeof(wfile->name));
+	wfile->imf = *imf;
+	BLI_addtail(&wframe->files, wfile);
+
+	return wfile;
+}
+
+/* Writers used by render_write_views_image(), without a frame the file is written right away. */
+static bool render_write_ibuf(
+        ReportList *reports, Scene *scene, RenderResult *rr, ImBuf *ibuf, const char *name,
+        const ImageFormatData *imf, bool stamp, RenderWriteFrame *wframe)
+{
+	RenderWriteFile *wfile;
+
+	if (wframe == NULL) {
+		return render_imbuf_write_stamp_test(reports, scene, rr, ibuf, name, imf, stamp);
+	}
+
+	if (stamp && (scene->r.stamp & R_STAMP_ALL)) {
+		BKE_imbuf_stamp_info(rr, ibuf);
+	}
+
+	/* the buffers can belong to the render result, which the next frame reuses */
+	wfile = render_write_frame_add(wframe, name, imf);
+	wfile->ibuf = IMB_dupImBuf(ibuf);
+	IMB_metadata_copy(wfile->ibuf, ibuf);
+
+	return true;
+}
+
+static bool render_write_result(
+        ReportList *reports, RenderResult *rr, const char *name, ImageFormatData *imf, const char *view,
+        RenderWriteFrame *wframe)
+{
+	RenderWriteFile *wfile;
+	bool ok;
+
+	if (wframe == NULL) {
+		ok = RE_WriteRenderResult(reports, rr, name, imf, view, -1);
+		render_print_save_message(reports, name, ok, errno);
+		return ok;
+	}
+
+	if (wframe->rr == NULL) {
+		wframe->rr = RE_DuplicateRenderResult(rr);
+	}
+
+	wfile = render_write_frame_add(wframe, name, imf);
+	if (view) {
+		BLI_strncpy(wfile->view, view, sizeof(wfile->view));
+	}
+
+	return true;
+}
+
+/* Finish frames in render order, waiting until no more than max_pending are left.
+ * Returns false when a file of one of the finished frames failed to write. */
+static bool render_write_queue_finish(Render *re, Scene *scene, RenderWriteQueue *queue, int max_pending)
+{
+	RenderWriteFrame *wframe;
+	bool ok = true;
+
+	while ((wframe = queue->frames.first)) {
+		RenderWriteFile *wfile;
+		bool frame_ok = true;
+
+		BLI_mutex_lock(&queue->mutex);
+		if (!wframe->done && BLI_listbase_count_at_most(&queue->frames, max_pending + 1) <= max_pending) {
+			BLI_mutex_unlock(&queue->mutex);
+			break;
+		}
+		while (!wframe->done) {
+			BLI_condition_wait(&queue->done_cond, &queue->mutex);
+		}
+		BLI_mutex_unlock(&queue->mutex);
+
+		for (wfile = wframe->files.first; wfile; wfile = wfile->next) {
+			render_print_save_message(re->reports, wfile->name, wfile->ok, wfile->err);
+			frame_ok &= wfile->ok;
+		}
+
+		if (frame_ok) {
+			/* handlers expect the written frame to be the current one */
+			const int cfra = scene->r.cfra;
+			scene->r.cfra = wframe->cfra;
+			BLI_callback_exec(re->main, (ID *)scene, BLI_CB_EVT_RENDER_WRITE);
+			scene->r.cfra = cfra;
+		}
+		ok &= frame_ok;
+
+		BLI_remlink(&queue->frames, wframe);
+		render_write_frame_free(wframe);
+	}
+
+	return ok;
+}
+
+static bool render_write_queue_push(Render *re, Scene *scene, RenderWriteQueue *queue, RenderWriteFrame *wframe)
+{
+	/* make room first, so no more than RE_WRITE_QUEUE_MAX_FRAMES copies are alive */
+	bool ok = render_write_queue_finish(re, scene, queue, RE_WRITE_QUEUE_MAX_FRAMES - 1);
+
+	BLI_addtail(&queue->frames, wframe);
+	BLI_thread_queue_push(queue->todo, wframe);
+
+	return ok;
+}
+
+static bool render_write_queue_free(Render *re, Scene *scene, RenderWriteQueue *queue)
+{
+	bool ok = render_write_queue_finish(re, scene, queue, 0);
+
+	BLI_thread_queue_nowait(queue->todo);
+	BLI_threadpool_end(&queue->threads);
+	BLI_thread_queue_free(queue->todo);
+	BLI_condition_end(&queue->done_cond);
+	BLI_mutex_end(&queue->mutex);
+	MEM_freeN(queue);
+
+	return ok;
+}
+
 void RE_FreeRenderResult(RenderResult *res)
 {
 	render_result_free(res);
@@ -3323,7 +3559,7 @@ void RE_BlenderFrame(Render *re, Main *bmain, Scene *scene, SceneRenderLayer *sr
 				        &scene->r.im_format, (scene->r.scemode & R_EXTENSION) != 0, false, NULL);
 
 				/* reports only used for Movie */
-				do_write_image_or_movie(re, bmain, scene, NULL, 0, name);
+				do_write_image_or_movie(re, bmain, scene, NULL, 0, name, NULL);
 			}
 		}
 
@@ -3368,7 +3604,9 @@ void RE_RenderFreestyleExternal(Render *re)
 }
 #endif
 
-bool RE_WriteRenderViewsImage(ReportList *reports, RenderResult *rr, Scene *scene, const bool stamp, char *name)
+static bool render_write_views_image(
+        ReportList *reports, RenderResult *rr, Scene *scene, const bool stamp, char *name,
+        RenderWriteFrame *wframe)
 {
 	bool ok = true;
 	RenderData *rd = &scene->r;
@@ -3382,8 +3620,7 @@ bool RE_WriteRenderViewsImage(ReportList *reports, RenderResult *rr, Scene *scen
 
 	if (rd->im_format.views_format == R_IMF_VIEWS_MULTIVIEW && is_exr_rr)
 	{
-		ok = RE_WriteRenderResult(reports, rr, name, &rd->im_format, NULL, -1);
-		render_print_save_message(reports, name, ok, errno);
+		ok = render_write_result(reports, rr, name, &rd->im_format, NULL, wframe);
 	}
 
 	/* mono, legacy code */
@@ -3401,8 +3638,7 @@ bool RE_WriteRenderViewsImage(ReportList *reports, RenderResult *rr, Scene *scen
 			}
 
 			if (is_exr_rr) {
-				ok = RE_WriteRenderResult(reports, rr, name, &rd->im_format, rv->name, -1);
-				render_print_save_message(reports, name, ok, errno);
+				ok = render_write_result(reports, rr, name, &rd->im_format, rv->name, wframe);
 
 				/* optional preview images for exr */
 				if (ok && (rd->im_format.flag & R_IMF_FLAG_PREVIEW_JPG)) {
@@ -3416,7 +3652,7 @@ bool RE_WriteRenderViewsImage(ReportList *reports, RenderResult *rr, Scene *scen
 					ImBuf *ibuf = render_result_rect_to_ibuf(rr, rd, view_id);
 					ibuf->planes = 24;
 
-					ok = render_imbuf_write_stamp_test(reports, scene, rr, ibuf, name, &imf, stamp);
+					ok = render_write_ibuf(reports, scene, rr, ibuf, name, &imf, stamp, wframe);
 
 					IMB_freeImBuf(ibuf);
 				}
@@ -3427,7 +3663,7 @@ bool RE_WriteRenderViewsImage(ReportList *reports, RenderResult *rr, Scene *scen
 				IMB_colormanagement_imbuf_for_write(ibuf, true, false, &scene->view_settings,
 				                                    &scene->display_settings, &rd->im_format);
 
-				ok = render_imbuf_write_stamp_test(reports, scene, rr, ibuf, name, &rd->im_format, stamp);
+				ok = render_write_ibuf(reports, scene, rr, ibuf, name, &rd->im_format, stamp, wframe);
 
 				/* imbuf knows which rects are not part of ibuf */
 				IMB_freeImBuf(ibuf);
@@ -3455,7 +3691,7 @@ bool RE_WriteRenderViewsImage(ReportList *reports, RenderResult *rr, Scene *scen
 
 			ibuf_arr[2] = IMB_stereo3d_ImBuf(&scene->r.im_format, ibuf_arr[0], ibuf_arr[1]);
 
-			ok = render_imbuf_write_stamp_test(reports, scene, rr, ibuf_arr[2], name, &rd->im_format, stamp);
+			ok = render_write_ibuf(reports, scene, rr, ibuf_arr[2], name, &rd->im_format, stamp, wframe);
 
 			/* optional preview images for exr */
 			if (ok && is_exr_rr &&
@@ -3470,7 +3706,7 @@ bool RE_WriteRenderViewsImage(ReportList *reports, RenderResult *rr, Scene *scen
 				BKE_image_path_ensure_ext_from_imformat(name, &imf);
 				ibuf_arr[2]->planes = 24;
 
-				ok = render_imbuf_write_stamp_test(reports, scene, rr, ibuf_arr[2], name, &rd->im_format, stamp);
+				ok = render_write_ibuf(reports, scene, rr, ibuf_arr[2], name, &rd->im_format, stamp, wframe);
 			}
 
 			/* imbuf knows which rects are not part of ibuf */
@@ -3483,6 +3719,11 @@ bool RE_WriteRenderViewsImage(ReportList *reports, RenderResult *rr, Scene *scen
 	return ok;
 }
 
+bool RE_WriteRenderViewsImage(ReportList *reports, RenderResult *rr, Scene *scene, const bool stamp, char *name)
+{
+	return render_write_views_image(reports, rr, scene, stamp, name, NULL);
+}
+
 bool RE_WriteRenderViewsMovie(
         ReportList *reports, RenderResult *rr, Scene *scene, RenderData *rd, bMovieHandle *mh,
         void **movie_ctx_arr, const int totvideos, bool preview)
@@ -3541,10 +3782,12 @@ bool RE_WriteRenderViewsMovie(
 	return ok;
 }
 
-static int do_write_image_or_movie(Render *re, Main *bmain, Scene *scene, bMovieHandle *mh, const int totvideos, const char *name_override)
+static int do_write_image_or_movie(Render *re, Main *bmain, Scene *scene, bMovieHandle *mh, const int totvideos,
+                                   const char *name_override, RenderWriteQueue *write_queue)
 {
 	char name[FILE_MAX];
 	RenderResult rres;
+	RenderWriteFrame *wframe = NULL;
 	double render_time;
 	bool ok = true;
 
@@ -3562,12 +3805,20 @@ static int do_write_image_or_movie(Render *re, Main *bmain, Scene *scene, bMovie
 			        name, scene->r.pic, BKE_main_blendfile_path(bmain), scene->r.cfra,
 			        &scene->r.im_format, (scene->r.scemode & R_EXTENSION) != 0, true, NULL);
 
+		if (write_queue) {
+			wframe = render_write_frame_new(scene->r.cfra);
+		}
+
 		/* write images as individual images or stereo */
-		ok = RE_WriteRenderViewsImage(re->reports, &rres, scene, true, name);
+		ok = render_write_views_image(re->reports, &rres, scene, true, name, wframe);
 	}
 
 	RE_ReleaseResultImageViews(re, &rres);
 
+	if (wframe) {
+		ok &= render_write_queue_push(re, scene, write_queue, wframe);
+	}
+
 	render_time = re->i.lastframetime;
 	re->i.lastframetime = PIL_check_seconds_timer() - re->i.starttime;
 
@@ -3629,6 +3880,7 @@ void RE_BlenderAnim(Render *re, Main *bmain, Scene *scene, Object *camera_overri
 {
 	RenderData rd = scene->r;
 	bMovieHandle *mh = NULL;
+	RenderWriteQueue *write_queue = NULL;
 	int cfrao = scene->r.cfra;
 	int nfra, totrendered = 0, totskipped = 0;
 	const int totvideos = BKE_scene_multiview_num_videos_get(&rd);
@@ -3690,6 +3942,10 @@ void RE_BlenderAnim(Render *re, Main *bmain, Scene *scene, Object *camera_overri
 
 	re->flag |= R_ANIMATION;
 
+	if (!is_movie) {
+		write_queue = render_write_queue_create();
+	}
+
 	{
 		for (nfra = sfra, scene->r.cfra = sfra; scene->r.cfra <= efra; scene->r.cfra++) {
 			char name[FILE_MAX];
@@ -3826,7 +4082,7 @@ void RE_BlenderAnim(Render *re, Main *bmain, Scene *scene, Object *camera_overri
 
 			if (re->test_break(re->tbh) == 0) {
 				if (!G.is_break)
-					if (!do_write_image_or_movie(re, bmain, scene, mh, totvideos, NULL))
+					if (!do_write_image_or_movie(re, bmain, scene, mh, totvideos, NULL, write_queue))
 						G.is_break = true;
 			}
 			else
@@ -3866,7 +4122,10 @@ void RE_BlenderAnim(Render *re, Main *bmain, Scene *scene, Object *camera_overri
 
 			if (G.is_break == false) {
 				BLI_callback_exec(re->main, (ID *)scene, BLI_CB_EVT_RENDER_POST); /* keep after file save */
-				BLI_callback_exec(re->main, (ID *)scene, BLI_CB_EVT_RENDER_WRITE);
+				/* queued frames run the write handlers once their files are written */
+				if (write_queue == NULL) {
+					BLI_callback_exec(re->main, (ID *)scene, BLI_CB_EVT_RENDER_WRITE);
+				}
 			}
 		}
 	}
@@ -3876,6 +4135,13 @@ void RE_BlenderAnim(Render *re, Main *bmain, Scene *scene, Object *camera_overri
 		re_movie_free_all(re, mh, totvideos);
 	}
 
+	/* wait for the last frames to be written */
+	if (write_queue) {
+		if (!render_write_queue_free(re, scene, write_queue)) {
+			G.is_break = true;
+		}
+	}
+
 	if (totskipped && totrendered == 0)
 		BKE_report(re->reports, RPT_INFO, "No frames rendered, skipped to not overwrite");
 
@@ -1540,6 +1540,6 @@ RenderResult *RE_DuplicateRenderResult(RenderResult *rr)
 	if (new_rr->rectz != NULL) {
 		new_rr->rectz = MEM_dupallocN(new_rr->rectz);
 	}
-	new_rr->stamp_data = MEM_dupallocN(new_rr->stamp_data);
+	new_rr->stamp_data = BKE_stamp_data_copy(new_rr->stamp_data);
 	return new_rr;
 }
@@ -59,6 +59,7 @@
 #include "BKE_report.h"
 #include "BKE_scene.h"
 #include "BKE_screen.h"
+#include "BKE_sequencer.h"
 
 #include "BKE_sound.h"
 
@@ -777,6 +778,14 @@ static void wm_operator_finished(bContext *C, wmOperator *op, const bool repeat,
 	}
 }
 
+/* operators changing data stop sequencer prefetching first, which reads the strips from worker threads */
+static void wm_operator_edit_begin(const wmOperatorType *ot)
+{
+	if (ot->flag & (OPTYPE_UNDO | OPTYPE_UNDO_GROUPED)) {
+		BKE_sequencer_prefetch_stop();
+	}
+}
+
 /* if repeat is true, it doesn't register again, nor does it free */
 static int wm_operator_exec(bContext *C, wmOperator *op, const bool repeat, const bool store)
 {
@@ -792,6 +801,8 @@ static int wm_operator_exec(bContext *C, wmOperator *op, const bool repeat, cons
 		return retval;
 
 	if (op->type->exec) {
+		wm_operator_edit_begin(op->type);
+
 		if (op->type->flag & OPTYPE_UNDO) {
 			wm->op_undo_depth++;
 		}
@@ -838,6 +849,8 @@ static int wm_operator_exec_notest(bContext *C, wmOperator *op)
 	if (op == NULL || op->type == NULL || op->type->exec == NULL)
 		return retval;
 
+	wm_operator_edit_begin(op->type);
+
 	retval = op->type->exec(C, op);
 	OPERATOR_RETVAL_CHECK(retval);
 
@@ -1158,6 +1171,8 @@ static int wm_operator_invoke(
 		if (op->type->invoke && event) {
 			wm_region_mouse_co(C, event);
 
+			wm_operator_edit_begin(op->type);
+
 			if (op->type->flag & OPTYPE_UNDO)
 				wm->op_undo_depth++;
 
@@ -1168,6 +1183,8 @@ static int wm_operator_invoke(
 				wm->op_undo_depth--;
 		}
 		else if (op->type->exec) {
+			wm_operator_edit_begin(op->type);
+
 			if (op->type->flag & OPTYPE_UNDO)
 				wm->op_undo_depth++;
 
@@ -1789,6 +1806,8 @@ static int wm_handler_operator_call(bContext *C, ListBase *handlers, wmEventHand
 			wm_region_mouse_co(C, event);
 			wm_event_modalkeymap(C, op, event, &dbl_click_disabled);
 
+			wm_operator_edit_begin(ot);
+
 			if (ot->flag & OPTYPE_UNDO)
 				wm->op_undo_depth++;
 
@@ -0,0 +1,168 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <cmath>
+#include <cstdlib>
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "seqeffects_intern.h"
+}
+
+/* not a multiple of four, so the pixels after the SIMD loop are tested too,
+ * more than one line so the factor of the second field is used */
+#define SIZE_X 37
+#define SIZE_Y 6
+
+/* factors of both fields, the crosses and alpha over have shortcuts for zero and one */
+static const float test_factors[][2] = {
+	{0.0f, 1.0f},
+	{0.3f, 0.7f},
+	{1.0f, 0.5f},
+};
+
+typedef void (*SeqKernelByte)(float, float, int, int, const unsigned char *, const unsigned char *, unsigned char *);
+typedef void (*SeqKernelFloat)(float, float, int, int, const float *, const float *, float *);
+
+static float seqeffects_random(unsigned int *seed)
+{
+	*seed = *seed * 1103515245u + 12345u;
+	return (float)((*seed >> 8) & 0xffff) / 65535.0f;
+}
+
+/* alpha zero, one and in between, for the opaque and transparent shortcuts of alpha over and under */
+static unsigned char *seqeffects_test_byte(unsigned int seed)
+{
+	unsigned char *rect = (unsigned char *)MEM_mallocN(sizeof(unsigned char) * 4 * SIZE_X * SIZE_Y, __func__);
+
+	for (int i = 0; i < SIZE_X * SIZE_Y; i++) {
+		unsigned char *pixel = rect + i * 4;
+		pixel[0] = (unsigned char)(seqeffects_random(&seed) * 255.0f);
+		pixel[1] = (unsigned char)(seqeffects_random(&seed) * 255.0f);
+		pixel[2] = (unsigned char)(seqeffects_random(&seed) * 255.0f);
+		pixel[3] = (i % 5 == 0) ? 0 : (i % 5 == 1) ? 255 : (unsigned char)(seqeffects_random(&seed) * 255.0f);
+	}
+
+	return rect;
+}
+
+/* premultiplied colors, some of them negative or above one */
+static float *seqeffects_test_float(unsigned int seed)
+{
+	float *rect = (float *)MEM_mallocN(sizeof(float) * 4 * SIZE_X * SIZE_Y, __func__);
+
+	for (int i = 0; i < SIZE_X * SIZE_Y; i++) {
+		float *pixel = rect + i * 4;
+		pixel[3] = (i % 5 == 0) ? 0.0f : (i % 5 == 1) ? 1.0f : seqeffects_random(&seed);
+		pixel[0] = (seqeffects_random(&seed) * 1.2f - 0.1f) * pixel[3];
+		pixel[1] = seqeffects_random(&seed) * pixel[3];
+		pixel[2] = seqeffects_random(&seed) * 2.0f;
+	}
+
+	return rect;
+}
+
+TEST(seqeffects, CrossByteEndpoints)
+{
+	unsigned char *rect1 = seqeffects_test_byte(1);
+	unsigned char *rect2 = seqeffects_test_byte(2);
+	unsigned char out[SIZE_X * SIZE_Y * 4];
+
+	/* even lines get the first input, odd lines the second */
+	seq_cross_byte_scalar(0.0f, 1.0f, SIZE_X, SIZE_Y, rect1, rect2, out);
+
+	for (int i = 0; i < SIZE_X * SIZE_Y * 4; i++) {
+		const int line = i / (SIZE_X * 4);
+		EXPECT_EQ((line & 1) ? rect2[i] : rect1[i], out[i]);
+	}
+
+	MEM_freeN(rect1);
+	MEM_freeN(rect2);
+}
+
+TEST(seqeffects, CrossFloatEndpoints)
+{
+	float *rect1 = seqeffects_test_float(1);
+	float *rect2 = seqeffects_test_float(2);
+	float out[SIZE_X * SIZE_Y * 4];
+
+	/* even lines get the first input, odd lines the second */
+	seq_cross_float_scalar(0.0f, 1.0f, SIZE_X, SIZE_Y, rect1, rect2, out);
+
+	for (int i = 0; i < SIZE_X * SIZE_Y * 4; i++) {
+		const int line = i / (SIZE_X * 4);
+		EXPECT_EQ((line & 1) ? rect2[i] : rect1[i], out[i]);
+	}
+
+	MEM_freeN(rect1);
+	MEM_freeN(rect2);
+}
+
+#ifdef __SSE2__
+
+static void seqeffects_compare_byte(SeqKernelByte kernel_a, SeqKernelByte kernel_b)
+{
+	unsigned char *rect1 = seqeffects_test_byte(1);
+	unsigned char *rect2 = seqeffects_test_byte(2);
+	unsigned char out_a[SIZE_X * SIZE_Y * 4], out_b[SIZE_X * SIZE_Y * 4];
+
+	for (int f = 0; f < (int)ARRAY_SIZE(test_factors); f++) {
+		kernel_a(test_factors[f][0], test_factors[f][1], SIZE_X, SIZE_Y, rect1, rect2, out_a);
+		kernel_b(test_factors[f][0], test_factors[f][1], SIZE_X, SIZE_Y, rect1, rect2, out_b);
+
+		/* float to byte conversions may round differently */
+		for (int i = 0; i < SIZE_X * SIZE_Y * 4; i++) {
+			EXPECT_LE(abs((int)out_a[i] - (int)out_b[i]), 1) << "pixel " << i / 4 << " factor " << f;
+		}
+	}
+
+	MEM_freeN(rect1);
+	MEM_freeN(rect2);
+}
+
+static void seqeffects_compare_float(SeqKernelFloat kernel_a, SeqKernelFloat kernel_b)
+{
+	float *rect1 = seqeffects_test_float(1);
+	float *rect2 = seqeffects_test_float(2);
+	float out_a[SIZE_X * SIZE_Y * 4], out_b[SIZE_X * SIZE_Y * 4];
+
+	for (int f = 0; f < (int)ARRAY_SIZE(test_factors); f++) {
+		kernel_a(test_factors[f][0], test_factors[f][1], SIZE_X, SIZE_Y, rect1, rect2, out_a);
+		kernel_b(test_factors[f][0], test_factors[f][1], SIZE_X, SIZE_Y, rect1, rect2, out_b);
+
+		for (int i = 0; i < SIZE_X * SIZE_Y * 4; i++) {
+			EXPECT_NEAR(out_a[i], out_b[i], 1e-5f) << "pixel " << i / 4 << " factor " << f;
+		}
+	}
+
+	MEM_freeN(rect1);
+	MEM_freeN(rect2);
+}
+
+TEST(seqeffects, AlphaOverSSE2)
+{
+	seqeffects_compare_byte(seq_alphaover_byte_scalar, seq_alphaover_byte_sse2);
+	seqeffects_compare_float(seq_alphaover_float_scalar, seq_alphaover_float_sse2);
+}
+
+TEST(seqeffects, AlphaUnderSSE2)
+{
+	seqeffects_compare_byte(seq_alphaunder_byte_scalar, seq_alphaunder_byte_sse2);
+	seqeffects_compare_float(seq_alphaunder_float_scalar, seq_alphaunder_float_sse2);
+}
+
+TEST(seqeffects, CrossSSE2)
+{
+	seqeffects_compare_byte(seq_cross_byte_scalar, seq_cross_byte_sse2);
+	seqeffects_compare_float(seq_cross_float_scalar, seq_cross_float_sse2);
+}
+
+TEST(seqeffects, GammaCrossSSE2)
+{
+	seqeffects_compare_byte(seq_gammacross_byte_scalar, seq_gammacross_byte_sse2);
+	seqeffects_compare_float(seq_gammacross_float_scalar, seq_gammacross_float_sse2);
+}
+
+#endif  /* __SSE2__ */
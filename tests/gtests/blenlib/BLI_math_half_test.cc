@@ -0,0 +1,84 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <math.h>
+
+#include "BLI_math_half.h"
+
+TEST(math_half, FloatToHalfExact)
+{
+	EXPECT_EQ(0x0000, float_to_half(0.0f));
+	EXPECT_EQ(0x8000, float_to_half(-0.0f));
+	EXPECT_EQ(0x3c00, float_to_half(1.0f));
+	EXPECT_EQ(0xc000, float_to_half(-2.0f));
+	EXPECT_EQ(0x3555, float_to_half(0.333251953125f));
+	EXPECT_EQ(0x7bff, float_to_half(65504.0f));
+	EXPECT_EQ(0x0400, float_to_half(6.103515625e-05f));  /* smallest normal */
+	EXPECT_EQ(0x0001, float_to_half(5.9604644775390625e-08f));  /* smallest denormal */
+}
+
+TEST(math_half, FloatToHalfRounding)
+{
+	/* halfway between 1 and the next half, rounds to even */
+	EXPECT_EQ(0x3c00, float_to_half(1.00048828125f));
+	/* halfway between the next two halves, rounds to even */
+	EXPECT_EQ(0x3c02, float_to_half(1.00146484375f));
+	EXPECT_EQ(0x3c01, float_to_half(1.0006f));
+	/* max half, and values rounding to infinity */
+	EXPECT_EQ(0x7bff, float_to_half(65519.0f));
+	EXPECT_EQ(0x7c00, float_to_half(65520.0f));
+	EXPECT_EQ(0xfc00, float_to_half(-1e10f));
+	/* denormals */
+	EXPECT_EQ(0x0000, float_to_half(2.98023223876953125e-08f));  /* 2^-25, halfway to even zero */
+	EXPECT_EQ(0x0001, float_to_half(3.0e-08f));
+	EXPECT_EQ(0x0000, float_to_half(1e-10f));
+}
+
+TEST(math_half, FloatToHalfSpecial)
+{
+	EXPECT_EQ(0x7c00, float_to_half(INFINITY));
+	EXPECT_EQ(0xfc00, float_to_half(-INFINITY));
+	EXPECT_EQ(0x7e00, float_to_half(NAN) & 0x7e00);
+}
+
+TEST(math_half, HalfToFloat)
+{
+	EXPECT_EQ(0.0f, half_to_float(0x0000));
+	EXPECT_EQ(1.0f, half_to_float(0x3c00));
+	EXPECT_EQ(-2.0f, half_to_float(0xc000));
+	EXPECT_EQ(65504.0f, half_to_float(0x7bff));
+	EXPECT_EQ(5.9604644775390625e-08f, half_to_float(0x0001));
+	EXPECT_EQ(-6.097555160522461e-05f, half_to_float(0x83ff));
+	EXPECT_EQ(INFINITY, half_to_float(0x7c00));
+	EXPECT_TRUE(isnan(half_to_float(0x7e00)));
+}
+
+TEST(math_half, RoundTrip)
+{
+	/* every half except NaNs converts to float and back without change */
+	for (unsigned int h = 0; h < 65536; h++) {
+		if ((h & 0x7c00) == 0x7c00 && (h & 0x3ff)) {
+			continue;
+		}
+		EXPECT_EQ(h, float_to_half(half_to_float((unsigned short)h)));
+	}
+}
+
+TEST(math_half, Arrays)
+{
+	const float src[7] = {0.0f, 1.0f, -0.5f, 1.00048828125f, 1e10f, 0.1f, 3.0f};
+	unsigned short half[7];
+	float dst[7];
+
+	/* the vectorized and remaining elements give the same result as the scalar conversion */
+	BLI_float_to_half_array(half, src, 7);
+	for (int i = 0; i < 7; i++) {
+		EXPECT_EQ(float_to_half(src[i]), half[i]);
+	}
+
+	BLI_half_to_float_array(dst, half, 7);
+	for (int i = 0; i < 7; i++) {
+		EXPECT_EQ(half_to_float(half[i]), dst[i]);
+	}
+}
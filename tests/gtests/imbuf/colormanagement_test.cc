@@ -0,0 +1,73 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "DNA_color_types.h"
+#include "BKE_colortools.h"
+#include "IMB_imbuf.h"
+#include "IMB_colormanagement.h"
+}
+
+/* values per channel, half of them just below white where display transforms clip */
+#define DISPLAY_LUT_TEST_STEPS 48
+
+static float display_lut_test_value(int i)
+{
+	if (i < DISPLAY_LUT_TEST_STEPS / 2) {
+		return 1.25f * i / (DISPLAY_LUT_TEST_STEPS / 2 - 1);
+	}
+	return 1.0f - (float)(i - DISPLAY_LUT_TEST_STEPS / 2) / 512.0f;
+}
+
+/* the baked display LUT against the exact OCIO processor, where the result is stored in bytes */
+TEST(colormanagement, DisplayLUTAccuracy)
+{
+	const int num_pixels = DISPLAY_LUT_TEST_STEPS * DISPLAY_LUT_TEST_STEPS * DISPLAY_LUT_TEST_STEPS;
+	ColorManagedViewSettings view_settings = {0};
+	ColorManagedDisplaySettings display_settings = {{0}};
+	ColormanageProcessor *cm_processor;
+	float *exact, *baked;
+	float max_error = 0.0f;
+
+	IMB_init();
+
+	BKE_color_managed_view_settings_init(&view_settings);
+	BKE_color_managed_display_settings_init(&display_settings);
+
+	exact = (float *)MEM_mallocN(sizeof(float) * 4 * num_pixels, __func__);
+	for (int i = 0; i < num_pixels; i++) {
+		float *pixel = exact + i * 4;
+		pixel[0] = display_lut_test_value(i % DISPLAY_LUT_TEST_STEPS);
+		pixel[1] = display_lut_test_value((i / DISPLAY_LUT_TEST_STEPS) % DISPLAY_LUT_TEST_STEPS);
+		pixel[2] = display_lut_test_value(i / (DISPLAY_LUT_TEST_STEPS * DISPLAY_LUT_TEST_STEPS));
+		pixel[3] = 1.0f;
+	}
+	baked = (float *)MEM_dupallocN(exact);
+
+	cm_processor = IMB_colormanagement_display_processor_new(&view_settings, &display_settings);
+	IMB_colormanagement_processor_apply(cm_processor, exact, num_pixels, 1, 4, false);
+	IMB_colormanagement_processor_free(cm_processor);
+
+	cm_processor = IMB_colormanagement_display_processor_new(&view_settings, &display_settings);
+	IMB_colormanagement_processor_use_display_lut(cm_processor, &view_settings, &display_settings);
+	IMB_colormanagement_processor_apply(cm_processor, baked, num_pixels, 1, 4, false);
+	IMB_colormanagement_processor_free(cm_processor);
+
+	/* only the range stored in bytes matters */
+	for (int i = 0; i < num_pixels * 4; i++) {
+		const float error = fabsf(clamp_f(exact[i], 0.0f, 1.0f) - clamp_f(baked[i], 0.0f, 1.0f));
+		max_error = max_ff(max_error, error);
+	}
+
+	/* a quarter of a byte step, so rounding to bytes rarely differs */
+	EXPECT_LE(max_error, 0.25f / 255.0f);
+
+	MEM_freeN(exact);
+	MEM_freeN(baked);
+
+	IMB_exit();
+}
@@ -0,0 +1,67 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "PIL_time.h"
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+}
+
+#define BENCHMARK_X 7680
+#define BENCHMARK_Y 4320
+
+static float conversion_random(unsigned int *seed)
+{
+	*seed = *seed * 1103515245u + 12345u;
+	return (float)((*seed >> 8) & 0xffff) / 65535.0f;
+}
+
+/* values slightly out of range, with alpha zero and one for the predivide special cases */
+static float *conversion_test_float(int x, int y)
+{
+	float *rect = (float *)MEM_mallocN(sizeof(float) * 4 * x * y, __func__);
+	unsigned int seed = 0;
+
+	for (int i = 0; i < x * y; i++) {
+		float *pixel = rect + i * 4;
+		pixel[0] = conversion_random(&seed) * 1.2f - 0.1f;
+		pixel[1] = conversion_random(&seed);
+		pixel[2] = (i % 3 == 0) ? 1.0f - 0.5f / 255.0f : conversion_random(&seed);
+		pixel[3] = (i % 5 == 0) ? 0.0f : (i % 5 == 1) ? 1.0f : conversion_random(&seed);
+	}
+
+	return rect;
+}
+
+TEST(conversion, Convert8K)
+{
+	IMB_init();
+
+	ImBuf *ibuf = IMB_allocImBuf(BENCHMARK_X, BENCHMARK_Y, 32, IB_rectfloat);
+	float *rect_float = conversion_test_float(BENCHMARK_X, BENCHMARK_Y);
+
+	memcpy(ibuf->rect_float, rect_float, sizeof(float) * 4 * BENCHMARK_X * BENCHMARK_Y);
+	MEM_freeN(rect_float);
+
+	double start = PIL_check_seconds_timer();
+	IMB_rect_from_float(ibuf);
+	printf("%-24s %8.3f ms\n", "IMB_rect_from_float", (PIL_check_seconds_timer() - start) * 1000.0);
+
+	imb_freerectfloatImBuf(ibuf);
+
+	start = PIL_check_seconds_timer();
+	IMB_float_from_rect(ibuf);
+	printf("%-24s %8.3f ms\n", "IMB_float_from_rect", (PIL_check_seconds_timer() - start) * 1000.0);
+
+	ibuf->dither = 1.0f;
+	start = PIL_check_seconds_timer();
+	IMB_rect_from_float(ibuf);
+	printf("%-24s %8.3f ms\n", "IMB_rect_from_float dither", (PIL_check_seconds_timer() - start) * 1000.0);
+
+	IMB_freeImBuf(ibuf);
+
+	IMB_exit();
+}
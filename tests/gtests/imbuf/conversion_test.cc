@@ -0,0 +1,174 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+}
+
+/* not a multiple of four, so the pixels after the SIMD loop are tested too */
+#define SIZE_X 37
+#define SIZE_Y 5
+
+static float conversion_random(unsigned int *seed)
+{
+	*seed = *seed * 1103515245u + 12345u;
+	return (float)((*seed >> 8) & 0xffff) / 65535.0f;
+}
+
+/* values slightly out of range, with alpha zero and one for the predivide special cases */
+static float *conversion_test_float(int x, int y)
+{
+	float *rect = (float *)MEM_mallocN(sizeof(float) * 4 * x * y, __func__);
+	unsigned int seed = 0;
+
+	for (int i = 0; i < x * y; i++) {
+		float *pixel = rect + i * 4;
+		pixel[0] = conversion_random(&seed) * 1.2f - 0.1f;
+		pixel[1] = conversion_random(&seed);
+		pixel[2] = (i % 3 == 0) ? 1.0f - 0.5f / 255.0f : conversion_random(&seed);
+		pixel[3] = (i % 5 == 0) ? 0.0f : (i % 5 == 1) ? 1.0f : conversion_random(&seed);
+	}
+
+	return rect;
+}
+
+static unsigned char *conversion_test_byte(int x, int y)
+{
+	unsigned char *rect = (unsigned char *)MEM_mallocN(sizeof(unsigned char) * 4 * x * y, __func__);
+
+	for (int i = 0; i < x * y * 4; i++) {
+		rect[i] = (unsigned char)(i * 7);
+	}
+
+	return rect;
+}
+
+TEST(conversion, ByteFromFloat)
+{
+	float *rect_from = conversion_test_float(SIZE_X, SIZE_Y);
+	unsigned char rect_to[SIZE_X * SIZE_Y * 4];
+
+	for (int profile_to = IB_PROFILE_LINEAR_RGB; profile_to <= IB_PROFILE_SRGB; profile_to++) {
+		for (int predivide = 0; predivide < 2; predivide++) {
+			IMB_buffer_byte_from_float(rect_to, rect_from, 4, 0.0f, profile_to, IB_PROFILE_SRGB, predivide,
+			                           SIZE_X, SIZE_Y, SIZE_X, SIZE_X);
+
+			for (int i = 0; i < SIZE_X * SIZE_Y; i++) {
+				float tmp[4];
+				unsigned char expected[4];
+
+				if (profile_to == IB_PROFILE_LINEAR_RGB && predivide)
+					srgb_to_linearrgb_predivide_v4(tmp, rect_from + i * 4);
+				else if (profile_to == IB_PROFILE_LINEAR_RGB)
+					srgb_to_linearrgb_v4(tmp, rect_from + i * 4);
+				else if (predivide)
+					premul_to_straight_v4_v4(tmp, rect_from + i * 4);
+				else
+					copy_v4_v4(tmp, rect_from + i * 4);
+				rgba_float_to_uchar(expected, tmp);
+
+				for (int c = 0; c < 4; c++) {
+					EXPECT_EQ(expected[c], rect_to[i * 4 + c]);
+				}
+			}
+		}
+	}
+
+	MEM_freeN(rect_from);
+}
+
+TEST(conversion, ByteFromFloatDither)
+{
+	const int x = 300, y = 200;
+	float *rect_from = conversion_test_float(x, y);
+	unsigned char *rect_to = (unsigned char *)MEM_mallocN(sizeof(unsigned char) * 4 * x * y, __func__);
+	unsigned char *rect_threaded = (unsigned char *)MEM_mallocN(sizeof(unsigned char) * 4 * x * y, __func__);
+	unsigned char *rect_plain = (unsigned char *)MEM_mallocN(sizeof(unsigned char) * 4 * x * y, __func__);
+	int changed = 0;
+
+	IMB_buffer_byte_from_float(rect_plain, rect_from, 4, 0.0f, IB_PROFILE_SRGB, IB_PROFILE_SRGB, false,
+	                           x, y, x, x);
+	IMB_buffer_byte_from_float(rect_to, rect_from, 4, 1.0f, IB_PROFILE_SRGB, IB_PROFILE_SRGB, false,
+	                           x, y, x, x);
+	IMB_buffer_byte_from_float_threaded(rect_threaded, rect_from, 4, 1.0f, IB_PROFILE_SRGB, IB_PROFILE_SRGB, false,
+	                                    x, y, x, x);
+
+	/* the noise only depends on the pixel position, not on the rows done by a thread */
+	EXPECT_EQ(0, memcmp(rect_to, rect_threaded, sizeof(unsigned char) * 4 * x * y));
+
+	for (int i = 0; i < x * y; i++) {
+		/* noise is below 0.005, so at most two steps */
+		for (int c = 0; c < 3; c++) {
+			EXPECT_NEAR(rect_plain[i * 4 + c], rect_to[i * 4 + c], 2);
+			changed += rect_plain[i * 4 + c] != rect_to[i * 4 + c];
+		}
+		EXPECT_EQ(rect_plain[i * 4 + 3], rect_to[i * 4 + 3]);
+	}
+
+	EXPECT_GT(changed, x * y / 10);
+
+	MEM_freeN(rect_from);
+	MEM_freeN(rect_to);
+	MEM_freeN(rect_threaded);
+	MEM_freeN(rect_plain);
+}
+
+TEST(conversion, FloatFromByte)
+{
+	unsigned char *rect_from = conversion_test_byte(SIZE_X, SIZE_Y);
+	float rect_to[SIZE_X * SIZE_Y * 4];
+
+	for (int profile_to = IB_PROFILE_LINEAR_RGB; profile_to <= IB_PROFILE_SRGB; profile_to++) {
+		for (int predivide = 0; predivide < 2; predivide++) {
+			IMB_buffer_float_from_byte(rect_to, rect_from, profile_to, IB_PROFILE_LINEAR_RGB, predivide,
+			                           SIZE_X, SIZE_Y, SIZE_X, SIZE_X);
+
+			for (int i = 0; i < SIZE_X * SIZE_Y; i++) {
+				float expected[4];
+
+				rgba_uchar_to_float(expected, rect_from + i * 4);
+				if (profile_to == IB_PROFILE_SRGB && predivide)
+					linearrgb_to_srgb_predivide_v4(expected, expected);
+				else if (profile_to == IB_PROFILE_SRGB)
+					linearrgb_to_srgb_v4(expected, expected);
+
+				for (int c = 0; c < 4; c++) {
+					EXPECT_EQ(expected[c], rect_to[i * 4 + c]);
+				}
+			}
+		}
+	}
+
+	MEM_freeN(rect_from);
+}
+
+TEST(conversion, Premultiply)
+{
+	float *rect = conversion_test_float(SIZE_X, SIZE_Y);
+	float *rect_premul = (float *)MEM_dupallocN(rect);
+	float *rect_straight = (float *)MEM_dupallocN(rect);
+
+	IMB_buffer_float_premultiply(rect_premul, SIZE_X, SIZE_Y);
+	IMB_buffer_float_unpremultiply(rect_straight, SIZE_X, SIZE_Y);
+
+	for (int i = 0; i < SIZE_X * SIZE_Y; i++) {
+		float expected_premul[4], expected_straight[4];
+
+		straight_to_premul_v4_v4(expected_premul, rect + i * 4);
+		premul_to_straight_v4_v4(expected_straight, rect + i * 4);
+
+		for (int c = 0; c < 4; c++) {
+			EXPECT_EQ(expected_premul[c], rect_premul[i * 4 + c]);
+			EXPECT_EQ(expected_straight[c], rect_straight[i * 4 + c]);
+		}
+	}
+
+	MEM_freeN(rect);
+	MEM_freeN(rect_premul);
+	MEM_freeN(rect_straight);
+}
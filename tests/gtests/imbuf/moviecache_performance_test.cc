@@ -0,0 +1,130 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "atomic_ops.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "MEM_CacheLimiterC-Api.h"
+#include "BLI_utildefines.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "PIL_time.h"
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+#include "IMB_moviecache.h"
+}
+
+/* Number of different frames, only a quarter of them fit in the cache. */
+#define NUM_FRAMES 4096
+#define FRAME_SIZE 32
+#define NUM_ACCESSES 1000000
+
+typedef struct FrameKey {
+	int framenr;
+} FrameKey;
+
+typedef struct AccessData {
+	MovieCache *cache;
+	int num_accesses;
+	uint32_t hits;
+	uint32_t misses;
+} AccessData;
+
+static unsigned int frame_hash(const void *key_v)
+{
+	const FrameKey *key = (const FrameKey *)key_v;
+	return (unsigned int)key->framenr;
+}
+
+static bool frame_cmp(const void *a_v, const void *b_v)
+{
+	const FrameKey *a = (const FrameKey *)a_v;
+	const FrameKey *b = (const FrameKey *)b_v;
+	return a->framenr != b->framenr;
+}
+
+/* Play back a range of frames a few times from a random start frame, like a
+ * user scrubbing while a prefetching thread fills the cache. */
+static void access_frames(TaskPool *__restrict pool, void *taskdata, int UNUSED(threadid))
+{
+	AccessData *data = (AccessData *)BLI_task_pool_userdata(pool);
+	unsigned int seed = (unsigned int)GET_INT_FROM_POINTER(taskdata) * 2654435761u + 1;
+	int start = 0;
+
+	for (int i = 0; i < data->num_accesses; i++) {
+		if (i % 256 == 0) {
+			seed = seed * 1103515245u + 12345u;
+			start = (int)((seed >> 8) % NUM_FRAMES);
+		}
+
+		FrameKey key;
+		key.framenr = (start + i % 64) % NUM_FRAMES;
+
+		ImBuf *ibuf = IMB_moviecache_get(data->cache, &key);
+		if (ibuf) {
+			atomic_add_and_fetch_uint32(&data->hits, 1);
+		}
+		else {
+			ibuf = IMB_allocImBuf(FRAME_SIZE, FRAME_SIZE, 32, IB_rect);
+			ibuf->rect[0] = (unsigned int)key.framenr;
+			IMB_moviecache_put(data->cache, &key, ibuf);
+			atomic_add_and_fetch_uint32(&data->misses, 1);
+		}
+		IMB_freeImBuf(ibuf);
+	}
+}
+
+static void moviecache_benchmark(int num_threads)
+{
+	AccessData data;
+	data.cache = IMB_moviecache_create("benchmark", sizeof(FrameKey), frame_hash, frame_cmp);
+	data.num_accesses = NUM_ACCESSES / num_threads;
+	data.hits = 0;
+	data.misses = 0;
+
+	TaskScheduler *scheduler = BLI_task_scheduler_create(num_threads);
+	TaskPool *pool = BLI_task_pool_create_suspended(scheduler, &data);
+	for (int i = 0; i < num_threads; i++) {
+		BLI_task_pool_push(pool, access_frames, SET_INT_IN_POINTER(i), false, TASK_PRIORITY_HIGH);
+	}
+
+	const double start = PIL_check_seconds_timer();
+	BLI_threaded_malloc_begin();
+	BLI_task_pool_work_and_wait(pool);
+	BLI_threaded_malloc_end();
+	const double time = PIL_check_seconds_timer() - start;
+
+	BLI_task_pool_free(pool);
+	BLI_task_scheduler_free(scheduler);
+
+	int num_cached = 0;
+	struct MovieCacheIter *iter = IMB_moviecacheIter_new(data.cache);
+	while (!IMB_moviecacheIter_done(iter)) {
+		num_cached++;
+		IMB_moviecacheIter_step(iter);
+	}
+	IMB_moviecacheIter_free(iter);
+
+	printf("%2d threads: %8.3f ms, %6.2f%% hits, %d frames cached\n",
+	       num_threads, time * 1000.0, 100.0 * data.hits / (data.hits + data.misses), num_cached);
+
+	IMB_moviecache_free(data.cache);
+}
+
+TEST(moviecache, GetPutThreaded)
+{
+	IMB_init();
+
+	const size_t old_maximum = MEM_CacheLimiter_get_maximum();
+	MEM_CacheLimiter_set_maximum((size_t)NUM_FRAMES / 4 * FRAME_SIZE * FRAME_SIZE * 4);
+
+	for (int num_threads = 1; num_threads <= 2 * BLI_system_thread_count(); num_threads *= 2) {
+		moviecache_benchmark(num_threads);
+	}
+
+	MEM_CacheLimiter_set_maximum(old_maximum);
+	IMB_moviecache_destruct();
+	IMB_exit();
+}
@@ -0,0 +1,124 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "MEM_CacheLimiterC-Api.h"
+#include "BLI_utildefines.h"
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+#include "IMB_moviecache.h"
+}
+
+#define FRAME_SIZE 128
+#define FRAME_BYTES (FRAME_SIZE * FRAME_SIZE * 4)
+
+/* room for four frames and their bookkeeping, but not for five */
+#define CACHE_LIMIT (FRAME_BYTES * 9 / 2)
+
+typedef struct FrameKey {
+	int framenr;
+} FrameKey;
+
+static unsigned int frame_hash(const void *key_v)
+{
+	const FrameKey *key = (const FrameKey *)key_v;
+	return (unsigned int)key->framenr;
+}
+
+static bool frame_cmp(const void *a_v, const void *b_v)
+{
+	const FrameKey *a = (const FrameKey *)a_v;
+	const FrameKey *b = (const FrameKey *)b_v;
+	return a->framenr != b->framenr;
+}
+
+static void frames_put(MovieCache *cache, int start, int num)
+{
+	for (int framenr = start; framenr < start + num; framenr++) {
+		FrameKey key;
+		key.framenr = framenr;
+
+		ImBuf *ibuf = IMB_allocImBuf(FRAME_SIZE, FRAME_SIZE, 32, IB_rect);
+		ibuf->rect[0] = (unsigned int)framenr;
+		IMB_moviecache_put(cache, &key, ibuf);
+		IMB_freeImBuf(ibuf);
+	}
+}
+
+/* number of cached frames, which all have to belong to their key */
+static int frames_count(MovieCache *cache)
+{
+	struct MovieCacheIter *iter = IMB_moviecacheIter_new(cache);
+	int num_cached = 0;
+
+	while (!IMB_moviecacheIter_done(iter)) {
+		const FrameKey *key = (const FrameKey *)IMB_moviecacheIter_getUserKey(iter);
+		ImBuf *ibuf = IMB_moviecacheIter_getImBuf(iter);
+		EXPECT_EQ(key->framenr, (int)ibuf->rect[0]);
+		num_cached++;
+		IMB_moviecacheIter_step(iter);
+	}
+	IMB_moviecacheIter_free(iter);
+
+	return num_cached;
+}
+
+TEST(moviecache, Eviction)
+{
+	const size_t old_maximum = MEM_CacheLimiter_get_maximum();
+	MEM_CacheLimiter_set_maximum(CACHE_LIMIT);
+
+	MovieCache *cache = IMB_moviecache_create("eviction", sizeof(FrameKey), frame_hash, frame_cmp);
+	frames_put(cache, 0, 16);
+
+	EXPECT_EQ(4, frames_count(cache));
+
+	/* the frame which was put last is never the one evicted for it */
+	FrameKey key;
+	key.framenr = 15;
+	EXPECT_TRUE(IMB_moviecache_has_frame(cache, &key));
+
+	IMB_moviecache_free(cache);
+
+	MEM_CacheLimiter_set_maximum(old_maximum);
+	IMB_moviecache_destruct();
+}
+
+/* puts into another cache do not free the frames of a cache which is iterated */
+TEST(moviecache, EvictionWhileIterating)
+{
+	const size_t old_maximum = MEM_CacheLimiter_get_maximum();
+	MEM_CacheLimiter_set_maximum(CACHE_LIMIT);
+
+	MovieCache *cache = IMB_moviecache_create("iterated", sizeof(FrameKey), frame_hash, frame_cmp);
+	MovieCache *cache_other = IMB_moviecache_create("other", sizeof(FrameKey), frame_hash, frame_cmp);
+	frames_put(cache, 0, 4);
+
+	struct MovieCacheIter *iter = IMB_moviecacheIter_new(cache);
+	int num_iterated = 0;
+
+	while (!IMB_moviecacheIter_done(iter)) {
+		const FrameKey *key = (const FrameKey *)IMB_moviecacheIter_getUserKey(iter);
+		ImBuf *ibuf = IMB_moviecacheIter_getImBuf(iter);
+
+		frames_put(cache_other, num_iterated * 4, 4);
+
+		EXPECT_EQ(key->framenr, (int)ibuf->rect[0]);
+		num_iterated++;
+		IMB_moviecacheIter_step(iter);
+	}
+
+	EXPECT_EQ(4, num_iterated);
+	IMB_moviecacheIter_free(iter);
+
+	/* the limit is respected again once the iteration is done */
+	EXPECT_EQ(4, frames_count(cache) + frames_count(cache_other));
+
+	IMB_moviecache_free(cache);
+	IMB_moviecache_free(cache_other);
+
+	MEM_CacheLimiter_set_maximum(old_maximum);
+	IMB_moviecache_destruct();
+}
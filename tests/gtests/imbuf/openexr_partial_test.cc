@@ -0,0 +1,276 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <cstring>
+#include <vector>
+
+#include <ImfChannelList.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfOutputFile.h>
+#include <ImfTiledOutputFile.h>
+
+extern "C" {
+#include "BLI_fileops.h"
+#include "BLI_math_base.h"
+#include "BLI_path_util.h"
+#include "BLI_utildefines.h"
+#include "BKE_appdir.h"
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+}
+
+#define PARTIAL_TEST_X 256
+#define PARTIAL_TEST_Y 160
+
+/* integers which floats store exactly, different for every level, row, column and channel,
+ * y goes down from the top like in the file */
+static float partial_test_value(int level, int x, int y, int channel)
+{
+	return (float)((level * 4 + channel) * 65536 + y * 256 + x);
+}
+
+static void partial_test_framebuffer(Imf::FrameBuffer &frameBuffer, float *pixels, int width)
+{
+	const char *names[3] = {"R", "G", "B"};
+
+	for (int c = 0; c < 3; c++) {
+		frameBuffer.insert(names[c], Imf::Slice(Imf::FLOAT, (char *)(pixels + c),
+		                                        sizeof(float) * 3, sizeof(float) * 3 * width));
+	}
+}
+
+static void partial_test_fill(std::vector<float> &pixels, int level, int width, int height)
+{
+	pixels.resize((size_t)width * height * 3);
+
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			for (int c = 0; c < 3; c++) {
+				pixels[((size_t)y * width + x) * 3 + c] = partial_test_value(level, x, y, c);
+			}
+		}
+	}
+}
+
+static Imf::Header partial_test_header()
+{
+	Imf::Header header(PARTIAL_TEST_X, PARTIAL_TEST_Y);
+
+	header.channels().insert("R", Imf::Channel(Imf::FLOAT));
+	header.channels().insert("G", Imf::Channel(Imf::FLOAT));
+	header.channels().insert("B", Imf::Channel(Imf::FLOAT));
+
+	return header;
+}
+
+/* tiled file of which every mipmap level has its own values, returns the number of levels */
+static int partial_test_write_tiled(const char *filepath)
+{
+	Imf::Header header = partial_test_header();
+	std::vector<float> pixels;
+
+	header.setTileDescription(Imf::TileDescription(32, 32, Imf::MIPMAP_LEVELS, Imf::ROUND_DOWN));
+
+	Imf::TiledOutputFile file(filepath, header);
+
+	for (int level = 0; level < file.numLevels(); level++) {
+		Imf::FrameBuffer frameBuffer;
+
+		partial_test_fill(pixels, level, file.levelWidth(level), file.levelHeight(level));
+		partial_test_framebuffer(frameBuffer, &pixels[0], file.levelWidth(level));
+
+		file.setFrameBuffer(frameBuffer);
+		file.writeTiles(0, file.numXTiles(level) - 1, 0, file.numYTiles(level) - 1, level);
+	}
+
+	return file.numLevels();
+}
+
+static void partial_test_write_scanlines(const char *filepath)
+{
+	Imf::Header header = partial_test_header();
+	Imf::FrameBuffer frameBuffer;
+	std::vector<float> pixels;
+
+	partial_test_fill(pixels, 0, PARTIAL_TEST_X, PARTIAL_TEST_Y);
+	partial_test_framebuffer(frameBuffer, &pixels[0], PARTIAL_TEST_X);
+
+	Imf::OutputFile file(filepath, header);
+	file.setFrameBuffer(frameBuffer);
+	file.writePixels(PARTIAL_TEST_Y);
+}
+
+static void partial_test_filepath(char *filepath, const char *filename)
+{
+	char tempdir[FILE_MAX];
+
+	BKE_tempdir_system_init(tempdir);
+	BLI_join_dirfile(filepath, FILE_MAX, tempdir, filename);
+}
+
+/* the pixel (x, y) of the ImBuf, with y going up from the bottom */
+static const float *partial_test_pixel(const ImBuf *ibuf, int x, int y)
+{
+	return ibuf->rect_float + ((size_t)y * ibuf->x + x) * ibuf->channels;
+}
+
+/* every level of a tiled file against the values written, and level 0 against a full read */
+TEST(openexr_partial, MipmapLevels)
+{
+	const size_t full_size = sizeof(float) * 3 * PARTIAL_TEST_X * PARTIAL_TEST_Y;
+	char filepath[FILE_MAX];
+	int num_levels;
+
+	IMB_init();
+
+	partial_test_filepath(filepath, "imbuf_openexr_partial_tiled.exr");
+	num_levels = partial_test_write_tiled(filepath);
+	EXPECT_EQ(9, num_levels);
+
+	ImBuf *full = IMB_loadiffname(filepath, 0, NULL);
+	ASSERT_TRUE(full != NULL);
+
+	for (int level = 0; level < num_levels; level++) {
+		const int width = max_ii(PARTIAL_TEST_X >> level, 1);
+		const int height = max_ii(PARTIAL_TEST_Y >> level, 1);
+		ImPartialRead partial = {0};
+
+		partial.level = level;
+		ImBuf *ibuf = IMB_loadiffname_partial(filepath, 0, NULL, &partial);
+		ASSERT_TRUE(ibuf != NULL);
+
+		EXPECT_EQ(level, partial.level_read);
+		EXPECT_EQ(PARTIAL_TEST_X, partial.width);
+		EXPECT_EQ(PARTIAL_TEST_Y, partial.height);
+		EXPECT_EQ(width, ibuf->x);
+		EXPECT_EQ(height, ibuf->y);
+		EXPECT_EQ(sizeof(float) * 3 * width * height, partial.bytes_read);
+		EXPECT_EQ(full_size, partial.bytes_read + partial.bytes_skipped);
+
+		for (int y = 0; y < ibuf->y; y++) {
+			for (int x = 0; x < ibuf->x; x++) {
+				const float *pixel = partial_test_pixel(ibuf, x, y);
+
+				for (int c = 0; c < 3; c++) {
+					EXPECT_EQ(partial_test_value(level, x, height - 1 - y, c), pixel[c]);
+				}
+				if (level == 0) {
+					EXPECT_EQ(0, memcmp(partial_test_pixel(full, x, y), pixel, sizeof(float) * 4));
+				}
+			}
+		}
+
+		IMB_freeImBuf(ibuf);
+	}
+
+	IMB_freeImBuf(full);
+	BLI_delete(filepath, false, false);
+
+	IMB_exit();
+}
+
+/* regions of the first two levels, crossing tile borders */
+TEST(openexr_partial, TiledRegion)
+{
+	char filepath[FILE_MAX];
+
+	IMB_init();
+
+	partial_test_filepath(filepath, "imbuf_openexr_partial_region.exr");
+	partial_test_write_tiled(filepath);
+
+	ImBuf *full = IMB_loadiffname(filepath, 0, NULL);
+	ASSERT_TRUE(full != NULL);
+
+	for (int level = 0; level < 2; level++) {
+		const int height = PARTIAL_TEST_Y >> level;
+		ImPartialRead partial = {0};
+
+		partial.xmin = 40 >> level;
+		partial.ymin = 20 >> level;
+		partial.xmax = 200 >> level;
+		partial.ymax = 100 >> level;
+		partial.level = level;
+
+		ImBuf *ibuf = IMB_loadiffname_partial(filepath, 0, NULL, &partial);
+		ASSERT_TRUE(ibuf != NULL);
+
+		EXPECT_EQ(partial.xmax - partial.xmin, ibuf->x);
+		EXPECT_EQ(partial.ymax - partial.ymin, ibuf->y);
+		/* only the tiles overlapping the region */
+		EXPECT_LT(partial.bytes_read, sizeof(float) * 3 * (PARTIAL_TEST_X >> level) * height);
+
+		for (int y = 0; y < ibuf->y; y++) {
+			for (int x = 0; x < ibuf->x; x++) {
+				const float *pixel = partial_test_pixel(ibuf, x, y);
+
+				for (int c = 0; c < 3; c++) {
+					EXPECT_EQ(partial_test_value(level, partial.xmin + x, height - 1 - (partial.ymin + y), c),
+					          pixel[c]);
+				}
+				if (level == 0) {
+					EXPECT_EQ(0, memcmp(partial_test_pixel(full, partial.xmin + x, partial.ymin + y), pixel,
+					                    sizeof(float) * 4));
+				}
+			}
+		}
+
+		IMB_freeImBuf(ibuf);
+	}
+
+	IMB_freeImBuf(full);
+	BLI_delete(filepath, false, false);
+
+	IMB_exit();
+}
+
+/* scanline files have no levels, every 4th pixel of every 4th scanline of a full read */
+TEST(openexr_partial, ScanlineSubsampled)
+{
+	const size_t full_size = sizeof(float) * 3 * PARTIAL_TEST_X * PARTIAL_TEST_Y;
+	char filepath[FILE_MAX];
+	ImPartialRead partial = {0};
+	ImPartialReadStats stats_before, stats_after;
+
+	IMB_init();
+
+	partial_test_filepath(filepath, "imbuf_openexr_partial_scanline.exr");
+	partial_test_write_scanlines(filepath);
+
+	ImBuf *full = IMB_loadiffname(filepath, 0, NULL);
+	ASSERT_TRUE(full != NULL);
+
+	IMB_partial_read_stats_get(&stats_before);
+
+	partial.level_min_size = PARTIAL_TEST_X / 4;
+	ImBuf *ibuf = IMB_loadiffname_partial(filepath, 0, NULL, &partial);
+	ASSERT_TRUE(ibuf != NULL);
+
+	IMB_partial_read_stats_get(&stats_after);
+
+	EXPECT_EQ(2, partial.level_read);
+	EXPECT_EQ(PARTIAL_TEST_X / 4, ibuf->x);
+	EXPECT_EQ(PARTIAL_TEST_Y / 4, ibuf->y);
+	EXPECT_EQ(sizeof(float) * 3 * PARTIAL_TEST_X * ibuf->y, partial.bytes_read);
+	EXPECT_EQ(full_size, partial.bytes_read + partial.bytes_skipped);
+
+	/* the totals include this read, other threads don't read here */
+	EXPECT_EQ(stats_before.reads + 1, stats_after.reads);
+	EXPECT_EQ(stats_before.bytes_read + partial.bytes_read, stats_after.bytes_read);
+	EXPECT_EQ(stats_before.bytes_skipped + partial.bytes_skipped, stats_after.bytes_skipped);
+
+	for (int y = 0; y < ibuf->y; y++) {
+		for (int x = 0; x < ibuf->x; x++) {
+			EXPECT_EQ(0, memcmp(partial_test_pixel(full, x * 4, y * 4), partial_test_pixel(ibuf, x, y),
+			                    sizeof(float) * 4));
+		}
+	}
+
+	IMB_freeImBuf(ibuf);
+	IMB_freeImBuf(full);
+	BLI_delete(filepath, false, false);
+
+	IMB_exit();
+}
@@ -0,0 +1,64 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "PIL_time.h"
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+}
+
+/* 8K UHD down to a thumbnail. */
+#define SRC_X 7680
+#define SRC_Y 4320
+#define DST_X 256
+#define DST_Y 144
+
+static ImBuf *scaling_test_imbuf(int x, int y, int flags)
+{
+	ImBuf *ibuf = IMB_allocImBuf(x, y, 32, flags);
+
+	for (size_t i = 0; i < (size_t)x * y; i++) {
+		if (ibuf->rect) {
+			ibuf->rect[i] = 0x80402010;
+		}
+		if (ibuf->rect_float) {
+			float *pixel = ibuf->rect_float + i * 4;
+			/* horizontal gradient */
+			pixel[0] = (float)(i % x) / x;
+			pixel[1] = pixel[2] = 0.5f;
+			pixel[3] = 1.0f;
+		}
+	}
+
+	return ibuf;
+}
+
+static void scaling_benchmark(const char *name, int flags, eIMBScaleFilter filter)
+{
+	ImBuf *ibuf = scaling_test_imbuf(SRC_X, SRC_Y, flags);
+
+	const double start = PIL_check_seconds_timer();
+	IMB_scaleImBuf_filter(ibuf, DST_X, DST_Y, filter);
+	const double time = PIL_check_seconds_timer() - start;
+
+	printf("%-8s %-8s %8.3f ms\n", name,
+	       (filter == IMB_SCALE_FILTER_BOX) ? "box" : (filter == IMB_SCALE_FILTER_BILINEAR) ? "bilinear" : "lanczos",
+	       time * 1000.0);
+
+	IMB_freeImBuf(ibuf);
+}
+
+TEST(scaling, Downscale8K)
+{
+	IMB_init();
+
+	for (int filter = IMB_SCALE_FILTER_BOX; filter <= IMB_SCALE_FILTER_LANCZOS; filter++) {
+		scaling_benchmark("byte", IB_rect, (eIMBScaleFilter)filter);
+		scaling_benchmark("float", IB_rectfloat, (eIMBScaleFilter)filter);
+	}
+
+	IMB_exit();
+}
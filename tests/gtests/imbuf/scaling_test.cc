@@ -0,0 +1,82 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+}
+
+TEST(scaling, Box)
+{
+	ImBuf *ibuf = IMB_allocImBuf(4, 2, 32, IB_rect | IB_rectfloat);
+	unsigned char *rect = (unsigned char *)ibuf->rect;
+
+	for (int i = 0; i < 8; i++) {
+		rect[i * 4] = i * 10;
+		ibuf->rect_float[i * 4] = i;
+	}
+
+	IMB_scaleImBuf(ibuf, 2, 1);
+
+	rect = (unsigned char *)ibuf->rect;
+	EXPECT_EQ(25, rect[0]);
+	EXPECT_EQ(45, rect[4]);
+	EXPECT_FLOAT_EQ(2.5f, ibuf->rect_float[0]);
+	EXPECT_FLOAT_EQ(4.5f, ibuf->rect_float[4]);
+
+	IMB_freeImBuf(ibuf);
+}
+
+TEST(scaling, Bilinear)
+{
+	ImBuf *ibuf = IMB_allocImBuf(2, 1, 32, IB_rectfloat);
+	const float expected[8] = {0.0f, 0.0f, 0.125f, 0.375f, 0.625f, 0.875f, 1.0f, 1.0f};
+
+	ibuf->rect_float[0] = 0.0f;
+	ibuf->rect_float[4] = 1.0f;
+
+	IMB_scaleImBuf(ibuf, 8, 1);
+
+	for (int i = 0; i < 8; i++) {
+		EXPECT_FLOAT_EQ(expected[i], ibuf->rect_float[i * 4]);
+	}
+
+	IMB_freeImBuf(ibuf);
+}
+
+/* a constant color stays constant and a gradient stays a gradient, for all filters */
+TEST(scaling, DownscaleGradient)
+{
+	const int src_x = 960, src_y = 540, dst_x = 64, dst_y = 36;
+
+	for (int filter = IMB_SCALE_FILTER_BOX; filter <= IMB_SCALE_FILTER_LANCZOS; filter++) {
+		ImBuf *ibuf = IMB_allocImBuf(src_x, src_y, 32, IB_rect | IB_rectfloat);
+
+		for (int i = 0; i < src_x * src_y; i++) {
+			float *pixel = ibuf->rect_float + i * 4;
+			ibuf->rect[i] = 0x80402010;
+			pixel[0] = (float)(i % src_x) / src_x;
+			pixel[1] = pixel[2] = 0.5f;
+			pixel[3] = 1.0f;
+		}
+
+		EXPECT_TRUE(IMB_scaleImBuf_filter(ibuf, dst_x, dst_y, (eIMBScaleFilter)filter));
+		EXPECT_EQ(dst_x, ibuf->x);
+		EXPECT_EQ(dst_y, ibuf->y);
+
+		for (int y = 1; y < dst_y - 1; y++) {
+			for (int x = 1; x < dst_x - 1; x++) {
+				const float *pixel = ibuf->rect_float + (y * dst_x + x) * 4;
+				EXPECT_EQ(0x80402010, ibuf->rect[y * dst_x + x]);
+				EXPECT_NEAR((x + 0.5f) / dst_x, pixel[0], 1e-3f);
+				EXPECT_NEAR(0.5f, pixel[1], 1e-5f);
+				EXPECT_NEAR(1.0f, pixel[3], 1e-5f);
+			}
+		}
+
+		IMB_freeImBuf(ibuf);
+	}
+}
@@ -0,0 +1,149 @@
+# Apache License, Version 2.0
+
+# Time the rendering of the sequencer effects at 1080p and 4K, for byte and float buffers.
+# The SSE2 kernels are checked against the scalar ones by tests/gtests/blenkernel/seqeffects_test.cc.
+#
+# The inputs are image strips with gradients in all channels, alpha included, so alpha over,
+# under and the crosses can't take their opaque or transparent shortcuts.
+#
+# ./blender.bin --background -noaudio --factory-startup --python tests/python/bl_sequencer_effects_benchmark.py
+# ./blender.bin --background -noaudio --factory-startup --python tests/python/bl_sequencer_effects_benchmark.py -- GLOW WIPE
+
+import bpy
+import os
+import shutil
+import sys
+import tempfile
+import time
+
+RESOLUTIONS = (
+    ("1080p", 1920, 1080),
+    ("4K", 3840, 2160),
+)
+
+# effect type, number of inputs
+EFFECTS = (
+    ('CROSS', 2),
+    ('GAMMA_CROSS', 2),
+    ('ALPHA_OVER', 2),
+    ('ALPHA_UNDER', 2),
+    ('COLORMIX', 2),
+    ('WIPE', 2),
+    ('GLOW', 1),
+    ('TRANSFORM', 1),
+)
+
+# every frame is rendered once, so the sequencer cache doesn't hide the effect
+NUM_FRAMES = 10
+
+
+def write_input_image(filepath, index, width, height):
+    # gradients are generated small and scaled up, filling the pixels of a 4K image from python is slow
+    size = 64
+    image = bpy.data.images.new("Input %d" % index, size, size, alpha=True)
+
+    pixels = [0.0] * (size * size * 4)
+    for y in range(size):
+        for x in range(size):
+            u = x / (size - 1)
+            v = y / (size - 1)
+            offset = (y * size + x) * 4
+            if index == 0:
+                pixels[offset:offset + 4] = (u, v, 1.0 - u, v)
+            else:
+                pixels[offset:offset + 4] = (1.0 - v, u * v, u, 1.0 - u * 0.75)
+    image.pixels = pixels
+
+    image.scale(width, height)
+    image.filepath_raw = filepath
+    image.file_format = 'PNG'
+    image.save()
+
+    bpy.data.images.remove(image)
+
+
+def input_images(tempdir, width, height):
+    filepaths = []
+    for i in range(2):
+        filepath = os.path.join(tempdir, "input_%d_%dx%d.png" % (i, width, height))
+        if not os.path.exists(filepath):
+            write_input_image(filepath, i, width, height)
+        filepaths.append(filepath)
+    return filepaths
+
+
+def setup_scene(tempdir, effect_type, num_inputs, width, height, use_float):
+    scene = bpy.context.scene
+
+    scene.render.resolution_x = width
+    scene.render.resolution_y = height
+    scene.render.resolution_percentage = 100
+    scene.render.use_sequencer = True
+    scene.render.use_compositing = False
+    scene.frame_start = 1
+    scene.frame_end = NUM_FRAMES
+
+    # clearing also frees the sequencer cache
+    if scene.sequence_editor:
+        scene.sequence_editor_clear()
+    seqs = scene.sequence_editor_create().sequences
+
+    inputs = []
+    for i, filepath in enumerate(input_images(tempdir, width, height)[:num_inputs]):
+        seq = seqs.new_image("Input %d" % i, filepath, i + 1, 1)
+        seq.frame_final_duration = NUM_FRAMES
+        seq.use_float = use_float
+        inputs.append(seq)
+
+    if effect_type is None:
+        return
+
+    seq = seqs.new_effect(
+        effect_type, effect_type, num_inputs + 1, 1, frame_end=NUM_FRAMES + 1,
+        seq1=inputs[0], seq2=inputs[1] if num_inputs == 2 else None)
+
+    if effect_type == 'GLOW':
+        seq.threshold = 0.1
+    elif effect_type == 'TRANSFORM':
+        seq.rotation_start = 15.0
+        seq.scale_start_x = 1.2
+        seq.scale_start_y = 1.2
+
+
+def time_render():
+    scene = bpy.context.scene
+    start = time.time()
+    for frame in range(scene.frame_start, scene.frame_end + 1):
+        scene.frame_set(frame)
+        bpy.ops.render.render()
+    return (time.time() - start) * 1000.0 / NUM_FRAMES
+
+
+def main():
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+    effects = [effect for effect in EFFECTS if not argv or effect[0] in argv]
+    tempdir = tempfile.mkdtemp()
+
+    try:
+        print("%-12s %-6s %12s %12s" % ("Effect", "Size", "Byte (ms)", "Float (ms)"))
+
+        for name, width, height in RESOLUTIONS:
+            # rendering the inputs alone, to be subtracted from the effect timings
+            times = []
+            for use_float in (False, True):
+                setup_scene(tempdir, None, 2, width, height, use_float)
+                times.append(time_render())
+            print("%-12s %-6s %12.2f %12.2f" % ("(inputs)", name, times[0], times[1]))
+
+            for effect_type, num_inputs in effects:
+                times = []
+                for use_float in (False, True):
+                    setup_scene(tempdir, effect_type, num_inputs, width, height, use_float)
+                    times.append(time_render())
+                print("%-12s %-6s %12.2f %12.2f" % (effect_type, name, times[0], times[1]))
+    finally:
+        shutil.rmtree(tempdir)
+
+
+if __name__ == "__main__":
+    main()